@@ -35,6 +35,10 @@ set(PPLCV_X86_SRC
 foreach(filename ${PPLCV_X86_FMA_SRC})
     set_source_files_properties(${filename} PROPERTIES COMPILE_FLAGS "${FMA_ENABLED_FLAGS}")
 endforeach()
+# the crc-32 folding of the png decoder also uses carry-less multiplication.
+if(NOT MSVC)
+    set_source_files_properties(src/ppl/cv/x86/fma/crc32_fma.cpp PROPERTIES COMPILE_FLAGS "${FMA_ENABLED_FLAGS} -mpclmul")
+endif()
 foreach(filename ${PPLCV_X86_AVX_SRC})
     set_source_files_properties(${filename} PROPERTIES COMPILE_FLAGS "${AVX_ENABLED_FLAGS}")
 endforeach()
@@ -130,13 +130,32 @@ enum {
                                  with CV_THRESH_OTSU */
 };
 
+enum CmpTypes {
+    CMP_EQ = 0, /**< src1 is equal to src2 */
+    CMP_GT = 1, /**< src1 is greater than src2 */
+    CMP_GE = 2, /**< src1 is greater than or equal to src2 */
+    CMP_LT = 3, /**< src1 is less than src2 */
+    CMP_LE = 4, /**< src1 is less than or equal to src2 */
+    CMP_NE = 5  /**< src1 is unequal to src2 */
+};
+
 enum ImageFormats {
 	BMP,
 	JPEG,
 	PNG,
+	QOI,
+	PNM,
 	UNSUPPORTED,
 };
 
+/** Layouts Imread()/Imdecode() decode an image into */
+enum ImreadModes {
+    IMREAD_UNCHANGED = 0,  /**< gray, BGR or BGRA as the image is stored */
+    IMREAD_GRAYSCALE = 1,  /**< the luma only, 1 channel */
+    IMREAD_I420      = 2,  /**< Y plane, then U and V planes of half size */
+    IMREAD_NV12      = 3,  /**< Y plane, then interleaved UV of half size */
+};
+
 } // namespace cv
 } // namespace ppl
 
@@ -0,0 +1,106 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef __ST_HPC_PPL_CV_X86_BUILDPYRAMID_H_
+#define __ST_HPC_PPL_CV_X86_BUILDPYRAMID_H_
+
+#include "ppl/common/retcode.h"
+#include "ppl/cv/types.h"
+
+namespace ppl {
+namespace cv {
+namespace x86 {
+
+/**
+* @brief Constructs the Gaussian pyramid of an image, level i + 1 is PyrDown of level i.
+* @tparam T The data type of input and output image, currently only \a uint8_t(uchar) and \a float are supported.
+* @tparam nc The number of channels of input image and output image, 1, 3 and 4 are supported.
+* @param height            input image's height
+* @param width             input image's width
+* @param inWidthStride     input image's width stride, usually it equals to `width * nc`
+* @param inData            input image data, which is level 0 of the pyramid
+* @param maxLevel          number of levels to build below the input image
+* @param outWidthStrides   width strides of the output levels, outWidthStrides[i] belongs to level i + 1
+* @param outData           data of the output levels, outData[i] is level i + 1 of
+*                          `(height_i + 1) / 2` rows and `(width_i + 1) / 2` columns, where height_i
+*                          and width_i are the size of level i
+* @param border_type       ways to deal with border. Only BORDER_REFLECT_101 or BORDER_DEFAULT are supported now.
+* @warning All input parameters must be valid, or undefined behaviour may occur.
+* @note All levels are produced in a single pass: as soon as a row of one level is
+*       finished, the rows of the next level depending on it are computed, so every
+*       row is consumed while it is still in cache and the input image is read only once.
+* @remark The following table show which data type and channels are supported.
+* <table>
+* <tr><th>Data type(T)<th>channels
+* <tr><td>float<td>1
+* <tr><td>float<td>3
+* <tr><td>float<td>4
+* <tr><td>uint8_t(uchar)<td>1
+* <tr><td>uint8_t(uchar)<td>3
+* <tr><td>uint8_t(uchar)<td>4
+* </table>
+* <table>
+* <caption align="left">Requirements</caption>
+* <tr><td>X86 platforms supported<td> All
+* <tr><td>Header files<td> #include &lt;ppl/cv/x86/buildpyramid.h&gt;
+* <tr><td>Project<td> ppl.cv
+* @since ppl.cv-v1.0.0
+* ###Example
+* @code{.cpp}
+* #include <ppl/cv/x86/buildpyramid.h>
+* int32_t main(int32_t argc, char** argv) {
+*     const int32_t W = 640;
+*     const int32_t H = 480;
+*     const int32_t C = 3;
+*     const int32_t L = 4;
+*     uint8_t* dev_iImage = (uint8_t*)malloc(W * H * C * sizeof(uint8_t));
+*     uint8_t* dev_oImages[L];
+*     int32_t strides[L];
+*     int32_t w = W, h = H;
+*     for (int32_t i = 0; i < L; ++i) {
+*         w = (w + 1) / 2;
+*         h = (h + 1) / 2;
+*         strides[i] = w * C;
+*         dev_oImages[i] = (uint8_t*)malloc(w * h * C * sizeof(uint8_t));
+*     }
+*
+*     ppl::cv::x86::BuildPyramid<uint8_t, 3>(H, W, W * C, dev_iImage, L, strides, dev_oImages);
+*
+*     free(dev_iImage);
+*     for (int32_t i = 0; i < L; ++i) {
+*         free(dev_oImages[i]);
+*     }
+*     return 0;
+* }
+* @endcode
+***************************************************************************************************/
+
+template <typename T, int32_t nc>
+::ppl::common::RetCode BuildPyramid(
+    int32_t height,
+    int32_t width,
+    int32_t inWidthStride,
+    const T* inData,
+    int32_t maxLevel,
+    const int32_t* outWidthStrides,
+    T** outData,
+    BorderType border_type = BORDER_DEFAULT);
+
+}
+}
+} // namespace ppl::cv::x86
+#endif //! __ST_HPC_PPL_CV_X86_BUILDPYRAMID_H_
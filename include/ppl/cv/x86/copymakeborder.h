@@ -35,7 +35,7 @@ namespace x86 {
  * @param dstWidth          output image's width
  * @param dstWidthStride    the width stride of output image, usually it equals to `width * channels`
  * @param dst               output image data
- * @param border_type       ways to deal with border. BORDER_REFLECT_101 ,BORDER_REFLECT, BORDER_CONSTANT and BORDER_REPLICATE are supported
+ * @param border_type       ways to deal with border. BORDER_REFLECT_101 ,BORDER_REFLECT, BORDER_CONSTANT, BORDER_REPLICATE and BORDER_WRAP are supported
  * @param border_value      padding value when border_type is BORDER_CONSTANT
  * @warning All input parameters must be valid, or undefined behaviour may occur.
  * @remark The fllowing table show which data type and channels are supported.
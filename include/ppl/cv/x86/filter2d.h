@@ -38,7 +38,15 @@ namespace x86 {
 * @param outWidthStride    the width stride of output image, usually it equals to `width * channels`
 * @param outData           output image data
 * @param border_type       ways to deal with border. Only BORDER_REFLECT_101 or BORDER_DEFAULT are supported now.
+* @param rank_tolerance    the relative error accepted when the kernel is approximated by a sum of one or two
+*                          separable kernels, measured as the Frobenius norm of the dropped part over the one
+*                          of the kernel. The default value only accepts kernels which are separable up to float
+*                          rounding, zero or a negative value disables the factorization.
 * @warning All input parameters must be valid, or undefined behaviour may occur.
+* @note Kernels from 9x9 to 31x31 are factorized with a small SVD. Kernels of rank 1, and kernels of rank 2
+*       up to 15x15, are applied with row and column passes. Other kernels with kernel_len no smaller than 15 are
+*       convolved in the frequency domain with a tiled FFT. The results of these paths may differ from the
+*       direct convolution by rounding errors.
 * @remark The following table show which data type and channels are supported.
 * <table>
 * <tr><th>Data type(T)<th>channels
@@ -87,7 +95,8 @@ template <typename T, int32_t nc>
     const float* kernel,
     int32_t outWidthStride,
     T* outData,
-    BorderType border_type);
+    BorderType border_type,
+    float rank_tolerance = 1e-5f);
 
 }
 }
@@ -26,6 +26,84 @@ namespace ppl {
 namespace cv {
 namespace x86 {
 
+class DecoderScratch;
+
+/**
+ * @brief Options of the image decoders, each format reads its own fields.
+ * @note 1 scaleDenominator is 1, 2, 4 or 8, a JPEG image is decoded at
+ *         1/scaleDenominator of its size in each dimension, rounding up.
+ *       2 upright applies the Exif orientation of a JPEG image, giving the
+ *         image as it is meant to be displayed.
+ *       3 checkCrc verifies the chunk crcs of a PNG image.
+ *       4 mode is the layout of the decoded data, IMREAD_UNCHANGED keeps the
+ *         channels of the image, IMREAD_GRAYSCALE gives the luma alone,
+ *         IMREAD_I420 and IMREAD_NV12 give the Y plane of height rows at
+ *         stride followed by the chroma of (height + 1) / 2 rows: the U plane
+ *         and the V plane at stride / 2 for I420, interleaved UV at stride
+ *         for NV12.
+ * @remark
+ * <caption align="left">Requirements</caption>
+ * <tr><td>x86 platforms supported<td> All
+ * <tr><td>Header files<td> #include &lt;ppl/cv/x86/imread.h&gt;
+ * <tr><td>Project<td> ppl.cv
+ * @since ppl.cv-v1.0.0
+ ******************************************************************************/
+struct ImreadParams {
+    int scaleDenominator;  // 1, 2, 4 or 8, 1 by default.
+    bool upright;          // the Exif orientation is applied, false by default.
+    bool checkCrc;         // the PNG chunk crcs are verified, true by default.
+    ImreadModes mode;      // IMREAD_UNCHANGED by default.
+
+    ImreadParams() : scaleDenominator(1), upright(false), checkCrc(true),
+                     mode(IMREAD_UNCHANGED) {}
+};
+
+/**
+ * @brief Working memory of the image decoders which is kept between calls.
+ * @note 1 A context is passed to the Imread()/Imdecode() overloads decoding
+ *         into a caller-owned buffer. The block buffer of the file reader,
+ *         the Huffman tables, the coefficient, component and row buffers of
+ *         the decoders are taken from it and only grow, so decoding a stream
+ *         of images of similar sizes with one context stops allocating after
+ *         the first few images.
+ *       2 A context must not be shared by threads decoding at the same time,
+ *         each worker thread keeps its own.
+ * @remark
+ * <caption align="left">Requirements</caption>
+ * <tr><td>x86 platforms supported<td> All
+ * <tr><td>Header files<td> #include &lt;ppl/cv/x86/imread.h&gt;
+ * <tr><td>Project<td> ppl.cv
+ * @since ppl.cv-v1.0.0
+ ******************************************************************************/
+class DecoderContext {
+  public:
+    DecoderContext();
+    ~DecoderContext();
+
+  private:
+    DecoderContext(const DecoderContext&);
+    DecoderContext& operator=(const DecoderContext&);
+
+    // the scratch is only handed to the decoders by the overloads below.
+    DecoderScratch* scratch() const;
+
+    friend ::ppl::common::RetCode Imread(DecoderContext* context,
+                                         const char* fileName, int stride,
+                                         size_t capacity, uchar* image,
+                                         int* height, int* width,
+                                         int* channels,
+                                         const ImreadParams& params);
+    friend ::ppl::common::RetCode Imdecode(DecoderContext* context,
+                                           const uchar* data, size_t size,
+                                           int stride, size_t capacity,
+                                           uchar* image, int* height,
+                                           int* width, int* channels,
+                                           const ImreadParams& params);
+
+  private:
+    DecoderScratch* scratch_;
+};
+
 /**
  * @brief Loads an image from a file.
  * @param fileName  name of file to be loaded.
@@ -36,17 +114,53 @@ namespace x86 {
  * @param image     pointer to a memory buffer storing the pixel data of the
  *                  loaded image. This buffer is allocated in Imread()
  *                  according to the height and stride of the image.
+ * @param params    options of the decoders, see ImreadParams.
  * @return The execution status, succeeds or fails with an error code.
  * @note 1 The function determines the type of an image by the content, not by
  *         the file extension.
- *       2 File formats of windows bitmaps(*.bmp), JPEG(*.jpeg, *.jpg) and
- *         portable network graphcs(*.png) are supported for now.
+ *       2 File formats of windows bitmaps(*.bmp), JPEG(*.jpeg, *.jpg),
+ *         portable network graphcs(*.png), quite OK images(*.qoi) and
+ *         binary portable graymaps and pixmaps(*.pgm, *.ppm, P5 and P6) are
+ *         supported for now.
  *       3 In the case of color images, the decoded images will have the
  *         channels stored in B G R / B G R A order.
  *       4 1, 3 and 4 channels are supported in the decoded data.
- *       5 uchar is supported in the decoded data.
+ *       5 uchar is supported in the decoded data, 16 bits PNG images give
+ *         uint16_t channels in the native byte order.
  *       6 By default number of pixels must be less than 2^30.
  *       7 image[] must be freed when unused.
+ *       8 The scaled decoding runs reduced IDCTs in place of the full ones
+ *         and shrinks the upsampling and color conversion accordingly. Other
+ *         formats are decoded at full size whatever the scale, the stored
+ *         height and width tell the size of the result.
+ *       9 The restart intervals of a baseline JPEG are decoded by parallel
+ *         threads, as many as the hardware runs, when the file is memory
+ *         mapped.
+ *      10 The orientation tag of the Exif APP1 segment is read. With upright
+ *         set, the rows are flipped, rotated or transposed in bands of 64
+ *         just after their color conversion, there is no pass over the
+ *         whole image afterwards. The stored height and width are those of
+ *         the upright image, swapped for orientations 5 ~ 8. Images without
+ *         the tag and other formats are left as they are stored.
+ *      11 Chunk crcs are computed with carry-less multiplication on
+ *         processors with FMA and PCLMULQDQ. Clearing checkCrc skips them
+ *         for trusted data, a corrupted chunk is then only caught by the
+ *         decoder itself.
+ *      12 Rows of a PGM/PPM image are copied straight from the mapped file
+ *         into image[], only the red and blue channels are swapped in place.
+ *         A maximum value over 255 gives 16 bits channels in the native
+ *         byte order.
+ *      13 Except in IMREAD_UNCHANGED, channels is stored as 1 and the
+ *         allocated stride is the width rounded up to a multiple of 4. The
+ *         samples are the full range YCbCr of JFIF, unlike the video range
+ *         of BGR2I420()/BGR2NV12(). 16 bits images are not supported.
+ *      14 A gray JPEG image and the YCbCr of a JPEG image are taken as the
+ *         IDCT gives them: IMREAD_GRAYSCALE decodes no chroma block at all,
+ *         the chroma of 4:2:0 is copied into I420/NV12 as it is, other
+ *         sampling is averaged over 2x2 pixels, and there is no conversion
+ *         to BGR. Other formats, CMYK JPEG images and, for I420 and NV12,
+ *         RGB JPEG images and those turned upright are decoded as BGR and
+ *         converted.
  * @warning All input parameters must be valid, or undefined behaviour may occur.
  * @remark
  * <caption align="left">Requirements</caption>
@@ -77,7 +191,682 @@ namespace x86 {
                               int* width,
                               int* channels,
                               int* stride,
-                              uchar** image);
+                              uchar** image,
+                              const ImreadParams& params = ImreadParams());
+
+/**
+ * @brief Loads an image from a file into a caller-owned buffer.
+ * @param context   decoder context reused across calls.
+ * @param fileName  name of file to be loaded.
+ * @param stride    row stride of the output buffer in bytes, not less than
+ *                  width * channels * depth / 8 of the image, or than the
+ *                  width rounded up to even for I420 and NV12.
+ * @param capacity  size of the output buffer in bytes.
+ * @param image     output buffer for the pixel data.
+ * @param height    pointer to store the height of the loaded image.
+ * @param width     pointer to store the width of the loaded image.
+ * @param channels  pointer to store the channels of the loaded image.
+ * @param params    options of the decoders, see ImreadParams.
+ * @return The execution status, succeeds or fails with an error code.
+ * @note 1 ImreadHeader() and ImreadBufferSize() tell the size of the buffer
+ *         in advance. When the buffer is too small, RC_INVALID_VALUE is
+ *         returned and height, width and channels are still stored.
+ *       2 Supported formats and the layout of the decoded data are the same
+ *         as those of Imread().
+ *       3 No memory is allocated once the context has grown to the size the
+ *         images need.
+ * @warning All input parameters must be valid, or undefined behaviour may occur.
+ * @remark
+ * <caption align="left">Requirements</caption>
+ * <tr><td>x86 platforms supported<td> All
+ * <tr><td>Header files<td> #include &lt;ppl/cv/x86/imread.h&gt;
+ * <tr><td>Project<td> ppl.cv
+ * @since ppl.cv-v1.0.0
+ * ###Example
+ * @code{.cpp}
+ * #include "ppl/cv/x86/imread.h"
+ *
+ * int32_t main(int32_t argc, char** argv) {
+ *     ppl::cv::x86::DecoderContext context;
+ *     std::vector<uchar> buffer(1920 * 1080 * 4);
+ *     int height, width, channels;
+ *
+ *     for (int32_t i = 1; i < argc; i++) {
+ *         ppl::cv::x86::Imread(&context, argv[i], 1920 * 4, buffer.size(),
+ *                              buffer.data(), &height, &width, &channels);
+ *     }
+ *
+ *     return 0;
+ * }
+ * @endcode
+ ******************************************************************************/
+::ppl::common::RetCode Imread(DecoderContext* context,
+                              const char* fileName,
+                              int stride,
+                              size_t capacity,
+                              uchar* image,
+                              int* height,
+                              int* width,
+                              int* channels,
+                              const ImreadParams& params = ImreadParams());
+
+/**
+ * @brief Decodes an image from a memory buffer.
+ * @param data      pointer to the encoded image, e.g. the whole content of a
+ *                  bmp/jpeg/png/qoi/pgm/ppm file.
+ * @param size      size of the encoded image in bytes.
+ * @param height    pointer to store the height of the decoded image.
+ * @param width     pointer to store the width of the decoded image.
+ * @param channels  pointer to store the channels of the decoded image.
+ * @param stride    pointer to store the row stride of the decoded image.
+ * @param image     pointer to a memory buffer storing the pixel data of the
+ *                  decoded image. This buffer is allocated in Imdecode()
+ *                  according to the height and stride of the image.
+ * @param params    options of the decoders, see ImreadParams.
+ * @return The execution status, succeeds or fails with an error code.
+ * @note 1 The decoders read the encoded data in place, it is not copied into
+ *         an intermediate buffer, so data[] must stay valid until Imdecode()
+ *         returns.
+ *       2 Supported formats and the layout of the decoded data are the same
+ *         as those of Imread().
+ *       3 image[] must be freed when unused.
+ * @warning All input parameters must be valid, or undefined behaviour may occur.
+ * @remark
+ * <caption align="left">Requirements</caption>
+ * <tr><td>x86 platforms supported<td> All
+ * <tr><td>Header files<td> #include &lt;ppl/cv/x86/imread.h&gt;
+ * <tr><td>Project<td> ppl.cv
+ * @since ppl.cv-v1.0.0
+ * ###Example
+ * @code{.cpp}
+ * #include "ppl/cv/x86/imread.h"
+ *
+ * int32_t main(int32_t argc, char** argv) {
+ *     std::vector<uchar> buffer;  // filled with the content of test.jpg
+ *     int height, width, channels, stride;
+ *     uchar* image;
+ *
+ *     ppl::cv::x86::Imdecode(buffer.data(), buffer.size(), &height, &width,
+ *                            &channels, &stride, &image);
+ *
+ *     free(image);
+ *
+ *     return 0;
+ * }
+ * @endcode
+ ******************************************************************************/
+::ppl::common::RetCode Imdecode(const uchar* data,
+                                size_t size,
+                                int* height,
+                                int* width,
+                                int* channels,
+                                int* stride,
+                                uchar** image,
+                                const ImreadParams& params = ImreadParams());
+
+/**
+ * @brief Decodes an image from a memory buffer into a caller-owned buffer.
+ * @param context   decoder context reused across calls.
+ * @param data      pointer to the encoded image.
+ * @param size      size of the encoded image in bytes.
+ * @param stride    row stride of the output buffer in bytes, not less than
+ *                  width * channels * depth / 8 of the image, or than the
+ *                  width rounded up to even for I420 and NV12.
+ * @param capacity  size of the output buffer in bytes.
+ * @param image     output buffer for the pixel data.
+ * @param height    pointer to store the height of the decoded image.
+ * @param width     pointer to store the width of the decoded image.
+ * @param channels  pointer to store the channels of the decoded image.
+ * @param params    options of the decoders, see ImreadParams.
+ * @return The execution status, succeeds or fails with an error code.
+ * @note 1 ImdecodeHeader() and ImreadBufferSize() tell the size of the
+ *         buffer in advance. When the buffer is too small, RC_INVALID_VALUE
+ *         is returned and height, width and channels are still stored.
+ *       2 Supported formats and the layout of the decoded data are the same
+ *         as those of Imread().
+ *       3 No memory is allocated once the context has grown to the size the
+ *         images need.
+ * @warning All input parameters must be valid, or undefined behaviour may occur.
+ * @remark
+ * <caption align="left">Requirements</caption>
+ * <tr><td>x86 platforms supported<td> All
+ * <tr><td>Header files<td> #include &lt;ppl/cv/x86/imread.h&gt;
+ * <tr><td>Project<td> ppl.cv
+ * @since ppl.cv-v1.0.0
+ * ###Example
+ * @code{.cpp}
+ * #include "ppl/cv/x86/imread.h"
+ *
+ * int32_t main(int32_t argc, char** argv) {
+ *     ppl::cv::x86::DecoderContext context;
+ *     std::vector<uchar> data;  // filled with the content of test.jpg
+ *     std::vector<uchar> image(1920 * 1080 * 4);
+ *     int height, width, channels;
+ *
+ *     ppl::cv::x86::Imdecode(&context, data.data(), data.size(), 1920 * 4,
+ *                            image.size(), image.data(), &height, &width,
+ *                            &channels);
+ *
+ *     return 0;
+ * }
+ * @endcode
+ ******************************************************************************/
+::ppl::common::RetCode Imdecode(DecoderContext* context,
+                                const uchar* data,
+                                size_t size,
+                                int stride,
+                                size_t capacity,
+                                uchar* image,
+                                int* height,
+                                int* width,
+                                int* channels,
+                                const ImreadParams& params = ImreadParams());
+
+/**
+ * @brief Reads the size and pixel format of an image from a file without
+ *        decoding it.
+ * @param fileName  name of file to be probed.
+ * @param height    pointer to store the height of the image.
+ * @param width     pointer to store the width of the image.
+ * @param channels  pointer to store the channels Imread() decodes the image
+ *                  into.
+ * @param depth     pointer to store the bits of each channel Imread() decodes
+ *                  the image into, 8 or 16.
+ * @param params    the options Imread() is to be called with, the stored
+ *                  height and width are those of the scaled and upright
+ *                  image.
+ * @return The execution status, succeeds or fails with an error code.
+ * @note 1 Only the file signature and the headers in front of the pixel data
+ *         are read, no pixel data is decoded and no image buffer is
+ *         allocated.
+ *       2 Supported formats are the same as those of Imread().
+ *       3 Except in IMREAD_UNCHANGED, channels is stored as 1 and a 16 bits
+ *         image fails with RC_UNSUPPORTED as Imread() does. The stored values
+ *         give the size of a caller-owned buffer with ImreadBufferSize().
+ * @warning All input parameters must be valid, or undefined behaviour may occur.
+ * @remark
+ * <caption align="left">Requirements</caption>
+ * <tr><td>x86 platforms supported<td> All
+ * <tr><td>Header files<td> #include &lt;ppl/cv/x86/imread.h&gt;
+ * <tr><td>Project<td> ppl.cv
+ * @since ppl.cv-v1.0.0
+ * ###Example
+ * @code{.cpp}
+ * #include "ppl/cv/x86/imread.h"
+ *
+ * int32_t main(int32_t argc, char** argv) {
+ *     char file_name[] = "test.png";
+ *     int height, width, channels, depth;
+ *
+ *     ppl::cv::x86::ImreadHeader(file_name, &height, &width, &channels,
+ *                                &depth);
+ *
+ *     return 0;
+ * }
+ * @endcode
+ ******************************************************************************/
+::ppl::common::RetCode ImreadHeader(const char* fileName,
+                                    int* height,
+                                    int* width,
+                                    int* channels,
+                                    int* depth,
+                                    const ImreadParams& params =
+                                        ImreadParams());
+
+/**
+ * @brief Reads the size and pixel format of an image in a memory buffer
+ *        without decoding it.
+ * @param data      pointer to the encoded image.
+ * @param size      size of the encoded image in bytes.
+ * @param height    pointer to store the height of the image.
+ * @param width     pointer to store the width of the image.
+ * @param channels  pointer to store the channels Imdecode() decodes the image
+ *                  into.
+ * @param depth     pointer to store the bits of each channel Imdecode()
+ *                  decodes the image into, 8 or 16.
+ * @param params    the options Imdecode() is to be called with, the stored
+ *                  height and width are those of the scaled and upright
+ *                  image.
+ * @return The execution status, succeeds or fails with an error code.
+ * @note 1 Only the signature and the headers in front of the pixel data are
+ *         parsed, no pixel data is decoded and no image buffer is allocated.
+ *       2 Supported formats are the same as those of Imread().
+ *       3 Except in IMREAD_UNCHANGED, channels is stored as 1 and a 16 bits
+ *         image fails with RC_UNSUPPORTED as Imdecode() does. The stored
+ *         values give the size of a caller-owned buffer with
+ *         ImreadBufferSize().
+ * @warning All input parameters must be valid, or undefined behaviour may occur.
+ * @remark
+ * <caption align="left">Requirements</caption>
+ * <tr><td>x86 platforms supported<td> All
+ * <tr><td>Header files<td> #include &lt;ppl/cv/x86/imread.h&gt;
+ * <tr><td>Project<td> ppl.cv
+ * @since ppl.cv-v1.0.0
+ * ###Example
+ * @code{.cpp}
+ * #include "ppl/cv/x86/imread.h"
+ *
+ * int32_t main(int32_t argc, char** argv) {
+ *     std::vector<uchar> buffer;  // filled with the content of test.jpg
+ *     int height, width, channels, depth;
+ *
+ *     ppl::cv::x86::ImdecodeHeader(buffer.data(), buffer.size(), &height,
+ *                                  &width, &channels, &depth);
+ *
+ *     return 0;
+ * }
+ * @endcode
+ ******************************************************************************/
+::ppl::common::RetCode ImdecodeHeader(const uchar* data,
+                                      size_t size,
+                                      int* height,
+                                      int* width,
+                                      int* channels,
+                                      int* depth,
+                                      const ImreadParams& params =
+                                          ImreadParams());
+
+/**
+ * @brief Computes the bytes of a caller-owned buffer an image is decoded
+ *        into by Imread()/Imdecode() with a context.
+ * @param height    height of the image, as ImreadHeader() stores it.
+ * @param width     width of the image, as ImreadHeader() stores it.
+ * @param channels  channels of the image, as ImreadHeader() stores it.
+ * @param depth     bits of each channel, as ImreadHeader() stores it.
+ * @param stride    row stride of the buffer in bytes.
+ * @param mode      layout of the decoded data, see ImreadParams.
+ * @return The bytes from the first pixel to the last one, which is the
+ *         smallest capacity accepted, or 0 when the stride is too small for
+ *         a row or a parameter is invalid.
+ * @note 1 The smallest stride is width * channels * depth / 8 bytes in
+ *         IMREAD_UNCHANGED, width in IMREAD_GRAYSCALE and (width + 1) / 2 * 2
+ *         in IMREAD_I420 and IMREAD_NV12.
+ *       2 In IMREAD_I420 and IMREAD_NV12, the size covers the Y plane and
+ *         the chroma planes behind it as laid out in ImreadParams.
+ * @remark
+ * <caption align="left">Requirements</caption>
+ * <tr><td>x86 platforms supported<td> All
+ * <tr><td>Header files<td> #include &lt;ppl/cv/x86/imread.h&gt;
+ * <tr><td>Project<td> ppl.cv
+ * @since ppl.cv-v1.0.0
+ * ###Example
+ * @code{.cpp}
+ * #include "ppl/cv/x86/imread.h"
+ *
+ * int32_t main(int32_t argc, char** argv) {
+ *     char file_name[] = "test.jpg";
+ *     ppl::cv::x86::ImreadParams params;
+ *     params.mode = ppl::cv::IMREAD_NV12;
+ *     int height, width, channels, depth;
+ *
+ *     ppl::cv::x86::ImreadHeader(file_name, &height, &width, &channels,
+ *                                &depth, params);
+ *     int stride = (width + 1) / 2 * 2;
+ *     std::vector<uchar> buffer(ppl::cv::x86::ImreadBufferSize(height, width,
+ *                                   channels, depth, stride, params.mode));
+ *
+ *     ppl::cv::x86::DecoderContext context;
+ *     ppl::cv::x86::Imread(&context, file_name, stride, buffer.size(),
+ *                          buffer.data(), &height, &width, &channels,
+ *                          params);
+ *
+ *     return 0;
+ * }
+ * @endcode
+ ******************************************************************************/
+size_t ImreadBufferSize(int height,
+                        int width,
+                        int channels,
+                        int depth,
+                        int stride,
+                        ImreadModes mode = IMREAD_UNCHANGED);
+
+/**
+ * @brief Loads a rectangular region of an image from a file.
+ * @param fileName  name of file to be loaded.
+ * @param x         column of the top left corner of the region.
+ * @param y         row of the top left corner of the region.
+ * @param regionWidth   width of the region.
+ * @param regionHeight  height of the region.
+ * @param height    pointer to store the height of the loaded region.
+ * @param width     pointer to store the width of the loaded region.
+ * @param channels  pointer to store the channels of the loaded region.
+ * @param stride    pointer to store the row stride of the loaded region.
+ * @param image     pointer to a memory buffer storing the pixel data of the
+ *                  loaded region. This buffer is allocated in ImreadRegion()
+ *                  according to the height and stride of the region.
+ * @return The execution status, succeeds or fails with an error code.
+ * @note 1 A region running past the image is clipped to it, the stored height
+ *         and width tell the size of the result. RC_INVALID_VALUE is returned
+ *         if nothing of the image is left.
+ *       2 The pixels are those Imread() decodes at the same place.
+ *       3 In a baseline JPEG, the entropy-coded data of the MCUs outside the
+ *         region is skipped, only their DC coefficients are tracked, and the
+ *         decoding stops after the last MCU row of the region. Only the MCUs
+ *         around the region are transformed and color converted. Restart
+ *         markers let the decoding start at the interval of the first MCU
+ *         of the region.
+ *       4 Other images are decoded whole and the region is copied out.
+ *         The Exif orientation is not applied, the region is placed in the
+ *         image as it is stored.
+ *       5 Supported formats and the layout of the decoded data are the same
+ *         as those of Imread(), image[] must be freed when unused.
+ * @warning All input parameters must be valid, or undefined behaviour may occur.
+ * @remark
+ * <caption align="left">Requirements</caption>
+ * <tr><td>x86 platforms supported<td> All
+ * <tr><td>Header files<td> #include &lt;ppl/cv/x86/imread.h&gt;
+ * <tr><td>Project<td> ppl.cv
+ * @since ppl.cv-v1.0.0
+ * ###Example
+ * @code{.cpp}
+ * #include "ppl/cv/x86/imread.h"
+ *
+ * int32_t main(int32_t argc, char** argv) {
+ *     char file_name[] = "test.jpg";
+ *     int height, width, channels, stride;
+ *     uchar* image;
+ *
+ *     ppl::cv::x86::ImreadRegion(file_name, 640, 360, 320, 240, &height,
+ *                                &width, &channels, &stride, &image);
+ *
+ *     free(image);
+ *
+ *     return 0;
+ * }
+ * @endcode
+ ******************************************************************************/
+::ppl::common::RetCode ImreadRegion(const char* fileName,
+                                    int x,
+                                    int y,
+                                    int regionWidth,
+                                    int regionHeight,
+                                    int* height,
+                                    int* width,
+                                    int* channels,
+                                    int* stride,
+                                    uchar** image);
+
+/**
+ * @brief Decodes a rectangular region of an image from a memory buffer.
+ * @param data      pointer to the encoded image.
+ * @param size      size of the encoded image in bytes.
+ * @param x         column of the top left corner of the region.
+ * @param y         row of the top left corner of the region.
+ * @param regionWidth   width of the region.
+ * @param regionHeight  height of the region.
+ * @param height    pointer to store the height of the decoded region.
+ * @param width     pointer to store the width of the decoded region.
+ * @param channels  pointer to store the channels of the decoded region.
+ * @param stride    pointer to store the row stride of the decoded region.
+ * @param image     pointer to a memory buffer storing the pixel data of the
+ *                  decoded region. This buffer is allocated in
+ *                  ImdecodeRegion() according to the height and stride of the
+ *                  region.
+ * @return The execution status, succeeds or fails with an error code.
+ * @note 1 data[] must stay valid until ImdecodeRegion() returns.
+ *       2 The region is handled as in ImreadRegion().
+ * @warning All input parameters must be valid, or undefined behaviour may occur.
+ * @remark
+ * <caption align="left">Requirements</caption>
+ * <tr><td>x86 platforms supported<td> All
+ * <tr><td>Header files<td> #include &lt;ppl/cv/x86/imread.h&gt;
+ * <tr><td>Project<td> ppl.cv
+ * @since ppl.cv-v1.0.0
+ * ###Example
+ * @code{.cpp}
+ * #include "ppl/cv/x86/imread.h"
+ *
+ * int32_t main(int32_t argc, char** argv) {
+ *     std::vector<uchar> buffer;  // filled with the content of test.jpg
+ *     int height, width, channels, stride;
+ *     uchar* image;
+ *
+ *     ppl::cv::x86::ImdecodeRegion(buffer.data(), buffer.size(), 640, 360,
+ *                                  320, 240, &height, &width, &channels,
+ *                                  &stride, &image);
+ *
+ *     free(image);
+ *
+ *     return 0;
+ * }
+ * @endcode
+ ******************************************************************************/
+::ppl::common::RetCode ImdecodeRegion(const uchar* data,
+                                      size_t size,
+                                      int x,
+                                      int y,
+                                      int regionWidth,
+                                      int regionHeight,
+                                      int* height,
+                                      int* width,
+                                      int* channels,
+                                      int* stride,
+                                      uchar** image);
+
+/**
+ * @brief Loads an image from a file resized to a given size.
+ * @param fileName  name of file to be loaded.
+ * @param outHeight height of the resized image.
+ * @param outWidth  width of the resized image.
+ * @param interpolation  INTERPOLATION_LINEAR or INTERPOLATION_NEAREST_POINT,
+ *                  the pixels are those ResizeLinear() or
+ *                  ResizeNearestPoint() compute.
+ * @param channels  pointer to store the channels of the loaded image.
+ * @param stride    pointer to store the row stride of the resized image.
+ * @param image     pointer to a memory buffer storing the pixel data of the
+ *                  resized image. This buffer is allocated in ImreadResized()
+ *                  according to outHeight and the stride.
+ * @return The execution status, succeeds or fails with an error code.
+ * @note 1 The image is resized while it is decoded, the decoded image is not
+ *         written out to be read back by a separate resize.
+ *       2 A JPEG image is decoded with the largest scale denominator of
+ *         Imread() whose reduced size still covers outWidth x outHeight,
+ *         the 1/2, 1/4 or 1/8 reduction being done by the IDCT, and the
+ *         reduced image is resized from there. Each row is resized as soon
+ *         as it is color converted, rows no output row reads are skipped.
+ *       3 Other images are decoded whole into working memory first, e.g. a
+ *         PNG image is inflated whole, and resized from there row by row.
+ *       4 The Exif orientation is not applied. 16 bit images are not
+ *         supported, RC_UNSUPPORTED is returned for them.
+ *       5 Supported formats and the channels of the decoded data are the
+ *         same as those of Imread(), image[] must be freed when unused.
+ * @warning All input parameters must be valid, or undefined behaviour may occur.
+ * @remark
+ * <caption align="left">Requirements</caption>
+ * <tr><td>x86 platforms supported<td> All
+ * <tr><td>Header files<td> #include &lt;ppl/cv/x86/imread.h&gt;
+ * <tr><td>Project<td> ppl.cv
+ * @since ppl.cv-v1.0.0
+ * ###Example
+ * @code{.cpp}
+ * #include "ppl/cv/x86/imread.h"
+ *
+ * int32_t main(int32_t argc, char** argv) {
+ *     char file_name[] = "test.jpg";
+ *     int channels, stride;
+ *     uchar* image;
+ *
+ *     ppl::cv::x86::ImreadResized(file_name, 224, 224,
+ *                                 ppl::cv::INTERPOLATION_LINEAR, &channels,
+ *                                 &stride, &image);
+ *
+ *     free(image);
+ *
+ *     return 0;
+ * }
+ * @endcode
+ ******************************************************************************/
+::ppl::common::RetCode ImreadResized(const char* fileName,
+                                     int outHeight,
+                                     int outWidth,
+                                     InterpolationType interpolation,
+                                     int* channels,
+                                     int* stride,
+                                     uchar** image);
+
+/**
+ * @brief Decodes an image from a memory buffer resized to a given size.
+ * @param data      pointer to the encoded image.
+ * @param size      size of the encoded image in bytes.
+ * @param outHeight height of the resized image.
+ * @param outWidth  width of the resized image.
+ * @param interpolation  INTERPOLATION_LINEAR or INTERPOLATION_NEAREST_POINT.
+ * @param channels  pointer to store the channels of the decoded image.
+ * @param stride    pointer to store the row stride of the resized image.
+ * @param image     pointer to a memory buffer storing the pixel data of the
+ *                  resized image. This buffer is allocated in
+ *                  ImdecodeResized() according to outHeight and the stride.
+ * @return The execution status, succeeds or fails with an error code.
+ * @note 1 data[] must stay valid until ImdecodeResized() returns.
+ *       2 The image is resized as in ImreadResized().
+ * @warning All input parameters must be valid, or undefined behaviour may occur.
+ * @remark
+ * <caption align="left">Requirements</caption>
+ * <tr><td>x86 platforms supported<td> All
+ * <tr><td>Header files<td> #include &lt;ppl/cv/x86/imread.h&gt;
+ * <tr><td>Project<td> ppl.cv
+ * @since ppl.cv-v1.0.0
+ * ###Example
+ * @code{.cpp}
+ * #include "ppl/cv/x86/imread.h"
+ *
+ * int32_t main(int32_t argc, char** argv) {
+ *     std::vector<uchar> buffer;  // filled with the content of test.jpg
+ *     int channels, stride;
+ *     uchar* image;
+ *
+ *     ppl::cv::x86::ImdecodeResized(buffer.data(), buffer.size(), 224, 224,
+ *                                   ppl::cv::INTERPOLATION_LINEAR, &channels,
+ *                                   &stride, &image);
+ *
+ *     free(image);
+ *
+ *     return 0;
+ * }
+ * @endcode
+ ******************************************************************************/
+::ppl::common::RetCode ImdecodeResized(const uchar* data,
+                                       size_t size,
+                                       int outHeight,
+                                       int outWidth,
+                                       InterpolationType interpolation,
+                                       int* channels,
+                                       int* stride,
+                                       uchar** image);
+
+/**
+ * @brief An image decoded by ImreadBatch() or ImdecodeBatch().
+ * @note 1 image is allocated by the batch as in Imread(), and must be freed
+ *         when unused. It is nullptr for an image which failed.
+ *       2 status tells how the decoding of this image went.
+ ******************************************************************************/
+struct DecodedImage {
+    int height;
+    int width;
+    int channels;
+    int stride;
+    uchar* image;
+    ::ppl::common::RetCode status;
+};
+
+/**
+ * @brief Loads a batch of images from files on a pool of worker threads.
+ * @param fileNames names of the files to be loaded.
+ * @param count     number of files.
+ * @param images    array of count images storing the loaded images and the
+ *                  status of each.
+ * @param threads   number of worker threads, the calling thread being one of
+ *                  them, 0 takes all the hardware threads.
+ * @param params    options of the decoders, see ImreadParams.
+ * @return The execution status, RC_SUCCESS when all the images are loaded,
+ *         otherwise the status of the first image which failed.
+ * @note 1 The files are handed out to the workers one at a time, so a worker
+ *         on a big image does not hold up the others, and the reading of a
+ *         file overlaps the decoding of others.
+ *       2 Each worker keeps one DecoderContext for all the images it takes,
+ *         and small files are read into its block buffer. With more than one
+ *         worker, an image is decoded by its worker alone, rather than by
+ *         the threads a JPEG decoder starts for a single image.
+ *       3 A failed image does not stop the others, its status is set and
+ *         its image is nullptr.
+ * @warning All input parameters must be valid, or undefined behaviour may occur.
+ * @remark
+ * <caption align="left">Requirements</caption>
+ * <tr><td>x86 platforms supported<td> All
+ * <tr><td>Header files<td> #include &lt;ppl/cv/x86/imread.h&gt;
+ * <tr><td>Project<td> ppl.cv
+ * @since ppl.cv-v1.0.0
+ * ###Example
+ * @code{.cpp}
+ * #include "ppl/cv/x86/imread.h"
+ *
+ * int32_t main(int32_t argc, char** argv) {
+ *     std::vector<ppl::cv::x86::DecodedImage> images(argc - 1);
+ *
+ *     ppl::cv::x86::ImreadBatch(argv + 1, argc - 1, images.data());
+ *     for (auto& image : images) {
+ *         free(image.image);
+ *     }
+ *
+ *     return 0;
+ * }
+ * @endcode
+ ******************************************************************************/
+::ppl::common::RetCode ImreadBatch(const char* const* fileNames,
+                                   int count,
+                                   DecodedImage* images,
+                                   int threads = 0,
+                                   const ImreadParams& params = ImreadParams());
+
+/**
+ * @brief Decodes a batch of images from memory buffers on a pool of worker
+ *        threads.
+ * @param data      pointers to the encoded images.
+ * @param sizes     sizes of the encoded images in bytes.
+ * @param count     number of images.
+ * @param images    array of count images storing the decoded images and the
+ *                  status of each.
+ * @param threads   number of worker threads, the calling thread being one of
+ *                  them, 0 takes all the hardware threads.
+ * @param params    options of the decoders, see ImreadParams.
+ * @return The execution status, RC_SUCCESS when all the images are decoded,
+ *         otherwise the status of the first image which failed.
+ * @note 1 The buffers must stay valid until ImdecodeBatch() returns.
+ *       2 The images are distributed to the workers as in ImreadBatch().
+ * @warning All input parameters must be valid, or undefined behaviour may occur.
+ * @remark
+ * <caption align="left">Requirements</caption>
+ * <tr><td>x86 platforms supported<td> All
+ * <tr><td>Header files<td> #include &lt;ppl/cv/x86/imread.h&gt;
+ * <tr><td>Project<td> ppl.cv
+ * @since ppl.cv-v1.0.0
+ * ###Example
+ * @code{.cpp}
+ * #include "ppl/cv/x86/imread.h"
+ *
+ * int32_t main(int32_t argc, char** argv) {
+ *     std::vector<const uchar*> data;  // the encoded images
+ *     std::vector<size_t> sizes;
+ *     std::vector<ppl::cv::x86::DecodedImage> images(data.size());
+ *
+ *     ppl::cv::x86::ImdecodeBatch(data.data(), sizes.data(), data.size(),
+ *                                 images.data(), 4);
+ *     for (auto& image : images) {
+ *         free(image.image);
+ *     }
+ *
+ *     return 0;
+ * }
+ * @endcode
+ ******************************************************************************/
+::ppl::common::RetCode ImdecodeBatch(const uchar* const* data,
+                                     const size_t* sizes,
+                                     int count,
+                                     DecodedImage* images,
+                                     int threads = 0,
+                                     const ImreadParams& params =
+                                         ImreadParams());
 
 } //! namespace x86
 } //! namespace cv
@@ -0,0 +1,284 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef __ST_HPC_PPL_CV_X86_IMWRITE_H_
+#define __ST_HPC_PPL_CV_X86_IMWRITE_H_
+
+#include <stddef.h>
+
+#include "ppl/cv/types.h"
+
+#include "ppl/common/retcode.h"
+
+namespace ppl {
+namespace cv {
+namespace x86 {
+
+enum PngCompressionLevels {
+    PNG_COMPRESSION_STORED  = 0, /**< no compression, stored blocks only */
+    PNG_COMPRESSION_FASTEST = 1, /**< Sub filter and runs of a byte only */
+    PNG_COMPRESSION_DEFAULT = 6, /**< adaptive filters and hash matching */
+    PNG_COMPRESSION_BEST    = 9, /**< adaptive filters and long hash chains */
+};
+
+// the same values as those of zlib and OpenCV.
+enum PngStrategies {
+    PNG_STRATEGY_DEFAULT      = 0, /**< parsing of the compression level */
+    PNG_STRATEGY_FILTERED     = 1, /**< matches shorter than 6 are dropped */
+    PNG_STRATEGY_HUFFMAN_ONLY = 2, /**< literals only */
+    PNG_STRATEGY_RLE          = 3, /**< matches at the distance of 1 only */
+    PNG_STRATEGY_FIXED        = 4, /**< no dynamic Huffman codes */
+};
+
+enum JpegSubsamplings {
+    JPEG_SUBSAMPLING_420 = 0, /**< a chroma sample of each 2x2 pixels */
+    JPEG_SUBSAMPLING_422 = 1, /**< a chroma sample of each 2x1 pixels */
+    JPEG_SUBSAMPLING_444 = 2, /**< no chroma subsampling */
+};
+
+/**
+ * @brief Options of the image encoders, each format reads its own fields.
+ * @remark
+ * <caption align="left">Requirements</caption>
+ * <tr><td>x86 platforms supported<td> All
+ * <tr><td>Header files<td> #include &lt;ppl/cv/x86/imwrite.h&gt;
+ * <tr><td>Project<td> ppl.cv
+ * @since ppl.cv-v1.0.0
+ ******************************************************************************/
+struct ImwriteParams {
+    int pngCompression;       // 0 ~ 9, PNG_COMPRESSION_FASTEST by default.
+    int pngStrategy;          // one of PngStrategies.
+    int jpegQuality;          // 0 ~ 100, 95 by default.
+    int jpegSubsampling;      // one of JpegSubsamplings.
+    int jpegRestartInterval;  // MCUs between restart markers, 0 ~ 65535.
+    bool jpegOptimize;        // Huffman tables built for the image.
+
+    ImwriteParams() : pngCompression(PNG_COMPRESSION_FASTEST),
+                      pngStrategy(PNG_STRATEGY_DEFAULT), jpegQuality(95),
+                      jpegSubsampling(JPEG_SUBSAMPLING_420),
+                      jpegRestartInterval(0), jpegOptimize(false) {}
+};
+
+/**
+ * @brief Saves an image to a file.
+ * @param fileName  name of file to be saved, the extension chooses the format.
+ * @param height    input image's height.
+ * @param width     input image's width.
+ * @param channels  input image's channels.
+ * @param stride    input image's row stride in bytes, not less than
+ *                  width * channels.
+ * @param image     input image data.
+ * @param params    options of the encoders, see ImwriteParams.
+ * @return The execution status, succeeds or fails with an error code.
+ * @note 1 Portable network graphcs(*.png), baseline JPEG files(*.jpg,
+ *         *.jpeg), quite OK images(*.qoi) and binary portable graymaps and
+ *         pixmaps(*.pgm, *.ppm, *.pnm) are supported for now, the extension
+ *         is not case sensitive.
+ *       2 1, 3 and 4 channels of uchar are supported by PNG and JPEG, 3 and
+ *         4 by QOI, 1 and 3 by PGM/PPM, which writes P5 for gray images and
+ *         P6 for color ones whatever the extension. Color images have the
+ *         channels stored in B G R / B G R A order as Imread() gives them,
+ *         and are written as gray, RGB and RGBA images.
+ *       3 The rows are filtered, converted and compressed block by block,
+ *         every 128k bytes of filtered rows are deflated into an IDAT chunk
+ *         and written at once, nothing of the size of the image is
+ *         allocated.
+ *       4 PNG_COMPRESSION_FASTEST filters the rows with Sub and only looks
+ *         for runs of a byte, which are coded with the literals by Huffman
+ *         codes built for each block. It is meant to keep up with the write
+ *         bandwidth of disks, masks and synthetic images still shrink a lot.
+ *         PNG_COMPRESSION_STORED does not compress at all. Higher levels
+ *         choose the filter of each row and search 4-byte hashes of the
+ *         earlier 32k bytes, the hash chains followed growing with the
+ *         level. Each block is sent as a stored, fixed or dynamic Huffman
+ *         block, whichever is the smallest.
+ *       5 Adler-32 of the zlib stream is computed with SSSE3, chunk crcs
+ *         with carry-less multiplication on processors with FMA and
+ *         PCLMULQDQ.
+ *       6 JPEG images are converted to full range YCbCr of JFIF, the chroma
+ *         averaged over the pixels of jpegSubsampling, and are transformed
+ *         and quantized with the integer DCT of libjpeg, two blocks at a
+ *         time with AVX2 on processors with FMA. The quantization tables
+ *         are those of the standard scaled by jpegQuality. The Huffman
+ *         tables are the standard ones, or are built from the counts of
+ *         the symbols when jpegOptimize is set, which takes the
+ *         coefficients of the whole image. A positive jpegRestartInterval
+ *         puts restart markers in the scan, whose intervals are then coded
+ *         by up to 4 threads, and alpha of 4 channels is dropped.
+ *       7 QOI and PGM/PPM are meant as fast intermediate formats, e.g. for
+ *         caches of decoded images. A QOI image takes no more than
+ *         height * width * (channels + 1) + 22 bytes, a PGM/PPM image no
+ *         more than height * width * channels + 32 bytes. Blocks of 64k bytes
+ *         and more, such as contiguous gray images, are written to the file
+ *         directly without going through the buffer of the writer.
+ * @warning All input parameters must be valid, or undefined behaviour may occur.
+ * @remark
+ * <caption align="left">Requirements</caption>
+ * <tr><td>x86 platforms supported<td> All
+ * <tr><td>Header files<td> #include &lt;ppl/cv/x86/imwrite.h&gt;
+ * <tr><td>Project<td> ppl.cv
+ * @since ppl.cv-v1.0.0
+ * ###Example
+ * @code{.cpp}
+ * #include "ppl/cv/x86/imwrite.h"
+ *
+ * int32_t main(int32_t argc, char** argv) {
+ *     const int32_t width = 640;
+ *     const int32_t height = 480;
+ *     const int32_t C = 3;
+ *     uchar* image = (uchar*)malloc(width * height * C * sizeof(uchar));
+ *
+ *     ppl::cv::x86::Imwrite("test.png", height, width, C, width * C, image);
+ *
+ *     free(image);
+ *
+ *     return 0;
+ * }
+ * @endcode
+ ******************************************************************************/
+::ppl::common::RetCode Imwrite(const char* fileName,
+                               int height,
+                               int width,
+                               int channels,
+                               int stride,
+                               const uchar* image,
+                               const ImwriteParams& params = ImwriteParams());
+
+/**
+ * @brief Encodes an image into a memory buffer.
+ * @param extension extension of the format, e.g. ".png".
+ * @param height    input image's height.
+ * @param width     input image's width.
+ * @param channels  input image's channels.
+ * @param stride    input image's row stride in bytes, not less than
+ *                  width * channels.
+ * @param image     input image data.
+ * @param size      pointer to store the size of the encoded image in bytes.
+ * @param data      pointer to a memory buffer storing the encoded image. This
+ *                  buffer is allocated in Imencode() and holds the same bytes
+ *                  Imwrite() writes to a file.
+ * @param params    options of the encoders, see ImwriteParams.
+ * @return The execution status, succeeds or fails with an error code.
+ * @note 1 Supported formats and images are the same as those of Imwrite().
+ *       2 data[] must be freed when unused.
+ * @warning All input parameters must be valid, or undefined behaviour may occur.
+ * @remark
+ * <caption align="left">Requirements</caption>
+ * <tr><td>x86 platforms supported<td> All
+ * <tr><td>Header files<td> #include &lt;ppl/cv/x86/imwrite.h&gt;
+ * <tr><td>Project<td> ppl.cv
+ * @since ppl.cv-v1.0.0
+ * ###Example
+ * @code{.cpp}
+ * #include "ppl/cv/x86/imwrite.h"
+ *
+ * int32_t main(int32_t argc, char** argv) {
+ *     const int32_t width = 640;
+ *     const int32_t height = 480;
+ *     uchar* image = (uchar*)malloc(width * height * sizeof(uchar));
+ *     size_t size;
+ *     uchar* data;
+ *
+ *     ppl::cv::x86::ImwriteParams params;
+ *     params.pngStrategy = ppl::cv::x86::PNG_STRATEGY_RLE;
+ *     ppl::cv::x86::Imencode(".png", height, width, 1, width, image, &size,
+ *                            &data, params);
+ *
+ *     free(data);
+ *     free(image);
+ *
+ *     return 0;
+ * }
+ * @endcode
+ ******************************************************************************/
+::ppl::common::RetCode Imencode(const char* extension,
+                                int height,
+                                int width,
+                                int channels,
+                                int stride,
+                                const uchar* image,
+                                size_t* size,
+                                uchar** data,
+                                const ImwriteParams& params = ImwriteParams());
+
+/**
+ * @brief Encodes an image into a caller-owned memory buffer.
+ * @param extension extension of the format, e.g. ".qoi".
+ * @param height    input image's height.
+ * @param width     input image's width.
+ * @param channels  input image's channels.
+ * @param stride    input image's row stride in bytes, not less than
+ *                  width * channels.
+ * @param image     input image data.
+ * @param capacity  size of data[] in bytes.
+ * @param data      memory buffer to store the encoded image.
+ * @param size      pointer to store the size of the encoded image in bytes.
+ * @param params    options of the encoders, see ImwriteParams.
+ * @return The execution status, succeeds or fails with an error code.
+ * @note 1 Supported formats and images are the same as those of Imwrite().
+ *       2 Nothing is allocated for the output, so that a cache writer may
+ *         encode many images into a buffer of its own, one after another.
+ *         The bounds in note 7 of Imwrite() tell the capacity which is
+ *         always enough for QOI and PGM/PPM.
+ *       3 The function fails with RC_INVALID_VALUE when the encoded image
+ *         does not fit in data[], the content of data[] is undefined then.
+ * @warning All input parameters must be valid, or undefined behaviour may occur.
+ * @remark
+ * <caption align="left">Requirements</caption>
+ * <tr><td>x86 platforms supported<td> All
+ * <tr><td>Header files<td> #include &lt;ppl/cv/x86/imwrite.h&gt;
+ * <tr><td>Project<td> ppl.cv
+ * @since ppl.cv-v1.0.0
+ * ###Example
+ * @code{.cpp}
+ * #include "ppl/cv/x86/imwrite.h"
+ *
+ * int32_t main(int32_t argc, char** argv) {
+ *     const int32_t width = 640;
+ *     const int32_t height = 480;
+ *     const int32_t C = 3;
+ *     uchar* image = (uchar*)malloc(width * height * C * sizeof(uchar));
+ *     size_t capacity = (size_t)width * height * (C + 1) + 22;
+ *     uchar* data = (uchar*)malloc(capacity);
+ *     size_t size;
+ *
+ *     ppl::cv::x86::Imencode(".qoi", height, width, C, width * C, image,
+ *                            capacity, data, &size);
+ *
+ *     free(data);
+ *     free(image);
+ *
+ *     return 0;
+ * }
+ * @endcode
+ ******************************************************************************/
+::ppl::common::RetCode Imencode(const char* extension,
+                                int height,
+                                int width,
+                                int channels,
+                                int stride,
+                                const uchar* image,
+                                size_t capacity,
+                                uchar* data,
+                                size_t* size,
+                                const ImwriteParams& params = ImwriteParams());
+
+} //! namespace x86
+} //! namespace cv
+} //! namespace ppl
+
+#endif //! __ST_HPC_PPL_CV_X86_IMWRITE_H_
@@ -0,0 +1,92 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef __ST_HPC_PPL_CV_X86_INRANGE_H_
+#define __ST_HPC_PPL_CV_X86_INRANGE_H_
+
+#include "ppl/common/retcode.h"
+#include "ppl/cv/types.h"
+
+namespace ppl {
+namespace cv {
+namespace x86 {
+
+/**
+ * @brief Checks if image elements lie between the elements of two scalars,
+ *        out = 255 if lowerBound[c] <= in[c] <= upperBound[c] for every channel c, 0 otherwise.
+ * @tparam T The data type of input image, currently only \a uint8_t(uchar) and \a float are supported.
+ * @tparam nc The number of channels of input image, 1, 3 and 4 are supported.
+ * @param height            input image's height
+ * @param width             input image's width need to be processed
+ * @param inWidthStride     input image's width stride, usually it equals to `width * nc`
+ * @param inData            input image data
+ * @param lowerBound        inclusive lower boundary of each channel, nc values
+ * @param upperBound        inclusive upper boundary of each channel, nc values
+ * @param outWidthStride    output mask's width stride, usually it equals to `width`
+ * @param outData           output mask data, a single channel uint8_t image
+ * @warning All input parameters must be valid, or undefined behaviour may occur.
+ * @remark The following table show which data type and channels are supported.
+ * <table>
+ * <tr><th>Data type(T)<th>channels
+ * <tr><td>float<td>1
+ * <tr><td>float<td>3
+ * <tr><td>float<td>4
+ * <tr><td>uint8_t(uchar)<td>1
+ * <tr><td>uint8_t(uchar)<td>3
+ * <tr><td>uint8_t(uchar)<td>4
+ * </table>
+ * <table>
+ * <caption align="left">Requirements</caption>
+ * <tr><td>X86 platforms supported<td> All
+ * <tr><td>Header files<td> #include &lt;ppl/cv/x86/inrange.h&gt;
+ * <tr><td>Project<td> ppl.cv
+ * @since ppl.cv-v1.0.0
+ * ###Example
+ * @code{.cpp}
+ * #include <ppl/cv/x86/inrange.h>
+ * int32_t main(int32_t argc, char** argv) {
+ *     const int32_t W = 640;
+ *     const int32_t H = 480;
+ *     const int32_t C = 3;
+ *     const uint8_t lower[C] = {0, 100, 100};
+ *     const uint8_t upper[C] = {10, 255, 255};
+ *     uint8_t* dev_iImage = (uint8_t*)malloc(W * H * C * sizeof(uint8_t));
+ *     uint8_t* dev_oImage = (uint8_t*)malloc(W * H * sizeof(uint8_t));
+ *
+ *     ppl::cv::x86::InRange<uint8_t, C>(H, W, W * C, dev_iImage, lower, upper, W, dev_oImage);
+ *
+ *     free(dev_iImage);
+ *     free(dev_oImage);
+ *     return 0;
+ * }
+ * @endcode
+ ***************************************************************************************************/
+template <typename T, int32_t nc>
+::ppl::common::RetCode InRange(
+    int32_t height,
+    int32_t width,
+    int32_t inWidthStride,
+    const T* inData,
+    const T* lowerBound,
+    const T* upperBound,
+    int32_t outWidthStride,
+    uint8_t* outData);
+
+}
+}
+} // namespace ppl::cv::x86
+#endif //! __ST_HPC_PPL_CV_X86_INRANGE_H_
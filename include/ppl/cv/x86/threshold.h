@@ -0,0 +1,101 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef __ST_HPC_PPL_CV_X86_THRESHOLD_H_
+#define __ST_HPC_PPL_CV_X86_THRESHOLD_H_
+
+#include "ppl/common/retcode.h"
+#include "ppl/cv/types.h"
+
+namespace ppl {
+namespace cv {
+namespace x86 {
+
+/**
+ * @brief Applies a fixed-level threshold to each element of an image.
+ * @tparam T The data type of input and output image, currently only \a uint8_t(uchar) and \a float are supported.
+ * @tparam nc The number of channels of input image and output image, 1, 3 and 4 are supported.
+ * @param height            input image's height
+ * @param width             input image's width need to be processed
+ * @param inWidthStride     input image's width stride, usually it equals to `width * nc`
+ * @param inData            input image data
+ * @param outWidthStride    output image's width stride, usually it equals to `width * nc`
+ * @param outData           output image data
+ * @param thresh            threshold value, ignored when CV_THRESH_OTSU is set
+ * @param maxValue          value assigned to the elements above the threshold with CV_THRESH_BINARY
+ *                          and to the elements not above it with CV_THRESH_BINARY_INV
+ * @param thresholdType     one of CV_THRESH_BINARY, CV_THRESH_BINARY_INV, CV_THRESH_TRUNC, CV_THRESH_TOZERO
+ *                          and CV_THRESH_TOZERO_INV, optionally combined with CV_THRESH_OTSU
+ * @param computedThresh    [optional] receives the threshold actually used, which is the Otsu threshold
+ *                          when CV_THRESH_OTSU is set, and thresh floored for uint8_t
+ * @warning All input parameters must be valid, or undefined behaviour may occur.
+ * @note CV_THRESH_OTSU is only supported for single channel uint8_t images, other types
+ *       and channels return RC_INVALID_VALUE. The histogram is taken over the whole image
+ *       in a single pass before it is thresholded.
+ * @remark The following table show which data type and channels are supported.
+ * <table>
+ * <tr><th>Data type(T)<th>channels
+ * <tr><td>float<td>1
+ * <tr><td>float<td>3
+ * <tr><td>float<td>4
+ * <tr><td>uint8_t(uchar)<td>1
+ * <tr><td>uint8_t(uchar)<td>3
+ * <tr><td>uint8_t(uchar)<td>4
+ * </table>
+ * <table>
+ * <caption align="left">Requirements</caption>
+ * <tr><td>X86 platforms supported<td> All
+ * <tr><td>Header files<td> #include &lt;ppl/cv/x86/threshold.h&gt;
+ * <tr><td>Project<td> ppl.cv
+ * @since ppl.cv-v1.0.0
+ * ###Example
+ * @code{.cpp}
+ * #include <ppl/cv/x86/threshold.h>
+ * int32_t main(int32_t argc, char** argv) {
+ *     const int32_t W = 640;
+ *     const int32_t H = 480;
+ *     const int32_t C = 1;
+ *     uint8_t* dev_iImage = (uint8_t*)malloc(W * H * C * sizeof(uint8_t));
+ *     uint8_t* dev_oImage = (uint8_t*)malloc(W * H * C * sizeof(uint8_t));
+ *     double otsu;
+ *
+ *     ppl::cv::x86::Threshold<uint8_t, C>(H, W, W * C, dev_iImage, W * C, dev_oImage, 0, 255,
+ *         ppl::cv::CV_THRESH_BINARY | ppl::cv::CV_THRESH_OTSU, &otsu);
+ *
+ *     free(dev_iImage);
+ *     free(dev_oImage);
+ *     return 0;
+ * }
+ * @endcode
+ ***************************************************************************************************/
+template <typename T, int32_t nc>
+::ppl::common::RetCode Threshold(
+    int32_t height,
+    int32_t width,
+    int32_t inWidthStride,
+    const T* inData,
+    int32_t outWidthStride,
+    T* outData,
+    double thresh,
+    double maxValue,
+    int32_t thresholdType,
+    double* computedThresh = nullptr);
+
+}
+}
+} // namespace ppl::cv::x86
+#endif //! __ST_HPC_PPL_CV_X86_THRESHOLD_H_
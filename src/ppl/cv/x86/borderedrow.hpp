@@ -0,0 +1,322 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef __ST_HPC_PPL_CV_X86_BORDEREDROW_HPP_
+#define __ST_HPC_PPL_CV_X86_BORDEREDROW_HPP_
+
+#include "ppl/cv/types.h"
+#include "ppl/common/sys.h"
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include <immintrin.h>
+
+namespace ppl {
+namespace cv {
+namespace x86 {
+
+/**
+ * Maps coordinate p to [0, len) according to border_type, -1 is returned for
+ * BORDER_CONSTANT. The reflection is repeated, so the result is valid even if
+ * the border is wider than the image.
+ */
+inline int32_t borderedIndex(int32_t p, int32_t len, BorderType border_type)
+{
+    if ((uint32_t)p < (uint32_t)len) {
+        return p;
+    }
+    if (border_type == ppl::cv::BORDER_CONSTANT) {
+        return -1;
+    }
+    if (border_type == ppl::cv::BORDER_REPLICATE) {
+        return p < 0 ? 0 : len - 1;
+    }
+    if (border_type == ppl::cv::BORDER_WRAP) {
+        p %= len;
+        return p < 0 ? p + len : p;
+    }
+    if (len == 1) {
+        return 0;
+    }
+    int32_t delta = border_type == ppl::cv::BORDER_REFLECT_101 ? 1 : 0;
+    do {
+        p = p < 0 ? -p - 1 + delta : 2 * len - 1 - p - delta;
+    } while ((uint32_t)p >= (uint32_t)len);
+    return p;
+}
+
+// dst pixel i = src pixel (count - 1 - i).
+template <typename T, int32_t cn>
+inline void reversePixels(const T *src, int32_t count, T *dst)
+{
+    for (int32_t i = 0; i < count; i++) {
+        const T *s = src + (count - 1 - i) * cn;
+        for (int32_t c = 0; c < cn; c++) {
+            dst[i * cn + c] = s[c];
+        }
+    }
+}
+
+template <>
+inline void reversePixels<uint8_t, 1>(const uint8_t *src, int32_t count, uint8_t *dst)
+{
+    const __m128i mask = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    int32_t i          = 0;
+    for (; i <= count - 16; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + count - i - 16));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_shuffle_epi8(v, mask));
+    }
+    for (; i < count; i++) {
+        dst[i] = src[count - 1 - i];
+    }
+}
+
+template <>
+inline void reversePixels<uint8_t, 4>(const uint8_t *src, int32_t count, uint8_t *dst)
+{
+    int32_t i = 0;
+    for (; i <= count - 4; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + (count - i - 4) * 4));
+        _mm_storeu_si128((__m128i *)(dst + i * 4), _mm_shuffle_epi32(v, 0x1B));
+    }
+    for (; i < count; i++) {
+        memcpy(dst + i * 4, src + (count - 1 - i) * 4, 4);
+    }
+}
+
+template <>
+inline void reversePixels<float, 1>(const float *src, int32_t count, float *dst)
+{
+    int32_t i = 0;
+    for (; i <= count - 4; i += 4) {
+        __m128 v = _mm_loadu_ps(src + count - i - 4);
+        _mm_storeu_ps(dst + i, _mm_shuffle_ps(v, v, 0x1B));
+    }
+    for (; i < count; i++) {
+        dst[i] = src[count - 1 - i];
+    }
+}
+
+template <>
+inline void reversePixels<float, 4>(const float *src, int32_t count, float *dst)
+{
+    for (int32_t i = 0; i < count; i++) {
+        _mm_storeu_ps(dst + i * 4, _mm_loadu_ps(src + (count - 1 - i) * 4));
+    }
+}
+
+template <typename T, int32_t cn>
+inline void fillPixels(const T *value, int32_t count, T *dst)
+{
+    if (cn == 1) {
+        std::fill(dst, dst + count, value[0]);
+        return;
+    }
+    for (int32_t i = 0; i < count; i++) {
+        for (int32_t c = 0; c < cn; c++) {
+            dst[i * cn + c] = value[c];
+        }
+    }
+}
+
+/**
+ * Fills the left and right border of one padded row. src is the unpadded
+ * source row of width pixels, dst points to the first left border pixel and
+ * the interior dst + left * cn is left untouched. Reflected and wrapped edges
+ * are copied as one (reversed) run of pixels when the border is not wider than
+ * the image, otherwise every pixel is interpolated on its own.
+ */
+template <typename T, int32_t cn>
+inline void fillBorderedEdges(
+    const T *src,
+    int32_t width,
+    int32_t left,
+    int32_t right,
+    BorderType border_type,
+    T border_value,
+    T *dst)
+{
+    T *dst_right = dst + (left + width) * cn;
+    if (border_type == ppl::cv::BORDER_CONSTANT) {
+        std::fill(dst, dst + left * cn, border_value);
+        std::fill(dst_right, dst_right + right * cn, border_value);
+        return;
+    }
+    if (border_type == ppl::cv::BORDER_REPLICATE) {
+        fillPixels<T, cn>(src, left, dst);
+        fillPixels<T, cn>(src + (width - 1) * cn, right, dst_right);
+        return;
+    }
+
+    if (border_type == ppl::cv::BORDER_WRAP) {
+        if (left <= width) {
+            memcpy(dst, src + (width - left) * cn, left * cn * sizeof(T));
+            left = 0;
+        }
+        if (right <= width) {
+            memcpy(dst_right, src, right * cn * sizeof(T));
+            right = 0;
+        }
+    } else {
+        int32_t delta = border_type == ppl::cv::BORDER_REFLECT_101 ? 1 : 0;
+        if (left + delta <= width) {
+            reversePixels<T, cn>(src + delta * cn, left, dst);
+            left = 0;
+        }
+        if (right + delta <= width) {
+            reversePixels<T, cn>(src + (width - right - delta) * cn, right, dst_right);
+            right = 0;
+        }
+    }
+
+    // borders wider than the image.
+    for (int32_t i = 0; i < left; i++) {
+        memcpy(dst + i * cn, src + borderedIndex(i - left, width, border_type) * cn, cn * sizeof(T));
+    }
+    for (int32_t i = 0; i < right; i++) {
+        memcpy(dst_right + i * cn, src + borderedIndex(width + i, width, border_type) * cn, cn * sizeof(T));
+    }
+}
+
+/**
+ * Builds one padded row of (left + width + right) pixels into dst.
+ */
+template <typename T, int32_t cn>
+inline void makeBorderedRow(
+    const T *src,
+    int32_t width,
+    int32_t left,
+    int32_t right,
+    BorderType border_type,
+    T border_value,
+    T *dst)
+{
+    if (dst + left * cn != src) {
+        memcpy(dst + left * cn, src, width * cn * sizeof(T));
+    }
+    fillBorderedEdges<T, cn>(src, width, left, right, border_type, border_value, dst);
+}
+
+/**
+ * Hands out padded rows of an image without materializing the whole padded
+ * image. Rows are built on demand into a small ring of ring_size scratch rows,
+ * y may be any row index, rows outside of [0, height) are interpolated with
+ * border_type. The ring is managed in least recently used order, so a
+ * returned pointer stays valid until ring_size other distinct rows have been
+ * requested, e.g. a ring of ksize rows serves a vertical sliding window of
+ * ksize rows with one new row built per output row.
+ */
+template <typename T, int32_t cn>
+class BorderedRowProvider {
+  public:
+    BorderedRowProvider(
+        int32_t height,
+        int32_t width,
+        int32_t inWidthStride,
+        const T *inData,
+        int32_t left,
+        int32_t right,
+        BorderType border_type,
+        T border_value,
+        int32_t ring_size)
+        : height_(height)
+        , width_(width)
+        , inWidthStride_(inWidthStride)
+        , inData_(inData)
+        , left_(left)
+        , right_(right)
+        , border_type_(border_type)
+        , border_value_(border_value)
+        , ring_size_(std::max(ring_size, 1))
+        , slot_rows_(ring_size_, -1)
+        , slot_stamps_(ring_size_, 0)
+        , stamp_(0)
+    {
+        // one more row for the constant border.
+        row_stride_ = (((left + width + right) * cn * (int32_t)sizeof(T) + 63) & ~63) / (int32_t)sizeof(T);
+        buffer_     = (T *)ppl::common::AlignedAlloc((size_t)(ring_size_ + 1) * row_stride_ * sizeof(T), 64);
+        if (buffer_ != nullptr && border_type == ppl::cv::BORDER_CONSTANT) {
+            T *row = buffer_ + ring_size_ * row_stride_;
+            std::fill(row, row + rowLength(), border_value);
+        }
+    }
+    ~BorderedRowProvider()
+    {
+        if (buffer_ != nullptr) {
+            ppl::common::AlignedFree(buffer_);
+        }
+    }
+
+    bool valid() const
+    {
+        return buffer_ != nullptr;
+    }
+    // number of elements in a padded row.
+    int32_t rowLength() const
+    {
+        return (left_ + width_ + right_) * cn;
+    }
+
+    const T *getRow(int32_t y)
+    {
+        int32_t sy = borderedIndex(y, height_, border_type_);
+        if (sy < 0) {
+            return buffer_ + ring_size_ * row_stride_;
+        }
+        int32_t slot = 0;
+        for (int32_t i = 0; i < ring_size_; i++) {
+            if (slot_rows_[i] == sy) {
+                slot_stamps_[i] = ++stamp_;
+                return buffer_ + i * row_stride_;
+            }
+            if (slot_stamps_[i] < slot_stamps_[slot]) {
+                slot = i;
+            }
+        }
+        T *row = buffer_ + slot * row_stride_;
+        makeBorderedRow<T, cn>(inData_ + sy * inWidthStride_, width_, left_, right_, border_type_, border_value_, row);
+        slot_rows_[slot]   = sy;
+        slot_stamps_[slot] = ++stamp_;
+        return row;
+    }
+
+  private:
+    BorderedRowProvider(const BorderedRowProvider &);
+    BorderedRowProvider &operator=(const BorderedRowProvider &);
+
+    int32_t height_;
+    int32_t width_;
+    int32_t inWidthStride_;
+    const T *inData_;
+    int32_t left_;
+    int32_t right_;
+    BorderType border_type_;
+    T border_value_;
+    int32_t ring_size_;
+    int32_t row_stride_;
+    T *buffer_;
+    std::vector<int32_t> slot_rows_;
+    std::vector<int64_t> slot_stamps_;
+    int64_t stamp_;
+};
+
+} //! namespace x86
+} //! namespace cv
+} //! namespace ppl
+
+#endif //! __ST_HPC_PPL_CV_X86_BORDEREDROW_HPP_
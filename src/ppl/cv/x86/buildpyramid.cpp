@@ -0,0 +1,133 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "ppl/cv/x86/buildpyramid.h"
+#include "ppl/cv/x86/pyramid.hpp"
+#include "ppl/cv/types.h"
+#include "ppl/common/sys.h"
+#include <vector>
+#include <type_traits>
+
+namespace ppl {
+namespace cv {
+namespace x86 {
+
+template <typename T, typename W>
+static ::ppl::common::RetCode buildpyramid_kernel(
+    int32_t height,
+    int32_t width,
+    int32_t channels,
+    int32_t inWidthStride,
+    const T *inData,
+    int32_t maxLevel,
+    const int32_t *outWidthStrides,
+    T **outData)
+{
+    // level 0 is the input image, the rest are the outputs.
+    std::vector<int32_t> heights(maxLevel + 1), widths(maxLevel + 1), strides(maxLevel + 1);
+    std::vector<const T *> data(maxLevel + 1);
+    std::vector<int32_t> produced(maxLevel + 1, 0);
+    heights[0]  = height;
+    widths[0]   = width;
+    strides[0]  = inWidthStride;
+    data[0]     = inData;
+    produced[0] = height;
+    for (int32_t l = 1; l <= maxLevel; ++l) {
+        heights[l] = (heights[l - 1] + 1) / 2;
+        widths[l]  = (widths[l - 1] + 1) / 2;
+        strides[l] = outWidthStrides[l - 1];
+        data[l]    = outData[l - 1];
+    }
+
+    // the row kernels run one row at a time, so the scratch of the widest
+    // level serves all of them.
+    W *buffer = (W *)ppl::common::AlignedAlloc(pyrScratchLength(width, channels) * sizeof(W), 64);
+    if (buffer == nullptr) {
+        return ppl::common::RC_OUT_OF_MEMORY;
+    }
+
+    const T *rows[5];
+    for (int32_t y = 0; y < heights[1]; ++y) {
+        // row y of level l needs rows up to 2 * y + 2 of level l - 1, so each
+        // new row is pushed down the pyramid as far as it goes.
+        for (int32_t l = 1; l <= maxLevel; ++l) {
+            while (produced[l] < heights[l]) {
+                int32_t oy   = produced[l];
+                int32_t last = 2 * oy + 2 < heights[l - 1] - 1 ? 2 * oy + 2 : heights[l - 1] - 1;
+                if (last >= produced[l - 1]) {
+                    break;
+                }
+                for (int32_t k = 0; k < 5; ++k) {
+                    rows[k] = data[l - 1] + pyrReflect101(oy * 2 - 2 + k, heights[l - 1]) * strides[l - 1];
+                }
+                pyrdown_row(rows, widths[l - 1], channels, widths[l], buffer, outData[l - 1] + oy * strides[l]);
+                produced[l]++;
+                if (l == 1) {
+                    break;
+                }
+            }
+        }
+    }
+
+    ppl::common::AlignedFree(buffer);
+    return ppl::common::RC_SUCCESS;
+}
+
+template <typename T, int32_t nc>
+::ppl::common::RetCode BuildPyramid(
+    int32_t height,
+    int32_t width,
+    int32_t inWidthStride,
+    const T *inData,
+    int32_t maxLevel,
+    const int32_t *outWidthStrides,
+    T **outData,
+    BorderType border_type)
+{
+    if (inData == nullptr || (maxLevel > 0 && (outWidthStrides == nullptr || outData == nullptr))) {
+        return ppl::common::RC_INVALID_VALUE;
+    }
+    if (height <= 0 || width <= 0 || inWidthStride < width * nc || maxLevel < 0) {
+        return ppl::common::RC_INVALID_VALUE;
+    }
+    if (border_type != ppl::cv::BORDER_REFLECT_101) {
+        return ppl::common::RC_INVALID_VALUE;
+    }
+    int32_t levelWidth = width;
+    for (int32_t l = 0; l < maxLevel; ++l) {
+        levelWidth = (levelWidth + 1) / 2;
+        if (outData[l] == nullptr || outWidthStrides[l] < levelWidth * nc) {
+            return ppl::common::RC_INVALID_VALUE;
+        }
+    }
+    if (maxLevel == 0) {
+        return ppl::common::RC_SUCCESS;
+    }
+    return buildpyramid_kernel<T, typename std::conditional<std::is_same<T, uint8_t>::value, uint16_t, float>::type>(
+        height, width, nc, inWidthStride, inData, maxLevel, outWidthStrides, outData);
+}
+
+template ::ppl::common::RetCode BuildPyramid<float, 1>(int32_t height, int32_t width, int32_t inWidthStride, const float *inData, int32_t maxLevel, const int32_t *outWidthStrides, float **outData, BorderType border_type);
+template ::ppl::common::RetCode BuildPyramid<float, 3>(int32_t height, int32_t width, int32_t inWidthStride, const float *inData, int32_t maxLevel, const int32_t *outWidthStrides, float **outData, BorderType border_type);
+template ::ppl::common::RetCode BuildPyramid<float, 4>(int32_t height, int32_t width, int32_t inWidthStride, const float *inData, int32_t maxLevel, const int32_t *outWidthStrides, float **outData, BorderType border_type);
+template ::ppl::common::RetCode BuildPyramid<uint8_t, 1>(int32_t height, int32_t width, int32_t inWidthStride, const uint8_t *inData, int32_t maxLevel, const int32_t *outWidthStrides, uint8_t **outData, BorderType border_type);
+template ::ppl::common::RetCode BuildPyramid<uint8_t, 3>(int32_t height, int32_t width, int32_t inWidthStride, const uint8_t *inData, int32_t maxLevel, const int32_t *outWidthStrides, uint8_t **outData, BorderType border_type);
+template ::ppl::common::RetCode BuildPyramid<uint8_t, 4>(int32_t height, int32_t width, int32_t inWidthStride, const uint8_t *inData, int32_t maxLevel, const int32_t *outWidthStrides, uint8_t **outData, BorderType border_type);
+
+}
+}
+} // namespace ppl::cv::x86
@@ -0,0 +1,109 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <benchmark/benchmark.h>
+#include "ppl/cv/x86/buildpyramid.h"
+#include "ppl/cv/debug.h"
+#include <vector>
+
+namespace {
+template<typename T, int32_t channels>
+class BuildPyramidBenchmark {
+public:
+    int32_t height;
+    int32_t width;
+    int32_t maxLevel;
+    T *inData;
+    std::vector<T*> outData;
+    std::vector<int32_t> outWidthStrides;
+
+    BuildPyramidBenchmark(int32_t height, int32_t width, int32_t maxLevel)
+        : height(height)
+        , width(width)
+        , maxLevel(maxLevel)
+        , outData(maxLevel)
+        , outWidthStrides(maxLevel)
+    {
+        inData = (T*)malloc(height * width * channels * sizeof(T));
+        memset(inData, 0, height * width * channels * sizeof(T));
+        int32_t h = height, w = width;
+        for (int32_t i = 0; i < maxLevel; ++i) {
+            h = (h + 1) / 2;
+            w = (w + 1) / 2;
+            outWidthStrides[i] = w * channels;
+            outData[i] = (T*)malloc(h * w * channels * sizeof(T));
+        }
+    }
+
+    void apply() {
+        ppl::cv::x86::BuildPyramid<T, channels>(height, width, width * channels, inData,
+            maxLevel, outWidthStrides.data(), outData.data(), ppl::cv::BORDER_DEFAULT);
+    }
+    void apply_opencv() {
+        cv::Mat iMat(height, width, T2CvType<T, channels>::type, inData);
+        std::vector<cv::Mat> pyramid;
+        cv::buildPyramid(iMat, pyramid, maxLevel);
+    }
+
+    ~BuildPyramidBenchmark() {
+        free(inData);
+        for (int32_t i = 0; i < maxLevel; ++i) {
+            free(outData[i]);
+        }
+    }
+};
+}
+
+using namespace ppl::cv::debug;
+
+template<typename T, int32_t channels>
+static void BM_BuildPyramid_ppl_x86(benchmark::State &state) {
+    BuildPyramidBenchmark<T, channels> bm(state.range(1), state.range(0), 4);
+    for (auto _: state) {
+        bm.apply();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * state.range(0) * state.range(1) * sizeof(T) * channels);
+}
+
+template<typename T, int32_t channels>
+static void BM_BuildPyramid_opencv_x86(benchmark::State &state) {
+    BuildPyramidBenchmark<T, channels> bm(state.range(1), state.range(0), 4);
+    for (auto _: state) {
+        bm.apply_opencv();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * state.range(0) * state.range(1) * sizeof(T) * channels);
+}
+//pplcv
+BENCHMARK_TEMPLATE(BM_BuildPyramid_ppl_x86, float, c1)->Args({640, 480})->Args({1920, 1080});
+BENCHMARK_TEMPLATE(BM_BuildPyramid_ppl_x86, float, c3)->Args({640, 480})->Args({1920, 1080});
+BENCHMARK_TEMPLATE(BM_BuildPyramid_ppl_x86, float, c4)->Args({640, 480})->Args({1920, 1080});
+
+BENCHMARK_TEMPLATE(BM_BuildPyramid_ppl_x86, uint8_t, c1)->Args({640, 480})->Args({1920, 1080});
+BENCHMARK_TEMPLATE(BM_BuildPyramid_ppl_x86, uint8_t, c3)->Args({640, 480})->Args({1920, 1080});
+BENCHMARK_TEMPLATE(BM_BuildPyramid_ppl_x86, uint8_t, c4)->Args({640, 480})->Args({1920, 1080});
+//opencv
+BENCHMARK_TEMPLATE(BM_BuildPyramid_opencv_x86, float, c1)->Args({640, 480})->Args({1920, 1080});
+BENCHMARK_TEMPLATE(BM_BuildPyramid_opencv_x86, float, c3)->Args({640, 480})->Args({1920, 1080});
+BENCHMARK_TEMPLATE(BM_BuildPyramid_opencv_x86, float, c4)->Args({640, 480})->Args({1920, 1080});
+
+BENCHMARK_TEMPLATE(BM_BuildPyramid_opencv_x86, uint8_t, c1)->Args({640, 480})->Args({1920, 1080});
+BENCHMARK_TEMPLATE(BM_BuildPyramid_opencv_x86, uint8_t, c3)->Args({640, 480})->Args({1920, 1080});
+BENCHMARK_TEMPLATE(BM_BuildPyramid_opencv_x86, uint8_t, c4)->Args({640, 480})->Args({1920, 1080});
@@ -0,0 +1,87 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "ppl/cv/x86/buildpyramid.h"
+#include "ppl/cv/x86/test.h"
+#include <gtest/gtest.h>
+#include "ppl/cv/debug.h"
+#include <memory>
+#include <vector>
+
+template<typename T, int32_t c>
+class BuildPyramid : public ::testing::TestWithParam<std::tuple<Size, int32_t>> {
+public:
+    using BuildPyramidParam = std::tuple<Size, int32_t>;
+    BuildPyramid()
+    {
+    }
+
+    ~BuildPyramid()
+    {
+    }
+
+    void apply(const BuildPyramidParam &param) {
+        Size isize = std::get<0>(param);
+        int32_t maxLevel = std::get<1>(param);
+
+        std::unique_ptr<T[]> src(new T[isize.width * isize.height * c]);
+        ppl::cv::debug::randomFill<T>(src.get(), isize.width * isize.height * c, 0, 255);
+
+        std::vector<Size> sizes(maxLevel);
+        std::vector<std::unique_ptr<T[]>> dst(maxLevel);
+        std::vector<T*> outData(maxLevel);
+        std::vector<int32_t> outWidthStrides(maxLevel);
+        Size size = isize;
+        for (int32_t i = 0; i < maxLevel; ++i) {
+            size = Size{(size.width + 1) / 2, (size.height + 1) / 2};
+            sizes[i] = size;
+            dst[i].reset(new T[size.width * size.height * c]);
+            outData[i] = dst[i].get();
+            outWidthStrides[i] = size.width * c;
+        }
+
+        ppl::cv::x86::BuildPyramid<T, c>(isize.height, isize.width, isize.width * c, src.get(),
+            maxLevel, outWidthStrides.data(), outData.data(), ppl::cv::BORDER_DEFAULT);
+
+        ::cv::Mat iMat(isize.height, isize.width, T2CvType<T, c>::type, src.get());
+        std::vector<::cv::Mat> pyramid;
+        ::cv::buildPyramid(iMat, pyramid, maxLevel);
+        for (int32_t i = 0; i < maxLevel; ++i) {
+            const ::cv::Mat &oMat = pyramid[i + 1];
+            checkResult<T, c>(dst[i].get(), (const T*)oMat.data, sizes[i].height, sizes[i].width,
+                sizes[i].width * c, oMat.step / sizeof(T), 1e-3);
+        }
+    }
+};
+
+#define R(name, t, c)\
+    using name = BuildPyramid<t, c>;\
+    TEST_P(name, t ## c)\
+    {\
+        this->apply(GetParam());\
+    }\
+    INSTANTIATE_TEST_CASE_P(standard, name,\
+        ::testing::Combine(::testing::Values(Size{6, 8}, Size{320, 240}, Size{321, 241}),\
+                           ::testing::Values(1, 4)));
+
+R(BuildPyramid_x86_f32c1, float, 1)
+R(BuildPyramid_x86_f32c3, float, 3)
+R(BuildPyramid_x86_f32c4, float, 4)
+
+R(BuildPyramid_x86_u8c1, uint8_t, 1)
+R(BuildPyramid_x86_u8c3, uint8_t, 3)
+R(BuildPyramid_x86_u8c4, uint8_t, 4)
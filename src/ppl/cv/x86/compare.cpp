@@ -0,0 +1,197 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "ppl/cv/x86/compare.h"
+#include "ppl/cv/types.h"
+#include <immintrin.h>
+
+namespace ppl {
+namespace cv {
+namespace x86 {
+
+/*
+ * CMP_LT and CMP_LE are run as CMP_GT and CMP_GE with the operands swapped,
+ * so only four comparisons are implemented.
+ */
+template <int32_t op>
+static inline __m128i compare_u8(__m128i v_src0, __m128i v_src1)
+{
+    const __m128i v_sign = _mm_set1_epi8((char)0x80);
+    const __m128i v_ones = _mm_set1_epi8(-1);
+    switch (op) {
+        case ppl::cv::CMP_EQ:
+            return _mm_cmpeq_epi8(v_src0, v_src1);
+        case ppl::cv::CMP_NE:
+            return _mm_xor_si128(_mm_cmpeq_epi8(v_src0, v_src1), v_ones);
+        case ppl::cv::CMP_GT:
+            return _mm_cmpgt_epi8(_mm_xor_si128(v_src0, v_sign), _mm_xor_si128(v_src1, v_sign));
+        default:
+            return _mm_cmpeq_epi8(_mm_max_epu8(v_src0, v_src1), v_src0);
+    }
+}
+
+template <int32_t op>
+static inline __m128 compare_f32(__m128 v_src0, __m128 v_src1)
+{
+    switch (op) {
+        case ppl::cv::CMP_EQ:
+            return _mm_cmpeq_ps(v_src0, v_src1);
+        case ppl::cv::CMP_NE:
+            return _mm_cmpneq_ps(v_src0, v_src1);
+        case ppl::cv::CMP_GT:
+            return _mm_cmpgt_ps(v_src0, v_src1);
+        default:
+            return _mm_cmpge_ps(v_src0, v_src1);
+    }
+}
+
+template <int32_t op, typename T>
+static inline uint8_t compare_scalar(T src0, T src1)
+{
+    switch (op) {
+        case ppl::cv::CMP_EQ:
+            return src0 == src1 ? 255 : 0;
+        case ppl::cv::CMP_NE:
+            return src0 != src1 ? 255 : 0;
+        case ppl::cv::CMP_GT:
+            return src0 > src1 ? 255 : 0;
+        default:
+            return src0 >= src1 ? 255 : 0;
+    }
+}
+
+template <int32_t op>
+static void compare_kernel(
+    int32_t height,
+    int32_t length,
+    int32_t inWidthStride0,
+    const uint8_t *inData0,
+    int32_t inWidthStride1,
+    const uint8_t *inData1,
+    int32_t outWidthStride,
+    uint8_t *outData)
+{
+    for (int32_t i = 0; i < height; i++) {
+        const uint8_t *src0 = inData0 + i * inWidthStride0;
+        const uint8_t *src1 = inData1 + i * inWidthStride1;
+        uint8_t *dst        = outData + i * outWidthStride;
+        int32_t j           = 0;
+        for (; j <= length - 32; j += 32) {
+            __m128i v_a0 = _mm_loadu_si128((const __m128i *)(src0 + j));
+            __m128i v_a1 = _mm_loadu_si128((const __m128i *)(src0 + j + 16));
+            __m128i v_b0 = _mm_loadu_si128((const __m128i *)(src1 + j));
+            __m128i v_b1 = _mm_loadu_si128((const __m128i *)(src1 + j + 16));
+            _mm_storeu_si128((__m128i *)(dst + j), compare_u8<op>(v_a0, v_b0));
+            _mm_storeu_si128((__m128i *)(dst + j + 16), compare_u8<op>(v_a1, v_b1));
+        }
+        for (; j <= length - 16; j += 16) {
+            __m128i v_a = _mm_loadu_si128((const __m128i *)(src0 + j));
+            __m128i v_b = _mm_loadu_si128((const __m128i *)(src1 + j));
+            _mm_storeu_si128((__m128i *)(dst + j), compare_u8<op>(v_a, v_b));
+        }
+        for (; j < length; j++) {
+            dst[j] = compare_scalar<op>(src0[j], src1[j]);
+        }
+    }
+}
+
+template <int32_t op>
+static void compare_kernel(
+    int32_t height,
+    int32_t length,
+    int32_t inWidthStride0,
+    const float *inData0,
+    int32_t inWidthStride1,
+    const float *inData1,
+    int32_t outWidthStride,
+    uint8_t *outData)
+{
+    for (int32_t i = 0; i < height; i++) {
+        const float *src0 = inData0 + i * inWidthStride0;
+        const float *src1 = inData1 + i * inWidthStride1;
+        uint8_t *dst      = outData + i * outWidthStride;
+        int32_t j         = 0;
+        for (; j <= length - 16; j += 16) {
+            __m128i v_m0 = _mm_castps_si128(compare_f32<op>(_mm_loadu_ps(src0 + j), _mm_loadu_ps(src1 + j)));
+            __m128i v_m1 = _mm_castps_si128(compare_f32<op>(_mm_loadu_ps(src0 + j + 4), _mm_loadu_ps(src1 + j + 4)));
+            __m128i v_m2 = _mm_castps_si128(compare_f32<op>(_mm_loadu_ps(src0 + j + 8), _mm_loadu_ps(src1 + j + 8)));
+            __m128i v_m3 = _mm_castps_si128(compare_f32<op>(_mm_loadu_ps(src0 + j + 12), _mm_loadu_ps(src1 + j + 12)));
+            __m128i v_mask = _mm_packs_epi16(_mm_packs_epi32(v_m0, v_m1), _mm_packs_epi32(v_m2, v_m3));
+            _mm_storeu_si128((__m128i *)(dst + j), v_mask);
+        }
+        for (; j < length; j++) {
+            dst[j] = compare_scalar<op>(src0[j], src1[j]);
+        }
+    }
+}
+
+template <typename T, int32_t nc>
+::ppl::common::RetCode Compare(
+    int32_t height,
+    int32_t width,
+    int32_t inWidthStride0,
+    const T *inData0,
+    int32_t inWidthStride1,
+    const T *inData1,
+    int32_t outWidthStride,
+    uint8_t *outData,
+    CmpTypes cmpOp)
+{
+    if (nullptr == inData0 || nullptr == inData1 || nullptr == outData) {
+        return ppl::common::RC_INVALID_VALUE;
+    }
+    if (height <= 0 || width <= 0 || inWidthStride0 < width * nc || inWidthStride1 < width * nc ||
+        outWidthStride < width * nc) {
+        return ppl::common::RC_INVALID_VALUE;
+    }
+    // the rows are compared as flat arrays of width * nc elements.
+    int32_t length = width * nc;
+    switch (cmpOp) {
+        case ppl::cv::CMP_EQ:
+            compare_kernel<ppl::cv::CMP_EQ>(height, length, inWidthStride0, inData0, inWidthStride1, inData1, outWidthStride, outData);
+            break;
+        case ppl::cv::CMP_NE:
+            compare_kernel<ppl::cv::CMP_NE>(height, length, inWidthStride0, inData0, inWidthStride1, inData1, outWidthStride, outData);
+            break;
+        case ppl::cv::CMP_GT:
+            compare_kernel<ppl::cv::CMP_GT>(height, length, inWidthStride0, inData0, inWidthStride1, inData1, outWidthStride, outData);
+            break;
+        case ppl::cv::CMP_GE:
+            compare_kernel<ppl::cv::CMP_GE>(height, length, inWidthStride0, inData0, inWidthStride1, inData1, outWidthStride, outData);
+            break;
+        case ppl::cv::CMP_LT:
+            compare_kernel<ppl::cv::CMP_GT>(height, length, inWidthStride1, inData1, inWidthStride0, inData0, outWidthStride, outData);
+            break;
+        case ppl::cv::CMP_LE:
+            compare_kernel<ppl::cv::CMP_GE>(height, length, inWidthStride1, inData1, inWidthStride0, inData0, outWidthStride, outData);
+            break;
+        default:
+            return ppl::common::RC_INVALID_VALUE;
+    }
+    return ppl::common::RC_SUCCESS;
+}
+
+template ::ppl::common::RetCode Compare<float, 1>(int32_t height, int32_t width, int32_t inWidthStride0, const float *inData0, int32_t inWidthStride1, const float *inData1, int32_t outWidthStride, uint8_t *outData, CmpTypes cmpOp);
+template ::ppl::common::RetCode Compare<float, 3>(int32_t height, int32_t width, int32_t inWidthStride0, const float *inData0, int32_t inWidthStride1, const float *inData1, int32_t outWidthStride, uint8_t *outData, CmpTypes cmpOp);
+template ::ppl::common::RetCode Compare<float, 4>(int32_t height, int32_t width, int32_t inWidthStride0, const float *inData0, int32_t inWidthStride1, const float *inData1, int32_t outWidthStride, uint8_t *outData, CmpTypes cmpOp);
+template ::ppl::common::RetCode Compare<uint8_t, 1>(int32_t height, int32_t width, int32_t inWidthStride0, const uint8_t *inData0, int32_t inWidthStride1, const uint8_t *inData1, int32_t outWidthStride, uint8_t *outData, CmpTypes cmpOp);
+template ::ppl::common::RetCode Compare<uint8_t, 3>(int32_t height, int32_t width, int32_t inWidthStride0, const uint8_t *inData0, int32_t inWidthStride1, const uint8_t *inData1, int32_t outWidthStride, uint8_t *outData, CmpTypes cmpOp);
+template ::ppl::common::RetCode Compare<uint8_t, 4>(int32_t height, int32_t width, int32_t inWidthStride0, const uint8_t *inData0, int32_t inWidthStride1, const uint8_t *inData1, int32_t outWidthStride, uint8_t *outData, CmpTypes cmpOp);
+
+}
+}
+} // namespace ppl::cv::x86
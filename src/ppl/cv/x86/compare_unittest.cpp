@@ -0,0 +1,71 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "ppl/cv/x86/compare.h"
+#include "ppl/cv/x86/test.h"
+#include "ppl/cv/types.h"
+#include <memory>
+#include <gtest/gtest.h>
+#include "ppl/cv/debug.h"
+
+template<typename T, int32_t nc>
+void CompareTest(int32_t height, int32_t width) {
+    std::unique_ptr<T[]> src0(new T[width * height * nc]);
+    std::unique_ptr<T[]> src1(new T[width * height * nc]);
+    std::unique_ptr<uint8_t[]> dst(new uint8_t[width * height * nc]);
+    std::unique_ptr<uint8_t[]> dst_ref(new uint8_t[width * height * nc]);
+    ppl::cv::debug::randomFill<T>(src0.get(), width * height * nc, 0, 255);
+    ppl::cv::debug::randomFill<T>(src1.get(), width * height * nc, 0, 255);
+    // make some of the elements equal.
+    for (int32_t i = 0; i < width * height * nc; i += 5) {
+        src1[i] = src0[i];
+    }
+    cv::Mat src0Mat(height, width, CV_MAKETYPE(cv::DataType<T>::depth, nc), src0.get());
+    cv::Mat src1Mat(height, width, CV_MAKETYPE(cv::DataType<T>::depth, nc), src1.get());
+    cv::Mat dstMat(height, width, CV_MAKETYPE(CV_8U, nc), dst_ref.get());
+
+    const ppl::cv::CmpTypes ops[] = {ppl::cv::CMP_EQ, ppl::cv::CMP_GT, ppl::cv::CMP_GE,
+                                     ppl::cv::CMP_LT, ppl::cv::CMP_LE, ppl::cv::CMP_NE};
+    for (ppl::cv::CmpTypes op : ops) {
+        ppl::cv::x86::Compare<T, nc>(height, width, width * nc, src0.get(), width * nc, src1.get(),
+                                     width * nc, dst.get(), op);
+        cv::compare(src0Mat, src1Mat, dstMat, op);
+        checkResult<uint8_t, nc>(dst.get(), dst_ref.get(), height, width, width * nc, width * nc, 1e-3);
+    }
+}
+
+TEST(CompareUint8, x86)
+{
+    CompareTest<uint8_t, 1>(480, 640);
+    CompareTest<uint8_t, 3>(480, 640);
+    CompareTest<uint8_t, 4>(480, 640);
+
+    CompareTest<uint8_t, 1>(31, 67);
+    CompareTest<uint8_t, 3>(31, 67);
+    CompareTest<uint8_t, 4>(31, 67);
+}
+
+TEST(CompareFloat, x86)
+{
+    CompareTest<float, 1>(480, 640);
+    CompareTest<float, 3>(480, 640);
+    CompareTest<float, 4>(480, 640);
+
+    CompareTest<float, 1>(31, 67);
+    CompareTest<float, 3>(31, 67);
+    CompareTest<float, 4>(31, 67);
+}
@@ -47,6 +47,8 @@ void CopymakeborderTest(int32_t height, int32_t width, int32_t padding, float di
         cv_border_type = cv::BORDER_REFLECT;
     } else if (border_type == ppl::cv::BORDER_REFLECT101) {
         cv_border_type = cv::BORDER_REFLECT101;
+    } else if (border_type == ppl::cv::BORDER_WRAP) {
+        cv_border_type = cv::BORDER_WRAP;
     }
     ppl::cv::x86::CopyMakeBorder<T, nc>(input_height, input_width, input_width * nc, src.get(), output_height, 
                                           output_width, output_width * nc, dst.get(), border_type);
@@ -64,6 +66,8 @@ void CopymakeborderTest(int32_t height, int32_t width, int32_t padding, float di
         CopymakeborderTest<dtype, nc, border_type>(241, 321, 2, diff); \
         CopymakeborderTest<dtype, nc, border_type>(480, 640, 3, diff); \
         CopymakeborderTest<dtype, nc, border_type>(720, 1280, 4, diff); \
+        CopymakeborderTest<dtype, nc, border_type>(31, 37, 17, diff); \
+        CopymakeborderTest<dtype, nc, border_type>(5, 7, 16, diff); \
     } \
 
 R(copymakeborder_u8c1_constant_x86, uint8_t, 1, ppl::cv::BORDER_CONSTANT, 1.01f);
@@ -78,6 +82,9 @@ R(copymakeborder_u8c4_reflect_x86, uint8_t, 4, ppl::cv::BORDER_REFLECT, 1.01f);
 R(copymakeborder_u8c1_reflect101_x86, uint8_t, 1, ppl::cv::BORDER_REFLECT_101, 1.01f);
 R(copymakeborder_u8c3_reflect101_x86, uint8_t, 3, ppl::cv::BORDER_REFLECT_101, 1.01f);
 R(copymakeborder_u8c4_reflect101_x86, uint8_t, 4, ppl::cv::BORDER_REFLECT_101, 1.01f);
+R(copymakeborder_u8c1_wrap_x86, uint8_t, 1, ppl::cv::BORDER_WRAP, 1.01f);
+R(copymakeborder_u8c3_wrap_x86, uint8_t, 3, ppl::cv::BORDER_WRAP, 1.01f);
+R(copymakeborder_u8c4_wrap_x86, uint8_t, 4, ppl::cv::BORDER_WRAP, 1.01f);
 
 R(copymakeborder_fp32c1_constant_x86, float, 1, ppl::cv::BORDER_CONSTANT, 1.01f);
 R(copymakeborder_fp32c3_constant_x86, float, 3, ppl::cv::BORDER_CONSTANT, 1.01f);
@@ -91,4 +98,7 @@ R(copymakeborder_fp32c4_reflect_x86, float, 4, ppl::cv::BORDER_REFLECT, 1.01f);
 R(copymakeborder_fp32c1_reflect101_x86, float, 1, ppl::cv::BORDER_REFLECT_101, 1.01f);
 R(copymakeborder_fp32c3_reflect101_x86, float, 3, ppl::cv::BORDER_REFLECT_101, 1.01f);
 R(copymakeborder_fp32c4_reflect101_x86, float, 4, ppl::cv::BORDER_REFLECT_101, 1.01f);
+R(copymakeborder_fp32c1_wrap_x86, float, 1, ppl::cv::BORDER_WRAP, 1.01f);
+R(copymakeborder_fp32c3_wrap_x86, float, 3, ppl::cv::BORDER_WRAP, 1.01f);
+R(copymakeborder_fp32c4_wrap_x86, float, 4, ppl::cv::BORDER_WRAP, 1.01f);
 
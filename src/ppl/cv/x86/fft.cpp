@@ -0,0 +1,289 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "ppl/cv/x86/fft.hpp"
+
+#include <string.h>
+#include <cmath>
+
+namespace ppl {
+namespace cv {
+namespace x86 {
+
+#define FFT_PI 3.14159265358979323846
+
+static inline void complexMultiply(__m128& re, __m128& im, __m128 w_re,
+                                   __m128 w_im) {
+    __m128 value = _mm_sub_ps(_mm_mul_ps(re, w_re), _mm_mul_ps(im, w_im));
+    im = _mm_add_ps(_mm_mul_ps(re, w_im), _mm_mul_ps(im, w_re));
+    re = value;
+}
+
+template <int32_t P>
+struct Butterfly;
+
+template <>
+struct Butterfly<2> {
+    static inline void apply(__m128* re, __m128* im) {
+        __m128 t_re = _mm_sub_ps(re[0], re[1]);
+        __m128 t_im = _mm_sub_ps(im[0], im[1]);
+        re[0] = _mm_add_ps(re[0], re[1]);
+        im[0] = _mm_add_ps(im[0], im[1]);
+        re[1] = t_re;
+        im[1] = t_im;
+    }
+};
+
+template <>
+struct Butterfly<3> {
+    static inline void apply(__m128* re, __m128* im) {
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 sin60 = _mm_set1_ps(0.866025403784438647f);
+        __m128 sum_re  = _mm_add_ps(re[1], re[2]);
+        __m128 sum_im  = _mm_add_ps(im[1], im[2]);
+        __m128 diff_re = _mm_mul_ps(_mm_sub_ps(re[1], re[2]), sin60);
+        __m128 diff_im = _mm_mul_ps(_mm_sub_ps(im[1], im[2]), sin60);
+        __m128 mid_re  = _mm_sub_ps(re[0], _mm_mul_ps(sum_re, half));
+        __m128 mid_im  = _mm_sub_ps(im[0], _mm_mul_ps(sum_im, half));
+
+        // b1 = mid - i * diff, b2 = mid + i * diff.
+        re[0] = _mm_add_ps(re[0], sum_re);
+        im[0] = _mm_add_ps(im[0], sum_im);
+        re[1] = _mm_add_ps(mid_re, diff_im);
+        im[1] = _mm_sub_ps(mid_im, diff_re);
+        re[2] = _mm_sub_ps(mid_re, diff_im);
+        im[2] = _mm_add_ps(mid_im, diff_re);
+    }
+};
+
+template <>
+struct Butterfly<4> {
+    static inline void apply(__m128* re, __m128* im) {
+        __m128 t0_re = _mm_add_ps(re[0], re[2]);
+        __m128 t0_im = _mm_add_ps(im[0], im[2]);
+        __m128 t1_re = _mm_sub_ps(re[0], re[2]);
+        __m128 t1_im = _mm_sub_ps(im[0], im[2]);
+        __m128 t2_re = _mm_add_ps(re[1], re[3]);
+        __m128 t2_im = _mm_add_ps(im[1], im[3]);
+        // t3 = -i * (a1 - a3).
+        __m128 t3_re = _mm_sub_ps(im[1], im[3]);
+        __m128 t3_im = _mm_sub_ps(re[3], re[1]);
+
+        re[0] = _mm_add_ps(t0_re, t2_re);
+        im[0] = _mm_add_ps(t0_im, t2_im);
+        re[2] = _mm_sub_ps(t0_re, t2_re);
+        im[2] = _mm_sub_ps(t0_im, t2_im);
+        re[1] = _mm_add_ps(t1_re, t3_re);
+        im[1] = _mm_add_ps(t1_im, t3_im);
+        re[3] = _mm_sub_ps(t1_re, t3_re);
+        im[3] = _mm_sub_ps(t1_im, t3_im);
+    }
+};
+
+template <>
+struct Butterfly<5> {
+    static inline void apply(__m128* re, __m128* im) {
+        const __m128 cos72  = _mm_set1_ps(0.309016994374947424f);
+        const __m128 cos144 = _mm_set1_ps(-0.809016994374947424f);
+        const __m128 sin72  = _mm_set1_ps(0.951056516295153572f);
+        const __m128 sin144 = _mm_set1_ps(0.587785252292473129f);
+
+        __m128 t1_re = _mm_add_ps(re[1], re[4]);
+        __m128 t1_im = _mm_add_ps(im[1], im[4]);
+        __m128 t2_re = _mm_add_ps(re[2], re[3]);
+        __m128 t2_im = _mm_add_ps(im[2], im[3]);
+        __m128 t3_re = _mm_sub_ps(re[1], re[4]);
+        __m128 t3_im = _mm_sub_ps(im[1], im[4]);
+        __m128 t4_re = _mm_sub_ps(re[2], re[3]);
+        __m128 t4_im = _mm_sub_ps(im[2], im[3]);
+
+        __m128 r1_re = _mm_add_ps(re[0], _mm_add_ps(_mm_mul_ps(cos72, t1_re),
+                                                    _mm_mul_ps(cos144, t2_re)));
+        __m128 r1_im = _mm_add_ps(im[0], _mm_add_ps(_mm_mul_ps(cos72, t1_im),
+                                                    _mm_mul_ps(cos144, t2_im)));
+        __m128 r2_re = _mm_add_ps(re[0], _mm_add_ps(_mm_mul_ps(cos144, t1_re),
+                                                    _mm_mul_ps(cos72, t2_re)));
+        __m128 r2_im = _mm_add_ps(im[0], _mm_add_ps(_mm_mul_ps(cos144, t1_im),
+                                                    _mm_mul_ps(cos72, t2_im)));
+        __m128 i1_re = _mm_add_ps(_mm_mul_ps(sin72, t3_re),
+                                  _mm_mul_ps(sin144, t4_re));
+        __m128 i1_im = _mm_add_ps(_mm_mul_ps(sin72, t3_im),
+                                  _mm_mul_ps(sin144, t4_im));
+        __m128 i2_re = _mm_sub_ps(_mm_mul_ps(sin144, t3_re),
+                                  _mm_mul_ps(sin72, t4_re));
+        __m128 i2_im = _mm_sub_ps(_mm_mul_ps(sin144, t3_im),
+                                  _mm_mul_ps(sin72, t4_im));
+
+        re[0] = _mm_add_ps(re[0], _mm_add_ps(t1_re, t2_re));
+        im[0] = _mm_add_ps(im[0], _mm_add_ps(t1_im, t2_im));
+        // b1 = r1 - i * i1, b4 = r1 + i * i1, b2 = r2 - i * i2,
+        // b3 = r2 + i * i2.
+        re[1] = _mm_add_ps(r1_re, i1_im);
+        im[1] = _mm_sub_ps(r1_im, i1_re);
+        re[4] = _mm_sub_ps(r1_re, i1_im);
+        im[4] = _mm_add_ps(r1_im, i1_re);
+        re[2] = _mm_add_ps(r2_re, i2_im);
+        im[2] = _mm_sub_ps(r2_im, i2_re);
+        re[3] = _mm_sub_ps(r2_re, i2_im);
+        im[3] = _mm_add_ps(r2_im, i2_re);
+    }
+};
+
+/*
+ * One decimation in frequency Stockham pass. The sub-sequence length is n
+ * and the stride is s, the result of the radix P butterflies is scattered
+ * to y in sorted order and multiplied with the twiddle factors.
+ */
+template <int32_t P>
+static void stockhamPass(int32_t n, int32_t s, const __m128* x_re,
+                         const __m128* x_im, __m128* y_re, __m128* y_im,
+                         const float* twiddle_re, const float* twiddle_im) {
+    const int32_t m = n / P;
+    __m128 a_re[P], a_im[P];
+    __m128 w_re[P], w_im[P];
+    for (int32_t i = 0; i < m; i++) {
+        for (int32_t t = 1; t < P; t++) {
+            w_re[t] = _mm_set1_ps(twiddle_re[i * (P - 1) + t - 1]);
+            w_im[t] = _mm_set1_ps(twiddle_im[i * (P - 1) + t - 1]);
+        }
+        for (int32_t q = 0; q < s; q++) {
+            for (int32_t r = 0; r < P; r++) {
+                a_re[r] = x_re[q + s * (i + r * m)];
+                a_im[r] = x_im[q + s * (i + r * m)];
+            }
+            Butterfly<P>::apply(a_re, a_im);
+            y_re[q + s * P * i] = a_re[0];
+            y_im[q + s * P * i] = a_im[0];
+            for (int32_t t = 1; t < P; t++) {
+                if (i != 0) {
+                    complexMultiply(a_re[t], a_im[t], w_re[t], w_im[t]);
+                }
+                y_re[q + s * (P * i + t)] = a_re[t];
+                y_im[q + s * (P * i + t)] = a_im[t];
+            }
+        }
+    }
+}
+
+bool FFT4::isSmoothLength(int32_t length) {
+    if (length <= 0) {
+        return false;
+    }
+    while (length % 2 == 0) length /= 2;
+    while (length % 3 == 0) length /= 3;
+    while (length % 5 == 0) length /= 5;
+
+    return length == 1;
+}
+
+bool FFT4::init(int32_t length) {
+    if (!isSmoothLength(length)) {
+        return false;
+    }
+
+    length_ = length;
+    radices_.clear();
+    twiddle_offsets_.clear();
+    twiddle_re_.clear();
+    twiddle_im_.clear();
+
+    int32_t remain = length;
+    while (remain % 4 == 0) {
+        radices_.push_back(4);
+        remain /= 4;
+    }
+    while (remain % 2 == 0) {
+        radices_.push_back(2);
+        remain /= 2;
+    }
+    while (remain % 3 == 0) {
+        radices_.push_back(3);
+        remain /= 3;
+    }
+    while (remain % 5 == 0) {
+        radices_.push_back(5);
+        remain /= 5;
+    }
+
+    int32_t n = length;
+    for (size_t stage = 0; stage < radices_.size(); stage++) {
+        int32_t p = radices_[stage];
+        int32_t m = n / p;
+        twiddle_offsets_.push_back((int32_t)twiddle_re_.size());
+        for (int32_t i = 0; i < m; i++) {
+            for (int32_t t = 1; t < p; t++) {
+                double angle = -2.0 * FFT_PI * i * t / n;
+                twiddle_re_.push_back((float)cos(angle));
+                twiddle_im_.push_back((float)sin(angle));
+            }
+        }
+        n = m;
+    }
+
+    return true;
+}
+
+void FFT4::forward(__m128* re, __m128* im, __m128* work_re,
+                   __m128* work_im) const {
+    __m128* x_re = re;
+    __m128* x_im = im;
+    __m128* y_re = work_re;
+    __m128* y_im = work_im;
+    int32_t n = length_;
+    int32_t s = 1;
+    for (size_t stage = 0; stage < radices_.size(); stage++) {
+        int32_t p = radices_[stage];
+        const float* twiddle_re = twiddle_re_.data() + twiddle_offsets_[stage];
+        const float* twiddle_im = twiddle_im_.data() + twiddle_offsets_[stage];
+        switch (p) {
+            case 4:
+                stockhamPass<4>(n, s, x_re, x_im, y_re, y_im, twiddle_re,
+                                twiddle_im);
+                break;
+            case 2:
+                stockhamPass<2>(n, s, x_re, x_im, y_re, y_im, twiddle_re,
+                                twiddle_im);
+                break;
+            case 3:
+                stockhamPass<3>(n, s, x_re, x_im, y_re, y_im, twiddle_re,
+                                twiddle_im);
+                break;
+            default:
+                stockhamPass<5>(n, s, x_re, x_im, y_re, y_im, twiddle_re,
+                                twiddle_im);
+                break;
+        }
+        n /= p;
+        s *= p;
+
+        __m128* temp = x_re;
+        x_re = y_re;
+        y_re = temp;
+        temp = x_im;
+        x_im = y_im;
+        y_im = temp;
+    }
+
+    if (x_re != re) {
+        memcpy(re, x_re, length_ * sizeof(__m128));
+        memcpy(im, x_im, length_ * sizeof(__m128));
+    }
+}
+
+} //! namespace x86
+} //! namespace cv
+} //! namespace ppl
@@ -0,0 +1,68 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef __ST_HPC_PPL_CV_X86_FFT_HPP_
+#define __ST_HPC_PPL_CV_X86_FFT_HPP_
+
+#include <stdint.h>
+#include <vector>
+#include <immintrin.h>
+
+namespace ppl {
+namespace cv {
+namespace x86 {
+
+/**
+ * Mixed radix (2/3/4/5) complex FFT running 4 independent transforms at
+ * once, one per SSE lane. Data is kept in split format: re[i] and im[i]
+ * hold the i-th element of the 4 transforms. The transform is a Stockham
+ * autosort one, so no bit reversal pass is needed, but a work buffer of the
+ * same size as the data is required.
+ */
+class FFT4 {
+  public:
+    FFT4() : length_(0) {}
+    ~FFT4() {}
+
+    // returns false if length is not a product of 2, 3 and 5.
+    bool init(int32_t length);
+    int32_t length() const { return length_; }
+
+    // unnormalized forward transform, result is written back to re/im.
+    void forward(__m128* re, __m128* im, __m128* work_re,
+                 __m128* work_im) const;
+    // unnormalized inverse transform, result is written back to re/im.
+    void inverse(__m128* re, __m128* im, __m128* work_re,
+                 __m128* work_im) const {
+        forward(im, re, work_im, work_re);
+    }
+
+    static bool isSmoothLength(int32_t length);
+
+  private:
+    int32_t length_;
+    std::vector<int32_t> radices_;
+    std::vector<int32_t> twiddle_offsets_;
+    std::vector<float> twiddle_re_;
+    std::vector<float> twiddle_im_;
+};
+
+} //! namespace x86
+} //! namespace cv
+} //! namespace ppl
+
+#endif //! __ST_HPC_PPL_CV_X86_FFT_HPP_
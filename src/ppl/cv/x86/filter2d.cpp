@@ -20,6 +20,8 @@
 #include "ppl/cv/x86/copymakeborder.h"
 #include "ppl/cv/types.h"
 #include "ppl/cv/x86/util.hpp"
+#include "ppl/cv/x86/fft.hpp"
+#include "ppl/cv/x86/borderedrow.hpp"
 #include "ppl/common/sys.h"
 #include "ppl/common/x86/sysinfo.h"
 #include <string.h>
@@ -27,6 +29,7 @@
 #include <limits.h>
 #include <immintrin.h>
 #include <algorithm>
+#include <vector>
 
 namespace ppl {
 namespace cv {
@@ -149,6 +152,600 @@ void convolutionSerialBlocking_f(
     }
 }
 
+template <typename T>
+static inline __m128 loadFloat4(const T *src);
+
+template <>
+inline __m128 loadFloat4<float>(const float *src)
+{
+    return _mm_loadu_ps(src);
+}
+
+template <>
+inline __m128 loadFloat4<uint8_t>(const uint8_t *src)
+{
+    int32_t value;
+    memcpy(&value, src, sizeof(value));
+    return _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(value)));
+}
+
+template <typename T>
+static inline void storeFloat4(__m128 value, T *dst);
+
+template <>
+inline void storeFloat4<float>(__m128 value, float *dst)
+{
+    _mm_storeu_ps(dst, value);
+}
+
+template <>
+inline void storeFloat4<uint8_t>(__m128 value, uint8_t *dst)
+{
+    __m128i data  = _mm_cvtps_epi32(value);
+    data          = _mm_packus_epi16(_mm_packs_epi32(data, data), data);
+    int32_t bytes = _mm_cvtsi128_si32(data);
+    memcpy(dst, &bytes, sizeof(bytes));
+}
+
+/*
+ * Kernels no smaller than FFT_KERNEL_SIZE_THRESHOLD are convolved in the
+ * frequency domain. The output is split into tiles, every tile is computed
+ * with one 2D FFT of size fftHeight x fftWidth over the bordered source
+ * (overlap-save), so the cost per pixel grows with log(k) instead of k * k.
+ * Two real tiles are packed into the real and imaginary parts of one complex
+ * transform, the kernel being real keeps their results separated.
+ */
+#define FFT_KERNEL_SIZE_THRESHOLD 15
+#define FFT_KERNEL_SIZE_LIMIT 255
+#define FFT_MAX_LENGTH 1024
+#define FFT_MAX_TILE_AREA (512 * 512)
+
+static int32_t smoothLengthAbove(int32_t length)
+{
+    int32_t n = round_up(length, 4);
+    while (!FFT4::isSmoothLength(n)) {
+        n += 4;
+    }
+    return n;
+}
+
+static bool chooseFFTSize(
+    int32_t height,
+    int32_t width,
+    int32_t kernel_len,
+    int32_t *fftHeight,
+    int32_t *fftWidth)
+{
+    int32_t min_length   = round_up(kernel_len + 3, 4);
+    int32_t limit_height = std::min(smoothLengthAbove(std::max(height + kernel_len - 1, min_length)), FFT_MAX_LENGTH);
+    int32_t limit_width  = std::min(smoothLengthAbove(std::max(width + kernel_len - 1, min_length)), FFT_MAX_LENGTH);
+    double best_cost     = 0.0;
+    *fftHeight           = 0;
+    *fftWidth            = 0;
+    for (int32_t n = min_length; n <= limit_height; n += 4) {
+        if (!FFT4::isSmoothLength(n)) continue;
+        int32_t tilesY = (height + n - kernel_len) / (n - kernel_len + 1);
+        for (int32_t m = min_length; m <= limit_width && n * m <= FFT_MAX_TILE_AREA; m += 4) {
+            if (!FFT4::isSmoothLength(m)) continue;
+            int32_t tilesX = (width + m - kernel_len) / (m - kernel_len + 1);
+            // butterflies plus the gather/scatter passes of every tile.
+            double cost = (double)tilesY * tilesX * n * m * (std::log2((double)n) + std::log2((double)m) + 2.0);
+            if (*fftHeight == 0 || cost < best_cost) {
+                best_cost  = cost;
+                *fftHeight = n;
+                *fftWidth  = m;
+            }
+        }
+    }
+    return *fftHeight > 0;
+}
+
+struct FFTTile {
+    int32_t y;
+    int32_t x;
+    int32_t channel;
+};
+
+// gathers 4 adjacent columns of the window at (tile.y, tile.x), one per lane.
+template <typename T>
+static void gatherFFTColumns(
+    const T *bsrc,
+    int32_t bsrcHeight,
+    int32_t bsrcWidth,
+    int32_t bsrcWidthStep,
+    int32_t cn,
+    const FFTTile &tile,
+    int32_t column,
+    int32_t fftHeight,
+    __m128 *dst)
+{
+    int32_t x           = tile.x + column;
+    int32_t valid_lanes = std::max(0, std::min(4, bsrcWidth - x));
+    int32_t valid_rows  = std::max(0, std::min(fftHeight, bsrcHeight - tile.y));
+    float lanes[4]      = {0.f, 0.f, 0.f, 0.f};
+    const T *src        = bsrc + tile.y * bsrcWidthStep + x * cn + tile.channel;
+    if (cn == 1 && valid_lanes == 4) {
+        for (int32_t i = 0; i < valid_rows; i++) {
+            dst[i] = loadFloat4<T>(src);
+            src += bsrcWidthStep;
+        }
+    } else {
+        for (int32_t i = 0; i < valid_rows; i++) {
+            for (int32_t l = 0; l < valid_lanes; l++) {
+                lanes[l] = src[l * cn];
+            }
+            dst[i] = _mm_loadu_ps(lanes);
+            src += bsrcWidthStep;
+        }
+    }
+    for (int32_t i = valid_rows; i < fftHeight; i++) {
+        dst[i] = _mm_setzero_ps();
+    }
+}
+
+// column FFTs of the window, written transposed as fftWidth x fftHeight.
+static void transposeFFTColumns(
+    const __m128 *column_re,
+    const __m128 *column_im,
+    int32_t column,
+    int32_t fftHeight,
+    float *spectrum_re,
+    float *spectrum_im)
+{
+    for (int32_t i = 0; i < fftHeight; i += 4) {
+        __m128 r0 = column_re[i], r1 = column_re[i + 1];
+        __m128 r2 = column_re[i + 2], r3 = column_re[i + 3];
+        __m128 i0 = column_im[i], i1 = column_im[i + 1];
+        __m128 i2 = column_im[i + 2], i3 = column_im[i + 3];
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        _MM_TRANSPOSE4_PS(i0, i1, i2, i3);
+        float *dst_re = spectrum_re + column * fftHeight + i;
+        float *dst_im = spectrum_im + column * fftHeight + i;
+        _mm_store_ps(dst_re, r0);
+        _mm_store_ps(dst_re + fftHeight, r1);
+        _mm_store_ps(dst_re + 2 * fftHeight, r2);
+        _mm_store_ps(dst_re + 3 * fftHeight, r3);
+        _mm_store_ps(dst_im, i0);
+        _mm_store_ps(dst_im + fftHeight, i1);
+        _mm_store_ps(dst_im + 2 * fftHeight, i2);
+        _mm_store_ps(dst_im + 3 * fftHeight, i3);
+    }
+}
+
+static void untransposeFFTColumns(
+    const float *spectrum_re,
+    const float *spectrum_im,
+    int32_t column,
+    int32_t fftHeight,
+    __m128 *column_re,
+    __m128 *column_im)
+{
+    for (int32_t i = 0; i < fftHeight; i += 4) {
+        const float *src_re = spectrum_re + column * fftHeight + i;
+        const float *src_im = spectrum_im + column * fftHeight + i;
+        __m128 r0 = _mm_load_ps(src_re), r1 = _mm_load_ps(src_re + fftHeight);
+        __m128 r2 = _mm_load_ps(src_re + 2 * fftHeight), r3 = _mm_load_ps(src_re + 3 * fftHeight);
+        __m128 i0 = _mm_load_ps(src_im), i1 = _mm_load_ps(src_im + fftHeight);
+        __m128 i2 = _mm_load_ps(src_im + 2 * fftHeight), i3 = _mm_load_ps(src_im + 3 * fftHeight);
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        _MM_TRANSPOSE4_PS(i0, i1, i2, i3);
+        column_re[i]     = r0;
+        column_re[i + 1] = r1;
+        column_re[i + 2] = r2;
+        column_re[i + 3] = r3;
+        column_im[i]     = i0;
+        column_im[i + 1] = i1;
+        column_im[i + 2] = i2;
+        column_im[i + 3] = i3;
+    }
+}
+
+template <typename T>
+static void scatterFFTColumns(
+    const __m128 *column,
+    int32_t column_index,
+    int32_t fftHeight,
+    int32_t kernel_len,
+    const FFTTile &tile,
+    int32_t height,
+    int32_t width,
+    int32_t outWidthStride,
+    T *outData,
+    int32_t cn)
+{
+    int32_t rows = std::min(fftHeight - kernel_len + 1, height - tile.y);
+    int32_t x0   = tile.x + column_index - kernel_len + 1;
+    if (cn == 1 && column_index >= kernel_len - 1 && x0 + 4 <= width) {
+        T *dst = outData + tile.y * outWidthStride + x0;
+        for (int32_t i = 0; i < rows; i++) {
+            storeFloat4<T>(column[kernel_len - 1 + i], dst);
+            dst += outWidthStride;
+        }
+        return;
+    }
+    int32_t lane_begin = std::max(0, kernel_len - 1 - column_index);
+    int32_t lane_end   = std::min(4, width - x0);
+    T *dst             = outData + tile.y * outWidthStride + x0 * cn + tile.channel;
+    T lanes[4];
+    for (int32_t i = 0; i < rows; i++) {
+        storeFloat4<T>(column[kernel_len - 1 + i], lanes);
+        for (int32_t l = lane_begin; l < lane_end; l++) {
+            dst[l * cn] = lanes[l];
+        }
+        dst += outWidthStride;
+    }
+}
+
+template <typename T>
+static ::ppl::common::RetCode convolution_fft(
+    int32_t bsrcHeight,
+    int32_t bsrcWidth,
+    int32_t bsrcWidthStep,
+    const T *bsrc,
+    int32_t kernel_len,
+    const float *filter,
+    int32_t height,
+    int32_t width,
+    int32_t outWidthStride,
+    T *outData,
+    int32_t cn)
+{
+    int32_t fftHeight, fftWidth;
+    if (!chooseFFTSize(height, width, kernel_len, &fftHeight, &fftWidth)) {
+        return ppl::common::RC_UNSUPPORTED;
+    }
+    FFT4 fft_rows, fft_columns;
+    fft_rows.init(fftWidth);
+    fft_columns.init(fftHeight);
+
+    int32_t plane_size = fftHeight * fftWidth;
+    int32_t max_length = std::max(fftHeight, fftWidth);
+    size_t buffer_size = (size_t)plane_size * 4 * sizeof(float) + (size_t)max_length * 4 * sizeof(__m128);
+    float *buffer      = (float *)ppl::common::AlignedAlloc(buffer_size, 64);
+    if (buffer == nullptr) {
+        return ppl::common::RC_OUT_OF_MEMORY;
+    }
+    float *kernel_re   = buffer;
+    float *kernel_im   = kernel_re + plane_size;
+    float *spectrum_re = kernel_im + plane_size;
+    float *spectrum_im = spectrum_re + plane_size;
+    __m128 *line_re    = (__m128 *)(spectrum_im + plane_size);
+    __m128 *line_im    = line_re + max_length;
+    __m128 *work_re    = line_im + max_length;
+    __m128 *work_im    = work_re + max_length;
+
+    // spectrum of the flipped kernel, the 1 / (N * M) scaling is folded in.
+    float scale = 1.f / plane_size;
+    for (int32_t column = 0; column < fftWidth; column += 4) {
+        for (int32_t i = 0; i < fftHeight; i++) {
+            float lanes[4] = {0.f, 0.f, 0.f, 0.f};
+            for (int32_t l = 0; l < 4 && i < kernel_len; l++) {
+                if (column + l < kernel_len) {
+                    lanes[l] = filter[(kernel_len - 1 - i) * kernel_len + kernel_len - 1 - column - l] * scale;
+                }
+            }
+            line_re[i] = _mm_loadu_ps(lanes);
+            line_im[i] = _mm_setzero_ps();
+        }
+        fft_columns.forward(line_re, line_im, work_re, work_im);
+        transposeFFTColumns(line_re, line_im, column, fftHeight, kernel_re, kernel_im);
+    }
+    for (int32_t i = 0; i < fftHeight; i += 4) {
+        for (int32_t j = 0; j < fftWidth; j++) {
+            line_re[j] = _mm_load_ps(kernel_re + j * fftHeight + i);
+            line_im[j] = _mm_load_ps(kernel_im + j * fftHeight + i);
+        }
+        fft_rows.forward(line_re, line_im, work_re, work_im);
+        for (int32_t j = 0; j < fftWidth; j++) {
+            _mm_store_ps(kernel_re + j * fftHeight + i, line_re[j]);
+            _mm_store_ps(kernel_im + j * fftHeight + i, line_im[j]);
+        }
+    }
+
+    int32_t tileHeight = fftHeight - kernel_len + 1;
+    int32_t tileWidth  = fftWidth - kernel_len + 1;
+    int32_t tilesY     = (height + tileHeight - 1) / tileHeight;
+    int32_t tilesX     = (width + tileWidth - 1) / tileWidth;
+    int32_t jobs       = tilesY * tilesX * cn;
+    for (int32_t job = 0; job < jobs; job += 2) {
+        FFTTile tiles[2];
+        int32_t count = std::min(2, jobs - job);
+        for (int32_t t = 0; t < count; t++) {
+            int32_t tile     = (job + t) / cn;
+            tiles[t].y       = tile / tilesX * tileHeight;
+            tiles[t].x       = tile % tilesX * tileWidth;
+            tiles[t].channel = (job + t) % cn;
+        }
+
+        for (int32_t column = 0; column < fftWidth; column += 4) {
+            gatherFFTColumns<T>(bsrc, bsrcHeight, bsrcWidth, bsrcWidthStep, cn, tiles[0], column, fftHeight, line_re);
+            if (count > 1) {
+                gatherFFTColumns<T>(bsrc, bsrcHeight, bsrcWidth, bsrcWidthStep, cn, tiles[1], column, fftHeight, line_im);
+            } else {
+                memset(line_im, 0, fftHeight * sizeof(__m128));
+            }
+            fft_columns.forward(line_re, line_im, work_re, work_im);
+            transposeFFTColumns(line_re, line_im, column, fftHeight, spectrum_re, spectrum_im);
+        }
+
+        for (int32_t i = 0; i < fftHeight; i += 4) {
+            for (int32_t j = 0; j < fftWidth; j++) {
+                line_re[j] = _mm_load_ps(spectrum_re + j * fftHeight + i);
+                line_im[j] = _mm_load_ps(spectrum_im + j * fftHeight + i);
+            }
+            fft_rows.forward(line_re, line_im, work_re, work_im);
+            for (int32_t j = 0; j < fftWidth; j++) {
+                __m128 k_re = _mm_load_ps(kernel_re + j * fftHeight + i);
+                __m128 k_im = _mm_load_ps(kernel_im + j * fftHeight + i);
+                __m128 s_re = line_re[j];
+                __m128 s_im = line_im[j];
+                line_re[j]  = _mm_sub_ps(_mm_mul_ps(s_re, k_re), _mm_mul_ps(s_im, k_im));
+                line_im[j]  = _mm_add_ps(_mm_mul_ps(s_re, k_im), _mm_mul_ps(s_im, k_re));
+            }
+            fft_rows.inverse(line_re, line_im, work_re, work_im);
+            for (int32_t j = 0; j < fftWidth; j++) {
+                _mm_store_ps(spectrum_re + j * fftHeight + i, line_re[j]);
+                _mm_store_ps(spectrum_im + j * fftHeight + i, line_im[j]);
+            }
+        }
+
+        // the first kernel_len - 1 rows and columns are wrapped around.
+        for (int32_t column = (kernel_len - 1) & ~3; column < fftWidth; column += 4) {
+            untransposeFFTColumns(spectrum_re, spectrum_im, column, fftHeight, line_re, line_im);
+            fft_columns.inverse(line_re, line_im, work_re, work_im);
+            scatterFFTColumns<T>(line_re, column, fftHeight, kernel_len, tiles[0], height, width, outWidthStride, outData, cn);
+            if (count > 1) {
+                scatterFFTColumns<T>(line_im, column, fftHeight, kernel_len, tiles[1], height, width, outWidthStride, outData, cn);
+            }
+        }
+    }
+
+    ppl::common::AlignedFree(buffer);
+    return ppl::common::RC_SUCCESS;
+}
+
+/*
+ * Kernels which are separable, or close to a sum of two separable ones,
+ * are factorized with a one-sided Jacobi SVD and convolved with a row pass
+ * followed by a column pass per rank, 2 * k instead of k * k operations per
+ * pixel. A factorization is accepted when the relative Frobenius norm of
+ * the dropped singular values is within the tolerance given by the caller.
+ */
+#define LOWRANK_KERNEL_SIZE_THRESHOLD 9
+#define LOWRANK_KERNEL_SIZE_LIMIT 31
+#define LOWRANK_MAX_RANK 2
+#define LOWRANK_MAX_TAPS 32
+#define JACOBI_MAX_SWEEPS 30
+
+struct LowRankKernel {
+    int32_t rank;
+    std::vector<float> vertical;   // rank x kernel_len
+    std::vector<float> horizontal; // rank x kernel_len
+};
+
+static bool decomposeKernel(
+    const float *kernel,
+    int32_t kernel_len,
+    float tolerance,
+    LowRankKernel *lowrank)
+{
+    if (tolerance <= 0.f || kernel_len < LOWRANK_KERNEL_SIZE_THRESHOLD || kernel_len > LOWRANK_KERNEL_SIZE_LIMIT) {
+        return false;
+    }
+
+    // kernel = a * v^T, the columns of a become orthogonal and carry the
+    // singular values, v accumulates the rotations.
+    int32_t n = kernel_len;
+    std::vector<double> a(n * n), v(n * n, 0.0);
+    double total = 0.0;
+    for (int32_t i = 0; i < n * n; i++) {
+        a[i] = kernel[i];
+        total += a[i] * a[i];
+    }
+    if (total == 0.0) {
+        return false;
+    }
+    for (int32_t i = 0; i < n; i++) {
+        v[i * n + i] = 1.0;
+    }
+
+    for (int32_t sweep = 0; sweep < JACOBI_MAX_SWEEPS; sweep++) {
+        bool rotated = false;
+        for (int32_t p = 0; p < n - 1; p++) {
+            for (int32_t q = p + 1; q < n; q++) {
+                double alpha = 0.0, beta = 0.0, gamma = 0.0;
+                for (int32_t i = 0; i < n; i++) {
+                    alpha += a[i * n + p] * a[i * n + p];
+                    beta += a[i * n + q] * a[i * n + q];
+                    gamma += a[i * n + p] * a[i * n + q];
+                }
+                if (std::fabs(gamma) <= 1e-15 * std::sqrt(alpha * beta) || std::fabs(gamma) <= 1e-300) {
+                    continue;
+                }
+                rotated      = true;
+                double zeta  = (beta - alpha) / (2.0 * gamma);
+                double t     = (zeta >= 0.0 ? 1.0 : -1.0) / (std::fabs(zeta) + std::sqrt(1.0 + zeta * zeta));
+                double c     = 1.0 / std::sqrt(1.0 + t * t);
+                double s     = c * t;
+                for (int32_t i = 0; i < n; i++) {
+                    double ap    = a[i * n + p];
+                    double aq    = a[i * n + q];
+                    a[i * n + p] = c * ap - s * aq;
+                    a[i * n + q] = s * ap + c * aq;
+                    double vp    = v[i * n + p];
+                    double vq    = v[i * n + q];
+                    v[i * n + p] = c * vp - s * vq;
+                    v[i * n + q] = s * vp + c * vq;
+                }
+            }
+        }
+        if (!rotated) break;
+    }
+
+    // picks the columns with the largest singular values.
+    int32_t order[LOWRANK_MAX_RANK] = {-1, -1};
+    double energy[LOWRANK_MAX_RANK] = {0.0, 0.0};
+    for (int32_t j = 0; j < n; j++) {
+        double norm = 0.0;
+        for (int32_t i = 0; i < n; i++) {
+            norm += a[i * n + j] * a[i * n + j];
+        }
+        if (order[0] < 0 || norm > energy[0]) {
+            order[1]  = order[0];
+            energy[1] = energy[0];
+            order[0]  = j;
+            energy[0] = norm;
+        } else if (order[1] < 0 || norm > energy[1]) {
+            order[1]  = j;
+            energy[1] = norm;
+        }
+    }
+
+    double bound    = (double)tolerance * tolerance * total;
+    double residual = total - energy[0];
+    int32_t rank    = 1;
+    if (residual > bound) {
+        residual -= energy[1];
+        rank = 2;
+        if (residual > bound) {
+            return false;
+        }
+    }
+    // beyond this the FFT path is faster than several separable passes.
+    if (rank * kernel_len > LOWRANK_MAX_TAPS) {
+        return false;
+    }
+
+    lowrank->rank = rank;
+    lowrank->vertical.resize(rank * n);
+    lowrank->horizontal.resize(rank * n);
+    for (int32_t r = 0; r < rank; r++) {
+        for (int32_t i = 0; i < n; i++) {
+            lowrank->vertical[r * n + i]   = (float)a[i * n + order[r]];
+            lowrank->horizontal[r * n + i] = (float)v[i * n + order[r]];
+        }
+    }
+    return true;
+}
+
+template <typename T>
+static void rowFilterLowRank(
+    const T *src,
+    int32_t length,
+    int32_t cn,
+    const float *coeffs,
+    int32_t kernel_len,
+    float *dst)
+{
+    int32_t x = 0;
+    for (; x <= length - 8; x += 8) {
+        __m128 sum0 = _mm_setzero_ps();
+        __m128 sum1 = _mm_setzero_ps();
+        for (int32_t k = 0; k < kernel_len; k++) {
+            __m128 coeff = _mm_set1_ps(coeffs[k]);
+            sum0         = _mm_add_ps(sum0, _mm_mul_ps(coeff, loadFloat4<T>(src + x + k * cn)));
+            sum1         = _mm_add_ps(sum1, _mm_mul_ps(coeff, loadFloat4<T>(src + x + k * cn + 4)));
+        }
+        _mm_storeu_ps(dst + x, sum0);
+        _mm_storeu_ps(dst + x + 4, sum1);
+    }
+    for (; x < length; x++) {
+        float sum = 0.f;
+        for (int32_t k = 0; k < kernel_len; k++) {
+            sum += coeffs[k] * src[x + k * cn];
+        }
+        dst[x] = sum;
+    }
+}
+
+template <typename T>
+static void columnFilterLowRank(
+    const float *const *rows,
+    int32_t count,
+    int32_t length,
+    const float *coeffs,
+    T *dst)
+{
+    int32_t x = 0;
+    for (; x <= length - 8; x += 8) {
+        __m128 sum0 = _mm_setzero_ps();
+        __m128 sum1 = _mm_setzero_ps();
+        for (int32_t k = 0; k < count; k++) {
+            __m128 coeff = _mm_set1_ps(coeffs[k]);
+            sum0         = _mm_add_ps(sum0, _mm_mul_ps(coeff, _mm_loadu_ps(rows[k] + x)));
+            sum1         = _mm_add_ps(sum1, _mm_mul_ps(coeff, _mm_loadu_ps(rows[k] + x + 4)));
+        }
+        storeFloat4<T>(sum0, dst + x);
+        storeFloat4<T>(sum1, dst + x + 4);
+    }
+    for (; x < length; x++) {
+        __m128 sum = _mm_setzero_ps();
+        for (int32_t k = 0; k < count; k++) {
+            sum = _mm_add_ss(sum, _mm_mul_ss(_mm_set_ss(coeffs[k]), _mm_load_ss(rows[k] + x)));
+        }
+        T value[4];
+        storeFloat4<T>(sum, value);
+        dst[x] = value[0];
+    }
+}
+
+template <typename T, int32_t cn>
+static ::ppl::common::RetCode convolution_lowrank(
+    int32_t height,
+    int32_t width,
+    int32_t inWidthStride,
+    const T *inData,
+    int32_t kernel_len,
+    const LowRankKernel &lowrank,
+    int32_t outWidthStride,
+    T *outData,
+    BorderType border_type)
+{
+    // the padded source rows are only needed once by the row pass, so they
+    // are built one at a time instead of padding the whole image.
+    int32_t radius = kernel_len / 2;
+    BorderedRowProvider<T, cn> provider(height, width, inWidthStride, inData, radius, radius, border_type, 0, 1);
+    // keeps the last kernel_len rows of the row pass of every rank in a ring.
+    int32_t rank       = lowrank.rank;
+    int32_t length     = width * cn;
+    int32_t rowStride  = round_up(length, 16);
+    float *ring        = (float *)ppl::common::AlignedAlloc((size_t)rank * kernel_len * rowStride * sizeof(float), 64);
+    if (ring == nullptr || !provider.valid()) {
+        if (ring != nullptr) {
+            ppl::common::AlignedFree(ring);
+        }
+        return ppl::common::RC_OUT_OF_MEMORY;
+    }
+    std::vector<const float *> rows(rank * kernel_len);
+
+    for (int32_t i = 0; i < height + 2 * radius; i++) {
+        int32_t slot = i % kernel_len;
+        const T *src = provider.getRow(i - radius);
+        for (int32_t r = 0; r < rank; r++) {
+            if (ppl::common::CpuSupports(ppl::common::ISA_X86_FMA)) {
+                fma::rowFilterLowRank<T>(src, length, cn, lowrank.horizontal.data() + r * kernel_len, kernel_len, ring + (r * kernel_len + slot) * rowStride);
+            } else {
+                rowFilterLowRank<T>(src, length, cn, lowrank.horizontal.data() + r * kernel_len, kernel_len, ring + (r * kernel_len + slot) * rowStride);
+            }
+        }
+        int32_t y = i - kernel_len + 1;
+        if (y < 0 || y >= height) continue;
+        for (int32_t r = 0; r < rank; r++) {
+            for (int32_t k = 0; k < kernel_len; k++) {
+                rows[r * kernel_len + k] = ring + (r * kernel_len + (y + k) % kernel_len) * rowStride;
+            }
+        }
+        if (ppl::common::CpuSupports(ppl::common::ISA_X86_FMA)) {
+            fma::columnFilterLowRank<T>(rows.data(), rank * kernel_len, length, lowrank.vertical.data(), outData + y * outWidthStride);
+        } else {
+            columnFilterLowRank<T>(rows.data(), rank * kernel_len, length, lowrank.vertical.data(), outData + y * outWidthStride);
+        }
+    }
+
+    ppl::common::AlignedFree(ring);
+    return ppl::common::RC_SUCCESS;
+}
+
 template <>
 ::ppl::common::RetCode Filter2D<float, 1>(
     int32_t height,
@@ -159,7 +756,8 @@ template <>
     const float *filter,
     int32_t outWidthStride,
     float *outData,
-    BorderType border_type)
+    BorderType border_type,
+    float rank_tolerance)
 {
     if (nullptr == inData || nullptr == outData) {
         return ppl::common::RC_INVALID_VALUE;
@@ -175,8 +773,18 @@ template <>
     int32_t bsrcWidth  = width + 2 * radius;
     int32_t cn         = 1;
 
+    LowRankKernel lowrank;
+    if (decomposeKernel(filter, kernel_len, rank_tolerance, &lowrank)) {
+        return convolution_lowrank<float, 1>(height, width, inWidthStride, inData, kernel_len, lowrank, outWidthStride, outData, border_type);
+    }
     int32_t bsrcWidthStep = (bsrcWidth)*cn;
     float *bsrc           = (float *)malloc(bsrcHeight * bsrcWidth * cn * sizeof(float));
+    if (kernel_len >= FFT_KERNEL_SIZE_THRESHOLD && kernel_len <= FFT_KERNEL_SIZE_LIMIT) {
+        CopyMakeBorder<float, 1>(height, width, inWidthStride, inData, bsrcHeight, bsrcWidth, bsrcWidthStep, bsrc, border_type);
+        ::ppl::common::RetCode code = convolution_fft<float>(bsrcHeight, bsrcWidth, bsrcWidthStep, bsrc, kernel_len, filter, height, width, outWidthStride, outData, cn);
+        free(bsrc);
+        return code;
+    }
     if (ppl::common::CpuSupports(ppl::common::ISA_X86_FMA)) {
         if (kernel_len == 5)
             fma::convolution_f<5>(bsrcWidth, bsrcHeight, bsrcWidthStep, bsrc, filter, outWidthStride, outData, cn, inData, height, width, inWidthStride, border_type);
@@ -204,7 +812,8 @@ template <>
     const float *filter,
     int32_t outWidthStride,
     float *outData,
-    BorderType border_type)
+    BorderType border_type,
+    float rank_tolerance)
 {
     if (nullptr == inData || nullptr == outData) {
         return ppl::common::RC_INVALID_VALUE;
@@ -220,9 +829,19 @@ template <>
     int32_t bsrcWidth  = width + 2 * radius;
     int32_t cn         = 3;
 
+    LowRankKernel lowrank;
+    if (decomposeKernel(filter, kernel_len, rank_tolerance, &lowrank)) {
+        return convolution_lowrank<float, 3>(height, width, inWidthStride, inData, kernel_len, lowrank, outWidthStride, outData, border_type);
+    }
     int32_t bsrcWidthStep = (bsrcWidth)*cn;
     float *bsrc           = (float *)malloc(bsrcHeight * bsrcWidth * cn * sizeof(float));
 
+    if (kernel_len >= FFT_KERNEL_SIZE_THRESHOLD && kernel_len <= FFT_KERNEL_SIZE_LIMIT) {
+        CopyMakeBorder<float, 3>(height, width, inWidthStride, inData, bsrcHeight, bsrcWidth, bsrcWidthStep, bsrc, border_type);
+        ::ppl::common::RetCode code = convolution_fft<float>(bsrcHeight, bsrcWidth, bsrcWidthStep, bsrc, kernel_len, filter, height, width, outWidthStride, outData, cn);
+        free(bsrc);
+        return code;
+    }
     if (ppl::common::CpuSupports(ppl::common::ISA_X86_FMA)) {
         if (kernel_len == 5)
             fma::convolution_f<5>(bsrcWidth, bsrcHeight, bsrcWidthStep, bsrc, filter, outWidthStride, outData, cn, inData, height, width, inWidthStride, border_type);
@@ -250,7 +869,8 @@ template <>
     const float *filter,
     int32_t outWidthStride,
     float *outData,
-    BorderType border_type)
+    BorderType border_type,
+    float rank_tolerance)
 {
     if (nullptr == inData || nullptr == outData) {
         return ppl::common::RC_INVALID_VALUE;
@@ -266,9 +886,19 @@ template <>
     int32_t bsrcWidth  = width + 2 * radius;
     int32_t cn         = 4;
 
+    LowRankKernel lowrank;
+    if (decomposeKernel(filter, kernel_len, rank_tolerance, &lowrank)) {
+        return convolution_lowrank<float, 4>(height, width, inWidthStride, inData, kernel_len, lowrank, outWidthStride, outData, border_type);
+    }
     int32_t bsrcWidthStep = (bsrcWidth)*cn;
     float *bsrc           = (float *)malloc(bsrcHeight * bsrcWidth * cn * sizeof(float));
 
+    if (kernel_len >= FFT_KERNEL_SIZE_THRESHOLD && kernel_len <= FFT_KERNEL_SIZE_LIMIT) {
+        CopyMakeBorder<float, 4>(height, width, inWidthStride, inData, bsrcHeight, bsrcWidth, bsrcWidthStep, bsrc, border_type);
+        ::ppl::common::RetCode code = convolution_fft<float>(bsrcHeight, bsrcWidth, bsrcWidthStep, bsrc, kernel_len, filter, height, width, outWidthStride, outData, cn);
+        free(bsrc);
+        return code;
+    }
     if (ppl::common::CpuSupports(ppl::common::ISA_X86_FMA)) {
         if (kernel_len == 5)
             fma::convolution_f<5>(bsrcWidth, bsrcHeight, bsrcWidthStep, bsrc, filter, outWidthStride, outData, cn, inData, height, width, inWidthStride, border_type);
@@ -296,7 +926,8 @@ template <>
     const float *filter,
     int32_t outWidthStride,
     uint8_t *outData,
-    BorderType border_type)
+    BorderType border_type,
+    float rank_tolerance)
 {
     if (nullptr == inData || nullptr == outData) {
         return ppl::common::RC_INVALID_VALUE;
@@ -312,9 +943,19 @@ template <>
     int32_t bsrcWidth  = width + 2 * radius;
     int32_t cn         = 1;
 
+    LowRankKernel lowrank;
+    if (decomposeKernel(filter, kernel_len, rank_tolerance, &lowrank)) {
+        return convolution_lowrank<uint8_t, 1>(height, width, inWidthStride, inData, kernel_len, lowrank, outWidthStride, outData, border_type);
+    }
     int32_t bsrcWidthStep = (bsrcWidth)*cn;
     uint8_t *bsrc         = (uint8_t *)malloc(bsrcHeight * bsrcWidth * cn * sizeof(uint8_t));
 
+    if (kernel_len >= FFT_KERNEL_SIZE_THRESHOLD && kernel_len <= FFT_KERNEL_SIZE_LIMIT) {
+        CopyMakeBorder<uint8_t, 1>(height, width, inWidthStride, inData, bsrcHeight, bsrcWidth, bsrcWidthStep, bsrc, border_type);
+        ::ppl::common::RetCode code = convolution_fft<uint8_t>(bsrcHeight, bsrcWidth, bsrcWidthStep, bsrc, kernel_len, filter, height, width, outWidthStride, outData, cn);
+        free(bsrc);
+        return code;
+    }
     if (ppl::common::CpuSupports(ppl::common::ISA_X86_FMA)) {
         if (kernel_len == 5)
             fma::convolution_b<5>(bsrcWidth, bsrcHeight, bsrcWidthStep, bsrc, filter, outWidthStride, outData, cn, inData, height, width, inWidthStride, border_type);
@@ -341,7 +982,8 @@ template <>
     const float *filter,
     int32_t outWidthStride,
     uint8_t *outData,
-    BorderType border_type)
+    BorderType border_type,
+    float rank_tolerance)
 {
     if (nullptr == inData || nullptr == outData) {
         return ppl::common::RC_INVALID_VALUE;
@@ -356,9 +998,19 @@ template <>
     int32_t bsrcHeight    = height + 2 * radius;
     int32_t bsrcWidth     = width + 2 * radius;
     int32_t cn            = 3;
+    LowRankKernel lowrank;
+    if (decomposeKernel(filter, kernel_len, rank_tolerance, &lowrank)) {
+        return convolution_lowrank<uint8_t, 3>(height, width, inWidthStride, inData, kernel_len, lowrank, outWidthStride, outData, border_type);
+    }
     int32_t bsrcWidthStep = (bsrcWidth)*cn;
     uint8_t *bsrc         = (uint8_t *)malloc(bsrcHeight * bsrcWidth * cn * sizeof(uint8_t));
 
+    if (kernel_len >= FFT_KERNEL_SIZE_THRESHOLD && kernel_len <= FFT_KERNEL_SIZE_LIMIT) {
+        CopyMakeBorder<uint8_t, 3>(height, width, inWidthStride, inData, bsrcHeight, bsrcWidth, bsrcWidthStep, bsrc, border_type);
+        ::ppl::common::RetCode code = convolution_fft<uint8_t>(bsrcHeight, bsrcWidth, bsrcWidthStep, bsrc, kernel_len, filter, height, width, outWidthStride, outData, cn);
+        free(bsrc);
+        return code;
+    }
     if (ppl::common::CpuSupports(ppl::common::ISA_X86_FMA)) {
         if (kernel_len == 5)
             fma::convolution_b<5>(bsrcWidth, bsrcHeight, bsrcWidthStep, bsrc, filter, outWidthStride, outData, cn, inData, height, width, inWidthStride, border_type);
@@ -386,7 +1038,8 @@ template <>
     const float *filter,
     int32_t outWidthStride,
     uint8_t *outData,
-    BorderType border_type)
+    BorderType border_type,
+    float rank_tolerance)
 {
     if (nullptr == inData || nullptr == outData) {
         return ppl::common::RC_INVALID_VALUE;
@@ -402,9 +1055,19 @@ template <>
     int32_t bsrcWidth  = width + 2 * radius;
     int32_t cn         = 4;
 
+    LowRankKernel lowrank;
+    if (decomposeKernel(filter, kernel_len, rank_tolerance, &lowrank)) {
+        return convolution_lowrank<uint8_t, 4>(height, width, inWidthStride, inData, kernel_len, lowrank, outWidthStride, outData, border_type);
+    }
     int32_t bsrcWidthStep = (bsrcWidth)*cn;
     uint8_t *bsrc         = (uint8_t *)malloc(bsrcHeight * bsrcWidth * cn * sizeof(uint8_t));
 
+    if (kernel_len >= FFT_KERNEL_SIZE_THRESHOLD && kernel_len <= FFT_KERNEL_SIZE_LIMIT) {
+        CopyMakeBorder<uint8_t, 4>(height, width, inWidthStride, inData, bsrcHeight, bsrcWidth, bsrcWidthStep, bsrc, border_type);
+        ::ppl::common::RetCode code = convolution_fft<uint8_t>(bsrcHeight, bsrcWidth, bsrcWidthStep, bsrc, kernel_len, filter, height, width, outWidthStride, outData, cn);
+        free(bsrc);
+        return code;
+    }
     if (ppl::common::CpuSupports(ppl::common::ISA_X86_FMA)) {
         if (kernel_len == 5)
             fma::convolution_b<5>(bsrcWidth, bsrcHeight, bsrcWidthStep, bsrc, filter, outWidthStride, outData, cn, inData, height, width, inWidthStride, border_type);
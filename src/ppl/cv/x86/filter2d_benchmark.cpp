@@ -50,6 +50,9 @@ BENCHMARK_TEMPLATE(BM_Filter2D_ppl_x86, float, c4, k5x5)->Args({320, 240})->Args
 BENCHMARK_TEMPLATE(BM_Filter2D_ppl_x86, float, c1, k7x7)->Args({320, 240})->Args({640, 480})->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
 BENCHMARK_TEMPLATE(BM_Filter2D_ppl_x86, float, c3, k7x7)->Args({320, 240})->Args({640, 480})->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
 BENCHMARK_TEMPLATE(BM_Filter2D_ppl_x86, float, c4, k7x7)->Args({320, 240})->Args({640, 480})->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
+BENCHMARK_TEMPLATE(BM_Filter2D_ppl_x86, float, c1, 21)->Args({320, 240})->Args({640, 480})->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
+BENCHMARK_TEMPLATE(BM_Filter2D_ppl_x86, float, c3, 21)->Args({320, 240})->Args({640, 480})->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
+BENCHMARK_TEMPLATE(BM_Filter2D_ppl_x86, float, c4, 21)->Args({320, 240})->Args({640, 480})->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
 
 BENCHMARK_TEMPLATE(BM_Filter2D_ppl_x86, uint8_t, c1, k3x3)->Args({320, 240})->Args({640, 480})->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
 BENCHMARK_TEMPLATE(BM_Filter2D_ppl_x86, uint8_t, c3, k3x3)->Args({320, 240})->Args({640, 480})->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
@@ -60,6 +63,9 @@ BENCHMARK_TEMPLATE(BM_Filter2D_ppl_x86, uint8_t, c4, k5x5)->Args({320, 240})->Ar
 BENCHMARK_TEMPLATE(BM_Filter2D_ppl_x86, uint8_t, c1, k7x7)->Args({320, 240})->Args({640, 480})->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
 BENCHMARK_TEMPLATE(BM_Filter2D_ppl_x86, uint8_t, c3, k7x7)->Args({320, 240})->Args({640, 480})->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
 BENCHMARK_TEMPLATE(BM_Filter2D_ppl_x86, uint8_t, c4, k7x7)->Args({320, 240})->Args({640, 480})->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
+BENCHMARK_TEMPLATE(BM_Filter2D_ppl_x86, uint8_t, c1, 21)->Args({320, 240})->Args({640, 480})->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
+BENCHMARK_TEMPLATE(BM_Filter2D_ppl_x86, uint8_t, c3, 21)->Args({320, 240})->Args({640, 480})->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
+BENCHMARK_TEMPLATE(BM_Filter2D_ppl_x86, uint8_t, c4, 21)->Args({320, 240})->Args({640, 480})->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
 
 #ifdef PPLCV_BENCHMARK_OPENCV
 template<typename T, int32_t channels, int32_t filter_size>
@@ -93,6 +99,9 @@ BENCHMARK_TEMPLATE(BM_Filter2D_opencv_x86, float, c4, k5x5)->Args({320, 240})->A
 BENCHMARK_TEMPLATE(BM_Filter2D_opencv_x86, float, c1, k7x7)->Args({320, 240})->Args({640, 480})->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
 BENCHMARK_TEMPLATE(BM_Filter2D_opencv_x86, float, c3, k7x7)->Args({320, 240})->Args({640, 480})->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
 BENCHMARK_TEMPLATE(BM_Filter2D_opencv_x86, float, c4, k7x7)->Args({320, 240})->Args({640, 480})->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
+BENCHMARK_TEMPLATE(BM_Filter2D_opencv_x86, float, c1, 21)->Args({320, 240})->Args({640, 480})->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
+BENCHMARK_TEMPLATE(BM_Filter2D_opencv_x86, float, c3, 21)->Args({320, 240})->Args({640, 480})->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
+BENCHMARK_TEMPLATE(BM_Filter2D_opencv_x86, float, c4, 21)->Args({320, 240})->Args({640, 480})->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
 
 BENCHMARK_TEMPLATE(BM_Filter2D_opencv_x86, uint8_t, c1, k3x3)->Args({320, 240})->Args({640, 480})->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
 BENCHMARK_TEMPLATE(BM_Filter2D_opencv_x86, uint8_t, c3, k3x3)->Args({320, 240})->Args({640, 480})->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
@@ -103,5 +112,8 @@ BENCHMARK_TEMPLATE(BM_Filter2D_opencv_x86, uint8_t, c4, k5x5)->Args({320, 240})-
 BENCHMARK_TEMPLATE(BM_Filter2D_opencv_x86, uint8_t, c1, k7x7)->Args({320, 240})->Args({640, 480})->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
 BENCHMARK_TEMPLATE(BM_Filter2D_opencv_x86, uint8_t, c3, k7x7)->Args({320, 240})->Args({640, 480})->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
 BENCHMARK_TEMPLATE(BM_Filter2D_opencv_x86, uint8_t, c4, k7x7)->Args({320, 240})->Args({640, 480})->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
+BENCHMARK_TEMPLATE(BM_Filter2D_opencv_x86, uint8_t, c1, 21)->Args({320, 240})->Args({640, 480})->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
+BENCHMARK_TEMPLATE(BM_Filter2D_opencv_x86, uint8_t, c3, 21)->Args({320, 240})->Args({640, 480})->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
+BENCHMARK_TEMPLATE(BM_Filter2D_opencv_x86, uint8_t, c4, 21)->Args({320, 240})->Args({640, 480})->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
 #endif //! PPLCV_BENCHMARK_OPENCV
 }
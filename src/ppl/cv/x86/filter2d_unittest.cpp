@@ -18,6 +18,7 @@
 #include "ppl/cv/x86/filter2d.h"
 #include "ppl/cv/x86/test.h"
 #include <memory>
+#include <algorithm>
 #include <gtest/gtest.h>
 #include "ppl/cv/debug.h"
 
@@ -45,13 +46,163 @@ void Filter2DTest(int32_t height, int32_t width, T diff) {
                     diff);
 }
 
+template<typename T, int32_t nc, int32_t filter_size>
+void Filter2DSeparableTest(int32_t height, int32_t width, T diff) {
+    std::unique_ptr<T[]> src(new T[width * height * nc]);
+    std::unique_ptr<T[]> dst_ref(new T[width * height * nc]);
+    std::unique_ptr<T[]> dst(new T[width * height * nc]);
+    std::unique_ptr<float[]> filter(new float[filter_size * filter_size]);
+    std::unique_ptr<float[]> kernel_x(new float[filter_size]);
+    std::unique_ptr<float[]> kernel_y(new float[filter_size]);
+    ppl::cv::debug::randomFill<T>(src.get(), width * height * nc, 0, 255);
+    ppl::cv::debug::randomFill<float>(kernel_x.get(), filter_size, 0, 1.0 / filter_size);
+    ppl::cv::debug::randomFill<float>(kernel_y.get(), filter_size, 0, 1.0 / filter_size);
+    for (int32_t i = 0; i < filter_size; ++i) {
+        for (int32_t j = 0; j < filter_size; ++j) {
+            filter[i * filter_size + j] = kernel_y[i] * kernel_x[j];
+        }
+    }
+
+    cv::Mat src_opencv(height, width, CV_MAKETYPE(cv::DataType<T>::depth, nc), src.get(), sizeof(T) * width * nc);
+    cv::Mat dst_opencv(height, width, CV_MAKETYPE(cv::DataType<T>::depth, nc), dst_ref.get(), sizeof(T) * width * nc);
+    cv::Mat filter_opencv(filter_size, filter_size, CV_32FC1, filter.get());
+
+    cv::filter2D(src_opencv, dst_opencv, -1, filter_opencv,cv::Point(-1,-1),0,cv::BORDER_REFLECT101);
+    ppl::cv::x86::Filter2D<T, nc>(height, width, width * nc,
+                            src.get(), filter_size, filter.get(), width * nc,
+                            dst.get(), ppl::cv::BORDER_REFLECT101);
+
+    checkResult<T, nc>(dst_ref.get(), dst.get(),
+                    height, width,
+                    width * nc, width * nc,
+                    diff);
+}
+
+template<typename T, int32_t nc, int32_t filter_size>
+void Filter2DRank2Test(int32_t height, int32_t width, T diff) {
+    std::unique_ptr<T[]> src(new T[width * height * nc]);
+    std::unique_ptr<T[]> dst_ref(new T[width * height * nc]);
+    std::unique_ptr<T[]> dst(new T[width * height * nc]);
+    std::unique_ptr<float[]> filter(new float[filter_size * filter_size]);
+    std::unique_ptr<float[]> vectors(new float[filter_size * 4]);
+    ppl::cv::debug::randomFill<T>(src.get(), width * height * nc, 0, 255);
+    ppl::cv::debug::randomFill<float>(vectors.get(), filter_size * 4, -1.0 / filter_size, 1.0 / filter_size);
+    // the sum of 2 separable kernels, taken by the low rank path with 2 terms.
+    const float *kernel_y0 = vectors.get(), *kernel_x0 = kernel_y0 + filter_size;
+    const float *kernel_y1 = kernel_x0 + filter_size, *kernel_x1 = kernel_y1 + filter_size;
+    for (int32_t i = 0; i < filter_size; ++i) {
+        for (int32_t j = 0; j < filter_size; ++j) {
+            filter[i * filter_size + j] = kernel_y0[i] * kernel_x0[j] + kernel_y1[i] * kernel_x1[j];
+        }
+    }
+
+    cv::Mat src_opencv(height, width, CV_MAKETYPE(cv::DataType<T>::depth, nc), src.get(), sizeof(T) * width * nc);
+    cv::Mat dst_opencv(height, width, CV_MAKETYPE(cv::DataType<T>::depth, nc), dst_ref.get(), sizeof(T) * width * nc);
+    cv::Mat filter_opencv(filter_size, filter_size, CV_32FC1, filter.get());
+
+    cv::filter2D(src_opencv, dst_opencv, -1, filter_opencv,cv::Point(-1,-1),0,cv::BORDER_REFLECT101);
+    ppl::cv::x86::Filter2D<T, nc>(height, width, width * nc,
+                            src.get(), filter_size, filter.get(), width * nc,
+                            dst.get(), ppl::cv::BORDER_REFLECT101);
+
+    checkResult<T, nc>(dst_ref.get(), dst.get(),
+                    height, width,
+                    width * nc, width * nc,
+                    diff);
+}
+
+static float maxDifference(const float* data0, const float* data1, int32_t size) {
+    float max = 0.f;
+    for (int32_t i = 0; i < size; i++) {
+        max = std::max(max, std::fabs(data0[i] - data1[i]));
+    }
+    return max;
+}
+
+// a separable kernel with a full rank perturbation of 5e-3 of its norm.
+template<int32_t filter_size>
+void Filter2DToleranceTest(int32_t height, int32_t width) {
+    std::unique_ptr<float[]> src(new float[width * height]);
+    std::unique_ptr<float[]> dst_ref(new float[width * height]);
+    std::unique_ptr<float[]> dst_approx(new float[width * height]);
+    std::unique_ptr<float[]> dst(new float[width * height]);
+    std::unique_ptr<float[]> filter(new float[filter_size * filter_size]);
+    std::unique_ptr<float[]> noise(new float[filter_size * filter_size]);
+    std::unique_ptr<float[]> kernel_x(new float[filter_size]);
+    std::unique_ptr<float[]> kernel_y(new float[filter_size]);
+    ppl::cv::debug::randomFill<float>(src.get(), width * height, 0, 255);
+    ppl::cv::debug::randomFill<float>(kernel_x.get(), filter_size, 0, 1.0 / filter_size);
+    ppl::cv::debug::randomFill<float>(kernel_y.get(), filter_size, 0, 1.0 / filter_size);
+    ppl::cv::debug::randomFill<float>(noise.get(), filter_size * filter_size, -1, 1);
+    double kernel_norm = 0.0, noise_norm = 0.0;
+    for (int32_t i = 0; i < filter_size; ++i) {
+        for (int32_t j = 0; j < filter_size; ++j) {
+            filter[i * filter_size + j] = kernel_y[i] * kernel_x[j];
+            kernel_norm += filter[i * filter_size + j] * filter[i * filter_size + j];
+            noise_norm += noise[i * filter_size + j] * noise[i * filter_size + j];
+        }
+    }
+    float scale = 5e-3 * std::sqrt(kernel_norm / noise_norm);
+    for (int32_t i = 0; i < filter_size * filter_size; ++i) {
+        filter[i] += noise[i] * scale;
+    }
+
+    // the rank 1 approximation of the kernel taken with a loose tolerance.
+    cv::Mat filter_opencv(filter_size, filter_size, CV_32FC1, filter.get());
+    cv::Mat w, u, vt;
+    cv::SVD::compute(filter_opencv, w, u, vt);
+    cv::Mat approx_opencv = w.at<float>(0) * u.col(0) * vt.row(0);
+
+    cv::Mat src_opencv(height, width, CV_32FC1, src.get(), sizeof(float) * width);
+    cv::Mat dst_opencv(height, width, CV_32FC1, dst_ref.get(), sizeof(float) * width);
+    cv::Mat dst_approx_opencv(height, width, CV_32FC1, dst_approx.get(), sizeof(float) * width);
+    cv::filter2D(src_opencv, dst_opencv, -1, filter_opencv, cv::Point(-1, -1), 0, cv::BORDER_REFLECT101);
+    cv::filter2D(src_opencv, dst_approx_opencv, -1, approx_opencv, cv::Point(-1, -1), 0, cv::BORDER_REFLECT101);
+
+    int32_t size = width * height;
+    ppl::cv::x86::Filter2D<float, 1>(height, width, width, src.get(), filter_size, filter.get(), width, dst.get(),
+                                     ppl::cv::BORDER_REFLECT101, 1e-2f);
+    EXPECT_LT(maxDifference(dst_approx.get(), dst.get(), size), 1e-3f);
+    EXPECT_GT(maxDifference(dst_ref.get(), dst.get(), size), 5e-3f);
+
+    ppl::cv::x86::Filter2D<float, 1>(height, width, width, src.get(), filter_size, filter.get(), width, dst.get(),
+                                     ppl::cv::BORDER_REFLECT101);
+    EXPECT_LT(maxDifference(dst_ref.get(), dst.get(), size), 1e-3f);
+}
+
+// a zero or negative tolerance keeps even a separable kernel on the 2D path.
+template<int32_t filter_size>
+void Filter2DNoFactorizationTest(int32_t height, int32_t width) {
+    std::unique_ptr<float[]> src(new float[width * height]);
+    std::unique_ptr<float[]> dst0(new float[width * height]);
+    std::unique_ptr<float[]> dst1(new float[width * height]);
+    std::unique_ptr<float[]> filter(new float[filter_size * filter_size]);
+    std::unique_ptr<float[]> kernel_x(new float[filter_size]);
+    std::unique_ptr<float[]> kernel_y(new float[filter_size]);
+    ppl::cv::debug::randomFill<float>(src.get(), width * height, 0, 255);
+    ppl::cv::debug::randomFill<float>(kernel_x.get(), filter_size, 0, 1.0 / filter_size);
+    ppl::cv::debug::randomFill<float>(kernel_y.get(), filter_size, 0, 1.0 / filter_size);
+    for (int32_t i = 0; i < filter_size; ++i) {
+        for (int32_t j = 0; j < filter_size; ++j) {
+            filter[i * filter_size + j] = kernel_y[i] * kernel_x[j];
+        }
+    }
+
+    ppl::cv::x86::Filter2D<float, 1>(height, width, width, src.get(), filter_size, filter.get(), width, dst0.get(),
+                                     ppl::cv::BORDER_REFLECT101, 0.f);
+    ppl::cv::x86::Filter2D<float, 1>(height, width, width, src.get(), filter_size, filter.get(), width, dst1.get(),
+                                     ppl::cv::BORDER_REFLECT101, -1.f);
+    EXPECT_EQ(maxDifference(dst0.get(), dst1.get(), width * height), 0.f);
+}
 
 TEST(FILTER2D_FP32, x86)
 {
     Filter2DTest<float, 3, 3>(720, 1080, 2.0);
     Filter2DTest<float, 3, 5>(720, 1080, 2.0);
     Filter2DTest<float, 3, 7>(720, 1080, 2.0);
-
+    Filter2DTest<float, 1, 15>(720, 1080, 2.0);
+    Filter2DTest<float, 3, 21>(720, 1080, 2.0);
+    Filter2DTest<float, 4, 31>(720, 1080, 2.0);
 }
 
 TEST(FILTER2D_UINT8, x86)
@@ -59,4 +210,40 @@ TEST(FILTER2D_UINT8, x86)
     Filter2DTest<uint8_t, 3, 3>(720, 1080, 2.0);
     Filter2DTest<uint8_t, 3, 5>(720, 1080, 2.0);
     Filter2DTest<uint8_t, 3, 7>(720, 1080, 2.0);
+    Filter2DTest<uint8_t, 1, 15>(720, 1080, 2.0);
+    Filter2DTest<uint8_t, 3, 21>(720, 1080, 2.0);
+    Filter2DTest<uint8_t, 4, 31>(720, 1080, 2.0);
+}
+
+TEST(FILTER2D_SEPARABLE_FP32, x86)
+{
+    Filter2DSeparableTest<float, 1, 9>(720, 1080, 2.0);
+    Filter2DSeparableTest<float, 3, 15>(720, 1080, 2.0);
+    Filter2DSeparableTest<float, 4, 31>(720, 1080, 2.0);
+}
+
+TEST(FILTER2D_SEPARABLE_UINT8, x86)
+{
+    Filter2DSeparableTest<uint8_t, 1, 9>(720, 1080, 2.0);
+    Filter2DSeparableTest<uint8_t, 3, 15>(720, 1080, 2.0);
+    Filter2DSeparableTest<uint8_t, 4, 31>(720, 1080, 2.0);
+}
+
+TEST(FILTER2D_RANK2_FP32, x86)
+{
+    Filter2DRank2Test<float, 1, 9>(720, 1080, 1e-2);
+    Filter2DRank2Test<float, 3, 15>(720, 1080, 1e-2);
+}
+
+TEST(FILTER2D_RANK2_UINT8, x86)
+{
+    Filter2DRank2Test<uint8_t, 1, 9>(720, 1080, 2.0);
+    Filter2DRank2Test<uint8_t, 4, 15>(720, 1080, 2.0);
+}
+
+TEST(FILTER2D_RANK_TOLERANCE, x86)
+{
+    Filter2DToleranceTest<15>(720, 1080);
+    Filter2DNoFactorizationTest<9>(720, 1080);
+    Filter2DNoFactorizationTest<15>(720, 1080);
 }
@@ -259,11 +259,12 @@ namespace x86 {
             break;
         }
         case 3: {
-            __m128i v_index = _mm_setr_epi8(12, 13, 14, 9, 10, 11, 6, 7, 8, 3, 4, 5, 0, 1, 2, -1);
+            // 5 pixels are loaded from one byte ahead and stored with a spare byte, both kept inside the row.
+            __m128i v_index = _mm_setr_epi8(13, 14, 15, 10, 11, 12, 7, 8, 9, 4, 5, 6, 1, 2, 3, -1);
             for (int32_t i = 0; i < height; ++i) {
                 int32_t j = 0;
-                for (; j <= width - 5; j += 5) {
-                    __m128i right = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * inWidthStride + (width - j - 5) * channels));
+                for (; j <= width - 6; j += 5) {
+                    __m128i right = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * inWidthStride + (width - j - 5) * channels - 1));
                     right         = _mm_shuffle_epi8(right, v_index);
                     _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * outWidthStride + j * channels), right);
                 }
@@ -342,11 +343,12 @@ namespace x86 {
             break;
         }
         case 3: {
-            __m128i v_index = _mm_setr_epi8(12, 13, 14, 9, 10, 11, 6, 7, 8, 3, 4, 5, 0, 1, 2, -1);
+            // 5 pixels are loaded from one byte ahead and stored with a spare byte, both kept inside the row.
+            __m128i v_index = _mm_setr_epi8(13, 14, 15, 10, 11, 12, 7, 8, 9, 4, 5, 6, 1, 2, 3, -1);
             for (int32_t i = 0; i < height; ++i) {
                 int32_t j = 0;
-                for (; j <= width - 5; j += 5) {
-                    __m128i right = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + (height - i - 1) * inWidthStride + (width - j - 5) * channels));
+                for (; j <= width - 6; j += 5) {
+                    __m128i right = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + (height - i - 1) * inWidthStride + (width - j - 5) * channels - 1));
                     right         = _mm_shuffle_epi8(right, v_index);
                     _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * outWidthStride + j * channels), right);
                 }
@@ -0,0 +1,96 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "ppl/cv/x86/fma/internal_fma.hpp"
+#include <immintrin.h>
+
+namespace ppl {
+namespace cv {
+namespace x86 {
+namespace fma {
+
+// Folding constants of the bit reflected CRC-32 polynomial 0x04C11DB7, from
+// "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction",
+// Intel, 2009. k1/k2 fold 512 bits, k3/k4 fold 128 bits, k5 folds 64 bits
+// down to 32, and the last pair holds P(x)' and mu for the Barrett reduction.
+static const uint64_t k1k2[2] = {0x0154442bd4, 0x01c6e41596};
+static const uint64_t k3k4[2] = {0x01751997d0, 0x00ccaa009e};
+static const uint64_t k5k0[2] = {0x0163cd6124, 0x0000000000};
+static const uint64_t polynomial[2] = {0x01db710641, 0x01f7011641};
+
+static inline __m128i foldBlock(__m128i x, __m128i constants, __m128i data)
+{
+    __m128i low  = _mm_clmulepi64_si128(x, constants, 0x00);
+    __m128i high = _mm_clmulepi64_si128(x, constants, 0x11);
+    return _mm_xor_si128(_mm_xor_si128(high, low), data);
+}
+
+uint32_t crc32_fold_u8(
+    uint32_t crc,
+    const uint8_t *data,
+    size_t length)
+{
+    // four independent 128 bit lanes hide the latency of the multiplier.
+    __m128i x0 = _mm_loadu_si128((const __m128i *)(data + 0));
+    __m128i x1 = _mm_loadu_si128((const __m128i *)(data + 16));
+    __m128i x2 = _mm_loadu_si128((const __m128i *)(data + 32));
+    __m128i x3 = _mm_loadu_si128((const __m128i *)(data + 48));
+    x0         = _mm_xor_si128(x0, _mm_cvtsi32_si128((int32_t)crc));
+    data += 64;
+    length -= 64;
+
+    __m128i constants = _mm_loadu_si128((const __m128i *)k1k2);
+    while (length >= 64) {
+        x0 = foldBlock(x0, constants, _mm_loadu_si128((const __m128i *)(data + 0)));
+        x1 = foldBlock(x1, constants, _mm_loadu_si128((const __m128i *)(data + 16)));
+        x2 = foldBlock(x2, constants, _mm_loadu_si128((const __m128i *)(data + 32)));
+        x3 = foldBlock(x3, constants, _mm_loadu_si128((const __m128i *)(data + 48)));
+        data += 64;
+        length -= 64;
+    }
+
+    // folds the four lanes into one, then the remaining 16 byte blocks.
+    constants = _mm_loadu_si128((const __m128i *)k3k4);
+    x0        = foldBlock(x0, constants, x1);
+    x0        = foldBlock(x0, constants, x2);
+    x0        = foldBlock(x0, constants, x3);
+    while (length >= 16) {
+        x0 = foldBlock(x0, constants, _mm_loadu_si128((const __m128i *)data));
+        data += 16;
+        length -= 16;
+    }
+
+    // 128 bits to 64 bits, then 64 bits to 32 bits.
+    __m128i mask32 = _mm_setr_epi32(-1, 0, -1, 0);
+    __m128i x4     = _mm_clmulepi64_si128(x0, constants, 0x10);
+    x0             = _mm_xor_si128(_mm_srli_si128(x0, 8), x4);
+    constants      = _mm_loadu_si128((const __m128i *)k5k0);
+    x4             = _mm_srli_si128(x0, 4);
+    x0             = _mm_clmulepi64_si128(_mm_and_si128(x0, mask32), constants, 0x00);
+    x0             = _mm_xor_si128(x0, x4);
+
+    // Barrett reduction to the 32 bit remainder.
+    constants = _mm_loadu_si128((const __m128i *)polynomial);
+    x4        = _mm_clmulepi64_si128(_mm_and_si128(x0, mask32), constants, 0x10);
+    x4        = _mm_clmulepi64_si128(_mm_and_si128(x4, mask32), constants, 0x00);
+    x0        = _mm_xor_si128(x0, x4);
+
+    return (uint32_t)_mm_extract_epi32(x0, 1);
+}
+
+}}}} // namespace ppl::cv::x86::fma
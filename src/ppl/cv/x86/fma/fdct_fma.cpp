@@ -0,0 +1,187 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "ppl/cv/x86/fma/internal_fma.hpp"
+#include <immintrin.h>
+
+namespace ppl {
+namespace cv {
+namespace x86 {
+namespace fma {
+
+// Same integer FDCT and quantization as the SSE2 ones of the JPEG encoder,
+// with the 128 bit lane 0 of each register holding a row of block 0 and lane 1
+// the same row of block 1, so results stay bit exact.
+#define CONST_BITS 13
+#define PASS1_BITS 2
+
+#define FIX_0_298631336 2446
+#define FIX_0_390180644 3196
+#define FIX_0_541196100 4433
+#define FIX_0_765366865 6270
+#define FIX_0_899976223 7373
+#define FIX_1_175875602 9633
+#define FIX_1_501321110 12299
+#define FIX_1_847759065 15137
+#define FIX_1_961570560 16069
+#define FIX_2_053119869 16819
+#define FIX_2_562915447 20995
+#define FIX_3_072711026 25172
+
+static inline __m256i fdctConstants(int16_t x, int16_t y)
+{
+    return _mm256_set1_epi32((int32_t)(((uint32_t)(uint16_t)y << 16) | (uint16_t)x));
+}
+
+// x * c.x + y * c.y of the 16 pairs, descaled and packed to 16 bits.
+template <int32_t shift>
+static inline __m256i fdctRotate(__m256i x, __m256i y, __m256i c, __m256i bias)
+{
+    __m256i low  = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(x, y), c), bias);
+    __m256i high = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(x, y), c), bias);
+    return _mm256_packs_epi32(_mm256_srai_epi32(low, shift), _mm256_srai_epi32(high, shift));
+}
+
+static inline void transpose8x8(__m256i rows[8])
+{
+    __m256i a0 = _mm256_unpacklo_epi16(rows[0], rows[1]);
+    __m256i a1 = _mm256_unpackhi_epi16(rows[0], rows[1]);
+    __m256i a2 = _mm256_unpacklo_epi16(rows[2], rows[3]);
+    __m256i a3 = _mm256_unpackhi_epi16(rows[2], rows[3]);
+    __m256i a4 = _mm256_unpacklo_epi16(rows[4], rows[5]);
+    __m256i a5 = _mm256_unpackhi_epi16(rows[4], rows[5]);
+    __m256i a6 = _mm256_unpacklo_epi16(rows[6], rows[7]);
+    __m256i a7 = _mm256_unpackhi_epi16(rows[6], rows[7]);
+    __m256i b0 = _mm256_unpacklo_epi32(a0, a2);
+    __m256i b1 = _mm256_unpackhi_epi32(a0, a2);
+    __m256i b2 = _mm256_unpacklo_epi32(a1, a3);
+    __m256i b3 = _mm256_unpackhi_epi32(a1, a3);
+    __m256i b4 = _mm256_unpacklo_epi32(a4, a6);
+    __m256i b5 = _mm256_unpackhi_epi32(a4, a6);
+    __m256i b6 = _mm256_unpacklo_epi32(a5, a7);
+    __m256i b7 = _mm256_unpackhi_epi32(a5, a7);
+    rows[0]    = _mm256_unpacklo_epi64(b0, b4);
+    rows[1]    = _mm256_unpackhi_epi64(b0, b4);
+    rows[2]    = _mm256_unpacklo_epi64(b1, b5);
+    rows[3]    = _mm256_unpackhi_epi64(b1, b5);
+    rows[4]    = _mm256_unpacklo_epi64(b2, b6);
+    rows[5]    = _mm256_unpackhi_epi64(b2, b6);
+    rows[6]    = _mm256_unpacklo_epi64(b3, b7);
+    rows[7]    = _mm256_unpackhi_epi64(b3, b7);
+}
+
+// one dimensional transform of the samples data[0] ~ data[7] of 16 lines.
+template <int32_t pass>
+static inline void fdctPass(__m256i data[8])
+{
+    const int32_t shift = pass == 1 ? CONST_BITS - PASS1_BITS : CONST_BITS + PASS1_BITS;
+    const __m256i bias  = _mm256_set1_epi32(1 << (shift - 1));
+
+    __m256i tmp0 = _mm256_add_epi16(data[0], data[7]);
+    __m256i tmp7 = _mm256_sub_epi16(data[0], data[7]);
+    __m256i tmp1 = _mm256_add_epi16(data[1], data[6]);
+    __m256i tmp6 = _mm256_sub_epi16(data[1], data[6]);
+    __m256i tmp2 = _mm256_add_epi16(data[2], data[5]);
+    __m256i tmp5 = _mm256_sub_epi16(data[2], data[5]);
+    __m256i tmp3 = _mm256_add_epi16(data[3], data[4]);
+    __m256i tmp4 = _mm256_sub_epi16(data[3], data[4]);
+
+    // even part
+    __m256i tmp10 = _mm256_add_epi16(tmp0, tmp3);
+    __m256i tmp13 = _mm256_sub_epi16(tmp0, tmp3);
+    __m256i tmp11 = _mm256_add_epi16(tmp1, tmp2);
+    __m256i tmp12 = _mm256_sub_epi16(tmp1, tmp2);
+    if (pass == 1) {
+        data[0] = _mm256_slli_epi16(_mm256_add_epi16(tmp10, tmp11), PASS1_BITS);
+        data[4] = _mm256_slli_epi16(_mm256_sub_epi16(tmp10, tmp11), PASS1_BITS);
+    } else {
+        const __m256i round = _mm256_set1_epi16(1 << (PASS1_BITS - 1));
+        data[0]             = _mm256_srai_epi16(_mm256_add_epi16(_mm256_add_epi16(tmp10, tmp11), round), PASS1_BITS);
+        data[4]             = _mm256_srai_epi16(_mm256_add_epi16(_mm256_sub_epi16(tmp10, tmp11), round), PASS1_BITS);
+    }
+    data[2] = fdctRotate<shift>(tmp13, tmp12, fdctConstants(FIX_0_541196100 + FIX_0_765366865, FIX_0_541196100), bias);
+    data[6] = fdctRotate<shift>(tmp13, tmp12, fdctConstants(FIX_0_541196100, FIX_0_541196100 - FIX_1_847759065), bias);
+
+    // odd part, z3 and z4 are shared by the rotations of the outputs.
+    __m256i z3        = _mm256_add_epi16(tmp4, tmp6);
+    __m256i z4        = _mm256_add_epi16(tmp5, tmp7);
+    __m256i z_low     = _mm256_unpacklo_epi16(z3, z4);
+    __m256i z_high    = _mm256_unpackhi_epi16(z3, z4);
+    __m256i z3_c      = fdctConstants(FIX_1_175875602 - FIX_1_961570560, FIX_1_175875602);
+    __m256i z4_c      = fdctConstants(FIX_1_175875602, FIX_1_175875602 - FIX_0_390180644);
+    __m256i z3_low    = _mm256_add_epi32(_mm256_madd_epi16(z_low, z3_c), bias);
+    __m256i z3_high   = _mm256_add_epi32(_mm256_madd_epi16(z_high, z3_c), bias);
+    __m256i z4_low    = _mm256_add_epi32(_mm256_madd_epi16(z_low, z4_c), bias);
+    __m256i z4_high   = _mm256_add_epi32(_mm256_madd_epi16(z_high, z4_c), bias);
+
+    __m256i t47_low   = _mm256_unpacklo_epi16(tmp4, tmp7);
+    __m256i t47_high  = _mm256_unpackhi_epi16(tmp4, tmp7);
+    __m256i t56_low   = _mm256_unpacklo_epi16(tmp5, tmp6);
+    __m256i t56_high  = _mm256_unpackhi_epi16(tmp5, tmp6);
+    __m256i c7        = fdctConstants(FIX_0_298631336 - FIX_0_899976223, -FIX_0_899976223);
+    __m256i c1        = fdctConstants(-FIX_0_899976223, FIX_1_501321110 - FIX_0_899976223);
+    __m256i c5        = fdctConstants(FIX_2_053119869 - FIX_2_562915447, -FIX_2_562915447);
+    __m256i c3        = fdctConstants(-FIX_2_562915447, FIX_3_072711026 - FIX_2_562915447);
+
+    data[7] = _mm256_packs_epi32(_mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(t47_low, c7), z3_low), shift),
+                                 _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(t47_high, c7), z3_high), shift));
+    data[1] = _mm256_packs_epi32(_mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(t47_low, c1), z4_low), shift),
+                                 _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(t47_high, c1), z4_high), shift));
+    data[5] = _mm256_packs_epi32(_mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(t56_low, c5), z4_low), shift),
+                                 _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(t56_high, c5), z4_high), shift));
+    data[3] = _mm256_packs_epi32(_mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(t56_low, c3), z3_low), shift),
+                                 _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(t56_high, c3), z3_high), shift));
+}
+
+void fdct_quant_2blocks_u8(
+    const uint8_t *src,
+    int32_t stride,
+    const uint16_t *divisors,
+    int16_t *dst0,
+    int16_t *dst1)
+{
+    const __m256i center = _mm256_set1_epi16(128);
+    __m256i data[8];
+    for (int32_t i = 0; i < 8; ++i) {
+        __m256i samples = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(src + i * stride)));
+        data[i]         = _mm256_sub_epi16(samples, center);
+    }
+
+    transpose8x8(data);
+    fdctPass<1>(data);
+    transpose8x8(data);
+    fdctPass<2>(data);
+
+    // |x| is divided through the reciprocals, see computeDivisors() of the
+    // encoder.
+    for (int32_t i = 0; i < 8; ++i) {
+        __m256i reciprocal = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(divisors + i * 8)));
+        __m256i correction = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(divisors + 64 + i * 8)));
+        __m256i scale      = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(divisors + 128 + i * 8)));
+        __m256i sign       = _mm256_srai_epi16(data[i], 15);
+        __m256i value      = _mm256_sub_epi16(_mm256_xor_si256(data[i], sign), sign);
+        value              = _mm256_add_epi16(value, correction);
+        value              = _mm256_mulhi_epu16(value, reciprocal);
+        value              = _mm256_mulhi_epu16(value, scale);
+        value              = _mm256_sub_epi16(_mm256_xor_si256(value, sign), sign);
+        _mm_storeu_si128((__m128i *)(dst0 + i * 8), _mm256_castsi256_si128(value));
+        _mm_storeu_si128((__m128i *)(dst1 + i * 8), _mm256_extracti128_si256(value, 1));
+    }
+}
+
+}}}} // namespace ppl::cv::x86::fma
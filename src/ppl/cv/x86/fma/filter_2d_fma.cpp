@@ -2752,6 +2752,107 @@ void convolution_f<5>(
     FILTER_F(imageOutInnerY + top, imageOutSizeY);
 }
 
+template <typename T>
+static inline __m256 loadFloat8(const T *src);
+
+template <>
+inline __m256 loadFloat8<float>(const float *src)
+{
+    return _mm256_loadu_ps(src);
+}
+
+template <>
+inline __m256 loadFloat8<uint8_t>(const uint8_t *src)
+{
+    return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)src)));
+}
+
+template <typename T>
+static inline void storeFloat8(__m256 value, T *dst);
+
+template <>
+inline void storeFloat8<float>(__m256 value, float *dst)
+{
+    _mm256_storeu_ps(dst, value);
+}
+
+template <>
+inline void storeFloat8<uint8_t>(__m256 value, uint8_t *dst)
+{
+    __m256i data  = _mm256_cvtps_epi32(value);
+    __m128i data0 = _mm_packs_epi32(_mm256_castsi256_si128(data), _mm256_extracti128_si256(data, 1));
+    _mm_storel_epi64((__m128i *)dst, _mm_packus_epi16(data0, data0));
+}
+
+template <typename T>
+void rowFilterLowRank(
+    const T *src,
+    int32_t length,
+    int32_t cn,
+    const float *coeffs,
+    int32_t kernel_len,
+    float *dst)
+{
+    int32_t x = 0;
+    for (; x <= length - 16; x += 16) {
+        __m256 sum0 = _mm256_setzero_ps();
+        __m256 sum1 = _mm256_setzero_ps();
+        for (int32_t k = 0; k < kernel_len; k++) {
+            __m256 coeff = _mm256_broadcast_ss(coeffs + k);
+            sum0         = _mm256_fmadd_ps(coeff, loadFloat8<T>(src + x + k * cn), sum0);
+            sum1         = _mm256_fmadd_ps(coeff, loadFloat8<T>(src + x + k * cn + 8), sum1);
+        }
+        _mm256_storeu_ps(dst + x, sum0);
+        _mm256_storeu_ps(dst + x + 8, sum1);
+    }
+    for (; x < length; x++) {
+        float sum = 0.f;
+        for (int32_t k = 0; k < kernel_len; k++) {
+            sum += coeffs[k] * src[x + k * cn];
+        }
+        dst[x] = sum;
+    }
+}
+
+template <typename T>
+void columnFilterLowRank(
+    const float *const *rows,
+    int32_t count,
+    int32_t length,
+    const float *coeffs,
+    T *dst)
+{
+    int32_t x = 0;
+    for (; x <= length - 16; x += 16) {
+        __m256 sum0 = _mm256_setzero_ps();
+        __m256 sum1 = _mm256_setzero_ps();
+        for (int32_t k = 0; k < count; k++) {
+            __m256 coeff = _mm256_broadcast_ss(coeffs + k);
+            sum0         = _mm256_fmadd_ps(coeff, _mm256_loadu_ps(rows[k] + x), sum0);
+            sum1         = _mm256_fmadd_ps(coeff, _mm256_loadu_ps(rows[k] + x + 8), sum1);
+        }
+        storeFloat8<T>(sum0, dst + x);
+        storeFloat8<T>(sum1, dst + x + 8);
+    }
+    for (; x < length; x++) {
+        __m128 sum = _mm_setzero_ps();
+        for (int32_t k = 0; k < count; k++) {
+            sum = _mm_fmadd_ss(_mm_set_ss(coeffs[k]), _mm_load_ss(rows[k] + x), sum);
+        }
+        float value = _mm_cvtss_f32(sum);
+        if (sizeof(T) == 1) {
+            dst[x] = sat_cast_u8(_mm_cvtss_si32(sum));
+        } else {
+            dst[x] = value;
+        }
+    }
+}
+
+template void rowFilterLowRank<float>(const float *src, int32_t length, int32_t cn, const float *coeffs, int32_t kernel_len, float *dst);
+template void rowFilterLowRank<uint8_t>(const uint8_t *src, int32_t length, int32_t cn, const float *coeffs, int32_t kernel_len, float *dst);
+template void columnFilterLowRank<float>(const float *const *rows, int32_t count, int32_t length, const float *coeffs, float *dst);
+template void columnFilterLowRank<uint8_t>(const float *const *rows, int32_t count, int32_t length, const float *coeffs, uint8_t *dst);
+
 }
 }
 }
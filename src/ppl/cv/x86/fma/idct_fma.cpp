@@ -0,0 +1,199 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "ppl/cv/x86/fma/internal_fma.hpp"
+#include <immintrin.h>
+
+namespace ppl {
+namespace cv {
+namespace x86 {
+namespace fma {
+
+// Same integer IDCT as the SSE2 one of the JPEG decoder, with the 128 bit
+// lane 0 of each register holding a row of block 0 and lane 1 the same row of
+// block 1, so results stay bit exact.
+#define FLOAT2FIXED(x) ((int32_t)(((x) * 4096 + 0.5)))
+
+typedef struct {
+    __m256i low, high;
+} Int32x16;
+
+static inline __m256i idctConstants(int16_t x, int16_t y)
+{
+    return _mm256_set1_epi32((int32_t)(((uint32_t)(uint16_t)y << 16) | (uint16_t)x));
+}
+
+static inline void idctRotate(__m256i x, __m256i y, __m256i c0, __m256i c1, Int32x16 &out0, Int32x16 &out1)
+{
+    __m256i low  = _mm256_unpacklo_epi16(x, y);
+    __m256i high = _mm256_unpackhi_epi16(x, y);
+    out0.low     = _mm256_madd_epi16(low, c0);
+    out0.high    = _mm256_madd_epi16(high, c0);
+    out1.low     = _mm256_madd_epi16(low, c1);
+    out1.high    = _mm256_madd_epi16(high, c1);
+}
+
+static inline Int32x16 idctWiden(__m256i x)
+{
+    Int32x16 out;
+    out.low  = _mm256_srai_epi32(_mm256_unpacklo_epi16(_mm256_setzero_si256(), x), 4);
+    out.high = _mm256_srai_epi32(_mm256_unpackhi_epi16(_mm256_setzero_si256(), x), 4);
+    return out;
+}
+
+static inline Int32x16 idctAdd(const Int32x16 &a, const Int32x16 &b)
+{
+    Int32x16 out;
+    out.low  = _mm256_add_epi32(a.low, b.low);
+    out.high = _mm256_add_epi32(a.high, b.high);
+    return out;
+}
+
+static inline Int32x16 idctSub(const Int32x16 &a, const Int32x16 &b)
+{
+    Int32x16 out;
+    out.low  = _mm256_sub_epi32(a.low, b.low);
+    out.high = _mm256_sub_epi32(a.high, b.high);
+    return out;
+}
+
+template <int32_t shift>
+static inline void idctButterfly(const Int32x16 &a, const Int32x16 &b, __m256i bias, __m256i &out0, __m256i &out1)
+{
+    __m256i biased_low  = _mm256_add_epi32(a.low, bias);
+    __m256i biased_high = _mm256_add_epi32(a.high, bias);
+    out0                = _mm256_packs_epi32(_mm256_srai_epi32(_mm256_add_epi32(biased_low, b.low), shift),
+                              _mm256_srai_epi32(_mm256_add_epi32(biased_high, b.high), shift));
+    out1                = _mm256_packs_epi32(_mm256_srai_epi32(_mm256_sub_epi32(biased_low, b.low), shift),
+                              _mm256_srai_epi32(_mm256_sub_epi32(biased_high, b.high), shift));
+}
+
+template <int32_t shift>
+static inline void idctPass(__m256i rows[8], __m256i bias)
+{
+    const __m256i rotate0_0 = idctConstants(FLOAT2FIXED(0.5411961f), FLOAT2FIXED(0.5411961f) + FLOAT2FIXED(-1.847759065f));
+    const __m256i rotate0_1 = idctConstants(FLOAT2FIXED(0.5411961f) + FLOAT2FIXED(0.765366865f), FLOAT2FIXED(0.5411961f));
+    const __m256i rotate1_0 = idctConstants(FLOAT2FIXED(1.175875602f) + FLOAT2FIXED(-0.899976223f), FLOAT2FIXED(1.175875602f));
+    const __m256i rotate1_1 = idctConstants(FLOAT2FIXED(1.175875602f), FLOAT2FIXED(1.175875602f) + FLOAT2FIXED(-2.562915447f));
+    const __m256i rotate2_0 = idctConstants(FLOAT2FIXED(-1.961570560f) + FLOAT2FIXED(0.298631336f), FLOAT2FIXED(-1.961570560f));
+    const __m256i rotate2_1 = idctConstants(FLOAT2FIXED(-1.961570560f), FLOAT2FIXED(-1.961570560f) + FLOAT2FIXED(3.072711026f));
+    const __m256i rotate3_0 = idctConstants(FLOAT2FIXED(-0.390180644f) + FLOAT2FIXED(2.053119869f), FLOAT2FIXED(-0.390180644f));
+    const __m256i rotate3_1 = idctConstants(FLOAT2FIXED(-0.390180644f), FLOAT2FIXED(-0.390180644f) + FLOAT2FIXED(1.501321110f));
+
+    // even part
+    Int32x16 t2, t3;
+    idctRotate(rows[2], rows[6], rotate0_0, rotate0_1, t2, t3);
+    Int32x16 t0 = idctWiden(_mm256_add_epi16(rows[0], rows[4]));
+    Int32x16 t1 = idctWiden(_mm256_sub_epi16(rows[0], rows[4]));
+    Int32x16 x0 = idctAdd(t0, t3);
+    Int32x16 x3 = idctSub(t0, t3);
+    Int32x16 x1 = idctAdd(t1, t2);
+    Int32x16 x2 = idctSub(t1, t2);
+
+    // odd part
+    Int32x16 y0, y1, y2, y3, y4, y5;
+    idctRotate(rows[7], rows[3], rotate2_0, rotate2_1, y0, y2);
+    idctRotate(rows[5], rows[1], rotate3_0, rotate3_1, y1, y3);
+    idctRotate(_mm256_add_epi16(rows[1], rows[7]), _mm256_add_epi16(rows[3], rows[5]), rotate1_0, rotate1_1, y4, y5);
+    Int32x16 x4 = idctAdd(y0, y4);
+    Int32x16 x5 = idctAdd(y1, y5);
+    Int32x16 x6 = idctAdd(y2, y5);
+    Int32x16 x7 = idctAdd(y3, y4);
+
+    idctButterfly<shift>(x0, x7, bias, rows[0], rows[7]);
+    idctButterfly<shift>(x1, x6, bias, rows[1], rows[6]);
+    idctButterfly<shift>(x2, x5, bias, rows[2], rows[5]);
+    idctButterfly<shift>(x3, x4, bias, rows[3], rows[4]);
+}
+
+static inline void interleave16(__m256i &a, __m256i &b)
+{
+    __m256i value = a;
+    a             = _mm256_unpacklo_epi16(a, b);
+    b             = _mm256_unpackhi_epi16(value, b);
+}
+
+static inline void interleave8(__m256i &a, __m256i &b)
+{
+    __m256i value = a;
+    a             = _mm256_unpacklo_epi8(a, b);
+    b             = _mm256_unpackhi_epi8(value, b);
+}
+
+// Stores the low 8 bytes of each lane as a 16 byte row of the two blocks.
+static inline void storeRow(uint8_t *dst, __m256i value)
+{
+    __m256i packed = _mm256_permute4x64_epi64(value, 0xD8);
+    _mm_storeu_si128((__m128i *)dst, _mm256_castsi256_si128(packed));
+}
+
+void idct_dequant_2blocks_u8(
+    const int16_t *coeffs,
+    const uint16_t *dequant,
+    uint8_t *dst,
+    int32_t stride)
+{
+    __m256i rows[8];
+    for (int32_t i = 0; i < 8; ++i) {
+        __m256i data  = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(coeffs + i * 8))),
+            _mm_loadu_si128((const __m128i *)(coeffs + 64 + i * 8)),
+            1);
+        __m256i quant = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(dequant + i * 8)));
+        rows[i]       = _mm256_mullo_epi16(data, quant);
+    }
+
+    idctPass<10>(rows, _mm256_set1_epi32(512));
+
+    interleave16(rows[0], rows[4]);
+    interleave16(rows[1], rows[5]);
+    interleave16(rows[2], rows[6]);
+    interleave16(rows[3], rows[7]);
+    interleave16(rows[0], rows[2]);
+    interleave16(rows[1], rows[3]);
+    interleave16(rows[4], rows[6]);
+    interleave16(rows[5], rows[7]);
+    interleave16(rows[0], rows[1]);
+    interleave16(rows[2], rows[3]);
+    interleave16(rows[4], rows[5]);
+    interleave16(rows[6], rows[7]);
+
+    idctPass<17>(rows, _mm256_set1_epi32(65536 + (128 << 17)));
+
+    __m256i p0 = _mm256_packus_epi16(rows[0], rows[1]);
+    __m256i p1 = _mm256_packus_epi16(rows[2], rows[3]);
+    __m256i p2 = _mm256_packus_epi16(rows[4], rows[5]);
+    __m256i p3 = _mm256_packus_epi16(rows[6], rows[7]);
+    interleave8(p0, p2);
+    interleave8(p1, p3);
+    interleave8(p0, p1);
+    interleave8(p2, p3);
+    interleave8(p0, p2);
+    interleave8(p1, p3);
+
+    storeRow(dst, p0);
+    storeRow(dst + stride, _mm256_shuffle_epi32(p0, 0x4E));
+    storeRow(dst + 2 * stride, p2);
+    storeRow(dst + 3 * stride, _mm256_shuffle_epi32(p2, 0x4E));
+    storeRow(dst + 4 * stride, p1);
+    storeRow(dst + 5 * stride, _mm256_shuffle_epi32(p1, 0x4E));
+    storeRow(dst + 6 * stride, p3);
+    storeRow(dst + 7 * stride, _mm256_shuffle_epi32(p3, 0x4E));
+}
+
+}}}} // namespace ppl::cv::x86::fma
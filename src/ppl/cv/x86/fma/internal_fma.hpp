@@ -297,6 +297,25 @@ void convolution_f_r(
     int32_t srcWidthStride,
     BorderType border_type);
 
+// row and column passes of the low rank Filter2D path, the column pass sums
+// count rows of the row pass weighted by coeffs.
+template <typename T>
+void rowFilterLowRank(
+    const T *src,
+    int32_t length,
+    int32_t cn,
+    const float *coeffs,
+    int32_t kernel_len,
+    float *dst);
+
+template <typename T>
+void columnFilterLowRank(
+    const float *const *rows,
+    int32_t count,
+    int32_t length,
+    const float *coeffs,
+    T *dst);
+
 template <typename T, int32_t nc>
 void mergeSOA2AOS(
     int32_t height,
@@ -306,5 +325,64 @@ void mergeSOA2AOS(
     int32_t outWidthStride,
     T *out);
 
+// AVX2 row kernels of PyrDown, PyrUp and BuildPyramid, see pyramid.hpp.
+void pyrdown_row_u8(
+    const uint8_t *const *rows,
+    int32_t width,
+    int32_t channels,
+    int32_t outWidth,
+    uint16_t *buffer,
+    uint8_t *dst);
+
+void pyrdown_row_f32(
+    const float *const *rows,
+    int32_t width,
+    int32_t channels,
+    int32_t outWidth,
+    float *buffer,
+    float *dst);
+
+void pyrup_row_u8(
+    const uint8_t *const *rows,
+    int32_t width,
+    int32_t channels,
+    uint16_t *buffer,
+    uint8_t *dst0,
+    uint8_t *dst1);
+
+void pyrup_row_f32(
+    const float *const *rows,
+    int32_t width,
+    int32_t channels,
+    float *buffer,
+    float *dst0,
+    float *dst1);
+
+// AVX2 JPEG IDCT: dequantizes and transforms the two consecutive 8x8 blocks
+// at coeffs, writing 8 rows of 16 pixels to dst.
+void idct_dequant_2blocks_u8(
+    const int16_t *coeffs,
+    const uint16_t *dequant,
+    uint8_t *dst,
+    int32_t stride);
+
+// AVX2 JPEG FDCT: transforms the two horizontally adjacent 8x8 blocks of
+// samples at src and quantizes them through divisors, the reciprocals,
+// corrections and scales of 64 coefficients each, into dst0 and dst1.
+void fdct_quant_2blocks_u8(
+    const uint8_t *src,
+    int32_t stride,
+    const uint16_t *divisors,
+    int16_t *dst0,
+    int16_t *dst1);
+
+// PCLMULQDQ folded CRC-32 of length bytes at data, length being a multiple
+// of 16 and not less than 64. crc is the running register, not inverted on
+// input or output.
+uint32_t crc32_fold_u8(
+    uint32_t crc,
+    const uint8_t *data,
+    size_t length);
+
 }}}} // namespace ppl::cv::x86::fma
 #endif //! PPL_CV_X86_INTERNAL_FMA_H_
@@ -0,0 +1,357 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "ppl/cv/x86/fma/internal_fma.hpp"
+#include "ppl/cv/x86/pyramid.hpp"
+#include <immintrin.h>
+#include <string.h>
+
+namespace ppl {
+namespace cv {
+namespace x86 {
+namespace fma {
+
+// (s[-2cn] + 4 * s[-cn] + 6 * s[0] + 4 * s[cn] + s[2cn] + 128) >> 8
+static inline __m256i pyrdownSum_u16(const uint16_t *s, int32_t cn)
+{
+    __m256i v0  = _mm256_loadu_si256((const __m256i *)(s - 2 * cn));
+    __m256i v1  = _mm256_loadu_si256((const __m256i *)(s - cn));
+    __m256i v2  = _mm256_loadu_si256((const __m256i *)s);
+    __m256i v3  = _mm256_loadu_si256((const __m256i *)(s + cn));
+    __m256i v4  = _mm256_loadu_si256((const __m256i *)(s + 2 * cn));
+    __m256i sum = _mm256_add_epi16(_mm256_add_epi16(v0, v4), _mm256_slli_epi16(_mm256_add_epi16(v1, v3), 2));
+    sum         = _mm256_add_epi16(sum, _mm256_add_epi16(_mm256_slli_epi16(v2, 2), _mm256_slli_epi16(v2, 1)));
+    return _mm256_srli_epi16(_mm256_add_epi16(sum, _mm256_set1_epi16(128)), 8);
+}
+
+static inline __m256 pyrdownSum_f32(const float *s, int32_t cn)
+{
+    __m256 v0  = _mm256_loadu_ps(s - 2 * cn);
+    __m256 v1  = _mm256_loadu_ps(s - cn);
+    __m256 v2  = _mm256_loadu_ps(s);
+    __m256 v3  = _mm256_loadu_ps(s + cn);
+    __m256 v4  = _mm256_loadu_ps(s + 2 * cn);
+    __m256 sum = _mm256_fmadd_ps(_mm256_add_ps(v1, v3), _mm256_set1_ps(4.0f), _mm256_add_ps(v0, v4));
+    sum        = _mm256_fmadd_ps(v2, _mm256_set1_ps(6.0f), sum);
+    return _mm256_mul_ps(sum, _mm256_set1_ps(1.0f / 256.0f));
+}
+
+void pyrdown_row_u8(
+    const uint8_t *const *rows,
+    int32_t width,
+    int32_t channels,
+    int32_t outWidth,
+    uint16_t *buffer,
+    uint8_t *dst)
+{
+    int32_t length    = width * channels;
+    int32_t outLength = outWidth * channels;
+    uint16_t *row     = buffer + 2 * channels;
+
+    int32_t x = 0;
+    for (; x <= length - 16; x += 16) {
+        __m256i v0  = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(rows[0] + x)));
+        __m256i v1  = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(rows[1] + x)));
+        __m256i v2  = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(rows[2] + x)));
+        __m256i v3  = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(rows[3] + x)));
+        __m256i v4  = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(rows[4] + x)));
+        __m256i sum = _mm256_add_epi16(_mm256_add_epi16(v0, v4), _mm256_slli_epi16(_mm256_add_epi16(v1, v3), 2));
+        sum         = _mm256_add_epi16(sum, _mm256_add_epi16(_mm256_slli_epi16(v2, 2), _mm256_slli_epi16(v2, 1)));
+        _mm256_storeu_si256((__m256i *)(row + x), sum);
+    }
+    for (; x < length; ++x) {
+        row[x] = rows[2][x] * 6 + (rows[1][x] + rows[3][x]) * 4 + rows[0][x] + rows[4][x];
+    }
+    pyrPadRow(row, width, channels, 2, false);
+
+    // the filter is evaluated at every position and the even pixels are
+    // packed afterwards.
+    x = 0;
+    if (channels == 1) {
+        const __m256i mask = _mm256_set1_epi32(0xFFFF);
+        for (; x <= outLength - 16; x += 16) {
+            __m256i a = _mm256_and_si256(pyrdownSum_u16(row + x * 2, 1), mask);
+            __m256i b = _mm256_and_si256(pyrdownSum_u16(row + x * 2 + 16, 1), mask);
+            __m256i p = _mm256_permute4x64_epi64(_mm256_packus_epi32(a, b), 0xD8);
+            p         = _mm256_permute4x64_epi64(_mm256_packus_epi16(p, p), 0x08);
+            _mm_storeu_si128((__m128i *)(dst + x), _mm256_castsi256_si128(p));
+        }
+    } else if (channels == 4) {
+        for (; x <= outLength - 16; x += 16) {
+            __m256i a = _mm256_permute4x64_epi64(pyrdownSum_u16(row + x * 2, 4), 0x08);
+            __m256i b = _mm256_permute4x64_epi64(pyrdownSum_u16(row + x * 2 + 16, 4), 0x08);
+            __m256i p = _mm256_permute2x128_si256(a, b, 0x20);
+            p         = _mm256_permute4x64_epi64(_mm256_packus_epi16(p, p), 0x08);
+            _mm_storeu_si128((__m128i *)(dst + x), _mm256_castsi256_si128(p));
+        }
+    } else {
+        // 3 channels, the filtered row is narrowed into temp and every
+        // other pixel is copied with 4 byte moves, each one overwriting the
+        // first byte of the next pixel.
+        uint8_t *temp = (uint8_t *)(buffer + pyrScratchStep(width, channels));
+        for (int32_t i = 0; i < outLength * 2; i += 16) {
+            __m256i p = pyrdownSum_u16(row + i, channels);
+            p         = _mm256_permute4x64_epi64(_mm256_packus_epi16(p, p), 0x08);
+            _mm_storeu_si128((__m128i *)(temp + i), _mm256_castsi256_si128(p));
+        }
+        for (; x < outLength - channels; x += channels) {
+            memcpy(dst + x, temp + x * 2, 4);
+        }
+    }
+    for (; x < outLength; x += channels) {
+        const uint16_t *s = row + x * 2;
+        for (int32_t c = 0; c < channels; ++c) {
+            int32_t temp = s[c] * 6 + (s[c - channels] + s[c + channels]) * 4 +
+                           s[c - channels * 2] + s[c + channels * 2];
+            dst[x + c] = (temp + (1 << 7)) >> 8;
+        }
+    }
+}
+
+void pyrdown_row_f32(
+    const float *const *rows,
+    int32_t width,
+    int32_t channels,
+    int32_t outWidth,
+    float *buffer,
+    float *dst)
+{
+    int32_t length    = width * channels;
+    int32_t outLength = outWidth * channels;
+    float *row        = buffer + 2 * channels;
+
+    int32_t x = 0;
+    for (; x <= length - 8; x += 8) {
+        __m256 v0  = _mm256_loadu_ps(rows[0] + x);
+        __m256 v1  = _mm256_loadu_ps(rows[1] + x);
+        __m256 v2  = _mm256_loadu_ps(rows[2] + x);
+        __m256 v3  = _mm256_loadu_ps(rows[3] + x);
+        __m256 v4  = _mm256_loadu_ps(rows[4] + x);
+        __m256 sum = _mm256_fmadd_ps(_mm256_add_ps(v1, v3), _mm256_set1_ps(4.0f), _mm256_add_ps(v0, v4));
+        _mm256_storeu_ps(row + x, _mm256_fmadd_ps(v2, _mm256_set1_ps(6.0f), sum));
+    }
+    for (; x < length; ++x) {
+        row[x] = rows[2][x] * 6 + (rows[1][x] + rows[3][x]) * 4 + rows[0][x] + rows[4][x];
+    }
+    pyrPadRow(row, width, channels, 2, false);
+
+    x = 0;
+    if (channels == 1) {
+        for (; x <= outLength - 8; x += 8) {
+            __m256 a = pyrdownSum_f32(row + x * 2, 1);
+            __m256 b = pyrdownSum_f32(row + x * 2 + 8, 1);
+            __m256 p = _mm256_shuffle_ps(a, b, 0x88);
+            p        = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(p), 0xD8));
+            _mm256_storeu_ps(dst + x, p);
+        }
+    } else if (channels == 4) {
+        for (; x <= outLength - 8; x += 8) {
+            __m256 a = pyrdownSum_f32(row + x * 2, 4);
+            __m256 b = pyrdownSum_f32(row + x * 2 + 8, 4);
+            _mm256_storeu_ps(dst + x, _mm256_permute2f128_ps(a, b, 0x20));
+        }
+    } else {
+        float *temp = buffer + pyrScratchStep(width, channels);
+        for (int32_t i = 0; i < outLength * 2; i += 8) {
+            _mm256_storeu_ps(temp + i, pyrdownSum_f32(row + i, channels));
+        }
+        for (; x < outLength - channels; x += channels) {
+            _mm_storeu_ps(dst + x, _mm_loadu_ps(temp + x * 2));
+        }
+    }
+    for (; x < outLength; x += channels) {
+        const float *s = row + x * 2;
+        for (int32_t c = 0; c < channels; ++c) {
+            dst[x + c] = (s[c] * 6 + (s[c - channels] + s[c + channels]) * 4 +
+                          s[c - channels * 2] + s[c + channels * 2]) *
+                         (1.0f / 256.0f);
+        }
+    }
+}
+
+// expands one summed row s into the output row d of twice the width.
+static void pyrupExpand_u8(const uint16_t *s, int32_t width, int32_t channels, uint8_t *temp, uint8_t *d)
+{
+    int32_t length      = width * channels;
+    const __m256i delta = _mm256_set1_epi16(1 << 5);
+    int32_t x           = 0;
+    for (; x <= length - 16; x += 16) {
+        __m256i v0 = _mm256_loadu_si256((const __m256i *)(s + x - channels));
+        __m256i v1 = _mm256_loadu_si256((const __m256i *)(s + x));
+        __m256i v2 = _mm256_loadu_si256((const __m256i *)(s + x + channels));
+        __m256i e  = _mm256_add_epi16(_mm256_add_epi16(v0, v2), _mm256_add_epi16(_mm256_slli_epi16(v1, 2), _mm256_slli_epi16(v1, 1)));
+        __m256i o  = _mm256_slli_epi16(_mm256_add_epi16(v1, v2), 2);
+        e          = _mm256_srli_epi16(_mm256_add_epi16(e, delta), 6);
+        o          = _mm256_srli_epi16(_mm256_add_epi16(o, delta), 6);
+
+        __m256i lo, hi;
+        if (channels == 1) {
+            lo = _mm256_unpacklo_epi16(e, o);
+            hi = _mm256_unpackhi_epi16(e, o);
+        } else if (channels == 4) {
+            lo = _mm256_unpacklo_epi64(e, o);
+            hi = _mm256_unpackhi_epi64(e, o);
+        } else {
+            __m256i p = _mm256_permute4x64_epi64(_mm256_packus_epi16(e, o), 0xD8);
+            _mm_storeu_si128((__m128i *)(temp + x), _mm256_castsi256_si128(p));
+            _mm_storeu_si128((__m128i *)(temp + length + x), _mm256_extracti128_si256(p, 1));
+            continue;
+        }
+        __m256i first  = _mm256_permute2x128_si256(lo, hi, 0x20);
+        __m256i second = _mm256_permute2x128_si256(lo, hi, 0x31);
+        __m256i p      = _mm256_permute4x64_epi64(_mm256_packus_epi16(first, second), 0xD8);
+        _mm256_storeu_si256((__m256i *)(d + x * 2), p);
+    }
+    if (channels != 1 && channels != 4) {
+        // 3 channels, 4 byte moves overwriting the first byte of the next
+        // pixel, the last pixel is left to the scalar tail.
+        x = x / channels * channels;
+        if (x == length) {
+            x -= channels;
+        }
+        for (int32_t i = 0; i < x; i += channels) {
+            memcpy(d + i * 2, temp + i, 4);
+            memcpy(d + i * 2 + channels, temp + length + i, 4);
+        }
+    }
+    for (; x < length; x += channels) {
+        for (int32_t c = 0; c < channels; ++c) {
+            d[x * 2 + c]            = (s[x + c - channels] + s[x + c] * 6 + s[x + c + channels] + (1 << 5)) >> 6;
+            d[x * 2 + channels + c] = ((s[x + c] + s[x + c + channels]) * 4 + (1 << 5)) >> 6;
+        }
+    }
+}
+
+static void pyrupExpand_f32(const float *s, int32_t width, int32_t channels, float *temp, float *d)
+{
+    int32_t length     = width * channels;
+    const __m256 scale = _mm256_set1_ps(1.0f / 64);
+    int32_t x          = 0;
+    for (; x <= length - 8; x += 8) {
+        __m256 v0 = _mm256_loadu_ps(s + x - channels);
+        __m256 v1 = _mm256_loadu_ps(s + x);
+        __m256 v2 = _mm256_loadu_ps(s + x + channels);
+        __m256 e  = _mm256_mul_ps(_mm256_fmadd_ps(v1, _mm256_set1_ps(6.0f), _mm256_add_ps(v0, v2)), scale);
+        __m256 o  = _mm256_mul_ps(_mm256_add_ps(v1, v2), _mm256_set1_ps(4.0f / 64));
+
+        __m256 first, second;
+        if (channels == 1) {
+            __m256 lo = _mm256_unpacklo_ps(e, o);
+            __m256 hi = _mm256_unpackhi_ps(e, o);
+            first     = _mm256_permute2f128_ps(lo, hi, 0x20);
+            second    = _mm256_permute2f128_ps(lo, hi, 0x31);
+        } else if (channels == 4) {
+            first  = _mm256_permute2f128_ps(e, o, 0x20);
+            second = _mm256_permute2f128_ps(e, o, 0x31);
+        } else {
+            _mm256_storeu_ps(temp + x, e);
+            _mm256_storeu_ps(temp + length + x, o);
+            continue;
+        }
+        _mm256_storeu_ps(d + x * 2, first);
+        _mm256_storeu_ps(d + x * 2 + 8, second);
+    }
+    if (channels != 1 && channels != 4) {
+        x = x / channels * channels;
+        if (x == length) {
+            x -= channels;
+        }
+        for (int32_t i = 0; i < x; i += channels) {
+            _mm_storeu_ps(d + i * 2, _mm_loadu_ps(temp + i));
+            _mm_storeu_ps(d + i * 2 + channels, _mm_loadu_ps(temp + length + i));
+        }
+    }
+    for (; x < length; x += channels) {
+        for (int32_t c = 0; c < channels; ++c) {
+            d[x * 2 + c]            = (s[x + c - channels] + s[x + c] * 6 + s[x + c + channels]) * (1.0f / 64);
+            d[x * 2 + channels + c] = (s[x + c] + s[x + c + channels]) * (4.0f / 64);
+        }
+    }
+}
+
+void pyrup_row_u8(
+    const uint8_t *const *rows,
+    int32_t width,
+    int32_t channels,
+    uint16_t *buffer,
+    uint8_t *dst0,
+    uint8_t *dst1)
+{
+    int32_t length  = width * channels;
+    int32_t bufstep = pyrScratchStep(width, channels);
+    uint16_t *row0  = buffer + channels;
+    uint16_t *row1  = buffer + bufstep + channels;
+
+    int32_t x = 0;
+    for (; x <= length - 16; x += 16) {
+        __m256i v0 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(rows[0] + x)));
+        __m256i v1 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(rows[1] + x)));
+        __m256i v2 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(rows[2] + x)));
+        __m256i t0 = _mm256_add_epi16(_mm256_add_epi16(v0, v2), _mm256_add_epi16(_mm256_slli_epi16(v1, 2), _mm256_slli_epi16(v1, 1)));
+        __m256i t1 = _mm256_slli_epi16(_mm256_add_epi16(v1, v2), 2);
+        _mm256_storeu_si256((__m256i *)(row0 + x), t0);
+        _mm256_storeu_si256((__m256i *)(row1 + x), t1);
+    }
+    for (; x < length; ++x) {
+        row0[x] = rows[0][x] + rows[1][x] * 6 + rows[2][x];
+        row1[x] = (rows[1][x] + rows[2][x]) * 4;
+    }
+    pyrPadRow(row0, width, channels, 1, true);
+    pyrPadRow(row1, width, channels, 1, true);
+
+    uint8_t *temp = (uint8_t *)(buffer + bufstep * 2);
+    pyrupExpand_u8(row0, width, channels, temp, dst0);
+    pyrupExpand_u8(row1, width, channels, temp, dst1);
+}
+
+void pyrup_row_f32(
+    const float *const *rows,
+    int32_t width,
+    int32_t channels,
+    float *buffer,
+    float *dst0,
+    float *dst1)
+{
+    int32_t length  = width * channels;
+    int32_t bufstep = pyrScratchStep(width, channels);
+    float *row0     = buffer + channels;
+    float *row1     = buffer + bufstep + channels;
+
+    int32_t x = 0;
+    for (; x <= length - 8; x += 8) {
+        __m256 v0 = _mm256_loadu_ps(rows[0] + x);
+        __m256 v1 = _mm256_loadu_ps(rows[1] + x);
+        __m256 v2 = _mm256_loadu_ps(rows[2] + x);
+        _mm256_storeu_ps(row0 + x, _mm256_fmadd_ps(v1, _mm256_set1_ps(6.0f), _mm256_add_ps(v0, v2)));
+        _mm256_storeu_ps(row1 + x, _mm256_mul_ps(_mm256_add_ps(v1, v2), _mm256_set1_ps(4.0f)));
+    }
+    for (; x < length; ++x) {
+        row0[x] = rows[0][x] + rows[1][x] * 6 + rows[2][x];
+        row1[x] = (rows[1][x] + rows[2][x]) * 4;
+    }
+    pyrPadRow(row0, width, channels, 1, true);
+    pyrPadRow(row1, width, channels, 1, true);
+
+    float *temp = buffer + bufstep * 2;
+    pyrupExpand_f32(row0, width, channels, temp, dst0);
+    pyrupExpand_f32(row1, width, channels, temp, dst1);
+}
+
+}
+}
+}
+} // namespace ppl::cv::x86::fma
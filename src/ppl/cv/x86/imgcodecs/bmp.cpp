@@ -46,8 +46,9 @@ inline void writePixel(uchar* pixel, PaletteEntry& color) {
     pixel[2] = color.r;
 }
 
-BmpDecoder::BmpDecoder(BytesReader& file_data) {
+BmpDecoder::BmpDecoder(BytesReader& file_data, DecoderScratch& scratch) {
     file_data_ = &file_data;
+    scratch_ = &scratch;
     data_offset_ = -1;
     bits_per_pixel_ = 0;
     compression_type_ = BMP_RGB;
@@ -442,6 +443,7 @@ bool BmpDecoder::readHeader() {
     }
 
     channels_ = colorful ? (bits_per_pixel_ == 32 ? 4 : 3) : 1;
+    depth_ = 8;
     origin_ = height > 0 ? ORIGIN_BL : ORIGIN_TL;
     width_  = abs(width);
     height_ = abs(height);
@@ -475,7 +477,10 @@ bool BmpDecoder::decodeData(uint32_t stride, uint8_t* image) {
     uint row, width3 = width_ * channels;
 
     size_t src_size = src_pitch + 32;
-    uchar* src = new uchar[src_size];
+    uchar* src = (uchar*)scratch_->reserve(BMP_SOURCE_ROW, src_size);
+    if (src == nullptr) {
+        return false;
+    }
 
     if (!colorful) {
         if (bits_per_pixel_ <= 8) {
@@ -772,8 +777,6 @@ decode_rle8_bad: ;
         LOG(ERROR) << "Invalid/unsupported bit-per-pixel mode.";
     }
 
-    delete [] src;
-
     return result;
 }
 
@@ -20,6 +20,7 @@
 
 #include "imagecodecs.h"
 #include "bytesreader.h"
+#include "decoderscratch.h"
 
 #include "ppl/cv/types.h"
 
@@ -45,7 +46,7 @@ enum Origin {
 
 class BmpDecoder : public ImageDecoder {
   public:
-    BmpDecoder(BytesReader& file_data);
+    BmpDecoder(BytesReader& file_data, DecoderScratch& scratch);
     ~BmpDecoder();
 
     bool readHeader() override;
@@ -81,6 +82,7 @@ class BmpDecoder : public ImageDecoder {
 
   private:
     BytesReader* file_data_;
+    DecoderScratch* scratch_;
     int data_offset_;
     int bits_per_pixel_;
     BmpCompression compression_type_;
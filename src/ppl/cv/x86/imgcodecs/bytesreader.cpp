@@ -26,22 +26,99 @@ namespace ppl {
 namespace cv {
 namespace x86 {
 
-BytesReader::BytesReader(FILE* fp) {
+/* Window buffer kept by a thread between two file readers. Buffers larger
+ * than CACHED_BLOCK_SIZE are not kept, so a thread only holds on to a small
+ * amount of memory after decoding a big file.
+ */
+struct BlockCache {
+    uint8_t* buffer;
+    uint32_t size;
+    bool in_use;
+
+    BlockCache() : buffer(nullptr), size(0), in_use(false) {}
+    ~BlockCache() {
+        delete [] buffer;
+    }
+};
+
+static thread_local BlockCache block_cache;
+
+BytesReader::BytesReader(FILE* fp, uint8_t* buffer, uint32_t buffer_size) {
     fp_ = fp;
-    start_ = new uint8_t[FILE_BLOCK_SIZE];
-    current_ = start_;
     block_position_ = 0;
     is_last_block_ = false;
     crc_ = nullptr;
 
-    readBlock();
+    // the window covers the whole file when the file fits in a block.
+    file_size_ = UINT32_MAX;
+    uint32_t window_size = FILE_BLOCK_SIZE;
+    long position = ftell(fp_);
+    if (position >= 0 && fseek(fp_, 0, SEEK_END) == 0) {
+        long end = ftell(fp_);
+        fseek(fp_, position, SEEK_SET);
+        if (end >= position && (uint64_t)(end - position) < UINT32_MAX) {
+            file_size_ = end - position;
+            window_size = file_size_ < FILE_BLOCK_SIZE ? file_size_ :
+                          FILE_BLOCK_SIZE;
+            window_size = window_size > 0 ? window_size : 1;
+        }
+    }
+
+    owns_block_ = false;
+    cached_block_ = false;
+    if (buffer != nullptr &&
+        (buffer_size >= window_size || buffer_size >= MIN_BLOCK_SIZE)) {
+        block_ = buffer;
+        block_size_ = buffer_size < window_size ? buffer_size : window_size;
+    }
+    else if (!block_cache.in_use && window_size <= CACHED_BLOCK_SIZE) {
+        if (block_cache.size < window_size) {
+            delete [] block_cache.buffer;
+            block_cache.buffer = new uint8_t[window_size];
+            block_cache.size = window_size;
+        }
+        block_cache.in_use = true;
+        block_ = block_cache.buffer;
+        block_size_ = window_size;
+        cached_block_ = true;
+    }
+    else {
+        block_ = new uint8_t[window_size];
+        block_size_ = window_size;
+        owns_block_ = true;
+    }
+
+    start_ = block_;
+    end_ = block_;
+    current_ = block_;
+    fillBlock(0);
+}
+
+BytesReader::BytesReader(const uint8_t* data, size_t size) {
+    fp_ = nullptr;
+    block_ = nullptr;
+    block_size_ = 0;
+    owns_block_ = false;
+    cached_block_ = false;
+    start_ = data;
+    end_ = data + size;
+    current_ = start_;
+    block_position_ = 0;
+    file_size_ = size;
+    is_last_block_ = true;
+    crc_ = nullptr;
 }
 
 BytesReader::~BytesReader() {
-    delete [] start_;
+    if (owns_block_) {
+        delete [] block_;
+    }
+    if (cached_block_) {
+        block_cache.in_use = false;
+    }
 }
 
-uint8_t* BytesReader::data() const {
+const uint8_t* BytesReader::data() const {
     return start_;
 }
 
@@ -52,69 +129,124 @@ uint32_t BytesReader::getPosition() {
 }
 
 void BytesReader::setPosition(uint32_t position) {
-    uint32_t offset = position % FILE_BLOCK_SIZE;
-    uint32_t prev_block_position = block_position_;
-    block_position_ = position - offset;
-    current_ = start_ + offset;
-    if (prev_block_position != block_position_) {
-        readBlock();
-    }
+    seekBlock(position);
 }
 
 bool BytesReader::skipBytes(uint32_t size) {
-    if (size <= FILE_BLOCK_SIZE - (current_ - start_)) {
+    if (size <= (uint32_t)(end_ - current_)) {
         current_ += size;
+
+        return true;
     }
-    else {
-        uint32_t left = size - (FILE_BLOCK_SIZE - (current_ - start_));
-        uint32_t offset = left % FILE_BLOCK_SIZE;
-        left -= offset;
-        int code = fseek(fp_, left, SEEK_CUR);
-        if (code != 0) {
-            LOG(ERROR) << "Error in skipping " << size
-                       << " bytes in input file.";
-            return false;
+
+    // the skipped bytes still go through the crc checking block by block.
+    if (fp_ != nullptr && crc_ != nullptr && crc_->isChecking()) {
+        while (size > (uint32_t)(end_ - current_) && !is_last_block_) {
+            size -= end_ - current_;
+            readBlock();
         }
-        block_position_ += left;
+        if (size <= (uint32_t)(end_ - current_)) {
+            current_ += size;
 
-        readBlock();
-        current_ = start_ + offset;
+            return true;
+        }
     }
 
+    bool succeeded = seekBlock(getPosition() + size);
+    if (!succeeded) {
+        LOG(ERROR) << "Error in skipping " << size
+                   << " bytes in the input data.";
+    }
+
+    return succeeded;
+}
+
+/* Moves to position, which is looked up in the current block first. A file
+ * reader loads the block starting at position otherwise. Positions past the
+ * end of the input leave the reader at the end.
+ */
+bool BytesReader::seekBlock(uint32_t position) {
+    if (position >= block_position_ &&
+        position - block_position_ <= (uint32_t)(end_ - start_)) {
+        current_ = start_ + (position - block_position_);
+        return true;
+    }
+
+    if (fp_ == nullptr || position > file_size_ ||
+        fseek(fp_, position, SEEK_SET) != 0) {
+        current_ = end_;
+        return false;
+    }
+    block_position_ = position;
+    fillBlock(0);
+
     return true;
 }
 
+// loads the next block of the file, the file is at the end of the current one.
 void BytesReader::readBlock() {
-    uint32_t readed = fread(start_, 1, FILE_BLOCK_SIZE, fp_);
+    if (fp_ == nullptr) {
+        return;
+    }
+
+    block_position_ += end_ - start_;
+    fillBlock(0);
+}
+
+/* Fills the block behind its first kept_size bytes with the following bytes
+ * of the file, the block then starts at block_position_.
+ */
+void BytesReader::fillBlock(uint32_t kept_size) {
+    uint32_t readed = fread(block_ + kept_size, 1, block_size_ - kept_size,
+                            fp_);
     if (ferror(fp_)) {
         LOG(ERROR) << "Error in reading the input file.";
     }
-    if (feof(fp_)) {
+    uint32_t size = kept_size + readed;
+    if (feof(fp_) || block_position_ + size >= file_size_) {
         is_last_block_ = true;
     }
-    end_ = start_ + readed;
-    current_ = start_;
-    if (readed == FILE_BLOCK_SIZE) {
-        block_position_ += FILE_BLOCK_SIZE;
+    else {
+        is_last_block_ = false;
     }
+    end_ = start_ + size;
+    current_ = start_;
 
-    if (crc_ != nullptr && crc_->isChecking()) {
-        crc_->resetData(start_, readed);
+    if (crc_ != nullptr && crc_->isChecking() && readed > 0) {
+        crc_->resetData(start_ + kept_size, readed);
         crc_->calculateCrc();
     }
 }
 
+/* Makes at least size bytes readable at the current position if the input
+ * has them, the unread bytes of the block are moved to its front and the
+ * rest of it is refilled. Returns whether size bytes are readable.
+ */
+bool BytesReader::ensureValidSize(uint32_t size) {
+    uint32_t left = end_ - current_;
+    if (left >= size || is_last_block_ || fp_ == nullptr) {
+        return left >= size;
+    }
+
+    memmove(block_, current_, left);
+    block_position_ += current_ - start_;
+    fillBlock(left);
+
+    return (uint32_t)(end_ - current_) >= size;
+}
+
 int32_t BytesReader::getByte() {
     if (current_ >= end_) {
         if (is_last_block_) return -2;
         readBlock();
+        if (current_ >= end_) return -2;
     }
 
     return *current_++;
 }
 
 int32_t BytesReader::getWordLittleEndian() {
-    uint8_t *current = current_;
+    const uint8_t *current = current_;
     int32_t value;
 
     if (current + 1 < end_) {
@@ -130,7 +262,7 @@ int32_t BytesReader::getWordLittleEndian() {
 }
 
 int32_t BytesReader::getWordBigEndian() {
-    uint8_t *current = current_;
+    const uint8_t *current = current_;
     int32_t value;
 
     if (current + 1 < end_) {
@@ -146,7 +278,7 @@ int32_t BytesReader::getWordBigEndian() {
 }
 
 int32_t BytesReader::getDWordLittleEndian() {
-    uint8_t *current = current_;
+    const uint8_t *current = current_;
     int32_t value;
 
     if (current + 3 < end_) {
@@ -165,7 +297,7 @@ int32_t BytesReader::getDWordLittleEndian() {
 }
 
 int32_t BytesReader::getDWordBigEndian() {
-    uint8_t *current = current_;
+    const uint8_t *current = current_;
     int32_t value;
 
     if (current + 3 < end_) {
@@ -184,24 +316,25 @@ int32_t BytesReader::getDWordBigEndian() {
 }
 
 void BytesReader::getBytes(void* buffer, int32_t count) {
-    if (count >= FILE_BLOCK_SIZE) {
-        LOG(ERROR) << "The bytes are too big than the buffer.";
-    }
-
-    int32_t left = (int32_t)(end_ - current_);
-    if (count <= left) {
-        memcpy(buffer, current_, count);
-        current_ += count;
-    }
-    else {
-        uint8_t* data = (uint8_t*)buffer;
-        memcpy(data, current_, left);
-        data += left;
-        count -= left;
+    uint8_t* data = (uint8_t*)buffer;
+    while (count > 0) {
+        int32_t left = (int32_t)(end_ - current_);
+        if (left == 0) {
+            if (is_last_block_) {
+                LOG(ERROR) << "Error in reading " << count
+                           << " bytes beyond the end of the input data.";
+                memset(data, 0, count);
+                return;
+            }
+            readBlock();
+            continue;
+        }
 
-        readBlock();
-        memcpy(data, current_, count);
-        current_ = start_ + count;
+        int32_t size = count < left ? count : left;
+        memcpy(data, current_, size);
+        current_ += size;
+        data += size;
+        count -= size;
     }
 }
 
@@ -28,15 +28,28 @@ namespace ppl {
 namespace cv {
 namespace x86 {
 
+/* A BytesReader either reads a file block by block through a window buffer,
+ * or works directly on a caller-owned memory buffer holding the whole
+ * encoded image, in which case nothing is copied and the buffer must outlive
+ * the reader.
+ *
+ * The window of a file is no larger than the file itself. It is taken from
+ * the caller-owned buffer when one is given and holds the whole file or at
+ * least MIN_BLOCK_SIZE bytes, otherwise from a buffer cached by the calling
+ * thread, so decoding small files one after another does not allocate
+ * anything once the cache has grown.
+ */
 class BytesReader {
   public:
-    BytesReader(FILE* fp);
+    BytesReader(FILE* fp, uint8_t* buffer = nullptr, uint32_t buffer_size = 0);
+    BytesReader(const uint8_t* data, size_t size);
     ~BytesReader();
 
-    uint8_t* data() const;
+    const uint8_t* data() const;
     uint32_t getPosition();
     void setPosition(uint32_t position);
-    uint8_t* getCurrentPosition() const {return current_;}
+    const uint8_t* getCurrentPosition() const {return current_;}
+    bool isLastBlock() const {return is_last_block_;}
     bool skipBytes(uint32_t size);
     void readBlock();
     int32_t getByte();
@@ -46,15 +59,25 @@ class BytesReader {
     int32_t getDWordBigEndian();
     void getBytes(void* buffer, int32_t count);
     uint32_t getValidSize() const;
+    bool ensureValidSize(uint32_t size);
     void setCrcChecking(Crc32* crc);
     void unsetCrcChecking();
 
+  private:
+    bool seekBlock(uint32_t position);
+    void fillBlock(uint32_t kept_size);
+
   private:
     FILE* fp_;
-    uint8_t* start_;
-    uint8_t* end_;
-    uint8_t* current_;
+    uint8_t* block_;
+    uint32_t block_size_;
+    bool owns_block_;
+    bool cached_block_;
+    const uint8_t* start_;
+    const uint8_t* end_;
+    const uint8_t* current_;
     uint32_t block_position_;
+    uint32_t file_size_;
     bool is_last_block_;
     Crc32* crc_;
 };
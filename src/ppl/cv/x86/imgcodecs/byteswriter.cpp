@@ -17,6 +17,7 @@
 
 #include "byteswriter.h"
 
+#include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 
@@ -28,10 +29,41 @@ namespace x86 {
 
 BytesWriter::BytesWriter(FILE* fp) {
     fp_ = fp;
-    start_ = new uchar[FILE_BLOCK_SIZE];
+    start_ = (uchar*)malloc(FILE_BLOCK_SIZE);
     end_ = start_ + FILE_BLOCK_SIZE;
     current_ = start_;
     block_position_ = 0;
+    owns_block_ = true;
+    is_good_ = start_ != nullptr;
+    is_full_ = false;
+}
+
+BytesWriter::BytesWriter() {
+    fp_ = nullptr;
+    start_ = (uchar*)malloc(CACHED_BLOCK_SIZE);
+    end_ = start_ + CACHED_BLOCK_SIZE;
+    current_ = start_;
+    block_position_ = 0;
+    owns_block_ = true;
+    is_good_ = start_ != nullptr;
+    is_full_ = false;
+}
+
+BytesWriter::BytesWriter(uchar* buffer, size_t capacity) {
+    fp_ = nullptr;
+    start_ = buffer;
+    end_ = buffer + capacity;
+    current_ = start_;
+    block_position_ = 0;
+    owns_block_ = false;
+    is_good_ = buffer != nullptr && capacity > 0;
+    is_full_ = false;
+}
+
+BytesWriter::~BytesWriter() {
+    if (owns_block_) {
+        free(start_);
+    }
 }
 
 int BytesWriter::getPosition() {
@@ -40,18 +72,82 @@ int BytesWriter::getPosition() {
     return position;
 }
 
+// in memory the block is only flushed into a larger one when it is full.
 void BytesWriter::writeBlock() {
+    if (fp_ == nullptr) {
+        if (current_ == end_) {
+            growBlock();
+        }
+        return;
+    }
+
     int size = (int)(current_ - start_);
 
     if (size == 0) {
         return;
     }
 
-    fwrite(start_, 1, size, fp_);
+    if (fwrite(start_, 1, size, fp_) != (size_t)size) {
+        is_good_ = false;
+    }
     current_ = start_;
     block_position_ += size;
 }
 
+/* A caller-owned buffer does not grow. Once it is filled up, the writer goes
+ * on in spill_, so that an image of exactly the capacity still fits, and
+ * the bytes beyond spill_ are dropped.
+ */
+void BytesWriter::growBlock() {
+    if (!owns_block_) {
+        if (start_ != spill_) {
+            block_position_ = end_ - start_;
+            start_ = spill_;
+            end_ = spill_ + sizeof(spill_);
+        }
+        else {
+            is_good_ = false;
+            is_full_ = true;
+        }
+        current_ = start_;
+        return;
+    }
+
+    size_t size = current_ - start_;
+    size_t capacity = (end_ - start_) * 2;
+    uchar* block = (uchar*)realloc(start_, capacity);
+    if (block == nullptr) {
+        // the data is dropped, is_good_ tells the caller.
+        is_good_ = false;
+        current_ = start_;
+        return;
+    }
+
+    start_ = block;
+    end_ = block + capacity;
+    current_ = block + size;
+}
+
+bool BytesWriter::isFull() const {
+    return is_full_ || (start_ == spill_ && current_ != start_);
+}
+
+uchar* BytesWriter::detach(size_t* size) {
+    assert(fp_ == nullptr && size != nullptr);
+    if (!is_good_ || !owns_block_) {
+        return nullptr;
+    }
+
+    uchar* data = start_;
+    *size = current_ - start_;
+    start_ = nullptr;
+    end_ = nullptr;
+    current_ = nullptr;
+    is_good_ = false;
+
+    return data;
+}
+
 void BytesWriter::putByte(int value) {
     *current_++ = (uchar)value;
     if (current_ >= end_) {
@@ -63,6 +159,19 @@ void BytesWriter::putBytes(const void* buffer, int count) {
     uchar* data = (uchar*)buffer;
     assert(data && current_ && count >= 0);
 
+    if (is_full_) {
+        return;
+    }
+    // large blocks skip the buffer, the bytes in it go out first.
+    if (fp_ != nullptr && count >= DIRECT_WRITE_SIZE) {
+        writeBlock();
+        if (fwrite(data, 1, count, fp_) != (size_t)count) {
+            is_good_ = false;
+        }
+        block_position_ += count;
+        return;
+    }
+
     while (count) {
         int left = (int)(end_ - current_);
 
@@ -99,6 +208,23 @@ void BytesWriter::putWord(int value) {
     }
 }
 
+void BytesWriter::putWordBigEndian(int value) {
+    uchar *current = current_;
+
+    if (current+1 < end_) {
+        current[0] = (uchar)(value >> 8);
+        current[1] = (uchar)value;
+        current_ = current + 2;
+        if (current_ == end_) {
+            writeBlock();
+        }
+    }
+    else {
+        putByte(value >> 8);
+        putByte(value);
+    }
+}
+
 void BytesWriter::putDWord(int value) {
     uchar *current = current_;
 
@@ -120,6 +246,27 @@ void BytesWriter::putDWord(int value) {
     }
 }
 
+void BytesWriter::putDWordBigEndian(int value) {
+    uchar *current = current_;
+
+    if (current+3 < end_) {
+        current[0] = (uchar)(value >> 24);
+        current[1] = (uchar)(value >> 16);
+        current[2] = (uchar)(value >> 8);
+        current[3] = (uchar)value;
+        current_ = current + 4;
+        if (current_ == end_) {
+            writeBlock();
+        }
+    }
+    else {
+        putByte(value >> 24);
+        putByte(value >> 16);
+        putByte(value >> 8);
+        putByte(value);
+    }
+}
+
 } //! namespace x86
 } //! namespace cv
 } //! namespace ppl
@@ -19,6 +19,7 @@
 #define __ST_HPC_PPL_CV_X86_BYTES_WRITER_H_
 
 #include <stdio.h>
+#include <stddef.h>
 
 #include "ppl/cv/types.h"
 
@@ -26,19 +27,32 @@ namespace ppl {
 namespace cv {
 namespace x86 {
 
+/* A BytesWriter either writes a file block by block through a buffer, or
+ * collects the whole encoded image in a growing memory buffer which is handed
+ * over to the caller by detach(), or fills a caller-owned buffer which never
+ * grows, isFull() telling whether the image did not fit in it.
+ */
 class BytesWriter {
   public:
     BytesWriter(FILE* fp);
-    ~BytesWriter() {
-        delete [] start_;
-    }
+    BytesWriter();
+    BytesWriter(uchar* buffer, size_t capacity);
+    ~BytesWriter();
 
     int getPosition();
     void writeBlock();
     void putByte(int value);
     void putBytes(const void* buffer, int count);
     void putWord(int value);
+    void putWordBigEndian(int value);
     void putDWord(int value);
+    void putDWordBigEndian(int value);
+    bool isGood() const {return is_good_;}
+    bool isFull() const;
+    uchar* detach(size_t* size);
+
+  private:
+    void growBlock();
 
   private:
     FILE* fp_;
@@ -46,6 +60,10 @@ class BytesWriter {
     uchar* end_;
     uchar* current_;
     int block_position_;
+    bool owns_block_;
+    bool is_good_;
+    bool is_full_;
+    uchar spill_[16];  // written beyond a caller-owned buffer just filled up
 };
 
 } //! namespace x86
@@ -23,6 +23,10 @@ namespace cv {
 namespace x86 {
 
 #define FILE_BLOCK_SIZE (1 << 24)
+#define CACHED_BLOCK_SIZE (1 << 20)
+#define MIN_BLOCK_SIZE (1 << 12)
+#define MIN_MAPPED_SIZE (1 << 16)
+#define DIRECT_WRITE_SIZE (1 << 16)
 #define MAX_IMAGE_SIZE (1 << 30)
 
 } //! namespace x86
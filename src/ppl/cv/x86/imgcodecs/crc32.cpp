@@ -19,7 +19,14 @@
 
 #include <stddef.h>
 #include <stdio.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
 
+#include "ppl/cv/x86/fma/internal_fma.hpp"
+#include "ppl/common/x86/sysinfo.h"
 #include "ppl/common/log.h"
 
 namespace ppl {
@@ -347,10 +354,40 @@ uint32_t crc32Big(uint32_t crc_value, const uint8_t* data, size_t length) {
     return ~crc;
 }
 
+// PCLMULQDQ is reported in bit 1 of ECX by CPUID leaf 1, it is queried once.
+static
+bool supportsPclmulqdq() {
+    static const bool supported = []() {
+#if defined(_MSC_VER)
+        int registers[4];
+        __cpuid(registers, 1);
+        return (registers[2] & 0x2) != 0;
+#else
+        unsigned int eax, ebx, ecx, edx;
+        if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+            return false;
+        }
+        return (ecx & bit_PCLMUL) != 0;
+#endif
+    }();
+
+    return supported;
+}
+
 static
 uint32_t crc32Little(uint32_t crc_value, const uint8_t* data, size_t length) {
     uint32_t crc = ~crc_value;
     uint32_t word;
+
+    // the 16-byte blocks are folded by carry-less multiplication, the folding
+    // is built with the FMA flags, and the tail goes through the tables.
+    if (length >= 64 && ppl::common::CpuSupports(ppl::common::ISA_X86_FMA) &&
+        supportsPclmulqdq()) {
+        size_t folded_length = length & ~(size_t)15;
+        crc = fma::crc32_fold_u8(crc, data, folded_length);
+        data += folded_length;
+        length -= folded_length;
+    }
     const uint32_t* current_word = (const uint32_t*)data;
 
     while (length >= 16) {
@@ -401,7 +438,7 @@ Crc32::Crc32() : data_poiter_(nullptr), data_size_(0), crc_value_(0),
     byte_order_ = checkByteOrder();
 }
 
-Crc32::Crc32(uint8_t* data_poiter, uint32_t data_size, uint32_t crc_value,
+Crc32::Crc32(const uint8_t* data_poiter, uint32_t data_size, uint32_t crc_value,
              uint32_t crc_length, bool is_checking) :
              data_poiter_(data_poiter), data_size_(data_size),
              crc_value_(crc_value), crc_length_(crc_length),
@@ -419,7 +456,7 @@ ByteOrder Crc32::checkByteOrder() {
     }
 }
 
-void Crc32::setCrc(uint8_t* data_poiter, uint32_t data_size,
+void Crc32::setCrc(const uint8_t* data_poiter, uint32_t data_size,
                    uint32_t crc_value, uint32_t crc_length) {
     data_poiter_ = data_poiter;
     data_size_   = data_size;
@@ -486,7 +523,7 @@ bool Crc32::calculateCrc() {
     return true;
 }
 
-bool Crc32::resetData(uint8_t* data_poiter, uint32_t data_size) {
+bool Crc32::resetData(const uint8_t* data_poiter, uint32_t data_size) {
     if (data_poiter == nullptr) {
         LOG(ERROR) << "Data pointer: invalid data pointer.";
         return false;
@@ -32,16 +32,16 @@ enum ByteOrder {
 class Crc32 {
   public:
     Crc32();
-    Crc32(uint8_t* data_poiter, uint32_t data_size, uint32_t crc_value,
+    Crc32(const uint8_t* data_poiter, uint32_t data_size, uint32_t crc_value,
           uint32_t crc_length, bool is_checking);
     ~Crc32() {}
 
     ByteOrder checkByteOrder();
-    void setCrc(uint8_t* data_poiter, uint32_t data_size,
+    void setCrc(const uint8_t* data_poiter, uint32_t data_size,
                 uint32_t crc_value, uint32_t crc_length);
     bool calculateCrc(uint32_t data);
     bool calculateCrc();
-    bool resetData(uint8_t* data_poiter, uint32_t data_size);
+    bool resetData(const uint8_t* data_poiter, uint32_t data_size);
     bool isChecking() const;
     void turnOn();
     void turnOff();
@@ -0,0 +1,83 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "decoderscratch.h"
+
+#include "ppl/common/sys.h"
+#include "ppl/common/log.h"
+
+namespace ppl {
+namespace cv {
+namespace x86 {
+
+DecoderScratch::DecoderScratch() {
+    for (uint32_t i = 0; i < SCRATCH_SLOTS; i++) {
+        buffers_[i] = nullptr;
+        sizes_[i] = 0;
+    }
+    threads_ = 0;
+}
+
+DecoderScratch::~DecoderScratch() {
+    clear();
+}
+
+void* DecoderScratch::reserve(uint32_t slot, size_t size) {
+    if (slot >= SCRATCH_SLOTS) {
+        LOG(ERROR) << "invalid scratch slot: " << slot;
+        return nullptr;
+    }
+    if (size <= sizes_[slot]) {
+        return buffers_[slot];
+    }
+
+    ppl::common::AlignedFree(buffers_[slot]);
+    sizes_[slot] = 0;
+    // 64 bytes of alignment and padding let SIMD loads run over the end.
+    buffers_[slot] = ppl::common::AlignedAlloc(size + 64, 64);
+    if (buffers_[slot] == nullptr) {
+        LOG(ERROR) << "failed to allocate " << size << " bytes of scratch.";
+        return nullptr;
+    }
+    sizes_[slot] = size;
+
+    return buffers_[slot];
+}
+
+size_t DecoderScratch::capacity(uint32_t slot) const {
+    return slot < SCRATCH_SLOTS ? sizes_[slot] : 0;
+}
+
+void DecoderScratch::clear() {
+    for (uint32_t i = 0; i < SCRATCH_SLOTS; i++) {
+        ppl::common::AlignedFree(buffers_[i]);
+        buffers_[i] = nullptr;
+        sizes_[i] = 0;
+    }
+}
+
+void DecoderScratch::setThreads(uint32_t threads) {
+    threads_ = threads;
+}
+
+uint32_t DecoderScratch::threads() const {
+    return threads_;
+}
+
+} //! namespace x86
+} //! namespace cv
+} //! namespace ppl
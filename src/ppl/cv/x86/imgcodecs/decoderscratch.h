@@ -0,0 +1,77 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef __ST_HPC_PPL_CV_X86_IMGCODECS_DECODER_SCRATCH_H_
+#define __ST_HPC_PPL_CV_X86_IMGCODECS_DECODER_SCRATCH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace ppl {
+namespace cv {
+namespace x86 {
+
+enum ScratchSlot {
+    READER_BLOCK           = 0,
+    JPEG_DECODE_DATA       = 1,
+    JPEG_COMPONENT_DATA    = 2,   // 4 slots, one for each component
+    JPEG_COEFFICIENTS      = 6,   // 4 slots, progressive only
+    JPEG_LINE_BUFFERS      = 10,  // 4 slots
+    JPEG_SCAN_BLOCKS       = 14,  // 4 slots, baseline only
+    JPEG_RESTART_INTERVALS = 18,  // baseline only
+    JPEG_REGION_ROW        = 19,
+    JPEG_UPRIGHT_BANDS     = 20,
+    JPEG_CHROMA_ROWS       = 21,
+    BMP_SOURCE_ROW         = 22,
+    PNG_PALETTE            = 23,
+    IMAGE_BUFFER           = 24,
+    RESIZE_BUFFERS         = 25,
+    SCRATCH_SLOTS          = 26,
+};
+
+/* Working memory of the decoders, kept in slots which only grow. Decoders take
+ * all their buffers from here and never free them, so an instance reused
+ * across images stops allocating once it has seen the largest one. The
+ * content of a slot is not preserved when it grows.
+ */
+class DecoderScratch {
+  public:
+    DecoderScratch();
+    ~DecoderScratch();
+
+    void* reserve(uint32_t slot, size_t size);
+    size_t capacity(uint32_t slot) const;
+    void clear();
+    // threads a decoder may spread one image over, 0 leaves it to the decoder.
+    void setThreads(uint32_t threads);
+    uint32_t threads() const;
+
+  private:
+    DecoderScratch(const DecoderScratch&);
+    DecoderScratch& operator=(const DecoderScratch&);
+
+  private:
+    void* buffers_[SCRATCH_SLOTS];
+    size_t sizes_[SCRATCH_SLOTS];
+    uint32_t threads_;
+};
+
+} //! namespace x86
+} //! namespace cv
+} //! namespace ppl
+
+#endif //! __ST_HPC_PPL_CV_X86_IMGCODECS_DECODER_SCRATCH_H_
@@ -0,0 +1,918 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "deflate.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <immintrin.h>
+#include <algorithm>
+
+#include "ppl/common/log.h"
+
+namespace ppl {
+namespace cv {
+namespace x86 {
+
+#define ADLER_BASE 65521
+#define ADLER_MAX_BLOCKS 347  // 16 byte blocks keeping s2 within 32 bits.
+#define CODE_LENGTH_SYMBOLS 19
+#define MAX_CODE_LENGTH 15
+#define MAX_CODE_LENGTH_LENGTH 7
+#define MAX_STORED_LENGTH 65535
+#define FIXED_LENGTH_SYMBOLS 288  // 286 and 287 take part in the codes.
+#define FIXED_BLOCK 1
+#define DYNAMIC_BLOCK 2
+
+struct LevelConfig {
+    int32_t max_chain;
+    uint32_t nice_length;
+};
+
+// level 0 stores, level 1 looks for runs only.
+static const LevelConfig level_configs[10] = {
+    {0, 0}, {0, 0}, {1, 16}, {2, 32}, {4, 64}, {8, 128}, {16, 128},
+    {32, ZLIB_MAX_MATCH}, {128, ZLIB_MAX_MATCH}, {512, ZLIB_MAX_MATCH},
+};
+
+static const uint8_t code_length_order[CODE_LENGTH_SYMBOLS] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15,
+};
+
+static inline uint32_t highestBit(uint32_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 31 - __builtin_clz(value);
+#else
+    uint32_t bit = 0;
+    while (value >>= 1) {
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+static inline uint32_t lowestBit(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(value);
+#else
+    uint32_t bit = 0;
+    while ((value & 1) == 0) {
+        value >>= 1;
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+static inline uint32_t reverseBits(uint32_t code, uint32_t length) {
+    uint32_t reversed = 0;
+    for (uint32_t i = 0; i < length; i++) {
+        reversed = (reversed << 1) | (code & 1);
+        code >>= 1;
+    }
+
+    return reversed;
+}
+
+// canonical codes with the bits reversed, as deflate sends them from the
+// least significant bit.
+static void assignCodes(const uint8_t* lengths, int32_t count,
+                        uint16_t* codes) {
+    uint32_t length_counts[MAX_CODE_LENGTH + 1] = {0};
+    for (int32_t i = 0; i < count; i++) {
+        length_counts[lengths[i]]++;
+    }
+    length_counts[0] = 0;
+
+    uint32_t next_codes[MAX_CODE_LENGTH + 1];
+    uint32_t code = 0;
+    next_codes[0] = 0;
+    for (int32_t i = 1; i <= MAX_CODE_LENGTH; i++) {
+        code = (code + length_counts[i - 1]) << 1;
+        next_codes[i] = code;
+    }
+
+    for (int32_t i = 0; i < count; i++) {
+        uint32_t length = lengths[i];
+        codes[i] = length ? reverseBits(next_codes[length]++, length) : 0;
+    }
+}
+
+// symbols of the lengths 3 ~ 258 and the codes of the fixed Huffman block.
+struct StaticTables {
+    uint16_t length_symbols[256];
+    uint8_t length_extra_bits[256];
+    uint8_t fixed_literal_lengths[FIXED_LENGTH_SYMBOLS];
+    uint16_t fixed_literal_codes[FIXED_LENGTH_SYMBOLS];
+    uint8_t fixed_distance_lengths[ZLIB_DISTANCE_SYMBOLS];
+    uint16_t fixed_distance_codes[ZLIB_DISTANCE_SYMBOLS];
+
+    StaticTables() {
+        for (uint32_t i = 0; i < 256; i++) {
+            if (i < 8) {
+                length_symbols[i] = 257 + i;
+                length_extra_bits[i] = 0;
+            }
+            else if (i == 255) {
+                length_symbols[i] = 285;
+                length_extra_bits[i] = 0;
+            }
+            else {
+                uint32_t bit = highestBit(i);
+                length_symbols[i] = 257 + 4 * (bit - 1) + ((i >> (bit - 2)) & 3);
+                length_extra_bits[i] = bit - 2;
+            }
+        }
+
+        for (int32_t i = 0; i < FIXED_LENGTH_SYMBOLS; i++) {
+            fixed_literal_lengths[i] = i < 144 ? 8 : i < 256 ? 9 :
+                                       i < 280 ? 7 : 8;
+        }
+        for (int32_t i = 0; i < ZLIB_DISTANCE_SYMBOLS; i++) {
+            fixed_distance_lengths[i] = 5;
+        }
+        assignCodes(fixed_literal_lengths, FIXED_LENGTH_SYMBOLS,
+                    fixed_literal_codes);
+        assignCodes(fixed_distance_lengths, ZLIB_DISTANCE_SYMBOLS,
+                    fixed_distance_codes);
+    }
+};
+
+static const StaticTables static_tables;
+
+static inline void getDistanceSymbol(uint32_t distance, uint32_t* symbol,
+                                     uint32_t* extra_bits) {
+    uint32_t value = distance - 1;
+    if (value < 4) {
+        *symbol = value;
+        *extra_bits = 0;
+    }
+    else {
+        uint32_t bit = highestBit(value);
+        *symbol = 2 * bit + ((value >> (bit - 1)) & 1);
+        *extra_bits = bit - 1;
+    }
+}
+
+static inline uint32_t getMatchLength(const uint8_t* data, const uint8_t* match,
+                                      uint32_t max_length) {
+    uint32_t length = 0;
+    while (length + 8 <= max_length) {
+        uint64_t value0, value1;
+        memcpy(&value0, data + length, 8);
+        memcpy(&value1, match + length, 8);
+        uint64_t difference = value0 ^ value1;
+        if (difference) {
+            return length + (lowestBit(difference) >> 3);
+        }
+        length += 8;
+    }
+    while (length < max_length && data[length] == match[length]) {
+        length++;
+    }
+
+    return length;
+}
+
+static inline uint32_t hashBytes(const uint8_t* data) {
+    uint32_t value;
+    memcpy(&value, data, 4);
+
+    return (value * 2654435761u) >> (32 - ZLIB_HASH_BITS);
+}
+
+/* 16 bytes a step, s1 gains their sum from _mm_sad_epu8() and s2 their sum
+ * weighted by 16 ~ 1 from _mm_maddubs_epi16(), plus 16 times s1 before the
+ * step, which is accumulated in vector_s1s and added at the end.
+ */
+uint32_t adler32(uint32_t adler, const uint8_t* data, size_t length) {
+    uint32_t s1 = adler & 0xFFFF;
+    uint32_t s2 = adler >> 16;
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i weights = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9, 8, 7,
+                                          6, 5, 4, 3, 2, 1);
+    while (length >= 16) {
+        size_t blocks = length >> 4;
+        blocks = blocks < ADLER_MAX_BLOCKS ? blocks : ADLER_MAX_BLOCKS;
+        length -= blocks << 4;
+        s2 += s1 * (uint32_t)(blocks << 4);
+
+        __m128i vector_s1  = zero;
+        __m128i vector_s2  = zero;
+        __m128i vector_s1s = zero;
+        do {
+            __m128i bytes = _mm_loadu_si128((const __m128i*)data);
+            vector_s1s = _mm_add_epi32(vector_s1s, vector_s1);
+            vector_s1  = _mm_add_epi32(vector_s1, _mm_sad_epu8(bytes, zero));
+            __m128i products = _mm_maddubs_epi16(bytes, weights);
+            vector_s2 = _mm_add_epi32(vector_s2, _mm_madd_epi16(products, ones));
+            data += 16;
+        } while (--blocks);
+        vector_s2 = _mm_add_epi32(vector_s2, _mm_slli_epi32(vector_s1s, 4));
+
+        vector_s1 = _mm_add_epi32(vector_s1, _mm_srli_si128(vector_s1, 8));
+        vector_s2 = _mm_add_epi32(vector_s2, _mm_srli_si128(vector_s2, 8));
+        vector_s2 = _mm_add_epi32(vector_s2, _mm_srli_si128(vector_s2, 4));
+        s1 += (uint32_t)_mm_cvtsi128_si32(vector_s1);
+        s2 += (uint32_t)_mm_cvtsi128_si32(vector_s2);
+        s1 %= ADLER_BASE;
+        s2 %= ADLER_BASE;
+    }
+    while (length--) {
+        s1 += *data++;
+        s2 += s1;
+    }
+    s1 %= ADLER_BASE;
+    s2 %= ADLER_BASE;
+
+    return (s2 << 16) | s1;
+}
+
+ZlibEncoder::ZlibEncoder(int32_t level, int32_t strategy) {
+    level_ = level < 0 ? 0 : level > 9 ? 9 : level;
+    strategy_ = strategy;
+    max_chain_ = level_configs[level_].max_chain;
+    nice_length_ = level_configs[level_].nice_length;
+    // matches shorter than 6 are dropped for filtered data as zlib does.
+    min_match_ = strategy_ == ZLIB_FILTERED ? 6 : ZLIB_MIN_MATCH + 1;
+    window_ = nullptr;
+    head_ = nullptr;
+    previous_ = nullptr;
+    tokens_ = nullptr;
+    token_count_ = 0;
+    block_start_ = 0;
+    data_end_ = 0;
+    adler_ = 1;
+    header_written_ = false;
+    code_length_count_ = 0;
+    output_ = nullptr;
+    bit_buffer_ = 0;
+    bit_count_ = 0;
+}
+
+ZlibEncoder::~ZlibEncoder() {
+    free(window_);
+    free(head_);
+    free(previous_);
+    free(tokens_);
+}
+
+bool ZlibEncoder::initialize() {
+    // 8 bytes behind the data are read by the comparison of matches.
+    window_ = (uint8_t*)malloc(ZLIB_WINDOW_SIZE + ZLIB_BLOCK_SIZE + 8);
+    if (window_ == nullptr) {
+        LOG(ERROR) << "failed to allocate the window of the zlib encoder.";
+        return false;
+    }
+    memset(window_ + ZLIB_WINDOW_SIZE + ZLIB_BLOCK_SIZE, 0, 8);
+    if (level_ == 0) {
+        return true;
+    }
+
+    tokens_ = (uint32_t*)malloc(ZLIB_BLOCK_SIZE * sizeof(uint32_t));
+    if (tokens_ == nullptr) {
+        LOG(ERROR) << "failed to allocate the tokens of the zlib encoder.";
+        return false;
+    }
+    if (max_chain_ == 0 || strategy_ == ZLIB_HUFFMAN_ONLY ||
+        strategy_ == ZLIB_RLE) {
+        return true;
+    }
+
+    head_ = (int32_t*)malloc((1 << ZLIB_HASH_BITS) * sizeof(int32_t));
+    previous_ = (int32_t*)malloc(ZLIB_WINDOW_SIZE * sizeof(int32_t));
+    if (head_ == nullptr || previous_ == nullptr) {
+        LOG(ERROR) << "failed to allocate the hash chains of the zlib encoder.";
+        return false;
+    }
+    for (int32_t i = 0; i < (1 << ZLIB_HASH_BITS); i++) {
+        head_[i] = -1;
+    }
+    for (int32_t i = 0; i < ZLIB_WINDOW_SIZE; i++) {
+        previous_[i] = -1;
+    }
+
+    return true;
+}
+
+// the zlib header, at most 5 bytes of stored block headers for each 64k
+// bytes, the padding of the final block and the adler-32 checksum.
+size_t ZlibEncoder::maxOutputSize() const {
+    return ZLIB_BLOCK_SIZE + (ZLIB_BLOCK_SIZE / MAX_STORED_LENGTH + 1) * 5 +
+           16;
+}
+
+uint32_t ZlibEncoder::write(const uint8_t* data, uint32_t size) {
+    uint32_t space = block_start_ + ZLIB_BLOCK_SIZE - data_end_;
+    uint32_t count = size < space ? size : space;
+    memcpy(window_ + data_end_, data, count);
+    data_end_ += count;
+
+    return count;
+}
+
+bool ZlibEncoder::isBlockFull() const {
+    return data_end_ - block_start_ == ZLIB_BLOCK_SIZE;
+}
+
+void ZlibEncoder::parseLiterals() {
+    const uint8_t* data = window_ + block_start_;
+    const uint8_t* end = window_ + data_end_;
+
+    // four tables break the dependency between the counts of equal bytes.
+    uint32_t counts[4][256];
+    memset(counts, 0, sizeof(counts));
+    while (data + 4 <= end) {
+        counts[0][data[0]]++;
+        counts[1][data[1]]++;
+        counts[2][data[2]]++;
+        counts[3][data[3]]++;
+        data += 4;
+    }
+    while (data < end) {
+        counts[0][*data++]++;
+    }
+    for (int32_t i = 0; i < 256; i++) {
+        literal_frequencies_[i] = counts[0][i] + counts[1][i] + counts[2][i] +
+                                  counts[3][i];
+    }
+}
+
+// matches only at the distance of 1, which are runs of a byte.
+void ZlibEncoder::parseRuns() {
+    const uint8_t* window = window_;
+    uint32_t* tokens = tokens_;
+    uint32_t count = 0;
+    uint32_t position = block_start_;
+    uint32_t end = data_end_;
+
+    if (position == 0 && position < end) {
+        tokens[count++] = window[0];
+        literal_frequencies_[window[0]]++;
+        position++;
+    }
+    while (position < end) {
+        uint32_t value = window[position];
+        if (value == window[position - 1]) {
+            uint32_t max_length = end - position;
+            max_length = max_length < ZLIB_MAX_MATCH ? max_length :
+                         ZLIB_MAX_MATCH;
+            uint32_t length = getMatchLength(window + position,
+                                             window + position - 1,
+                                             max_length);
+            if (length >= min_match_) {
+                tokens[count++] = (1 << 16) | length;
+                literal_frequencies_[static_tables.length_symbols[length - 3]]++;
+                distance_frequencies_[0]++;
+                position += length;
+                continue;
+            }
+        }
+        tokens[count++] = value;
+        literal_frequencies_[value]++;
+        position++;
+    }
+    token_count_ = count;
+}
+
+/* Greedy matching of 4 byte hashes. Level 2 checks only the latest position
+ * of a hash and does not hash the positions inside a match, higher levels
+ * follow the chains of earlier positions up to max_chain_ steps.
+ */
+void ZlibEncoder::parseMatches() {
+    const uint8_t* window = window_;
+    int32_t* head = head_;
+    int32_t* previous = previous_;
+    uint32_t* tokens = tokens_;
+    uint32_t count = 0;
+    uint32_t position = block_start_;
+    uint32_t end = data_end_;
+    uint32_t hash_end = end > 3 ? end - 3 : 0;
+    bool hash_all = max_chain_ > 1;
+
+    while (position < hash_end) {
+        const uint8_t* data = window + position;
+        uint32_t hash = hashBytes(data);
+        int32_t candidate = head[hash];
+        head[hash] = position;
+        previous[position & ZLIB_WINDOW_MASK] = candidate;
+
+        int32_t limit = (int32_t)position - ZLIB_WINDOW_SIZE;
+        limit = limit > -1 ? limit : -1;
+        uint32_t max_length = end - position;
+        max_length = max_length < ZLIB_MAX_MATCH ? max_length : ZLIB_MAX_MATCH;
+        uint32_t best_length = 0;
+        uint32_t best_distance = 0;
+        int32_t chain = max_chain_;
+        while (candidate > limit) {
+            const uint8_t* match = window + candidate;
+            if (match[best_length] == data[best_length]) {
+                uint32_t length = getMatchLength(data, match, max_length);
+                if (length > best_length) {
+                    best_length = length;
+                    best_distance = position - candidate;
+                    if (length >= nice_length_ || length == max_length) {
+                        break;
+                    }
+                }
+            }
+            if (--chain == 0) {
+                break;
+            }
+            candidate = previous[candidate & ZLIB_WINDOW_MASK];
+        }
+
+        if (best_length >= min_match_) {
+            uint32_t symbol, extra_bits;
+            getDistanceSymbol(best_distance, &symbol, &extra_bits);
+            tokens[count++] = (best_distance << 16) | best_length;
+            literal_frequencies_[static_tables.length_symbols[best_length - 3]]++;
+            distance_frequencies_[symbol]++;
+
+            uint32_t match_end = position + best_length;
+            if (hash_all) {
+                uint32_t last = match_end < hash_end ? match_end : hash_end;
+                for (position++; position < last; position++) {
+                    hash = hashBytes(window + position);
+                    previous[position & ZLIB_WINDOW_MASK] = head[hash];
+                    head[hash] = position;
+                }
+            }
+            position = match_end;
+        }
+        else {
+            tokens[count++] = data[0];
+            literal_frequencies_[data[0]]++;
+            position++;
+        }
+    }
+    while (position < end) {
+        tokens[count++] = window[position];
+        literal_frequencies_[window[position]]++;
+        position++;
+    }
+    token_count_ = count;
+}
+
+/* Huffman code lengths limited to max_length. The tree is built over the
+ * used symbols sorted by frequency with two queues, the leaves and the inner
+ * nodes, which come out in increasing weight. Lengths beyond max_length are
+ * cut and the code is made complete again by splitting the shortest leaves,
+ * the lengths are then handed out again from the least frequent symbol.
+ */
+void ZlibEncoder::buildCodes(const uint32_t* frequencies, int32_t count,
+                             int32_t max_length, uint8_t* lengths,
+                             uint16_t* codes) {
+    uint16_t symbols[ZLIB_LENGTH_SYMBOLS];
+    int32_t used = 0;
+    for (int32_t i = 0; i < count; i++) {
+        lengths[i] = 0;
+        if (frequencies[i]) {
+            symbols[used++] = i;
+        }
+    }
+    if (used == 1) {
+        lengths[symbols[0]] = 1;
+    }
+    if (used <= 1) {
+        assignCodes(lengths, count, codes);
+        return;
+    }
+
+    std::sort(symbols, symbols + used, [frequencies](uint16_t a, uint16_t b) {
+        return frequencies[a] < frequencies[b] ||
+               (frequencies[a] == frequencies[b] && a < b);
+    });
+
+    uint32_t weights[ZLIB_LENGTH_SYMBOLS * 2];
+    int32_t parents[ZLIB_LENGTH_SYMBOLS * 2];
+    for (int32_t i = 0; i < used; i++) {
+        weights[i] = frequencies[symbols[i]];
+    }
+    int32_t leaf = 0, node = used;
+    int32_t root = 2 * used - 2;
+    for (int32_t i = used; i <= root; i++) {
+        int32_t children[2];
+        for (int32_t j = 0; j < 2; j++) {
+            if (leaf < used && (node >= i || weights[leaf] <= weights[node])) {
+                children[j] = leaf++;
+            }
+            else {
+                children[j] = node++;
+            }
+        }
+        weights[i] = weights[children[0]] + weights[children[1]];
+        parents[children[0]] = i;
+        parents[children[1]] = i;
+    }
+
+    // depths in place of the weights, parents always come after children.
+    uint32_t length_counts[MAX_CODE_LENGTH + 2] = {0};
+    weights[root] = 0;
+    for (int32_t i = root - 1; i >= 0; i--) {
+        weights[i] = weights[parents[i]] + 1;
+        if (i < used) {
+            uint32_t depth = weights[i];
+            length_counts[depth < (uint32_t)max_length ? depth : max_length]++;
+        }
+    }
+
+    uint32_t total = 0;
+    for (int32_t i = 1; i <= max_length; i++) {
+        total += length_counts[i] << (max_length - i);
+    }
+    while (total != (1u << max_length)) {
+        length_counts[max_length]--;
+        for (int32_t i = max_length - 1; i > 0; i--) {
+            if (length_counts[i]) {
+                length_counts[i]--;
+                length_counts[i + 1] += 2;
+                break;
+            }
+        }
+        total--;
+    }
+
+    int32_t index = 0;
+    for (int32_t i = max_length; i > 0; i--) {
+        for (uint32_t j = 0; j < length_counts[i]; j++) {
+            lengths[symbols[index++]] = i;
+        }
+    }
+    assignCodes(lengths, count, codes);
+}
+
+/* Run-length codes the literal/length and distance code lengths with the
+ * symbols 16 ~ 18, builds the code of the code lengths and returns the bits
+ * the header takes.
+ */
+uint64_t ZlibEncoder::countDynamicHeader(int32_t* literal_count,
+                                         int32_t* distance_count) {
+    int32_t literals = ZLIB_LENGTH_SYMBOLS;
+    while (literals > 257 && literal_lengths_[literals - 1] == 0) {
+        literals--;
+    }
+    int32_t distances = ZLIB_DISTANCE_SYMBOLS;
+    while (distances > 1 && distance_lengths_[distances - 1] == 0) {
+        distances--;
+    }
+    *literal_count = literals;
+    *distance_count = distances;
+
+    int32_t total = literals + distances;
+    memcpy(code_lengths_, literal_lengths_, literals);
+    memcpy(code_lengths_ + literals, distance_lengths_, distances);
+
+    uint32_t frequencies[CODE_LENGTH_SYMBOLS] = {0};
+    int32_t count = 0;
+    for (int32_t i = 0; i < total;) {
+        uint32_t value = code_lengths_[i];
+        int32_t run = 1;
+        while (i + run < total && code_lengths_[i + run] == value) {
+            run++;
+        }
+        i += run;
+
+        if (value == 0) {
+            while (run >= 11) {
+                int32_t length = run < 138 ? run : 138;
+                length_symbols_[count] = 18;
+                length_extras_[count++] = length - 11;
+                run -= length;
+            }
+            if (run >= 3) {
+                length_symbols_[count] = 17;
+                length_extras_[count++] = run - 3;
+                run = 0;
+            }
+        }
+        else {
+            length_symbols_[count] = value;
+            length_extras_[count++] = 0;
+            run--;
+            while (run >= 3) {
+                int32_t length = run < 6 ? run : 6;
+                length_symbols_[count] = 16;
+                length_extras_[count++] = length - 3;
+                run -= length;
+            }
+        }
+        while (run-- > 0) {
+            length_symbols_[count] = value;
+            length_extras_[count++] = 0;
+        }
+    }
+    length_symbol_count_ = count;
+    for (int32_t i = 0; i < count; i++) {
+        frequencies[length_symbols_[i]]++;
+    }
+
+    buildCodes(frequencies, CODE_LENGTH_SYMBOLS, MAX_CODE_LENGTH_LENGTH,
+               code_length_lengths_, code_length_codes_);
+    int32_t lengths = CODE_LENGTH_SYMBOLS;
+    while (lengths > 4 &&
+           code_length_lengths_[code_length_order[lengths - 1]] == 0) {
+        lengths--;
+    }
+    code_length_count_ = lengths;
+
+    uint64_t bits = 5 + 5 + 4 + 3 * lengths;
+    for (int32_t i = 0; i < CODE_LENGTH_SYMBOLS; i++) {
+        bits += (uint64_t)frequencies[i] * code_length_lengths_[i];
+    }
+    bits += frequencies[16] * 2 + frequencies[17] * 3 + frequencies[18] * 7;
+
+    return bits;
+}
+
+// at most 32 bits are added to less than 32 bits kept in the buffer.
+inline void ZlibEncoder::putBits(uint64_t bits, uint32_t count) {
+    bit_buffer_ |= bits << bit_count_;
+    bit_count_ += count;
+    if (bit_count_ >= 32) {
+        uint32_t word = (uint32_t)bit_buffer_;
+        memcpy(output_, &word, 4);
+        output_ += 4;
+        bit_buffer_ >>= 32;
+        bit_count_ -= 32;
+    }
+}
+
+// pads the last byte with zeros.
+void ZlibEncoder::flushBits() {
+    while (bit_count_ > 0) {
+        *output_++ = (uint8_t)bit_buffer_;
+        bit_buffer_ >>= 8;
+        bit_count_ = bit_count_ > 8 ? bit_count_ - 8 : 0;
+    }
+    bit_buffer_ = 0;
+}
+
+void ZlibEncoder::putStoredBlock(bool is_final) {
+    const uint8_t* data = window_ + block_start_;
+    uint32_t remaining = data_end_ - block_start_;
+
+    do {
+        uint32_t length = remaining < MAX_STORED_LENGTH ? remaining :
+                          MAX_STORED_LENGTH;
+        remaining -= length;
+        putBits(is_final && remaining == 0 ? 1 : 0, 3);
+        flushBits();
+        output_[0] = (uint8_t)length;
+        output_[1] = (uint8_t)(length >> 8);
+        output_[2] = (uint8_t)~length;
+        output_[3] = (uint8_t)(~length >> 8);
+        memcpy(output_ + 4, data, length);
+        output_ += 4 + length;
+        data += length;
+    } while (remaining > 0);
+}
+
+void ZlibEncoder::putDynamicHeader(bool is_final, int32_t literal_count,
+                                   int32_t distance_count) {
+    putBits((is_final ? 1 : 0) | (DYNAMIC_BLOCK << 1), 3);
+    putBits(literal_count - 257, 5);
+    putBits(distance_count - 1, 5);
+    putBits(code_length_count_ - 4, 4);
+    for (int32_t i = 0; i < code_length_count_; i++) {
+        putBits(code_length_lengths_[code_length_order[i]], 3);
+    }
+
+    static const uint8_t extra_bits[3] = {2, 3, 7};
+    for (int32_t i = 0; i < length_symbol_count_; i++) {
+        uint32_t symbol = length_symbols_[i];
+        putBits(code_length_codes_[symbol], code_length_lengths_[symbol]);
+        if (symbol >= 16) {
+            putBits(length_extras_[i], extra_bits[symbol - 16]);
+        }
+    }
+}
+
+void ZlibEncoder::putSymbols(const uint8_t* literal_lengths,
+                             const uint16_t* literal_codes,
+                             const uint8_t* distance_lengths,
+                             const uint16_t* distance_codes) {
+    if (strategy_ == ZLIB_HUFFMAN_ONLY) {
+        // two literals of at most 15 bits each go together.
+        const uint8_t* data = window_ + block_start_;
+        const uint8_t* end = window_ + data_end_;
+        while (data + 2 <= end) {
+            uint32_t length0 = literal_lengths[data[0]];
+            uint64_t bits = literal_codes[data[0]] |
+                            ((uint64_t)literal_codes[data[1]] << length0);
+            putBits(bits, length0 + literal_lengths[data[1]]);
+            data += 2;
+        }
+        if (data < end) {
+            putBits(literal_codes[data[0]], literal_lengths[data[0]]);
+        }
+    }
+    else {
+        const uint32_t* tokens = tokens_;
+        for (uint32_t i = 0; i < token_count_; i++) {
+            uint32_t token = tokens[i];
+            if (token < (1 << 16)) {
+                putBits(literal_codes[token], literal_lengths[token]);
+                continue;
+            }
+
+            uint32_t length = (token & 0xFFFF) - 3;
+            uint32_t distance = token >> 16;
+            uint32_t symbol = static_tables.length_symbols[length];
+            uint32_t extra_bits = static_tables.length_extra_bits[length];
+            uint32_t code_length = literal_lengths[symbol];
+            uint64_t bits = literal_codes[symbol] |
+                            ((uint64_t)(length & ((1 << extra_bits) - 1)) <<
+                             code_length);
+            putBits(bits, code_length + extra_bits);
+
+            getDistanceSymbol(distance, &symbol, &extra_bits);
+            code_length = distance_lengths[symbol];
+            bits = distance_codes[symbol] |
+                   ((uint64_t)((distance - 1) & ((1 << extra_bits) - 1)) <<
+                    code_length);
+            putBits(bits, code_length + extra_bits);
+        }
+    }
+    putBits(literal_codes[256], literal_lengths[256]);
+}
+
+// keeps the last 32k bytes as the history of the next block.
+void ZlibEncoder::slideWindow() {
+    if (data_end_ <= ZLIB_WINDOW_SIZE) {
+        block_start_ = data_end_;
+        return;
+    }
+
+    uint32_t shift = data_end_ - ZLIB_WINDOW_SIZE;
+    assert((shift & ZLIB_WINDOW_MASK) == 0);
+    memmove(window_, window_ + shift, ZLIB_WINDOW_SIZE);
+    block_start_ = ZLIB_WINDOW_SIZE;
+    data_end_ = ZLIB_WINDOW_SIZE;
+
+    if (head_ != nullptr) {
+        for (int32_t i = 0; i < (1 << ZLIB_HASH_BITS); i++) {
+            int32_t position = head_[i] - (int32_t)shift;
+            head_[i] = position > -1 ? position : -1;
+        }
+        for (int32_t i = 0; i < ZLIB_WINDOW_SIZE; i++) {
+            int32_t position = previous_[i] - (int32_t)shift;
+            previous_[i] = position > -1 ? position : -1;
+        }
+    }
+}
+
+/* The block is parsed, then sent in the smallest of the three kinds of
+ * blocks. The costs count the bits of the block header, the code lengths of
+ * a dynamic block and the symbols with their extra bits.
+ */
+size_t ZlibEncoder::compressBlock(bool is_final, uint8_t* output) {
+    output_ = output;
+    if (!header_written_) {
+        uint32_t level_flag = level_ < 2 ? 0 : level_ < 6 ? 1 :
+                              level_ == 6 ? 2 : 3;
+        uint32_t flags = level_flag << 6;
+        flags += 31 - ((0x78 << 8) + flags) % 31;
+        putBits(0x78, 8);
+        putBits(flags, 8);
+        header_written_ = true;
+    }
+
+    uint32_t size = data_end_ - block_start_;
+    adler_ = adler32(adler_, window_ + block_start_, size);
+
+    if (level_ == 0) {
+        putStoredBlock(is_final);
+    }
+    else {
+        memset(literal_frequencies_, 0, sizeof(literal_frequencies_));
+        memset(distance_frequencies_, 0, sizeof(distance_frequencies_));
+        if (strategy_ == ZLIB_HUFFMAN_ONLY) {
+            parseLiterals();
+        }
+        else if (level_ == 1 || strategy_ == ZLIB_RLE) {
+            parseRuns();
+        }
+        else {
+            parseMatches();
+        }
+        literal_frequencies_[256] = 1;
+
+        uint64_t extra_bits = 0;
+        for (int32_t i = 265; i < 285; i++) {
+            extra_bits += (uint64_t)literal_frequencies_[i] * ((i - 261) >> 2);
+        }
+        for (int32_t i = 4; i < ZLIB_DISTANCE_SYMBOLS; i++) {
+            extra_bits += (uint64_t)distance_frequencies_[i] * ((i - 2) >> 1);
+        }
+
+        uint64_t fixed_bits = 3 + extra_bits;
+        for (int32_t i = 0; i < ZLIB_LENGTH_SYMBOLS; i++) {
+            fixed_bits += (uint64_t)literal_frequencies_[i] *
+                          static_tables.fixed_literal_lengths[i];
+        }
+        for (int32_t i = 0; i < ZLIB_DISTANCE_SYMBOLS; i++) {
+            fixed_bits += (uint64_t)distance_frequencies_[i] * 5;
+        }
+
+        // pieces after the first start on a byte boundary.
+        uint32_t pieces = (size + MAX_STORED_LENGTH - 1) / MAX_STORED_LENGTH;
+        pieces = pieces > 0 ? pieces : 1;
+        uint64_t stored_bits = (((bit_count_ + 3 + 7) & ~7) - bit_count_) +
+                               (uint64_t)(pieces - 1) * 8 + pieces * 32 +
+                               (uint64_t)size * 8;
+
+        uint64_t dynamic_bits = UINT64_MAX;
+        int32_t literal_count = 0, distance_count = 0;
+        if (strategy_ != ZLIB_FIXED) {
+            // decoders may reject codes with a single symbol.
+            for (int32_t i = 0; i < 2; i++) {
+                int32_t used = 0;
+                for (int32_t j = 0; j < ZLIB_DISTANCE_SYMBOLS; j++) {
+                    used += distance_frequencies_[j] > 0;
+                }
+                if (used < 2) {
+                    distance_frequencies_[distance_frequencies_[0] ? 1 : 0]++;
+                }
+            }
+            int32_t used = 0;
+            for (int32_t i = 0; i < ZLIB_LENGTH_SYMBOLS; i++) {
+                used += literal_frequencies_[i] > 0;
+            }
+            if (used < 2) {
+                literal_frequencies_[0]++;
+            }
+
+            buildCodes(literal_frequencies_, ZLIB_LENGTH_SYMBOLS,
+                       MAX_CODE_LENGTH, literal_lengths_, literal_codes_);
+            buildCodes(distance_frequencies_, ZLIB_DISTANCE_SYMBOLS,
+                       MAX_CODE_LENGTH, distance_lengths_, distance_codes_);
+            dynamic_bits = 3 + extra_bits +
+                           countDynamicHeader(&literal_count, &distance_count);
+            for (int32_t i = 0; i < ZLIB_LENGTH_SYMBOLS; i++) {
+                dynamic_bits += (uint64_t)literal_frequencies_[i] *
+                                literal_lengths_[i];
+            }
+            for (int32_t i = 0; i < ZLIB_DISTANCE_SYMBOLS; i++) {
+                dynamic_bits += (uint64_t)distance_frequencies_[i] *
+                                distance_lengths_[i];
+            }
+        }
+
+        if (stored_bits <= fixed_bits && stored_bits <= dynamic_bits) {
+            putStoredBlock(is_final);
+        }
+        else if (fixed_bits <= dynamic_bits) {
+            putBits((is_final ? 1 : 0) | (FIXED_BLOCK << 1), 3);
+            putSymbols(static_tables.fixed_literal_lengths,
+                       static_tables.fixed_literal_codes,
+                       static_tables.fixed_distance_lengths,
+                       static_tables.fixed_distance_codes);
+        }
+        else {
+            putDynamicHeader(is_final, literal_count, distance_count);
+            putSymbols(literal_lengths_, literal_codes_, distance_lengths_,
+                       distance_codes_);
+        }
+    }
+
+    if (is_final) {
+        flushBits();
+        output_[0] = (uint8_t)(adler_ >> 24);
+        output_[1] = (uint8_t)(adler_ >> 16);
+        output_[2] = (uint8_t)(adler_ >> 8);
+        output_[3] = (uint8_t)adler_;
+        output_ += 4;
+    }
+    else {
+        while (bit_count_ >= 8) {
+            *output_++ = (uint8_t)bit_buffer_;
+            bit_buffer_ >>= 8;
+            bit_count_ -= 8;
+        }
+        slideWindow();
+    }
+
+    return output_ - output;
+}
+
+} //! namespace x86
+} //! namespace cv
+} //! namespace ppl
@@ -0,0 +1,131 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef __ST_HPC_PPL_CV_X86_IMGCODECS_DEFLATE_H_
+#define __ST_HPC_PPL_CV_X86_IMGCODECS_DEFLATE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace ppl {
+namespace cv {
+namespace x86 {
+
+#define ZLIB_WINDOW_SIZE (1 << 15)
+#define ZLIB_WINDOW_MASK (ZLIB_WINDOW_SIZE - 1)
+#define ZLIB_BLOCK_SIZE (1 << 17)
+#define ZLIB_HASH_BITS 15
+#define ZLIB_MIN_MATCH 3
+#define ZLIB_MAX_MATCH 258
+#define ZLIB_LENGTH_SYMBOLS 286
+#define ZLIB_DISTANCE_SYMBOLS 30
+
+// the same values as those of zlib.
+enum ZlibStrategy {
+    ZLIB_DEFAULT_STRATEGY = 0,
+    ZLIB_FILTERED = 1,
+    ZLIB_HUFFMAN_ONLY = 2,
+    ZLIB_RLE = 3,
+    ZLIB_FIXED = 4,
+};
+
+uint32_t adler32(uint32_t adler, const uint8_t* data, size_t length);
+
+/* Compresses a zlib stream block by block. The input is appended to a window
+ * holding the last 32k bytes of the stream in front of the current block.
+ * Each block is parsed into literals and matches by the strategy of the level
+ * and sent as a stored, fixed or dynamic Huffman block, whichever is the
+ * smallest:
+ *   level 0, stored blocks only;
+ *   level 1, runs of a repeated byte only, the fastest level;
+ *   level 2 ~ 9, greedy hash matching, the chains followed growing with the
+ *   level.
+ * The strategy overrides the parsing as that of zlib does.
+ */
+class ZlibEncoder {
+  public:
+    ZlibEncoder(int32_t level, int32_t strategy);
+    ~ZlibEncoder();
+
+    bool initialize();
+    // the output of a block is no larger than this.
+    size_t maxOutputSize() const;
+    // appends at most size bytes to the block, returns the count taken.
+    uint32_t write(const uint8_t* data, uint32_t size);
+    bool isBlockFull() const;
+    // compresses the buffered input, returns the count of bytes in output.
+    size_t compressBlock(bool is_final, uint8_t* output);
+
+  private:
+    void parseLiterals();
+    void parseRuns();
+    void parseMatches();
+    void buildCodes(const uint32_t* frequencies, int32_t count,
+                    int32_t max_length, uint8_t* lengths, uint16_t* codes);
+    uint64_t countDynamicHeader(int32_t* literal_count,
+                                int32_t* distance_count);
+    void putBits(uint64_t bits, uint32_t count);
+    void flushBits();
+    void putStoredBlock(bool is_final);
+    void putDynamicHeader(bool is_final, int32_t literal_count,
+                          int32_t distance_count);
+    void putSymbols(const uint8_t* literal_lengths,
+                    const uint16_t* literal_codes,
+                    const uint8_t* distance_lengths,
+                    const uint16_t* distance_codes);
+    void slideWindow();
+
+  private:
+    int32_t level_;
+    int32_t strategy_;
+    int32_t max_chain_;
+    uint32_t nice_length_;
+    uint32_t min_match_;
+    uint8_t* window_;
+    int32_t* head_;
+    int32_t* previous_;
+    uint32_t* tokens_;
+    uint32_t token_count_;
+    uint32_t block_start_;
+    uint32_t data_end_;
+    uint32_t adler_;
+    bool header_written_;
+
+    uint32_t literal_frequencies_[ZLIB_LENGTH_SYMBOLS];
+    uint32_t distance_frequencies_[ZLIB_DISTANCE_SYMBOLS];
+    uint8_t literal_lengths_[ZLIB_LENGTH_SYMBOLS];
+    uint16_t literal_codes_[ZLIB_LENGTH_SYMBOLS];
+    uint8_t distance_lengths_[ZLIB_DISTANCE_SYMBOLS];
+    uint16_t distance_codes_[ZLIB_DISTANCE_SYMBOLS];
+    uint8_t code_lengths_[ZLIB_LENGTH_SYMBOLS + ZLIB_DISTANCE_SYMBOLS];
+    uint8_t length_symbols_[ZLIB_LENGTH_SYMBOLS + ZLIB_DISTANCE_SYMBOLS];
+    uint8_t length_extras_[ZLIB_LENGTH_SYMBOLS + ZLIB_DISTANCE_SYMBOLS];
+    int32_t length_symbol_count_;
+    uint8_t code_length_lengths_[19];
+    uint16_t code_length_codes_[19];
+    int32_t code_length_count_;
+
+    uint8_t* output_;
+    uint64_t bit_buffer_;
+    uint32_t bit_count_;
+};
+
+} //! namespace x86
+} //! namespace cv
+} //! namespace ppl
+
+#endif //! __ST_HPC_PPL_CV_X86_IMGCODECS_DEFLATE_H_
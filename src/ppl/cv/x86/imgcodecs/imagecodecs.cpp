@@ -21,18 +21,19 @@ namespace ppl {
 namespace cv {
 namespace x86 {
 
-ImageDecoder::ImageDecoder() : height_(0), width_(0), channels_(0), depth_(0) {
+ImageDecoder::ImageDecoder() : height_(0), width_(0), channels_(0), depth_(0),
+        transposed_(false) {
 }
 
 ImageDecoder::~ImageDecoder() {
 }
 
 uint32_t ImageDecoder::height() const {
-    return height_;
+    return transposed_ ? width_ : height_;
 }
 
 uint32_t ImageDecoder::width() const {
-    return width_;
+    return transposed_ ? height_ : width_;
 }
 
 uint32_t ImageDecoder::channels() const {
@@ -43,6 +44,36 @@ uint32_t ImageDecoder::depth() const {
     return depth_;
 }
 
+// formats without a reduced decoding keep their full size.
+void ImageDecoder::setScale(uint32_t denominator) {
+}
+
+// formats which can not decode a region alone are decoded whole and cropped.
+bool ImageDecoder::setRegion(uint32_t x, uint32_t y, uint32_t width,
+                             uint32_t height) {
+    return false;
+}
+
+// formats without an orientation tag are stored upright.
+void ImageDecoder::setUpright(bool upright) {
+}
+
+// other layouts are converted from the decoded image by the caller.
+bool ImageDecoder::setMode(ImreadModes mode) {
+    return mode == IMREAD_UNCHANGED;
+}
+
+// formats which can not hand out their rows are decoded whole by the caller.
+bool ImageDecoder::setRowConsumer(RowConsumer* consumer) {
+    return false;
+}
+
+ImageEncoder::ImageEncoder() {
+}
+
+ImageEncoder::~ImageEncoder() {
+}
+
 } //! namespace x86
 } //! namespace cv
 } //! namespace ppl
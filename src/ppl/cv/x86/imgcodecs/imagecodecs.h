@@ -24,6 +24,16 @@ namespace ppl {
 namespace cv {
 namespace x86 {
 
+/* Takes the rows of an image one at a time from the top, as a decoder
+ * produces them, so the whole image is never written out.
+ */
+class RowConsumer {
+  public:
+    virtual ~RowConsumer() {}
+
+    virtual void consumeRow(const uint8_t* row) = 0;
+};
+
 class ImageDecoder {
   public:
     ImageDecoder();
@@ -34,6 +44,12 @@ class ImageDecoder {
     uint32_t channels() const;
     uint32_t depth() const;
     virtual bool readHeader() = 0;
+    virtual void setScale(uint32_t denominator);
+    virtual bool setRegion(uint32_t x, uint32_t y, uint32_t width,
+                           uint32_t height);
+    virtual void setUpright(bool upright);
+    virtual bool setMode(ImreadModes mode);
+    virtual bool setRowConsumer(RowConsumer* consumer);
     virtual bool decodeData(uint32_t stride, uint8_t* image) = 0;
 
   protected:
@@ -41,6 +57,17 @@ class ImageDecoder {
     uint32_t width_;
     uint32_t channels_;
     uint32_t depth_;
+    bool transposed_;  // the upright image swaps the height and width.
+};
+
+class ImageEncoder {
+  public:
+    ImageEncoder();
+    virtual ~ImageEncoder();
+
+    virtual bool isChannelsSupported(uint32_t channels) const = 0;
+    virtual bool encodeData(uint32_t height, uint32_t width, uint32_t channels,
+                            uint32_t stride, const uint8_t* image) = 0;
 };
 
 } //! namespace x86
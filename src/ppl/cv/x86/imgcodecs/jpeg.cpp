@@ -20,10 +20,17 @@
 
 #include <memory.h>
 #include <immintrin.h>
+#include <algorithm>
+#include <memory>
 #include <thread>
 #include <vector>
 
+#include "ppl/cv/x86/flip.h"
+#include "ppl/cv/x86/rotate.h"
+#include "ppl/cv/x86/transpose.h"
 #include "ppl/cv/x86/intrinutils.hpp"
+#include "ppl/cv/x86/fma/internal_fma.hpp"
+#include "ppl/common/x86/sysinfo.h"
 #include "ppl/common/log.h"
 
 using namespace ppl::common;
@@ -33,7 +40,6 @@ namespace cv {
 namespace x86 {
 
 #define FLOAT2FLOAT(x) ((int32_t) (((x) * 4096 + 0.5)))
-#define FSH(x) ((x) * 4096)
 #define DIVIDE4(x) ((uint8_t) ((x) >> 2))
 #define DIVIDE16(x) ((uint8_t) ((x) >> 4))
 #define FLOAT2FIXED(x) (((int32_t) ((x) * 4096.0f + 0.5f)) << 8)
@@ -43,43 +49,6 @@ namespace x86 {
 #define ROTATE_BITS(x, y) (((x) << (y)) | ((x) >> ((BUFFER_BITS - (y)))))
 
 // derived from jidctint -- DCT_ISLOW
-#define IDCT_1D(s0, s1, s2, s3, s4, s5, s6, s7)                                \
-   int32_t t0, t1, t2, t3, p1, p2, p3, p4, p5, x0, x1, x2, x3;                 \
-   p2 = s2;                                                                    \
-   p3 = s6;                                                                    \
-   p1 = (p2 + p3) * FLOAT2FLOAT( 0.5411961f);                                  \
-   t2 = p1 + p3 * FLOAT2FLOAT(-1.847759065f);                                  \
-   t3 = p1 + p2 * FLOAT2FLOAT( 0.765366865f);                                  \
-   p2 = s0;                                                                    \
-   p3 = s4;                                                                    \
-   t0 = FSH(p2 + p3);                                                          \
-   t1 = FSH(p2 - p3);                                                          \
-   x0 = t0 + t3;                                                               \
-   x3 = t0 - t3;                                                               \
-   x1 = t1 + t2;                                                               \
-   x2 = t1 - t2;                                                               \
-   t0 = s7;                                                                    \
-   t1 = s5;                                                                    \
-   t2 = s3;                                                                    \
-   t3 = s1;                                                                    \
-   p3 = t0 + t2;                                                               \
-   p4 = t1 + t3;                                                               \
-   p1 = t0 + t3;                                                               \
-   p2 = t1 + t2;                                                               \
-   p5 = (p3 + p4) * FLOAT2FLOAT( 1.175875602f);                                \
-   t0 = t0 * FLOAT2FLOAT( 0.298631336f);                                       \
-   t1 = t1 * FLOAT2FLOAT( 2.053119869f);                                       \
-   t2 = t2 * FLOAT2FLOAT( 3.072711026f);                                       \
-   t3 = t3 * FLOAT2FLOAT( 1.501321110f);                                       \
-   p1 = p5 + p1 * FLOAT2FLOAT(-0.899976223f);                                  \
-   p2 = p5 + p2 * FLOAT2FLOAT(-2.562915447f);                                  \
-   p3 = p3 * FLOAT2FLOAT(-1.961570560f);                                       \
-   p4 = p4 * FLOAT2FLOAT(-0.390180644f);                                       \
-   t3 += p1 + p4;                                                              \
-   t2 += p2 + p3;                                                              \
-   t1 += p2 + p4;                                                              \
-   t0 += p1 + p3;
-
 static const uint8_t dezigzag_indices[64 + 15] = {
      0,  1,  8, 16,  9,  2,  3, 10,
     17, 24, 32, 25, 18, 11,  4,  5,
@@ -140,7 +109,7 @@ static uint8_t* resampleRowH2(uint8_t *out, uint8_t *in_near, uint8_t *in_far,
         out[i * 2 + 0] = DIVIDE4(n + input[i - 1]);
         out[i * 2 + 1] = DIVIDE4(n + input[i + 1]);
     }
-    out[i * 2 + 0] = DIVIDE4(input[width - 2] * 3 + input[width - 1] + 2);
+    out[i * 2 + 0] = DIVIDE4(input[width - 1] * 3 + input[width - 2] + 2);
     out[i * 2 + 1] = input[width - 1];
 
     return out;
@@ -168,7 +137,7 @@ static uint8_t* resampleRowHV2(uint8_t *out, uint8_t *in_near, uint8_t *in_far,
     uint8_t* src0 = in_near;
     uint8_t* src1 = in_far;
     uint8_t* dst = out + 1;
-    for (i = 0; i <= width - 16; i += 15) {
+    for (i = 0; i + 16 <= width; i += 15) {
         value_near = _mm_loadu_si128((__m128i const*)src0);
         value_far  = _mm_loadu_si128((__m128i const*)src1);
 
@@ -232,6 +201,7 @@ static uint8_t* resampleRowHV2(uint8_t *out, uint8_t *in_near, uint8_t *in_far,
         dst += 14;
     }
 
+    if (i == 0) i = 1;
     t1 = 3 * in_near[i - 1] + in_far[i - 1];
     for (; i < width; ++i) {
         t0 = t1;
@@ -276,7 +246,7 @@ static void RGB2YSSE(uint8_t* input0, uint8_t* input1, uint8_t* input2,
     __m128i packed29  = _mm_set_epi16(29, 29, 29, 29, 29, 29, 29, 29);
 
     uint32_t index = 0;
-    for (; index <= width - 32; index += 32) {
+    for (; index + 32 <= width; index += 32) {
         rs = _mm_loadu_si128((__m128i const*)input0);
         gs = _mm_loadu_si128((__m128i const*)input1);
         bs = _mm_loadu_si128((__m128i const*)input2);
@@ -369,7 +339,7 @@ void YCrCb2BGR::process8Elements(uint8_t const *y, uint8_t const *pcb,
 void YCrCb2BGR::convertBGR(uint8_t const *y, uint8_t const *pcb,
                            uint8_t const *pcr, uint8_t *dst) {
     uint32_t i = 0;
-    for (; i <= width_ - 32; i += 32, dst += channels_ * 32) {
+    for (; i + 32 <= width_; i += 32, dst += channels_ * 32) {
         process8Elements(y, pcb, pcr, i, b16s0_, g16s0_, r16s0_);
         process8Elements(y, pcb, pcr, i + 8, b16s1_, g16s1_, r16s1_);
         __m128i b8s0 = _mm_packus_epi16(b16s0_, b16s1_);
@@ -413,22 +383,44 @@ void YCrCb2BGR::convertBGR(uint8_t const *y, uint8_t const *pcb,
     }
 }
 
-JpegDecoder::JpegDecoder(BytesReader& file_data) {
+JpegDecoder::JpegDecoder(BytesReader& file_data, DecoderScratch& scratch) {
     file_data_ = &file_data;
+    scratch_ = &scratch;
 
-    jpeg_ = (JpegDecodeData*) malloc(sizeof(JpegDecodeData));
-    if (jpeg_ == nullptr) {
-       LOG(ERROR) << "No enough memory to initialize JpegDecoder.";
+    jpeg_ = (JpegDecodeData*)scratch_->reserve(JPEG_DECODE_DATA,
+                                               sizeof(JpegDecodeData));
+    if (jpeg_ != nullptr) {
+        jpeg_->marker = NULL_MARKER;
+        jpeg_->components = 0;
+    }
+    else {
+        LOG(ERROR) << "No enough memory to initialize JpegDecoder.";
     }
-    jpeg_->marker = NULL_MARKER;
 
     hardware_threads_ = std::thread::hardware_concurrency();
     hardware_threads_ = hardware_threads_ == 0 ? 1 : hardware_threads_;
+    if (scratch.threads() != 0 && scratch.threads() < hardware_threads_) {
+        hardware_threads_ = scratch.threads();
+    }
+    // the restart intervals go to every thread, the bands to 4 at most.
+    interval_threads_ = hardware_threads_;
     hardware_threads_ = hardware_threads_ > 4 ? 4 : hardware_threads_;
+    image_width_  = 0;
+    image_height_ = 0;
+    block_size_   = 8;
+    intervals_ = nullptr;
+    interval_count_ = 0;
+    region_x_ = region_y_ = 0;
+    region_width_ = region_height_ = 0;
+    upright_ = false;
+    upright_bands_ = nullptr;
+    mode_ = IMREAD_UNCHANGED;
+    chroma_rows_ = nullptr;
+    consumer_ = nullptr;
+    consumer_row_ = nullptr;
 }
 
 JpegDecoder::~JpegDecoder() {
-   free(jpeg_);
 }
 
 bool JpegDecoder::parseAPP0(JpegDecodeData *jpeg) {
@@ -458,6 +450,71 @@ bool JpegDecoder::parseAPP0(JpegDecodeData *jpeg) {
     return true;
 }
 
+static inline uint32_t exifWord(const uint8_t* data, bool little_endian) {
+    return little_endian ? (data[0] | (data[1] << 8)) :
+                           ((data[0] << 8) | data[1]);
+}
+
+static inline uint32_t exifDWord(const uint8_t* data, bool little_endian) {
+    return little_endian ?
+           (exifWord(data, true) | (exifWord(data + 2, true) << 16)) :
+           ((exifWord(data, false) << 16) | exifWord(data + 2, false));
+}
+
+/* Reads the orientation tag out of the 0th IFD of an Exif segment. Other APP1
+ * segments such as XMP and the rest of the Exif data are skipped, a malformed
+ * Exif block only leaves the image unrotated.
+ */
+bool JpegDecoder::parseAPP1(JpegDecodeData *jpeg) {
+    uint32_t length = file_data_->getWordBigEndian();
+    if (length < 2) {
+        LOG(ERROR) << "Invalid length of Exif APP1 segment: " << length
+                   << ", correct value be not less than 2.";
+        return false;
+    }
+    length -= 2;
+
+    // {'E','x','i','f','\0','\0'} and a TIFF header of 8 bytes.
+    uint8_t tag[6] = {0x45, 0x78, 0x69, 0x66, 0x0, 0x0};
+    uint8_t header[14] = {0};
+    uint32_t consumed = 0;
+    if (length >= 14) {
+        file_data_->getBytes(header, 14);
+        consumed = 14;
+    }
+    bool little_endian = header[6] == 0x49 && header[7] == 0x49;  // "II"
+    bool big_endian    = header[6] == 0x4D && header[7] == 0x4D;  // "MM"
+    if (consumed == 14 && memcmp(header, tag, 6) == 0 &&
+        (little_endian || big_endian) &&
+        exifWord(header + 8, little_endian) == 42) {
+        // offsets are counted from the TIFF header.
+        uint32_t offset = exifDWord(header + 10, little_endian);
+        if (offset >= 8 && offset <= length - 8) {
+            file_data_->skipBytes(offset - 8);
+            consumed = offset + 6;
+            uint8_t entry[12];
+            file_data_->getBytes(entry, 2);
+            consumed += 2;
+            uint32_t count = exifWord(entry, little_endian);
+            for (uint32_t i = 0; i < count && consumed + 12 <= length; ++i) {
+                file_data_->getBytes(entry, 12);
+                consumed += 12;
+                uint32_t type = exifWord(entry + 2, little_endian);
+                if (exifWord(entry, little_endian) == 0x0112 && type == 3) {
+                    uint32_t value = exifWord(entry + 8, little_endian);
+                    if (value >= 1 && value <= 8) {
+                        jpeg->orientation = value;
+                    }
+                    break;
+                }
+            }
+        }
+    }
+    file_data_->skipBytes(length - consumed);
+
+    return true;
+}
+
 bool JpegDecoder::parseAPP14(JpegDecodeData *jpeg) {
     uint32_t length = file_data_->getWordBigEndian();
     if (length < 8) {
@@ -507,14 +564,16 @@ bool JpegDecoder::parseSOF(JpegDecodeData *jpeg) {
         return false;
     }
 
-    jpeg->components = file_data_->getByte();  // Gray(1), YCbCr/YIQ(3), CMYK(4)
-    channels_ = jpeg->components >= 3 ? 3 : 1;
-    if (jpeg->components != 1 && jpeg->components != 3 &&
-        jpeg->components != 4) {
-        LOG(ERROR) << "Invalid component count: " << jpeg->components
+    // Gray(1), YCbCr/YIQ(3), CMYK(4), checked before it bounds img_comp[].
+    int32_t components = file_data_->getByte();
+    if (components != 1 && components != 3 && components != 4) {
+        LOG(ERROR) << "Invalid component count: " << components
                    << ", correct value: 0(Gray), 3(YCbCr), 4(CMYK).";
         return false;
     }
+    jpeg->components = components;
+    channels_ = jpeg->components >= 3 ? 3 : 1;
+    depth_ = 8;
     if (height_ * width_ * jpeg->components > MAX_IMAGE_SIZE) {
         LOG(ERROR) << "the JPEG image is too large.";
         return false;
@@ -528,7 +587,6 @@ bool JpegDecoder::parseSOF(JpegDecodeData *jpeg) {
     uint32_t i = 0;
     for (; i < jpeg->components; i++) {
         jpeg->img_comp[i].data = nullptr;
-        jpeg->img_comp[i].line_buffer = nullptr;
     }
 
     jpeg->rgb = 0;
@@ -599,21 +657,123 @@ bool JpegDecoder::parseSOF(JpegDecodeData *jpeg) {
             (height_ * jpeg->img_comp[i].vsampling + v_max - 1) / v_max;
         jpeg->img_comp[i].w2 = jpeg->mcus_x * jpeg->img_comp[i].hsampling * 8;
         jpeg->img_comp[i].h2 = jpeg->mcus_y * jpeg->img_comp[i].vsampling * 8;
-        jpeg->img_comp[i].data =
-            (uint8_t*)malloc(jpeg->img_comp[i].w2 * jpeg->img_comp[i].h2 + 15);
+        jpeg->img_comp[i].coeff_w = jpeg->img_comp[i].w2 / 8;
+        jpeg->img_comp[i].coeff = nullptr;
+    }
+    image_width_  = width_;
+    image_height_ = height_;
+    scaleComponents(jpeg);
+
+    return true;
+}
+
+/* The image shrinks by 8 / block_size_, rounding up. As libjpeg does, a
+ * subsampled component is scaled up by a larger IDCT rather than by the
+ * upsampling where the sampling factors allow it, e.g. the chroma of a 4:2:0
+ * image decoded at 1/2 takes full 8x8 IDCTs and needs no upsampling.
+ */
+void JpegDecoder::scaleComponents(JpegDecodeData *jpeg) {
+    for (uint32_t i = 0; i < jpeg->components; ++i) {
+        uint32_t size = block_size_;
+        while (size < 8 &&
+               (jpeg->hsampling_max * block_size_) %
+               (jpeg->img_comp[i].hsampling * size * 2) == 0 &&
+               (jpeg->vsampling_max * block_size_) %
+               (jpeg->img_comp[i].vsampling * size * 2) == 0) {
+            size *= 2;
+        }
+        jpeg->img_comp[i].block_size = size;
+        jpeg->img_comp[i].out_y  = (jpeg->img_comp[i].y * size + 7) >> 3;
+        jpeg->img_comp[i].out_w2 = jpeg->img_comp[i].w2 * size >> 3;
+        jpeg->img_comp[i].out_h2 = jpeg->img_comp[i].h2 * size >> 3;
+    }
+}
+
+void JpegDecoder::setScale(uint32_t denominator) {
+    block_size_ = 8 / denominator;
+    width_  = (image_width_ + denominator - 1) / denominator;
+    height_ = (image_height_ + denominator - 1) / denominator;
+    scaleComponents(jpeg_);
+}
+
+bool JpegDecoder::setRegion(uint32_t x, uint32_t y, uint32_t width,
+                            uint32_t height) {
+    region_x_ = x;
+    region_y_ = y;
+    region_width_  = width;
+    region_height_ = height;
+
+    return true;
+}
+
+// orientations 5 ~ 8 turn the image a quarter, swapping its height and width.
+void JpegDecoder::setUpright(bool upright) {
+    upright_ = upright && jpeg_->orientation != 1;
+    transposed_ = upright_ && jpeg_->orientation >= 5;
+}
+
+/* The luma and the planes of YCbCr are taken as they are decoded, without
+ * the conversion to BGR. A gray output skips the chroma of YCbCr, I420 and
+ * NV12 are written out of YCbCr and gray images with the same sampling of
+ * both chroma, stored upright. The other images return false and are
+ * converted by the caller.
+ */
+bool JpegDecoder::setMode(ImreadModes mode) {
+    chooseComponents(jpeg_);
+    if (mode == IMREAD_UNCHANGED) {
+        return true;
+    }
+    if (jpeg_->components == 4) {
+        return false;
+    }
+    if (mode == IMREAD_I420 || mode == IMREAD_NV12) {
+        if (is_rgb_ || upright_) {
+            return false;
+        }
+        if (jpeg_->components == 3 &&
+            (jpeg_->img_comp[1].hsampling != jpeg_->img_comp[2].hsampling ||
+             jpeg_->img_comp[1].vsampling != jpeg_->img_comp[2].vsampling)) {
+            return false;
+        }
+    }
+    mode_ = mode;
+    channels_ = 1;
+
+    return true;
+}
+
+/* The rows are converted one at a time into a row buffer and handed to the
+ * consumer from the top, so the conversion runs on a single thread. The
+ * orientation and the other layouts are left to the caller.
+ */
+bool JpegDecoder::setRowConsumer(RowConsumer* consumer) {
+    if (upright_ || mode_ != IMREAD_UNCHANGED) {
+        return false;
+    }
+    consumer_ = consumer;
+
+    return true;
+}
+
+/* The component buffers are taken from the scratch when the data is decoded
+ * rather than in parseSOF(), so that reading the header alone touches nothing.
+ */
+bool JpegDecoder::allocateComponents(JpegDecodeData *jpeg) {
+    for (uint32_t i = 0; i < jpeg->components; ++i) {
+        jpeg->img_comp[i].data = (uint8_t*)scratch_->reserve(
+            JPEG_COMPONENT_DATA + i,
+            jpeg->img_comp[i].out_w2 * jpeg->img_comp[i].out_h2 + 15);
         if (jpeg->img_comp[i].data == nullptr) {
             freeComponents(jpeg, i + 1);
             LOG(ERROR) << "failed to allocate data buffer for component "
                        << jpeg->img_comp[i].id;
             return false;
         }
-        jpeg->img_comp[i].line_buffer = nullptr;
-        jpeg->img_comp[i].coeff = nullptr;
         if (jpeg->progressive) {
-            jpeg->img_comp[i].coeff_w = jpeg->img_comp[i].w2 / 8;
             size_t size = jpeg->img_comp[i].w2 * jpeg->img_comp[i].h2 *
                           sizeof(int16_t) + 15;
-            jpeg->img_comp[i].coeff = (int16_t*)malloc(size);
+            jpeg->img_comp[i].coeff =
+                (int16_t*)scratch_->reserve(JPEG_COEFFICIENTS + i, size);
             if (jpeg->img_comp[i].coeff == nullptr) {
                 freeComponents(jpeg, i + 1);
                 LOG(ERROR) << "failed to allocate coeff buffer for component "
@@ -812,9 +972,20 @@ bool JpegDecoder::parseDHT(JpegDecodeData *jpeg) {
 
         uint32_t symbol_counts[16], count = 0;
         for (uint32_t i = 0; i < 16; ++i) {
-            symbol_counts[i] = file_data_->getByte();
+            int32_t symbol_count = file_data_->getByte();
+            if (symbol_count < 0) {
+                LOG(ERROR) << "The DHT segment is truncated.";
+                return false;
+            }
+            symbol_counts[i] = symbol_count;
             count += symbol_counts[i];
         }
+        if (count > 256 || 17 + count > length) {
+            LOG(ERROR) << "Invalid DHT symbol count: " << count
+                       << ", valid value should be not more than 256 and "
+                       << "fit in the segment.";
+            return false;
+        }
 
         uint8_t *symbol;
         if (type == 0) {
@@ -895,9 +1066,7 @@ bool JpegDecoder::processOtherSegments(int32_t marker) {
         return false;
     }
 
-    file_data_->skipBytes(length - 2);
-
-    return true;
+    return file_data_->skipBytes(length - 2);
 }
 
 bool JpegDecoder::processSegments(JpegDecodeData *jpeg, uint8_t marker) {
@@ -908,8 +1077,7 @@ bool JpegDecoder::processSegments(JpegDecodeData *jpeg, uint8_t marker) {
             succeeded = parseAPP0(jpeg);
             break;
         case 0xE1:  // Exif, APP1
-            LOG(ERROR) << "EXIF JPEG is not supported.";
-            succeeded = false;
+            succeeded = parseAPP1(jpeg);
             break;
         case 0xEE:  // Adobe APP14
             succeeded = parseAPP14(jpeg);
@@ -942,20 +1110,11 @@ bool JpegDecoder::processSegments(JpegDecodeData *jpeg, uint8_t marker) {
     return succeeded;
 }
 
+// the buffers belong to the scratch, they are only detached here.
 void JpegDecoder::freeComponents(JpegDecodeData *jpeg, uint32_t ncomp) {
     for (uint32_t i = 0; i < ncomp; ++i) {
-        if (jpeg->img_comp[i].data) {
-            free(jpeg->img_comp[i].data);
-            jpeg->img_comp[i].data = nullptr;
-        }
-        if (jpeg->img_comp[i].coeff) {
-            free(jpeg->img_comp[i].coeff);
-            jpeg->img_comp[i].coeff = nullptr;
-        }
-        if (jpeg->img_comp[i].line_buffer) {
-            free(jpeg->img_comp[i].line_buffer);
-            jpeg->img_comp[i].line_buffer = nullptr;
-        }
+        jpeg->img_comp[i].data = nullptr;
+        jpeg->img_comp[i].coeff = nullptr;
     }
 }
 
@@ -973,45 +1132,69 @@ void JpegDecoder::resetJpegDecoder(JpegDecodeData *jpeg) {
     jpeg->marker = NULL_MARKER;
     jpeg->todo = jpeg->restart_interval ? jpeg->restart_interval : 0x7fffffff;
     jpeg->eob_run = 0;
+    jpeg->prefix_ff = false;
 }
 
 /* If there's a pending marker from the entropy stream, return that
  * otherwise, fetch from the stream and get a marker. if there's no
- * marker, return 0xff, which is never a valid marker value.
+ * marker or the data ends, return 0xff, which is never a valid marker value.
  */
 uint8_t JpegDecoder::getMarker(JpegDecodeData *jpeg) {
-    uint8_t marker;
     if (jpeg->marker != NULL_MARKER) {
-        marker = jpeg->marker;
+        uint8_t marker = jpeg->marker;
         jpeg->marker = NULL_MARKER;
         return marker;
     }
 
-    marker = file_data_->getByte();
-    if (marker != 0xFF) {
+    int32_t value = file_data_->getByte();
+    if (value != 0xFF) {
         LOG(ERROR) << "invalid segment identifier.";
         return NULL_MARKER;
     }
-    while (marker == 0xFF) {
-        marker = file_data_->getByte();
+    while (value == 0xFF) {
+        value = file_data_->getByte();
+    }
+    if (value < 0) {
+        LOG(ERROR) << "unexpected end of the file data.";
+        return NULL_MARKER;
     }
 
-    return marker;
+    return (uint8_t)value;
 }
 
-static bool global_prefix = false;
 static __m128i swap_index = _mm_set_epi8(15, 14, 13, 12, 11, 10, 9, 8,
                                          0, 1, 2, 3, 4, 5, 6, 7);
 
+// load the next 8 bytes of the entropy-coded data in big endian order, bytes
+// past the end of the input are read as 0.
+inline uint64_t loadBitstream(BytesReader* file_data) {
+    bool available = file_data->ensureValidSize(BUFFER_BYTES);
+    const uint8_t* current_data = file_data->getCurrentPosition();
+    __m128i value0;
+    if (available) {
+        value0 = _mm_loadl_epi64((__m128i const*)current_data);
+    }
+    else {
+        uint64_t tail = 0;
+        memcpy(&tail, current_data, file_data->getValidSize());
+        value0 = _mm_cvtsi64_si128(tail);
+    }
+    __m128i value1 = _mm_shuffle_epi8(value0, swap_index);
+
+    return _mm_extract_epi64(value1, 0);
+}
+
 inline void growBitBuffer(BytesReader* file_data, JpegDecodeData *jpeg) {
     uint64_t buffer;
     uint32_t valid_bytes = 0, invalid_bytes = 0;
-    bool prefix_ff = global_prefix;
+    bool prefix_ff = jpeg->prefix_ff;
 
-    uint8_t* current_data = file_data->getCurrentPosition();
-    __m128i value0 = _mm_lddqu_si128((__m128i const*)current_data);
-    __m128i value1 = _mm_shuffle_epi8(value0, swap_index);
-    buffer = _mm_extract_epi64(value1, 0);
+    // a truncated stream goes on with zero bits, there is nothing to skip.
+    if (!file_data->ensureValidSize(1)) {
+        jpeg->code_bits = BUFFER_BITS;
+        return;
+    }
+    buffer = loadBitstream(file_data);
 
     if ((!prefix_ff) && (buffer & 0xFF00000000000000) != 0xFF00000000000000 &&
                         (buffer & 0xFF000000000000) != 0xFF000000000000 &&
@@ -1030,7 +1213,8 @@ inline void growBitBuffer(BytesReader* file_data, JpegDecodeData *jpeg) {
             jpeg->code_bits -= (invalid_bytes << 3);
             valid_bytes -= invalid_bytes;
         }
-        file_data->skipBytes(valid_bytes);
+        file_data->skipBytes(std::min(valid_bytes,
+                                      file_data->getValidSize()));
     }
     else {
         uint32_t index = 0, processed_bytes = 0, ff00_index = 0;
@@ -1301,16 +1485,13 @@ inline void growBitBuffer(BytesReader* file_data, JpegDecodeData *jpeg) {
 
             if (processed_bytes == BUFFER_BYTES && index == 0) {
                 file_data->skipBytes(BUFFER_BYTES);
-                uint8_t* current_data = file_data->getCurrentPosition();
-                __m128i value0 = _mm_lddqu_si128((__m128i const*)current_data);
-                __m128i value1 = _mm_shuffle_epi8(value0, swap_index);
-                buffer = _mm_extract_epi64(value1, 0);
+                buffer = loadBitstream(file_data);
 
                 processed_bytes = 0;
             }
         } while (processed_bytes < BUFFER_BYTES);
 
-        global_prefix = prefix_ff;
+        jpeg->prefix_ff = prefix_ff;
         jpeg->code_buffer |= buffer >> jpeg->code_bits;
         jpeg->code_bits += (index) << 3;
         if (jpeg->code_bits > BUFFER_BITS) {
@@ -1321,7 +1502,8 @@ inline void growBitBuffer(BytesReader* file_data, JpegDecodeData *jpeg) {
                             invalid_bytes;
         }
         processed_bytes -= invalid_bytes;
-        file_data->skipBytes(processed_bytes);
+        file_data->skipBytes(std::min(processed_bytes,
+                                      file_data->getValidSize()));
     }
 }
 
@@ -1370,11 +1552,30 @@ inline int32_t extendReceive(JpegDecodeData *jpeg, BytesReader* file_data,
     return (int32_t)value;
 }
 
+/* At the end of a restart interval followed by more MCUs, the RSTn marker
+ * must come next. Only the padding bits of the interval are left in the bit
+ * buffer then, so filling it reaches the marker if it was not seen yet.
+ */
+bool JpegDecoder::restartDecoder(BytesReader *file_data,
+                                 JpegDecodeData *jpeg) {
+    if (jpeg->marker == NULL_MARKER) {
+        growBitBuffer(file_data, jpeg);
+    }
+    if (!DRI_RESTART(jpeg->marker)) {
+        LOG(ERROR) << "Missing restart marker at the end of an interval.";
+        return false;
+    }
+    resetJpegDecoder(jpeg);
+
+    return true;
+}
+
 // decode a jpeg huffman value(bit length) from the bitstream
-inline int32_t JpegDecoder::decodeHuffmanData(JpegDecodeData *jpeg,
+inline int32_t JpegDecoder::decodeHuffmanData(BytesReader *file_data,
+                                            JpegDecodeData *jpeg,
                                             HuffmanLookupTable *huffman_table) {
-    if (jpeg_->marker == NULL_MARKER && jpeg->code_bits < LOOKAHEAD_BITS) {
-        growBitBuffer(file_data_, jpeg);
+    if (jpeg->marker == NULL_MARKER && jpeg->code_bits < LOOKAHEAD_BITS) {
+        growBitBuffer(file_data, jpeg);
     }
 
     // look at the top LOOKAHEAD_BITS and fast indexed table to determine
@@ -1390,8 +1591,8 @@ inline int32_t JpegDecoder::decodeHuffmanData(JpegDecodeData *jpeg,
         return (value & 0xFF);
     }
 
-    if (jpeg_->marker == NULL_MARKER && jpeg->code_bits < MAX_BITS) {
-        growBitBuffer(file_data_, jpeg);
+    if (jpeg->marker == NULL_MARKER && jpeg->code_bits < MAX_BITS) {
+        growBitBuffer(file_data, jpeg);
     }
 
     bits = jpeg->code_buffer >> (BUFFER_BITS - MAX_BITS);
@@ -1415,41 +1616,41 @@ inline int32_t JpegDecoder::decodeHuffmanData(JpegDecodeData *jpeg,
 }
 
 // decode a 8x8 block from huffman encoding + zigzag ordering + dequantization.
-bool JpegDecoder::decodeBlock(JpegDecodeData *jpeg, int16_t decoded_data[64],
+bool JpegDecoder::decodeBlock(BytesReader *file_data, JpegDecodeData *jpeg,
+                              int16_t decoded_data[64],
                               HuffmanLookupTable *huffman_dc,
                               HuffmanLookupTable *huffman_ac,
-                              uint32_t component_id, uint16_t *dequant_table) {
+                              uint32_t component_id) {
     // decode DC component.
-    int32_t bit_length = decodeHuffmanData(jpeg, huffman_dc);
+    int32_t bit_length = decodeHuffmanData(file_data, jpeg, huffman_dc);
     if (bit_length < 0 || bit_length > 15) {
         LOG(ERROR) << "Invalid bit length of DC value from huffman decoding: "
                    << bit_length << ", valid value: 0-15.";
     }
 
     int32_t value = bit_length ?
-                    extendReceive(jpeg, file_data_, bit_length) : 0;
+                    extendReceive(jpeg, file_data, bit_length) : 0;
     int32_t dc_value = jpeg->img_comp[component_id].dc_pred + value;
     jpeg->img_comp[component_id].dc_pred = dc_value;
-    decoded_data[0] = (int16_t)(dc_value * dequant_table[0]);
+    decoded_data[0] = (int16_t)dc_value;
 
     // decode AC components.
     uint32_t combined_value, zeroes, zig_index, ac_index = 1;
     do {
         // combined_value: number of zero + bit length of incoming code of the
         // jpeg fixed encoding table.
-        combined_value = decodeHuffmanData(jpeg, huffman_ac);
+        combined_value = decodeHuffmanData(file_data, jpeg, huffman_ac);
         zeroes = combined_value >> 4;
         bit_length = combined_value & 15;
         if (bit_length == 0) {
-            if (zeroes != 0xF0) {
+            if (combined_value != 0xF0) {
                 break;  // end of block
             }
-            ac_index += 16;
+            ac_index += 16;  // zero run length, 16 zeroes
         } else {
             ac_index += zeroes;
             zig_index = dezigzag_indices[ac_index++];
-            value = extendReceive(jpeg, file_data_, bit_length) *
-                    dequant_table[zig_index];
+            value = extendReceive(jpeg, file_data, bit_length);
             decoded_data[zig_index] = (int16_t)value;
         }
     } while (ac_index < 64);
@@ -1457,79 +1658,385 @@ bool JpegDecoder::decodeBlock(JpegDecodeData *jpeg, int16_t decoded_data[64],
     return true;
 }
 
-void JpegDecoder::idctDecodeBlock(uint8_t *output, int32_t out_stride,
-                                  int16_t data[64]) {
-    int32_t i, val[64], *v = val;
-    uint8_t *o;
-    int16_t *d = data;
-    int32_t scaled = 65536 + (128 << 17);
-
-    // columns
-    for (i = 0; i < 8; ++i, ++d, ++v) {
-        // if all zeroes, shortcut -- this avoids dequantizing 0s and IDCTing.
-        if (d[8] == 0 && d[16] == 0 && d[24] == 0 && d[32] == 0 &&
-            d[40] == 0 && d[48] == 0 && d[56] == 0) {
-            //    no shortcut                 0     seconds
-            //    (1|2|3|4|5|6|7)==0          0     seconds
-            //    all separate               -0.047 seconds
-            //    1 && 2|3 && 4|5 && 6|7:    -0.047 seconds
-            int32_t dcterm = d[0] * 4;
-            v[0] = v[8] = v[16] = v[24] = v[32] = v[40] = v[48] = v[56] =
-                   dcterm;
+/* Goes over a block outside the decoded region. Only the DC prediction is
+ * kept, the AC coefficients are read and dropped.
+ */
+bool JpegDecoder::skipBlock(BytesReader *file_data, JpegDecodeData *jpeg,
+                            HuffmanLookupTable *huffman_dc,
+                            HuffmanLookupTable *huffman_ac,
+                            uint32_t component_id) {
+    int32_t bit_length = decodeHuffmanData(file_data, jpeg, huffman_dc);
+    if (bit_length < 0 || bit_length > 15) {
+        LOG(ERROR) << "Invalid bit length of DC value from huffman decoding: "
+                   << bit_length << ", valid value: 0-15.";
+        return false;
+    }
+    if (bit_length) {
+        jpeg->img_comp[component_id].dc_pred +=
+            extendReceive(jpeg, file_data, bit_length);
+    }
+
+    uint32_t combined_value, ac_index = 1;
+    do {
+        combined_value = decodeHuffmanData(file_data, jpeg, huffman_ac);
+        bit_length = combined_value & 15;
+        if (bit_length == 0) {
+            if (combined_value != 0xF0) {
+                break;  // end of block
+            }
+            ac_index += 16;
         } else {
-            IDCT_1D(d[0], d[8], d[16], d[24], d[32], d[40], d[48], d[56])
-            // constants scaled things up by 1<<12; let's bring them back
-            // down, but keep 2 extra bits of precision.
-            x0 += 512; x1 += 512; x2 += 512; x3 += 512;
-            v[ 0] = (x0 + t3) >> 10;
-            v[56] = (x0 - t3) >> 10;
-            v[ 8] = (x1 + t2) >> 10;
-            v[48] = (x1 - t2) >> 10;
-            v[16] = (x2 + t1) >> 10;
-            v[40] = (x2 - t1) >> 10;
-            v[24] = (x3 + t0) >> 10;
-            v[32] = (x3 - t0) >> 10;
-        }
-    }
-
-    for (i = 0, v = val, o = output; i < 8; ++i, v += 8, o += out_stride) {
-        // no fast case since the first 1D IDCT spread components out.
-        IDCT_1D(v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7])
-        // constants scaled things up by 1<<12, plus we had 1<<2 from first
-        // loop, plus horizontal and vertical each scale by sqrt(8) so together
-        // we've got an extra 1<<3, so 1<<17 total we need to remove.
-        // so we want to round that, which means adding 0.5 * 1<<17,
-        // aka 65536. Also, we'll end up with -128 to 127 that we want
-        // to encode as 0..255 by adding 128, so we'll add that before the shift
-        x0 += scaled;
-        x1 += scaled;
-        x2 += scaled;
-        x3 += scaled;
-        // tried computing the shifts into temps, or'ing the temps to see
-        // if any were out of range, but that was slower.
-        o[0] = clampInt8((x0 + t3) >> 17);
-        o[7] = clampInt8((x0 - t3) >> 17);
-        o[1] = clampInt8((x1 + t2) >> 17);
-        o[6] = clampInt8((x1 - t2) >> 17);
-        o[2] = clampInt8((x2 + t1) >> 17);
-        o[5] = clampInt8((x2 - t1) >> 17);
-        o[3] = clampInt8((x3 + t0) >> 17);
-        o[4] = clampInt8((x3 - t0) >> 17);
+            ac_index += (combined_value >> 4) + 1;
+            getBits(jpeg, file_data, bit_length);
+        }
+    } while (ac_index < 64);
+
+    return true;
+}
+
+/* The SIMD IDCT produces exactly the results of the jidctint-style integer
+ * IDCT: products with 12 bit fixed point constants, 2 extra bits of precision
+ * kept between the column and the row pass, rounding before each shift, and
+ * a final clamp to [0, 255]. The dequantization is fused into the loading of
+ * the coefficients, which is bit exact with multiplying them in int16_t.
+ */
+typedef struct {
+    __m128i low, high;
+} IdctInt32x8;
+
+static inline __m128i idctConstants(int16_t x, int16_t y) {
+    return _mm_setr_epi16(x, y, x, y, x, y, x, y);
+}
+
+// out0 = x * c0[even] + y * c0[odd], out1 = x * c1[even] + y * c1[odd].
+static inline void idctRotate(__m128i x, __m128i y, __m128i c0, __m128i c1,
+                              IdctInt32x8 &out0, IdctInt32x8 &out1) {
+    __m128i low  = _mm_unpacklo_epi16(x, y);
+    __m128i high = _mm_unpackhi_epi16(x, y);
+    out0.low  = _mm_madd_epi16(low, c0);
+    out0.high = _mm_madd_epi16(high, c0);
+    out1.low  = _mm_madd_epi16(low, c1);
+    out1.high = _mm_madd_epi16(high, c1);
+}
+
+// x << 12 in 32 bits.
+static inline IdctInt32x8 idctWiden(__m128i x) {
+    IdctInt32x8 out;
+    out.low  = _mm_srai_epi32(_mm_unpacklo_epi16(_mm_setzero_si128(), x), 4);
+    out.high = _mm_srai_epi32(_mm_unpackhi_epi16(_mm_setzero_si128(), x), 4);
+
+    return out;
+}
+
+static inline IdctInt32x8 idctAdd(const IdctInt32x8 &a, const IdctInt32x8 &b) {
+    IdctInt32x8 out;
+    out.low  = _mm_add_epi32(a.low, b.low);
+    out.high = _mm_add_epi32(a.high, b.high);
+
+    return out;
+}
+
+static inline IdctInt32x8 idctSub(const IdctInt32x8 &a, const IdctInt32x8 &b) {
+    IdctInt32x8 out;
+    out.low  = _mm_sub_epi32(a.low, b.low);
+    out.high = _mm_sub_epi32(a.high, b.high);
+
+    return out;
+}
+
+// out0 = (a + bias + b) >> shift, out1 = (a + bias - b) >> shift, in int16_t.
+template <int32_t shift>
+static inline void idctButterfly(const IdctInt32x8 &a, const IdctInt32x8 &b,
+                                 __m128i bias, __m128i &out0, __m128i &out1) {
+    __m128i biased_low  = _mm_add_epi32(a.low, bias);
+    __m128i biased_high = _mm_add_epi32(a.high, bias);
+    out0 = _mm_packs_epi32(
+               _mm_srai_epi32(_mm_add_epi32(biased_low, b.low), shift),
+               _mm_srai_epi32(_mm_add_epi32(biased_high, b.high), shift));
+    out1 = _mm_packs_epi32(
+               _mm_srai_epi32(_mm_sub_epi32(biased_low, b.low), shift),
+               _mm_srai_epi32(_mm_sub_epi32(biased_high, b.high), shift));
+}
+
+// 1D IDCT of the 8 columns held by rows[].
+template <int32_t shift>
+static inline void idctPass(__m128i rows[8], __m128i bias) {
+    const __m128i rotate0_0 = idctConstants(FLOAT2FLOAT(0.5411961f),
+        FLOAT2FLOAT(0.5411961f) + FLOAT2FLOAT(-1.847759065f));
+    const __m128i rotate0_1 = idctConstants(
+        FLOAT2FLOAT(0.5411961f) + FLOAT2FLOAT(0.765366865f),
+        FLOAT2FLOAT(0.5411961f));
+    const __m128i rotate1_0 = idctConstants(
+        FLOAT2FLOAT(1.175875602f) + FLOAT2FLOAT(-0.899976223f),
+        FLOAT2FLOAT(1.175875602f));
+    const __m128i rotate1_1 = idctConstants(FLOAT2FLOAT(1.175875602f),
+        FLOAT2FLOAT(1.175875602f) + FLOAT2FLOAT(-2.562915447f));
+    const __m128i rotate2_0 = idctConstants(
+        FLOAT2FLOAT(-1.961570560f) + FLOAT2FLOAT(0.298631336f),
+        FLOAT2FLOAT(-1.961570560f));
+    const __m128i rotate2_1 = idctConstants(FLOAT2FLOAT(-1.961570560f),
+        FLOAT2FLOAT(-1.961570560f) + FLOAT2FLOAT(3.072711026f));
+    const __m128i rotate3_0 = idctConstants(
+        FLOAT2FLOAT(-0.390180644f) + FLOAT2FLOAT(2.053119869f),
+        FLOAT2FLOAT(-0.390180644f));
+    const __m128i rotate3_1 = idctConstants(FLOAT2FLOAT(-0.390180644f),
+        FLOAT2FLOAT(-0.390180644f) + FLOAT2FLOAT(1.501321110f));
+
+    // even part
+    IdctInt32x8 t2, t3;
+    idctRotate(rows[2], rows[6], rotate0_0, rotate0_1, t2, t3);
+    IdctInt32x8 t0 = idctWiden(_mm_add_epi16(rows[0], rows[4]));
+    IdctInt32x8 t1 = idctWiden(_mm_sub_epi16(rows[0], rows[4]));
+    IdctInt32x8 x0 = idctAdd(t0, t3);
+    IdctInt32x8 x3 = idctSub(t0, t3);
+    IdctInt32x8 x1 = idctAdd(t1, t2);
+    IdctInt32x8 x2 = idctSub(t1, t2);
+
+    // odd part
+    IdctInt32x8 y0, y1, y2, y3, y4, y5;
+    idctRotate(rows[7], rows[3], rotate2_0, rotate2_1, y0, y2);
+    idctRotate(rows[5], rows[1], rotate3_0, rotate3_1, y1, y3);
+    idctRotate(_mm_add_epi16(rows[1], rows[7]), _mm_add_epi16(rows[3], rows[5]),
+               rotate1_0, rotate1_1, y4, y5);
+    IdctInt32x8 x4 = idctAdd(y0, y4);
+    IdctInt32x8 x5 = idctAdd(y1, y5);
+    IdctInt32x8 x6 = idctAdd(y2, y5);
+    IdctInt32x8 x7 = idctAdd(y3, y4);
+
+    idctButterfly<shift>(x0, x7, bias, rows[0], rows[7]);
+    idctButterfly<shift>(x1, x6, bias, rows[1], rows[6]);
+    idctButterfly<shift>(x2, x5, bias, rows[2], rows[5]);
+    idctButterfly<shift>(x3, x4, bias, rows[3], rows[4]);
+}
+
+static inline void interleave16(__m128i &a, __m128i &b) {
+    __m128i value = a;
+    a = _mm_unpacklo_epi16(a, b);
+    b = _mm_unpackhi_epi16(value, b);
+}
+
+static inline void interleave8(__m128i &a, __m128i &b) {
+    __m128i value = a;
+    a = _mm_unpacklo_epi8(a, b);
+    b = _mm_unpackhi_epi8(value, b);
+}
+
+void JpegDecoder::idctDecodeBlock(uint8_t *output, int32_t out_stride,
+                                  const int16_t data[64],
+                                  const uint16_t *dequant_table) {
+    __m128i rows[8];
+    for (int32_t i = 0; i < 8; ++i) {
+        rows[i] = _mm_mullo_epi16(
+            _mm_loadu_si128((__m128i const*)(data + i * 8)),
+            _mm_loadu_si128((__m128i const*)(dequant_table + i * 8)));
+    }
+
+    // columns, keeping 2 extra bits of precision.
+    idctPass<10>(rows, _mm_set1_epi32(512));
+
+    // transpose the 8x8 int16_t block.
+    interleave16(rows[0], rows[4]);
+    interleave16(rows[1], rows[5]);
+    interleave16(rows[2], rows[6]);
+    interleave16(rows[3], rows[7]);
+    interleave16(rows[0], rows[2]);
+    interleave16(rows[1], rows[3]);
+    interleave16(rows[4], rows[6]);
+    interleave16(rows[5], rows[7]);
+    interleave16(rows[0], rows[1]);
+    interleave16(rows[2], rows[3]);
+    interleave16(rows[4], rows[5]);
+    interleave16(rows[6], rows[7]);
+
+    // rows, removing the 1 << 17 scale with rounding and adding 128.
+    idctPass<17>(rows, _mm_set1_epi32(65536 + (128 << 17)));
+
+    // saturate to uint8_t and transpose back.
+    __m128i p0 = _mm_packus_epi16(rows[0], rows[1]);
+    __m128i p1 = _mm_packus_epi16(rows[2], rows[3]);
+    __m128i p2 = _mm_packus_epi16(rows[4], rows[5]);
+    __m128i p3 = _mm_packus_epi16(rows[6], rows[7]);
+    interleave8(p0, p2);
+    interleave8(p1, p3);
+    interleave8(p0, p1);
+    interleave8(p2, p3);
+    interleave8(p0, p2);
+    interleave8(p1, p3);
+
+    _mm_storel_epi64((__m128i*)output, p0);
+    output += out_stride;
+    _mm_storel_epi64((__m128i*)output, _mm_shuffle_epi32(p0, 0x4E));
+    output += out_stride;
+    _mm_storel_epi64((__m128i*)output, p2);
+    output += out_stride;
+    _mm_storel_epi64((__m128i*)output, _mm_shuffle_epi32(p2, 0x4E));
+    output += out_stride;
+    _mm_storel_epi64((__m128i*)output, p1);
+    output += out_stride;
+    _mm_storel_epi64((__m128i*)output, _mm_shuffle_epi32(p1, 0x4E));
+    output += out_stride;
+    _mm_storel_epi64((__m128i*)output, p3);
+    output += out_stride;
+    _mm_storel_epi64((__m128i*)output, _mm_shuffle_epi32(p3, 0x4E));
+}
+
+/* Reduced IDCTs of the scaled decoding, producing 4x4, 2x2 and 1x1 pixels
+ * straight from the coefficients of a block as in jidctred.c of libjpeg:
+ * 13 bit fixed point constants, 2 extra bits of precision kept between the
+ * column and the row pass.
+ */
+#define REDUCED_BITS 13
+#define PASS1_BITS 2
+#define FIX(x) ((int32_t)((x) * (1 << REDUCED_BITS) + 0.5))
+#define DESCALE(x, n) (((x) + (1 << ((n) - 1))) >> (n))
+
+static void idctReduced4x4(uint8_t *output, int32_t out_stride,
+                           const int16_t data[64],
+                           const uint16_t *dequant_table) {
+    int32_t workspace[8 * 4];
+    int32_t tmp0, tmp2, tmp10, tmp12, z1, z2, z3, z4;
+
+    // columns, column 4 is not used by the row pass.
+    for (int32_t i = 0; i < 8; ++i) {
+        if (i == 4) continue;
+        const int16_t *input = data + i;
+        const uint16_t *quant = dequant_table + i;
+        z1 = input[8 * 7] * quant[8 * 7];
+        z2 = input[8 * 5] * quant[8 * 5];
+        z3 = input[8 * 3] * quant[8 * 3];
+        z4 = input[8 * 1] * quant[8 * 1];
+
+        tmp0 = (input[0] * quant[0]) * (1 << (REDUCED_BITS + 1));
+        tmp2 = input[8 * 2] * quant[8 * 2] * FIX(1.847759065) -
+               input[8 * 6] * quant[8 * 6] * FIX(0.765366865);
+        tmp10 = tmp0 + tmp2;
+        tmp12 = tmp0 - tmp2;
+
+        tmp0 = z1 * -FIX(0.211164243) + z2 * FIX(1.451774981) +
+               z3 * -FIX(2.172734803) + z4 * FIX(1.061594337);
+        tmp2 = z1 * -FIX(0.509795579) + z2 * -FIX(0.601344887) +
+               z3 * FIX(0.899976223) + z4 * FIX(2.562915447);
+
+        const int32_t shift = REDUCED_BITS - PASS1_BITS + 1;
+        workspace[8 * 0 + i] = DESCALE(tmp10 + tmp2, shift);
+        workspace[8 * 3 + i] = DESCALE(tmp10 - tmp2, shift);
+        workspace[8 * 1 + i] = DESCALE(tmp12 + tmp0, shift);
+        workspace[8 * 2 + i] = DESCALE(tmp12 - tmp0, shift);
+    }
+
+    // rows, removing the scale and adding 128.
+    const int32_t shift = REDUCED_BITS + PASS1_BITS + 3 + 1;
+    for (int32_t i = 0; i < 4; ++i) {
+        const int32_t *row = workspace + 8 * i;
+        tmp0 = row[0] * (1 << (REDUCED_BITS + 1));
+        tmp2 = row[2] * FIX(1.847759065) - row[6] * FIX(0.765366865);
+        tmp10 = tmp0 + tmp2;
+        tmp12 = tmp0 - tmp2;
+
+        tmp0 = row[7] * -FIX(0.211164243) + row[5] * FIX(1.451774981) +
+               row[3] * -FIX(2.172734803) + row[1] * FIX(1.061594337);
+        tmp2 = row[7] * -FIX(0.509795579) + row[5] * -FIX(0.601344887) +
+               row[3] * FIX(0.899976223) + row[1] * FIX(2.562915447);
+
+        output[0] = clampInt8(DESCALE(tmp10 + tmp2, shift) + 128);
+        output[3] = clampInt8(DESCALE(tmp10 - tmp2, shift) + 128);
+        output[1] = clampInt8(DESCALE(tmp12 + tmp0, shift) + 128);
+        output[2] = clampInt8(DESCALE(tmp12 - tmp0, shift) + 128);
+        output += out_stride;
+    }
+}
+
+static void idctReduced2x2(uint8_t *output, int32_t out_stride,
+                           const int16_t data[64],
+                           const uint16_t *dequant_table) {
+    int32_t workspace[8 * 2];
+    int32_t tmp0, tmp10;
+
+    // columns, only the odd ones and column 0 are used by the row pass.
+    for (int32_t i = 0; i < 8; ++i) {
+        if (i == 2 || i == 4 || i == 6) continue;
+        const int16_t *input = data + i;
+        const uint16_t *quant = dequant_table + i;
+        tmp10 = (input[0] * quant[0]) * (1 << (REDUCED_BITS + 2));
+        tmp0 = input[8 * 7] * quant[8 * 7] * -FIX(0.720959822) +
+               input[8 * 5] * quant[8 * 5] * FIX(0.850430095) +
+               input[8 * 3] * quant[8 * 3] * -FIX(1.272758580) +
+               input[8 * 1] * quant[8 * 1] * FIX(3.624509785);
+
+        const int32_t shift = REDUCED_BITS - PASS1_BITS + 2;
+        workspace[8 * 0 + i] = DESCALE(tmp10 + tmp0, shift);
+        workspace[8 * 1 + i] = DESCALE(tmp10 - tmp0, shift);
+    }
+
+    const int32_t shift = REDUCED_BITS + PASS1_BITS + 3 + 2;
+    for (int32_t i = 0; i < 2; ++i) {
+        const int32_t *row = workspace + 8 * i;
+        tmp10 = row[0] * (1 << (REDUCED_BITS + 2));
+        tmp0 = row[7] * -FIX(0.720959822) + row[5] * FIX(0.850430095) +
+               row[3] * -FIX(1.272758580) + row[1] * FIX(3.624509785);
+
+        output[0] = clampInt8(DESCALE(tmp10 + tmp0, shift) + 128);
+        output[1] = clampInt8(DESCALE(tmp10 - tmp0, shift) + 128);
+        output += out_stride;
+    }
+}
+
+static void idctReduced1x1(uint8_t *output, const int16_t data[64],
+                           const uint16_t *dequant_table) {
+    output[0] = clampInt8(DESCALE(data[0] * dequant_table[0], 3) + 128);
+}
+
+// Transforms a row of consecutive blocks. AVX2 machines handle two blocks per
+// pass, the odd tail block goes through the SSE2 transform.
+void JpegDecoder::idctDecodeRow(uint8_t *output, int32_t out_stride,
+                                const int16_t *data, uint32_t blocks,
+                                const uint16_t *dequant_table,
+                                uint32_t block_size) {
+    if (block_size != 8) {
+        for (uint32_t j = 0; j < blocks; j++) {
+            if (block_size == 4) {
+                idctReduced4x4(output, out_stride, data, dequant_table);
+            }
+            else if (block_size == 2) {
+                idctReduced2x2(output, out_stride, data, dequant_table);
+            }
+            else {
+                idctReduced1x1(output, data, dequant_table);
+            }
+            data += 64;
+            output += block_size;
+        }
+        return;
+    }
+
+    uint32_t j = 0;
+    if (ppl::common::CpuSupports(ppl::common::ISA_X86_FMA)) {
+        for (; j + 2 <= blocks; j += 2) {
+            fma::idct_dequant_2blocks_u8(data, dequant_table, output,
+                                         out_stride);
+            data += 128;
+            output += 16;
+        }
+    }
+    for (; j < blocks; j++) {
+        idctDecodeBlock(output, out_stride, data, dequant_table);
+        data += 64;
+        output += 8;
     }
 }
 
 void JpegDecoder::idctprocess0(JpegDecodeData *jpeg, int16_t* buffer,
                                uint8_t* output, uint32_t height_begin,
                                uint32_t height_end, uint32_t width,
-                               uint32_t width2) {
+                               uint32_t width2,
+                               const uint16_t *dequant_table,
+                               uint32_t block_size) {
     buffer += height_begin * width * 64;
     for (uint32_t i = height_begin; i < height_end; i++) {
-        uint8_t* result = output + width2 * i * 8;
-        for (uint32_t j = 0; j < width; j++) {
-            idctDecodeBlock(result, width2, buffer);
-            buffer += 64;
-            result += 8;
-        }
+        uint8_t* result = output + width2 * i * block_size;
+        idctDecodeRow(result, width2, buffer, width, dequant_table,
+                      block_size);
+        buffer += width * 64;
     }
 }
 
@@ -1544,7 +2051,7 @@ bool JpegDecoder::decodeProgressiveDCBlock(JpegDecodeData *jpeg,
     }
 
     if (jpeg->succ_high == 0) {  // first scan for DC coefficient.
-        int32_t bit_length = decodeHuffmanData(jpeg, huffman_dc);
+        int32_t bit_length = decodeHuffmanData(file_data_, jpeg, huffman_dc);
         if (bit_length < 0 || bit_length > 15) {
             LOG(ERROR) << "Invalid bit length of DC value from huffman "
                        << "decoding: " << bit_length << ", valid value: 0-15.";
@@ -1585,7 +2092,7 @@ bool JpegDecoder::decodeProgressiveACBlock(JpegDecodeData *jpeg,
         int32_t zig_index, value;
         ac_index = jpeg->index_start;
         do {
-            combined_value = decodeHuffmanData(jpeg, huffman_ac);
+            combined_value = decodeHuffmanData(file_data_, jpeg, huffman_ac);
             zeroes = (combined_value >> 4) & 15;
             bit_length = combined_value & 15;
             if (bit_length == 0) {
@@ -1629,7 +2136,8 @@ bool JpegDecoder::decodeProgressiveACBlock(JpegDecodeData *jpeg,
         } else {
             ac_index = jpeg->index_start;
             do {
-                combined_value = decodeHuffmanData(jpeg, huffman_ac);
+                combined_value = decodeHuffmanData(file_data_, jpeg,
+                                                   huffman_ac);
                 zeroes = combined_value >> 4;
                 bit_length = combined_value & 15;
                 if (bit_length == 0) {
@@ -1696,30 +2204,42 @@ bool JpegDecoder::parseEntropyCodedData(JpegDecodeData *jpeg) {
             uint32_t height = (jpeg->img_comp[comp_id].y + 7) >> 3;
             uint32_t width  = (jpeg->img_comp[comp_id].x + 7) >> 3;
             size_t size = height * width * 64;
-            int16_t* buffer = new int16_t[size];
+            int16_t* buffer = (int16_t*)scratch_->reserve(JPEG_SCAN_BLOCKS,
+                                  size * sizeof(int16_t));
+            if (buffer == nullptr) return false;
             memset(buffer, 0, size * sizeof(int16_t));
             int16_t* data = buffer;
             huffman_dc = jpeg->huff_dc + jpeg->img_comp[comp_id].dc_id;
             huffman_ac = jpeg->huff_ac + jpeg->img_comp[comp_id].ac_id;
             dequant_table = jpeg->dequant[jpeg->img_comp[comp_id].quant_id];
+            bool skipped = comp_id >= decode_n_;
             for (uint32_t i = 0; i < height; ++i) {
                 for (uint32_t j = 0; j < width; ++j) {
-                    succeeded = decodeBlock(jpeg, data, huffman_dc, huffman_ac,
-                                            comp_id, dequant_table);
+                    succeeded = skipped ?
+                        skipBlock(file_data_, jpeg, huffman_dc, huffman_ac,
+                                  comp_id) :
+                        decodeBlock(file_data_, jpeg, data, huffman_dc,
+                                    huffman_ac, comp_id);
                     if (!succeeded) return false;
                     data += 64;
 
                     // every data block is an MCU, so countdown the restart
-                    // interval.
-                    if (--jpeg->todo <= 0) {
-                        if (!DRI_RESTART(jpeg->marker)) return false;
-                        resetJpegDecoder(jpeg);
+                    // interval. the scan ends after the last one.
+                    if (--jpeg->todo <= 0 &&
+                        (i + 1 < height || j + 1 < width)) {
+                        if (!restartDecoder(file_data_, jpeg)) return false;
                     }
                 }
             }
+            if (skipped) return true;
 
             uint8_t* output = jpeg->img_comp[comp_id].data;
-            uint32_t width2 = jpeg->img_comp[comp_id].w2;
+            uint32_t width2 = jpeg->img_comp[comp_id].out_w2;
+            if (hardware_threads_ == 1) {
+                idctprocess0(jpeg, buffer, output, 0, height, width, width2,
+                             dequant_table, jpeg->img_comp[comp_id].block_size);
+                return true;
+            }
             std::vector<std::thread> threads;
             uint32_t interval = (height + hardware_threads_ - 1) /
                                 hardware_threads_;
@@ -1729,21 +2249,25 @@ bool JpegDecoder::parseEntropyCodedData(JpegDecodeData *jpeg) {
                                      heigh_begin + interval : height;
                 threads.push_back(std::thread(&JpegDecoder::idctprocess0, this,
                                   jpeg, buffer, output, heigh_begin, heigh_end,
-                                  width, width2));
+                                  width, width2, dequant_table,
+                                  jpeg->img_comp[comp_id].block_size));
             }
 
             for (auto &worker: threads) {
                 worker.join();
             }
-            delete [] buffer;
 
             return true;
         } else {  // n components, interleaved data blocks in an mcu.
             uint32_t i, j, k, x, y;
-            int16_t** buffer = new int16_t*[jpeg->scan_n];
+            int16_t* buffer[4];
             for (i = 0; i < jpeg->scan_n; i++) {
-                size_t size = jpeg->img_comp[i].h2 * jpeg->img_comp[i].w2;
-                buffer[i] = new int16_t[size];
+                uint32_t comp_id = jpeg->order[i];
+                size_t size = jpeg->img_comp[comp_id].h2 *
+                              jpeg->img_comp[comp_id].w2;
+                buffer[i] = (int16_t*)scratch_->reserve(JPEG_SCAN_BLOCKS + i,
+                                size * sizeof(int16_t));
+                if (buffer[i] == nullptr) return false;
                 memset(buffer[i], 0, size * sizeof(int16_t));
             }
 
@@ -1757,8 +2281,6 @@ bool JpegDecoder::parseEntropyCodedData(JpegDecodeData *jpeg) {
                                      jpeg->img_comp[comp_id].dc_id;
                         huffman_ac = jpeg->huff_ac +
                                      jpeg->img_comp[comp_id].ac_id;
-                        dequant_table =
-                                jpeg->dequant[jpeg->img_comp[comp_id].quant_id];
                         int32_t mcu_width = jpeg->mcus_x *
                                             jpeg->img_comp[comp_id].hsampling;
                         int32_t y2 = i * jpeg->img_comp[comp_id].vsampling;
@@ -1766,8 +2288,12 @@ bool JpegDecoder::parseEntropyCodedData(JpegDecodeData *jpeg) {
                         for (y = 0; y < jpeg->img_comp[comp_id].vsampling; ++y) {
                             for (x = 0; x < jpeg->img_comp[comp_id].hsampling; ++x) {
                                 data_ptr = buffer[k] + ((y2 + y) * mcu_width + x2 + x) * 64;
-                                succeeded = decodeBlock(jpeg, data_ptr, huffman_dc,
-                                            huffman_ac, comp_id, dequant_table);
+                                succeeded = comp_id < decode_n_ ?
+                                    decodeBlock(file_data_, jpeg, data_ptr,
+                                                huffman_dc, huffman_ac,
+                                                comp_id) :
+                                    skipBlock(file_data_, jpeg, huffman_dc,
+                                              huffman_ac, comp_id);
                                 if (!succeeded) return false;
                             }
                         }
@@ -1775,19 +2301,27 @@ bool JpegDecoder::parseEntropyCodedData(JpegDecodeData *jpeg) {
 
                     // after all interleaved components, that's an interleaved MCU,
                     // so now count down the restart interval
-                    if (--jpeg->todo <= 0) {
-                        if (!DRI_RESTART(jpeg->marker)) return false;
-                        resetJpegDecoder(jpeg);
+                    if (--jpeg->todo <= 0 &&
+                        (i + 1 < jpeg->mcus_y || j + 1 < jpeg->mcus_x)) {
+                        if (!restartDecoder(file_data_, jpeg)) return false;
                     }
                 }
             }
 
             for (i = 0; i < jpeg->scan_n; i++) {
                 uint32_t comp_id = jpeg->order[i];
+                if (comp_id >= decode_n_) continue;
                 uint32_t height = jpeg->mcus_y * jpeg->img_comp[comp_id].vsampling;
                 uint32_t width  = jpeg->mcus_x * jpeg->img_comp[comp_id].hsampling;
                 uint8_t* output = jpeg->img_comp[comp_id].data;
-                uint32_t width2 = jpeg->img_comp[comp_id].w2;
+                uint32_t width2 = jpeg->img_comp[comp_id].out_w2;
+                dequant_table = jpeg->dequant[jpeg->img_comp[comp_id].quant_id];
+                if (hardware_threads_ == 1) {
+                    idctprocess0(jpeg, buffer[i], output, 0, height, width,
+                                 width2, dequant_table,
+                                 jpeg->img_comp[comp_id].block_size);
+                    continue;
+                }
                 std::vector<std::thread> threads;
                 uint32_t interval = (height + hardware_threads_ - 1) /
                                      hardware_threads_;
@@ -1797,7 +2331,9 @@ bool JpegDecoder::parseEntropyCodedData(JpegDecodeData *jpeg) {
                                          heigh_begin + interval : height;
                     threads.push_back(std::thread(&JpegDecoder::idctprocess0,
                                       this, jpeg, buffer[i], output,
-                                      heigh_begin, heigh_end, width, width2));
+                                      heigh_begin, heigh_end, width, width2,
+                                      dequant_table,
+                                      jpeg->img_comp[comp_id].block_size));
                 }
 
                 for (auto &worker: threads) {
@@ -1805,11 +2341,6 @@ bool JpegDecoder::parseEntropyCodedData(JpegDecodeData *jpeg) {
                 }
             }
 
-            for (i = 0; i < jpeg->scan_n; i++) {
-                delete [] buffer[i];
-            }
-            delete [] buffer;
-
             return true;
         }
     } else {  // progressive jpeg.
@@ -1886,42 +2417,532 @@ bool JpegDecoder::parseEntropyCodedData(JpegDecodeData *jpeg) {
     }
 }
 
-// data[i] *= dequant_table[i]
-void JpegDecoder::dequantizeData(int16_t *data, uint16_t *dequant_table) {
-    for (int32_t i = 0; i < 8; ++i) {
-        __m128i input  = _mm_lddqu_si128((__m128i const*)data);
-        __m128i coeffs = _mm_lddqu_si128((__m128i const*)dequant_table);
-        __m128i output = _mm_mullo_epi16(input, coeffs);
-        _mm_storeu_si128((__m128i*)data, output);
-        data += 8;
-        dequant_table += 8;
+/* A baseline scan holding every component is decoded one MCU row at a time:
+ * the blocks of the row are entropy decoded, transformed into a ring of two
+ * MCU rows per component, then upsampled and color converted into the image.
+ * Neither the coefficients nor the component planes of the whole image are
+ * kept, the working set stays in cache and the peak memory is about the
+ * size of the output.
+ */
+bool JpegDecoder::decodeScanRows(JpegDecodeData *jpeg, int32_t stride,
+                                 uint8_t* image) {
+    bool interleaved = jpeg->scan_n > 1;
+    uint32_t ring_rows[4] = {0};
+    uint32_t block_rows[4], block_cols[4];
+    int16_t* blocks[4];
+    uint32_t i, j, k, x, y;
+    for (i = 0; i < jpeg->scan_n; i++) {
+        uint32_t comp_id = jpeg->order[i];
+        if (interleaved) {
+            block_rows[i] = jpeg->img_comp[comp_id].vsampling;
+            block_cols[i] = jpeg->mcus_x * jpeg->img_comp[comp_id].hsampling;
+        }
+        else {
+            block_rows[i] = 1;
+            block_cols[i] = (jpeg->img_comp[comp_id].x + 7) >> 3;
+        }
+        ring_rows[comp_id] = block_rows[i] *
+                             jpeg->img_comp[comp_id].block_size * 2;
+        jpeg->img_comp[comp_id].data = (uint8_t*)scratch_->reserve(
+            JPEG_COMPONENT_DATA + comp_id,
+            ring_rows[comp_id] * jpeg->img_comp[comp_id].out_w2 + 15);
+        blocks[i] = (int16_t*)scratch_->reserve(JPEG_SCAN_BLOCKS + i,
+                        block_rows[i] * block_cols[i] * 64 * sizeof(int16_t));
+        if (jpeg->img_comp[comp_id].data == nullptr || blocks[i] == nullptr) {
+            freeComponents(jpeg, jpeg->components);
+            LOG(ERROR) << "failed to allocate row buffers for component "
+                       << jpeg->img_comp[comp_id].id;
+            return false;
+        }
+    }
+    if (!initializeSampling(jpeg, ring_rows, 1)) {
+        return false;
+    }
+
+    uint32_t steps = interleaved ? jpeg->mcus_y :
+                     (jpeg->img_comp[jpeg->order[0]].y + 7) >> 3;
+    HuffmanLookupTable *huffman_dc, *huffman_ac;
+    bool succeeded;
+    resetJpegDecoder(jpeg);
+    for (uint32_t step = 0; step < steps; step++) {
+        for (i = 0; i < jpeg->scan_n; i++) {
+            if (jpeg->order[i] >= decode_n_) continue;
+            memset(blocks[i], 0,
+                   block_rows[i] * block_cols[i] * 64 * sizeof(int16_t));
+        }
+
+        uint32_t mcus = interleaved ? jpeg->mcus_x : block_cols[0];
+        for (j = 0; j < mcus; ++j) {
+            for (k = 0; k < jpeg->scan_n; ++k) {
+                uint32_t comp_id = jpeg->order[k];
+                huffman_dc = jpeg->huff_dc + jpeg->img_comp[comp_id].dc_id;
+                huffman_ac = jpeg->huff_ac + jpeg->img_comp[comp_id].ac_id;
+                uint32_t hsampling = interleaved ?
+                                     jpeg->img_comp[comp_id].hsampling : 1;
+                for (y = 0; y < block_rows[k]; ++y) {
+                    for (x = 0; x < hsampling; ++x) {
+                        int16_t* data = blocks[k] + (y * block_cols[k] +
+                                        j * hsampling + x) * 64;
+                        succeeded = comp_id < decode_n_ ?
+                            decodeBlock(file_data_, jpeg, data, huffman_dc,
+                                        huffman_ac, comp_id) :
+                            skipBlock(file_data_, jpeg, huffman_dc,
+                                      huffman_ac, comp_id);
+                        if (!succeeded) return false;
+                    }
+                }
+            }
+
+            // count down the restart interval after every MCU but the last.
+            if (--jpeg->todo <= 0 && (step + 1 < steps || j + 1 < mcus)) {
+                if (!restartDecoder(file_data_, jpeg)) return false;
+            }
+        }
+
+        for (i = 0; i < jpeg->scan_n; i++) {
+            uint32_t comp_id = jpeg->order[i];
+            if (comp_id >= decode_n_) continue;
+            uint32_t width2 = jpeg->img_comp[comp_id].out_w2;
+            const uint16_t* dequant_table =
+                jpeg->dequant[jpeg->img_comp[comp_id].quant_id];
+            uint32_t block_size = jpeg->img_comp[comp_id].block_size;
+            uint32_t rows = block_rows[i] * block_size;
+            uint8_t* output = jpeg->img_comp[comp_id].data +
+                              (step & 1) * rows * width2;
+            for (y = 0; y < block_rows[i]; ++y) {
+                idctDecodeRow(output + y * block_size * width2, width2,
+                              blocks[i] + y * block_cols[i] * 64,
+                              block_cols[i], dequant_table, block_size);
+            }
+            samples_[comp_id].ready_rows = (step + 1) * rows;
+        }
+        storeRows(samples_, ycrcb2bgr_, output_row_, height_, 0, 0, stride,
+                  image);
+    }
+    freeComponents(jpeg, jpeg->components);
+
+    return true;
+}
+
+/* The restart intervals of a baseline scan can be decoded independently when
+ * the rest of the scan is in memory. Looks for the RSTn markers through the
+ * entropy-coded data and records where each interval starts, the last offset
+ * being the marker ending the scan. Returns false if the scan is left to the
+ * sequential decoding, e.g. when the markers do not match the MCU count.
+ */
+bool JpegDecoder::locateIntervals(JpegDecodeData *jpeg) {
+    if (jpeg->restart_interval <= 0 || !file_data_->isLastBlock()) {
+        return false;
+    }
+
+    uint32_t mcus = jpeg->scan_n > 1 ? jpeg->mcus_x * jpeg->mcus_y :
+                    ((jpeg->img_comp[jpeg->order[0]].x + 7) >> 3) *
+                    ((jpeg->img_comp[jpeg->order[0]].y + 7) >> 3);
+    uint32_t count = (mcus + jpeg->restart_interval - 1) /
+                     jpeg->restart_interval;
+    if (count < 2) {
+        return false;
+    }
+    intervals_ = (uint32_t*)scratch_->reserve(JPEG_RESTART_INTERVALS,
+                                              (count + 1) * sizeof(uint32_t));
+    if (intervals_ == nullptr) {
+        return false;
+    }
+
+    const uint8_t* start = file_data_->getCurrentPosition();
+    const uint8_t* end = start + file_data_->getValidSize();
+    const uint8_t* current = start;
+    uint32_t found = 1;
+    intervals_[0] = 0;
+    while (true) {
+        current = (const uint8_t*)memchr(current, 0xFF, end - current);
+        if (current == nullptr) {
+            return false;
+        }
+        while (current + 1 < end && current[1] == 0xFF) {  // fill bytes
+            current++;
+        }
+        if (current + 1 >= end) {
+            return false;
+        }
+
+        uint8_t marker = current[1];
+        if (marker == 0) {  // stuffed 0xFF data byte
+            current += 2;
+        }
+        else if (DRI_RESTART(marker)) {
+            if (found == count) {
+                return false;
+            }
+            current += 2;
+            intervals_[found++] = current - start;
+        }
+        else {
+            intervals_[found] = current - start;
+            break;
+        }
+    }
+    interval_count_ = found;
+
+    return found == count;
+}
+
+/* Decodes the MCUs from mcu_begin to mcu_end, which span whole restart
+ * intervals held by size bytes at data, and transforms their blocks into the
+ * component planes. Consecutive MCUs of a row are gathered in blocks so the
+ * IDCT runs over whole block rows.
+ */
+void JpegDecoder::decodeIntervalRange(JpegDecodeData *jpeg,
+                                      const uint8_t* data, uint32_t size,
+                                      uint32_t mcu_begin, uint32_t mcu_end,
+                                      int16_t** blocks, bool* succeeded) {
+    *succeeded = false;
+    bool interleaved = jpeg->scan_n > 1;
+    uint32_t block_rows[4], block_cols[4], hsampling[4];
+    uint32_t i, j, k, x, y;
+    for (i = 0; i < jpeg->scan_n; i++) {
+        uint32_t comp_id = jpeg->order[i];
+        if (interleaved) {
+            block_rows[i] = jpeg->img_comp[comp_id].vsampling;
+            hsampling[i]  = jpeg->img_comp[comp_id].hsampling;
+            block_cols[i] = jpeg->mcus_x * hsampling[i];
+        }
+        else {
+            block_rows[i] = 1;
+            hsampling[i]  = 1;
+            block_cols[i] = (jpeg->img_comp[comp_id].x + 7) >> 3;
+        }
+    }
+    uint32_t mcus_x = interleaved ? jpeg->mcus_x : block_cols[0];
+
+    // the entropy decoder state is private to the thread.
+    JpegDecodeData state = *jpeg;
+    BytesReader file_data(data, size);
+    HuffmanLookupTable *huffman_dc, *huffman_ac;
+    resetJpegDecoder(&state);
+    uint32_t mcu = mcu_begin;
+    while (mcu < mcu_end) {
+        uint32_t mcu_y = mcu / mcus_x;
+        uint32_t col_begin = mcu % mcus_x;
+        uint32_t col_end = col_begin + (mcu_end - mcu) < mcus_x ?
+                           col_begin + (mcu_end - mcu) : mcus_x;
+        for (i = 0; i < jpeg->scan_n; i++) {
+            if (jpeg->order[i] >= decode_n_) continue;
+            for (y = 0; y < block_rows[i]; ++y) {
+                memset(blocks[i] + (y * block_cols[i] + col_begin *
+                       hsampling[i]) * 64, 0, (col_end - col_begin) *
+                       hsampling[i] * 64 * sizeof(int16_t));
+            }
+        }
+
+        for (j = col_begin; j < col_end; ++j, ++mcu) {
+            for (k = 0; k < jpeg->scan_n; ++k) {
+                uint32_t comp_id = jpeg->order[k];
+                huffman_dc = state.huff_dc + jpeg->img_comp[comp_id].dc_id;
+                huffman_ac = state.huff_ac + jpeg->img_comp[comp_id].ac_id;
+                for (y = 0; y < block_rows[k]; ++y) {
+                    for (x = 0; x < hsampling[k]; ++x) {
+                        int16_t* block = blocks[k] + (y * block_cols[k] +
+                                         j * hsampling[k] + x) * 64;
+                        bool decoded = comp_id < decode_n_ ?
+                            decodeBlock(&file_data, &state, block, huffman_dc,
+                                        huffman_ac, comp_id) :
+                            skipBlock(&file_data, &state, huffman_dc,
+                                      huffman_ac, comp_id);
+                        if (!decoded) return;
+                    }
+                }
+            }
+
+            if (--state.todo <= 0 && mcu + 1 < mcu_end) {
+                if (!restartDecoder(&file_data, &state)) return;
+            }
+        }
+
+        for (i = 0; i < jpeg->scan_n; i++) {
+            uint32_t comp_id = jpeg->order[i];
+            if (comp_id >= decode_n_) continue;
+            uint32_t width2 = jpeg->img_comp[comp_id].out_w2;
+            uint32_t block_size = jpeg->img_comp[comp_id].block_size;
+            const uint16_t* dequant_table =
+                jpeg->dequant[jpeg->img_comp[comp_id].quant_id];
+            uint8_t* output = jpeg->img_comp[comp_id].data +
+                              mcu_y * block_rows[i] * block_size * width2 +
+                              col_begin * hsampling[i] * block_size;
+            for (y = 0; y < block_rows[i]; ++y) {
+                idctDecodeRow(output + y * block_size * width2, width2,
+                              blocks[i] + (y * block_cols[i] + col_begin *
+                              hsampling[i]) * 64,
+                              (col_end - col_begin) * hsampling[i],
+                              dequant_table, block_size);
+            }
+        }
+    }
+    *succeeded = true;
+}
+
+/* Decodes a baseline scan located by locateIntervals(): each thread takes a
+ * run of whole restart intervals and decodes them into their MCU positions
+ * of the component planes, which are then color converted in bands.
+ */
+bool JpegDecoder::decodeIntervals(JpegDecodeData *jpeg, int32_t stride,
+                                  uint8_t* image) {
+    if (!allocateComponents(jpeg)) {
+        return false;
+    }
+
+    uint32_t threads_n = interval_count_ < interval_threads_ ?
+                         interval_count_ : interval_threads_;
+    // the block rows of up to 4 components for each thread.
+    std::vector<int16_t*> blocks(threads_n * 4);
+    uint32_t i, n;
+    for (i = 0; i < jpeg->scan_n; i++) {
+        uint32_t comp_id = jpeg->order[i];
+        size_t size = jpeg->scan_n > 1 ?
+                      jpeg->img_comp[comp_id].vsampling * jpeg->mcus_x *
+                      jpeg->img_comp[comp_id].hsampling :
+                      (jpeg->img_comp[comp_id].x + 7) >> 3;
+        size *= 64;
+        int16_t* buffer = (int16_t*)scratch_->reserve(JPEG_SCAN_BLOCKS + i,
+                              size * threads_n * sizeof(int16_t));
+        if (buffer == nullptr) {
+            freeComponents(jpeg, jpeg->components);
+            LOG(ERROR) << "failed to allocate row buffers for component "
+                       << jpeg->img_comp[comp_id].id;
+            return false;
+        }
+        for (n = 0; n < threads_n; n++) {
+            blocks[n * 4 + i] = buffer + size * n;
+        }
+    }
+
+    const uint8_t* data = file_data_->getCurrentPosition();
+    uint32_t data_size = file_data_->getValidSize();
+    uint32_t mcus = jpeg->scan_n > 1 ? jpeg->mcus_x * jpeg->mcus_y :
+                    ((jpeg->img_comp[jpeg->order[0]].x + 7) >> 3) *
+                    ((jpeg->img_comp[jpeg->order[0]].y + 7) >> 3);
+    std::vector<std::thread> threads;
+    std::unique_ptr<bool[]> succeeded(new bool[threads_n]());
+    for (n = 0; n < threads_n; n++) {
+        uint32_t first = interval_count_ * n / threads_n;
+        uint32_t last  = interval_count_ * (n + 1) / threads_n;
+        uint32_t mcu_begin = first * jpeg->restart_interval;
+        uint32_t mcu_end = last * jpeg->restart_interval < mcus ?
+                           last * jpeg->restart_interval : mcus;
+
+        // a range ends with the marker behind its last interval.
+        uint32_t end = intervals_[last];
+        if (last == interval_count_) {
+            end = end + 2 < data_size ? end + 2 : data_size;
+        }
+        threads.push_back(std::thread(&JpegDecoder::decodeIntervalRange, this,
+                          jpeg, data + intervals_[first],
+                          end - intervals_[first], mcu_begin, mcu_end,
+                          &blocks[n * 4], &succeeded[n]));
+    }
+
+    for (auto &worker: threads) {
+        worker.join();
+    }
+    for (n = 0; n < threads_n; n++) {
+        if (!succeeded[n]) {
+            freeComponents(jpeg, jpeg->components);
+            return false;
+        }
+    }
+
+    // the scan is over, the next marker is the one ending it.
+    file_data_->skipBytes(intervals_[interval_count_]);
+    jpeg->marker = NULL_MARKER;
+
+    return convertColor(stride, image);
+}
+
+/* Decodes the region of a baseline scan holding every component. The MCUs
+ * are entropy decoded up to the last MCU row of the region, those outside
+ * the window of MCUs around it only through skipBlock(). With the restart
+ * intervals located, the decoding starts at the interval of the first MCU
+ * of the window. The window keeps an MCU on each side of the region, so the
+ * upsampling at the edges of the region sees the same neighbours as in the
+ * whole image, and only the window is transformed and color converted.
+ */
+bool JpegDecoder::decodeRegionScan(JpegDecodeData *jpeg, int32_t stride,
+                                   uint8_t* image) {
+    bool interleaved = jpeg->scan_n > 1;
+    uint32_t units_x, units_y, unit_width, unit_height;
+    if (interleaved) {
+        units_x = jpeg->mcus_x;
+        units_y = jpeg->mcus_y;
+        unit_width  = jpeg->hsampling_max * block_size_;
+        unit_height = jpeg->vsampling_max * block_size_;
+    }
+    else {
+        uint32_t comp_id = jpeg->order[0];
+        units_x = (jpeg->img_comp[comp_id].x + 7) >> 3;
+        units_y = (jpeg->img_comp[comp_id].y + 7) >> 3;
+        unit_width  = jpeg->img_comp[comp_id].block_size;
+        unit_height = jpeg->img_comp[comp_id].block_size;
+    }
+
+    uint32_t unit_x0 = region_x_ / unit_width;
+    uint32_t unit_y0 = region_y_ / unit_height;
+    uint32_t unit_x1 = (region_x_ + region_width_ + unit_width - 1) /
+                       unit_width;
+    uint32_t unit_y1 = (region_y_ + region_height_ + unit_height - 1) /
+                       unit_height;
+    unit_x0 = unit_x0 > 0 ? unit_x0 - 1 : 0;
+    unit_y0 = unit_y0 > 0 ? unit_y0 - 1 : 0;
+    unit_x1 = unit_x1 < units_x ? unit_x1 + 1 : units_x;
+    unit_y1 = unit_y1 < units_y ? unit_y1 + 1 : units_y;
+
+    uint32_t block_rows[4], block_cols[4], hsampling[4], plane_width[4];
+    int16_t* blocks[4];
+    uint32_t i, k, x, y;
+    for (i = 0; i < jpeg->scan_n; i++) {
+        uint32_t comp_id = jpeg->order[i];
+        block_rows[i] = interleaved ? jpeg->img_comp[comp_id].vsampling : 1;
+        hsampling[i]  = interleaved ? jpeg->img_comp[comp_id].hsampling : 1;
+        block_cols[i] = (unit_x1 - unit_x0) * hsampling[i];
+        uint32_t block_size = jpeg->img_comp[comp_id].block_size;
+        plane_width[i] = block_cols[i] * block_size;
+        uint32_t plane_height = (unit_y1 - unit_y0) * block_rows[i] *
+                                block_size;
+        jpeg->img_comp[comp_id].data = (uint8_t*)scratch_->reserve(
+            JPEG_COMPONENT_DATA + comp_id,
+            plane_width[i] * plane_height + 15);
+        blocks[i] = (int16_t*)scratch_->reserve(JPEG_SCAN_BLOCKS + i,
+                        block_rows[i] * block_cols[i] * 64 * sizeof(int16_t));
+        if (jpeg->img_comp[comp_id].data == nullptr || blocks[i] == nullptr) {
+            freeComponents(jpeg, jpeg->components);
+            LOG(ERROR) << "failed to allocate region buffers for component "
+                       << jpeg->img_comp[comp_id].id;
+            return false;
+        }
+    }
+
+    HuffmanLookupTable *huffman_dc, *huffman_ac;
+    bool succeeded;
+    uint32_t units = units_x * units_y;
+    uint32_t unit_end = (unit_y1 - 1) * units_x + unit_x1;
+    uint32_t unit = 0;
+    resetJpegDecoder(jpeg);
+    if (locateIntervals(jpeg)) {
+        uint32_t interval = (unit_y0 * units_x + unit_x0) /
+                            jpeg->restart_interval;
+        file_data_->skipBytes(intervals_[interval]);
+        unit = interval * jpeg->restart_interval;
+    }
+    for (; unit < unit_end; ++unit) {
+        uint32_t unit_row = unit / units_x;
+        uint32_t unit_col = unit % units_x;
+        bool inside = unit_row >= unit_y0 && unit_col >= unit_x0 &&
+                      unit_col < unit_x1;
+        if (inside && unit_col == unit_x0) {
+            for (i = 0; i < jpeg->scan_n; i++) {
+                memset(blocks[i], 0, block_rows[i] * block_cols[i] * 64 *
+                       sizeof(int16_t));
+            }
+        }
+
+        for (k = 0; k < jpeg->scan_n; ++k) {
+            uint32_t comp_id = jpeg->order[k];
+            huffman_dc = jpeg->huff_dc + jpeg->img_comp[comp_id].dc_id;
+            huffman_ac = jpeg->huff_ac + jpeg->img_comp[comp_id].ac_id;
+            for (y = 0; y < block_rows[k]; ++y) {
+                for (x = 0; x < hsampling[k]; ++x) {
+                    if (inside) {
+                        int16_t* data = blocks[k] + (y * block_cols[k] +
+                                        (unit_col - unit_x0) * hsampling[k] +
+                                        x) * 64;
+                        succeeded = decodeBlock(file_data_, jpeg, data,
+                                                huffman_dc, huffman_ac,
+                                                comp_id);
+                    }
+                    else {
+                        succeeded = skipBlock(file_data_, jpeg, huffman_dc,
+                                              huffman_ac, comp_id);
+                    }
+                    if (!succeeded) return false;
+                }
+            }
+        }
+
+        if (--jpeg->todo <= 0 && unit + 1 < units) {
+            if (!restartDecoder(file_data_, jpeg)) return false;
+        }
+
+        if (inside && unit_col == unit_x1 - 1) {
+            for (i = 0; i < jpeg->scan_n; i++) {
+                uint32_t comp_id = jpeg->order[i];
+                uint32_t block_size = jpeg->img_comp[comp_id].block_size;
+                const uint16_t* dequant_table =
+                    jpeg->dequant[jpeg->img_comp[comp_id].quant_id];
+                uint8_t* output = jpeg->img_comp[comp_id].data +
+                                  (unit_row - unit_y0) * block_rows[i] *
+                                  block_size * plane_width[i];
+                for (y = 0; y < block_rows[i]; ++y) {
+                    idctDecodeRow(output + y * block_size * plane_width[i],
+                                  plane_width[i],
+                                  blocks[i] + y * block_cols[i] * 64,
+                                  block_cols[i], dequant_table, block_size);
+                }
+            }
+        }
+    }
+
+    // from here on, the component planes and the image size are those of the
+    // window.
+    for (i = 0; i < jpeg->scan_n; i++) {
+        uint32_t comp_id = jpeg->order[i];
+        uint32_t block_size = jpeg->img_comp[comp_id].block_size;
+        uint32_t top = unit_y0 * block_rows[i] * block_size;
+        jpeg->img_comp[comp_id].out_w2 = plane_width[i];
+        jpeg->img_comp[comp_id].out_h2 = (unit_y1 - unit_y0) * block_rows[i] *
+                                         block_size;
+        jpeg->img_comp[comp_id].out_y  = jpeg->img_comp[comp_id].out_y - top;
+        if (jpeg->img_comp[comp_id].out_y > jpeg->img_comp[comp_id].out_h2) {
+            jpeg->img_comp[comp_id].out_y = jpeg->img_comp[comp_id].out_h2;
+        }
     }
+    uint32_t width = width_, height = height_;
+    uint32_t window_x = unit_x0 * unit_width;
+    uint32_t window_y = unit_y0 * unit_height;
+    width_  = (unit_x1 * unit_width < width ? unit_x1 * unit_width : width) -
+              window_x;
+    height_ = (unit_y1 * unit_height < height ? unit_y1 * unit_height :
+               height) - window_y;
+    succeeded = convertRegion(stride, image, region_x_ - window_x,
+                              region_y_ - window_y);
+    width_  = width;
+    height_ = height;
+
+    return succeeded;
 }
 
 void JpegDecoder::idctprocess1(JpegDecodeData *jpeg, uint32_t height_begin,
                                uint32_t height_end, uint32_t width,
                                uint32_t comp_id, uint32_t width2) {
+    const uint16_t* dequant_table =
+        jpeg->dequant[jpeg->img_comp[comp_id].quant_id];
     for (uint32_t i = height_begin; i < height_end; i++) {
         uint8_t* result = jpeg->img_comp[comp_id].data +
-                          jpeg->img_comp[comp_id].w2 * i * 8;
+                          width2 * i * jpeg->img_comp[comp_id].block_size;
         int16_t *data = jpeg->img_comp[comp_id].coeff +
                         jpeg->img_comp[comp_id].coeff_w * i * 64;
-
-        for (uint32_t j = 0; j < width; j++) {
-            dequantizeData(data,
-                           jpeg->dequant[jpeg->img_comp[comp_id].quant_id]);
-            idctDecodeBlock(result, width2, data);
-            data += 64;
-            result += 8;
-        }
+        idctDecodeRow(result, width2, data, width, dequant_table,
+                      jpeg->img_comp[comp_id].block_size);
     }
 }
 
 void JpegDecoder::finishProgressiveJpeg(JpegDecodeData *jpeg) {
-    for (uint32_t n = 0; n < jpeg->components; ++n) {
+    for (uint32_t n = 0; n < decode_n_; ++n) {
         uint32_t height = (jpeg->img_comp[n].y + 7) >> 3;
         uint32_t width  = (jpeg->img_comp[n].x + 7) >> 3;
-        uint32_t width2 = jpeg->img_comp[n].w2;
+        uint32_t width2 = jpeg->img_comp[n].out_w2;
+        if (hardware_threads_ == 1) {
+            idctprocess1(jpeg, 0, height, width, n, width2);
+            continue;
+        }
         std::vector<std::thread> threads;
         int32_t interval = (height + hardware_threads_ - 1) / hardware_threads_;
 
@@ -1940,49 +2961,67 @@ void JpegDecoder::finishProgressiveJpeg(JpegDecodeData *jpeg) {
     }
 }
 
-bool JpegDecoder::convertColor(int32_t stride, uint8_t* image) {
-    uint32_t target_comps, decode_n, is_rgb;
-    // determine actual number of components to generate.
-    // target_comps: target components, jpeg_->components: encoded components.
-    target_comps = jpeg_->components >= 3 ? 3 : 1;
+/* Determines the components to decode, the chroma of YCbCr are neither
+ * transformed nor upsampled when the luma is all the output takes.
+ */
+void JpegDecoder::chooseComponents(JpegDecodeData *jpeg) {
+    // target_comps_: target components, jpeg->components: encoded components.
+    target_comps_ = jpeg->components >= 3 && mode_ == IMREAD_UNCHANGED ? 3 : 1;
 
-    is_rgb = jpeg_->components == 3 && (jpeg_->rgb == 3 ||
-                (jpeg_->app14_color_transform == 0 && !jpeg_->jfif));
+    is_rgb_ = jpeg->components == 3 && (jpeg->rgb == 3 ||
+                (jpeg->app14_color_transform == 0 && !jpeg->jfif));
 
-    if (jpeg_->components == 3 && target_comps < 3 && !is_rgb) {
-        decode_n = 1;
+    if (jpeg->components == 3 && mode_ == IMREAD_GRAYSCALE && !is_rgb_) {
+        decode_n_ = 1;
     }
     else {
-        decode_n = jpeg_->components;
+        decode_n_ = jpeg->components;
     }
+}
 
-    // resample and color-convert
-    uint32_t k, i;
-    uint8_t *output[4] = { NULL, NULL, NULL, NULL };
-    SampleData res_comp[4];
-
-    for (k = 0; k < decode_n; ++k) {
-        SampleData *sample = &res_comp[k];
+/* Sets up the upsampling of every component. The rows of component k are read
+ * from a ring of ring_rows[k] lines at img_comp[k].data, which is the whole
+ * component plane unless the scan is decoded row by row. A line buffer is
+ * reserved for each of the bands converted at the same time.
+ */
+bool JpegDecoder::initializeSampling(JpegDecodeData *jpeg,
+                                     const uint32_t ring_rows[4],
+                                     uint32_t bands) {
+    for (uint32_t k = 0; k < decode_n_; ++k) {
+        SampleData *sample = &samples_[k];
 
         // allocate line buffer big enough for upsampling off the edges
         // with upsample factor of 4
-        jpeg_->img_comp[k].line_buffer = (uint8_t *) malloc(width_ + 3);
-        if (!jpeg_->img_comp[k].line_buffer) {
-            freeComponents(jpeg_, jpeg_->components);
+        sample->line_buffer = (uint8_t *)scratch_->reserve(
+            JPEG_LINE_BUFFERS + k, (width_ + 3) * bands);
+        if (!sample->line_buffer) {
+            freeComponents(jpeg, jpeg->components);
             LOG(ERROR) << "No enough memory to convert sample.";
             return false;
         }
 
-        sample->hs      = jpeg_->hsampling_max / jpeg_->img_comp[k].hsampling;
-        sample->vs      = jpeg_->vsampling_max / jpeg_->img_comp[k].vsampling;
+        // upsampling left to do after the IDCT of the component.
+        sample->hs      = jpeg->hsampling_max * block_size_ /
+                          (jpeg->img_comp[k].hsampling *
+                           jpeg->img_comp[k].block_size);
+        sample->vs      = jpeg->vsampling_max * block_size_ /
+                          (jpeg->img_comp[k].vsampling *
+                           jpeg->img_comp[k].block_size);
         sample->ystep   = sample->vs >> 1;
         sample->w_lores = (width_ + sample->hs - 1) / sample->hs;
         sample->ypos    = 0;
-        sample->line0   = sample->line1 = jpeg_->img_comp[k].data;
+        sample->line0   = sample->line1 = 0;
+        sample->ring_rows  = ring_rows[k];
+        sample->ready_rows = 0;
 
+        // as libjpeg, the pixels are replicated rather than interpolated
+        // when the image is scaled down to 1 pixel a block.
         if (sample->hs == 1 && sample->vs == 1) {
             sample->resample = resampleRow1;
         }
+        else if (block_size_ == 1) {
+            sample->resample = resampleRowGeneric;
+        }
         else if (sample->hs == 1 && sample->vs == 2) {
             sample->resample = resampleRowV2;
         }
@@ -1996,41 +3035,97 @@ bool JpegDecoder::convertColor(int32_t stride, uint8_t* image) {
             sample->resample = resampleRowGeneric;
         }
     }
+    output_row_ = 0;
+
+    // pairs of full resolution chroma rows averaged into a row of I420/NV12.
+    if ((mode_ == IMREAD_I420 || mode_ == IMREAD_NV12) && decode_n_ == 3) {
+        chroma_rows_ = (uint8_t *)scratch_->reserve(JPEG_CHROMA_ROWS,
+                                                    (size_t)width_ * 4 * bands);
+        if (!chroma_rows_) {
+            freeComponents(jpeg, jpeg->components);
+            LOG(ERROR) << "No enough memory to subsample the chroma.";
+            return false;
+        }
+    }
+
+    if (consumer_ != nullptr) {
+        consumer_row_ = (uint8_t *)scratch_->reserve(JPEG_REGION_ROW,
+                                                     width_ * channels_);
+        if (!consumer_row_) {
+            freeComponents(jpeg, jpeg->components);
+            LOG(ERROR) << "No enough memory to convert a row.";
+            return false;
+        }
+    }
+
+    // orientation 7 flips a band before rotating it, which takes a second one.
+    if (upright_) {
+        size_t band_size = (size_t)UPRIGHT_BAND_ROWS * width_ * channels_;
+        band_size *= jpeg->orientation == 7 ? 2 : 1;
+        upright_bands_ = (uint8_t *)scratch_->reserve(JPEG_UPRIGHT_BANDS,
+                                                      band_size * bands);
+        if (!upright_bands_) {
+            freeComponents(jpeg, jpeg->components);
+            LOG(ERROR) << "No enough memory to turn the image upright.";
+            return false;
+        }
+    }
+
+    return true;
+}
 
-    if (target_comps == 3 && jpeg_->components == 3 && !is_rgb) {
-        ycrcb2bgr_ = new YCrCb2BGR(width_, channels_);
+// moves the sampling of a component with out_y rows to the next output row.
+static inline void advanceSampling(SampleData *sample, uint32_t out_y) {
+    if (++sample->ystep >= sample->vs) {
+        sample->ystep = 0;
+        sample->line0 = sample->line1;
+        if (++sample->ypos < out_y) {
+            sample->line1++;
+        }
     }
+}
+
+/* Resamples and color-converts the output rows from row up to row_end whose
+ * component rows are ready, row is left at the first row not converted.
+ */
+void JpegDecoder::convertRows(SampleData *samples, YCrCb2BGR *ycrcb2bgr,
+                              uint32_t &row, uint32_t row_end, int32_t stride,
+                              uint8_t* image) {
+    uint32_t k, i;
+    uint8_t *output[4] = { NULL, NULL, NULL, NULL };
+
+    for (; row < row_end; ++row) {
+        for (k = 0; k < decode_n_; ++k) {
+            if (samples[k].line1 >= samples[k].ready_rows) return;
+        }
 
-    // now go ahead and resample
-    for (uint32_t row = 0; row < height_; ++row) {
         uint8_t *output_row = image + stride * row;
-        for (k = 0; k < decode_n; ++k) {
-            SampleData *sample = &res_comp[k];   // optimize
+        for (k = 0; k < decode_n_; ++k) {
+            SampleData *sample = &samples[k];
+            uint32_t w2 = jpeg_->img_comp[k].out_w2;
+            uint8_t *line0 = jpeg_->img_comp[k].data +
+                             (sample->line0 % sample->ring_rows) * w2;
+            uint8_t *line1 = jpeg_->img_comp[k].data +
+                             (sample->line1 % sample->ring_rows) * w2;
             int32_t y_bot = sample->ystep >= (sample->vs >> 1);
-            output[k] = sample->resample(jpeg_->img_comp[k].line_buffer,
-                                     y_bot ? sample->line1 : sample->line0,
-                                     y_bot ? sample->line0 : sample->line1,
-                                     sample->w_lores, sample->hs);
-            if (++sample->ystep >= sample->vs) {
-                sample->ystep = 0;
-                sample->line0 = sample->line1;
-                if (++sample->ypos < jpeg_->img_comp[k].y) {
-                    sample->line1 += jpeg_->img_comp[k].w2;
-                }
-            }
+            output[k] = sample->resample(sample->line_buffer,
+                                         y_bot ? line1 : line0,
+                                         y_bot ? line0 : line1,
+                                         sample->w_lores, sample->hs);
+            advanceSampling(sample, jpeg_->img_comp[k].out_y);
         }
-        if (target_comps == 3) {
+        if (target_comps_ == 3) {
             uint8_t *y = output[0];
             if (jpeg_->components == 3) {
-                if (is_rgb) {  // input is rgb
+                if (is_rgb_) {  // input is rgb
                     for (i = 0; i < width_; ++i) {
                         output_row[0] = y[i];
                         output_row[1] = output[1][i];
                         output_row[2] = output[2][i];
-                        output_row += target_comps;
+                        output_row += target_comps_;
                     }
                 } else {  // input is YCrCb
-                    ycrcb2bgr_->convertBGR(y, output[1], output[2], output_row);
+                    ycrcb2bgr->convertBGR(y, output[1], output[2], output_row);
                 }
             } else if (jpeg_->components == 4) {
                 if (jpeg_->app14_color_transform == 0) {  // CMYK
@@ -2039,88 +3134,403 @@ bool JpegDecoder::convertColor(int32_t stride, uint8_t* image) {
                         output_row[0] = blinn8x8(output[0][i], m);
                         output_row[1] = blinn8x8(output[1][i], m);
                         output_row[2] = blinn8x8(output[2][i], m);
-                        output_row += target_comps;
+                        output_row += target_comps_;
                     }
                 } else if (jpeg_->app14_color_transform == 2) { // YCCK
-                    ycrcb2bgr_->convertBGR(y, output[1], output[2], output_row);
+                    ycrcb2bgr->convertBGR(y, output[1], output[2], output_row);
                     for (i = 0; i < width_; ++i) {
                         uint8_t m = output[3][i];
                         output_row[0] = blinn8x8(255 - output_row[0], m);
                         output_row[1] = blinn8x8(255 - output_row[1], m);
                         output_row[2] = blinn8x8(255 - output_row[2], m);
-                        output_row += target_comps;
+                        output_row += target_comps_;
                     }
                 } else { // YCbCr + alpha?  Ignore the fourth channel for now
-                    ycrcb2bgr_->convertBGR(y, output[1], output[2], output_row);
+                    ycrcb2bgr->convertBGR(y, output[1], output[2], output_row);
                 }
             } else {
                 for (i = 0; i < width_; ++i) {
                     output_row[0] = output_row[1] = output_row[2] = y[i];
-                    output_row += target_comps;
+                    output_row += target_comps_;
                 }
             }
-        } else {  // target_comps == 1
-            if (is_rgb) {
-                if (target_comps == 1) {
-                    RGB2YSSE(output[0], output[1], output[2], output_row,
-                             width_);
-                }
-                else {
-                    for (i = 0; i < width_; ++i, output_row += 2) {
-                        output_row[0] = computeY(output[0][i], output[1][i],
-                                                 output[2][i]);
-                        output_row[1] = 255;
-                    }
-                }
-            } else if (jpeg_->components == 4 &&
-                       jpeg_->app14_color_transform == 0) {
-                for (i = 0; i < width_; ++i) {
-                    uint8_t m = output[3][i];
-                    uint8_t r = blinn8x8(output[0][i], m);
-                    uint8_t g = blinn8x8(output[1][i], m);
-                    uint8_t b = blinn8x8(output[2][i], m);
-                    output_row[0] = computeY(r, g, b);
-                    output_row[1] = 255;
-                    output_row += target_comps;
-                }
-            } else if (jpeg_->components == 4 &&
-                       jpeg_->app14_color_transform == 2) {
-                for (i = 0; i < width_; ++i) {
-                    output_row[0] = blinn8x8(255 - output[0][i],
-                                             output[3][i]);
-                    output_row[1] = 255;
-                    output_row += target_comps;
-                }
+        } else {  // target_comps_ == 1, gray or the luma of 3 components
+            if (is_rgb_) {
+                RGB2YSSE(output[0], output[1], output[2], output_row, width_);
             } else {
-                uint8_t *y = output[0];
-                if (target_comps == 1) {
-                    memcpy(output_row, y, width_);
-                }
-                else {
-                    for (i = 0; i < width_; ++i) {
-                        *output_row++ = y[i];
-                        *output_row++ = 255;
-                    }
-                }
+                memcpy(output_row, output[0], width_);
+            }
+        }
+    }
+}
+
+// averages the 2x2 pixels of two rows of width pixels into a row of half size.
+static void averageRows(const uint8_t* row0, const uint8_t* row1,
+                        uint32_t width, uint8_t* output) {
+    __m128i ones = _mm_set1_epi8(1);
+    __m128i twos = _mm_set1_epi16(2);
+    __m128i value0, value1, sum0, sum1;
+
+    uint32_t index = 0;
+    for (; index + 32 <= width; index += 32) {
+        value0 = _mm_loadu_si128((__m128i const*)(row0 + index));
+        value1 = _mm_loadu_si128((__m128i const*)(row1 + index));
+        sum0 = _mm_add_epi16(_mm_maddubs_epi16(value0, ones),
+                             _mm_maddubs_epi16(value1, ones));
+        value0 = _mm_loadu_si128((__m128i const*)(row0 + index + 16));
+        value1 = _mm_loadu_si128((__m128i const*)(row1 + index + 16));
+        sum1 = _mm_add_epi16(_mm_maddubs_epi16(value0, ones),
+                             _mm_maddubs_epi16(value1, ones));
+        sum0 = _mm_srli_epi16(_mm_add_epi16(sum0, twos), 2);
+        sum1 = _mm_srli_epi16(_mm_add_epi16(sum1, twos), 2);
+        _mm_storeu_si128((__m128i*)(output + (index >> 1)),
+                         _mm_packus_epi16(sum0, sum1));
+    }
+
+    // the last pixel of an odd width stands for the missing one.
+    for (; index < width; index += 2) {
+        uint32_t next = index + 1 < width ? index + 1 : index;
+        output[index >> 1] = (row0[index] + row0[next] + row1[index] +
+                              row1[next] + 2) >> 2;
+    }
+}
+
+// interleaves two rows of width samples into a row of pairs.
+static void interleaveRows(const uint8_t* row0, const uint8_t* row1,
+                           uint32_t width, uint8_t* output) {
+    __m128i value0, value1;
+
+    uint32_t index = 0;
+    for (; index + 16 <= width; index += 16) {
+        value0 = _mm_loadu_si128((__m128i const*)(row0 + index));
+        value1 = _mm_loadu_si128((__m128i const*)(row1 + index));
+        _mm_storeu_si128((__m128i*)(output + index * 2),
+                         _mm_unpacklo_epi8(value0, value1));
+        _mm_storeu_si128((__m128i*)(output + index * 2 + 16),
+                         _mm_unpackhi_epi8(value0, value1));
+    }
+
+    for (; index < width; ++index) {
+        output[index * 2] = row0[index];
+        output[index * 2 + 1] = row1[index];
+    }
+}
+
+/* Writes the Y rows from row up to row_end whose component rows are ready as
+ * convertRows() does, and a row of the chroma planes behind the Y plane for
+ * every 2 rows, of I420 or NV12. The chroma of 4:2:0 is copied out of the
+ * component planes, other sampling is upsampled to full resolution and
+ * averaged over 2x2 pixels, the upper row of a pair waiting in the band of
+ * chroma_rows_. Gray images get neutral chroma.
+ */
+void JpegDecoder::convertYuvRows(SampleData *samples, uint32_t &row,
+                                 uint32_t row_end, uint32_t band,
+                                 int32_t stride, uint8_t* image) {
+    uint32_t chroma_width  = (width_ + 1) >> 1;
+    uint32_t chroma_height = (height_ + 1) >> 1;
+    int32_t chroma_stride = mode_ == IMREAD_I420 ? stride / 2 : stride;
+    uint8_t* chroma_planes = image + (size_t)stride * height_;
+    bool halved = decode_n_ == 3 && samples[1].hs == 2 && samples[1].vs == 2;
+    uint8_t* pending[2] = { NULL, NULL };
+    uint8_t* averaged[2] = { NULL, NULL };
+    if (decode_n_ == 3) {
+        uint8_t* rows = chroma_rows_ + (size_t)width_ * 4 * band;
+        pending[0]  = rows;
+        pending[1]  = rows + width_;
+        averaged[0] = rows + width_ * 2;
+        averaged[1] = averaged[0] + chroma_width;
+    }
+    uint32_t k;
+    uint8_t *output[3] = { NULL, NULL, NULL };
+
+    for (; row < row_end; ++row) {
+        for (k = 0; k < decode_n_; ++k) {
+            if (samples[k].line1 >= samples[k].ready_rows) return;
+        }
+
+        bool even = (row & 1) == 0;
+        for (k = 0; k < decode_n_; ++k) {
+            SampleData *sample = &samples[k];
+            uint32_t w2 = jpeg_->img_comp[k].out_w2;
+            uint8_t *line0 = jpeg_->img_comp[k].data +
+                             (sample->line0 % sample->ring_rows) * w2;
+            uint8_t *line1 = jpeg_->img_comp[k].data +
+                             (sample->line1 % sample->ring_rows) * w2;
+            if (k > 0 && halved) {
+                output[k] = line1;  // the chroma row of an even row
+            }
+            else {
+                int32_t y_bot = sample->ystep >= (sample->vs >> 1);
+                output[k] = sample->resample(sample->line_buffer,
+                                             y_bot ? line1 : line0,
+                                             y_bot ? line0 : line1,
+                                             sample->w_lores, sample->hs);
+            }
+            advanceSampling(sample, jpeg_->img_comp[k].out_y);
+        }
+        memcpy(image + stride * row, output[0], width_);
+
+        uint8_t* chroma_row = chroma_planes + (row >> 1) * chroma_stride;
+        uint8_t* u = output[1];
+        uint8_t* v = output[2];
+        if (decode_n_ == 1) {
+            if (!even) continue;
+            memset(chroma_row, 128, chroma_width *
+                   (mode_ == IMREAD_I420 ? 1 : 2));
+            if (mode_ == IMREAD_I420) {
+                memset(chroma_row + chroma_stride * chroma_height, 128,
+                       chroma_width);
+            }
+            continue;
+        }
+        else if (halved) {
+            if (!even) continue;
+        }
+        else if (even && row + 1 < height_) {
+            memcpy(pending[0], u, width_);
+            memcpy(pending[1], v, width_);
+            continue;
+        }
+        else {
+            averageRows(even ? u : pending[0], u, width_, averaged[0]);
+            averageRows(even ? v : pending[1], v, width_, averaged[1]);
+            u = averaged[0];
+            v = averaged[1];
+        }
+
+        if (mode_ == IMREAD_I420) {
+            memcpy(chroma_row, u, chroma_width);
+            memcpy(chroma_row + chroma_stride * chroma_height, v,
+                   chroma_width);
+        }
+        else {
+            interleaveRows(u, v, chroma_width, chroma_row);
+        }
+    }
+}
+
+/* Puts the rows first ~ last of a height x width image in their place after
+ * the Exif orientation is applied, image being the upright one.
+ */
+template <int32_t nc>
+static void uprightRows(uint32_t orientation, uint32_t height, uint32_t width,
+                        uint8_t* rows, uint32_t first, uint32_t last,
+                        int32_t stride, uint8_t* image) {
+    int32_t count = last - first;
+    int32_t rows_stride = width * nc;
+    switch (orientation) {
+        case 2:  // mirrored horizontally
+            Flip<uint8_t, nc>(count, width, rows_stride, rows, stride,
+                              image + first * stride, 1);
+            break;
+        case 3:  // rotated 180 degrees
+            RotateNx90degree<uint8_t, nc>(count, width, rows_stride, rows,
+                                          count, width, stride,
+                                          image + (height - last) * stride,
+                                          180);
+            break;
+        case 4:  // mirrored vertically
+            Flip<uint8_t, nc>(count, width, rows_stride, rows, stride,
+                              image + (height - last) * stride, 0);
+            break;
+        case 5:  // mirrored along the top-left to bottom-right diagonal
+            Transpose<uint8_t, nc>(count, width, rows_stride, rows, stride,
+                                   image + first * nc);
+            break;
+        case 6:  // rotated 90 degrees clockwise
+            RotateNx90degree<uint8_t, nc>(count, width, rows_stride, rows,
+                                          width, count, stride,
+                                          image + (height - last) * nc, 90);
+            break;
+        case 7: {  // mirrored along the top-right to bottom-left diagonal
+            uint8_t* flipped = rows + UPRIGHT_BAND_ROWS * rows_stride;
+            Flip<uint8_t, nc>(count, width, rows_stride, rows, rows_stride,
+                              flipped, 1);
+            RotateNx90degree<uint8_t, nc>(count, width, rows_stride, flipped,
+                                          width, count, stride,
+                                          image + (height - last) * nc, 90);
+            break;
+        }
+        case 8:  // rotated 90 degrees counterclockwise
+            RotateNx90degree<uint8_t, nc>(count, width, rows_stride, rows,
+                                          width, count, stride,
+                                          image + first * nc, 270);
+            break;
+        default:
+            break;
+    }
+}
+
+/* Converts the rows as convertRows() does. With the orientation applied, the
+ * rows are converted into a band of UPRIGHT_BAND_ROWS rows instead, which is
+ * flipped, rotated or transposed into the image while it is still in cache,
+ * whenever it is full and at row_end. The bands of a thread start at
+ * row_begin. A row consumer gets the rows one by one out of a row buffer.
+ */
+void JpegDecoder::storeRows(SampleData *samples, YCrCb2BGR *ycrcb2bgr,
+                            uint32_t &row, uint32_t row_end,
+                            uint32_t row_begin, uint32_t band, int32_t stride,
+                            uint8_t* image) {
+    if (mode_ == IMREAD_I420 || mode_ == IMREAD_NV12) {
+        convertYuvRows(samples, row, row_end, band, stride, image);
+        return;
+    }
+    if (consumer_ != nullptr) {
+        while (row < row_end) {
+            uint32_t current = row;
+            convertRows(samples, ycrcb2bgr, row, row + 1, 0, consumer_row_);
+            if (row == current) return;  // the component rows are not ready.
+            consumer_->consumeRow(consumer_row_);
+        }
+        return;
+    }
+    if (!upright_) {
+        convertRows(samples, ycrcb2bgr, row, row_end, stride, image);
+        return;
+    }
+
+    size_t band_stride = (size_t)width_ * channels_;
+    size_t band_size = UPRIGHT_BAND_ROWS * band_stride *
+                       (jpeg_->orientation == 7 ? 2 : 1);
+    uint8_t* rows = upright_bands_ + band * band_size;
+    while (row < row_end) {
+        uint32_t current = row;
+        convertRows(samples, ycrcb2bgr, row, row + 1, 0,
+                    rows + (current - row_begin) % UPRIGHT_BAND_ROWS *
+                    band_stride);
+        if (row == current) return;  // the component rows are not ready.
+
+        if ((row - row_begin) % UPRIGHT_BAND_ROWS == 0 || row == row_end) {
+            uint32_t first = row - ((row - row_begin - 1) %
+                                    UPRIGHT_BAND_ROWS + 1);
+            if (channels_ == 1) {
+                uprightRows<1>(jpeg_->orientation, height_, width_, rows,
+                               first, row, stride, image);
             }
+            else {
+                uprightRows<3>(jpeg_->orientation, height_, width_, rows,
+                               first, row, stride, image);
+            }
+        }
+    }
+}
+
+// converts the output rows of a band with its own sampling state and buffers.
+void JpegDecoder::convertBand(int32_t stride, uint8_t* image,
+                              uint32_t row_begin, uint32_t row_end,
+                              uint32_t band) {
+    SampleData samples[4];
+    for (uint32_t k = 0; k < decode_n_; ++k) {
+        samples[k] = samples_[k];
+        samples[k].line_buffer += (width_ + 3) * band;
+        for (uint32_t row = 0; row < row_begin; ++row) {
+            advanceSampling(&samples[k], jpeg_->img_comp[k].out_y);
         }
     }
 
+    YCrCb2BGR ycrcb2bgr(width_, channels_);
+    uint32_t row = row_begin;
+    storeRows(samples, &ycrcb2bgr, row, row_end, row_begin, band, stride,
+              image);
+}
+
+/* The whole component planes are ready, the output rows are split into
+ * bands converted by parallel threads, unless a consumer takes them in order.
+ */
+bool JpegDecoder::convertColor(int32_t stride, uint8_t* image) {
+    uint32_t bands = height_ < hardware_threads_ ? height_ : hardware_threads_;
+    bands = bands == 0 || consumer_ != nullptr ? 1 : bands;
+    uint32_t ring_rows[4];
+    for (uint32_t k = 0; k < jpeg_->components; ++k) {
+        ring_rows[k] = jpeg_->img_comp[k].out_h2;
+    }
+    if (!initializeSampling(jpeg_, ring_rows, bands)) {
+        return false;
+    }
+
+    for (uint32_t k = 0; k < decode_n_; ++k) {
+        samples_[k].ready_rows = jpeg_->img_comp[k].out_y;
+    }
+    if (bands == 1) {
+        storeRows(samples_, ycrcb2bgr_, output_row_, height_, 0, 0, stride,
+                  image);
+    }
+    else {
+        std::vector<std::thread> threads;
+        uint32_t interval = (height_ + bands - 1) / bands;
+        if (mode_ == IMREAD_I420 || mode_ == IMREAD_NV12) {
+            interval = (interval + 1) & ~1;  // a chroma row takes 2 rows.
+        }
+        uint32_t band = 0;
+        for (uint32_t row_begin = 0; row_begin < height_;
+             row_begin += interval, ++band) {
+            uint32_t row_end = row_begin + interval < height_ ?
+                               row_begin + interval : height_;
+            threads.push_back(std::thread(&JpegDecoder::convertBand, this,
+                              stride, image, row_begin, row_end, band));
+        }
+
+        for (auto &worker: threads) {
+            worker.join();
+        }
+    }
     freeComponents(jpeg_, jpeg_->components);
-    if (target_comps == 3 && jpeg_->components == 3 && !is_rgb) {
-        delete ycrcb2bgr_;
+
+    return true;
+}
+
+/* Converts the region out of component planes covering width_ x height_
+ * output pixels, in which it starts at (crop_x, crop_y). Each row goes
+ * through a row buffer, the rows above the region are only stepped over.
+ */
+bool JpegDecoder::convertRegion(int32_t stride, uint8_t* image,
+                                uint32_t crop_x, uint32_t crop_y) {
+    uint32_t ring_rows[4];
+    for (uint32_t k = 0; k < jpeg_->components; ++k) {
+        ring_rows[k] = jpeg_->img_comp[k].out_h2;
+    }
+    if (!initializeSampling(jpeg_, ring_rows, 1)) {
+        return false;
+    }
+    uint8_t* row_buffer = (uint8_t*)scratch_->reserve(JPEG_REGION_ROW,
+                                                      width_ * channels_);
+    if (row_buffer == nullptr) {
+        freeComponents(jpeg_, jpeg_->components);
+        LOG(ERROR) << "No enough memory to convert the region.";
+        return false;
     }
 
+    for (uint32_t k = 0; k < decode_n_; ++k) {
+        samples_[k].ready_rows = jpeg_->img_comp[k].out_y;
+        for (uint32_t row = 0; row < crop_y; ++row) {
+            advanceSampling(&samples_[k], jpeg_->img_comp[k].out_y);
+        }
+    }
+    YCrCb2BGR ycrcb2bgr(width_, channels_);
+    for (uint32_t row = 0; row < region_height_; ++row) {
+        uint32_t current = crop_y + row;
+        convertRows(samples_, &ycrcb2bgr, current, current + 1, 0, row_buffer);
+        memcpy(image + stride * row, row_buffer + crop_x * channels_,
+               region_width_ * channels_);
+    }
+    freeComponents(jpeg_, jpeg_->components);
+
     return true;
 }
 
 bool JpegDecoder::readHeader() {
+    if (jpeg_ == nullptr) {
+        return false;
+    }
+
     for (uint32_t i = 0; i < 4; i++) {
         jpeg_->img_comp[i].data  = nullptr;
         jpeg_->img_comp[i].coeff = nullptr;
     }
+    jpeg_->components = 0;
     jpeg_->restart_interval = 0;
     jpeg_->jfif = 0;
+    jpeg_->orientation = 1;
     // valid values are 0(Unknown, 3->RGB, 4->CMYK), 1(YCbCr), 2(YCCK)
     jpeg_->app14_color_transform = -1;
     jpeg_->progressive = false;
@@ -2130,6 +3540,10 @@ bool JpegDecoder::readHeader() {
     jpeg_->marker = NULL_MARKER;
     uint8_t marker = getMarker(jpeg_);
     while (marker != 0xDA && marker != 0xD9) {  // Start of scan or end of image
+        if (marker == NULL_MARKER) {
+            freeComponents(jpeg_, jpeg_->components);
+            return false;
+        }
         succeeded = processSegments(jpeg_, marker);
         if (!succeeded) {
             freeComponents(jpeg_, jpeg_->components);
@@ -2151,9 +3565,21 @@ bool JpegDecoder::readHeader() {
 }
 
 bool JpegDecoder::decodeData(uint32_t stride, uint8_t* image) {
+    chooseComponents(jpeg_);
+    YCrCb2BGR ycrcb2bgr(width_, channels_);
+    ycrcb2bgr_ = &ycrcb2bgr;
+
+    // the full component planes are only needed by progressive images and
+    // by baseline images split in several scans.
+    bool allocated = false, streamed = false;
     bool succeeded;
     uint8_t marker = getMarker(jpeg_);
     while (marker != 0xD9) {   // end of image
+        if (marker == NULL_MARKER) {
+            freeComponents(jpeg_, jpeg_->components);
+            LOG(ERROR) << "The image data ends without an end of image.";
+            return false;
+        }
         if (marker == 0xDA) {  // start of scan
             succeeded = parseSOS(jpeg_);
             if (!succeeded) {
@@ -2161,8 +3587,39 @@ bool JpegDecoder::decodeData(uint32_t stride, uint8_t* image) {
                 LOG(ERROR) << "Failed to parse the start of scan segment.";
                 return false;
             }
+            if (streamed) {
+                LOG(ERROR) << "Unexpected scan after the image data.";
+                return false;
+            }
 
-            succeeded = parseEntropyCodedData(jpeg_);
+            if (!jpeg_->progressive && !allocated &&
+                jpeg_->scan_n == jpeg_->components) {
+                if (region_width_ > 0) {
+                    // nothing behind the region is needed.
+                    succeeded = decodeRegionScan(jpeg_, stride, image);
+                    if (succeeded) {
+                        ycrcb2bgr_ = nullptr;
+                        return true;
+                    }
+                }
+                else if (interval_threads_ > 1 && locateIntervals(jpeg_)) {
+                    succeeded = decodeIntervals(jpeg_, stride, image);
+                }
+                else {
+                    succeeded = decodeScanRows(jpeg_, stride, image);
+                }
+                streamed = true;
+            }
+            else {
+                if (!allocated) {
+                    succeeded = allocateComponents(jpeg_);
+                    if (!succeeded) {
+                        return false;
+                    }
+                    allocated = true;
+                }
+                succeeded = parseEntropyCodedData(jpeg_);
+            }
             if (!succeeded) {
                 freeComponents(jpeg_, jpeg_->components);
                 LOG(ERROR) << "Failed to decode the compressed data.";
@@ -2180,12 +3637,23 @@ bool JpegDecoder::decodeData(uint32_t stride, uint8_t* image) {
         marker = getMarker(jpeg_);
     }
 
+    if (streamed) {
+        ycrcb2bgr_ = nullptr;
+        return true;
+    }
+
     if (jpeg_->progressive) {
         finishProgressiveJpeg(jpeg_);
     }
 
-    succeeded = convertColor(stride, image);
+    if (region_width_ > 0) {
+        succeeded = convertRegion(stride, image, region_x_, region_y_);
+    }
+    else {
+        succeeded = convertColor(stride, image);
+    }
     freeComponents(jpeg_, jpeg_->components);
+    ycrcb2bgr_ = nullptr;
     if (!succeeded) {
         LOG(ERROR) << "Failed to sample and convert YCrCb data to the target"
                    << " color format.";
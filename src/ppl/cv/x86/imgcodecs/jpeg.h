@@ -20,6 +20,8 @@
 
 #include "imagecodecs.h"
 #include "bytesreader.h"
+#include "decoderscratch.h"
+#include "byteswriter.h"
 
 #include <stdint.h>
 
@@ -34,17 +36,22 @@ namespace x86 {
 #define BUFFER_BITS 64
 #define MAX_BITS 16
 #define LOOKAHEAD_BITS 9
+// output rows turned upright together when the Exif orientation is applied
+#define UPRIGHT_BAND_ROWS 64
 
 typedef uint8_t *(*resampleRow)(uint8_t *out, uint8_t *in0, uint8_t *in1,
                                 uint32_t width, uint32_t hs);
 
 typedef struct {
     resampleRow resample;
-    uint8_t *line0, *line1;
+    uint32_t line0, line1;  // component rows feeding the current output row
+    uint32_t ring_rows;     // rows held by the component buffer
+    uint32_t ready_rows;    // component rows decoded so far
     uint32_t hs, vs;   // expansion factor in each axis
     uint32_t w_lores;  // horizontal pixels pre-expansion
     uint32_t ystep;    // how far through vertical expansion we are
     uint32_t ypos;     // which pre-expansion row we're on
+    uint8_t *line_buffer;
 } SampleData;
 
 typedef struct {
@@ -72,8 +79,9 @@ typedef struct {
         int32_t dc_pred;
 
         uint32_t x, y, w2, h2, coeff_w;
+        uint32_t block_size;             // pixels out of a block per axis
+        uint32_t out_y, out_w2, out_h2;  // plane produced by the scaled IDCT
         uint8_t *data;    // sequentially stored mcu data of YCrCb
-        uint8_t *line_buffer;
         int16_t *coeff;   // progressive only
     } img_comp[4];
 
@@ -81,6 +89,7 @@ typedef struct {
     uint32_t code_bits;    // number of valid bits
     uint8_t marker;        // marker seen while filling entropy buffer
     uint32_t nomore;       // flag if we saw a marker so must stop
+    bool prefix_ff;        // the last loaded byte is a pending 0xFF
 
     bool progressive;
     uint32_t index_start;
@@ -89,6 +98,7 @@ typedef struct {
     uint32_t succ_low;
     uint32_t eob_run;
     uint32_t jfif;
+    uint32_t orientation;           // Exif orientation tag, 1 when upright
     int32_t app14_color_transform;  // Adobe APP14 tag
     int32_t rgb;
 
@@ -125,16 +135,25 @@ class YCrCb2BGR {
 
 class JpegDecoder : public ImageDecoder {
   public:
-    JpegDecoder(BytesReader& file_data);
+    JpegDecoder(BytesReader& file_data, DecoderScratch& scratch);
     ~JpegDecoder();
 
     bool readHeader() override;
+    void setScale(uint32_t denominator) override;
+    bool setRegion(uint32_t x, uint32_t y, uint32_t width,
+                   uint32_t height) override;
+    void setUpright(bool upright) override;
+    bool setMode(ImreadModes mode) override;
+    bool setRowConsumer(RowConsumer* consumer) override;
     bool decodeData(uint32_t stride, uint8_t* image) override;
 
   private:
     bool parseAPP0(JpegDecodeData *jpeg);
+    bool parseAPP1(JpegDecodeData *jpeg);
     bool parseAPP14(JpegDecodeData *jpeg);
     bool parseSOF(JpegDecodeData *jpeg);
+    void scaleComponents(JpegDecodeData *jpeg);
+    bool allocateComponents(JpegDecodeData *jpeg);
     bool parseSOS(JpegDecodeData *jpeg);
     bool parseDQT(JpegDecodeData *jpeg);
     bool buildHuffmanTable(HuffmanLookupTable *huffman_table, uint32_t *count);
@@ -148,16 +167,27 @@ class JpegDecoder : public ImageDecoder {
     void freeComponents(JpegDecodeData *jpeg, uint32_t ncomp);
     void resetJpegDecoder(JpegDecodeData *jpeg);
     uint8_t getMarker(JpegDecodeData *jpeg);
-    int32_t decodeHuffmanData(JpegDecodeData *jpeg,
+    bool restartDecoder(BytesReader *file_data, JpegDecodeData *jpeg);
+    int32_t decodeHuffmanData(BytesReader *file_data, JpegDecodeData *jpeg,
                               HuffmanLookupTable *huffman_table);
-    bool decodeBlock(JpegDecodeData *jpeg, int16_t decoded_data[64],
+    bool decodeBlock(BytesReader *file_data, JpegDecodeData *jpeg,
+                     int16_t decoded_data[64],
                      HuffmanLookupTable *huffman_dc,
                      HuffmanLookupTable *huffman_ac,
-                     uint32_t component_id, uint16_t *dequant_table);
-    void idctDecodeBlock(uint8_t *output, int32_t out_stride, int16_t data[64]);
+                     uint32_t component_id);
+    bool skipBlock(BytesReader *file_data, JpegDecodeData *jpeg,
+                   HuffmanLookupTable *huffman_dc,
+                   HuffmanLookupTable *huffman_ac, uint32_t component_id);
+    void idctDecodeBlock(uint8_t *output, int32_t out_stride,
+                         const int16_t data[64],
+                         const uint16_t *dequant_table);
+    void idctDecodeRow(uint8_t *output, int32_t out_stride,
+                       const int16_t *data, uint32_t blocks,
+                       const uint16_t *dequant_table, uint32_t block_size);
     void idctprocess0(JpegDecodeData *jpeg, int16_t* buffer, uint8_t* output,
                       uint32_t height_begin, uint32_t height_end,
-                      uint32_t width, uint32_t width2);
+                      uint32_t width, uint32_t width2,
+                      const uint16_t *dequant_table, uint32_t block_size);
     bool decodeProgressiveDCBlock(JpegDecodeData *jpeg,
                                   int16_t decoded_data[64],
                                   HuffmanLookupTable *huffman_dc,
@@ -166,17 +196,172 @@ class JpegDecoder : public ImageDecoder {
                                   int16_t decoded_data[64],
                                   HuffmanLookupTable *huffman_ac);
     bool parseEntropyCodedData(JpegDecodeData *jpeg);
-    void dequantizeData(int16_t *data, uint16_t *dequant_table);
+    bool decodeScanRows(JpegDecodeData *jpeg, int32_t stride, uint8_t* image);
+    bool locateIntervals(JpegDecodeData *jpeg);
+    void decodeIntervalRange(JpegDecodeData *jpeg, const uint8_t* data,
+                             uint32_t size, uint32_t mcu_begin,
+                             uint32_t mcu_end, int16_t** blocks,
+                             bool* succeeded);
+    bool decodeIntervals(JpegDecodeData *jpeg, int32_t stride,
+                         uint8_t* image);
+    bool decodeRegionScan(JpegDecodeData *jpeg, int32_t stride,
+                          uint8_t* image);
     void idctprocess1(JpegDecodeData *jpeg, uint32_t height_begin,
                       uint32_t height_end, uint32_t width, uint32_t comp_id,
                       uint32_t width2);
     void finishProgressiveJpeg(JpegDecodeData *jpeg);
+    void chooseComponents(JpegDecodeData *jpeg);
+    bool initializeSampling(JpegDecodeData *jpeg, const uint32_t ring_rows[4],
+                            uint32_t bands);
+    void convertRows(SampleData *samples, YCrCb2BGR *ycrcb2bgr,
+                     uint32_t &row, uint32_t row_end, int32_t stride,
+                     uint8_t* image);
+    void convertYuvRows(SampleData *samples, uint32_t &row, uint32_t row_end,
+                        uint32_t band, int32_t stride, uint8_t* image);
+    void storeRows(SampleData *samples, YCrCb2BGR *ycrcb2bgr, uint32_t &row,
+                   uint32_t row_end, uint32_t row_begin, uint32_t band,
+                   int32_t stride, uint8_t* image);
+    void convertBand(int32_t stride, uint8_t* image, uint32_t row_begin,
+                     uint32_t row_end, uint32_t band);
     bool convertColor(int32_t stride, uint8_t* image);
+    bool convertRegion(int32_t stride, uint8_t* image, uint32_t crop_x,
+                       uint32_t crop_y);
 
   private:
     BytesReader* file_data_;
+    DecoderScratch* scratch_;
     JpegDecodeData* jpeg_;
     YCrCb2BGR* ycrcb2bgr_;
+    SampleData samples_[4];
+    uint32_t decode_n_, target_comps_, is_rgb_;
+    ImreadModes mode_;
+    uint8_t* chroma_rows_;  // a pair of chroma rows pending for each thread
+    RowConsumer* consumer_;   // takes the rows instead of the image
+    uint8_t* consumer_row_;
+    uint32_t output_row_;
+    uint32_t *intervals_;    // offsets of the restart intervals in the scan
+    uint32_t interval_count_;
+    uint32_t region_x_, region_y_;  // region of the output to decode alone
+    uint32_t region_width_, region_height_;
+    bool upright_;         // the Exif orientation is applied to the output
+    uint8_t* upright_bands_;  // a band of converted rows for each thread
+    uint32_t hardware_threads_;  // threads of the bands, 4 at most
+    uint32_t interval_threads_;  // threads of the restart intervals
+    uint32_t image_width_, image_height_;
+    uint32_t block_size_;  // 8 / scale denominator, pixels out of a block of
+                           // the components with the largest sampling
+};
+
+// the layouts of the chroma samples the encoder writes
+enum JpegSubsampling {
+    SUBSAMPLING_420 = 0,
+    SUBSAMPLING_422 = 1,
+    SUBSAMPLING_444 = 2,
+};
+
+/* Division of the coefficients through a quantization table without
+ * division, (|x| + corrections) * reciprocals >> 16 * scales >> 16, see
+ * computeDivisors().
+ */
+typedef struct {
+    uint16_t reciprocals[64];
+    uint16_t corrections[64];
+    uint16_t scales[64];
+} QuantDivisors;
+
+typedef struct {
+    uint8_t bits[17];       // count of the codes of each length
+    uint8_t values[256];    // symbols in the order of their codes
+    uint16_t codes[256];
+    uint8_t lengths[256];
+} HuffmanCodeTable;
+
+typedef struct {
+    uint32_t dc[2][257];    // 256 is reserved so no code is all 1 bits
+    uint32_t ac[2][257];
+} HuffmanCounts;
+
+class BGR2YCrCb {
+  public:
+    BGR2YCrCb(uint32_t width, uint32_t channels, uint32_t hsampling,
+              uint32_t vsampling);
+    ~BGR2YCrCb();
+
+    void convertRows(uint8_t const *src0, uint8_t const *src1, uint8_t *y0,
+                     uint8_t *y1, uint8_t *cb, uint8_t *cr) const;
+
+  private:
+    void load16Pixels(uint8_t const *src, __m128i &b, __m128i &g,
+                      __m128i &r) const;
+    __m128i convertLuma(__m128i b, __m128i g, __m128i r) const;
+    void convertChroma(__m128i b16s, __m128i g16s, __m128i r16s,
+                       __m128i &cb16s, __m128i &cr16s) const;
+
+  private:
+    uint32_t width_, channels_;
+    uint32_t hsampling_, vsampling_;
+    uint32_t chroma_shift_;  // 14 + log2 of the pixels summed for a sample
+    __m128i luma_const0_, luma_const1_;
+    __m128i cb_const0_, cb_const1_;
+    __m128i cr_const0_, cr_const1_;
+    __m128i chroma_bias_;
+};
+
+class JpegEncoder : public ImageEncoder {
+  public:
+    JpegEncoder(BytesWriter& file_data, int32_t quality, int32_t subsampling,
+                int32_t restart_interval, bool optimize);
+    ~JpegEncoder();
+
+    bool isChannelsSupported(uint32_t channels) const override;
+    bool encodeData(uint32_t height, uint32_t width, uint32_t channels,
+                    uint32_t stride, const uint8_t* image) override;
+
+  private:
+    void setComponents(uint32_t height, uint32_t width, uint32_t channels);
+    void setQuantTables();
+    void setHuffmanTable(HuffmanCodeTable *table, const uint8_t *bits,
+                         const uint8_t *values);
+    void optimizeHuffmanTable(HuffmanCodeTable *table, uint32_t counts[257]);
+    void putHeaders();
+    void putHuffmanTables();
+    void putScanHeader();
+    void convertRows(uint32_t mcu_row, uint8_t* planes);
+    void transformRow(uint8_t* planes, int16_t* blocks);
+    void transformBand(uint32_t mcu_row_begin, uint32_t mcu_row_end,
+                       bool* succeeded);
+    void countMcus(uint32_t mcu_begin, uint32_t mcu_end,
+                   HuffmanCounts* counts);
+    void encodeMcus(uint32_t mcu_begin, uint32_t mcu_end, BytesWriter* output,
+                    bool* succeeded);
+    bool transformImage();
+    bool countSymbols();
+    bool encodeScan();
+
+  private:
+    BytesWriter* file_data_;
+    int32_t quality_;
+    int32_t subsampling_;
+    uint32_t restart_interval_;  // MCUs of an interval, 0 without restarts
+    bool optimize_;              // Huffman tables built for the image
+
+    const uint8_t* image_;
+    uint32_t height_, width_, channels_, stride_;
+    BGR2YCrCb* bgr2ycrcb_;
+    uint32_t components_;
+    uint32_t hsampling_, vsampling_;  // of the luma, the chroma are 1x1
+    uint32_t mcu_width_, mcu_height_;
+    uint32_t mcus_x_, mcus_y_;
+    uint32_t blocks_per_mcu_;
+    uint32_t plane_strides_[3];
+    uint32_t plane_offsets_[3];
+    uint32_t planes_size_;
+
+    uint8_t quant_tables_[2][64];   // natural order, 0 luma and 1 chroma
+    QuantDivisors divisors_[2];
+    HuffmanCodeTable dc_tables_[2];
+    HuffmanCodeTable ac_tables_[2];
+    int16_t* coefficients_;         // all the MCUs when optimize_ is set
     uint32_t hardware_threads_;
 };
 
@@ -0,0 +1,1375 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "jpeg.h"
+#include "codecs.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <immintrin.h>
+#include <thread>
+#include <vector>
+
+#include "ppl/cv/x86/fma/internal_fma.hpp"
+#include "ppl/common/x86/sysinfo.h"
+#include "ppl/common/log.h"
+
+using namespace ppl::common;
+
+namespace ppl {
+namespace cv {
+namespace x86 {
+
+// derived from jfdctint -- DCT_ISLOW
+#define CONST_BITS 13
+#define PASS1_BITS 2
+
+#define FIX_0_298631336 2446
+#define FIX_0_390180644 3196
+#define FIX_0_541196100 4433
+#define FIX_0_765366865 6270
+#define FIX_0_899976223 7373
+#define FIX_1_175875602 9633
+#define FIX_1_501321110 12299
+#define FIX_1_847759065 15137
+#define FIX_1_961570560 16069
+#define FIX_2_053119869 16819
+#define FIX_2_562915447 20995
+#define FIX_3_072711026 25172
+
+// full range YCbCr of JFIF in 14 bit fixed point.
+#define Y_B 1868
+#define Y_G 9617
+#define Y_R 4899
+#define CB_G -5427
+#define CB_R -2765
+#define CR_G -6860
+#define CR_B -1332
+#define CHROMA_HALF 8192
+
+#define ENTROPY_BUFFER_SIZE (1 << 16)
+// 6 blocks of 64 codes of at most 27 bits, each byte possibly stuffed
+#define MAX_MCU_BYTES 4096
+#define RST0_MARKER 0xD0
+
+// the natural index of the k-th coefficient in the zigzag order.
+static const uint8_t zigzag_indices[64] = {
+    0,  1,  8, 16,  9,  2,  3, 10,
+   17, 24, 32, 25, 18, 11,  4,  5,
+   12, 19, 26, 33, 40, 48, 41, 34,
+   27, 20, 13,  6,  7, 14, 21, 28,
+   35, 42, 49, 56, 57, 50, 43, 36,
+   29, 22, 15, 23, 30, 37, 44, 51,
+   58, 59, 52, 45, 38, 31, 39, 46,
+   53, 60, 61, 54, 47, 55, 62, 63,
+};
+
+// the tables of Annex K of the standard, in natural order.
+static const uint8_t luma_quant_table[64] = {
+   16, 11, 10, 16,  24,  40,  51,  61,
+   12, 12, 14, 19,  26,  58,  60,  55,
+   14, 13, 16, 24,  40,  57,  69,  56,
+   14, 17, 22, 29,  51,  87,  80,  62,
+   18, 22, 37, 56,  68, 109, 103,  77,
+   24, 35, 55, 64,  81, 104, 113,  92,
+   49, 64, 78, 87, 103, 121, 120, 101,
+   72, 92, 95, 98, 112, 100, 103,  99,
+};
+
+static const uint8_t chroma_quant_table[64] = {
+   17, 18, 24, 47, 99, 99, 99, 99,
+   18, 21, 26, 66, 99, 99, 99, 99,
+   24, 26, 56, 99, 99, 99, 99, 99,
+   47, 66, 99, 99, 99, 99, 99, 99,
+   99, 99, 99, 99, 99, 99, 99, 99,
+   99, 99, 99, 99, 99, 99, 99, 99,
+   99, 99, 99, 99, 99, 99, 99, 99,
+   99, 99, 99, 99, 99, 99, 99, 99,
+};
+
+static const uint8_t luma_dc_bits[17] = {
+    0, 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0,
+};
+
+static const uint8_t chroma_dc_bits[17] = {
+    0, 0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0,
+};
+
+static const uint8_t dc_values[12] = {
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11,
+};
+
+static const uint8_t luma_ac_bits[17] = {
+    0, 0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d,
+};
+
+static const uint8_t luma_ac_values[162] = {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06,
+    0x13, 0x51, 0x61, 0x07, 0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08,
+    0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0, 0x24, 0x33, 0x62, 0x72,
+    0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45,
+    0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59,
+    0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75,
+    0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3,
+    0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6,
+    0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9,
+    0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+    0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa,
+};
+
+static const uint8_t chroma_ac_bits[17] = {
+    0, 0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77,
+};
+
+static const uint8_t chroma_ac_values[162] = {
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41,
+    0x51, 0x07, 0x61, 0x71, 0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91,
+    0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0, 0x15, 0x62, 0x72, 0xd1,
+    0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+    0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44,
+    0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58,
+    0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74,
+    0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a,
+    0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4,
+    0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7,
+    0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa,
+};
+
+static inline uint32_t highestBit(uint32_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 31 - __builtin_clz(value);
+#else
+    uint32_t bit = 0;
+    while (value >>= 1) {
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+static inline uint32_t lowestBit(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(value);
+#else
+    uint32_t bit = 0;
+    while ((value & 1) == 0) {
+        value >>= 1;
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+// the count of bits of |value| and the bits sent for value.
+static inline uint32_t getValueBits(int32_t value, uint32_t* bits) {
+    uint32_t magnitude = value < 0 ? -value : value;
+    if (magnitude == 0) {
+        *bits = 0;
+        return 0;
+    }
+    uint32_t count = highestBit(magnitude) + 1;
+    *bits = (uint32_t)(value - (value < 0)) & ((1u << count) - 1);
+
+    return count;
+}
+
+static inline __m128i fdctConstants(int16_t x, int16_t y) {
+    return _mm_set1_epi32((int32_t)(((uint32_t)(uint16_t)y << 16) |
+                                    (uint16_t)x));
+}
+
+// x * c.x + y * c.y of the 8 pairs, descaled and packed to 16 bits.
+static inline __m128i fdctRotate(__m128i x, __m128i y, __m128i c,
+                                 __m128i bias, int32_t shift) {
+    __m128i low  = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(x, y), c),
+                                 bias);
+    __m128i high = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(x, y), c),
+                                 bias);
+
+    return _mm_packs_epi32(_mm_srai_epi32(low, shift),
+                           _mm_srai_epi32(high, shift));
+}
+
+static inline void transpose8x8(__m128i rows[8]) {
+    __m128i a0 = _mm_unpacklo_epi16(rows[0], rows[1]);
+    __m128i a1 = _mm_unpackhi_epi16(rows[0], rows[1]);
+    __m128i a2 = _mm_unpacklo_epi16(rows[2], rows[3]);
+    __m128i a3 = _mm_unpackhi_epi16(rows[2], rows[3]);
+    __m128i a4 = _mm_unpacklo_epi16(rows[4], rows[5]);
+    __m128i a5 = _mm_unpackhi_epi16(rows[4], rows[5]);
+    __m128i a6 = _mm_unpacklo_epi16(rows[6], rows[7]);
+    __m128i a7 = _mm_unpackhi_epi16(rows[6], rows[7]);
+    __m128i b0 = _mm_unpacklo_epi32(a0, a2);
+    __m128i b1 = _mm_unpackhi_epi32(a0, a2);
+    __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+    __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+    __m128i b4 = _mm_unpacklo_epi32(a4, a6);
+    __m128i b5 = _mm_unpackhi_epi32(a4, a6);
+    __m128i b6 = _mm_unpacklo_epi32(a5, a7);
+    __m128i b7 = _mm_unpackhi_epi32(a5, a7);
+    rows[0] = _mm_unpacklo_epi64(b0, b4);
+    rows[1] = _mm_unpackhi_epi64(b0, b4);
+    rows[2] = _mm_unpacklo_epi64(b1, b5);
+    rows[3] = _mm_unpackhi_epi64(b1, b5);
+    rows[4] = _mm_unpacklo_epi64(b2, b6);
+    rows[5] = _mm_unpackhi_epi64(b2, b6);
+    rows[6] = _mm_unpacklo_epi64(b3, b7);
+    rows[7] = _mm_unpackhi_epi64(b3, b7);
+}
+
+/* One dimensional transform of the samples data[0] ~ data[7] of 8 lines. The
+ * first pass keeps PASS1_BITS more bits, the second one removes them with the
+ * factor 8 of the transform left in the outputs.
+ */
+static inline void fdctPass(__m128i data[8], bool first_pass) {
+    int32_t shift = first_pass ? CONST_BITS - PASS1_BITS :
+                                 CONST_BITS + PASS1_BITS;
+    __m128i bias = _mm_set1_epi32(1 << (shift - 1));
+
+    __m128i tmp0 = _mm_add_epi16(data[0], data[7]);
+    __m128i tmp7 = _mm_sub_epi16(data[0], data[7]);
+    __m128i tmp1 = _mm_add_epi16(data[1], data[6]);
+    __m128i tmp6 = _mm_sub_epi16(data[1], data[6]);
+    __m128i tmp2 = _mm_add_epi16(data[2], data[5]);
+    __m128i tmp5 = _mm_sub_epi16(data[2], data[5]);
+    __m128i tmp3 = _mm_add_epi16(data[3], data[4]);
+    __m128i tmp4 = _mm_sub_epi16(data[3], data[4]);
+
+    // even part
+    __m128i tmp10 = _mm_add_epi16(tmp0, tmp3);
+    __m128i tmp13 = _mm_sub_epi16(tmp0, tmp3);
+    __m128i tmp11 = _mm_add_epi16(tmp1, tmp2);
+    __m128i tmp12 = _mm_sub_epi16(tmp1, tmp2);
+    if (first_pass) {
+        data[0] = _mm_slli_epi16(_mm_add_epi16(tmp10, tmp11), PASS1_BITS);
+        data[4] = _mm_slli_epi16(_mm_sub_epi16(tmp10, tmp11), PASS1_BITS);
+    }
+    else {
+        __m128i round = _mm_set1_epi16(1 << (PASS1_BITS - 1));
+        data[0] = _mm_srai_epi16(_mm_add_epi16(_mm_add_epi16(tmp10, tmp11),
+                                 round), PASS1_BITS);
+        data[4] = _mm_srai_epi16(_mm_add_epi16(_mm_sub_epi16(tmp10, tmp11),
+                                 round), PASS1_BITS);
+    }
+    data[2] = fdctRotate(tmp13, tmp12,
+                         fdctConstants(FIX_0_541196100 + FIX_0_765366865,
+                                       FIX_0_541196100), bias, shift);
+    data[6] = fdctRotate(tmp13, tmp12,
+                         fdctConstants(FIX_0_541196100,
+                                       FIX_0_541196100 - FIX_1_847759065),
+                         bias, shift);
+
+    // odd part, z3 and z4 are shared by the rotations of the outputs.
+    __m128i z3 = _mm_add_epi16(tmp4, tmp6);
+    __m128i z4 = _mm_add_epi16(tmp5, tmp7);
+    __m128i z_low  = _mm_unpacklo_epi16(z3, z4);
+    __m128i z_high = _mm_unpackhi_epi16(z3, z4);
+    __m128i z3_c = fdctConstants(FIX_1_175875602 - FIX_1_961570560,
+                                 FIX_1_175875602);
+    __m128i z4_c = fdctConstants(FIX_1_175875602,
+                                 FIX_1_175875602 - FIX_0_390180644);
+    __m128i z3_low  = _mm_add_epi32(_mm_madd_epi16(z_low, z3_c), bias);
+    __m128i z3_high = _mm_add_epi32(_mm_madd_epi16(z_high, z3_c), bias);
+    __m128i z4_low  = _mm_add_epi32(_mm_madd_epi16(z_low, z4_c), bias);
+    __m128i z4_high = _mm_add_epi32(_mm_madd_epi16(z_high, z4_c), bias);
+
+    __m128i t47_low  = _mm_unpacklo_epi16(tmp4, tmp7);
+    __m128i t47_high = _mm_unpackhi_epi16(tmp4, tmp7);
+    __m128i t56_low  = _mm_unpacklo_epi16(tmp5, tmp6);
+    __m128i t56_high = _mm_unpackhi_epi16(tmp5, tmp6);
+    __m128i c7 = fdctConstants(FIX_0_298631336 - FIX_0_899976223,
+                               -FIX_0_899976223);
+    __m128i c1 = fdctConstants(-FIX_0_899976223,
+                               FIX_1_501321110 - FIX_0_899976223);
+    __m128i c5 = fdctConstants(FIX_2_053119869 - FIX_2_562915447,
+                               -FIX_2_562915447);
+    __m128i c3 = fdctConstants(-FIX_2_562915447,
+                               FIX_3_072711026 - FIX_2_562915447);
+
+    data[7] = _mm_packs_epi32(
+        _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(t47_low, c7), z3_low),
+                       shift),
+        _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(t47_high, c7), z3_high),
+                       shift));
+    data[1] = _mm_packs_epi32(
+        _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(t47_low, c1), z4_low),
+                       shift),
+        _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(t47_high, c1), z4_high),
+                       shift));
+    data[5] = _mm_packs_epi32(
+        _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(t56_low, c5), z4_low),
+                       shift),
+        _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(t56_high, c5), z4_high),
+                       shift));
+    data[3] = _mm_packs_epi32(
+        _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(t56_low, c3), z3_low),
+                       shift),
+        _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(t56_high, c3), z3_high),
+                       shift));
+}
+
+// the rows are transformed, the transposed columns then, and quantized.
+static void fdctQuantizeBlock(const uint8_t* src, int32_t stride,
+                              const QuantDivisors* divisors, int16_t* dst) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i center = _mm_set1_epi16(128);
+    __m128i data[8];
+    for (int32_t i = 0; i < 8; i++) {
+        __m128i samples = _mm_loadl_epi64((const __m128i*)(src + i * stride));
+        data[i] = _mm_sub_epi16(_mm_unpacklo_epi8(samples, zero), center);
+    }
+
+    transpose8x8(data);
+    fdctPass(data, true);
+    transpose8x8(data);
+    fdctPass(data, false);
+
+    for (int32_t i = 0; i < 8; i++) {
+        __m128i reciprocal = _mm_loadu_si128(
+            (const __m128i*)(divisors->reciprocals + i * 8));
+        __m128i correction = _mm_loadu_si128(
+            (const __m128i*)(divisors->corrections + i * 8));
+        __m128i scale = _mm_loadu_si128(
+            (const __m128i*)(divisors->scales + i * 8));
+        __m128i sign  = _mm_srai_epi16(data[i], 15);
+        __m128i value = _mm_sub_epi16(_mm_xor_si128(data[i], sign), sign);
+        value = _mm_add_epi16(value, correction);
+        value = _mm_mulhi_epu16(value, reciprocal);
+        value = _mm_mulhi_epu16(value, scale);
+        value = _mm_sub_epi16(_mm_xor_si128(value, sign), sign);
+        _mm_storeu_si128((__m128i*)(dst + i * 8), value);
+    }
+}
+
+/* The divisors of the 8 times scaled coefficients, as those of libjpeg-turbo:
+ * with r = 16 + log2(divisor), |x| / divisor is rounded to
+ * (|x| + correction) * reciprocal >> r, a division by 2 ^ (r - 16) being
+ * left to the multiplication by the scale.
+ */
+static void computeDivisors(const uint8_t table[64], QuantDivisors* divisors) {
+    for (int32_t i = 0; i < 64; i++) {
+        uint32_t divisor = table[i] * 8;
+        uint32_t shift = 16 + highestBit(divisor);
+        uint32_t reciprocal = (1u << shift) / divisor;
+        uint32_t remainder  = (1u << shift) % divisor;
+        uint32_t correction = divisor / 2;
+        if (remainder == 0) {
+            reciprocal >>= 1;
+            shift--;
+        }
+        else if (remainder <= divisor / 2) {
+            correction++;
+        }
+        else {
+            reciprocal++;
+        }
+        divisors->reciprocals[i] = (uint16_t)reciprocal;
+        divisors->corrections[i] = (uint16_t)correction;
+        divisors->scales[i] = (uint16_t)(1u << (32 - shift));
+    }
+}
+
+/* The entropy-coded bytes are gathered in a buffer, with a 0 stuffed behind
+ * each 0xFF, and handed to the writer when less than an MCU of room is left.
+ */
+class HuffmanWriter {
+  public:
+    HuffmanWriter(BytesWriter* output) {
+        output_ = output;
+        buffer_ = (uint8_t*)malloc(ENTROPY_BUFFER_SIZE);
+        size_ = 0;
+        bit_buffer_ = 0;
+        bit_count_ = 0;
+    }
+
+    ~HuffmanWriter() {
+        free(buffer_);
+    }
+
+    bool isGood() const {
+        return buffer_ != nullptr;
+    }
+
+    // bits is no longer than 27 bits, a code and the bits of a value.
+    inline void putBits(uint32_t bits, uint32_t count) {
+        bit_buffer_ = (bit_buffer_ << count) | bits;
+        bit_count_ += count;
+        if (bit_count_ >= 32) {
+            bit_count_ -= 32;
+            putWord((uint32_t)(bit_buffer_ >> bit_count_));
+        }
+    }
+
+    // pads the last byte with 1 bits.
+    void alignBits() {
+        uint32_t padding = (8 - (bit_count_ & 7)) & 7;
+        if (padding > 0) {
+            putBits((1u << padding) - 1, padding);
+        }
+        while (bit_count_ >= 8) {
+            bit_count_ -= 8;
+            putByte((uint8_t)(bit_buffer_ >> bit_count_));
+        }
+    }
+
+    void putMarker(uint8_t marker) {
+        alignBits();
+        buffer_[size_++] = 0xFF;
+        buffer_[size_++] = marker;
+    }
+
+    void flushBuffer(bool force) {
+        if (force || size_ > ENTROPY_BUFFER_SIZE - MAX_MCU_BYTES) {
+            output_->putBytes(buffer_, size_);
+            size_ = 0;
+        }
+    }
+
+  private:
+    inline void putByte(uint8_t value) {
+        buffer_[size_++] = value;
+        if (value == 0xFF) {
+            buffer_[size_++] = 0;
+        }
+    }
+
+    inline void putWord(uint32_t value) {
+        // a byte of 0xFF is a zero byte of ~value.
+        uint32_t inverse = ~value;
+        if (((inverse - 0x01010101) & ~inverse & 0x80808080) == 0) {
+            uint8_t* data = buffer_ + size_;
+            data[0] = (uint8_t)(value >> 24);
+            data[1] = (uint8_t)(value >> 16);
+            data[2] = (uint8_t)(value >> 8);
+            data[3] = (uint8_t)value;
+            size_ += 4;
+        }
+        else {
+            putByte((uint8_t)(value >> 24));
+            putByte((uint8_t)(value >> 16));
+            putByte((uint8_t)(value >> 8));
+            putByte((uint8_t)value);
+        }
+    }
+
+  private:
+    BytesWriter* output_;
+    uint8_t* buffer_;
+    uint32_t size_;
+    uint64_t bit_buffer_;
+    uint32_t bit_count_;
+};
+
+// reorders a block in zigzag order and marks its nonzero coefficients.
+static inline uint64_t zigzagBlock(const int16_t* block, int16_t* zigzag) {
+    for (int32_t i = 0; i < 64; i++) {
+        zigzag[i] = block[zigzag_indices[i]];
+    }
+
+    __m128i zero = _mm_setzero_si128();
+    uint64_t zeros = 0;
+    for (int32_t i = 0; i < 4; i++) {
+        __m128i value0 = _mm_loadu_si128((const __m128i*)(zigzag + i * 16));
+        __m128i value1 = _mm_loadu_si128((const __m128i*)(zigzag + i * 16 +
+                                                          8));
+        __m128i bytes = _mm_packs_epi16(value0, value1);
+        uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, zero));
+        zeros |= (uint64_t)mask << (i * 16);
+    }
+
+    return ~zeros;
+}
+
+/* The AC coefficients are walked through the bits of the nonzero ones, the
+ * runs of zeros in between being the distances of the bits.
+ */
+static inline void encodeBlock(HuffmanWriter& writer, const int16_t* block,
+                               int32_t& prediction,
+                               const HuffmanCodeTable& dc_table,
+                               const HuffmanCodeTable& ac_table) {
+    int16_t zigzag[64];
+    uint64_t nonzero = zigzagBlock(block, zigzag) & ~(uint64_t)1;
+
+    uint32_t bits;
+    int32_t difference = zigzag[0] - prediction;
+    prediction = zigzag[0];
+    uint32_t count = getValueBits(difference, &bits);
+    writer.putBits(((uint32_t)dc_table.codes[count] << count) | bits,
+                   dc_table.lengths[count] + count);
+
+    uint32_t last = 0;
+    while (nonzero) {
+        uint32_t index = lowestBit(nonzero);
+        uint32_t run = index - last - 1;
+        while (run >= 16) {
+            writer.putBits(ac_table.codes[0xF0], ac_table.lengths[0xF0]);
+            run -= 16;
+        }
+        count = getValueBits(zigzag[index], &bits);
+        uint32_t symbol = (run << 4) | count;
+        writer.putBits(((uint32_t)ac_table.codes[symbol] << count) | bits,
+                       ac_table.lengths[symbol] + count);
+        last = index;
+        nonzero &= nonzero - 1;
+    }
+    if (last != 63) {
+        writer.putBits(ac_table.codes[0], ac_table.lengths[0]);
+    }
+}
+
+static inline void countBlock(const int16_t* block, int32_t& prediction,
+                              uint32_t* dc_counts, uint32_t* ac_counts) {
+    int16_t zigzag[64];
+    uint64_t nonzero = zigzagBlock(block, zigzag) & ~(uint64_t)1;
+
+    uint32_t bits;
+    int32_t difference = zigzag[0] - prediction;
+    prediction = zigzag[0];
+    dc_counts[getValueBits(difference, &bits)]++;
+
+    uint32_t last = 0;
+    while (nonzero) {
+        uint32_t index = lowestBit(nonzero);
+        uint32_t run = index - last - 1;
+        while (run >= 16) {
+            ac_counts[0xF0]++;
+            run -= 16;
+        }
+        ac_counts[(run << 4) | getValueBits(zigzag[index], &bits)]++;
+        last = index;
+        nonzero &= nonzero - 1;
+    }
+    if (last != 63) {
+        ac_counts[0]++;
+    }
+}
+
+BGR2YCrCb::BGR2YCrCb(uint32_t width, uint32_t channels, uint32_t hsampling,
+                     uint32_t vsampling) : width_(width), channels_(channels),
+                     hsampling_(hsampling), vsampling_(vsampling) {
+    chroma_shift_ = 14 + (hsampling - 1) + (vsampling - 1);
+    // (128 << shift) + (1 << (shift - 1)) is bias * constant below.
+    int16_t bias = chroma_shift_ == 16 ? 514 : 257;
+    int16_t constant = chroma_shift_ == 14 ? 8192 : 16384;
+
+    luma_const0_ = fdctConstants(Y_B, Y_G);
+    luma_const1_ = fdctConstants(Y_R, CHROMA_HALF);
+    cb_const0_ = fdctConstants(16384 / 2, CB_G);
+    cb_const1_ = fdctConstants(CB_R, constant);
+    cr_const0_ = fdctConstants(16384 / 2, CR_G);
+    cr_const1_ = fdctConstants(CR_B, constant);
+    chroma_bias_ = _mm_set1_epi16(bias);
+}
+
+BGR2YCrCb::~BGR2YCrCb() {
+}
+
+// deinterleaves 16 pixels of B G R or B G R A.
+void BGR2YCrCb::load16Pixels(uint8_t const *src, __m128i &b, __m128i &g,
+                             __m128i &r) const {
+    if (channels_ == 3) {
+        __m128i a0 = _mm_loadu_si128((const __m128i*)src);
+        __m128i a1 = _mm_loadu_si128((const __m128i*)(src + 16));
+        __m128i a2 = _mm_loadu_si128((const __m128i*)(src + 32));
+        b = _mm_or_si128(_mm_or_si128(
+                _mm_shuffle_epi8(a0, _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1,
+                                 -1, -1, -1, -1, -1, -1, -1, -1)),
+                _mm_shuffle_epi8(a1, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2,
+                                 5, 8, 11, 14, -1, -1, -1, -1, -1))),
+                _mm_shuffle_epi8(a2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1,
+                                 -1, -1, -1, -1, 1, 4, 7, 10, 13)));
+        g = _mm_or_si128(_mm_or_si128(
+                _mm_shuffle_epi8(a0, _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1,
+                                 -1, -1, -1, -1, -1, -1, -1, -1)),
+                _mm_shuffle_epi8(a1, _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6,
+                                 9, 12, 15, -1, -1, -1, -1, -1))),
+                _mm_shuffle_epi8(a2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1,
+                                 -1, -1, -1, -1, 2, 5, 8, 11, 14)));
+        r = _mm_or_si128(_mm_or_si128(
+                _mm_shuffle_epi8(a0, _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1,
+                                 -1, -1, -1, -1, -1, -1, -1, -1)),
+                _mm_shuffle_epi8(a1, _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7,
+                                 10, 13, -1, -1, -1, -1, -1, -1))),
+                _mm_shuffle_epi8(a2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1,
+                                 -1, -1, -1, 0, 3, 6, 9, 12, 15)));
+    }
+    else {
+        __m128i mask = _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3,
+                                     7, 11, 15);
+        __m128i a0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)src),
+                                      mask);
+        __m128i a1 = _mm_shuffle_epi8(
+            _mm_loadu_si128((const __m128i*)(src + 16)), mask);
+        __m128i a2 = _mm_shuffle_epi8(
+            _mm_loadu_si128((const __m128i*)(src + 32)), mask);
+        __m128i a3 = _mm_shuffle_epi8(
+            _mm_loadu_si128((const __m128i*)(src + 48)), mask);
+        __m128i t0 = _mm_unpacklo_epi32(a0, a1);
+        __m128i t1 = _mm_unpackhi_epi32(a0, a1);
+        __m128i t2 = _mm_unpacklo_epi32(a2, a3);
+        __m128i t3 = _mm_unpackhi_epi32(a2, a3);
+        b = _mm_unpacklo_epi64(t0, t2);
+        g = _mm_unpackhi_epi64(t0, t2);
+        r = _mm_unpacklo_epi64(t1, t3);
+    }
+}
+
+__m128i BGR2YCrCb::convertLuma(__m128i b, __m128i g, __m128i r) const {
+    __m128i zero = _mm_setzero_si128();
+    __m128i one  = _mm_set1_epi16(1);
+    __m128i b16s = _mm_unpacklo_epi8(b, zero);
+    __m128i g16s = _mm_unpacklo_epi8(g, zero);
+    __m128i r16s = _mm_unpacklo_epi8(r, zero);
+    __m128i low0 = _mm_add_epi32(
+        _mm_madd_epi16(_mm_unpacklo_epi16(b16s, g16s), luma_const0_),
+        _mm_madd_epi16(_mm_unpacklo_epi16(r16s, one), luma_const1_));
+    __m128i high0 = _mm_add_epi32(
+        _mm_madd_epi16(_mm_unpackhi_epi16(b16s, g16s), luma_const0_),
+        _mm_madd_epi16(_mm_unpackhi_epi16(r16s, one), luma_const1_));
+    b16s = _mm_unpackhi_epi8(b, zero);
+    g16s = _mm_unpackhi_epi8(g, zero);
+    r16s = _mm_unpackhi_epi8(r, zero);
+    __m128i low1 = _mm_add_epi32(
+        _mm_madd_epi16(_mm_unpacklo_epi16(b16s, g16s), luma_const0_),
+        _mm_madd_epi16(_mm_unpacklo_epi16(r16s, one), luma_const1_));
+    __m128i high1 = _mm_add_epi32(
+        _mm_madd_epi16(_mm_unpackhi_epi16(b16s, g16s), luma_const0_),
+        _mm_madd_epi16(_mm_unpackhi_epi16(r16s, one), luma_const1_));
+
+    __m128i y16s0 = _mm_packs_epi32(_mm_srai_epi32(low0, 14),
+                                    _mm_srai_epi32(high0, 14));
+    __m128i y16s1 = _mm_packs_epi32(_mm_srai_epi32(low1, 14),
+                                    _mm_srai_epi32(high1, 14));
+
+    return _mm_packus_epi16(y16s0, y16s1);
+}
+
+// 8 chroma samples out of the sums of the pixels they cover.
+void BGR2YCrCb::convertChroma(__m128i b16s, __m128i g16s, __m128i r16s,
+                              __m128i &cb16s, __m128i &cr16s) const {
+    __m128i shift = _mm_cvtsi32_si128(chroma_shift_);
+    __m128i low = _mm_add_epi32(
+        _mm_madd_epi16(_mm_unpacklo_epi16(b16s, g16s), cb_const0_),
+        _mm_madd_epi16(_mm_unpacklo_epi16(r16s, chroma_bias_), cb_const1_));
+    __m128i high = _mm_add_epi32(
+        _mm_madd_epi16(_mm_unpackhi_epi16(b16s, g16s), cb_const0_),
+        _mm_madd_epi16(_mm_unpackhi_epi16(r16s, chroma_bias_), cb_const1_));
+    cb16s = _mm_packs_epi32(_mm_sra_epi32(low, shift),
+                            _mm_sra_epi32(high, shift));
+
+    low = _mm_add_epi32(
+        _mm_madd_epi16(_mm_unpacklo_epi16(r16s, g16s), cr_const0_),
+        _mm_madd_epi16(_mm_unpacklo_epi16(b16s, chroma_bias_), cr_const1_));
+    high = _mm_add_epi32(
+        _mm_madd_epi16(_mm_unpackhi_epi16(r16s, g16s), cr_const0_),
+        _mm_madd_epi16(_mm_unpackhi_epi16(b16s, chroma_bias_), cr_const1_));
+    cr16s = _mm_packs_epi32(_mm_sra_epi32(low, shift),
+                            _mm_sra_epi32(high, shift));
+}
+
+/* Converts a row, or two rows when the chroma are vertically subsampled, to
+ * Y and the chroma of the sums of the 1, 2 or 4 pixels each sample covers.
+ * The last pixel stands in for those beyond the width.
+ */
+void BGR2YCrCb::convertRows(uint8_t const *src0, uint8_t const *src1,
+                            uint8_t *y0, uint8_t *y1, uint8_t *cb,
+                            uint8_t *cr) const {
+    __m128i zero = _mm_setzero_si128();
+    __m128i ones = _mm_set1_epi8(1);
+    __m128i b0, g0, r0, b1, g1, r1;
+    __m128i cb16s, cr16s;
+    uint32_t x = 0;
+    for (; x + 16 <= width_; x += 16) {
+        load16Pixels(src0 + x * channels_, b0, g0, r0);
+        _mm_storeu_si128((__m128i*)(y0 + x), convertLuma(b0, g0, r0));
+        if (hsampling_ == 1) {
+            __m128i cb16s1, cr16s1;
+            convertChroma(_mm_unpacklo_epi8(b0, zero),
+                          _mm_unpacklo_epi8(g0, zero),
+                          _mm_unpacklo_epi8(r0, zero), cb16s, cr16s);
+            convertChroma(_mm_unpackhi_epi8(b0, zero),
+                          _mm_unpackhi_epi8(g0, zero),
+                          _mm_unpackhi_epi8(r0, zero), cb16s1, cr16s1);
+            _mm_storeu_si128((__m128i*)(cb + x),
+                             _mm_packus_epi16(cb16s, cb16s1));
+            _mm_storeu_si128((__m128i*)(cr + x),
+                             _mm_packus_epi16(cr16s, cr16s1));
+            continue;
+        }
+
+        __m128i b16s = _mm_maddubs_epi16(b0, ones);
+        __m128i g16s = _mm_maddubs_epi16(g0, ones);
+        __m128i r16s = _mm_maddubs_epi16(r0, ones);
+        if (vsampling_ == 2) {
+            load16Pixels(src1 + x * channels_, b1, g1, r1);
+            _mm_storeu_si128((__m128i*)(y1 + x), convertLuma(b1, g1, r1));
+            b16s = _mm_add_epi16(b16s, _mm_maddubs_epi16(b1, ones));
+            g16s = _mm_add_epi16(g16s, _mm_maddubs_epi16(g1, ones));
+            r16s = _mm_add_epi16(r16s, _mm_maddubs_epi16(r1, ones));
+        }
+        convertChroma(b16s, g16s, r16s, cb16s, cr16s);
+        _mm_storel_epi64((__m128i*)(cb + x / 2), _mm_packus_epi16(cb16s, zero));
+        _mm_storel_epi64((__m128i*)(cr + x / 2), _mm_packus_epi16(cr16s, zero));
+    }
+
+    int32_t bias = (128 << chroma_shift_) + (1 << (chroma_shift_ - 1));
+    for (; x < width_; x += hsampling_) {
+        int32_t b = 0, g = 0, r = 0;
+        for (uint32_t i = 0; i < vsampling_; i++) {
+            const uint8_t* src = i == 0 ? src0 : src1;
+            uint8_t* y = i == 0 ? y0 : y1;
+            for (uint32_t j = 0; j < hsampling_; j++) {
+                uint32_t index = x + j < width_ ? x + j : width_ - 1;
+                const uint8_t* pixel = src + index * channels_;
+                y[index] = (uint8_t)((pixel[0] * Y_B + pixel[1] * Y_G +
+                                      pixel[2] * Y_R + CHROMA_HALF) >> 14);
+                b += pixel[0];
+                g += pixel[1];
+                r += pixel[2];
+            }
+        }
+        cb[x / hsampling_] = (uint8_t)((b * 8192 + g * CB_G + r * CB_R +
+                                        bias) >> chroma_shift_);
+        cr[x / hsampling_] = (uint8_t)((r * 8192 + g * CR_G + b * CR_B +
+                                        bias) >> chroma_shift_);
+    }
+}
+
+JpegEncoder::JpegEncoder(BytesWriter& file_data, int32_t quality,
+                         int32_t subsampling, int32_t restart_interval,
+                         bool optimize) {
+    file_data_ = &file_data;
+    quality_ = quality;
+    subsampling_ = subsampling;
+    restart_interval_ = restart_interval;
+    optimize_ = optimize;
+    image_ = nullptr;
+    bgr2ycrcb_ = nullptr;
+    coefficients_ = nullptr;
+
+    hardware_threads_ = std::thread::hardware_concurrency();
+    hardware_threads_ = hardware_threads_ == 0 ? 1 : hardware_threads_;
+    hardware_threads_ = hardware_threads_ > 4 ? 4 : hardware_threads_;
+}
+
+JpegEncoder::~JpegEncoder() {
+    free(coefficients_);
+}
+
+// the alpha channel of 4 channels is dropped.
+bool JpegEncoder::isChannelsSupported(uint32_t channels) const {
+    return channels == 1 || channels == 3 || channels == 4;
+}
+
+/* The MCU holds hsampling_ x vsampling_ luma blocks followed by a block of Cb
+ * and one of Cr. The planes of an MCU row are padded to whole MCUs.
+ */
+void JpegEncoder::setComponents(uint32_t height, uint32_t width,
+                                uint32_t channels) {
+    components_ = channels == 1 ? 1 : 3;
+    hsampling_ = 1;
+    vsampling_ = 1;
+    if (components_ == 3 && subsampling_ != SUBSAMPLING_444) {
+        hsampling_ = 2;
+        vsampling_ = subsampling_ == SUBSAMPLING_420 ? 2 : 1;
+    }
+    mcu_width_  = hsampling_ * 8;
+    mcu_height_ = vsampling_ * 8;
+    mcus_x_ = (width + mcu_width_ - 1) / mcu_width_;
+    mcus_y_ = (height + mcu_height_ - 1) / mcu_height_;
+    blocks_per_mcu_ = hsampling_ * vsampling_ + components_ - 1;
+
+    plane_strides_[0] = mcus_x_ * mcu_width_;
+    plane_offsets_[0] = 0;
+    planes_size_ = plane_strides_[0] * mcu_height_;
+    for (uint32_t i = 1; i < components_; i++) {
+        plane_strides_[i] = mcus_x_ * 8;
+        plane_offsets_[i] = planes_size_;
+        planes_size_ += plane_strides_[i] * 8;
+    }
+}
+
+// scaled as libjpeg does, baseline tables take no value beyond 255.
+void JpegEncoder::setQuantTables() {
+    int32_t quality = quality_ < 1 ? 1 : quality_ > 100 ? 100 : quality_;
+    int32_t scale = quality < 50 ? 5000 / quality : 200 - quality * 2;
+    const uint8_t* tables[2] = {luma_quant_table, chroma_quant_table};
+    for (int32_t i = 0; i < 2; i++) {
+        for (int32_t j = 0; j < 64; j++) {
+            int32_t value = (tables[i][j] * scale + 50) / 100;
+            value = value < 1 ? 1 : value > 255 ? 255 : value;
+            quant_tables_[i][j] = (uint8_t)value;
+        }
+        computeDivisors(quant_tables_[i], &divisors_[i]);
+    }
+}
+
+// canonical codes, those of each length following the shorter ones.
+void JpegEncoder::setHuffmanTable(HuffmanCodeTable *table,
+                                  const uint8_t *bits, const uint8_t *values) {
+    memcpy(table->bits, bits, 17);
+    memset(table->lengths, 0, sizeof(table->lengths));
+    uint32_t code = 0, index = 0;
+    for (uint32_t length = 1; length <= 16; length++) {
+        for (uint32_t i = 0; i < bits[length]; i++) {
+            uint8_t symbol = values[index];
+            table->values[index++] = symbol;
+            table->codes[symbol] = (uint16_t)code++;
+            table->lengths[symbol] = (uint8_t)length;
+        }
+        code <<= 1;
+    }
+}
+
+/* Huffman code lengths of the counted symbols limited to 16 bits, as in
+ * K.2 of the standard. The pseudo symbol 256 keeps any real code from being
+ * all 1 bits.
+ */
+void JpegEncoder::optimizeHuffmanTable(HuffmanCodeTable *table,
+                                       uint32_t counts[257]) {
+    uint32_t frequencies[257];
+    int32_t code_sizes[257];
+    int32_t others[257];
+    uint32_t bits[33];
+    memcpy(frequencies, counts, sizeof(frequencies));
+    frequencies[256] = 1;
+    memset(code_sizes, 0, sizeof(code_sizes));
+    memset(bits, 0, sizeof(bits));
+    for (int32_t i = 0; i < 257; i++) {
+        others[i] = -1;
+    }
+
+    while (true) {
+        // the least frequent symbol, the larger value among the equal ones.
+        int32_t c1 = -1, c2 = -1;
+        uint32_t value = UINT32_MAX;
+        for (int32_t i = 0; i < 257; i++) {
+            if (frequencies[i] && frequencies[i] <= value) {
+                value = frequencies[i];
+                c1 = i;
+            }
+        }
+        value = UINT32_MAX;
+        for (int32_t i = 0; i < 257; i++) {
+            if (frequencies[i] && frequencies[i] <= value && i != c1) {
+                value = frequencies[i];
+                c2 = i;
+            }
+        }
+        if (c2 < 0) {
+            break;
+        }
+
+        frequencies[c1] += frequencies[c2];
+        frequencies[c2] = 0;
+        code_sizes[c1]++;
+        while (others[c1] >= 0) {
+            c1 = others[c1];
+            code_sizes[c1]++;
+        }
+        others[c1] = c2;
+        code_sizes[c2]++;
+        while (others[c2] >= 0) {
+            c2 = others[c2];
+            code_sizes[c2]++;
+        }
+    }
+    for (int32_t i = 0; i < 257; i++) {
+        if (code_sizes[i]) {
+            bits[code_sizes[i]]++;
+        }
+    }
+
+    // a pair of the longest codes gives way to a prefix one bit shorter.
+    for (int32_t i = 32; i > 16; i--) {
+        while (bits[i] > 0) {
+            int32_t j = i - 2;
+            while (bits[j] == 0) {
+                j--;
+            }
+            bits[i] -= 2;
+            bits[i - 1]++;
+            bits[j + 1] += 2;
+            bits[j]--;
+        }
+    }
+    int32_t longest = 16;
+    while (bits[longest] == 0) {
+        longest--;
+    }
+    bits[longest]--;
+
+    uint8_t table_bits[17];
+    uint8_t values[256];
+    table_bits[0] = 0;
+    for (int32_t i = 1; i <= 16; i++) {
+        table_bits[i] = (uint8_t)bits[i];
+    }
+    int32_t index = 0;
+    for (int32_t length = 1; length <= 32; length++) {
+        for (int32_t i = 0; i < 256; i++) {
+            if (code_sizes[i] == length) {
+                values[index++] = (uint8_t)i;
+            }
+        }
+    }
+    setHuffmanTable(table, table_bits, values);
+}
+
+void JpegEncoder::putHeaders() {
+    file_data_->putByte(0xFF);
+    file_data_->putByte(0xD8);
+
+    // JFIF APP0, version 1.1 without units or thumbnail
+    const uint8_t app0[18] = {0xFF, 0xE0, 0, 16, 'J', 'F', 'I', 'F', 0, 1, 1,
+                              0, 0, 1, 0, 1, 0, 0};
+    file_data_->putBytes(app0, sizeof(app0));
+
+    uint32_t tables = components_ == 1 ? 1 : 2;
+    file_data_->putByte(0xFF);
+    file_data_->putByte(0xDB);
+    file_data_->putWordBigEndian(2 + tables * 65);
+    for (uint32_t i = 0; i < tables; i++) {
+        file_data_->putByte(i);
+        for (int32_t j = 0; j < 64; j++) {
+            file_data_->putByte(quant_tables_[i][zigzag_indices[j]]);
+        }
+    }
+
+    file_data_->putByte(0xFF);
+    file_data_->putByte(0xC0);
+    file_data_->putWordBigEndian(8 + components_ * 3);
+    file_data_->putByte(8);
+    file_data_->putWordBigEndian(height_);
+    file_data_->putWordBigEndian(width_);
+    file_data_->putByte(components_);
+    for (uint32_t i = 0; i < components_; i++) {
+        file_data_->putByte(i + 1);
+        file_data_->putByte(i == 0 ? (hsampling_ << 4) | vsampling_ : 0x11);
+        file_data_->putByte(i == 0 ? 0 : 1);
+    }
+}
+
+void JpegEncoder::putHuffmanTables() {
+    uint32_t tables = components_ == 1 ? 1 : 2;
+    uint32_t length = 2;
+    for (uint32_t i = 0; i < tables; i++) {
+        const HuffmanCodeTable* pair[2] = {&dc_tables_[i], &ac_tables_[i]};
+        for (int32_t j = 0; j < 2; j++) {
+            length += 17;
+            for (int32_t k = 1; k <= 16; k++) {
+                length += pair[j]->bits[k];
+            }
+        }
+    }
+
+    file_data_->putByte(0xFF);
+    file_data_->putByte(0xC4);
+    file_data_->putWordBigEndian(length);
+    for (uint32_t i = 0; i < tables; i++) {
+        const HuffmanCodeTable* pair[2] = {&dc_tables_[i], &ac_tables_[i]};
+        for (int32_t j = 0; j < 2; j++) {
+            uint32_t count = 0;
+            file_data_->putByte((j << 4) | i);
+            for (int32_t k = 1; k <= 16; k++) {
+                file_data_->putByte(pair[j]->bits[k]);
+                count += pair[j]->bits[k];
+            }
+            file_data_->putBytes(pair[j]->values, count);
+        }
+    }
+}
+
+void JpegEncoder::putScanHeader() {
+    if (restart_interval_ > 0) {
+        file_data_->putByte(0xFF);
+        file_data_->putByte(0xDD);
+        file_data_->putWordBigEndian(4);
+        file_data_->putWordBigEndian(restart_interval_);
+    }
+
+    file_data_->putByte(0xFF);
+    file_data_->putByte(0xDA);
+    file_data_->putWordBigEndian(6 + components_ * 2);
+    file_data_->putByte(components_);
+    for (uint32_t i = 0; i < components_; i++) {
+        file_data_->putByte(i + 1);
+        file_data_->putByte(i == 0 ? 0x00 : 0x11);
+    }
+    file_data_->putByte(0);
+    file_data_->putByte(63);
+    file_data_->putByte(0);
+}
+
+/* Converts the pixel rows of an MCU row into the planes, the last row and
+ * column of the image being repeated to whole MCUs.
+ */
+void JpegEncoder::convertRows(uint32_t mcu_row, uint8_t* planes) {
+    uint8_t* y_plane  = planes;
+    uint8_t* cb_plane = planes + plane_offsets_[1];
+    uint8_t* cr_plane = planes + plane_offsets_[2];
+    uint32_t y_stride = plane_strides_[0];
+    uint32_t chroma_width = (width_ + hsampling_ - 1) / hsampling_;
+
+    for (uint32_t i = 0; i < mcu_height_; i += vsampling_) {
+        uint32_t row0 = mcu_row * mcu_height_ + i;
+        uint32_t row1 = row0 + 1;
+        row0 = row0 < height_ ? row0 : height_ - 1;
+        row1 = row1 < height_ ? row1 : height_ - 1;
+        const uint8_t* src0 = image_ + (size_t)row0 * stride_;
+        const uint8_t* src1 = image_ + (size_t)row1 * stride_;
+        uint8_t* y0 = y_plane + i * y_stride;
+        uint8_t* y1 = y0 + y_stride;
+
+        if (components_ == 1) {
+            memcpy(y0, src0, width_);
+            memset(y0 + width_, y0[width_ - 1], y_stride - width_);
+            continue;
+        }
+
+        uint32_t chroma_row = i / vsampling_;
+        uint8_t* cb = cb_plane + chroma_row * plane_strides_[1];
+        uint8_t* cr = cr_plane + chroma_row * plane_strides_[2];
+        bgr2ycrcb_->convertRows(src0, src1, y0, y1, cb, cr);
+        memset(y0 + width_, y0[width_ - 1], y_stride - width_);
+        if (vsampling_ == 2) {
+            memset(y1 + width_, y1[width_ - 1], y_stride - width_);
+        }
+        memset(cb + chroma_width, cb[chroma_width - 1],
+               plane_strides_[1] - chroma_width);
+        memset(cr + chroma_width, cr[chroma_width - 1],
+               plane_strides_[2] - chroma_width);
+    }
+}
+
+// transforms the blocks of the planes into blocks in the order of the MCUs.
+void JpegEncoder::transformRow(uint8_t* planes, int16_t* blocks) {
+    bool fma_supported = CpuSupports(ISA_X86_FMA);
+    for (uint32_t i = 0; i < components_; i++) {
+        const uint8_t* plane = planes + plane_offsets_[i];
+        uint32_t stride = plane_strides_[i];
+        uint32_t hsampling = i == 0 ? hsampling_ : 1;
+        uint32_t vsampling = i == 0 ? vsampling_ : 1;
+        uint32_t block_offset = i == 0 ? 0 : hsampling_ * vsampling_ + i - 1;
+        const QuantDivisors* divisors = &divisors_[i == 0 ? 0 : 1];
+        uint32_t blocks_x = mcus_x_ * hsampling;
+
+        for (uint32_t y = 0; y < vsampling; y++) {
+            const uint8_t* src = plane + y * 8 * stride;
+            int16_t* dst = blocks + (block_offset + y * hsampling) * 64;
+            uint32_t x = 0;
+            if (fma_supported) {
+                for (; x + 2 <= blocks_x; x += 2) {
+                    int16_t* dst0 = dst + ((x / hsampling) * blocks_per_mcu_ +
+                                           x % hsampling) * 64;
+                    int16_t* dst1 = dst + (((x + 1) / hsampling) *
+                                           blocks_per_mcu_ + (x + 1) %
+                                           hsampling) * 64;
+                    fma::fdct_quant_2blocks_u8(src + x * 8, stride,
+                                               divisors->reciprocals, dst0,
+                                               dst1);
+                }
+            }
+            for (; x < blocks_x; x++) {
+                fdctQuantizeBlock(src + x * 8, stride, divisors,
+                                  dst + ((x / hsampling) * blocks_per_mcu_ +
+                                         x % hsampling) * 64);
+            }
+        }
+    }
+}
+
+void JpegEncoder::transformBand(uint32_t mcu_row_begin, uint32_t mcu_row_end,
+                                bool* succeeded) {
+    uint8_t* planes = (uint8_t*)malloc(planes_size_);
+    if (planes == nullptr) {
+        *succeeded = false;
+        return;
+    }
+
+    size_t row_blocks = (size_t)mcus_x_ * blocks_per_mcu_ * 64;
+    for (uint32_t row = mcu_row_begin; row < mcu_row_end; row++) {
+        convertRows(row, planes);
+        transformRow(planes, coefficients_ + row * row_blocks);
+    }
+    free(planes);
+    *succeeded = true;
+}
+
+// the DC predictions start from the MCU in front unless it is a restart.
+void JpegEncoder::countMcus(uint32_t mcu_begin, uint32_t mcu_end,
+                            HuffmanCounts* counts) {
+    memset(counts, 0, sizeof(HuffmanCounts));
+    uint32_t luma_blocks = hsampling_ * vsampling_;
+    int32_t predictions[3] = {0, 0, 0};
+    if (mcu_begin > 0 && (restart_interval_ == 0 ||
+                          mcu_begin % restart_interval_ != 0)) {
+        const int16_t* previous = coefficients_ + (size_t)(mcu_begin - 1) *
+                                  blocks_per_mcu_ * 64;
+        predictions[0] = previous[(luma_blocks - 1) * 64];
+        for (uint32_t i = 1; i < components_; i++) {
+            predictions[i] = previous[(luma_blocks + i - 1) * 64];
+        }
+    }
+
+    const int16_t* block = coefficients_ + (size_t)mcu_begin *
+                           blocks_per_mcu_ * 64;
+    for (uint32_t mcu = mcu_begin; mcu < mcu_end; mcu++) {
+        if (restart_interval_ > 0 && mcu % restart_interval_ == 0) {
+            predictions[0] = predictions[1] = predictions[2] = 0;
+        }
+        for (uint32_t i = 0; i < luma_blocks; i++) {
+            countBlock(block, predictions[0], counts->dc[0], counts->ac[0]);
+            block += 64;
+        }
+        for (uint32_t i = 1; i < components_; i++) {
+            countBlock(block, predictions[i], counts->dc[1], counts->ac[1]);
+            block += 64;
+        }
+    }
+}
+
+/* Codes the MCUs of whole restart intervals, a marker leading the ones
+ * behind the first interval. The blocks are those of coefficients_, or are
+ * transformed row by row when the tables are the standard ones.
+ */
+void JpegEncoder::encodeMcus(uint32_t mcu_begin, uint32_t mcu_end,
+                             BytesWriter* output, bool* succeeded) {
+    *succeeded = false;
+    HuffmanWriter writer(output);
+    uint8_t* planes = nullptr;
+    int16_t* row_blocks = nullptr;
+    size_t row_size = (size_t)mcus_x_ * blocks_per_mcu_ * 64;
+    if (coefficients_ == nullptr) {
+        planes = (uint8_t*)malloc(planes_size_);
+        row_blocks = (int16_t*)malloc(row_size * sizeof(int16_t));
+    }
+    if (!writer.isGood() || (coefficients_ == nullptr &&
+                             (planes == nullptr || row_blocks == nullptr))) {
+        free(planes);
+        free(row_blocks);
+        return;
+    }
+
+    uint32_t luma_blocks = hsampling_ * vsampling_;
+    int32_t predictions[3] = {0, 0, 0};
+    uint32_t mcu = mcu_begin;
+    while (mcu < mcu_end) {
+        uint32_t mcu_row = mcu / mcus_x_;
+        const int16_t* blocks;
+        if (coefficients_ != nullptr) {
+            blocks = coefficients_ + mcu_row * row_size;
+        }
+        else {
+            convertRows(mcu_row, planes);
+            transformRow(planes, row_blocks);
+            blocks = row_blocks;
+        }
+
+        uint32_t row_end = (mcu_row + 1) * mcus_x_;
+        row_end = row_end < mcu_end ? row_end : mcu_end;
+        for (; mcu < row_end; mcu++) {
+            if (restart_interval_ > 0 && mcu % restart_interval_ == 0 &&
+                mcu > 0) {
+                writer.putMarker(RST0_MARKER +
+                                 ((mcu / restart_interval_ - 1) & 7));
+                predictions[0] = predictions[1] = predictions[2] = 0;
+            }
+
+            const int16_t* block = blocks + (size_t)(mcu % mcus_x_) *
+                                   blocks_per_mcu_ * 64;
+            for (uint32_t i = 0; i < luma_blocks; i++) {
+                encodeBlock(writer, block, predictions[0], dc_tables_[0],
+                            ac_tables_[0]);
+                block += 64;
+            }
+            for (uint32_t i = 1; i < components_; i++) {
+                encodeBlock(writer, block, predictions[i], dc_tables_[1],
+                            ac_tables_[1]);
+                block += 64;
+            }
+            writer.flushBuffer(false);
+        }
+    }
+    writer.alignBits();
+    writer.flushBuffer(true);
+
+    free(planes);
+    free(row_blocks);
+    *succeeded = output->isGood();
+}
+
+// the coefficients of the whole image for the counting of the symbols.
+bool JpegEncoder::transformImage() {
+    size_t size = (size_t)mcus_x_ * mcus_y_ * blocks_per_mcu_ * 64;
+    coefficients_ = (int16_t*)malloc(size * sizeof(int16_t));
+    if (coefficients_ == nullptr) {
+        LOG(ERROR) << "failed to allocate the coefficients of the image.";
+        return false;
+    }
+
+    uint32_t threads_n = mcus_y_ < hardware_threads_ ? mcus_y_ :
+                         hardware_threads_;
+    bool succeeded[4] = {false, false, false, false};
+    std::vector<std::thread> threads;
+    for (uint32_t i = 1; i < threads_n; i++) {
+        threads.push_back(std::thread(&JpegEncoder::transformBand, this,
+                                      mcus_y_ * i / threads_n,
+                                      mcus_y_ * (i + 1) / threads_n,
+                                      &succeeded[i]));
+    }
+    transformBand(0, mcus_y_ / threads_n, &succeeded[0]);
+    for (auto &worker: threads) {
+        worker.join();
+    }
+    for (uint32_t i = 0; i < threads_n; i++) {
+        if (!succeeded[i]) {
+            LOG(ERROR) << "failed to allocate the planes of the encoder.";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool JpegEncoder::countSymbols() {
+    uint32_t mcus = mcus_x_ * mcus_y_;
+    uint32_t threads_n = mcus < hardware_threads_ ? mcus : hardware_threads_;
+    std::vector<HuffmanCounts> counts(threads_n);
+    std::vector<std::thread> threads;
+    for (uint32_t i = 1; i < threads_n; i++) {
+        threads.push_back(std::thread(&JpegEncoder::countMcus, this,
+                                      mcus * i / threads_n,
+                                      mcus * (i + 1) / threads_n, &counts[i]));
+    }
+    countMcus(0, mcus / threads_n, &counts[0]);
+    for (auto &worker: threads) {
+        worker.join();
+    }
+
+    uint32_t tables = components_ == 1 ? 1 : 2;
+    for (uint32_t i = 0; i < tables; i++) {
+        for (uint32_t j = 1; j < threads_n; j++) {
+            for (int32_t k = 0; k < 257; k++) {
+                counts[0].dc[i][k] += counts[j].dc[i][k];
+                counts[0].ac[i][k] += counts[j].ac[i][k];
+            }
+        }
+        optimizeHuffmanTable(&dc_tables_[i], counts[0].dc[i]);
+        optimizeHuffmanTable(&ac_tables_[i], counts[0].ac[i]);
+    }
+
+    return true;
+}
+
+/* With restart intervals, the scan is cut into runs of whole intervals coded
+ * by parallel threads. Each interval ends on a byte boundary, so the bytes of
+ * the runs are simply put one after another.
+ */
+bool JpegEncoder::encodeScan() {
+    uint32_t mcus = mcus_x_ * mcus_y_;
+    uint32_t groups = 1;
+    uint32_t intervals = 0;
+    if (restart_interval_ > 0) {
+        intervals = (mcus + restart_interval_ - 1) / restart_interval_;
+        groups = intervals < hardware_threads_ ? intervals : hardware_threads_;
+    }
+
+    bool succeeded[4] = {false, false, false, false};
+    if (groups == 1) {
+        encodeMcus(0, mcus, file_data_, &succeeded[0]);
+        return succeeded[0];
+    }
+
+    BytesWriter* outputs = new BytesWriter[groups];
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < groups; i++) {
+        uint32_t begin = intervals * i / groups * restart_interval_;
+        uint32_t end   = intervals * (i + 1) / groups * restart_interval_;
+        end = end < mcus ? end : mcus;
+        threads.push_back(std::thread(&JpegEncoder::encodeMcus, this, begin,
+                                      end, &outputs[i], &succeeded[i]));
+    }
+    for (auto &worker: threads) {
+        worker.join();
+    }
+
+    bool is_good = true;
+    for (uint32_t i = 0; i < groups; i++) {
+        if (!succeeded[i]) {
+            is_good = false;
+            break;
+        }
+        size_t size;
+        uchar* data = outputs[i].detach(&size);
+        file_data_->putBytes(data, (int)size);
+        free(data);
+    }
+    delete [] outputs;
+
+    return is_good;
+}
+
+bool JpegEncoder::encodeData(uint32_t height, uint32_t width,
+                             uint32_t channels, uint32_t stride,
+                             const uint8_t* image) {
+    // the dimensions are no larger than 65535, checked by the caller.
+    image_ = image;
+    height_ = height;
+    width_ = width;
+    channels_ = channels;
+    stride_ = stride;
+    setComponents(height, width, channels);
+    setQuantTables();
+    BGR2YCrCb bgr2ycrcb(width, channels, hsampling_, vsampling_);
+    bgr2ycrcb_ = &bgr2ycrcb;
+
+    bool succeeded;
+    if (optimize_) {
+        succeeded = transformImage() && countSymbols();
+    }
+    else {
+        setHuffmanTable(&dc_tables_[0], luma_dc_bits, dc_values);
+        setHuffmanTable(&ac_tables_[0], luma_ac_bits, luma_ac_values);
+        setHuffmanTable(&dc_tables_[1], chroma_dc_bits, dc_values);
+        setHuffmanTable(&ac_tables_[1], chroma_ac_bits, chroma_ac_values);
+        succeeded = true;
+    }
+    if (succeeded) {
+        putHeaders();
+        putHuffmanTables();
+        putScanHeader();
+        succeeded = encodeScan();
+        file_data_->putByte(0xFF);
+        file_data_->putByte(0xD9);
+    }
+    bgr2ycrcb_ = nullptr;
+    free(coefficients_);
+    coefficients_ = nullptr;
+
+    return succeeded && file_data_->isGood();
+}
+
+} //! namespace x86
+} //! namespace cv
+} //! namespace ppl
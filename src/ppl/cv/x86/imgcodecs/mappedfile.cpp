@@ -0,0 +1,91 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "mappedfile.h"
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "codecs.h"
+
+namespace ppl {
+namespace cv {
+namespace x86 {
+
+MappedFile::MappedFile() : address_(nullptr), size_(0) {}
+
+MappedFile::~MappedFile() {
+    unmap();
+}
+
+bool MappedFile::map(FILE* fp) {
+    unmap();
+
+#if !defined(_WIN32)
+    int fd = fileno(fp);
+    struct stat status;
+    if (fd < 0 || fstat(fd, &status) != 0 || !S_ISREG(status.st_mode)) {
+        return false;
+    }
+    if (status.st_size < MIN_MAPPED_SIZE ||
+        (uint64_t)status.st_size >= UINT32_MAX) {
+        return false;
+    }
+
+    size_t size = (size_t)status.st_size;
+    void* address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address == MAP_FAILED) {
+        return false;
+    }
+    // the decoders walk the file from the front to the end, so the kernel
+    // may read ahead aggressively and drop the pages behind.
+    madvise(address, size, MADV_SEQUENTIAL);
+
+    address_ = address;
+    size_ = size;
+
+    return true;
+#else
+    (void)fp;
+
+    return false;
+#endif
+}
+
+void MappedFile::unmap() {
+#if !defined(_WIN32)
+    if (address_ != nullptr) {
+        munmap(address_, size_);
+    }
+#endif
+    address_ = nullptr;
+    size_ = 0;
+}
+
+const uint8_t* MappedFile::data() const {
+    return (const uint8_t*)address_;
+}
+
+size_t MappedFile::size() const {
+    return size_;
+}
+
+} //! namespace x86
+} //! namespace cv
+} //! namespace ppl
@@ -0,0 +1,59 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef __ST_HPC_PPL_CV_X86_IMGCODECS_MAPPEDFILE_H_
+#define __ST_HPC_PPL_CV_X86_IMGCODECS_MAPPEDFILE_H_
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace ppl {
+namespace cv {
+namespace x86 {
+
+/* A read-only mapping of a whole file, so that decoders parse the page cache
+ * in place through a memory backed BytesReader. Mapping is only tried for
+ * regular files of at least MIN_MAPPED_SIZE bytes, for smaller ones reading
+ * into the cached window of BytesReader is cheaper than setting up a mapping.
+ * map() returns false whenever the file can not be mapped, and the caller
+ * falls back to reading it through the FILE stream.
+ */
+class MappedFile {
+  public:
+    MappedFile();
+    ~MappedFile();
+
+    bool map(FILE* fp);
+    void unmap();
+    const uint8_t* data() const;
+    size_t size() const;
+
+  private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+  private:
+    void* address_;
+    size_t size_;
+};
+
+} //! namespace x86
+} //! namespace cv
+} //! namespace ppl
+
+#endif //! __ST_HPC_PPL_CV_X86_IMGCODECS_MAPPEDFILE_H_
@@ -21,6 +21,7 @@
 #include <limits.h>
 #include <string.h>
 #include <immintrin.h>
+#include <algorithm>
 
 #include "ppl/cv/types.h"
 #include "ppl/common/log.h"
@@ -31,29 +32,6 @@ namespace ppl {
 namespace cv {
 namespace x86 {
 
-#define MAKE_CHUNK_TYPE(s0, s1, s2, s3) (((uint32_t)(s0) << 24) | \
-                                         ((uint32_t)(s1) << 16) | \
-                                         ((uint32_t)(s2) << 8)  | \
-                                         ((uint32_t)(s3)))
-#define png_IHDR MAKE_CHUNK_TYPE( 73,  72,  68,  82)
-#define png_PLTE MAKE_CHUNK_TYPE( 80,  76,  84,  69)
-#define png_IDAT MAKE_CHUNK_TYPE( 73,  68,  65,  84)
-#define png_IEND MAKE_CHUNK_TYPE( 73,  69,  78,  68)
-#define png_tRNS MAKE_CHUNK_TYPE(116,  82,  78,  83)
-#define png_cHRM MAKE_CHUNK_TYPE( 99,  72,  82,  77)
-#define png_gAMA MAKE_CHUNK_TYPE(103,  65,  77,  65)
-#define png_iCCP MAKE_CHUNK_TYPE(105,  67,  67,  80)
-#define png_sBIT MAKE_CHUNK_TYPE(115,  66,  73,  84)
-#define png_sRGB MAKE_CHUNK_TYPE(115,  82,  71,  66)
-#define png_tEXt MAKE_CHUNK_TYPE(116,  69,  88, 116)
-#define png_zTXt MAKE_CHUNK_TYPE(122,  84,  88, 116)
-#define png_iTXt MAKE_CHUNK_TYPE(105,  84,  88, 116)
-#define png_bKGD MAKE_CHUNK_TYPE( 98,  75,  71,  68)
-#define png_hIST MAKE_CHUNK_TYPE(104,  73,  83,  84)
-#define png_pHYs MAKE_CHUNK_TYPE(112,  72,  89, 115)
-#define png_sPLT MAKE_CHUNK_TYPE(115,  80,  76,  84)
-#define png_tIME MAKE_CHUNK_TYPE(116,  73,  77,  69)
-
 #define HAVE_PLTE 0x01
 #define HAVE_tRNS 0x02
 #define HAVE_hIST 0x04
@@ -62,14 +40,6 @@ namespace x86 {
 #define HAVE_iCCP 0x20
 #define HAVE_sRGB 0x40
 
-enum FilterTypes {
-    FILTER_NONE    = 0,
-    FILTER_SUB     = 1,
-    FILTER_UP      = 2,
-    FILTER_AVERAGE = 3,
-    FILTER_PAETH   = 4,
-};
-
 static const uint8_t depth_scales[9] = {0, 0xff, 0x55, 0, 0x11, 0, 0, 0, 0x01};
 
 static const uint8_t default_length_sizes[SYMBOL_NUMBER] = {
@@ -111,8 +81,53 @@ static const int distance_extra_bits[32] = {
     0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10,
     11, 11, 12, 12, 13, 13};
 
-PngDecoder::PngDecoder(BytesReader& file_data) {
+#define FAST_PAIR_FLAG 0x100
+
+// shuffle masks repeating a period of 1-15 bytes over a 16-byte block.
+static const uint8_t period_masks[16][16] = {
+    { 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0},
+    { 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0},
+    { 0,  1,  0,  1,  0,  1,  0,  1,  0,  1,  0,  1,  0,  1,  0,  1},
+    { 0,  1,  2,  0,  1,  2,  0,  1,  2,  0,  1,  2,  0,  1,  2,  0},
+    { 0,  1,  2,  3,  0,  1,  2,  3,  0,  1,  2,  3,  0,  1,  2,  3},
+    { 0,  1,  2,  3,  4,  0,  1,  2,  3,  4,  0,  1,  2,  3,  4,  0},
+    { 0,  1,  2,  3,  4,  5,  0,  1,  2,  3,  4,  5,  0,  1,  2,  3},
+    { 0,  1,  2,  3,  4,  5,  6,  0,  1,  2,  3,  4,  5,  6,  0,  1},
+    { 0,  1,  2,  3,  4,  5,  6,  7,  0,  1,  2,  3,  4,  5,  6,  7},
+    { 0,  1,  2,  3,  4,  5,  6,  7,  8,  0,  1,  2,  3,  4,  5,  6},
+    { 0,  1,  2,  3,  4,  5,  6,  7,  8,  9,  0,  1,  2,  3,  4,  5},
+    { 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10,  0,  1,  2,  3,  4},
+    { 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11,  0,  1,  2,  3},
+    { 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12,  0,  1,  2},
+    { 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13,  0,  1},
+    { 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,  0}};
+
+// shuffle masks moving a repeated block of 1-15 bytes to the next 16 bytes.
+static const uint8_t period_shifts[16][16] = {
+    { 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0},
+    { 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0},
+    { 0,  1,  0,  1,  0,  1,  0,  1,  0,  1,  0,  1,  0,  1,  0,  1},
+    { 1,  2,  0,  1,  2,  0,  1,  2,  0,  1,  2,  0,  1,  2,  0,  1},
+    { 0,  1,  2,  3,  0,  1,  2,  3,  0,  1,  2,  3,  0,  1,  2,  3},
+    { 1,  2,  3,  4,  0,  1,  2,  3,  4,  0,  1,  2,  3,  4,  0,  1},
+    { 4,  5,  0,  1,  2,  3,  4,  5,  0,  1,  2,  3,  4,  5,  0,  1},
+    { 2,  3,  4,  5,  6,  0,  1,  2,  3,  4,  5,  6,  0,  1,  2,  3},
+    { 0,  1,  2,  3,  4,  5,  6,  7,  0,  1,  2,  3,  4,  5,  6,  7},
+    { 7,  8,  0,  1,  2,  3,  4,  5,  6,  7,  8,  0,  1,  2,  3,  4},
+    { 6,  7,  8,  9,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9,  0,  1},
+    { 5,  6,  7,  8,  9, 10,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9},
+    { 4,  5,  6,  7,  8,  9, 10, 11,  0,  1,  2,  3,  4,  5,  6,  7},
+    { 3,  4,  5,  6,  7,  8,  9, 10, 11, 12,  0,  1,  2,  3,  4,  5},
+    { 2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13,  0,  1,  2,  3},
+    { 1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,  0,  1}};
+
+static inline uint32_t makeFastEntry(uint32_t size, uint32_t symbol) {
+    return size | (size << 4) | (symbol << 9);
+}
+
+PngDecoder::PngDecoder(BytesReader& file_data, DecoderScratch& scratch) {
     file_data_ = &file_data;
+    scratch_ = &scratch;
     png_info_.palette_length = 0;
     png_info_.palette = nullptr;
     png_info_.chunk_status = 0;
@@ -121,17 +136,21 @@ PngDecoder::PngDecoder(BytesReader& file_data) {
     file_data_->setCrcChecking(&crc32_);
     png_info_.fixed_huffman_done = false;
     png_info_.header_after_idat = false;
-    // crc32_.turnOff();
 }
 
 PngDecoder::~PngDecoder() {
-    if (png_info_.palette != nullptr) {
-        delete [] png_info_.palette;
-    }
-
     file_data_->unsetCrcChecking();
 }
 
+void PngDecoder::setCrcChecking(bool checking) {
+    if (checking) {
+        crc32_.turnOn();
+    }
+    else {
+        crc32_.turnOff();
+    }
+}
+
 void PngDecoder::getChunkHeader(PngInfo& png_info) {
     png_info.current_chunk.length = file_data_->getDWordBigEndian();
     png_info.current_chunk.type   = file_data_->getDWordBigEndian();
@@ -247,11 +266,6 @@ bool PngDecoder::parseIHDR(PngInfo& png_info) {
         return false;
     }
 
-    if (bit_depth_ == 16) {
-        LOG(ERROR) << "This implementation does not support bit depth 16.";
-        return false;
-    }
-
     return true;
 }
 
@@ -567,7 +581,8 @@ bool PngDecoder::parsePLTE(PngInfo& png_info) {
 
     uint32_t length = png_info.current_chunk.length / 3;
     png_info.palette_length = length;
-    png_info.palette = new uint8_t[1024];
+    png_info.palette = (uint8_t*)scratch_->reserve(PNG_PALETTE, 1024);
+    if (png_info.palette == nullptr) return false;
     uint8_t value0, value1, value2;
     for (uint32_t index = 0; index < length * 4; index += 4) {
         value0 = file_data_->getByte();
@@ -752,8 +767,11 @@ bool PngDecoder::parseIDATs(PngInfo& png_info, uint8_t* image,
         if (!succeeded) return false;
     }
 
-    succeeded = inflateImage(png_info, image, stride);
-    if (!succeeded) return false;
+    // IDAT chunks after the final block carry the rest of the zlib stream.
+    if (!png_info.zlib_buffer.is_final_block) {
+        succeeded = inflateImage(png_info, image, stride);
+        if (!succeeded) return false;
+    }
     // skipping 32 bits of the optional ADLER32 checksum in zlib data stream.
     if (png_info.current_chunk.type == png_IDAT) {
         file_data_->skipBytes(png_info.current_chunk.length);
@@ -830,7 +848,7 @@ bool PngDecoder::setCrc32() {
     }
 
     if (png_info_.current_chunk.length != 0) {
-        uint8_t* buffer = file_data_->getCurrentPosition();
+        const uint8_t* buffer = file_data_->getCurrentPosition();
         uint32_t buffer_size = file_data_->getValidSize();
         crc32_.setCrc(buffer, buffer_size, 0, png_info_.current_chunk.length);
 
@@ -866,8 +884,9 @@ bool PngDecoder::isCrcCorrect() {
 }
 
 bool PngDecoder::parseDeflateHeader() {
-    uint8_t cmf = file_data_->getByte();
-    uint8_t flags = file_data_->getByte();
+    // the header may run into the next IDAT chunk.
+    uint8_t cmf = (uint8_t)getNumber(&png_info_.zlib_buffer, 8);
+    uint8_t flags = (uint8_t)getNumber(&png_info_.zlib_buffer, 8);
     uint32_t compression_method = cmf & 15;
     uint32_t compresson_info = (cmf >> 4) & 15;
     if (compression_method != 8 ||
@@ -887,15 +906,18 @@ bool PngDecoder::parseDeflateHeader() {
                    << "specification.";
         return false;
     }
-    png_info_.current_chunk.length -= 2;
     png_info_.zlib_buffer.window_size = 1 << (compresson_info + 8);
 
     return true;
 }
 
 bool PngDecoder::fillBits(ZlibBuffer *zlib_buffer) {
+    // the IDAT chunks have been consumed, no more bits come.
+    if (png_info_.header_after_idat) return true;
+
     uint64_t segment;
-    if (png_info_.current_chunk.length > 8) {
+    if (png_info_.current_chunk.length > 8 &&
+        file_data_->ensureValidSize(sizeof(uint64_t))) {
         memcpy(&segment, file_data_->getCurrentPosition(), sizeof(uint64_t));
 
         zlib_buffer->code_buffer |= segment << zlib_buffer->bit_number;
@@ -953,17 +975,9 @@ bool PngDecoder::parseZlibUncompressedBlock(PngInfo& png_info) {
     if (ignored_bits) {
         getNumber(&zlib_buffer, ignored_bits);
     }
-    uint32_t index = 0;
-    while (zlib_buffer.bit_number > 0 && index < 4) {
-        header[index++] = (uint8_t)(zlib_buffer.code_buffer & 255);
-        zlib_buffer.code_buffer >>= 8;
-        zlib_buffer.bit_number -= 8;
-    }
-    if (zlib_buffer.bit_number == 0 && index < 4) {
-        while (index < 4) {
-            header[index++] = file_data_->getByte();
-            png_info_.current_chunk.length -= 1;
-        }
+    // the header may run into the next IDAT chunk.
+    for (uint32_t index = 0; index < 4; ++index) {
+        header[index] = (uint8_t)getNumber(&zlib_buffer, 8);
     }
     uint32_t len  = header[1] * 256 + header[0];
     uint32_t nlen = header[3] * 256 + header[2];
@@ -977,13 +991,16 @@ bool PngDecoder::parseZlibUncompressedBlock(PngInfo& png_info) {
     }
 
     if (zlib_buffer.bit_number > 0) {
-        uint32_t size = zlib_buffer.bit_number >> 3;
+        // bytes beyond a short block belong to the next block header.
+        uint32_t size = std::min(zlib_buffer.bit_number >> 3, len);
         memcpy(png_info.decompressed_image, &(zlib_buffer.code_buffer), size);
         png_info.decompressed_image += size;
-        zlib_buffer.code_buffer = 0;
-        zlib_buffer.bit_number = 0;
+        zlib_buffer.code_buffer >>= size << 3;
+        zlib_buffer.bit_number -= size << 3;
         len -= size;
     }
+    // drops bits loaded ahead, as the stored bytes are read past them.
+    zlib_buffer.code_buffer &= ((uint64_t)1 << zlib_buffer.bit_number) - 1;
 
     do {
         if (len <= png_info.current_chunk.length) {
@@ -1077,7 +1094,7 @@ bool PngDecoder::buildHuffmanCode(ZlibHuffman *huffman_coding,
         if (size) {
             int index = next_code[size] - huffman_coding->first_code[size] +
                         huffman_coding->first_symbol[size];
-            uint16_t fast_value = (uint16_t) ((size << 9) | i);
+            uint32_t fast_value = makeFastEntry(size, i);
             huffman_coding->size [index] = (uint8_t)size;
             huffman_coding->value[index] = (uint16_t)i;
             if (size <= ZLIB_FAST_BITS) {
@@ -1132,7 +1149,7 @@ bool PngDecoder::buildHuffmanCode(ZlibHuffman *huffman_coding,
     for (i = 0; i < number; ++i) {
         int index = next_code[size] - huffman_coding->first_code[size] +
                     huffman_coding->first_symbol[size];
-        uint16_t fast_value = (uint16_t) ((size << 9) | i);
+        uint32_t fast_value = makeFastEntry(size, i);
         huffman_coding->size [index] = (uint8_t)size;
         huffman_coding->value[index] = (uint16_t)i;
         if (size <= ZLIB_FAST_BITS) {
@@ -1148,6 +1165,29 @@ bool PngDecoder::buildHuffmanCode(ZlibHuffman *huffman_coding,
     return true;
 }
 
+/* A literal whose fast entry leaves enough bits for a following short literal
+ * is merged with it, so runs of literals are decoded two per lookup. The table
+ * is walked downwards, as the entry for the second code at index >> size is
+ * never above the index and is still a single one when it is read.
+ */
+static void combineLiteralPairs(ZlibHuffman *huffman_coding) {
+    uint32_t *fast = huffman_coding->fast;
+    for (int32_t i = (1 << ZLIB_FAST_BITS) - 1; i >= 0; --i) {
+        uint32_t first = fast[i];
+        if (first == 0 || (first >> 9) >= 256) continue;
+
+        uint32_t first_size = first & 15;
+        uint32_t second = fast[i >> first_size];
+        if (second == 0 || (second >> 9) >= 256) continue;
+
+        uint32_t size = first_size + (second & 15);
+        if (size > ZLIB_FAST_BITS) continue;
+
+        fast[i] = first_size | (size << 4) | FAST_PAIR_FLAG |
+                  ((first >> 9) << 9) | ((second >> 9) << 18);
+    }
+}
+
 int32_t PngDecoder::huffmanDecodeSlowly(ZlibBuffer *zlib_buffer,
                                         ZlibHuffman *huffman_coding) {
     int32_t bits, size, index;
@@ -1175,10 +1215,10 @@ int32_t PngDecoder::huffmanDecode(ZlibBuffer *zlib_buffer,
     uint32_t fast_bits, size;
     fast_bits = huffman_coding->fast[zlib_buffer->code_buffer & ZLIB_FAST_MASK];
     if (fast_bits) {
-        size = fast_bits >> 9;
+        size = fast_bits & 15;
         zlib_buffer->code_buffer >>= size;
         zlib_buffer->bit_number   -= size;
-        return fast_bits & 511;
+        return (fast_bits >> 9) & 511;
     }
 
     int32_t value = huffmanDecodeSlowly(zlib_buffer, huffman_coding);
@@ -1255,6 +1295,7 @@ bool PngDecoder::computeDynamicHuffman(ZlibBuffer* zlib_buffer) {
     succeeded = buildHuffmanCode(&zlib_buffer->length_huffman, length_codes,
                                  hlit);
     if (!succeeded) return false;
+    combineLiteralPairs(&zlib_buffer->length_huffman);
 
     succeeded = buildHuffmanCode(&zlib_buffer->distance_huffman,
                                  length_codes + hlit, hdist);
@@ -1263,47 +1304,180 @@ bool PngDecoder::computeDynamicHuffman(ZlibBuffer* zlib_buffer) {
     return true;
 }
 
+void PngDecoder::takeInput(const uint8_t* &input, const uint8_t* &input_end) {
+    input = file_data_->getCurrentPosition();
+    input_end = input;
+    if (!png_info_.header_after_idat) {
+        input_end += std::min(png_info_.current_chunk.length,
+                              file_data_->getValidSize());
+    }
+}
+
+void PngDecoder::returnInput(const uint8_t* input) {
+    uint32_t size = input - file_data_->getCurrentPosition();
+    file_data_->skipBytes(size);
+    png_info_.current_chunk.length -= size;
+}
+
+/* Loads 64 bits at a time from the IDAT data which the inflating loop reads
+ * by itself. Near the end of a chunk or of the buffered block, the read
+ * position goes back to fillBits() to cross the boundary.
+ */
+inline
+bool PngDecoder::refillBits(ZlibBuffer *zlib_buffer, const uint8_t* &input,
+                            const uint8_t* &input_end) {
+    if (input_end - input >= 8) {
+        uint64_t segment;
+        memcpy(&segment, input, sizeof(uint64_t));
+        zlib_buffer->code_buffer |= segment << zlib_buffer->bit_number;
+        input += 7 - ((zlib_buffer->bit_number >> 3) & 7);
+        zlib_buffer->bit_number |= 56;
+
+        return true;
+    }
+
+    returnInput(input);
+    bool succeeded = fillBits(zlib_buffer);
+    if (!succeeded) return false;
+    takeInput(input, input_end);
+
+    return true;
+}
+
+/* Copies a back reference in 16-byte blocks, which may write up to 15 bytes
+ * past the match. A source nearer than one block is loaded once, and its
+ * period is repeated over the block and carried to the next one by shuffles.
+ */
+static inline
+void copyMatch(uint8_t* output, uint32_t distance, uint32_t length) {
+    const uint8_t* source = output - distance;
+    uint8_t* output_end = output + length;
+    if (distance >= 16) {
+        do {
+            __m128i value = _mm_loadu_si128((const __m128i*)source);
+            _mm_storeu_si128((__m128i*)output, value);
+            source += 16;
+            output += 16;
+        } while (output < output_end);
+    }
+    else {
+        __m128i masks  = _mm_loadu_si128((const __m128i*)
+                                         period_masks[distance]);
+        __m128i shifts = _mm_loadu_si128((const __m128i*)
+                                         period_shifts[distance]);
+        __m128i value  = _mm_loadu_si128((const __m128i*)source);
+        value = _mm_shuffle_epi8(value, masks);
+        do {
+            _mm_storeu_si128((__m128i*)output, value);
+            value = _mm_shuffle_epi8(value, shifts);
+            output += 16;
+        } while (output < output_end);
+    }
+}
+
 bool PngDecoder::decodeHuffmanData(ZlibBuffer* zlib_buffer) {
     uint8_t *output = png_info_.decompressed_image;
-    uint32_t rounded_length;
+    uint8_t *output_end = png_info_.decompressed_image_end;
+    const uint32_t *length_fast = zlib_buffer->length_huffman.fast;
+    const uint32_t *distance_fast = zlib_buffer->distance_huffman.fast;
+    const uint8_t *input, *input_end;
+    takeInput(input, input_end);
 
     while (1) {
-        int32_t value = huffmanDecode(zlib_buffer,
-                                      &zlib_buffer->length_huffman);
+        // a refill of 56 bits and more covers several literal codes.
+        if (zlib_buffer->bit_number < 16) {
+            bool succeeded = refillBits(zlib_buffer, input, input_end);
+            if (!succeeded) return false;
+        }
+
+        int32_t value;
+        uint32_t entry = length_fast[zlib_buffer->code_buffer & ZLIB_FAST_MASK];
+        uint32_t size = (entry >> 4) & 15;
+        if ((entry & FAST_PAIR_FLAG) && size <= zlib_buffer->bit_number) {
+            if (output_end - output < 2) {
+                LOG(ERROR) << "No space stores decoded literals in zlib.";
+                return false;
+            }
+            output[0] = (uint8_t)(entry >> 9);
+            output[1] = (uint8_t)(entry >> 18);
+            output += 2;
+            zlib_buffer->code_buffer >>= size;
+            zlib_buffer->bit_number   -= size;
+            continue;
+        }
+        if (entry) {
+            size = entry & 15;
+            zlib_buffer->code_buffer >>= size;
+            zlib_buffer->bit_number   -= size;
+            value = (entry >> 9) & 511;
+        }
+        else {
+            value = huffmanDecodeSlowly(zlib_buffer,
+                                        &zlib_buffer->length_huffman);
+        }
+
         if (value < 256) {
             if (value < 0) {
                 LOG(ERROR) << "Invalid decoded literal/length code: " << value
                            << ", valid value: 0-285.";
                 return false;
             }
+            if (output == output_end) {
+                LOG(ERROR) << "No space stores decoded literals in zlib.";
+                return false;
+            }
             *output++ = (uint8_t)value;
         } else {
             uint32_t length, distance;
             if (value == 256) {
                 png_info_.decompressed_image = output;
+                returnInput(input);
                 return true;
             }
+            if (value > 285) {
+                LOG(ERROR) << "Invalid decoded literal/length code: " << value
+                           << ", valid value: 0-285.";
+                return false;
+            }
+            // bits of a length, a distance code and a distance, 5 + 15 + 13,
+            // which are taken below without checking.
+            if (zlib_buffer->bit_number < 33) {
+                bool succeeded = refillBits(zlib_buffer, input, input_end);
+                if (!succeeded) return false;
+            }
             value -= 257;
             length = length_base[value];
-            if (length_extra_bits[value]) {
-                length += getNumber(zlib_buffer, length_extra_bits[value]);
-            }
+            size = length_extra_bits[value];
+            length += zlib_buffer->code_buffer & ((1 << size) - 1);
+            zlib_buffer->code_buffer >>= size;
+            zlib_buffer->bit_number   -= size;
             if (png_info_.decompressed_image_end - output < length) {
                 LOG(ERROR) << "Invalid decoded length: " << length
                            << ", valid value: 0-"
                            << png_info_.decompressed_image_end - output;
                 return false;
             }
-            value = huffmanDecode(zlib_buffer, &zlib_buffer->distance_huffman);
-            if (value < 0) {
+            entry = distance_fast[zlib_buffer->code_buffer & ZLIB_FAST_MASK];
+            if (entry) {
+                size = entry & 15;
+                zlib_buffer->code_buffer >>= size;
+                zlib_buffer->bit_number   -= size;
+                value = (entry >> 9) & 511;
+            }
+            else {
+                value = huffmanDecodeSlowly(zlib_buffer,
+                                            &zlib_buffer->distance_huffman);
+            }
+            if (value < 0 || value > 29) {
                 LOG(ERROR) << "Invalid decoded distance code: " << value
-                           << ", valid value: 0-31.";
+                           << ", valid value: 0-29.";
                 return false;
             }
             distance = distance_base[value];
-            if (distance_extra_bits[value]) {
-                distance += getNumber(zlib_buffer, distance_extra_bits[value]);
-            }
+            size = distance_extra_bits[value];
+            distance += zlib_buffer->code_buffer & ((1 << size) - 1);
+            zlib_buffer->code_buffer >>= size;
+            zlib_buffer->bit_number   -= size;
             if (output - png_info_.decompressed_image_start < distance) {
                 LOG(ERROR) << "Invalid decoded distance: " << distance
                            << ", valid value: 0-"
@@ -1315,36 +1489,15 @@ bool PngDecoder::decodeHuffmanData(ZlibBuffer* zlib_buffer) {
                            << ", valid value: 0-" << zlib_buffer->window_size;
                 return false;
             }
-            uint8_t *copy_address = (uint8_t *) (output - distance);
-            if (distance == 1) {  // run of one byte, common in images.
-                uint8_t source = *copy_address;
-                if (output + length + 8 < png_info_.decompressed_image_end) {
-                    rounded_length = (length + 7) & -8;
-                    memset(output, source, rounded_length);
-                }
-                else {
-                    memset(output, source, length);
-                }
+            if (output_end - output >= length + 16) {
+                copyMatch(output, distance, length);
                 output += length;
-            } else {
-                if (distance >= length) {
-                    if (output + length + 8 <
-                        png_info_.decompressed_image_end) {
-                        rounded_length = (length + 7) & -8;
-                        memcpy(output, copy_address, rounded_length);
-                    }
-                    else {
-                        memcpy(output, copy_address, length);
-                    }
-                    output += length;
-                }
-                else {  // 2 <= distance < length
-                    if (length) {
-                        do {
-                            *output++ = *copy_address++;
-                        } while (--length);
-                    }
-                }
+            }
+            else {  // the last bytes of the image, copied exactly.
+                uint8_t *copy_address = output - distance;
+                do {
+                    *output++ = *copy_address++;
+                } while (--length);
             }
         }
     }
@@ -1352,7 +1505,8 @@ bool PngDecoder::decodeHuffmanData(ZlibBuffer* zlib_buffer) {
 
 bool PngDecoder::inflateImage(PngInfo& png_info, uint8_t* image,
                               uint32_t stride) {
-    if (png_info.current_chunk.length == 0) {
+    if (png_info.current_chunk.length == 0 &&
+        png_info.zlib_buffer.bit_number == 0) {
         LOG(ERROR) << "No data in the IDAT chunk is needed to be decompressed.";
         return false;
     }
@@ -1374,6 +1528,7 @@ bool PngDecoder::inflateImage(PngInfo& png_info, uint8_t* image,
                     succeeded = buildHuffmanCode(&zlib_buffer.length_huffman,
                                   default_length_sizes, SYMBOL_NUMBER);
                     if (!succeeded) return false;
+                    combineLiteralPairs(&zlib_buffer.length_huffman);
                     succeeded = buildHuffmanCode(&zlib_buffer.distance_huffman,
                                   default_distance_sizes, 32);
                     if (!succeeded) return false;
@@ -1383,6 +1538,8 @@ bool PngDecoder::inflateImage(PngInfo& png_info, uint8_t* image,
                 if (!succeeded) return false;
                 break;
             case DYNAMIC_HUFFMAN:
+                // the dynamic tables take the place of the fixed ones.
+                png_info.fixed_huffman_done = false;
                 succeeded = computeDynamicHuffman(&zlib_buffer);
                 if (!succeeded) return false;
 
@@ -1394,7 +1551,7 @@ bool PngDecoder::inflateImage(PngInfo& png_info, uint8_t* image,
                            << (uint32_t)zlib_buffer.encoding_method
                            << ", valid values: stored section(0)/"
                            << "static huffman(1)/dynamic huffman(2).";
-                break;
+                return false;
         }
 
     } while (!zlib_buffer.is_final_block);
@@ -1434,13 +1591,13 @@ inline
 void rowDefilter2(uint8_t* input_row, uint8_t* prior_row, uint32_t row_bytes,
                   uint8_t* recon_row, bool overflowed) {
     uint32_t i = 0;
-    row_bytes -= 16;
-    for (; i < row_bytes; i+= 16) {
+    for (; i + 16 <= row_bytes; i+= 16) {
         __m128i input_data = _mm_loadu_si128((__m128i*)(input_row + i));
         __m128i prior_data = _mm_loadu_si128((__m128i*)(prior_row + i));
         __m128i current_data = _mm_add_epi8(input_data, prior_data);
         _mm_storeu_si128((__m128i*)(recon_row + i), current_data);
     }
+    if (i == row_bytes) return;
 
     if (overflowed) {
         __m128i input_data = _mm_loadu_si128((__m128i*)(input_row + i));
@@ -1449,7 +1606,6 @@ void rowDefilter2(uint8_t* input_row, uint8_t* prior_row, uint32_t row_bytes,
         _mm_storeu_si128((__m128i*)(recon_row + i), current_data);
     }
     else {
-        row_bytes += 16;
         for (; i < row_bytes; i++) {
             recon_row[i] = input_row[i] + prior_row[i];
         }
@@ -1470,21 +1626,6 @@ void rowDefilter3(uint8_t* input_row, uint8_t* prior_row, uint32_t pixel_bytes,
     }
 }
 
-inline
-void rowDefilter3C2(uint8_t* input_row, uint8_t* prior_row, uint32_t row_bytes,
-                    uint8_t* recon_row) {
-    recon_row[0] = input_row[0] + (prior_row[0] >> 1);
-    recon_row[1] = input_row[1] + (prior_row[1] >> 1);
-
-    uint32_t i = 2;
-    uint32_t j = 0;
-    for (; i < row_bytes; i += 2, j += 2) {
-        recon_row[i]     = input_row[i] + ((recon_row[j] + prior_row[i]) >> 1);
-        recon_row[i + 1] = input_row[i + 1] +
-                           ((recon_row[j + 1] + prior_row[i + 1]) >> 1);
-    }
-}
-
 inline
 void row0Defilter3(uint8_t* input_row, uint32_t pixel_bytes,
                    uint32_t row_bytes, uint8_t* recon_row) {
@@ -1499,16 +1640,132 @@ void row0Defilter3(uint8_t* input_row, uint32_t pixel_bytes,
     }
 }
 
+/* Paeth predictor without branches, it picks the same value as the one of the
+ * specification, while the comparisons of the straightforward form mispredict
+ * on noisy rows.
+ */
 inline
 int filterPaeth(int a, int b, int c) {
-    int p = a + b - c;
-    int pa = abs(p - a);
-    int pb = abs(p - b);
-    int pc = abs(p - c);
-    if (pa <= pb && pa <= pc) return a;
-    if (pb <= pc) return b;
+    int threshold = c * 3 - (a + b);
+    int low  = a < b ? a : b;
+    int high = a < b ? b : a;
+    int target = (high <= threshold) ? low : c;
+
+    return (threshold <= low) ? high : target;
+}
+
+// loads/stores a pixel of 2, 4, 6 or 8 bytes in the low bytes of a register.
+template <int pixel_bytes>
+inline __m128i loadPixel(const uint8_t* data);
+
+template <>
+inline __m128i loadPixel<2>(const uint8_t* data) {
+    return _mm_cvtsi32_si128(*(const uint16_t*)data);
+}
+
+template <>
+inline __m128i loadPixel<4>(const uint8_t* data) {
+    return _mm_cvtsi32_si128(*(const int32_t*)data);
+}
+
+template <>
+inline __m128i loadPixel<6>(const uint8_t* data) {
+    __m128i value = _mm_cvtsi32_si128(*(const int32_t*)data);
+    return _mm_insert_epi16(value, *(const uint16_t*)(data + 4), 2);
+}
+
+template <>
+inline __m128i loadPixel<8>(const uint8_t* data) {
+    return _mm_loadl_epi64((const __m128i*)data);
+}
+
+template <int pixel_bytes>
+inline void storePixel(uint8_t* data, __m128i value);
+
+template <>
+inline void storePixel<2>(uint8_t* data, __m128i value) {
+    *(uint16_t*)data = (uint16_t)_mm_cvtsi128_si32(value);
+}
+
+template <>
+inline void storePixel<4>(uint8_t* data, __m128i value) {
+    *(int32_t*)data = _mm_cvtsi128_si32(value);
+}
+
+template <>
+inline void storePixel<6>(uint8_t* data, __m128i value) {
+    *(int32_t*)data = _mm_cvtsi128_si32(value);
+    *(uint16_t*)(data + 4) = (uint16_t)_mm_extract_epi16(value, 2);
+}
+
+template <>
+inline void storePixel<8>(uint8_t* data, __m128i value) {
+    _mm_storel_epi64((__m128i*)data, value);
+}
+
+// reorders the 16-bit samples of RGB/RGBA pixels to BGR/BGRA.
+inline __m128i swapSamplesIndex() {
+    return _mm_setr_epi8(4, 5, 2, 3, 0, 1, 6, 7, -1, -1, -1, -1, -1, -1, -1,
+                         -1);
+}
+
+/* Average and Paeth unfiltering of the rows with 2, 4, 6 or 8 bytes per
+ * pixel, a pixel depends on the reconstructed one on its left, so the pixels
+ * are processed one by one with all their bytes in a register. With swapped,
+ * the 16-bit samples of a 6/8-byte pixel come out in BGR/BGRA order.
+ */
+template <int pixel_bytes, bool swapped>
+inline
+void rowDefilter3Simd(uint8_t* input_row, uint8_t* prior_row,
+                      uint32_t row_bytes, uint8_t* recon_row) {
+    __m128i swap_index = swapSamplesIndex();
+    __m128i one = _mm_set1_epi8(1);
+    __m128i a = _mm_setzero_si128();
+    __m128i input, b, average;
+    for (uint32_t i = 0; i < row_bytes; i += pixel_bytes) {
+        input = loadPixel<pixel_bytes>(input_row + i);
+        if (swapped) input = _mm_shuffle_epi8(input, swap_index);
+        b = loadPixel<pixel_bytes>(prior_row + i);
+        // (a + b) >> 1, _mm_avg_epu8() rounds up.
+        average = _mm_sub_epi8(_mm_avg_epu8(a, b),
+                               _mm_and_si128(_mm_xor_si128(a, b), one));
+        a = _mm_add_epi8(input, average);
+        storePixel<pixel_bytes>(recon_row + i, a);
+    }
+}
+
+// branchless Paeth predictor on 16-bit lanes, ties prefer a, then b.
+inline
+__m128i predictPaeth(__m128i a, __m128i b, __m128i c) {
+    __m128i pa = _mm_sub_epi16(b, c);  // p - a
+    __m128i pb = _mm_sub_epi16(a, c);  // p - b
+    __m128i pc = _mm_abs_epi16(_mm_add_epi16(pa, pb));
+    pa = _mm_abs_epi16(pa);
+    pb = _mm_abs_epi16(pb);
+    __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+    __m128i nearest  = _mm_blendv_epi8(c, b, _mm_cmpeq_epi16(smallest, pb));
 
-    return c;
+    return _mm_blendv_epi8(nearest, a, _mm_cmpeq_epi16(smallest, pa));
+}
+
+template <int pixel_bytes, bool swapped>
+inline
+void rowDefilter4Simd(uint8_t* input_row, uint8_t* prior_row,
+                      uint32_t row_bytes, uint8_t* recon_row) {
+    __m128i swap_index = swapSamplesIndex();
+    __m128i low_bytes = _mm_set1_epi16(0xFF);
+    __m128i a = _mm_setzero_si128();
+    __m128i c = _mm_setzero_si128();
+    __m128i input, b;
+    for (uint32_t i = 0; i < row_bytes; i += pixel_bytes) {
+        input = loadPixel<pixel_bytes>(input_row + i);
+        if (swapped) input = _mm_shuffle_epi8(input, swap_index);
+        b = _mm_cvtepu8_epi16(loadPixel<pixel_bytes>(prior_row + i));
+        a = _mm_add_epi16(_mm_cvtepu8_epi16(input), predictPaeth(a, b, c));
+        a = _mm_and_si128(a, low_bytes);
+        c = b;
+        storePixel<pixel_bytes>(recon_row + i, _mm_packus_epi16(a, a));
+    }
 }
 
 inline
@@ -1526,64 +1783,6 @@ void rowDefilter4(uint8_t* input_row, uint8_t* prior_row, uint32_t pixel_bytes,
     }
 }
 
-inline
-void filterPaethC2(uint8_t* a, uint8_t* b, uint8_t* c, uint8_t* src,
-                   uint8_t* result) {
-    int a0 = a[0];
-    int a1 = a[1];
-    int b0 = b[0];
-    int b1 = b[1];
-    int c0 = c[0];
-    int c1 = c[1];
-    int p0 = a0 + b0 -c0;
-    int p1 = a1 + b1 -c1;
-    int pa0 = abs(p0 - a0);
-    int pa1 = abs(p1 - a1);
-    int pb0 = abs(p0 - b0);
-    int pb1 = abs(p1 - b1);
-    int pc0 = abs(p0 - c0);
-    int pc1 = abs(p1 - c1);
-    int target0, target1;
-    if (pa0 <= pb0 && pa0 <= pc0) {
-        target0 = a0;
-    }
-    else if (pb0 <= pc0) {
-        target0 = b0;
-    }
-    else {
-        target0 = c0;
-    }
-    if (pa1 <= pb1 && pa1 <= pc1) {
-        target1 = a1;
-    }
-    else if (pb1 <= pc1) {
-        target1 = b1;
-    }
-    else {
-        target1 = c1;
-    }
-
-    target0 += src[0];
-    target1 += src[1];
-
-    result[0] = target0;
-    result[1] = target1;
-}
-
-inline
-void rowDefilter4C2(uint8_t* input_row, uint8_t* prior_row,
-                    uint32_t row_bytes, uint8_t* recon_row) {
-    recon_row[0] = input_row[0] + prior_row[0];
-    recon_row[1] = input_row[1] + prior_row[1];
-
-    uint32_t i = 2;
-    uint32_t j = 0;
-    for (; i < row_bytes; i += 2, j += 2) {
-        filterPaethC2(recon_row + j, prior_row + i, prior_row + j,
-                      input_row + i, recon_row + i);
-    }
-}
-
 /* process an image with color type 0/3/4, which does not need rgb-> bgr
  * transformation.
  */
@@ -1604,7 +1803,6 @@ bool PngDecoder::deFilterImage(PngInfo& png_info, uint8_t* image,
     uint8_t *recon_row = image + stride_offset0;
     uint8_t *prior_row;
     uint8_t filter_type;
-    uint32_t aligned_bytes = (row_bytes + 15) & -16;
 
     // process the first row.
     filter_type = *input++;
@@ -1617,7 +1815,7 @@ bool PngDecoder::deFilterImage(PngInfo& png_info, uint8_t* image,
     switch (filter_type) {
         case FILTER_NONE:
         case FILTER_UP:
-            memcpy(recon_row, input, aligned_bytes);
+            memmove(recon_row, input, row_bytes);
             break;
         case FILTER_SUB:
         case FILTER_PAETH:
@@ -1630,8 +1828,8 @@ bool PngDecoder::deFilterImage(PngInfo& png_info, uint8_t* image,
     input += row_bytes;
     recon_row += stride;
 
-    // process the most rows.
-    for (uint32_t row = 1; row < height_ - 1; ++row) {
+    // process the other rows.
+    for (uint32_t row = 1; row < height_; ++row) {
         prior_row = recon_row - stride;
         filter_type = *input++;
         if (filter_type > 4) {
@@ -1642,7 +1840,7 @@ bool PngDecoder::deFilterImage(PngInfo& png_info, uint8_t* image,
         }
         switch (filter_type) {
             case FILTER_NONE:
-                memcpy(recon_row, input, aligned_bytes);
+                memmove(recon_row, input, row_bytes);
                 break;
             case FILTER_SUB:
                 if (pixel_bytes == 2) {
@@ -1654,11 +1852,16 @@ bool PngDecoder::deFilterImage(PngInfo& png_info, uint8_t* image,
                 break;
             case FILTER_UP:
                 rowDefilter2(input, prior_row, row_bytes, recon_row,
-                             row < height_ - 15 ? true : false);
+                             row + 15 < height_ ? true : false);
                 break;
             case FILTER_AVERAGE:
                 if (pixel_bytes == 2) {
-                    rowDefilter3C2(input, prior_row, row_bytes, recon_row);
+                    rowDefilter3Simd<2, false>(input, prior_row, row_bytes,
+                                               recon_row);
+                }
+                else if (pixel_bytes == 4) {
+                    rowDefilter3Simd<4, false>(input, prior_row, row_bytes,
+                                               recon_row);
                 }
                 else {
                     rowDefilter3(input, prior_row, pixel_bytes, row_bytes,
@@ -1667,7 +1870,12 @@ bool PngDecoder::deFilterImage(PngInfo& png_info, uint8_t* image,
                 break;
             case FILTER_PAETH:
                 if (pixel_bytes == 2) {
-                    rowDefilter4C2(input, prior_row, row_bytes, recon_row);
+                    rowDefilter4Simd<2, false>(input, prior_row, row_bytes,
+                                               recon_row);
+                }
+                else if (pixel_bytes == 4) {
+                    rowDefilter4Simd<4, false>(input, prior_row, row_bytes,
+                                               recon_row);
                 }
                 else {
                     rowDefilter4(input, prior_row, pixel_bytes, row_bytes,
@@ -1679,50 +1887,6 @@ bool PngDecoder::deFilterImage(PngInfo& png_info, uint8_t* image,
         recon_row += stride;
     }
 
-    // process the last row.
-    prior_row = recon_row - stride;
-    filter_type = *input++;
-    if (filter_type > 4) {
-        LOG(ERROR) << "The readed filter type: " << (uint32_t)filter_type
-                   << ", correct filter type: None(0)/Sub(1)/Up(2)/"
-                   << "Average(3)/Paeth(4)";
-        return false;
-    }
-    switch (filter_type) {
-        case FILTER_NONE:
-            memcpy(recon_row, input, row_bytes);
-            break;
-        case FILTER_SUB:
-            if (pixel_bytes == 2) {
-                rowDefilter1C2(input, row_bytes, recon_row);
-            }
-            else {
-                rowDefilter1(input, pixel_bytes, row_bytes, recon_row);
-            }
-            break;
-        case FILTER_UP:
-            rowDefilter2(input, prior_row, row_bytes, recon_row, false);
-            break;
-        case FILTER_AVERAGE:
-            if (pixel_bytes == 2) {
-                rowDefilter3C2(input, prior_row, row_bytes, recon_row);
-            }
-            else {
-                rowDefilter3(input, prior_row, pixel_bytes, row_bytes,
-                             recon_row);
-            }
-            break;
-        case FILTER_PAETH:
-            if (pixel_bytes == 2) {
-                rowDefilter4C2(input, prior_row, row_bytes, recon_row);
-            }
-            else {
-                rowDefilter4(input, prior_row, pixel_bytes, row_bytes,
-                             recon_row);
-            }
-            break;
-    }
-
     uint32_t stride_offset1 = 0;
     if ((color_type_ == 0 && encoded_channels_ + 1 == channels_) ||
         color_type_ == 3) {
@@ -1789,9 +1953,10 @@ bool PngDecoder::deFilterImage(PngInfo& png_info, uint8_t* image,
         uint8_t value0, value1;
         uint8_t *recon_row = image + stride_offset0;
         uint16_t *current_row16;
+        uint32_t samples = width_ * encoded_channels_;
         for (uint32_t row = 0; row < height_; row++) {
             current_row16 = (uint16_t*)recon_row;
-            for (uint32_t col = 0, col1 = 0; col < width_; col++, col1 += 2) {
+            for (uint32_t col = 0, col1 = 0; col < samples; col++, col1 += 2) {
                 value0 = recon_row[col1];
                 value1 = recon_row[col1 + 1];
                 current_row16[col] = (value0 << 8) | value1;
@@ -2027,7 +2192,10 @@ void rowDefilter1ColorC3(uint8_t* input_row, uint32_t row_bytes,
         }
         else {
             uint32_t value0, value1, value2;
-            uint8_t* before_bytes = recon_row - 3;
+            // a row without a pixel on the left of its tail starts with zeros.
+            uint8_t zero_pixel[4] = {0, 0, 0, 0};
+            bool row_start = (input_row + row_bytes == input_end);
+            uint8_t* before_bytes = row_start ? zero_pixel : recon_row - 3;
             while (input_row < input_end) {
                 value0 = input_row[0];
                 value1 = input_row[1];
@@ -2037,7 +2205,7 @@ void rowDefilter1ColorC3(uint8_t* input_row, uint32_t row_bytes,
                 recon_row[2] = value0 + before_bytes[2];
                 recon_row    += 3;
                 input_row    += 3;
-                before_bytes += 3;
+                before_bytes = recon_row - 3;
             }
         }
     }
@@ -2108,7 +2276,10 @@ void rowDefilter1ColorC4(uint8_t* input_row, uint32_t row_bytes,
         }
         else {
             uint32_t value0, value1, value2, value3;
-            uint8_t* before_bytes = recon_row - 4;
+            // a row without a pixel on the left of its tail starts with zeros.
+            uint8_t zero_pixel[4] = {0, 0, 0, 0};
+            bool row_start = (input_row + row_bytes == input_end);
+            uint8_t* before_bytes = row_start ? zero_pixel : recon_row - 4;
             while (input_row < input_end) {
                 value0 = input_row[0];
                 value1 = input_row[1];
@@ -2120,7 +2291,7 @@ void rowDefilter1ColorC4(uint8_t* input_row, uint32_t row_bytes,
                 recon_row[3] = value3 + before_bytes[3];
                 recon_row    += 4;
                 input_row    += 4;
-                before_bytes += 4;
+                before_bytes = recon_row - 4;
             }
         }
     }
@@ -2653,7 +2824,10 @@ void rowDefilter3ColorC3(uint8_t* input_row, uint8_t* prior_row,
         }
         else {
             uint32_t value0, value1, value2;
-            uint8_t* before_bytes = recon_row - 3;
+            // a row without a pixel on the left of its tail starts with zeros.
+            uint8_t zero_pixel[4] = {0, 0, 0, 0};
+            bool row_start = (input_row + row_bytes == input_end);
+            uint8_t* before_bytes = row_start ? zero_pixel : recon_row - 3;
             while (input_row < input_end) {
                 value0 = input_row[0];
                 value1 = input_row[1];
@@ -2663,7 +2837,7 @@ void rowDefilter3ColorC3(uint8_t* input_row, uint8_t* prior_row,
                 recon_row[2] = value0 + ((before_bytes[2] + prior_row[2]) >> 1);
                 recon_row    += 3;
                 input_row    += 3;
-                before_bytes += 3;
+                before_bytes = recon_row - 3;
                 prior_row    += 3;
             }
         }
@@ -2785,7 +2959,10 @@ void rowDefilter3ColorC4(uint8_t* input_row, uint8_t* prior_row,
         }
         else {
             uint32_t value0, value1, value2, value3;
-            uint8_t* before_bytes = recon_row - 4;
+            // a row without a pixel on the left of its tail starts with zeros.
+            uint8_t zero_pixel[4] = {0, 0, 0, 0};
+            bool row_start = (input_row + row_bytes == input_end);
+            uint8_t* before_bytes = row_start ? zero_pixel : recon_row - 4;
             while (input_row < input_end) {
                 value0 = input_row[0];
                 value1 = input_row[1];
@@ -2797,105 +2974,13 @@ void rowDefilter3ColorC4(uint8_t* input_row, uint8_t* prior_row,
                 recon_row[3] = value3 + ((before_bytes[3] + prior_row[3]) >> 1);
                 recon_row    += 4;
                 input_row    += 4;
-                before_bytes += 4;
+                before_bytes = recon_row - 4;
                 prior_row    += 4;
             }
         }
     }
 }
 
-inline
-void rowDefilter3ColorC6(uint8_t* input_row, uint8_t* prior_row,
-                         uint32_t row_bytes, uint8_t* recon_row) {
-    uint32_t value0, value1, value2, value3, value4, value5;
-    value0 = input_row[0];
-    value1 = input_row[1];
-    value2 = input_row[2];
-    value3 = input_row[3];
-    value4 = input_row[4];
-    value5 = input_row[5];
-    recon_row[0] = value4 + (prior_row[0] >> 1);
-    recon_row[1] = value5 + (prior_row[1] >> 1);
-    recon_row[2] = value2 + (prior_row[2] >> 1);
-    recon_row[3] = value3 + (prior_row[3] >> 1);
-    recon_row[4] = value0 + (prior_row[4] >> 1);
-    recon_row[5] = value1 + (prior_row[5] >> 1);
-
-    uint8_t* input_end = input_row + row_bytes;
-    uint8_t* before_bytes = recon_row;
-    input_row += 6;
-    prior_row += 6;
-    recon_row += 6;
-    while (input_row < input_end) {
-        value0 = input_row[0];
-        value1 = input_row[1];
-        value2 = input_row[2];
-        value3 = input_row[3];
-        value4 = input_row[4];
-        value5 = input_row[5];
-        recon_row[0] = value4 + ((before_bytes[0] + prior_row[0]) >> 1);
-        recon_row[1] = value5 + ((before_bytes[1] + prior_row[1]) >> 1);
-        recon_row[2] = value2 + ((before_bytes[2] + prior_row[2]) >> 1);
-        recon_row[3] = value3 + ((before_bytes[3] + prior_row[3]) >> 1);
-        recon_row[4] = value0 + ((before_bytes[4] + prior_row[4]) >> 1);
-        recon_row[5] = value1 + ((before_bytes[5] + prior_row[5]) >> 1);
-        recon_row    += 6;
-        input_row    += 6;
-        before_bytes += 6;
-        prior_row    += 6;
-    }
-}
-
-inline
-void rowDefilter3ColorC8(uint8_t* input_row, uint8_t* prior_row,
-                         uint32_t row_bytes, uint8_t* recon_row) {
-    uint32_t value0, value1, value2, value3, value4, value5, value6, value7;
-    value0 = input_row[0];
-    value1 = input_row[1];
-    value2 = input_row[2];
-    value3 = input_row[3];
-    value4 = input_row[4];
-    value5 = input_row[5];
-    value6 = input_row[6];
-    value7 = input_row[7];
-    recon_row[0] = value4 + (prior_row[0] >> 1);
-    recon_row[1] = value5 + (prior_row[1] >> 1);
-    recon_row[2] = value2 + (prior_row[2] >> 1);
-    recon_row[3] = value3 + (prior_row[3] >> 1);
-    recon_row[4] = value0 + (prior_row[4] >> 1);
-    recon_row[5] = value1 + (prior_row[5] >> 1);
-    recon_row[6] = value6 + (prior_row[6] >> 1);
-    recon_row[7] = value7 + (prior_row[7] >> 1);
-
-    uint8_t* input_end = input_row + row_bytes;
-    uint8_t* before_bytes = recon_row;
-    input_row += 8;
-    prior_row += 8;
-    recon_row += 8;
-    while (input_row < input_end) {
-        value0 = input_row[0];
-        value1 = input_row[1];
-        value2 = input_row[2];
-        value3 = input_row[3];
-        value4 = input_row[4];
-        value5 = input_row[5];
-        value6 = input_row[6];
-        value7 = input_row[7];
-        recon_row[0] = value4 + ((before_bytes[0] + prior_row[0]) >> 1);
-        recon_row[1] = value5 + ((before_bytes[1] + prior_row[1]) >> 1);
-        recon_row[2] = value2 + ((before_bytes[2] + prior_row[2]) >> 1);
-        recon_row[3] = value3 + ((before_bytes[3] + prior_row[3]) >> 1);
-        recon_row[4] = value0 + ((before_bytes[4] + prior_row[4]) >> 1);
-        recon_row[5] = value1 + ((before_bytes[5] + prior_row[5]) >> 1);
-        recon_row[6] = value6 + ((before_bytes[6] + prior_row[6]) >> 1);
-        recon_row[7] = value7 + ((before_bytes[7] + prior_row[7]) >> 1);
-        recon_row    += 8;
-        input_row    += 8;
-        before_bytes += 8;
-        prior_row    += 8;
-    }
-}
-
 inline
 __m128i caculatePaeth(__m128i a4_i16, __m128i b4_i16, __m128i c4_i16,
                       __m128i input) {
@@ -3069,8 +3154,11 @@ void rowDefilter4ColorC3(uint8_t* input_row, uint8_t* prior_row,
         }
         else {
             uint32_t value0, value1, value2;
-            uint8_t* before_bytes = recon_row - 3;
-            uint8_t* prior_before = prior_row - 3;
+            // a row without a pixel on the left of its tail starts with zeros.
+            uint8_t zero_pixel[4] = {0, 0, 0, 0};
+            bool row_start = (input_row + row_bytes == input_end);
+            uint8_t* before_bytes = row_start ? zero_pixel : recon_row - 3;
+            uint8_t* prior_before = row_start ? zero_pixel : prior_row - 3;
             while (input_row < input_end) {
                 value0 = input_row[0];
                 value1 = input_row[1];
@@ -3083,9 +3171,9 @@ void rowDefilter4ColorC3(uint8_t* input_row, uint8_t* prior_row,
                                prior_row[2], prior_before[2]);
                 recon_row    += 3;
                 input_row    += 3;
-                before_bytes += 3;
+                before_bytes = recon_row - 3;
                 prior_row    += 3;
-                prior_before += 3;
+                prior_before = prior_row - 3;
             }
         }
     }
@@ -3215,8 +3303,11 @@ void rowDefilter4ColorC4(uint8_t* input_row, uint8_t* prior_row,
         }
         else {
             uint32_t value0, value1, value2, value3;
-            uint8_t* before_bytes = recon_row - 4;
-            uint8_t* prior_before = prior_row - 4;
+            // a row without a pixel on the left of its tail starts with zeros.
+            uint8_t zero_pixel[4] = {0, 0, 0, 0};
+            bool row_start = (input_row + row_bytes == input_end);
+            uint8_t* before_bytes = row_start ? zero_pixel : recon_row - 4;
+            uint8_t* prior_before = row_start ? zero_pixel : prior_row - 4;
             while (input_row < input_end) {
                 value0 = input_row[0];
                 value1 = input_row[1];
@@ -3232,127 +3323,24 @@ void rowDefilter4ColorC4(uint8_t* input_row, uint8_t* prior_row,
                                prior_row[3], prior_before[3]);
                 recon_row    += 4;
                 input_row    += 4;
-                before_bytes += 4;
+                before_bytes = recon_row - 4;
                 prior_row    += 4;
-                prior_before += 4;
+                prior_before = prior_row - 4;
             }
         }
     }
 }
 
-inline
-void rowDefilter4ColorC6(uint8_t* input_row, uint8_t* prior_row,
-                         uint32_t row_bytes, uint8_t* recon_row) {
-    uint32_t value0, value1, value2, value3, value4, value5;
-    value0 = input_row[0];
-    value1 = input_row[1];
-    value2 = input_row[2];
-    value3 = input_row[3];
-    value4 = input_row[4];
-    value5 = input_row[5];
-    recon_row[0] = value4 + prior_row[0];
-    recon_row[1] = value5 + prior_row[1];
-    recon_row[2] = value2 + prior_row[2];
-    recon_row[3] = value3 + prior_row[3];
-    recon_row[4] = value0 + prior_row[4];
-    recon_row[5] = value1 + prior_row[5];
-
-    uint8_t* input_end = input_row + row_bytes;
-    uint8_t* before_bytes = recon_row;
-    uint8_t* prior_before = prior_row;
-    input_row += 6;
-    prior_row += 6;
-    recon_row += 6;
-    while (input_row < input_end) {
-        value0 = input_row[0];
-        value1 = input_row[1];
-        value2 = input_row[2];
-        value3 = input_row[3];
-        value4 = input_row[4];
-        value5 = input_row[5];
-        recon_row[0] = value4 + filterPaeth(before_bytes[0], prior_row[0],
-                                            prior_before[0]);
-        recon_row[1] = value5 + filterPaeth(before_bytes[1], prior_row[1],
-                                            prior_before[1]);
-        recon_row[2] = value2 + filterPaeth(before_bytes[2], prior_row[2],
-                                            prior_before[2]);
-        recon_row[3] = value3 + filterPaeth(before_bytes[3], prior_row[3],
-                                            prior_before[3]);
-        recon_row[4] = value0 + filterPaeth(before_bytes[4], prior_row[4],
-                                            prior_before[4]);
-        recon_row[5] = value1 + filterPaeth(before_bytes[5], prior_row[5],
-                                            prior_before[5]);
-        recon_row    += 6;
-        input_row    += 6;
-        before_bytes += 6;
-        prior_row    += 6;
-        prior_before += 6;
-    }
-}
-
-inline
-void rowDefilter4ColorC8(uint8_t* input_row, uint8_t* prior_row,
-                         uint32_t row_bytes, uint8_t* recon_row) {
-    uint32_t value0, value1, value2, value3, value4, value5, value6, value7;
-    value0 = input_row[0];
-    value1 = input_row[1];
-    value2 = input_row[2];
-    value3 = input_row[3];
-    value4 = input_row[4];
-    value5 = input_row[5];
-    value6 = input_row[6];
-    value7 = input_row[7];
-    recon_row[0] = value4 + prior_row[0];
-    recon_row[1] = value5 + prior_row[1];
-    recon_row[2] = value2 + prior_row[2];
-    recon_row[3] = value3 + prior_row[3];
-    recon_row[4] = value0 + prior_row[4];
-    recon_row[5] = value1 + prior_row[5];
-    recon_row[6] = value6 + prior_row[6];
-    recon_row[7] = value7 + prior_row[7];
-
-    uint8_t* input_end = input_row + row_bytes;
-    uint8_t* before_bytes = recon_row;
-    uint8_t* prior_before = prior_row;
-    input_row += 8;
-    prior_row += 8;
-    recon_row += 8;
-    while (input_row < input_end) {
-        value0 = input_row[0];
-        value1 = input_row[1];
-        value2 = input_row[2];
-        value3 = input_row[3];
-        value4 = input_row[4];
-        value5 = input_row[5];
-        value6 = input_row[6];
-        value7 = input_row[7];
-        recon_row[0] = value4 + filterPaeth(before_bytes[0], prior_row[0],
-                                            prior_before[0]);
-        recon_row[1] = value5 + filterPaeth(before_bytes[1], prior_row[1],
-                                            prior_before[1]);
-        recon_row[2] = value2 + filterPaeth(before_bytes[2], prior_row[2],
-                                            prior_before[2]);
-        recon_row[3] = value3 + filterPaeth(before_bytes[3], prior_row[3],
-                                            prior_before[3]);
-        recon_row[4] = value0 + filterPaeth(before_bytes[4], prior_row[4],
-                                            prior_before[4]);
-        recon_row[5] = value1 + filterPaeth(before_bytes[5], prior_row[5],
-                                            prior_before[5]);
-        recon_row[6] = value6 + filterPaeth(before_bytes[6], prior_row[6],
-                                            prior_before[6]);
-        recon_row[7] = value7 + filterPaeth(before_bytes[7], prior_row[7],
-                                            prior_before[7]);
-        recon_row    += 8;
-        input_row    += 8;
-        before_bytes += 8;
-        prior_row    += 8;
-        prior_before += 8;
-    }
-}
-
 static
 bool deFilterC3TureColor(uint8_t* input, uint32_t height, uint32_t row_bytes,
                          uint32_t stride, uint8_t* recon_row) {
+    /* the 16-byte loads and stores of a row tail may run past the row end,
+     * which is only allowed when they stay in the input buffer and can't reach
+     * the input of the next row.
+     */
+    uint8_t* input_end = input + (row_bytes + 1) * height;
+    bool exact_tail;
+
     // process the first row.
     uint8_t filter_type = *input++;
     if (filter_type > 4) {
@@ -3361,25 +3349,28 @@ bool deFilterC3TureColor(uint8_t* input, uint32_t height, uint32_t row_bytes,
                    << "Paeth(4)";
         return false;
     }
+    exact_tail = (input - recon_row < 16 ||
+                  input_end - input < row_bytes + 16);
     switch (filter_type) {
         case FILTER_NONE:
-            rowDefilter0ColorC3(input, row_bytes, recon_row, false);
+            rowDefilter0ColorC3(input, row_bytes, recon_row, exact_tail);
             break;
         case FILTER_SUB:
-            rowDefilter1ColorC3(input, row_bytes, recon_row, false);
+            rowDefilter1ColorC3(input, row_bytes, recon_row, exact_tail);
             break;
         case FILTER_UP:
-            rowDefilter0ColorC3(input, row_bytes, recon_row, false);
+            rowDefilter0ColorC3(input, row_bytes, recon_row, exact_tail);
             break;
-        case FILTER_PAETH:
+        case FILTER_AVERAGE:
             row0Defilter3ColorC3(input, row_bytes, recon_row);
             break;
-        case FILTER_AVERAGE:
-            rowDefilter1ColorC3(input, row_bytes, recon_row, false);
+        case FILTER_PAETH:
+            rowDefilter1ColorC3(input, row_bytes, recon_row, exact_tail);
             break;
     }
     input += row_bytes;
     recon_row += stride;
+    if (height == 1) return true;
 
     // process the most rows.
     uint8_t *prior_row;
@@ -3392,24 +3383,26 @@ bool deFilterC3TureColor(uint8_t* input, uint32_t height, uint32_t row_bytes,
                        << "Average(3)/Paeth(4)";
             return false;
         }
+        exact_tail = (input - recon_row < 16 ||
+                      input_end - input < row_bytes + 16);
         switch (filter_type) {
             case FILTER_NONE:
-                rowDefilter0ColorC3(input, row_bytes, recon_row, false);
+                rowDefilter0ColorC3(input, row_bytes, recon_row, exact_tail);
                 break;
             case FILTER_SUB:
-                rowDefilter1ColorC3(input, row_bytes, recon_row, false);
+                rowDefilter1ColorC3(input, row_bytes, recon_row, exact_tail);
                 break;
             case FILTER_UP:
                 rowDefilter2ColorC3(input, prior_row, row_bytes, recon_row,
-                                    false);
+                                    exact_tail);
                 break;
             case FILTER_AVERAGE:
                 rowDefilter3ColorC3(input, prior_row, row_bytes, recon_row,
-                                    false);
+                                    exact_tail);
                 break;
             case FILTER_PAETH:
                 rowDefilter4ColorC3(input, prior_row, row_bytes, recon_row,
-                                    false);
+                                    exact_tail);
                 break;
         }
         input += row_bytes;
@@ -3449,6 +3442,13 @@ bool deFilterC3TureColor(uint8_t* input, uint32_t height, uint32_t row_bytes,
 static
 bool deFilterC4TureColor(uint8_t* input, uint32_t height, uint32_t row_bytes,
                          uint32_t stride, uint8_t* recon_row) {
+    /* the 16-byte loads and stores of a row tail may run past the row end,
+     * which is only allowed when they stay in the input buffer and can't reach
+     * the input of the next row.
+     */
+    uint8_t* input_end = input + (row_bytes + 1) * height;
+    bool exact_tail;
+
     // process the first row.
     uint8_t filter_type = *input++;
     if (filter_type > 4) {
@@ -3457,25 +3457,28 @@ bool deFilterC4TureColor(uint8_t* input, uint32_t height, uint32_t row_bytes,
                    << "Paeth(4)";
         return false;
     }
+    exact_tail = (input - recon_row < 16 ||
+                  input_end - input < row_bytes + 16);
     switch (filter_type) {
         case FILTER_NONE:
-            rowDefilter0ColorC4(input, row_bytes, recon_row, false);
+            rowDefilter0ColorC4(input, row_bytes, recon_row, exact_tail);
             break;
         case FILTER_SUB:
-            rowDefilter1ColorC4(input, row_bytes, recon_row, false);
+            rowDefilter1ColorC4(input, row_bytes, recon_row, exact_tail);
             break;
         case FILTER_UP:
-            rowDefilter0ColorC4(input, row_bytes, recon_row, false);
+            rowDefilter0ColorC4(input, row_bytes, recon_row, exact_tail);
             break;
         case FILTER_AVERAGE:
             row0Defilter3ColorC4(input, row_bytes, recon_row);
             break;
         case FILTER_PAETH:
-            rowDefilter1ColorC4(input, row_bytes, recon_row, false);
+            rowDefilter1ColorC4(input, row_bytes, recon_row, exact_tail);
             break;
     }
     input += row_bytes;
     recon_row += stride;
+    if (height == 1) return true;
 
     // process the most rows.
     uint8_t *prior_row;
@@ -3488,24 +3491,26 @@ bool deFilterC4TureColor(uint8_t* input, uint32_t height, uint32_t row_bytes,
                        << "Average(3)/Paeth(4)";
             return false;
         }
+        exact_tail = (input - recon_row < 16 ||
+                      input_end - input < row_bytes + 16);
         switch (filter_type) {
             case FILTER_NONE:
-                rowDefilter0ColorC4(input, row_bytes, recon_row, false);
+                rowDefilter0ColorC4(input, row_bytes, recon_row, exact_tail);
                 break;
             case FILTER_SUB:
-                rowDefilter1ColorC4(input, row_bytes, recon_row, false);
+                rowDefilter1ColorC4(input, row_bytes, recon_row, exact_tail);
                 break;
             case FILTER_UP:
                 rowDefilter2ColorC4(input, prior_row, row_bytes, recon_row,
-                                    false);
+                                    exact_tail);
                 break;
             case FILTER_AVERAGE:
                 rowDefilter3ColorC4(input, prior_row, row_bytes, recon_row,
-                                    false);
+                                    exact_tail);
                 break;
             case FILTER_PAETH:
                 rowDefilter4ColorC4(input, prior_row, row_bytes, recon_row,
-                                    false);
+                                    exact_tail);
                 break;
         }
         input += row_bytes;
@@ -3594,10 +3599,12 @@ bool deFilterC6TureColor(uint8_t* input, uint32_t height, uint32_t row_bytes,
                 rowDefilter2ColorC6(input, prior_row, row_bytes, recon_row);
                 break;
             case FILTER_AVERAGE:
-                rowDefilter3ColorC6(input, prior_row, row_bytes, recon_row);
+                rowDefilter3Simd<6, true>(input, prior_row, row_bytes,
+                                          recon_row);
                 break;
             case FILTER_PAETH:
-                rowDefilter4ColorC6(input, prior_row, row_bytes, recon_row);
+                rowDefilter4Simd<6, true>(input, prior_row, row_bytes,
+                                          recon_row);
                 break;
         }
         input += row_bytes;
@@ -3659,10 +3666,12 @@ bool deFilterC8TureColor(uint8_t* input, uint32_t height, uint32_t row_bytes,
                 rowDefilter2ColorC8(input, prior_row, row_bytes, recon_row);
                 break;
             case FILTER_AVERAGE:
-                rowDefilter3ColorC8(input, prior_row, row_bytes, recon_row);
+                rowDefilter3Simd<8, true>(input, prior_row, row_bytes,
+                                          recon_row);
                 break;
             case FILTER_PAETH:
-                rowDefilter4ColorC8(input, prior_row, row_bytes, recon_row);
+                rowDefilter4Simd<8, true>(input, prior_row, row_bytes,
+                                          recon_row);
                 break;
         }
         input += row_bytes;
@@ -3712,9 +3721,10 @@ bool PngDecoder::deFilterImageTrueColor(PngInfo& png_info, uint8_t* image,
         uint8_t value0, value1;
         recon_row = image + stride_offset;
         uint16_t *current_row16;
+        uint32_t samples = width_ * encoded_channels_;
         for (uint32_t row = 0; row < height_; row++) {
             current_row16 = (uint16_t*)recon_row;
-            for (uint32_t col = 0, col1 = 0; col < width_; col++, col1 += 2) {
+            for (uint32_t col = 0, col1 = 0; col < samples; col++, col1 += 2) {
                 value0 = recon_row[col1];
                 value1 = recon_row[col1 + 1];
                 current_row16[col] = (value0 << 8) | value1;
@@ -3786,6 +3796,7 @@ bool PngDecoder::computeTransparency(PngInfo& png_info, uint8_t* image,
         uint16_t* output_row = (uint16_t*)image;
         uint16_t* alpha_values = (uint16_t*)png_info.alpha_values;
         uint16_t value0, value1, value2, value3;
+        uint32_t stride16 = stride >> 1;
 
         if (color_type_ == GRAY) {
             for (uint32_t row = 0; row < height_; row++) {
@@ -3796,8 +3807,8 @@ bool PngDecoder::computeTransparency(PngInfo& png_info, uint8_t* image,
                      output_row[col1 + 1] = value1;
                      col1 += 2;
                 }
-                input_row  += stride;
-                output_row += stride;
+                input_row  += stride16;
+                output_row += stride16;
             }
         }
         else if (color_type_ == TRUE_COLOR) {
@@ -3821,8 +3832,8 @@ bool PngDecoder::computeTransparency(PngInfo& png_info, uint8_t* image,
                      output_row[col1 + 3] = value3;
                      col1 += 4;
                 }
-                input_row  += stride;
-                output_row += stride;
+                input_row  += stride16;
+                output_row += stride16;
             }
         }
         else {
@@ -4004,6 +4015,7 @@ bool PngDecoder::decodeData(uint32_t stride, uint8_t* image) {
     png_info_.decompressed_image = png_info_.decompressed_image_start;
     png_info_.zlib_buffer.bit_number = 0;
     png_info_.zlib_buffer.code_buffer = 0;
+    png_info_.zlib_buffer.is_final_block = false;
 
     bool succeeded;
     while (png_info_.current_chunk.type != png_IEND) {
@@ -20,6 +20,8 @@
 
 #include "imagecodecs.h"
 #include "bytesreader.h"
+#include "byteswriter.h"
+#include "decoderscratch.h"
 #include "crc32.h"
 
 #include <string>
@@ -29,10 +31,33 @@ namespace cv {
 namespace x86 {
 
 #define PNG_SHIFT_SIZE 56
-#define ZLIB_FAST_BITS 9
+#define ZLIB_FAST_BITS 11
 #define ZLIB_FAST_MASK ((1 << ZLIB_FAST_BITS) - 1)
 #define SYMBOL_NUMBER 288
 
+#define MAKE_CHUNK_TYPE(s0, s1, s2, s3) (((uint32_t)(s0) << 24) | \
+                                         ((uint32_t)(s1) << 16) | \
+                                         ((uint32_t)(s2) << 8)  | \
+                                         ((uint32_t)(s3)))
+#define png_IHDR MAKE_CHUNK_TYPE( 73,  72,  68,  82)
+#define png_PLTE MAKE_CHUNK_TYPE( 80,  76,  84,  69)
+#define png_IDAT MAKE_CHUNK_TYPE( 73,  68,  65,  84)
+#define png_IEND MAKE_CHUNK_TYPE( 73,  69,  78,  68)
+#define png_tRNS MAKE_CHUNK_TYPE(116,  82,  78,  83)
+#define png_cHRM MAKE_CHUNK_TYPE( 99,  72,  82,  77)
+#define png_gAMA MAKE_CHUNK_TYPE(103,  65,  77,  65)
+#define png_iCCP MAKE_CHUNK_TYPE(105,  67,  67,  80)
+#define png_sBIT MAKE_CHUNK_TYPE(115,  66,  73,  84)
+#define png_sRGB MAKE_CHUNK_TYPE(115,  82,  71,  66)
+#define png_tEXt MAKE_CHUNK_TYPE(116,  69,  88, 116)
+#define png_zTXt MAKE_CHUNK_TYPE(122,  84,  88, 116)
+#define png_iTXt MAKE_CHUNK_TYPE(105,  84,  88, 116)
+#define png_bKGD MAKE_CHUNK_TYPE( 98,  75,  71,  68)
+#define png_hIST MAKE_CHUNK_TYPE(104,  73,  83,  84)
+#define png_pHYs MAKE_CHUNK_TYPE(112,  72,  89, 115)
+#define png_sPLT MAKE_CHUNK_TYPE(115,  80,  76,  84)
+#define png_tIME MAKE_CHUNK_TYPE(116,  73,  77,  69)
+
 enum ColorTypes {
     GRAY = 0,
     TRUE_COLOR = 2,
@@ -41,6 +66,14 @@ enum ColorTypes {
     TRUE_COLOR_WITH_ALPHA = 6,
 };
 
+enum FilterTypes {
+    FILTER_NONE    = 0,
+    FILTER_SUB     = 1,
+    FILTER_UP      = 2,
+    FILTER_AVERAGE = 3,
+    FILTER_PAETH   = 4,
+};
+
 enum CompressionMethods {
     DEFLATE = 0,
 };
@@ -70,9 +103,13 @@ struct PngTime {
    uint8_t second;  // second of minute, 0 - 60 (for leap seconds)
 };
 
-// zlib-style huffman encoding, jpegs packs from left, zlib from right
+// zlib-style huffman encoding, jpegs packs from left, zlib from right.
+// An entry of the fast table holds the size of the first code in bit 0-3,
+// the size of all codes in bit 4-7, a literal pair flag in bit 8, the first
+// symbol in bit 9-17 and the second literal in bit 18-25. 0 means the code is
+// longer than ZLIB_FAST_BITS.
 struct ZlibHuffman {
-   uint16_t fast[1 << ZLIB_FAST_BITS];
+   uint32_t fast[1 << ZLIB_FAST_BITS];
    uint16_t first_code[16];
    uint16_t first_symbol[16];
    int32_t max_code[17];
@@ -113,11 +150,13 @@ struct PngInfo {
 
 class PngDecoder : public ImageDecoder {
   public:
-    PngDecoder(BytesReader& file_data);
+    PngDecoder(BytesReader& file_data, DecoderScratch& scratch);
     ~PngDecoder();
 
     bool readHeader() override;
     bool decodeData(uint32_t stride, uint8_t* image) override;
+    // chunk crcs are verified unless turned off before readHeader().
+    void setCrcChecking(bool checking);
 
   private:
     void getChunkHeader(PngInfo& png_info);
@@ -158,6 +197,10 @@ class PngDecoder : public ImageDecoder {
     int32_t huffmanDecode(ZlibBuffer *zlib_buffer,
                           ZlibHuffman *huffman_coding);
     bool computeDynamicHuffman(ZlibBuffer *zlib_buffer);
+    void takeInput(const uint8_t* &input, const uint8_t* &input_end);
+    void returnInput(const uint8_t* input);
+    bool refillBits(ZlibBuffer *zlib_buffer, const uint8_t* &input,
+                    const uint8_t* &input_end);
     bool decodeHuffmanData(ZlibBuffer *zlib_buffer);
     bool inflateImage(PngInfo& png_info, uint8_t* image, uint32_t stride);
     bool deFilterImage(PngInfo& png_info, uint8_t* image, uint32_t stride);
@@ -169,6 +212,7 @@ class PngDecoder : public ImageDecoder {
 
   private:
     BytesReader* file_data_;
+    DecoderScratch* scratch_;
     PngInfo png_info_;
     Crc32 crc32_;
     uint8_t bit_depth_;
@@ -179,6 +223,29 @@ class PngDecoder : public ImageDecoder {
     uint32_t encoded_channels_;
 };
 
+/* Writes 8-bit gray, RGB and RGBA images, see pngencoder.cpp. The filtered
+ * rows go through a ZlibEncoder, each compressed block becomes an IDAT chunk.
+ */
+class PngEncoder : public ImageEncoder {
+  public:
+    PngEncoder(BytesWriter& file_data, int32_t level, int32_t strategy);
+    ~PngEncoder();
+
+    bool isChannelsSupported(uint32_t channels) const override;
+    bool encodeData(uint32_t height, uint32_t width, uint32_t channels,
+                    uint32_t stride, const uint8_t* image) override;
+
+  private:
+    void putChunk(uint32_t type, uint32_t length);
+
+  private:
+    BytesWriter* file_data_;
+    int32_t level_;
+    int32_t strategy_;
+    Crc32 crc32_;
+    uint8_t* chunk_;
+};
+
 } //! namespace x86
 } //! namespace cv
 } //! namespace ppl
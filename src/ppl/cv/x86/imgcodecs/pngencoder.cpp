@@ -0,0 +1,319 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "png.h"
+#include "deflate.h"
+#include "codecs.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <immintrin.h>
+
+#include "ppl/common/log.h"
+
+namespace ppl {
+namespace cv {
+namespace x86 {
+
+#define ROW_PADDING 16
+#define ADAPTIVE_FILTER 5
+
+/* The filter of the rows at each level. Level 0 leaves the rows as they are
+ * for the stored blocks, level 1 takes the Sub filter, whose runs of zeros in
+ * flat areas are what the run-only parsing catches. The other levels choose
+ * the filter of each row by the smallest sum of the absolute differences,
+ * as libpng does.
+ */
+static const uint8_t level_filters[10] = {
+    FILTER_NONE, FILTER_SUB, ADAPTIVE_FILTER, ADAPTIVE_FILTER,
+    ADAPTIVE_FILTER, ADAPTIVE_FILTER, ADAPTIVE_FILTER, ADAPTIVE_FILTER,
+    ADAPTIVE_FILTER, ADAPTIVE_FILTER,
+};
+
+static inline void putDWordBigEndian(uint8_t* data, uint32_t value) {
+    data[0] = (uint8_t)(value >> 24);
+    data[1] = (uint8_t)(value >> 16);
+    data[2] = (uint8_t)(value >> 8);
+    data[3] = (uint8_t)value;
+}
+
+// B G R (A) to R G B (A), 5 or 4 pixels a step.
+static void swapRedBlue(const uint8_t* src, uint32_t width, uint32_t channels,
+                        uint8_t* dst) {
+    uint32_t bytes = width * channels;
+    uint32_t i = 0;
+    if (channels == 3) {
+        __m128i mask = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14,
+                                     13, 12, 15);
+        for (; i + 16 <= bytes; i += 15) {
+            __m128i pixels = _mm_loadu_si128((const __m128i*)(src + i));
+            _mm_storeu_si128((__m128i*)(dst + i),
+                             _mm_shuffle_epi8(pixels, mask));
+        }
+    }
+    else {
+        __m128i mask = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14,
+                                     13, 12, 15);
+        for (; i + 16 <= bytes; i += 16) {
+            __m128i pixels = _mm_loadu_si128((const __m128i*)(src + i));
+            _mm_storeu_si128((__m128i*)(dst + i),
+                             _mm_shuffle_epi8(pixels, mask));
+        }
+    }
+    for (; i < bytes; i += channels) {
+        dst[i]     = src[i + 2];
+        dst[i + 1] = src[i + 1];
+        dst[i + 2] = src[i];
+        if (channels == 4) {
+            dst[i + 3] = src[i + 3];
+        }
+    }
+}
+
+/* The filters run over the padded rows, the bytes in front of a row are 0,
+ * and write up to 15 bytes behind the filtered row.
+ */
+static void filterSub(const uint8_t* row, uint32_t bytes, uint32_t pixel_bytes,
+                      uint8_t* dst) {
+    for (uint32_t i = 0; i < bytes; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(row + i));
+        __m128i a = _mm_loadu_si128((const __m128i*)(row + i - pixel_bytes));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_sub_epi8(x, a));
+    }
+}
+
+static void filterUp(const uint8_t* row, const uint8_t* prior, uint32_t bytes,
+                     uint8_t* dst) {
+    for (uint32_t i = 0; i < bytes; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(row + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(prior + i));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_sub_epi8(x, b));
+    }
+}
+
+// the rounded average of _mm_avg_epu8() less the carried lowest bit.
+static void filterAverage(const uint8_t* row, const uint8_t* prior,
+                          uint32_t bytes, uint32_t pixel_bytes, uint8_t* dst) {
+    __m128i one = _mm_set1_epi8(1);
+    for (uint32_t i = 0; i < bytes; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(row + i));
+        __m128i a = _mm_loadu_si128((const __m128i*)(row + i - pixel_bytes));
+        __m128i b = _mm_loadu_si128((const __m128i*)(prior + i));
+        __m128i average = _mm_avg_epu8(a, b);
+        average = _mm_sub_epi8(average,
+                               _mm_and_si128(_mm_xor_si128(a, b), one));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_sub_epi8(x, average));
+    }
+}
+
+// pa = |b - c|, pb = |a - c|, pc = |a + b - 2c|, ties go to a, then b.
+static inline __m128i predictPaeth(__m128i a, __m128i b, __m128i c) {
+    __m128i b_c = _mm_sub_epi16(b, c);
+    __m128i a_c = _mm_sub_epi16(a, c);
+    __m128i pa = _mm_abs_epi16(b_c);
+    __m128i pb = _mm_abs_epi16(a_c);
+    __m128i pc = _mm_abs_epi16(_mm_add_epi16(b_c, a_c));
+    __m128i smallest = _mm_min_epi16(pa, _mm_min_epi16(pb, pc));
+    __m128i prediction = _mm_blendv_epi8(c, b, _mm_cmpeq_epi16(pb, smallest));
+
+    return _mm_blendv_epi8(prediction, a, _mm_cmpeq_epi16(pa, smallest));
+}
+
+static void filterPaeth(const uint8_t* row, const uint8_t* prior,
+                        uint32_t bytes, uint32_t pixel_bytes, uint8_t* dst) {
+    __m128i zero = _mm_setzero_si128();
+    for (uint32_t i = 0; i < bytes; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(row + i));
+        __m128i a = _mm_loadu_si128((const __m128i*)(row + i - pixel_bytes));
+        __m128i b = _mm_loadu_si128((const __m128i*)(prior + i));
+        __m128i c = _mm_loadu_si128((const __m128i*)(prior + i - pixel_bytes));
+        __m128i low = predictPaeth(_mm_unpacklo_epi8(a, zero),
+                                   _mm_unpacklo_epi8(b, zero),
+                                   _mm_unpacklo_epi8(c, zero));
+        __m128i high = predictPaeth(_mm_unpackhi_epi8(a, zero),
+                                    _mm_unpackhi_epi8(b, zero),
+                                    _mm_unpackhi_epi8(c, zero));
+        __m128i prediction = _mm_packus_epi16(low, high);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_sub_epi8(x, prediction));
+    }
+}
+
+// sum of the filtered bytes taken as signed differences.
+static uint64_t sumAbsolute(const uint8_t* data, uint32_t bytes) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i sums = zero;
+    uint32_t i = 0;
+    for (; i + 16 <= bytes; i += 16) {
+        __m128i x = _mm_abs_epi8(_mm_loadu_si128((const __m128i*)(data + i)));
+        sums = _mm_add_epi64(sums, _mm_sad_epu8(x, zero));
+    }
+    sums = _mm_add_epi64(sums, _mm_srli_si128(sums, 8));
+    uint64_t sum = (uint64_t)_mm_cvtsi128_si64(sums);
+    for (; i < bytes; i++) {
+        int32_t value = (int8_t)data[i];
+        sum += value < 0 ? -value : value;
+    }
+
+    return sum;
+}
+
+static void filterRow(uint32_t filter, const uint8_t* row, const uint8_t* prior,
+                      uint32_t bytes, uint32_t pixel_bytes, uint8_t* dst) {
+    dst[0] = (uint8_t)filter;
+    switch (filter) {
+        case FILTER_NONE:
+            memcpy(dst + 1, row, bytes);
+            break;
+        case FILTER_SUB:
+            filterSub(row, bytes, pixel_bytes, dst + 1);
+            break;
+        case FILTER_UP:
+            filterUp(row, prior, bytes, dst + 1);
+            break;
+        case FILTER_AVERAGE:
+            filterAverage(row, prior, bytes, pixel_bytes, dst + 1);
+            break;
+        default:  // FILTER_PAETH
+            filterPaeth(row, prior, bytes, pixel_bytes, dst + 1);
+            break;
+    }
+}
+
+PngEncoder::PngEncoder(BytesWriter& file_data, int32_t level,
+                       int32_t strategy) {
+    file_data_ = &file_data;
+    level_ = level;
+    strategy_ = strategy;
+    chunk_ = nullptr;
+}
+
+PngEncoder::~PngEncoder() {
+    free(chunk_);
+}
+
+bool PngEncoder::isChannelsSupported(uint32_t channels) const {
+    return channels == 1 || channels == 3 || channels == 4;
+}
+
+// the chunk data is put at chunk_ + 8 behind the room of its length and type.
+void PngEncoder::putChunk(uint32_t type, uint32_t length) {
+    putDWordBigEndian(chunk_, length);
+    putDWordBigEndian(chunk_ + 4, type);
+    crc32_.setCrc(chunk_ + 4, length + 4, 0, length + 4);
+    crc32_.calculateCrc();
+    putDWordBigEndian(chunk_ + 8 + length, crc32_.getCrcValue());
+    file_data_->putBytes(chunk_, length + 12);
+}
+
+/* The rows are converted to R G B (A) and filtered one by one into the
+ * window of the zlib encoder, a full block is compressed into an IDAT chunk
+ * at once, so nothing larger than a block is kept in memory.
+ */
+bool PngEncoder::encodeData(uint32_t height, uint32_t width, uint32_t channels,
+                            uint32_t stride, const uint8_t* image) {
+    ZlibEncoder zlib_encoder(level_, strategy_);
+    if (!zlib_encoder.initialize()) {
+        return false;
+    }
+
+    uint32_t row_bytes = width * channels;
+    uint32_t row_size = ROW_PADDING + row_bytes + ROW_PADDING;
+    uint32_t filtered_size = 1 + row_bytes + ROW_PADDING;
+    uint32_t filter = level_filters[level_ < 0 ? 0 : level_ > 9 ? 9 : level_];
+    uint32_t filtered_rows = filter == ADAPTIVE_FILTER ? 5 : 1;
+    size_t chunk_size = zlib_encoder.maxOutputSize() + 12;
+    chunk_ = (uint8_t*)malloc(chunk_size);
+    uint8_t* buffer = (uint8_t*)malloc(row_size * 2 +
+                                       filtered_size * filtered_rows);
+    if (chunk_ == nullptr || buffer == nullptr) {
+        LOG(ERROR) << "failed to allocate the buffers of the png encoder.";
+        free(buffer);
+        return false;
+    }
+    memset(buffer, 0, row_size * 2 + filtered_size * filtered_rows);
+    uint8_t* rows[2] = {buffer + ROW_PADDING,
+                        buffer + row_size + ROW_PADDING};
+    uint8_t* filtered = buffer + row_size * 2;
+
+    const uint8_t signature[8] = {0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A,
+                                  0x0A};
+    file_data_->putBytes(signature, 8);
+
+    uint8_t* header = chunk_ + 8;
+    putDWordBigEndian(header, width);
+    putDWordBigEndian(header + 4, height);
+    header[8]  = 8;
+    header[9]  = channels == 1 ? GRAY : channels == 3 ? TRUE_COLOR :
+                 TRUE_COLOR_WITH_ALPHA;
+    header[10] = DEFLATE;
+    header[11] = ADAPTIVE;
+    header[12] = NO_INTRLACE;
+    putChunk(png_IHDR, 13);
+
+    uint32_t pixel_bytes = channels;
+    for (uint32_t row = 0; row < height; row++) {
+        uint8_t* current = rows[row & 1];
+        const uint8_t* prior = rows[(row + 1) & 1];
+        const uint8_t* src = image + (size_t)row * stride;
+        if (channels == 1) {
+            memcpy(current, src, row_bytes);
+        }
+        else {
+            swapRedBlue(src, width, channels, current);
+        }
+
+        const uint8_t* filtered_row = filtered;
+        if (filter == ADAPTIVE_FILTER) {
+            uint64_t smallest_sum = UINT64_MAX;
+            for (uint32_t i = FILTER_NONE; i <= FILTER_PAETH; i++) {
+                uint8_t* dst = filtered + i * filtered_size;
+                filterRow(i, current, prior, row_bytes, pixel_bytes, dst);
+                uint64_t sum = sumAbsolute(dst + 1, row_bytes);
+                if (sum < smallest_sum) {
+                    smallest_sum = sum;
+                    filtered_row = dst;
+                }
+            }
+        }
+        else {
+            filterRow(filter, current, prior, row_bytes, pixel_bytes,
+                      filtered);
+        }
+
+        uint32_t remaining = 1 + row_bytes;
+        while (remaining > 0) {
+            uint32_t count = zlib_encoder.write(filtered_row, remaining);
+            filtered_row += count;
+            remaining -= count;
+            if (zlib_encoder.isBlockFull()) {
+                size_t size = zlib_encoder.compressBlock(false, chunk_ + 8);
+                putChunk(png_IDAT, size);
+            }
+        }
+    }
+    free(buffer);
+
+    size_t size = zlib_encoder.compressBlock(true, chunk_ + 8);
+    putChunk(png_IDAT, size);
+    putChunk(png_IEND, 0);
+
+    return file_data_->isGood();
+}
+
+} //! namespace x86
+} //! namespace cv
+} //! namespace ppl
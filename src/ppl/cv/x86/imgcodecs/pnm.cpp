@@ -0,0 +1,245 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "pnm.h"
+#include "codecs.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <immintrin.h>
+
+#include "ppl/common/log.h"
+
+namespace ppl {
+namespace cv {
+namespace x86 {
+
+/* R G B <-> B G R of 8 bit samples, dst may be src. 5 pixels are shuffled at
+ * a time, the 16th byte of the store is the unchanged one the next load
+ * starts with.
+ */
+static void swapRedBlue(const uint8_t* src, uint8_t* dst, uint32_t pixels) {
+    __m128i order = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13,
+                                  12, 15);
+    uint32_t i = 0;
+    for (; i + 6 <= pixels; i += 5) {
+        __m128i value = _mm_loadu_si128((const __m128i*)(src + i * 3));
+        _mm_storeu_si128((__m128i*)(dst + i * 3),
+                         _mm_shuffle_epi8(value, order));
+    }
+    for (; i < pixels; i++) {
+        uint8_t value = src[i * 3];
+        dst[i * 3] = src[i * 3 + 2];
+        dst[i * 3 + 1] = src[i * 3 + 1];
+        dst[i * 3 + 2] = value;
+    }
+}
+
+PnmDecoder::PnmDecoder(BytesReader& file_data) {
+    file_data_ = &file_data;
+    max_value_ = 0;
+}
+
+PnmDecoder::~PnmDecoder() {
+}
+
+// a decimal number behind white spaces and comments, -1 without one.
+int32_t PnmDecoder::readNumber() {
+    int32_t value = file_data_->getByte();
+    while (true) {
+        if (value == '#') {
+            while (value >= 0 && value != '\n' && value != '\r') {
+                value = file_data_->getByte();
+            }
+        }
+        else if (value == ' ' || value == '\t' || value == '\n' ||
+                 value == '\r' || value == '\v' || value == '\f') {
+            value = file_data_->getByte();
+        }
+        else {
+            break;
+        }
+    }
+    if (value < '0' || value > '9') {
+        return -1;
+    }
+
+    int64_t number = 0;
+    while (value >= '0' && value <= '9') {
+        number = number * 10 + (value - '0');
+        if (number > INT32_MAX) {
+            return -1;
+        }
+        value = file_data_->getByte();
+    }
+    // the single white space in front of the samples is consumed here.
+    if (value != ' ' && value != '\t' && value != '\n' && value != '\r' &&
+        value != '\v' && value != '\f') {
+        return -1;
+    }
+
+    return (int32_t)number;
+}
+
+bool PnmDecoder::readHeader() {
+    file_data_->getByte();
+    int32_t type = file_data_->getByte();
+    if (type != '5' && type != '6') {
+        LOG(ERROR) << "Only binary pgm(P5) and ppm(P6) are supported.";
+        return false;
+    }
+
+    int32_t width  = readNumber();
+    int32_t height = readNumber();
+    int32_t max_value = readNumber();
+    if (width <= 0 || height <= 0 ||
+        (uint64_t)width * height >= MAX_IMAGE_SIZE) {
+        LOG(ERROR) << "Invalid pnm image size: " << width << "x" << height;
+        return false;
+    }
+    if (max_value <= 0 || max_value > 65535) {
+        LOG(ERROR) << "Invalid pnm maximum value: " << max_value;
+        return false;
+    }
+
+    width_  = width;
+    height_ = height;
+    channels_ = type == '5' ? 1 : 3;
+    depth_ = max_value > 255 ? 16 : 8;
+    max_value_ = max_value;
+    if (depth_ == 8 && max_value_ != 255) {
+        for (uint32_t i = 0; i < 256; i++) {
+            scale_table_[i] = i >= max_value_ ? 255 :
+                              (uint8_t)((i * 255 + max_value_ / 2) /
+                                        max_value_);
+        }
+    }
+
+    return true;
+}
+
+// the samples of a row in the file order to those of the image.
+void PnmDecoder::convertRow(uint8_t* row) {
+    uint32_t samples = width_ * channels_;
+    if (depth_ == 8) {
+        if (max_value_ != 255) {
+            for (uint32_t i = 0; i < samples; i++) {
+                row[i] = scale_table_[row[i]];
+            }
+        }
+        if (channels_ == 3) {
+            swapRedBlue(row, row, width_);
+        }
+        return;
+    }
+
+    uint16_t* values = (uint16_t*)row;
+    for (uint32_t i = 0; i < samples; i++) {
+        uint32_t value = ((uint32_t)row[i * 2] << 8) | row[i * 2 + 1];
+        if (max_value_ != 65535) {
+            value = value >= max_value_ ? 65535 :
+                    (value * 65535 + max_value_ / 2) / max_value_;
+        }
+        values[i] = (uint16_t)value;
+    }
+    if (channels_ == 3) {
+        for (uint32_t i = 0; i < width_; i++) {
+            uint16_t value = values[i * 3];
+            values[i * 3] = values[i * 3 + 2];
+            values[i * 3 + 2] = value;
+        }
+    }
+}
+
+/* The rows are copied from the input, mapped or in memory, into the image
+ * and converted there, there is no intermediate buffer.
+ */
+bool PnmDecoder::decodeData(uint32_t stride, uint8_t* image) {
+    uint32_t row_bytes = width_ * channels_ * (depth_ / 8);
+    for (uint32_t row = 0; row < height_; row++) {
+        uint8_t* dst = image + (size_t)row * stride;
+        if (file_data_->ensureValidSize(row_bytes)) {
+            memcpy(dst, file_data_->getCurrentPosition(), row_bytes);
+            file_data_->skipBytes(row_bytes);
+        }
+        else if (file_data_->isLastBlock()) {
+            LOG(ERROR) << "The pnm data is truncated at row " << row << ".";
+            return false;
+        }
+        else {
+            // a row larger than the window of the file.
+            file_data_->getBytes(dst, row_bytes);
+        }
+        convertRow(dst);
+    }
+
+    return true;
+}
+
+PnmEncoder::PnmEncoder(BytesWriter& file_data) {
+    file_data_ = &file_data;
+}
+
+PnmEncoder::~PnmEncoder() {
+}
+
+bool PnmEncoder::isChannelsSupported(uint32_t channels) const {
+    return channels == 1 || channels == 3;
+}
+
+/* Gray images are written as P5 and color ones as P6 whatever the extension.
+ * Contiguous gray rows go out with a single write, which skips the buffer of
+ * a file writer.
+ */
+bool PnmEncoder::encodeData(uint32_t height, uint32_t width, uint32_t channels,
+                            uint32_t stride, const uint8_t* image) {
+    char header[32];
+    int length = snprintf(header, sizeof(header), "P%c\n%u %u\n255\n",
+                          channels == 1 ? '5' : '6', width, height);
+    file_data_->putBytes(header, length);
+
+    uint32_t row_bytes = width * channels;
+    if (channels == 1) {
+        if (stride == row_bytes) {
+            file_data_->putBytes(image, (int)((size_t)row_bytes * height));
+        }
+        else {
+            for (uint32_t row = 0; row < height; row++) {
+                file_data_->putBytes(image + (size_t)row * stride, row_bytes);
+            }
+        }
+        return file_data_->isGood();
+    }
+
+    uint8_t* buffer = (uint8_t*)malloc(row_bytes);
+    if (buffer == nullptr) {
+        LOG(ERROR) << "failed to allocate the row buffer of the encoder.";
+        return false;
+    }
+    for (uint32_t row = 0; row < height; row++) {
+        swapRedBlue(image + (size_t)row * stride, buffer, width);
+        file_data_->putBytes(buffer, row_bytes);
+    }
+    free(buffer);
+
+    return file_data_->isGood();
+}
+
+} //! namespace x86
+} //! namespace cv
+} //! namespace ppl
@@ -0,0 +1,69 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef __ST_HPC_PPL_CV_X86_IMGCODECS_PNM_H_
+#define __ST_HPC_PPL_CV_X86_IMGCODECS_PNM_H_
+
+#include "imagecodecs.h"
+#include "bytesreader.h"
+#include "byteswriter.h"
+
+namespace ppl {
+namespace cv {
+namespace x86 {
+
+/* Binary portable graymaps(P5) and pixmaps(P6). Samples of 8 bits are copied
+ * straight between the input and the image rows, only the R and B channels
+ * of pixmaps being swapped in place. Samples of 16 bits are big endian in
+ * the file and native in the image.
+ */
+class PnmDecoder : public ImageDecoder {
+  public:
+    PnmDecoder(BytesReader& file_data);
+    ~PnmDecoder();
+
+    bool readHeader() override;
+    bool decodeData(uint32_t stride, uint8_t* image) override;
+
+  private:
+    int32_t readNumber();
+    void convertRow(uint8_t* row);
+
+  private:
+    BytesReader* file_data_;
+    uint32_t max_value_;
+    uint8_t scale_table_[256];  // samples of max_value_ below 255 to 8 bits
+};
+
+class PnmEncoder : public ImageEncoder {
+  public:
+    PnmEncoder(BytesWriter& file_data);
+    ~PnmEncoder();
+
+    bool isChannelsSupported(uint32_t channels) const override;
+    bool encodeData(uint32_t height, uint32_t width, uint32_t channels,
+                    uint32_t stride, const uint8_t* image) override;
+
+  private:
+    BytesWriter* file_data_;
+};
+
+} //! namespace x86
+} //! namespace cv
+} //! namespace ppl
+
+#endif //! __ST_HPC_PPL_CV_X86_IMGCODECS_PNM_H_
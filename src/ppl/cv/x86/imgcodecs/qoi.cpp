@@ -0,0 +1,338 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "qoi.h"
+#include "codecs.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ppl/common/log.h"
+
+namespace ppl {
+namespace cv {
+namespace x86 {
+
+// the longest chunk, QOI_OP_RGBA and its 4 bytes.
+#define QOI_MAX_CHUNK_SIZE 5
+
+static inline uint32_t hashPixel(uint32_t pixel) {
+    uint32_t b = pixel & 0xFF;
+    uint32_t g = (pixel >> 8) & 0xFF;
+    uint32_t r = (pixel >> 16) & 0xFF;
+    uint32_t a = pixel >> 24;
+
+    return (r * 3 + g * 5 + b * 7 + a * 11) & 63;
+}
+
+QoiDecoder::QoiDecoder(BytesReader& file_data) {
+    file_data_ = &file_data;
+    row_ = nullptr;
+    x_ = 0;
+    y_ = 0;
+    stride_ = 0;
+    pixel_ = 0xFF000000;
+}
+
+QoiDecoder::~QoiDecoder() {
+}
+
+bool QoiDecoder::readHeader() {
+    if (!file_data_->ensureValidSize(QOI_HEADER_SIZE)) {
+        LOG(ERROR) << "The qoi header is truncated.";
+        return false;
+    }
+
+    const uint8_t* header = file_data_->getCurrentPosition();
+    if (memcmp(header, "qoif", 4) != 0) {
+        LOG(ERROR) << "The qoi signature is not found.";
+        return false;
+    }
+    file_data_->skipBytes(4);
+    width_  = (uint32_t)file_data_->getDWordBigEndian();
+    height_ = (uint32_t)file_data_->getDWordBigEndian();
+    uint32_t channels   = file_data_->getByte();
+    uint32_t colorspace = file_data_->getByte();
+    if (width_ == 0 || height_ == 0 ||
+        (uint64_t)width_ * height_ >= MAX_IMAGE_SIZE) {
+        LOG(ERROR) << "Invalid qoi image size: " << width_ << "x" << height_;
+        return false;
+    }
+    if ((channels != 3 && channels != 4) || colorspace > 1) {
+        LOG(ERROR) << "Invalid qoi channels: " << channels << ", colorspace: "
+                   << colorspace;
+        return false;
+    }
+    channels_ = channels;
+    depth_ = 8;
+
+    return true;
+}
+
+// a run may go over rows, the runs of corrupted data stop at the last row.
+inline void QoiDecoder::putPixels(uint32_t pixel, uint32_t count) {
+    if (count == 1 && x_ + 1 < width_) {
+        // the 4th byte of 3 channels is overwritten by the next pixel.
+        memcpy(row_ + x_ * channels_, &pixel, 4);
+        x_++;
+        return;
+    }
+
+    while (count > 0 && y_ < height_) {
+        uint32_t number = width_ - x_;
+        number = count < number ? count : number;
+        uint8_t* dst = row_ + x_ * channels_;
+        if (channels_ == 4) {
+            for (uint32_t i = 0; i < number; i++) {
+                memcpy(dst + i * 4, &pixel, 4);
+            }
+        }
+        else {
+            for (uint32_t i = 0; i < number; i++) {
+                dst[i * 3]     = (uint8_t)pixel;
+                dst[i * 3 + 1] = (uint8_t)(pixel >> 8);
+                dst[i * 3 + 2] = (uint8_t)(pixel >> 16);
+            }
+        }
+        x_ += number;
+        count -= number;
+        if (x_ == width_) {
+            x_ = 0;
+            y_++;
+            row_ += stride_;
+        }
+    }
+}
+
+/* Decodes the chunks in data ~ end. The length of a chunk is only checked
+ * within the last QOI_MAX_CHUNK_SIZE bytes, which are left to the next call
+ * unless they are the last ones of the input. Returns false when the input
+ * ends inside a chunk.
+ */
+bool QoiDecoder::decodeChunks(const uint8_t*& data, const uint8_t* end,
+                              bool is_last) {
+    const uint8_t* current = data;
+    uint32_t pixel = pixel_;
+    bool succeeded = true;
+    while (y_ < height_) {
+        if (end - current < QOI_MAX_CHUNK_SIZE) {
+            if (!is_last) {
+                break;
+            }
+            int32_t length = 1;
+            if (current < end) {
+                uint32_t tag = current[0];
+                length = tag == QOI_OP_RGBA ? 5 : tag == QOI_OP_RGB ? 4 :
+                         (tag & QOI_MASK_2) == QOI_OP_LUMA ? 2 : 1;
+            }
+            if (end - current < length) {
+                succeeded = false;
+                break;
+            }
+        }
+
+        uint32_t tag = *current++;
+        if (tag == QOI_OP_RGB) {
+            pixel = (pixel & 0xFF000000) | ((uint32_t)current[0] << 16) |
+                    ((uint32_t)current[1] << 8) | current[2];
+            current += 3;
+        }
+        else if (tag == QOI_OP_RGBA) {
+            pixel = ((uint32_t)current[3] << 24) |
+                    ((uint32_t)current[0] << 16) |
+                    ((uint32_t)current[1] << 8) | current[2];
+            current += 4;
+        }
+        else if ((tag & QOI_MASK_2) == QOI_OP_INDEX) {
+            pixel = index_[tag];
+            putPixels(pixel, 1);
+            continue;
+        }
+        else if ((tag & QOI_MASK_2) == QOI_OP_RUN) {
+            putPixels(pixel, (tag & 0x3F) + 1);
+            index_[hashPixel(pixel)] = pixel;
+            continue;
+        }
+        else {
+            int32_t dr, dg, db;
+            if ((tag & QOI_MASK_2) == QOI_OP_DIFF) {
+                dr = ((tag >> 4) & 3) - 2;
+                dg = ((tag >> 2) & 3) - 2;
+                db = (tag & 3) - 2;
+            }
+            else {
+                uint32_t value = *current++;
+                dg = (int32_t)(tag & 0x3F) - 32;
+                dr = dg - 8 + (int32_t)(value >> 4);
+                db = dg - 8 + (int32_t)(value & 0x0F);
+            }
+            uint32_t b = (pixel + db) & 0xFF;
+            uint32_t g = ((pixel >> 8) + dg) & 0xFF;
+            uint32_t r = ((pixel >> 16) + dr) & 0xFF;
+            pixel = (pixel & 0xFF000000) | (r << 16) | (g << 8) | b;
+        }
+        index_[hashPixel(pixel)] = pixel;
+        putPixels(pixel, 1);
+    }
+    data = current;
+    pixel_ = pixel;
+
+    return succeeded;
+}
+
+bool QoiDecoder::decodeData(uint32_t stride, uint8_t* image) {
+    memset(index_, 0, sizeof(index_));
+    pixel_ = 0xFF000000;
+    row_ = image;
+    x_ = 0;
+    y_ = 0;
+    stride_ = stride;
+
+    while (y_ < height_) {
+        bool is_last = !file_data_->ensureValidSize(QOI_MAX_CHUNK_SIZE) ||
+                       file_data_->isLastBlock();
+        const uint8_t* start = file_data_->getCurrentPosition();
+        const uint8_t* data = start;
+        bool succeeded = decodeChunks(data, start +
+                                      file_data_->getValidSize(), is_last);
+        file_data_->skipBytes(data - start);
+        if (!succeeded) {
+            LOG(ERROR) << "The qoi data is truncated at row " << y_ << ".";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+QoiEncoder::QoiEncoder(BytesWriter& file_data) {
+    file_data_ = &file_data;
+}
+
+QoiEncoder::~QoiEncoder() {
+}
+
+bool QoiEncoder::isChannelsSupported(uint32_t channels) const {
+    return channels == 3 || channels == 4;
+}
+
+/* The chunks of a row are gathered in a buffer, a pixel takes no more than
+ * channels + 1 bytes, plus a run carried over from the row above.
+ */
+bool QoiEncoder::encodeData(uint32_t height, uint32_t width, uint32_t channels,
+                            uint32_t stride, const uint8_t* image) {
+    uint8_t* buffer = (uint8_t*)malloc((size_t)width * (channels + 1) + 1);
+    if (buffer == nullptr) {
+        LOG(ERROR) << "failed to allocate the row buffer of the encoder.";
+        return false;
+    }
+
+    file_data_->putBytes("qoif", 4);
+    file_data_->putDWordBigEndian(width);
+    file_data_->putDWordBigEndian(height);
+    file_data_->putByte(channels);
+    file_data_->putByte(0);
+
+    uint32_t index[64];
+    memset(index, 0, sizeof(index));
+    uint32_t previous = 0xFF000000;
+    uint32_t run = 0;
+    for (uint32_t row = 0; row < height; row++) {
+        const uint8_t* src = image + (size_t)row * stride;
+        uint8_t* output = buffer;
+        for (uint32_t col = 0; col < width; col++) {
+            uint32_t pixel;
+            if (channels == 4) {
+                memcpy(&pixel, src + col * 4, 4);
+            }
+            else {
+                const uint8_t* bgr = src + col * 3;
+                pixel = 0xFF000000 | ((uint32_t)bgr[2] << 16) |
+                        ((uint32_t)bgr[1] << 8) | bgr[0];
+            }
+
+            if (pixel == previous) {
+                run++;
+                if (run == 62) {
+                    *output++ = QOI_OP_RUN | 61;
+                    run = 0;
+                }
+                continue;
+            }
+            if (run > 0) {
+                *output++ = QOI_OP_RUN | (run - 1);
+                run = 0;
+            }
+
+            uint32_t hash = hashPixel(pixel);
+            if (index[hash] == pixel) {
+                *output++ = QOI_OP_INDEX | hash;
+            }
+            else {
+                index[hash] = pixel;
+                uint8_t b = pixel, g = pixel >> 8, r = pixel >> 16;
+                if ((pixel >> 24) == (previous >> 24)) {
+                    int32_t db = (int8_t)(b - (uint8_t)previous);
+                    int32_t dg = (int8_t)(g - (uint8_t)(previous >> 8));
+                    int32_t dr = (int8_t)(r - (uint8_t)(previous >> 16));
+                    int32_t dr_dg = dr - dg;
+                    int32_t db_dg = db - dg;
+                    if (dr > -3 && dr < 2 && dg > -3 && dg < 2 && db > -3 &&
+                        db < 2) {
+                        *output++ = QOI_OP_DIFF | ((dr + 2) << 4) |
+                                    ((dg + 2) << 2) | (db + 2);
+                    }
+                    else if (dr_dg > -9 && dr_dg < 8 && dg > -33 && dg < 32 &&
+                             db_dg > -9 && db_dg < 8) {
+                        output[0] = QOI_OP_LUMA | (dg + 32);
+                        output[1] = ((dr_dg + 8) << 4) | (db_dg + 8);
+                        output += 2;
+                    }
+                    else {
+                        output[0] = QOI_OP_RGB;
+                        output[1] = r;
+                        output[2] = g;
+                        output[3] = b;
+                        output += 4;
+                    }
+                }
+                else {
+                    output[0] = QOI_OP_RGBA;
+                    output[1] = r;
+                    output[2] = g;
+                    output[3] = b;
+                    output[4] = pixel >> 24;
+                    output += 5;
+                }
+            }
+            previous = pixel;
+        }
+        file_data_->putBytes(buffer, (int)(output - buffer));
+    }
+    if (run > 0) {
+        file_data_->putByte(QOI_OP_RUN | (run - 1));
+    }
+    const uint8_t padding[QOI_PADDING_SIZE] = {0, 0, 0, 0, 0, 0, 0, 1};
+    file_data_->putBytes(padding, QOI_PADDING_SIZE);
+    free(buffer);
+
+    return file_data_->isGood();
+}
+
+} //! namespace x86
+} //! namespace cv
+} //! namespace ppl
@@ -0,0 +1,81 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef __ST_HPC_PPL_CV_X86_IMGCODECS_QOI_H_
+#define __ST_HPC_PPL_CV_X86_IMGCODECS_QOI_H_
+
+#include "imagecodecs.h"
+#include "bytesreader.h"
+#include "byteswriter.h"
+
+namespace ppl {
+namespace cv {
+namespace x86 {
+
+#define QOI_HEADER_SIZE 14
+#define QOI_PADDING_SIZE 8
+#define QOI_OP_INDEX 0x00  // 00xxxxxx
+#define QOI_OP_DIFF  0x40  // 01xxxxxx
+#define QOI_OP_LUMA  0x80  // 10xxxxxx
+#define QOI_OP_RUN   0xC0  // 11xxxxxx
+#define QOI_OP_RGB   0xFE
+#define QOI_OP_RGBA  0xFF
+#define QOI_MASK_2   0xC0
+
+/* The pixels of the codec are kept in B G R A order of the decoded images,
+ * packed in a 32 bit word from the lowest byte.
+ */
+class QoiDecoder : public ImageDecoder {
+  public:
+    QoiDecoder(BytesReader& file_data);
+    ~QoiDecoder();
+
+    bool readHeader() override;
+    bool decodeData(uint32_t stride, uint8_t* image) override;
+
+  private:
+    bool decodeChunks(const uint8_t*& data, const uint8_t* end, bool is_last);
+    inline void putPixels(uint32_t pixel, uint32_t count);
+
+  private:
+    BytesReader* file_data_;
+    uint32_t index_[64];
+    uint32_t pixel_;
+    uint8_t* row_;       // the row being decoded
+    uint32_t x_;         // the next pixel in the row
+    uint32_t y_;
+    uint32_t stride_;
+};
+
+class QoiEncoder : public ImageEncoder {
+  public:
+    QoiEncoder(BytesWriter& file_data);
+    ~QoiEncoder();
+
+    bool isChannelsSupported(uint32_t channels) const override;
+    bool encodeData(uint32_t height, uint32_t width, uint32_t channels,
+                    uint32_t stride, const uint8_t* image) override;
+
+  private:
+    BytesWriter* file_data_;
+};
+
+} //! namespace x86
+} //! namespace cv
+} //! namespace ppl
+
+#endif //! __ST_HPC_PPL_CV_X86_IMGCODECS_QOI_H_
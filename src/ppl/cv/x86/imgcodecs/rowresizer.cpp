@@ -0,0 +1,325 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "rowresizer.h"
+
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <immintrin.h>
+
+#include "ppl/cv/x86/fma/internal_fma.hpp"
+#include "ppl/common/x86/sysinfo.h"
+#include "ppl/common/log.h"
+
+namespace ppl {
+namespace cv {
+namespace x86 {
+
+#define RESIZE_COEF_BITS  11
+#define RESIZE_COEF_SCALE (1 << RESIZE_COEF_BITS)
+
+static inline int32_t floorValue(float value) {
+    return value >= 0 ? (int32_t)value : (int32_t)value - 1;
+}
+
+// rounds half to even, as the coefficients of ResizeLinear() are.
+static inline int16_t roundCoefficient(float value) {
+    double integral, fraction;
+    fraction = modf(value, &integral);
+    int32_t rounded;
+    if (fabs(fraction) != 0.5f || (((int32_t)integral) % 2) != 0) {
+        rounded = (int32_t)(value + (value >= 0 ? 0.5f : -0.5f));
+    }
+    else {
+        rounded = (int32_t)integral;
+    }
+
+    return rounded > SHRT_MIN ? (rounded < SHRT_MAX ? rounded : SHRT_MAX) :
+           SHRT_MIN;
+}
+
+// sizes of the tables and rows are kept in 64 bytes for the SIMD loads.
+static inline size_t alignSize(size_t size) {
+    return (size + 63) & ~(size_t)63;
+}
+
+RowResizer::RowResizer(DecoderScratch& scratch) {
+    scratch_ = &scratch;
+    in_height_ = in_width_ = channels_ = 0;
+    out_height_ = out_width_ = 0;
+    interpolation_ = INTERPOLATION_LINEAR;
+    stride_ = 0;
+    image_ = nullptr;
+    h_offsets_ = nullptr;
+    h_coeffs_ = nullptr;
+    w_offsets_ = nullptr;
+    w_coeffs_ = nullptr;
+    rows_[0] = rows_[1] = nullptr;
+    w_max_ = 0;
+    in_row_ = out_row_ = 0;
+}
+
+RowResizer::~RowResizer() {
+}
+
+bool RowResizer::initialize(uint32_t in_height, uint32_t in_width,
+                            uint32_t channels, uint32_t out_height,
+                            uint32_t out_width,
+                            InterpolationType interpolation, uint32_t stride,
+                            uint8_t* image) {
+    in_height_ = in_height;
+    in_width_ = in_width;
+    channels_ = channels;
+    out_height_ = out_height;
+    out_width_ = out_width;
+    interpolation_ = interpolation;
+    stride_ = stride;
+    image_ = image;
+    in_row_ = out_row_ = 0;
+
+    size_t row_size = (size_t)out_width * channels;
+    size_t h_offsets_size = alignSize(out_height * sizeof(int32_t));
+    size_t h_coeffs_size  = alignSize(out_height * sizeof(int16_t));
+    size_t w_offsets_size = alignSize(row_size * sizeof(int32_t));
+    size_t w_coeffs_size  = alignSize(row_size * 2 * sizeof(int16_t));
+    size_t rows_size      = alignSize(row_size * sizeof(int32_t));
+    uint8_t* buffer = (uint8_t*)scratch_->reserve(RESIZE_BUFFERS,
+                          h_offsets_size + h_coeffs_size + w_offsets_size +
+                          w_coeffs_size + rows_size * 2);
+    if (buffer == nullptr) {
+        LOG(ERROR) << "No enough memory to resize the rows.";
+        return false;
+    }
+    h_offsets_ = (int32_t*)buffer;
+    h_coeffs_  = (int16_t*)(buffer + h_offsets_size);
+    w_offsets_ = (int32_t*)((uint8_t*)h_coeffs_ + h_coeffs_size);
+    w_coeffs_  = (int16_t*)((uint8_t*)w_offsets_ + w_offsets_size);
+    rows_[0]   = (int32_t*)((uint8_t*)w_coeffs_ + w_coeffs_size);
+    rows_[1]   = (int32_t*)((uint8_t*)rows_[0] + rows_size);
+
+    if (interpolation == INTERPOLATION_LINEAR) {
+        computeLinearTables();
+    }
+    else {
+        computeNearestTables();
+    }
+
+    return true;
+}
+
+// the source pixel centers of each output pixel, as in ResizeLinear().
+void RowResizer::computeLinearTables() {
+    double scale_h = (double)in_height_ / out_height_;
+    for (uint32_t h = 0; h < out_height_; ++h) {
+        float float_h = (h + 0.5) * scale_h - 0.5;
+        int32_t int_h = floorValue(float_h);
+        float_h -= int_h;
+        h_offsets_[h] = int_h;
+        h_coeffs_[h]  = roundCoefficient((1.0f - float_h) * RESIZE_COEF_SCALE);
+    }
+
+    double scale_w = (double)in_width_ / out_width_;
+    w_max_ = 0;
+    for (uint32_t w = 0; w < out_width_; ++w) {
+        float float_w = (w + 0.5) * scale_w - 0.5;
+        int32_t int_w = floorValue(float_w);
+        float_w -= int_w;
+        if (int_w < 0) {
+            int_w   = 0;
+            float_w = 0;
+        }
+        if (int_w + 1 >= (int32_t)in_width_) {
+            int_w   = in_width_ - 1;
+            float_w = 0;
+        }
+        if (int_w <= (int32_t)in_width_ - 2) {
+            w_max_ = w;
+        }
+
+        w_offsets_[w] = int_w * channels_;
+        int16_t coeff0 = roundCoefficient((1.0f - float_w) * RESIZE_COEF_SCALE);
+        int16_t coeff1 = roundCoefficient(float_w * RESIZE_COEF_SCALE);
+        for (uint32_t c = 0; c < channels_; ++c) {
+            w_coeffs_[(w * channels_ + c) * 2 + 0] = coeff0;
+            w_coeffs_[(w * channels_ + c) * 2 + 1] = coeff1;
+        }
+    }
+}
+
+// the nearest source pixels of each output pixel, as in ResizeNearestPoint().
+void RowResizer::computeNearestTables() {
+    double scale_h = (double)in_height_ / out_height_;
+    for (uint32_t h = 0; h < out_height_; ++h) {
+        int32_t int_h = floorValue(h * scale_h);
+        h_offsets_[h] = int_h < (int32_t)in_height_ - 1 ? int_h :
+                        in_height_ - 1;
+    }
+
+    double scale_w = (double)in_width_ / out_width_;
+    for (uint32_t w = 0; w < out_width_; ++w) {
+        int32_t int_w = floorValue(w * scale_w);
+        int_w = int_w < (int32_t)in_width_ - 1 ? int_w : in_width_ - 1;
+        w_offsets_[w] = int_w * channels_;
+    }
+}
+
+void RowResizer::resizeRowLinear(const uint8_t* row, int32_t* output) {
+    int32_t i = 0;
+    if (ppl::common::CpuSupports(ppl::common::ISA_X86_FMA)) {
+        if (channels_ == 1) {
+            i = fma::resize_linear_w_oneline_c1_u8_fma(in_width_, row,
+                    out_width_, w_offsets_, w_coeffs_, RESIZE_COEF_SCALE,
+                    output);
+        }
+        else if (channels_ == 3) {
+            i = fma::resize_linear_w_oneline_c3_u8_fma(in_width_, row,
+                    out_width_, w_offsets_, w_coeffs_, RESIZE_COEF_SCALE,
+                    output);
+        }
+        else if (channels_ == 4) {
+            i = fma::resize_linear_w_oneline_c4_u8_fma(in_width_, row,
+                    out_width_, w_offsets_, w_coeffs_, RESIZE_COEF_SCALE,
+                    output);
+        }
+    }
+
+    int32_t channels = channels_;
+    int32_t last = (in_width_ - 1) * channels;
+    for (; i < (int32_t)out_width_; ++i) {
+        for (int32_t c = 0; c < channels; ++c) {
+            int32_t index0 = w_offsets_[i] + c;
+            int32_t index1 = i < w_max_ || index0 < last ? index0 + channels :
+                             index0;
+            const int16_t* coeffs = w_coeffs_ + (i * channels + c) * 2;
+            output[i * channels + c] = (row[index0] * coeffs[0] +
+                                        row[index1] * coeffs[1]) >> 4;
+        }
+    }
+}
+
+// row0 * coeff + row1 * (RESIZE_COEF_SCALE - coeff), as in ResizeLinear().
+void RowResizer::blendRows(const int32_t* row0, const int32_t* row1,
+                           int16_t coeff, uint8_t* output) {
+    int32_t size = out_width_ * channels_;
+    int16_t coeff1 = RESIZE_COEF_SCALE - coeff;
+    __m128i m_coeff0 = _mm_set1_epi16(coeff);
+    __m128i m_coeff1 = _mm_set1_epi16(coeff1);
+    __m128i m_two = _mm_set1_epi16(2);
+
+    int32_t i = 0;
+    for (; i <= size - 16; i += 16) {
+        __m128i m_row00 = _mm_packs_epi32(
+            _mm_load_si128((const __m128i*)(row0 + i)),
+            _mm_load_si128((const __m128i*)(row0 + i + 4)));
+        __m128i m_row01 = _mm_packs_epi32(
+            _mm_load_si128((const __m128i*)(row0 + i + 8)),
+            _mm_load_si128((const __m128i*)(row0 + i + 12)));
+        __m128i m_row10 = _mm_packs_epi32(
+            _mm_load_si128((const __m128i*)(row1 + i)),
+            _mm_load_si128((const __m128i*)(row1 + i + 4)));
+        __m128i m_row11 = _mm_packs_epi32(
+            _mm_load_si128((const __m128i*)(row1 + i + 8)),
+            _mm_load_si128((const __m128i*)(row1 + i + 12)));
+
+        __m128i m_result0 = _mm_adds_epi16(_mm_mulhi_epi16(m_row00, m_coeff0),
+                                           _mm_mulhi_epi16(m_row10, m_coeff1));
+        __m128i m_result1 = _mm_adds_epi16(_mm_mulhi_epi16(m_row01, m_coeff0),
+                                           _mm_mulhi_epi16(m_row11, m_coeff1));
+        m_result0 = _mm_srai_epi16(_mm_adds_epi16(m_result0, m_two), 2);
+        m_result1 = _mm_srai_epi16(_mm_adds_epi16(m_result1, m_two), 2);
+        _mm_storeu_si128((__m128i*)(output + i),
+                         _mm_packus_epi16(m_result0, m_result1));
+    }
+    for (; i < size; ++i) {
+        output[i] = (((coeff * row0[i]) >> 16) + ((coeff1 * row1[i]) >> 16) +
+                     2) >> 2;
+    }
+}
+
+void RowResizer::sampleRow(const uint8_t* row, uint8_t* output) {
+    if (channels_ == 1) {
+        for (uint32_t i = 0; i < out_width_; ++i) {
+            output[i] = row[w_offsets_[i]];
+        }
+    }
+    else if (channels_ == 3) {
+        for (uint32_t i = 0; i < out_width_; ++i) {
+            const uint8_t* pixel = row + w_offsets_[i];
+            output[i * 3 + 0] = pixel[0];
+            output[i * 3 + 1] = pixel[1];
+            output[i * 3 + 2] = pixel[2];
+        }
+    }
+    else {
+        for (uint32_t i = 0; i < out_width_; ++i) {
+            memcpy(output + i * channels_, row + w_offsets_[i], channels_);
+        }
+    }
+}
+
+/* Writes the output rows which need no source row below this one. The output
+ * rows read their source rows in order, so a source row above the first one
+ * the next output row reads is never read.
+ */
+void RowResizer::consumeRow(const uint8_t* row) {
+    int32_t current = in_row_++;
+    if (out_row_ >= out_height_) {
+        return;
+    }
+
+    if (interpolation_ == INTERPOLATION_NEAREST_POINT) {
+        while (out_row_ < out_height_ && h_offsets_[out_row_] == current) {
+            uint8_t* output = image_ + out_row_ * (size_t)stride_;
+            if (out_row_ > 0 && h_offsets_[out_row_ - 1] == current) {
+                memcpy(output, output - stride_, out_width_ * channels_);
+            }
+            else {
+                sampleRow(row, output);
+            }
+            out_row_++;
+        }
+        return;
+    }
+
+    int32_t first = h_offsets_[out_row_] > 0 ? h_offsets_[out_row_] : 0;
+    if (current < first) {
+        return;
+    }
+    resizeRowLinear(row, rows_[current & 1]);
+
+    int32_t last = in_height_ - 1;
+    while (out_row_ < out_height_) {
+        int32_t row0 = h_offsets_[out_row_];
+        int32_t row1 = row0 == last ? last : row0 + 1;
+        row0 = row0 > 0 ? row0 : 0;
+        if (row1 > current) {
+            break;
+        }
+        blendRows(rows_[row0 & 1], rows_[row1 & 1], h_coeffs_[out_row_],
+                  image_ + out_row_ * (size_t)stride_);
+        out_row_++;
+    }
+}
+
+bool RowResizer::isComplete() const {
+    return out_row_ == out_height_;
+}
+
+} //! namespace x86
+} //! namespace cv
+} //! namespace ppl
@@ -0,0 +1,78 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef __ST_HPC_PPL_CV_X86_IMGCODECS_ROWRESIZER_H_
+#define __ST_HPC_PPL_CV_X86_IMGCODECS_ROWRESIZER_H_
+
+#include "imagecodecs.h"
+#include "decoderscratch.h"
+
+#include <stdint.h>
+
+namespace ppl {
+namespace cv {
+namespace x86 {
+
+/* Resizes an 8 bit image whose rows come one at a time from the top, with the
+ * fixed point arithmetic of ResizeLinear() and the sampling of
+ * ResizeNearestPoint(). A source row is resized horizontally once, when an
+ * output row reads it, and kept with the one above it until the output rows
+ * between them are blended. Rows no output row reads are skipped. The tables
+ * and the 2 resized rows come from the scratch.
+ */
+class RowResizer : public RowConsumer {
+  public:
+    RowResizer(DecoderScratch& scratch);
+    ~RowResizer();
+
+    bool initialize(uint32_t in_height, uint32_t in_width, uint32_t channels,
+                    uint32_t out_height, uint32_t out_width,
+                    InterpolationType interpolation, uint32_t stride,
+                    uint8_t* image);
+    void consumeRow(const uint8_t* row) override;
+    // all the output rows are written.
+    bool isComplete() const;
+
+  private:
+    void computeLinearTables();
+    void computeNearestTables();
+    void resizeRowLinear(const uint8_t* row, int32_t* output);
+    void blendRows(const int32_t* row0, const int32_t* row1, int16_t coeff,
+                   uint8_t* output);
+    void sampleRow(const uint8_t* row, uint8_t* output);
+
+  private:
+    DecoderScratch* scratch_;
+    uint32_t in_height_, in_width_, channels_;
+    uint32_t out_height_, out_width_;
+    InterpolationType interpolation_;
+    uint32_t stride_;
+    uint8_t* image_;
+    int32_t* h_offsets_;  // the first source row of each output row
+    int16_t* h_coeffs_;   // the weight of the first source row
+    int32_t* w_offsets_;
+    int16_t* w_coeffs_;
+    int32_t* rows_[2];    // horizontally resized source rows, by parity
+    int32_t w_max_;       // output columns reading 2 source pixels
+    uint32_t in_row_, out_row_;
+};
+
+} //! namespace x86
+} //! namespace cv
+} //! namespace ppl
+
+#endif //! __ST_HPC_PPL_CV_X86_IMGCODECS_ROWRESIZER_H_
@@ -17,15 +17,24 @@
 
 #include "ppl/cv/x86/imread.h"
 #include "imgcodecs/bytesreader.h"
+#include "imgcodecs/mappedfile.h"
+#include "imgcodecs/decoderscratch.h"
 #include "imgcodecs/imagecodecs.h"
 #include "imgcodecs/bmp.h"
 #include "imgcodecs/jpeg.h"
 #include "imgcodecs/png.h"
+#include "imgcodecs/qoi.h"
+#include "imgcodecs/pnm.h"
+#include "imgcodecs/rowresizer.h"
 #include "imgcodecs/codecs.h"
 
 #include <stdio.h>
 #include <string.h>
+#include <ctype.h>
 #include <assert.h>
+#include <atomic>
+#include <thread>
+#include <vector>
 
 #include "ppl/common/log.h"
 
@@ -41,33 +50,723 @@ bool detectFormat(BytesReader& file_data, ImageFormats* image_format) {
     const char png_signature[] = {(int8_t)0x89, (int8_t)0x50, (int8_t)0x4E,
                                   (int8_t)0x47, (int8_t)0x0D, (int8_t)0x0A,
                                   (int8_t)0x1A, (int8_t)0x0A};
+    const char* qoi_signature  = "qoif";
 
-    const char* file_signature = (char*)file_data.data();
+    const char* file_signature = (const char*)file_data.data();
+    uint32_t size = file_data.getValidSize();
 
     int matched;
-    matched = memcmp(bmp_signature, file_signature, 2);
+    matched = size >= 2 ? memcmp(bmp_signature, file_signature, 2) : -1;
     if (matched == 0) {
         *image_format = BMP;
         return true;
     }
-    matched = memcmp(jpeg_signature, file_signature, 3);
+    matched = size >= 3 ? memcmp(jpeg_signature, file_signature, 3) : -1;
     if (matched == 0) {
         *image_format = JPEG;
         return true;
     }
-    matched = memcmp(png_signature, file_signature, 8);
+    matched = size >= 8 ? memcmp(png_signature, file_signature, 8) : -1;
     if (matched == 0) {
         *image_format = PNG;
         file_data.skipBytes(8);
         return true;
     }
+    matched = size >= 4 ? memcmp(qoi_signature, file_signature, 4) : -1;
+    if (matched == 0) {
+        *image_format = QOI;
+        return true;
+    }
+    // binary graymaps and pixmaps, P5 or P6 and a white space.
+    if (size >= 3 && file_signature[0] == 'P' &&
+        (file_signature[1] == '5' || file_signature[1] == '6') &&
+        isspace((unsigned char)file_signature[2])) {
+        *image_format = PNM;
+        return true;
+    }
 
     *image_format = UNSUPPORTED;
     return false;
 }
 
+/* Detects the format, reads the header with a decoder living on the stack and
+ * hands the decoder to function(). All buffers of the decoders come from
+ * scratch. Decoders which can scale report the reduced size after the header,
+ * those applying an orientation report the size of the upright image.
+ * Chunk crcs of png images are skipped for trusted data without check_crc.
+ */
+template <typename Function>
+static RetCode runDecoder(BytesReader& file_data, DecoderScratch& scratch,
+                          int scale, bool upright, bool check_crc,
+                          Function function) {
+    ImageFormats image_format;
+    bool succeeded = detectFormat(file_data, &image_format);
+    if (succeeded == false) {
+        if (image_format == UNSUPPORTED) {
+            LOG(ERROR) << "unsupported image format.";
+        }
+        return RC_OTHER_ERROR;
+    }
+
+    if (image_format == BMP) {
+        BmpDecoder decoder(file_data, scratch);
+        succeeded = decoder.readHeader();
+        if (succeeded) {
+            decoder.setScale(scale);
+            decoder.setUpright(upright);
+            return function(decoder, image_format);
+        }
+    }
+    else if (image_format == JPEG) {
+        JpegDecoder decoder(file_data, scratch);
+        succeeded = decoder.readHeader();
+        if (succeeded) {
+            decoder.setScale(scale);
+            decoder.setUpright(upright);
+            return function(decoder, image_format);
+        }
+    }
+    else if (image_format == PNG) {
+        PngDecoder decoder(file_data, scratch);
+        decoder.setCrcChecking(check_crc);
+        succeeded = decoder.readHeader();
+        if (succeeded) {
+            decoder.setScale(scale);
+            decoder.setUpright(upright);
+            return function(decoder, image_format);
+        }
+    }
+    else if (image_format == QOI) {
+        QoiDecoder decoder(file_data);
+        succeeded = decoder.readHeader();
+        if (succeeded) {
+            return function(decoder, image_format);
+        }
+    }
+    else {  // image_format == PNM
+        PnmDecoder decoder(file_data);
+        succeeded = decoder.readHeader();
+        if (succeeded) {
+            return function(decoder, image_format);
+        }
+    }
+    LOG(ERROR) << "failed to read file header.";
+
+    return RC_OTHER_ERROR;
+}
+
+static RetCode readImageHeader(BytesReader& file_data, DecoderScratch& scratch,
+                               int* height, int* width, int* channels,
+                               int* depth, const ImreadParams& params) {
+    return runDecoder(file_data, scratch, params.scaleDenominator,
+                      params.upright, true,
+        [&](ImageDecoder& decoder, ImageFormats image_format) {
+            *height   = decoder.height();
+            *width    = decoder.width();
+            *channels = decoder.channels();
+            *depth    = decoder.depth();
+            if (params.mode != IMREAD_UNCHANGED) {
+                if (decoder.depth() == 16) {
+                    LOG(ERROR) << "16 bit images are only decoded unchanged.";
+                    return RC_UNSUPPORTED;
+                }
+                *channels = 1;
+            }
+
+            return RC_SUCCESS;
+        });
+}
+
+// bytes from the first pixel to the last one of an image of the mode.
+static size_t modeImageSize(ImreadModes mode, int height, int width,
+                            int stride) {
+    size_t chroma_width  = (width + 1) >> 1;
+    size_t chroma_height = (height + 1) >> 1;
+    if (mode == IMREAD_GRAYSCALE) {
+        return (size_t)stride * (height - 1) + width;
+    }
+    else if (mode == IMREAD_I420) {
+        return (size_t)stride * height +
+               (size_t)(stride / 2) * (chroma_height * 2 - 1) + chroma_width;
+    }
+    else {  // mode == IMREAD_NV12
+        return (size_t)stride * (height + chroma_height - 1) +
+               chroma_width * 2;
+    }
+}
+
+/* Converts a gray, gray and alpha, BGR or BGRA image into the layout of the
+ * mode with the full range YCbCr of JFIF, as a jpeg image is decoded into
+ * it. rows holds 2 rows of width + 16 bytes for the chroma out of the way.
+ */
+static void convertImage(ImreadModes mode, int height, int width,
+                         int channels, size_t src_stride, const uint8_t* src,
+                         uint8_t* rows, int stride, uint8_t* image) {
+    int chroma_width  = (width + 1) >> 1;
+    int chroma_height = (height + 1) >> 1;
+    int chroma_stride = mode == IMREAD_I420 ? stride / 2 : stride;
+    uint8_t* chroma_planes = image + (size_t)stride * height;
+    if (channels <= 2) {
+        for (int row = 0; row < height; row++) {
+            const uint8_t* src_row = src + row * src_stride;
+            uint8_t* dst_row = image + row * (size_t)stride;
+            if (channels == 1) {
+                memcpy(dst_row, src_row, width);
+            }
+            else {
+                for (int col = 0; col < width; col++) {
+                    dst_row[col] = src_row[col * 2];
+                }
+            }
+        }
+        if (mode == IMREAD_GRAYSCALE) {
+            return;
+        }
+
+        // neutral chroma, the u and v planes of I420 are one after the other.
+        int chroma_rows  = mode == IMREAD_I420 ? chroma_height * 2 :
+                           chroma_height;
+        int chroma_bytes = mode == IMREAD_I420 ? chroma_width :
+                           chroma_width * 2;
+        for (int row = 0; row < chroma_rows; row++) {
+            memset(chroma_planes + row * (size_t)chroma_stride, 128,
+                   chroma_bytes);
+        }
+        return;
+    }
+
+    uint8_t* cb = rows;
+    uint8_t* cr = rows + width + 16;
+    if (mode == IMREAD_GRAYSCALE) {
+        BGR2YCrCb converter(width, channels, 2, 1);
+        for (int row = 0; row < height; row++) {
+            converter.convertRows(src + row * src_stride, nullptr,
+                                  image + row * (size_t)stride, nullptr, cb,
+                                  cr);
+        }
+        return;
+    }
+
+    BGR2YCrCb converter(width, channels, 2, 2);
+    for (int row = 0; row < height; row += 2) {
+        int next = row + 1 < height ? row + 1 : row;
+        uint8_t* chroma_row = chroma_planes + (row >> 1) *
+                              (size_t)chroma_stride;
+        if (mode == IMREAD_I420) {
+            cb = chroma_row;
+            cr = chroma_row + (size_t)chroma_stride * chroma_height;
+        }
+        converter.convertRows(src + row * src_stride, src + next * src_stride,
+                              image + row * (size_t)stride,
+                              image + next * (size_t)stride, cb, cr);
+        if (mode == IMREAD_NV12) {
+            for (int index = 0; index < chroma_width; index++) {
+                chroma_row[index * 2] = cb[index];
+                chroma_row[index * 2 + 1] = cr[index];
+            }
+        }
+    }
+}
+
+/* Decodes an image into the layout of the mode. Decoders which can not write
+ * it decode the image as it is into the image buffer of the scratch, and it
+ * is converted from there.
+ */
+static bool decodeInMode(ImageDecoder& decoder, ImageFormats image_format,
+                         DecoderScratch& scratch, ImreadModes mode,
+                         int stride, uchar* image) {
+    if (decoder.setMode(mode)) {
+        return decoder.decodeData(stride, image);
+    }
+
+    int height = decoder.height();
+    int width  = decoder.width();
+    int channels = decoder.channels();
+    size_t row_bytes = (size_t)width * channels;
+    size_t src_stride = image_format == PNG ? (row_bytes + 1 + 15) & -16 :
+                        (row_bytes + 3) & -4;
+    uint8_t* buffer = (uint8_t*)scratch.reserve(IMAGE_BUFFER,
+                          src_stride * height + ((size_t)width + 16) * 2);
+    if (buffer == nullptr || !decoder.decodeData(src_stride, buffer)) {
+        return false;
+    }
+    convertImage(mode, height, width, channels, src_stride, buffer,
+                 buffer + src_stride * height, stride, image);
+
+    return true;
+}
+
+static RetCode decodeImage(BytesReader& file_data, DecoderScratch& scratch,
+                           int* height, int* width, int* channels, int* stride,
+                           uchar** image, const ImreadParams& params) {
+    ImreadModes mode = params.mode;
+    return runDecoder(file_data, scratch, params.scaleDenominator,
+                      params.upright, params.checkCrc,
+        [&](ImageDecoder& decoder, ImageFormats image_format) {
+            *height   = decoder.height();
+            *width    = decoder.width();
+            *channels = decoder.channels();
+            int bytes = (decoder.depth() == 16 ? 2 : 1);
+            if (mode != IMREAD_UNCHANGED) {
+                if (decoder.depth() == 16) {
+                    LOG(ERROR) << "16 bit images are only decoded unchanged.";
+                    return RC_UNSUPPORTED;
+                }
+                *channels = 1;
+                // whole rows of stride bytes up to the last one.
+                *stride = (decoder.width() + 3) & -4;
+                (*image) = (uchar*)malloc(modeImageSize(mode, *height, *stride,
+                                                        *stride));
+                if (*image == nullptr) {
+                    LOG(ERROR) << "failed to allocate memory for the image.";
+                    return RC_OUT_OF_MEMORY;
+                }
+                if (!decodeInMode(decoder, image_format, scratch, mode,
+                                  *stride, *image)) {
+                    LOG(ERROR) << "failed to decode the file data.";
+                    free(*image);
+                    *image = nullptr;
+                    return RC_OTHER_ERROR;
+                }
+
+                return RC_SUCCESS;
+            }
+            if (image_format == PNG) {
+                *stride = (decoder.width() * decoder.channels() * bytes + 1 +
+                           15) & -16;
+            }
+            else {
+                *stride = (decoder.width() * decoder.channels() * bytes + 3) &
+                          -4;
+            }
+            size_t size = (*stride) * (*height);
+            assert(size < MAX_IMAGE_SIZE);
+            (*image) = (uchar*)malloc(size);
+            if (*image == nullptr) {
+                LOG(ERROR) << "failed to allocate memory for the image.";
+                return RC_OUT_OF_MEMORY;
+            }
+
+            bool succeeded = decoder.decodeData(*stride, (*image));
+            if (succeeded == false) {
+                LOG(ERROR) << "failed to decode the file data.";
+                free(*image);
+                *image = nullptr;
+                return RC_OTHER_ERROR;
+            }
+
+            return RC_SUCCESS;
+        });
+}
+
+/* Decodes into a caller-owned buffer. The png decoder inflates and unfilters
+ * in place at the bottom of its output, which needs rows one byte longer
+ * than the pixels and aligned with 16 bytes, so a png image with a tighter
+ * stride goes through the image buffer of the scratch.
+ */
+static RetCode decodeImage(BytesReader& file_data, DecoderScratch& scratch,
+                           int stride, size_t capacity, uchar* image,
+                           int* height, int* width, int* channels,
+                           const ImreadParams& params) {
+    ImreadModes mode = params.mode;
+    return runDecoder(file_data, scratch, params.scaleDenominator,
+                      params.upright, params.checkCrc,
+        [&](ImageDecoder& decoder, ImageFormats image_format) {
+            *height   = decoder.height();
+            *width    = decoder.width();
+            *channels = decoder.channels();
+            int bytes = (decoder.depth() == 16 ? 2 : 1);
+            if (mode != IMREAD_UNCHANGED) {
+                if (decoder.depth() == 16) {
+                    LOG(ERROR) << "16 bit images are only decoded unchanged.";
+                    return RC_UNSUPPORTED;
+                }
+                size_t size = ImreadBufferSize(*height, *width, 1, 8, stride,
+                                               mode);
+                if (size == 0 || size > capacity) {
+                    LOG(ERROR) << "the output buffer is too small for a "
+                               << decoder.width() << "x" << decoder.height()
+                               << " image in mode " << mode << ".";
+                    return RC_INVALID_VALUE;
+                }
+                *channels = 1;
+                if (!decodeInMode(decoder, image_format, scratch, mode,
+                                  stride, image)) {
+                    LOG(ERROR) << "failed to decode the file data.";
+                    return RC_OTHER_ERROR;
+                }
+
+                return RC_SUCCESS;
+            }
+
+            size_t row_bytes = (size_t)decoder.width() * decoder.channels() *
+                               bytes;
+            size_t size = ImreadBufferSize(*height, *width, *channels,
+                                           decoder.depth(), stride, mode);
+            if (size == 0 || size > capacity) {
+                LOG(ERROR) << "the output buffer is too small for a "
+                           << decoder.width() << "x" << decoder.height()
+                           << "x" << decoder.channels() << " image.";
+                return RC_INVALID_VALUE;
+            }
+
+            uint8_t* output = image;
+            size_t output_stride = stride;
+            if (image_format == PNG) {
+                size_t png_stride = (row_bytes + 1 + 15) & -16;
+                if ((size_t)stride < png_stride || (stride & 15) ||
+                    ((uintptr_t)image & 15) ||
+                    (size_t)stride * decoder.height() > capacity) {
+                    output_stride = png_stride;
+                    output = (uint8_t*)scratch.reserve(IMAGE_BUFFER,
+                                 png_stride * decoder.height());
+                    if (output == nullptr) {
+                        return RC_OUT_OF_MEMORY;
+                    }
+                }
+            }
+
+            bool succeeded = decoder.decodeData(output_stride, output);
+            if (succeeded == false) {
+                LOG(ERROR) << "failed to decode the file data.";
+                return RC_OTHER_ERROR;
+            }
+            if (output != image) {
+                for (uint32_t row = 0; row < decoder.height(); row++) {
+                    memcpy(image + row * (size_t)stride,
+                           output + row * output_stride, row_bytes);
+                }
+            }
+
+            return RC_SUCCESS;
+        });
+}
+
+/* Decodes the part of the image inside a region, which is clipped to the
+ * image. Decoders which can not decode a region alone decode the whole image
+ * into the image buffer of the scratch, and the region is copied out of it.
+ */
+static RetCode decodeImageRegion(BytesReader& file_data,
+                                 DecoderScratch& scratch, int x, int y,
+                                 int region_width, int region_height,
+                                 int* height, int* width, int* channels,
+                                 int* stride, uchar** image) {
+    return runDecoder(file_data, scratch, 1, false, true,
+        [&](ImageDecoder& decoder, ImageFormats image_format) {
+            int64_t right  = (int64_t)x + region_width;
+            int64_t bottom = (int64_t)y + region_height;
+            right  = right < decoder.width() ? right : decoder.width();
+            bottom = bottom < decoder.height() ? bottom : decoder.height();
+            if (x >= right || y >= bottom) {
+                LOG(ERROR) << "the region is outside the " << decoder.width()
+                           << "x" << decoder.height() << " image.";
+                return RC_INVALID_VALUE;
+            }
+            *height   = bottom - y;
+            *width    = right - x;
+            *channels = decoder.channels();
+            int bytes = (decoder.depth() == 16 ? 2 : 1);
+            size_t row_bytes = (size_t)(*width) * decoder.channels() * bytes;
+            *stride = (row_bytes + 3) & -4;
+            (*image) = (uchar*)malloc((*stride) * (size_t)(*height));
+            if (*image == nullptr) {
+                LOG(ERROR) << "failed to allocate memory for the image.";
+                return RC_OUT_OF_MEMORY;
+            }
+
+            bool succeeded;
+            if (decoder.setRegion(x, y, *width, *height)) {
+                succeeded = decoder.decodeData(*stride, (*image));
+            }
+            else {
+                size_t full_bytes = (size_t)decoder.width() *
+                                    decoder.channels() * bytes;
+                size_t full_stride = image_format == PNG ?
+                                     (full_bytes + 1 + 15) & -16 :
+                                     (full_bytes + 3) & -4;
+                uint8_t* output = (uint8_t*)scratch.reserve(IMAGE_BUFFER,
+                                      full_stride * decoder.height());
+                succeeded = output != nullptr &&
+                            decoder.decodeData(full_stride, output);
+                if (succeeded) {
+                    output += y * full_stride + (size_t)x *
+                              decoder.channels() * bytes;
+                    for (int row = 0; row < *height; row++) {
+                        memcpy(*image + row * (size_t)(*stride),
+                               output + row * full_stride, row_bytes);
+                    }
+                }
+            }
+            if (succeeded == false) {
+                LOG(ERROR) << "failed to decode the file data.";
+                free(*image);
+                *image = nullptr;
+                return RC_OTHER_ERROR;
+            }
+
+            return RC_SUCCESS;
+        });
+}
+
+/* Decodes an image resized to out_height x out_width. A jpeg image is decoded
+ * at the smallest DCT scale still covering the output size, and its rows go
+ * to the resizer as they are converted, so neither the full size image nor
+ * the scaled one is written out. The other decoders need their whole output,
+ * e.g. as the deflate window of png, those images are decoded into the image
+ * buffer of the scratch and resized from there row by row.
+ */
+static RetCode decodeImageResized(BytesReader& file_data,
+                                  DecoderScratch& scratch, int out_height,
+                                  int out_width,
+                                  InterpolationType interpolation,
+                                  int* channels, int* stride, uchar** image) {
+    return runDecoder(file_data, scratch, 1, false, true,
+        [&](ImageDecoder& decoder, ImageFormats image_format) {
+            if (decoder.depth() == 16) {
+                LOG(ERROR) << "16 bit images are not resized.";
+                return RC_UNSUPPORTED;
+            }
+            uint32_t full_height = decoder.height();
+            uint32_t full_width  = decoder.width();
+            uint32_t scale = 8;
+            while (scale > 1 &&
+                   ((full_height + scale - 1) / scale < (uint32_t)out_height ||
+                    (full_width + scale - 1) / scale < (uint32_t)out_width)) {
+                scale >>= 1;
+            }
+            decoder.setScale(scale);
+
+            *channels = decoder.channels();
+            *stride = (out_width * decoder.channels() + 3) & -4;
+            (*image) = (uchar*)malloc((*stride) * (size_t)out_height);
+            if (*image == nullptr) {
+                LOG(ERROR) << "failed to allocate memory for the image.";
+                return RC_OUT_OF_MEMORY;
+            }
+
+            RowResizer resizer(scratch);
+            bool succeeded = resizer.initialize(decoder.height(),
+                                 decoder.width(), decoder.channels(),
+                                 out_height, out_width, interpolation,
+                                 *stride, *image);
+            if (succeeded && decoder.setRowConsumer(&resizer)) {
+                succeeded = decoder.decodeData(0, nullptr);
+            }
+            else if (succeeded) {
+                size_t row_bytes = (size_t)decoder.width() * decoder.channels();
+                size_t src_stride = image_format == PNG ?
+                                    (row_bytes + 1 + 15) & -16 :
+                                    (row_bytes + 3) & -4;
+                uint8_t* buffer = (uint8_t*)scratch.reserve(IMAGE_BUFFER,
+                                      src_stride * decoder.height());
+                succeeded = buffer != nullptr &&
+                            decoder.decodeData(src_stride, buffer);
+                for (uint32_t row = 0; succeeded && row < decoder.height();
+                     row++) {
+                    resizer.consumeRow(buffer + row * src_stride);
+                }
+            }
+            if (succeeded == false || !resizer.isComplete()) {
+                LOG(ERROR) << "failed to decode the file data.";
+                free(*image);
+                *image = nullptr;
+                return RC_OTHER_ERROR;
+            }
+
+            return RC_SUCCESS;
+        });
+}
+
+static bool checkRegion(int x, int y, int region_width, int region_height) {
+    if (x < 0 || y < 0 || region_width <= 0 || region_height <= 0) {
+        LOG(ERROR) << "invalid region: (" << x << ", " << y << ") "
+                   << region_width << "x" << region_height << ".";
+        return false;
+    }
+
+    return true;
+}
+
+static bool checkScale(int scale) {
+    if (scale != 1 && scale != 2 && scale != 4 && scale != 8) {
+        LOG(ERROR) << "invalid scale denominator: " << scale
+                   << ", valid value: 1, 2, 4, 8.";
+        return false;
+    }
+
+    return true;
+}
+
+static bool checkMode(ImreadModes mode) {
+    if (mode != IMREAD_UNCHANGED && mode != IMREAD_GRAYSCALE &&
+        mode != IMREAD_I420 && mode != IMREAD_NV12) {
+        LOG(ERROR) << "invalid decoding mode: " << mode
+                   << ", valid value: 0, 1, 2, 3.";
+        return false;
+    }
+
+    return true;
+}
+
+static bool checkParams(const ImreadParams& params) {
+    return checkScale(params.scaleDenominator) && checkMode(params.mode);
+}
+
+static bool checkResizing(int out_height, int out_width,
+                          InterpolationType interpolation) {
+    if (out_height <= 0 || out_width <= 0) {
+        LOG(ERROR) << "invalid output size: " << out_width << "x"
+                   << out_height << ".";
+        return false;
+    }
+    if (interpolation != INTERPOLATION_LINEAR &&
+        interpolation != INTERPOLATION_NEAREST_POINT) {
+        LOG(ERROR) << "invalid interpolation: " << interpolation
+                   << ", valid value: INTERPOLATION_LINEAR, "
+                   << "INTERPOLATION_NEAREST_POINT.";
+        return false;
+    }
+
+    return true;
+}
+
+static bool checkInputData(const uchar* data, size_t size) {
+    if (data == nullptr || size == 0) {
+        LOG(ERROR) << "the input data is empty.";
+        return false;
+    }
+    if (size >= UINT32_MAX) {
+        LOG(ERROR) << "the input data is too big: " << size << " bytes.";
+        return false;
+    }
+
+    return true;
+}
+
+static bool checkBatch(int count, int threads) {
+    if (count <= 0) {
+        LOG(ERROR) << "invalid image count: " << count << ".";
+        return false;
+    }
+    if (threads < 0) {
+        LOG(ERROR) << "invalid thread count: " << threads
+                   << ", valid value: 0 or a positive number.";
+        return false;
+    }
+
+    return true;
+}
+
+/* Reads an image of a batch with the scratch of a worker. Files too small to
+ * be mapped are read into the block of the scratch, so a worker allocates
+ * nothing for them once its scratch has grown.
+ */
+static RetCode readBatchImage(DecoderScratch& scratch, const char* file_name,
+                              DecodedImage& image,
+                              const ImreadParams& params) {
+    if (file_name == nullptr) {
+        LOG(ERROR) << "the file name is empty.";
+        return RC_INVALID_VALUE;
+    }
+    uint8_t* block = (uint8_t*)scratch.reserve(READER_BLOCK, MIN_MAPPED_SIZE);
+    if (block == nullptr) {
+        return RC_OUT_OF_MEMORY;
+    }
+
+    FILE* fp = fopen(file_name, "rb");
+    if (fp == nullptr) {
+        LOG(ERROR) << "failed to open the input file: " << file_name;
+        return RC_OTHER_ERROR;
+    }
+
+    RetCode code;
+    MappedFile mapped_file;
+    if (mapped_file.map(fp)) {
+        BytesReader file_data(mapped_file.data(), mapped_file.size());
+        code = decodeImage(file_data, scratch, &image.height, &image.width,
+                           &image.channels, &image.stride, &image.image,
+                           params);
+    }
+    else {
+        BytesReader file_data(fp, block, MIN_MAPPED_SIZE);
+        code = decodeImage(file_data, scratch, &image.height, &image.width,
+                           &image.channels, &image.stride, &image.image,
+                           params);
+    }
+    mapped_file.unmap();
+    fclose(fp);
+
+    return code;
+}
+
+/* Runs decode(scratch, index) over the images of a batch on a pool of
+ * workers, the calling thread being one of them. The images are handed out
+ * one at a time, so a worker held up by a big image does not hold up the
+ * others, and the file reading of a worker overlaps the decoding of the
+ * others. Each worker keeps one scratch for all its images. With more than
+ * one worker the cores are already busy, and a decoder runs each image on the
+ * worker alone rather than starting threads of its own.
+ */
+template <typename Function>
+static RetCode runBatch(int count, int threads, DecodedImage* images,
+                        Function decode) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+        threads = threads == 0 ? 1 : threads;
+    }
+    threads = threads < count ? threads : count;
+
+    for (int index = 0; index < count; index++) {
+        images[index].height   = 0;
+        images[index].width    = 0;
+        images[index].channels = 0;
+        images[index].stride   = 0;
+        images[index].image    = nullptr;
+        images[index].status   = RC_OTHER_ERROR;
+    }
+
+    std::atomic<int> next_index(0);
+    auto work = [&]() {
+        DecoderScratch scratch;
+        if (threads > 1) {
+            scratch.setThreads(1);
+        }
+        for (int index = next_index++; index < count; index = next_index++) {
+            images[index].status = decode(scratch, index);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (int i = 1; i < threads; i++) {
+        workers.push_back(std::thread(work));
+    }
+    work();
+    for (auto &worker: workers) {
+        worker.join();
+    }
+
+    for (int index = 0; index < count; index++) {
+        if (images[index].status != RC_SUCCESS) {
+            return images[index].status;
+        }
+    }
+
+    return RC_SUCCESS;
+}
+
+DecoderContext::DecoderContext() {
+    scratch_ = new DecoderScratch();
+}
+
+DecoderContext::~DecoderContext() {
+    delete scratch_;
+}
+
+DecoderScratch* DecoderContext::scratch() const {
+    return scratch_;
+}
+
 RetCode Imread(const char* file_name, int* height, int* width, int* channels,
-               int* stride, uchar** image) {
+               int* stride, uchar** image, const ImreadParams& params) {
     assert(file_name != nullptr);
     assert(height != nullptr);
     assert(width != nullptr);
@@ -75,75 +774,361 @@ RetCode Imread(const char* file_name, int* height, int* width, int* channels,
     assert(stride != nullptr);
     assert(image != nullptr);
 
-    RetCode code = RC_SUCCESS;
+    if (!checkParams(params)) {
+        return RC_INVALID_VALUE;
+    }
+
     FILE* fp = fopen(file_name, "rb");
     if (fp == nullptr) {
         LOG(ERROR) << "failed to open the input file: " << file_name;
         return RC_OTHER_ERROR;
     }
 
-    BytesReader file_data(fp);
-    ImageFormats image_format;
-    bool succeeded = detectFormat(file_data, &image_format);
-    if (succeeded == false) {
-        if (image_format == UNSUPPORTED) {
-            LOG(ERROR) << "unsupported image format.";
-        }
-        fclose(fp);
-        return RC_OTHER_ERROR;
+    // a mapped file is decoded in place, otherwise it is read block by block.
+    RetCode code;
+    DecoderScratch scratch;
+    MappedFile mapped_file;
+    if (mapped_file.map(fp)) {
+        BytesReader file_data(mapped_file.data(), mapped_file.size());
+        code = decodeImage(file_data, scratch, height, width, channels, stride,
+                           image, params);
     }
+    else {
+        BytesReader file_data(fp);
+        code = decodeImage(file_data, scratch, height, width, channels, stride,
+                           image, params);
+    }
+    mapped_file.unmap();
+    fclose(fp);
 
-    ImageDecoder* decoder = nullptr;
-    if (image_format == BMP) {
-        decoder = new BmpDecoder(file_data);
+    return code;
+}
+
+RetCode Imread(DecoderContext* context, const char* file_name, int stride,
+               size_t capacity, uchar* image, int* height, int* width,
+               int* channels, const ImreadParams& params) {
+    assert(context != nullptr);
+    assert(file_name != nullptr);
+    assert(image != nullptr);
+    assert(height != nullptr);
+    assert(width != nullptr);
+    assert(channels != nullptr);
+
+    if (!checkParams(params)) {
+        return RC_INVALID_VALUE;
     }
-    else if (image_format == JPEG) {
-        decoder = new JpegDecoder(file_data);
+
+    DecoderScratch& scratch = *(context->scratch());
+    uint8_t* block = (uint8_t*)scratch.reserve(READER_BLOCK, MIN_MAPPED_SIZE);
+    if (block == nullptr) {
+        return RC_OUT_OF_MEMORY;
     }
-    else if (image_format == PNG) {
-        decoder = new PngDecoder(file_data);
+
+    FILE* fp = fopen(file_name, "rb");
+    if (fp == nullptr) {
+        LOG(ERROR) << "failed to open the input file: " << file_name;
+        return RC_OTHER_ERROR;
+    }
+
+    // files too small to be mapped fit in the block of the context.
+    RetCode code;
+    MappedFile mapped_file;
+    if (mapped_file.map(fp)) {
+        BytesReader file_data(mapped_file.data(), mapped_file.size());
+        code = decodeImage(file_data, scratch, stride, capacity, image, height,
+                           width, channels, params);
     }
     else {
+        BytesReader file_data(fp, block, MIN_MAPPED_SIZE);
+        code = decodeImage(file_data, scratch, stride, capacity, image, height,
+                           width, channels, params);
     }
+    mapped_file.unmap();
+    fclose(fp);
 
-    succeeded = decoder->readHeader();
-    if (succeeded == false) {
-        LOG(ERROR) << "failed to read file header.";
-        fclose(fp);
+    return code;
+}
+
+RetCode Imdecode(const uchar* data, size_t size, int* height, int* width,
+                 int* channels, int* stride, uchar** image,
+                 const ImreadParams& params) {
+    assert(height != nullptr);
+    assert(width != nullptr);
+    assert(channels != nullptr);
+    assert(stride != nullptr);
+    assert(image != nullptr);
+
+    if (!checkInputData(data, size) || !checkParams(params)) {
+        return RC_INVALID_VALUE;
+    }
+
+    DecoderScratch scratch;
+    BytesReader file_data(data, size);
+    RetCode code = decodeImage(file_data, scratch, height, width, channels,
+                               stride, image, params);
+
+    return code;
+}
+
+RetCode Imdecode(DecoderContext* context, const uchar* data, size_t size,
+                 int stride, size_t capacity, uchar* image, int* height,
+                 int* width, int* channels, const ImreadParams& params) {
+    assert(context != nullptr);
+    assert(image != nullptr);
+    assert(height != nullptr);
+    assert(width != nullptr);
+    assert(channels != nullptr);
+
+    if (!checkInputData(data, size) || !checkParams(params)) {
+        return RC_INVALID_VALUE;
+    }
+
+    BytesReader file_data(data, size);
+    RetCode code = decodeImage(file_data, *(context->scratch()), stride,
+                               capacity, image, height, width, channels,
+                               params);
+
+    return code;
+}
+
+RetCode ImreadHeader(const char* file_name, int* height, int* width,
+                     int* channels, int* depth, const ImreadParams& params) {
+    assert(file_name != nullptr);
+    assert(height != nullptr);
+    assert(width != nullptr);
+    assert(channels != nullptr);
+    assert(depth != nullptr);
+
+    if (!checkParams(params)) {
+        return RC_INVALID_VALUE;
+    }
+
+    FILE* fp = fopen(file_name, "rb");
+    if (fp == nullptr) {
+        LOG(ERROR) << "failed to open the input file: " << file_name;
         return RC_OTHER_ERROR;
     }
 
-    *height   = decoder->height();
-    *width    = decoder->width();
-    *channels = decoder->channels();
-    if (image_format == PNG) {
-        int bytes = (decoder->depth() == 16 ? 2 : 1);
-        *stride = (decoder->width() * decoder->channels() * bytes + 1 + 15) &
-                   -16;
+    // headers sit at the front of a file, a small window is enough to read
+    // them, and the segments behind are skipped by seeking.
+    RetCode code;
+    {
+        uint8_t buffer[MIN_BLOCK_SIZE];
+        DecoderScratch scratch;
+        BytesReader file_data(fp, buffer, MIN_BLOCK_SIZE);
+        code = readImageHeader(file_data, scratch, height, width, channels,
+                               depth, params);
+    }
+    fclose(fp);
+
+    return code;
+}
+
+RetCode ImdecodeHeader(const uchar* data, size_t size, int* height, int* width,
+                       int* channels, int* depth, const ImreadParams& params) {
+    assert(height != nullptr);
+    assert(width != nullptr);
+    assert(channels != nullptr);
+    assert(depth != nullptr);
+
+    if (!checkInputData(data, size) || !checkParams(params)) {
+        return RC_INVALID_VALUE;
+    }
+
+    DecoderScratch scratch;
+    BytesReader file_data(data, size);
+    RetCode code = readImageHeader(file_data, scratch, height, width, channels,
+                                   depth, params);
+
+    return code;
+}
+
+size_t ImreadBufferSize(int height, int width, int channels, int depth,
+                        int stride, ImreadModes mode) {
+    if (height <= 0 || width <= 0 || !checkMode(mode)) {
+        return 0;
+    }
+
+    if (mode == IMREAD_UNCHANGED) {
+        size_t row_bytes = (size_t)width * channels * (depth == 16 ? 2 : 1);
+        if ((size_t)stride < row_bytes) {
+            return 0;
+        }
+
+        return (size_t)stride * (height - 1) + row_bytes;
+    }
+
+    int min_stride = mode == IMREAD_GRAYSCALE ? width : ((width + 1) >> 1) * 2;
+    if (stride < min_stride) {
+        return 0;
+    }
+
+    return modeImageSize(mode, height, width, stride);
+}
+
+RetCode ImreadRegion(const char* file_name, int x, int y, int region_width,
+                     int region_height, int* height, int* width, int* channels,
+                     int* stride, uchar** image) {
+    assert(file_name != nullptr);
+    assert(height != nullptr);
+    assert(width != nullptr);
+    assert(channels != nullptr);
+    assert(stride != nullptr);
+    assert(image != nullptr);
+
+    if (!checkRegion(x, y, region_width, region_height)) {
+        return RC_INVALID_VALUE;
+    }
+
+    FILE* fp = fopen(file_name, "rb");
+    if (fp == nullptr) {
+        LOG(ERROR) << "failed to open the input file: " << file_name;
+        return RC_OTHER_ERROR;
+    }
+
+    RetCode code;
+    DecoderScratch scratch;
+    MappedFile mapped_file;
+    if (mapped_file.map(fp)) {
+        BytesReader file_data(mapped_file.data(), mapped_file.size());
+        code = decodeImageRegion(file_data, scratch, x, y, region_width,
+                                 region_height, height, width, channels,
+                                 stride, image);
     }
     else {
-        *stride = (decoder->width() * decoder->channels() + 3) & -4;
-    }
-    size_t size = (*stride) * (*height);
-    assert(size < MAX_IMAGE_SIZE);
-    (*image) = (uchar*)malloc(size);
-    if (*image == nullptr) {
-        LOG(ERROR) << "failed to allocate memory for the image.";
-        fclose(fp);
-        return RC_OUT_OF_MEMORY;
+        BytesReader file_data(fp);
+        code = decodeImageRegion(file_data, scratch, x, y, region_width,
+                                 region_height, height, width, channels,
+                                 stride, image);
     }
+    mapped_file.unmap();
+    fclose(fp);
 
-    succeeded = decoder->decodeData(*stride, (*image));
-    if (succeeded == false) {
-        LOG(ERROR) << "failed to decode the file data.";
-        fclose(fp);
+    return code;
+}
+
+RetCode ImdecodeRegion(const uchar* data, size_t size, int x, int y,
+                       int region_width, int region_height, int* height,
+                       int* width, int* channels, int* stride, uchar** image) {
+    assert(height != nullptr);
+    assert(width != nullptr);
+    assert(channels != nullptr);
+    assert(stride != nullptr);
+    assert(image != nullptr);
+
+    if (!checkInputData(data, size) ||
+        !checkRegion(x, y, region_width, region_height)) {
+        return RC_INVALID_VALUE;
+    }
+
+    DecoderScratch scratch;
+    BytesReader file_data(data, size);
+    RetCode code = decodeImageRegion(file_data, scratch, x, y, region_width,
+                                     region_height, height, width, channels,
+                                     stride, image);
+
+    return code;
+}
+
+RetCode ImreadResized(const char* file_name, int out_height, int out_width,
+                      InterpolationType interpolation, int* channels,
+                      int* stride, uchar** image) {
+    assert(file_name != nullptr);
+    assert(channels != nullptr);
+    assert(stride != nullptr);
+    assert(image != nullptr);
+
+    if (!checkResizing(out_height, out_width, interpolation)) {
+        return RC_INVALID_VALUE;
+    }
+
+    FILE* fp = fopen(file_name, "rb");
+    if (fp == nullptr) {
+        LOG(ERROR) << "failed to open the input file: " << file_name;
         return RC_OTHER_ERROR;
     }
+
+    RetCode code;
+    DecoderScratch scratch;
+    MappedFile mapped_file;
+    if (mapped_file.map(fp)) {
+        BytesReader file_data(mapped_file.data(), mapped_file.size());
+        code = decodeImageResized(file_data, scratch, out_height, out_width,
+                                  interpolation, channels, stride, image);
+    }
+    else {
+        BytesReader file_data(fp);
+        code = decodeImageResized(file_data, scratch, out_height, out_width,
+                                  interpolation, channels, stride, image);
+    }
+    mapped_file.unmap();
     fclose(fp);
 
     return code;
 }
 
+RetCode ImdecodeResized(const uchar* data, size_t size, int out_height,
+                        int out_width, InterpolationType interpolation,
+                        int* channels, int* stride, uchar** image) {
+    assert(channels != nullptr);
+    assert(stride != nullptr);
+    assert(image != nullptr);
+
+    if (!checkInputData(data, size) ||
+        !checkResizing(out_height, out_width, interpolation)) {
+        return RC_INVALID_VALUE;
+    }
+
+    DecoderScratch scratch;
+    BytesReader file_data(data, size);
+    RetCode code = decodeImageResized(file_data, scratch, out_height,
+                                      out_width, interpolation, channels,
+                                      stride, image);
+
+    return code;
+}
+
+RetCode ImreadBatch(const char* const* file_names, int count,
+                    DecodedImage* images, int threads,
+                    const ImreadParams& params) {
+    assert(file_names != nullptr);
+    assert(images != nullptr);
+
+    if (!checkBatch(count, threads) || !checkParams(params)) {
+        return RC_INVALID_VALUE;
+    }
+
+    return runBatch(count, threads, images,
+        [&](DecoderScratch& scratch, int index) -> RetCode {
+            return readBatchImage(scratch, file_names[index], images[index],
+                                  params);
+        });
+}
+
+RetCode ImdecodeBatch(const uchar* const* data, const size_t* sizes,
+                      int count, DecodedImage* images, int threads,
+                      const ImreadParams& params) {
+    assert(data != nullptr);
+    assert(sizes != nullptr);
+    assert(images != nullptr);
+
+    if (!checkBatch(count, threads) || !checkParams(params)) {
+        return RC_INVALID_VALUE;
+    }
+
+    return runBatch(count, threads, images,
+        [&](DecoderScratch& scratch, int index) -> RetCode {
+            if (!checkInputData(data[index], sizes[index])) {
+                return RC_INVALID_VALUE;
+            }
+            DecodedImage& image = images[index];
+            BytesReader file_data(data[index], sizes[index]);
+            return decodeImage(file_data, scratch, &image.height,
+                               &image.width, &image.channels, &image.stride,
+                               &image.image, params);
+        });
+}
+
 }  // namespace x86
 }  // namespace cv
 }  // namespace ppl
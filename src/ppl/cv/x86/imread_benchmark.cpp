@@ -21,8 +21,11 @@
 #include <sys/time.h>
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <assert.h>
 #include <string.h>
+#include <vector>
+#include <algorithm>
 
 #include "opencv2/imgproc.hpp"
 #include "opencv2/imgcodecs.hpp"
@@ -589,4 +592,384 @@ BENCHMARK_TEMPLATE(BM_ImreadPNG_ppl_x86, uchar)->Args({15})->UseManualTime();  \
 BENCHMARK_TEMPLATE(BM_ImreadPNG_opencv_x86, uchar)->Args({16});                \
 BENCHMARK_TEMPLATE(BM_ImreadPNG_ppl_x86, uchar)->Args({16})->UseManualTime();
 
-RUN_PNG_BENCHMARK(uchar)
\ No newline at end of file
+RUN_PNG_BENCHMARK(uchar)
+
+/*************************** Png filter benchmark ***************************/
+
+static void putBigEndianDWord(std::vector<uchar>& buffer, uint32_t value) {
+    buffer.push_back((uchar)(value >> 24));
+    buffer.push_back((uchar)(value >> 16));
+    buffer.push_back((uchar)(value >> 8));
+    buffer.push_back((uchar)value);
+}
+
+// bitwise crc of a chunk type and its data as in the PNG specification.
+static uint32_t computeChunkCrc(const uchar* data, size_t size) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (int j = 0; j < 8; j++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+
+    return crc ^ 0xFFFFFFFF;
+}
+
+static void putPngChunk(std::vector<uchar>& buffer, const char* type,
+                        const std::vector<uchar>& data) {
+    std::vector<uchar> chunk(type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    putBigEndianDWord(buffer, data.size());
+    buffer.insert(buffer.end(), chunk.begin(), chunk.end());
+    putBigEndianDWord(buffer, computeChunkCrc(chunk.data(), chunk.size()));
+}
+
+static int predictPaeth(int a, int b, int c) {
+    int p  = a + b - c;
+    int pa = abs(p - a);
+    int pb = abs(p - b);
+    int pc = abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    if (pb <= pc) return b;
+
+    return c;
+}
+
+/* encodes an 8-bit gray/gray-alpha/bgr/bgra image into a png with the given
+ * filter on every row, 5 cycles through the 5 filters row by row. The zlib
+ * stream holds stored blocks, so the scanlines reach the decoder unchanged.
+ */
+static void createFilteredPng(const cv::Mat& src, int filter,
+                              std::vector<uchar>& buffer) {
+    int channels  = src.channels();
+    int row_bytes = src.cols * channels;
+    std::vector<uchar> scanlines;
+    std::vector<uchar> prior(row_bytes, 0), current(row_bytes);
+    for (int row = 0; row < src.rows; row++) {
+        const uchar* data = src.ptr<uchar>(row);
+        for (int i = 0; i < row_bytes; i += channels) {
+            for (int j = 0; j < channels; j++) {
+                current[i + j] = (channels >= 3 && j < 3) ? data[i + 2 - j] :
+                                                            data[i + j];
+            }
+        }
+
+        int type = filter < 5 ? filter : row % 5;
+        scanlines.push_back((uchar)type);
+        for (int i = 0; i < row_bytes; i++) {
+            int a = i >= channels ? current[i - channels] : 0;
+            int b = prior[i];
+            int c = i >= channels ? prior[i - channels] : 0;
+            int predictions[5] = {0, a, b, (a + b) >> 1, predictPaeth(a, b, c)};
+            scanlines.push_back((uchar)(current[i] - predictions[type]));
+        }
+        prior.swap(current);
+    }
+
+    std::vector<uchar> stream = {0x78, 0x01};
+    uint32_t adler_a = 1, adler_b = 0;
+    for (size_t i = 0; i < scanlines.size(); i++) {
+        adler_a = (adler_a + scanlines[i]) % 65521;
+        adler_b = (adler_b + adler_a) % 65521;
+    }
+    size_t position = 0;
+    do {
+        size_t size = std::min(scanlines.size() - position, (size_t)65535);
+        bool is_final = (position + size == scanlines.size());
+        stream.push_back(is_final ? 1 : 0);
+        stream.push_back((uchar)size);
+        stream.push_back((uchar)(size >> 8));
+        stream.push_back((uchar)~size);
+        stream.push_back((uchar)(~size >> 8));
+        stream.insert(stream.end(), scanlines.begin() + position,
+                      scanlines.begin() + position + size);
+        position += size;
+    } while (position < scanlines.size());
+    putBigEndianDWord(stream, (adler_b << 16) | adler_a);
+
+    uchar color_types[5] = {0, 0, 4, 2, 6};
+    std::vector<uchar> header;
+    putBigEndianDWord(header, src.cols);
+    putBigEndianDWord(header, src.rows);
+    header.push_back(8);
+    header.push_back(color_types[channels]);
+    header.push_back(0);
+    header.push_back(0);
+    header.push_back(0);
+
+    const uchar signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    buffer.assign(signature, signature + 8);
+    putPngChunk(buffer, "IHDR", header);
+    putPngChunk(buffer, "IDAT", stream);
+    putPngChunk(buffer, "IEND", std::vector<uchar>());
+}
+
+template <int channels, int filter>
+void BM_ImdecodePngFilter_ppl_x86(benchmark::State &state) {
+    int width  = state.range(0);
+    int height = state.range(1);
+    cv::Mat src = createSourceImage(height, width,
+                                    CV_MAKETYPE(cv::DataType<uchar>::depth,
+                                    channels));
+    std::vector<uchar> buffer;
+    createFilteredPng(src, filter, buffer);
+    int channels0, stride;
+    uchar* image = nullptr;
+
+    struct timeval start, end;
+    for (auto _ : state) {
+        gettimeofday(&start, NULL);
+        ppl::cv::x86::Imdecode(buffer.data(), buffer.size(), &height, &width,
+                               &channels0, &stride, &image);
+        gettimeofday(&end, NULL);
+        int time = (end.tv_sec * 1000000 + end.tv_usec) -
+                   (start.tv_sec * 1000000 + start.tv_usec);
+        state.SetIterationTime(time * 1e-6);
+
+        if (image != nullptr) {
+            free(image);
+            image = nullptr;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * 1);
+}
+
+template <int channels, int filter>
+void BM_ImdecodePngFilter_opencv_x86(benchmark::State &state) {
+    int width  = state.range(0);
+    int height = state.range(1);
+    cv::Mat src = createSourceImage(height, width,
+                                    CV_MAKETYPE(cv::DataType<uchar>::depth,
+                                    channels));
+    std::vector<uchar> buffer;
+    createFilteredPng(src, filter, buffer);
+    for (auto _ : state) {
+        cv::Mat cv_dst = cv::imdecode(buffer, cv::IMREAD_UNCHANGED);
+    }
+    state.SetItemsProcessed(state.iterations() * 1);
+}
+
+#define RUN_PNG_FILTER_BENCHMARK(channels, filter)                             \
+BENCHMARK_TEMPLATE(BM_ImdecodePngFilter_opencv_x86, channels, filter)->         \
+                   Args({640, 480});                                           \
+BENCHMARK_TEMPLATE(BM_ImdecodePngFilter_ppl_x86, channels, filter)->            \
+                   Args({640, 480})->UseManualTime();                          \
+BENCHMARK_TEMPLATE(BM_ImdecodePngFilter_opencv_x86, channels, filter)->         \
+                   Args({1920, 1080});                                         \
+BENCHMARK_TEMPLATE(BM_ImdecodePngFilter_ppl_x86, channels, filter)->            \
+                   Args({1920, 1080})->UseManualTime();
+
+// filters 0-4 are None/Sub/Up/Average/Paeth.
+RUN_PNG_FILTER_BENCHMARK(1, 0)
+RUN_PNG_FILTER_BENCHMARK(1, 1)
+RUN_PNG_FILTER_BENCHMARK(1, 2)
+RUN_PNG_FILTER_BENCHMARK(1, 3)
+RUN_PNG_FILTER_BENCHMARK(1, 4)
+RUN_PNG_FILTER_BENCHMARK(2, 0)
+RUN_PNG_FILTER_BENCHMARK(2, 1)
+RUN_PNG_FILTER_BENCHMARK(2, 2)
+RUN_PNG_FILTER_BENCHMARK(2, 3)
+RUN_PNG_FILTER_BENCHMARK(2, 4)
+RUN_PNG_FILTER_BENCHMARK(3, 0)
+RUN_PNG_FILTER_BENCHMARK(3, 1)
+RUN_PNG_FILTER_BENCHMARK(3, 2)
+RUN_PNG_FILTER_BENCHMARK(3, 3)
+RUN_PNG_FILTER_BENCHMARK(3, 4)
+RUN_PNG_FILTER_BENCHMARK(4, 0)
+RUN_PNG_FILTER_BENCHMARK(4, 1)
+RUN_PNG_FILTER_BENCHMARK(4, 2)
+RUN_PNG_FILTER_BENCHMARK(4, 3)
+RUN_PNG_FILTER_BENCHMARK(4, 4)
+
+/************************** Decoding mode benchmark **************************/
+
+template <int mode>
+void BM_ImdecodeMode_ppl_x86(benchmark::State &state) {
+    int width  = state.range(0);
+    int height = state.range(1);
+    cv::Mat src = createSourceImage(height, width, CV_8UC3);
+    std::vector<uchar> buffer;
+    cv::imencode(".jpg", src, buffer);
+    int channels, stride;
+    uchar* image = nullptr;
+    ppl::cv::x86::ImreadParams params;
+    params.mode = (ppl::cv::ImreadModes)mode;
+
+    struct timeval start, end;
+    for (auto _ : state) {
+        gettimeofday(&start, NULL);
+        ppl::cv::x86::Imdecode(buffer.data(), buffer.size(), &height, &width,
+                               &channels, &stride, &image, params);
+        gettimeofday(&end, NULL);
+        int time = (end.tv_sec * 1000000 + end.tv_usec) -
+                   (start.tv_sec * 1000000 + start.tv_usec);
+        state.SetIterationTime(time * 1e-6);
+
+        if (image != nullptr) {
+            free(image);
+            image = nullptr;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * 1);
+}
+
+template <int mode>
+void BM_ImdecodeMode_opencv_x86(benchmark::State &state) {
+    int width  = state.range(0);
+    int height = state.range(1);
+    cv::Mat src = createSourceImage(height, width, CV_8UC3);
+    std::vector<uchar> buffer;
+    cv::imencode(".jpg", src, buffer);
+    for (auto _ : state) {
+        if (mode == ppl::cv::IMREAD_GRAYSCALE) {
+            cv::Mat cv_dst = cv::imdecode(buffer, cv::IMREAD_GRAYSCALE);
+        }
+        else {
+            cv::Mat cv_bgr = cv::imdecode(buffer, cv::IMREAD_COLOR);
+            cv::Mat cv_dst;
+            cv::cvtColor(cv_bgr, cv_dst, cv::COLOR_BGR2YUV_I420);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * 1);
+}
+
+#define RUN_MODE_BENCHMARK(mode)                                               \
+BENCHMARK_TEMPLATE(BM_ImdecodeMode_opencv_x86, mode)->Args({640, 480});        \
+BENCHMARK_TEMPLATE(BM_ImdecodeMode_ppl_x86, mode)->Args({640, 480})->          \
+                   UseManualTime();                                            \
+BENCHMARK_TEMPLATE(BM_ImdecodeMode_opencv_x86, mode)->Args({1920, 1080});      \
+BENCHMARK_TEMPLATE(BM_ImdecodeMode_ppl_x86, mode)->Args({1920, 1080})->        \
+                   UseManualTime();
+
+RUN_MODE_BENCHMARK(ppl::cv::IMREAD_GRAYSCALE)
+RUN_MODE_BENCHMARK(ppl::cv::IMREAD_I420)
+
+/************************* Resized decoding benchmark *************************/
+
+static const char* resized_extensions[] = {".jpg", ".png"};
+
+template <int format>
+void BM_ImdecodeResized_ppl_x86(benchmark::State &state) {
+    int width  = state.range(0);
+    int height = state.range(1);
+    cv::Mat src = createSourceImage(height, width, CV_8UC3);
+    std::vector<uchar> buffer;
+    cv::imencode(resized_extensions[format], src, buffer);
+    int channels, stride;
+    uchar* image = nullptr;
+
+    struct timeval start, end;
+    for (auto _ : state) {
+        gettimeofday(&start, NULL);
+        ppl::cv::x86::ImdecodeResized(buffer.data(), buffer.size(), 224, 224,
+                                      ppl::cv::INTERPOLATION_LINEAR,
+                                      &channels, &stride, &image);
+        gettimeofday(&end, NULL);
+        int time = (end.tv_sec * 1000000 + end.tv_usec) -
+                   (start.tv_sec * 1000000 + start.tv_usec);
+        state.SetIterationTime(time * 1e-6);
+
+        if (image != nullptr) {
+            free(image);
+            image = nullptr;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * 1);
+}
+
+template <int format>
+void BM_ImdecodeResized_opencv_x86(benchmark::State &state) {
+    int width  = state.range(0);
+    int height = state.range(1);
+    cv::Mat src = createSourceImage(height, width, CV_8UC3);
+    std::vector<uchar> buffer;
+    cv::imencode(resized_extensions[format], src, buffer);
+    for (auto _ : state) {
+        cv::Mat cv_image = cv::imdecode(buffer, cv::IMREAD_UNCHANGED);
+        cv::Mat cv_dst;
+        cv::resize(cv_image, cv_dst, cv::Size(224, 224), 0, 0,
+                   cv::INTER_LINEAR);
+    }
+    state.SetItemsProcessed(state.iterations() * 1);
+}
+
+#define RUN_RESIZED_BENCHMARK(format)                                          \
+BENCHMARK_TEMPLATE(BM_ImdecodeResized_opencv_x86, format)->Args({640, 480});   \
+BENCHMARK_TEMPLATE(BM_ImdecodeResized_ppl_x86, format)->Args({640, 480})->     \
+                   UseManualTime();                                            \
+BENCHMARK_TEMPLATE(BM_ImdecodeResized_opencv_x86, format)->                    \
+                   Args({1920, 1080});                                         \
+BENCHMARK_TEMPLATE(BM_ImdecodeResized_ppl_x86, format)->Args({1920, 1080})->   \
+                   UseManualTime();
+
+RUN_RESIZED_BENCHMARK(0)
+RUN_RESIZED_BENCHMARK(1)
+
+/************************** Batch decoding benchmark **************************/
+
+static void createBatchBuffers(int width, int height,
+                               std::vector<std::vector<uchar>>& buffers) {
+    cv::Mat src = createSourceImage(height, width, CV_8UC3);
+    buffers.resize(64);
+    for (size_t index = 0; index < buffers.size(); index++) {
+        cv::imencode(".jpg", src, buffers[index]);
+    }
+}
+
+template <int threads>
+void BM_ImdecodeBatch_ppl_x86(benchmark::State &state) {
+    int width  = state.range(0);
+    int height = state.range(1);
+    std::vector<std::vector<uchar>> buffers;
+    createBatchBuffers(width, height, buffers);
+    std::vector<const uchar*> data;
+    std::vector<size_t> sizes;
+    for (const std::vector<uchar>& buffer : buffers) {
+        data.push_back(buffer.data());
+        sizes.push_back(buffer.size());
+    }
+    std::vector<ppl::cv::x86::DecodedImage> images(buffers.size());
+
+    struct timeval start, end;
+    for (auto _ : state) {
+        gettimeofday(&start, NULL);
+        ppl::cv::x86::ImdecodeBatch(data.data(), sizes.data(), data.size(),
+                                    images.data(), threads);
+        gettimeofday(&end, NULL);
+        int time = (end.tv_sec * 1000000 + end.tv_usec) -
+                   (start.tv_sec * 1000000 + start.tv_usec);
+        state.SetIterationTime(time * 1e-6);
+
+        for (ppl::cv::x86::DecodedImage& image : images) {
+            free(image.image);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * buffers.size());
+}
+
+template <int threads>
+void BM_ImdecodeBatch_opencv_x86(benchmark::State &state) {
+    int width  = state.range(0);
+    int height = state.range(1);
+    std::vector<std::vector<uchar>> buffers;
+    createBatchBuffers(width, height, buffers);
+    for (auto _ : state) {
+        for (const std::vector<uchar>& buffer : buffers) {
+            cv::Mat cv_dst = cv::imdecode(buffer, cv::IMREAD_UNCHANGED);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * buffers.size());
+}
+
+#define RUN_BATCH_BENCHMARK(threads)                                           \
+BENCHMARK_TEMPLATE(BM_ImdecodeBatch_opencv_x86, threads)->Args({320, 240});    \
+BENCHMARK_TEMPLATE(BM_ImdecodeBatch_ppl_x86, threads)->Args({320, 240})->      \
+                   UseManualTime();                                            \
+BENCHMARK_TEMPLATE(BM_ImdecodeBatch_opencv_x86, threads)->Args({640, 480});    \
+BENCHMARK_TEMPLATE(BM_ImdecodeBatch_ppl_x86, threads)->Args({640, 480})->      \
+                   UseManualTime();
+
+RUN_BATCH_BENCHMARK(1)
+RUN_BATCH_BENCHMARK(4)
+RUN_BATCH_BENCHMARK(0)
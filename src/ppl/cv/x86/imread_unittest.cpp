@@ -16,15 +16,19 @@
 // under the License.
 
 #include "ppl/cv/x86/imread.h"
+#include "ppl/cv/x86/imwrite.h"
+#include "ppl/cv/x86/resize.h"
 
 #include <stdio.h>
 #include <assert.h>
 #include <string.h>
 #include <string>
+#include <vector>
 #include <assert.h>
 
 #include <tuple>
 #include <sstream>
+#include <algorithm>
 
 #include "opencv2/imgproc.hpp"
 #include "opencv2/imgcodecs.hpp"
@@ -502,6 +506,315 @@ INSTANTIATE_TEST_CASE_P(IsEqual, PplCvX86ImreadJpegTest0,
     }
 );
 
+using Parameters3 = std::tuple<int, int, cv::Size>;
+inline std::string convertToStringJpegScaled(const Parameters3& parameters) {
+    std::ostringstream formatted;
+
+    int channels = std::get<0>(parameters);
+    formatted << "Channels" << channels << "_";
+
+    int scale = std::get<1>(parameters);
+    formatted << "Scale" << scale << "_";
+
+    cv::Size size = std::get<2>(parameters);
+    formatted << size.width << "x";
+    formatted << size.height;
+
+    return formatted.str();
+}
+
+// the flag of cv::imread() decoding at 1/scale of the size.
+static int reducedFlag(int channels, int scale) {
+    if (scale == 2) {
+        return channels == 1 ? cv::IMREAD_REDUCED_GRAYSCALE_2 :
+                               cv::IMREAD_REDUCED_COLOR_2;
+    }
+    else if (scale == 4) {
+        return channels == 1 ? cv::IMREAD_REDUCED_GRAYSCALE_4 :
+                               cv::IMREAD_REDUCED_COLOR_4;
+    }
+    else {
+        return channels == 1 ? cv::IMREAD_REDUCED_GRAYSCALE_8 :
+                               cv::IMREAD_REDUCED_COLOR_8;
+    }
+}
+
+class PplCvX86ImreadJpegScaledTest :
+        public ::testing::TestWithParam<Parameters3> {
+  public:
+    PplCvX86ImreadJpegScaledTest() {
+        const Parameters3& parameters = GetParam();
+        channels = std::get<0>(parameters);
+        scale    = std::get<1>(parameters);
+        size     = std::get<2>(parameters);
+    }
+
+    ~PplCvX86ImreadJpegScaledTest() {
+    }
+
+    bool apply();
+
+  private:
+    int channels;
+    int scale;
+    cv::Size size;
+};
+
+bool PplCvX86ImreadJpegScaledTest::apply() {
+    cv::Mat src = createSourceImage(size.height, size.width,
+                                    CV_MAKETYPE(cv::DataType<uchar>::depth,
+                                    channels));
+    std::string file_name("test_scaled.jpeg");
+    bool succeeded = cv::imwrite(file_name.c_str(), src);
+    if (succeeded == false) {
+        std::cout << "failed to write the image to test_scaled.jpeg."
+                  << std::endl;
+        return false;
+    }
+
+    cv::Mat cv_dst = cv::imread(file_name, reducedFlag(channels, scale));
+
+    int height, width, channels, stride;
+    uchar* image;
+    ppl::cv::x86::ImreadParams params;
+    params.scaleDenominator = scale;
+    ppl::cv::x86::Imread(file_name.c_str(), &height, &width, &channels, &stride,
+                         &image, params);
+    int header_height, header_width, header_channels, depth;
+    ppl::cv::x86::ImreadHeader(file_name.c_str(), &header_height,
+                               &header_width, &header_channels, &depth, params);
+
+    float epsilon = EPSILON_3F;
+    bool identity = height == cv_dst.rows && width == cv_dst.cols &&
+                    header_height == height && header_width == width;
+    identity = identity && checkDataIdentity<uchar>(cv_dst.data, image, height,
+                                                    width, channels,
+                                                    cv_dst.step, stride,
+                                                    epsilon);
+
+    free(image);
+    int code = remove(file_name.c_str());
+    if (code != 0) {
+        std::cout << "failed to delete test_scaled.jpeg." << std::endl;
+    }
+
+    return identity;
+}
+
+TEST_P(PplCvX86ImreadJpegScaledTest, Standard) {
+    bool identity = this->apply();
+    EXPECT_TRUE(identity);
+}
+
+INSTANTIATE_TEST_CASE_P(IsEqual, PplCvX86ImreadJpegScaledTest,
+    ::testing::Combine(
+        ::testing::Values(1, 3),
+        ::testing::Values(2, 4, 8),
+        ::testing::Values(cv::Size{321, 240}, cv::Size{1283, 720},
+                          cv::Size{640, 480}, cv::Size{1920, 1080})),
+    [](const testing::TestParamInfo<PplCvX86ImreadJpegScaledTest::ParamType>&
+       info) {
+        return convertToStringJpegScaled(info.param);
+    }
+);
+
+inline std::string convertToStringJpegSampled(const Parameters3& parameters) {
+    std::ostringstream formatted;
+
+    int sampling = std::get<0>(parameters);
+    formatted << "Sampling" << sampling << "_";
+
+    int scale = std::get<1>(parameters);
+    formatted << "Scale" << scale << "_";
+
+    cv::Size size = std::get<2>(parameters);
+    formatted << size.width << "x";
+    formatted << size.height;
+
+    return formatted.str();
+}
+
+class PplCvX86ImdecodeJpegSampledTest :
+        public ::testing::TestWithParam<Parameters3> {
+  public:
+    PplCvX86ImdecodeJpegSampledTest() {
+        const Parameters3& parameters = GetParam();
+        sampling = std::get<0>(parameters);
+        scale    = std::get<1>(parameters);
+        size     = std::get<2>(parameters);
+    }
+
+    ~PplCvX86ImdecodeJpegSampledTest() {
+    }
+
+    bool apply();
+
+  private:
+    int sampling;
+    int scale;
+    cv::Size size;
+};
+
+/* cv::imwrite() only writes 4:2:0, the 4:2:2 image is encoded by Imencode().
+ * A 4:4:0 image takes the same blocks in each MCU as a 4:2:2 one, so its
+ * stream is made by swapping the sampling factors of the luma in the frame
+ * header, the size having as many MCUs in both.
+ */
+bool PplCvX86ImdecodeJpegSampledTest::apply() {
+    cv::Mat src = createSourceImage(size.height, size.width, CV_8UC3);
+    ppl::cv::x86::ImwriteParams write_params;
+    write_params.jpegSubsampling = ppl::cv::x86::JPEG_SUBSAMPLING_422;
+    size_t data_size;
+    uchar* data = nullptr;
+    ppl::common::RetCode code = ppl::cv::x86::Imencode(".jpg", src.rows,
+                                    src.cols, 3, src.step, src.data,
+                                    &data_size, &data, write_params);
+    if (code != ppl::common::RC_SUCCESS) {
+        return false;
+    }
+    std::vector<uchar> buffer(data, data + data_size);
+    free(data);
+    if (sampling == 440) {
+        size_t sof = 0;
+        while (sof + 12 < buffer.size() &&
+               (buffer[sof] != 0xFF || buffer[sof + 1] != 0xC0)) {
+            sof++;
+        }
+        if (sof + 12 >= buffer.size() || buffer[sof + 11] != 0x21) {
+            return false;
+        }
+        buffer[sof + 11] = 0x12;
+    }
+
+    cv::Mat cv_dst = cv::imdecode(buffer, reducedFlag(3, scale));
+
+    int height, width, channels, stride;
+    uchar* image = nullptr;
+    ppl::cv::x86::ImreadParams params;
+    params.scaleDenominator = scale;
+    code = ppl::cv::x86::Imdecode(buffer.data(), buffer.size(), &height,
+                                  &width, &channels, &stride, &image, params);
+    if (code != ppl::common::RC_SUCCESS) {
+        return false;
+    }
+
+    float epsilon = EPSILON_3F;
+    bool identity = height == cv_dst.rows && width == cv_dst.cols &&
+                    channels == 3;
+    identity = identity && checkDataIdentity<uchar>(cv_dst.data, image, height,
+                                                    width, channels,
+                                                    cv_dst.step, stride,
+                                                    epsilon);
+    free(image);
+
+    return identity;
+}
+
+TEST_P(PplCvX86ImdecodeJpegSampledTest, Standard) {
+    bool identity = this->apply();
+    EXPECT_TRUE(identity);
+}
+
+INSTANTIATE_TEST_CASE_P(IsEqual, PplCvX86ImdecodeJpegSampledTest,
+    ::testing::Combine(
+        ::testing::Values(422, 440),
+        ::testing::Values(2, 4, 8),
+        ::testing::Values(cv::Size{320, 240}, cv::Size{640, 480},
+                          cv::Size{1280, 720})),
+    [](const testing::TestParamInfo<PplCvX86ImdecodeJpegSampledTest::ParamType>&
+       info) {
+        return convertToStringJpegSampled(info.param);
+    }
+);
+
+inline std::string convertToStringJpegRestart(const Parameters3& parameters) {
+    std::ostringstream formatted;
+
+    int channels = std::get<0>(parameters);
+    formatted << "Channels" << channels << "_";
+
+    int interval = std::get<1>(parameters);
+    formatted << "Interval" << interval << "_";
+
+    cv::Size size = std::get<2>(parameters);
+    formatted << size.width << "x";
+    formatted << size.height;
+
+    return formatted.str();
+}
+
+class PplCvX86ImreadJpegRestartTest :
+        public ::testing::TestWithParam<Parameters3> {
+  public:
+    PplCvX86ImreadJpegRestartTest() {
+        const Parameters3& parameters = GetParam();
+        channels = std::get<0>(parameters);
+        interval = std::get<1>(parameters);
+        size     = std::get<2>(parameters);
+    }
+
+    ~PplCvX86ImreadJpegRestartTest() {
+    }
+
+    bool apply();
+
+  private:
+    int channels;
+    int interval;
+    cv::Size size;
+};
+
+bool PplCvX86ImreadJpegRestartTest::apply() {
+    cv::Mat src = createSourceImage(size.height, size.width,
+                                    CV_MAKETYPE(cv::DataType<uchar>::depth,
+                                    channels));
+    std::string file_name("test_restart.jpeg");
+    std::vector<int> params{cv::IMWRITE_JPEG_RST_INTERVAL, interval};
+    bool succeeded = cv::imwrite(file_name.c_str(), src, params);
+    if (succeeded == false) {
+        std::cout << "failed to write the image to test_restart.jpeg."
+                  << std::endl;
+        return false;
+    }
+
+    cv::Mat cv_dst = cv::imread(file_name, cv::IMREAD_UNCHANGED);
+
+    int height, width, channels, stride;
+    uchar* image;
+    ppl::cv::x86::Imread(file_name.c_str(), &height, &width, &channels, &stride,
+                         &image);
+
+    float epsilon = EPSILON_3F;
+    bool identity = checkDataIdentity<uchar>(cv_dst.data, image, height, width,
+                                             channels, cv_dst.step, stride,
+                                             epsilon);
+
+    free(image);
+    int code = remove(file_name.c_str());
+    if (code != 0) {
+        std::cout << "failed to delete test_restart.jpeg." << std::endl;
+    }
+
+    return identity;
+}
+
+TEST_P(PplCvX86ImreadJpegRestartTest, Standard) {
+    bool identity = this->apply();
+    EXPECT_TRUE(identity);
+}
+
+INSTANTIATE_TEST_CASE_P(IsEqual, PplCvX86ImreadJpegRestartTest,
+    ::testing::Combine(
+        ::testing::Values(1, 3),
+        ::testing::Values(1, 7, 64),
+        ::testing::Values(cv::Size{321, 240}, cv::Size{1283, 720},
+                          cv::Size{640, 480}, cv::Size{1920, 1080})),
+    [](const testing::TestParamInfo<PplCvX86ImreadJpegRestartTest::ParamType>&
+       info) {
+        return convertToStringJpegRestart(info.param);
+    }
+);
+
 class PplCvX86ImreadJpegTest1 : public ::testing::TestWithParam<Parameters1> {
   public:
     PplCvX86ImreadJpegTest1() {
@@ -724,3 +1037,1378 @@ INSTANTIATE_TEST_CASE_P(IsEqual, PplCvX86ImreadPngTest1 ## T,                  \
 );
 
 PNG_UNITTEST1(uchar)
+
+inline std::string convertToStringPngSplit(const Parameters3& parameters) {
+    std::ostringstream formatted;
+
+    int channels = std::get<0>(parameters);
+    formatted << "Channels" << channels << "_";
+
+    int split_size = std::get<1>(parameters);
+    formatted << "Split" << split_size << "_";
+
+    cv::Size size = std::get<2>(parameters);
+    formatted << size.width << "x";
+    formatted << size.height;
+
+    return formatted.str();
+}
+
+static uint32_t getBigEndianDWord(const uchar* data) {
+    return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) |
+           ((uint32_t)data[2] << 8) | (uint32_t)data[3];
+}
+
+static void putBigEndianDWord(std::vector<uchar>& buffer, uint32_t value) {
+    buffer.push_back((uchar)(value >> 24));
+    buffer.push_back((uchar)(value >> 16));
+    buffer.push_back((uchar)(value >> 8));
+    buffer.push_back((uchar)value);
+}
+
+// bitwise crc of a chunk type and its data as in the PNG specification.
+static uint32_t computeChunkCrc(const uchar* data, size_t size) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (int j = 0; j < 8; j++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+
+    return crc ^ 0xFFFFFFFF;
+}
+
+// repacks the zlib stream of the IDAT chunks into chunks of split_size bytes.
+static void splitIdatChunks(std::vector<uchar>& buffer, size_t split_size) {
+    std::vector<uchar> result(buffer.begin(), buffer.begin() + 8);
+    std::vector<uchar> stream;
+    size_t position = 8;
+    while (position + 12 <= buffer.size()) {
+        uint32_t length = getBigEndianDWord(&buffer[position]);
+        const uchar* type = &buffer[position + 4];
+        if (memcmp(type, "IDAT", 4) == 0) {
+            stream.insert(stream.end(), type + 4, type + 4 + length);
+        }
+        else {
+            if (memcmp(type, "IEND", 4) == 0) {
+                for (size_t i = 0; i < stream.size(); i += split_size) {
+                    size_t size = std::min(split_size, stream.size() - i);
+                    std::vector<uchar> chunk = {'I', 'D', 'A', 'T'};
+                    chunk.insert(chunk.end(), stream.begin() + i,
+                                 stream.begin() + i + size);
+                    putBigEndianDWord(result, size);
+                    result.insert(result.end(), chunk.begin(), chunk.end());
+                    putBigEndianDWord(result, computeChunkCrc(chunk.data(),
+                                                              chunk.size()));
+                }
+            }
+            result.insert(result.end(), buffer.begin() + position,
+                          buffer.begin() + position + length + 12);
+        }
+        position += length + 12;
+    }
+    buffer.swap(result);
+}
+
+class PplCvX86ImdecodePngSplitTest :
+        public ::testing::TestWithParam<Parameters3> {
+  public:
+    PplCvX86ImdecodePngSplitTest() {
+        const Parameters3& parameters = GetParam();
+        channels   = std::get<0>(parameters);
+        split_size = std::get<1>(parameters);
+        size       = std::get<2>(parameters);
+    }
+
+    ~PplCvX86ImdecodePngSplitTest() {
+    }
+
+    bool apply();
+
+  private:
+    int channels;
+    int split_size;
+    cv::Size size;
+};
+
+bool PplCvX86ImdecodePngSplitTest::apply() {
+    cv::Mat src = createSourceImage(size.height, size.width,
+                                    CV_MAKETYPE(cv::DataType<uchar>::depth,
+                                    channels));
+    // stored, fixed and dynamic huffman blocks.
+    int levels[3] = {0, 1, 9};
+    for (int i = 0; i < 3; i++) {
+        std::vector<uchar> buffer;
+        std::vector<int> parameters = {cv::IMWRITE_PNG_COMPRESSION, levels[i]};
+        bool succeeded = cv::imencode(".png", src, buffer, parameters);
+        if (succeeded == false) {
+            std::cout << "failed to encode the image to .png." << std::endl;
+            return false;
+        }
+        splitIdatChunks(buffer, split_size);
+
+        int height, width, channels, stride;
+        uchar* image = nullptr;
+        ppl::common::RetCode code = ppl::cv::x86::Imdecode(buffer.data(),
+                                        buffer.size(), &height, &width,
+                                        &channels, &stride, &image);
+        if (code != ppl::common::RC_SUCCESS) {
+            return false;
+        }
+
+        float epsilon = EPSILON_1F;
+        bool identity = checkDataIdentity<uchar>(src.data, image, height,
+                                                 width, channels, src.step,
+                                                 stride, epsilon);
+        free(image);
+        if (!identity) return false;
+    }
+
+    return true;
+}
+
+TEST_P(PplCvX86ImdecodePngSplitTest, Standard) {
+    bool identity = this->apply();
+    EXPECT_TRUE(identity);
+}
+
+INSTANTIATE_TEST_CASE_P(IsEqual, PplCvX86ImdecodePngSplitTest,
+    ::testing::Combine(
+        ::testing::Values(1, 3, 4),
+        ::testing::Values(1, 7, 4096),
+        ::testing::Values(cv::Size{321, 240}, cv::Size{640, 480})),
+    [](const testing::TestParamInfo<PplCvX86ImdecodePngSplitTest::ParamType>&
+       info) {
+        return convertToStringPngSplit(info.param);
+    }
+);
+
+TEST(PplCvX86ImdecodePngCrcTest, Standard) {
+    cv::Mat src = createSourceImage(240, 321, CV_8UC3);
+    std::vector<uchar> buffer;
+    cv::imencode(".png", src, buffer);
+
+    // corrupts the crc of the first IDAT chunk.
+    size_t offset = 8;
+    while (offset + 8 <= buffer.size() &&
+           memcmp(buffer.data() + offset + 4, "IDAT", 4) != 0) {
+        offset += getBigEndianDWord(buffer.data() + offset) + 12;
+    }
+    ASSERT_LE(offset + 12, buffer.size());
+    offset += getBigEndianDWord(buffer.data() + offset) + 8;
+    buffer[offset + 3] ^= 0xFF;
+
+    int height, width, channels, stride;
+    uchar* image = nullptr;
+    ppl::common::RetCode code = ppl::cv::x86::Imdecode(buffer.data(),
+                                    buffer.size(), &height, &width, &channels,
+                                    &stride, &image);
+    EXPECT_NE(code, ppl::common::RC_SUCCESS);
+
+    // trusted data decodes without the crc checking.
+    ppl::cv::x86::ImreadParams params;
+    params.checkCrc = false;
+    code = ppl::cv::x86::Imdecode(buffer.data(), buffer.size(), &height,
+                                  &width, &channels, &stride, &image, params);
+    ASSERT_EQ(code, ppl::common::RC_SUCCESS);
+    float epsilon = EPSILON_1F;
+    bool identity = checkDataIdentity<uchar>(src.data, image, height, width,
+                                             channels, src.step, stride,
+                                             epsilon);
+    free(image);
+    EXPECT_TRUE(identity);
+}
+
+using Parameters5 = std::tuple<int, int, int, cv::Size>;
+inline std::string convertToStringPngFilter(const Parameters5& parameters) {
+    std::ostringstream formatted;
+
+    int depth = std::get<0>(parameters);
+    formatted << "Depth" << (depth == CV_16U ? 16 : 8) << "_";
+
+    int channels = std::get<1>(parameters);
+    formatted << "Channels" << channels << "_";
+
+    int filter = std::get<2>(parameters);
+    formatted << "Filter" << filter << "_";
+
+    cv::Size size = std::get<3>(parameters);
+    formatted << size.width << "x";
+    formatted << size.height;
+
+    return formatted.str();
+}
+
+static void putPngChunk(std::vector<uchar>& buffer, const char* type,
+                        const std::vector<uchar>& data) {
+    std::vector<uchar> chunk(type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    putBigEndianDWord(buffer, data.size());
+    buffer.insert(buffer.end(), chunk.begin(), chunk.end());
+    putBigEndianDWord(buffer, computeChunkCrc(chunk.data(), chunk.size()));
+}
+
+static int predictPaeth(int a, int b, int c) {
+    int p  = a + b - c;
+    int pa = abs(p - a);
+    int pb = abs(p - b);
+    int pc = abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    if (pb <= pc) return b;
+
+    return c;
+}
+
+/* encodes an 8/16-bit gray/gray-alpha/bgr/bgra image into a png with the
+ * given filter on every row, 5 cycles through the 5 filters row by row. The
+ * zlib stream holds stored blocks, so the scanlines reach the decoder
+ * unchanged.
+ */
+static void createFilteredPng(const cv::Mat& src, int filter,
+                              std::vector<uchar>& buffer) {
+    int channels    = src.channels();
+    int bytes       = src.elemSize1();
+    int pixel_bytes = channels * bytes;
+    int row_bytes   = src.cols * pixel_bytes;
+    std::vector<uchar> scanlines;
+    std::vector<uchar> prior(row_bytes, 0), current(row_bytes);
+    for (int row = 0; row < src.rows; row++) {
+        const uchar* data = src.ptr<uchar>(row);
+        for (int i = 0; i < row_bytes; i += pixel_bytes) {
+            for (int j = 0; j < channels; j++) {
+                int channel = (channels >= 3 && j < 3) ? 2 - j : j;
+                uint32_t value = bytes == 2 ?
+                    ((const uint16_t*)(data + i))[channel] :
+                    data[i + channel];
+                // 16-bit samples are stored big-endian.
+                for (int k = 0; k < bytes; k++) {
+                    current[i + j * bytes + k] =
+                        (uchar)(value >> (8 * (bytes - 1 - k)));
+                }
+            }
+        }
+
+        int type = filter < 5 ? filter : row % 5;
+        scanlines.push_back((uchar)type);
+        for (int i = 0; i < row_bytes; i++) {
+            int a = i >= pixel_bytes ? current[i - pixel_bytes] : 0;
+            int b = prior[i];
+            int c = i >= pixel_bytes ? prior[i - pixel_bytes] : 0;
+            int predictions[5] = {0, a, b, (a + b) >> 1, predictPaeth(a, b, c)};
+            scanlines.push_back((uchar)(current[i] - predictions[type]));
+        }
+        prior.swap(current);
+    }
+
+    std::vector<uchar> stream = {0x78, 0x01};
+    uint32_t adler_a = 1, adler_b = 0;
+    for (size_t i = 0; i < scanlines.size(); i++) {
+        adler_a = (adler_a + scanlines[i]) % 65521;
+        adler_b = (adler_b + adler_a) % 65521;
+    }
+    size_t position = 0;
+    do {
+        size_t size = std::min(scanlines.size() - position, (size_t)65535);
+        bool is_final = (position + size == scanlines.size());
+        stream.push_back(is_final ? 1 : 0);
+        stream.push_back((uchar)size);
+        stream.push_back((uchar)(size >> 8));
+        stream.push_back((uchar)~size);
+        stream.push_back((uchar)(~size >> 8));
+        stream.insert(stream.end(), scanlines.begin() + position,
+                      scanlines.begin() + position + size);
+        position += size;
+    } while (position < scanlines.size());
+    putBigEndianDWord(stream, (adler_b << 16) | adler_a);
+
+    uchar color_types[5] = {0, 0, 4, 2, 6};
+    std::vector<uchar> header;
+    putBigEndianDWord(header, src.cols);
+    putBigEndianDWord(header, src.rows);
+    header.push_back(bytes * 8);
+    header.push_back(color_types[channels]);
+    header.push_back(0);
+    header.push_back(0);
+    header.push_back(0);
+
+    const uchar signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    buffer.assign(signature, signature + 8);
+    putPngChunk(buffer, "IHDR", header);
+    putPngChunk(buffer, "IDAT", stream);
+    putPngChunk(buffer, "IEND", std::vector<uchar>());
+}
+
+class PplCvX86ImdecodePngFilterTest :
+        public ::testing::TestWithParam<Parameters5> {
+  public:
+    PplCvX86ImdecodePngFilterTest() {
+        const Parameters5& parameters = GetParam();
+        depth    = std::get<0>(parameters);
+        channels = std::get<1>(parameters);
+        filter   = std::get<2>(parameters);
+        size     = std::get<3>(parameters);
+    }
+
+    ~PplCvX86ImdecodePngFilterTest() {
+    }
+
+    bool apply();
+
+  private:
+    int depth;
+    int channels;
+    int filter;
+    cv::Size size;
+};
+
+bool PplCvX86ImdecodePngFilterTest::apply() {
+    cv::Mat src;
+    if (depth == CV_16U) {
+        src.create(size.height, size.width, CV_MAKETYPE(CV_16U, channels));
+        cv::randu(src, cv::Scalar::all(0), cv::Scalar::all(65536));
+    }
+    else {
+        src = createSourceImage(size.height, size.width,
+                                CV_MAKETYPE(cv::DataType<uchar>::depth,
+                                channels));
+    }
+    std::vector<uchar> buffer;
+    createFilteredPng(src, filter, buffer);
+
+    int height, width, channels, stride;
+    uchar* image = nullptr;
+    ppl::common::RetCode code = ppl::cv::x86::Imdecode(buffer.data(),
+                                    buffer.size(), &height, &width, &channels,
+                                    &stride, &image);
+    if (code != ppl::common::RC_SUCCESS) {
+        return false;
+    }
+
+    bool identity;
+    float epsilon = EPSILON_1F;
+    if (depth == CV_16U) {
+        identity = checkDataIdentity<uint16_t>((uint16_t*)src.data,
+                                               (uint16_t*)image, height, width,
+                                               channels, src.step, stride,
+                                               epsilon);
+    }
+    else {
+        identity = checkDataIdentity<uchar>(src.data, image, height, width,
+                                            channels, src.step, stride,
+                                            epsilon);
+    }
+    free(image);
+
+    return identity;
+}
+
+TEST_P(PplCvX86ImdecodePngFilterTest, Standard) {
+    bool identity = this->apply();
+    EXPECT_TRUE(identity);
+}
+
+INSTANTIATE_TEST_CASE_P(IsEqual, PplCvX86ImdecodePngFilterTest,
+    ::testing::Combine(
+        ::testing::Values(CV_8U, CV_16U),
+        ::testing::Values(1, 2, 3, 4),
+        ::testing::Values(0, 1, 2, 3, 4, 5),
+        ::testing::Values(cv::Size{1, 1}, cv::Size{5, 2}, cv::Size{7, 3},
+                          cv::Size{37, 13}, cv::Size{321, 240})),
+    [](const testing::TestParamInfo<PplCvX86ImdecodePngFilterTest::ParamType>&
+       info) {
+        return convertToStringPngFilter(info.param);
+    }
+);
+
+/***************************** Imdecode unittest *****************************/
+
+using Parameters2 = std::tuple<std::string, int, cv::Size>;
+inline std::string convertToStringImdecode(const Parameters2& parameters) {
+    std::ostringstream formatted;
+
+    std::string extension = std::get<0>(parameters);
+    formatted << extension.substr(1) << "_";
+
+    int channels = std::get<1>(parameters);
+    formatted << "Channels" << channels << "_";
+
+    cv::Size size = std::get<2>(parameters);
+    formatted << size.width << "x";
+    formatted << size.height;
+
+    return formatted.str();
+}
+
+class PplCvX86ImdecodeTest : public ::testing::TestWithParam<Parameters2> {
+  public:
+    PplCvX86ImdecodeTest() {
+        const Parameters2& parameters = GetParam();
+        extension = std::get<0>(parameters);
+        channels  = std::get<1>(parameters);
+        size      = std::get<2>(parameters);
+    }
+
+    ~PplCvX86ImdecodeTest() {
+    }
+
+    bool apply();
+
+  private:
+    std::string extension;
+    int channels;
+    cv::Size size;
+};
+
+bool PplCvX86ImdecodeTest::apply() {
+    cv::Mat src = createSourceImage(size.height, size.width,
+                                    CV_MAKETYPE(cv::DataType<uchar>::depth,
+                                    channels));
+    std::vector<uchar> buffer;
+    bool succeeded = cv::imencode(extension, src, buffer);
+    if (succeeded == false) {
+        std::cout << "failed to encode the image to " << extension << "."
+                  << std::endl;
+        return false;
+    }
+
+    cv::Mat cv_dst = cv::imdecode(buffer, cv::IMREAD_UNCHANGED);
+
+    int header_height, header_width, header_channels, depth;
+    ppl::common::RetCode code = ppl::cv::x86::ImdecodeHeader(buffer.data(),
+                                    buffer.size(), &header_height,
+                                    &header_width, &header_channels, &depth);
+    if (code != ppl::common::RC_SUCCESS || header_height != cv_dst.rows ||
+        header_width != cv_dst.cols || header_channels != cv_dst.channels() ||
+        depth != 8) {
+        return false;
+    }
+
+    int height, width, channels, stride;
+    uchar* image = nullptr;
+    code = ppl::cv::x86::Imdecode(buffer.data(), buffer.size(), &height, &width,
+                                  &channels, &stride, &image);
+    if (code != ppl::common::RC_SUCCESS) {
+        return false;
+    }
+    if (height != cv_dst.rows || width != cv_dst.cols ||
+        channels != cv_dst.channels()) {
+        free(image);
+        return false;
+    }
+
+    float epsilon = extension == ".jpg" ? EPSILON_3F : EPSILON_1F;
+    bool identity = checkDataIdentity<uchar>(cv_dst.data, image, height, width,
+                                             channels, cv_dst.step, stride,
+                                             epsilon);
+    free(image);
+    if (identity == false) {
+        return false;
+    }
+
+    // the context is shared by all the cases, so its buffers are reused.
+    static ppl::cv::x86::DecoderContext context;
+    int tight_stride = header_width * header_channels;
+    std::vector<uchar> output((size_t)tight_stride * header_height);
+    code = ppl::cv::x86::Imdecode(&context, buffer.data(), buffer.size(),
+                                  tight_stride, output.size(), output.data(),
+                                  &height, &width, &channels);
+    if (code != ppl::common::RC_SUCCESS) {
+        return false;
+    }
+    identity = checkDataIdentity<uchar>(cv_dst.data, output.data(), height,
+                                        width, channels, cv_dst.step,
+                                        tight_stride, epsilon);
+
+    return identity;
+}
+
+TEST_P(PplCvX86ImdecodeTest, Standard) {
+    bool identity = this->apply();
+    EXPECT_TRUE(identity);
+}
+
+INSTANTIATE_TEST_CASE_P(IsEqual, PplCvX86ImdecodeTest,
+    ::testing::Combine(
+        ::testing::Values(".bmp", ".jpg", ".png"),
+        ::testing::Values(1, 3),
+        ::testing::Values(cv::Size{321, 240}, cv::Size{642, 480},
+                          cv::Size{1283, 720}, cv::Size{1976, 1080},
+                          cv::Size{320, 240}, cv::Size{640, 480},
+                          cv::Size{1280, 720}, cv::Size{1920, 1080})),
+    [](const testing::TestParamInfo<PplCvX86ImdecodeTest::ParamType>& info) {
+        return convertToStringImdecode(info.param);
+    }
+);
+
+TEST(PplCvX86ImdecodeInvalidTest, Standard) {
+    int height, width, channels, stride;
+    uchar* image = nullptr;
+    uchar data[4] = {0x42, 0x4D, 0x00, 0x00};
+
+    ppl::common::RetCode code = ppl::cv::x86::Imdecode(nullptr, 0, &height,
+                                    &width, &channels, &stride, &image);
+    EXPECT_EQ(code, ppl::common::RC_INVALID_VALUE);
+    int depth;
+    code = ppl::cv::x86::ImdecodeHeader(nullptr, 0, &height, &width, &channels,
+                                        &depth);
+    EXPECT_EQ(code, ppl::common::RC_INVALID_VALUE);
+    ppl::cv::x86::ImreadParams params;
+    params.scaleDenominator = 3;
+    code = ppl::cv::x86::Imdecode(data, 4, &height, &width, &channels, &stride,
+                                  &image, params);
+    EXPECT_EQ(code, ppl::common::RC_INVALID_VALUE);
+
+    // an output buffer too small for the image.
+    cv::Mat src = createSourceImage(48, 64, CV_8UC3);
+    std::vector<uchar> buffer;
+    cv::imencode(".png", src, buffer);
+    ppl::cv::x86::DecoderContext context;
+    std::vector<uchar> output(64 * 3 * 47);
+    code = ppl::cv::x86::Imdecode(&context, buffer.data(), buffer.size(),
+                                  64 * 3, output.size(), output.data(),
+                                  &height, &width, &channels);
+    EXPECT_EQ(code, ppl::common::RC_INVALID_VALUE);
+    EXPECT_EQ(height, 48);
+    EXPECT_EQ(width, 64);
+
+    // an unknown decoding mode, and an I420 image not fitting the buffer.
+    params.scaleDenominator = 1;
+    params.mode = (ppl::cv::ImreadModes)4;
+    code = ppl::cv::x86::Imdecode(buffer.data(), buffer.size(), &height,
+                                  &width, &channels, &stride, &image, params);
+    EXPECT_EQ(code, ppl::common::RC_INVALID_VALUE);
+    params.mode = ppl::cv::IMREAD_I420;
+    code = ppl::cv::x86::Imdecode(&context, buffer.data(), buffer.size(), 64,
+                                  64 * 72 - 1, output.data(), &height, &width,
+                                  &channels, params);
+    EXPECT_EQ(code, ppl::common::RC_INVALID_VALUE);
+
+    // a 16 bit image is only decoded unchanged.
+    cv::Mat src16(48, 64, CV_16UC3, cv::Scalar(1000, 2000, 3000));
+    cv::imencode(".ppm", src16, buffer);
+    params.mode = ppl::cv::IMREAD_GRAYSCALE;
+    code = ppl::cv::x86::Imdecode(buffer.data(), buffer.size(), &height,
+                                  &width, &channels, &stride, &image, params);
+    EXPECT_EQ(code, ppl::common::RC_UNSUPPORTED);
+    code = ppl::cv::x86::ImdecodeHeader(buffer.data(), buffer.size(), &height,
+                                        &width, &channels, &depth, params);
+    EXPECT_EQ(code, ppl::common::RC_UNSUPPORTED);
+
+    // a truncated bmp header.
+    code = ppl::cv::x86::Imdecode(data, 4, &height, &width, &channels, &stride,
+                                  &image);
+    EXPECT_NE(code, ppl::common::RC_SUCCESS);
+
+    // jpeg images cut in the headers and in the entropy-coded data.
+    cv::Mat src_jpeg = createSourceImage(480, 640, CV_8UC3);
+    cv::imencode(".jpg", src_jpeg, buffer);
+    size_t lengths[] = {40, 400, buffer.size() / 2, buffer.size() - 2};
+    for (size_t length : lengths) {
+        std::vector<uchar> truncated(buffer.begin(), buffer.begin() + length);
+        code = ppl::cv::x86::Imdecode(truncated.data(), truncated.size(),
+                                      &height, &width, &channels, &stride,
+                                      &image);
+        EXPECT_NE(code, ppl::common::RC_SUCCESS);
+    }
+}
+
+/************************** Region decoding unittest **************************/
+
+class PplCvX86ImdecodeRegionTest :
+        public ::testing::TestWithParam<Parameters2> {
+  public:
+    PplCvX86ImdecodeRegionTest() {
+        const Parameters2& parameters = GetParam();
+        extension = std::get<0>(parameters);
+        channels  = std::get<1>(parameters);
+        size      = std::get<2>(parameters);
+    }
+
+    ~PplCvX86ImdecodeRegionTest() {
+    }
+
+    bool apply();
+
+  private:
+    std::string extension;
+    int channels;
+    cv::Size size;
+};
+
+bool PplCvX86ImdecodeRegionTest::apply() {
+    cv::Mat src = createSourceImage(size.height, size.width,
+                                    CV_MAKETYPE(cv::DataType<uchar>::depth,
+                                    channels));
+    std::vector<uchar> buffer;
+    bool succeeded = cv::imencode(extension, src, buffer);
+    if (succeeded == false) {
+        std::cout << "failed to encode the image to " << extension << "."
+                  << std::endl;
+        return false;
+    }
+
+    cv::Mat cv_dst = cv::imdecode(buffer, cv::IMREAD_UNCHANGED);
+
+    // regions inside the image, on block boundaries and beyond the border.
+    cv::Rect regions[] = {
+        cv::Rect(0, 0, 64, 48),
+        cv::Rect(size.width / 3, size.height / 3, size.width / 4,
+                 size.height / 5),
+        cv::Rect(17, 9, 1, 1),
+        cv::Rect(size.width - 100, size.height - 70, 200, 200),
+    };
+
+    float epsilon = extension == ".jpg" ? EPSILON_3F : EPSILON_1F;
+    for (const cv::Rect& region : regions) {
+        int height, width, channels, stride;
+        uchar* image = nullptr;
+        ppl::common::RetCode code = ppl::cv::x86::ImdecodeRegion(buffer.data(),
+                                        buffer.size(), region.x, region.y,
+                                        region.width, region.height, &height,
+                                        &width, &channels, &stride, &image);
+        if (code != ppl::common::RC_SUCCESS) {
+            return false;
+        }
+
+        cv::Rect clipped = region & cv::Rect(0, 0, cv_dst.cols, cv_dst.rows);
+        if (height != clipped.height || width != clipped.width ||
+            channels != cv_dst.channels()) {
+            free(image);
+            return false;
+        }
+
+        cv::Mat cv_region = cv_dst(clipped);
+        bool identity = checkDataIdentity<uchar>(cv_region.data, image, height,
+                                                 width, channels, cv_region.step,
+                                                 stride, epsilon);
+        free(image);
+        if (identity == false) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+TEST_P(PplCvX86ImdecodeRegionTest, Standard) {
+    bool identity = this->apply();
+    EXPECT_TRUE(identity);
+}
+
+INSTANTIATE_TEST_CASE_P(IsEqual, PplCvX86ImdecodeRegionTest,
+    ::testing::Combine(
+        ::testing::Values(".bmp", ".jpg", ".png"),
+        ::testing::Values(1, 3),
+        ::testing::Values(cv::Size{321, 240}, cv::Size{1283, 720},
+                          cv::Size{640, 480}, cv::Size{1920, 1080})),
+    [](const testing::TestParamInfo<PplCvX86ImdecodeRegionTest::ParamType>&
+       info) {
+        return convertToStringImdecode(info.param);
+    }
+);
+
+TEST(PplCvX86ImdecodeRegionInvalidTest, Standard) {
+    int height, width, channels, stride;
+    uchar* image = nullptr;
+
+    cv::Mat src = createSourceImage(48, 64, CV_8UC3);
+    std::vector<uchar> buffer;
+    cv::imencode(".jpg", src, buffer);
+    ppl::common::RetCode code = ppl::cv::x86::ImdecodeRegion(buffer.data(),
+                                    buffer.size(), 0, 0, 0, 16, &height,
+                                    &width, &channels, &stride, &image);
+    EXPECT_EQ(code, ppl::common::RC_INVALID_VALUE);
+    code = ppl::cv::x86::ImdecodeRegion(buffer.data(), buffer.size(), -1, 0,
+                                        16, 16, &height, &width, &channels,
+                                        &stride, &image);
+    EXPECT_EQ(code, ppl::common::RC_INVALID_VALUE);
+    // a region entirely outside the image.
+    code = ppl::cv::x86::ImdecodeRegion(buffer.data(), buffer.size(), 64, 0,
+                                        16, 16, &height, &width, &channels,
+                                        &stride, &image);
+    EXPECT_EQ(code, ppl::common::RC_INVALID_VALUE);
+}
+
+/************************** Resized decoding unittest *************************/
+
+class PplCvX86ImdecodeResizedTest :
+        public ::testing::TestWithParam<Parameters2> {
+  public:
+    PplCvX86ImdecodeResizedTest() {
+        const Parameters2& parameters = GetParam();
+        extension = std::get<0>(parameters);
+        channels  = std::get<1>(parameters);
+        size      = std::get<2>(parameters);
+    }
+
+    ~PplCvX86ImdecodeResizedTest() {
+    }
+
+    bool apply();
+
+  private:
+    std::string extension;
+    int channels;
+    cv::Size size;
+};
+
+/* The resized image must be the one ResizeLinear()/ResizeNearestPoint() make
+ * from the image Imdecode() decodes with the scale ImdecodeResized() picks.
+ */
+static bool resizeDecodedImage(const uchar* data, size_t size, int out_height,
+                               int out_width,
+                               ppl::cv::InterpolationType interpolation,
+                               std::vector<uchar>& output) {
+    int height, width, channels, depth, stride;
+    ppl::common::RetCode code = ppl::cv::x86::ImdecodeHeader(data, size,
+                                    &height, &width, &channels, &depth);
+    if (code != ppl::common::RC_SUCCESS) {
+        return false;
+    }
+    int scale = 8;
+    while (scale > 1 && ((height + scale - 1) / scale < out_height ||
+                         (width + scale - 1) / scale < out_width)) {
+        scale >>= 1;
+    }
+
+    uchar* image = nullptr;
+    ppl::cv::x86::ImreadParams params;
+    params.scaleDenominator = scale;
+    code = ppl::cv::x86::Imdecode(data, size, &height, &width, &channels,
+                                  &stride, &image, params);
+    if (code != ppl::common::RC_SUCCESS) {
+        return false;
+    }
+    output.resize((size_t)out_height * out_width * channels);
+    int out_stride = out_width * channels;
+    if (interpolation == ppl::cv::INTERPOLATION_LINEAR) {
+        code = channels == 1 ?
+            ppl::cv::x86::ResizeLinear<uchar, 1>(height, width, stride, image,
+                out_height, out_width, out_stride, output.data()) :
+            ppl::cv::x86::ResizeLinear<uchar, 3>(height, width, stride, image,
+                out_height, out_width, out_stride, output.data());
+    }
+    else {
+        code = channels == 1 ?
+            ppl::cv::x86::ResizeNearestPoint<uchar, 1>(height, width, stride,
+                image, out_height, out_width, out_stride, output.data()) :
+            ppl::cv::x86::ResizeNearestPoint<uchar, 3>(height, width, stride,
+                image, out_height, out_width, out_stride, output.data());
+    }
+    free(image);
+
+    return code == ppl::common::RC_SUCCESS;
+}
+
+bool PplCvX86ImdecodeResizedTest::apply() {
+    cv::Mat src = createSourceImage(size.height, size.width,
+                                    CV_MAKETYPE(cv::DataType<uchar>::depth,
+                                    channels));
+    std::vector<uchar> buffer;
+    bool succeeded = cv::imencode(extension, src, buffer);
+    if (succeeded == false) {
+        std::cout << "failed to encode the image to " << extension << "."
+                  << std::endl;
+        return false;
+    }
+
+    // downscaling through the jpeg scales, a single pixel and upscaling.
+    cv::Size out_sizes[] = {
+        cv::Size(224, 224),
+        cv::Size(size.width / 3, size.height / 5),
+        cv::Size(1, 1),
+        cv::Size(size.width * 3 / 2, size.height + 7),
+    };
+    ppl::cv::InterpolationType interpolations[] = {
+        ppl::cv::INTERPOLATION_LINEAR,
+        ppl::cv::INTERPOLATION_NEAREST_POINT,
+    };
+
+    for (const cv::Size& out_size : out_sizes) {
+        for (ppl::cv::InterpolationType interpolation : interpolations) {
+            std::vector<uchar> expected;
+            if (!resizeDecodedImage(buffer.data(), buffer.size(),
+                                    out_size.height, out_size.width,
+                                    interpolation, expected)) {
+                return false;
+            }
+
+            int channels, stride;
+            uchar* image = nullptr;
+            ppl::common::RetCode code = ppl::cv::x86::ImdecodeResized(
+                                            buffer.data(), buffer.size(),
+                                            out_size.height, out_size.width,
+                                            interpolation, &channels, &stride,
+                                            &image);
+            if (code != ppl::common::RC_SUCCESS) {
+                return false;
+            }
+            if (channels != this->channels) {
+                free(image);
+                return false;
+            }
+
+            bool identity = checkDataIdentity<uchar>(expected.data(), image,
+                                out_size.height, out_size.width, channels,
+                                out_size.width * channels, stride, EPSILON_E6);
+            free(image);
+            if (identity == false) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+TEST_P(PplCvX86ImdecodeResizedTest, Standard) {
+    bool identity = this->apply();
+    EXPECT_TRUE(identity);
+}
+
+INSTANTIATE_TEST_CASE_P(IsEqual, PplCvX86ImdecodeResizedTest,
+    ::testing::Combine(
+        ::testing::Values(".bmp", ".jpg", ".png"),
+        ::testing::Values(1, 3),
+        ::testing::Values(cv::Size{321, 240}, cv::Size{1283, 720},
+                          cv::Size{640, 480}, cv::Size{1920, 1080})),
+    [](const testing::TestParamInfo<PplCvX86ImdecodeResizedTest::ParamType>&
+       info) {
+        return convertToStringImdecode(info.param);
+    }
+);
+
+TEST(PplCvX86ImdecodeResizedInvalidTest, Standard) {
+    int channels, stride;
+    uchar* image = nullptr;
+
+    cv::Mat src = createSourceImage(48, 64, CV_8UC3);
+    std::vector<uchar> buffer;
+    cv::imencode(".jpg", src, buffer);
+    ppl::common::RetCode code = ppl::cv::x86::ImdecodeResized(buffer.data(),
+                                    buffer.size(), 0, 16,
+                                    ppl::cv::INTERPOLATION_LINEAR, &channels,
+                                    &stride, &image);
+    EXPECT_EQ(code, ppl::common::RC_INVALID_VALUE);
+    // area interpolation is not available on x86.
+    code = ppl::cv::x86::ImdecodeResized(buffer.data(), buffer.size(), 16, 16,
+                                         ppl::cv::INTERPOLATION_AREA,
+                                         &channels, &stride, &image);
+    EXPECT_EQ(code, ppl::common::RC_INVALID_VALUE);
+
+    // a 16 bit image is not resized.
+    cv::Mat src16(48, 64, CV_16UC3, cv::Scalar(1000, 2000, 3000));
+    cv::imencode(".ppm", src16, buffer);
+    code = ppl::cv::x86::ImdecodeResized(buffer.data(), buffer.size(), 16, 16,
+                                         ppl::cv::INTERPOLATION_LINEAR,
+                                         &channels, &stride, &image);
+    EXPECT_EQ(code, ppl::common::RC_UNSUPPORTED);
+}
+
+/************************** Exif orientation unittest *************************/
+
+inline std::string convertToStringOrientation(const Parameters3& parameters) {
+    std::ostringstream formatted;
+
+    int channels = std::get<0>(parameters);
+    formatted << "Channels" << channels << "_";
+
+    int orientation = std::get<1>(parameters);
+    formatted << "Orientation" << orientation << "_";
+
+    cv::Size size = std::get<2>(parameters);
+    formatted << size.width << "x";
+    formatted << size.height;
+
+    return formatted.str();
+}
+
+// inserts an Exif APP1 segment carrying the orientation tag after SOI.
+static void insertExifOrientation(std::vector<uchar>& buffer, int orientation) {
+    const uchar segment[] = {
+        0xFF, 0xE1, 0x00, 0x22,                     // APP1, 34 bytes
+        'E', 'x', 'i', 'f', 0x00, 0x00,
+        'M', 'M', 0x00, 0x2A, 0x00, 0x00, 0x00, 0x08,  // big endian TIFF
+        0x00, 0x01,                                 // 1 entry in IFD0
+        0x01, 0x12, 0x00, 0x03, 0x00, 0x00, 0x00, 0x01,
+        0x00, (uchar)orientation, 0x00, 0x00,       // orientation, SHORT
+        0x00, 0x00, 0x00, 0x00,                     // no next IFD
+    };
+    buffer.insert(buffer.begin() + 2, segment, segment + sizeof(segment));
+}
+
+class PplCvX86ImdecodeOrientationTest :
+        public ::testing::TestWithParam<Parameters3> {
+  public:
+    PplCvX86ImdecodeOrientationTest() {
+        const Parameters3& parameters = GetParam();
+        channels    = std::get<0>(parameters);
+        orientation = std::get<1>(parameters);
+        size        = std::get<2>(parameters);
+    }
+
+    ~PplCvX86ImdecodeOrientationTest() {
+    }
+
+    bool apply();
+
+  private:
+    int channels;
+    int orientation;
+    cv::Size size;
+};
+
+bool PplCvX86ImdecodeOrientationTest::apply() {
+    cv::Mat src = createSourceImage(size.height, size.width,
+                                    CV_MAKETYPE(cv::DataType<uchar>::depth,
+                                    channels));
+    std::vector<uchar> buffer;
+    bool succeeded = cv::imencode(".jpg", src, buffer);
+    if (succeeded == false) {
+        std::cout << "failed to encode the image to .jpg." << std::endl;
+        return false;
+    }
+    insertExifOrientation(buffer, orientation);
+
+    // opencv turns the image upright unless IMREAD_IGNORE_ORIENTATION is set.
+    int flags = channels == 1 ? cv::IMREAD_GRAYSCALE : cv::IMREAD_COLOR;
+    cv::Mat cv_dst = cv::imdecode(buffer, flags);
+
+    int header_height, header_width, header_channels, depth;
+    ppl::cv::x86::ImreadParams params;
+    params.upright = true;
+    ppl::common::RetCode code = ppl::cv::x86::ImdecodeHeader(buffer.data(),
+                                    buffer.size(), &header_height,
+                                    &header_width, &header_channels, &depth,
+                                    params);
+    if (code != ppl::common::RC_SUCCESS || header_height != cv_dst.rows ||
+        header_width != cv_dst.cols) {
+        return false;
+    }
+
+    int height, width, channels, stride;
+    uchar* image = nullptr;
+    code = ppl::cv::x86::Imdecode(buffer.data(), buffer.size(), &height, &width,
+                                  &channels, &stride, &image, params);
+    if (code != ppl::common::RC_SUCCESS) {
+        return false;
+    }
+    if (height != cv_dst.rows || width != cv_dst.cols ||
+        channels != cv_dst.channels()) {
+        free(image);
+        return false;
+    }
+
+    float epsilon = EPSILON_3F;
+    bool identity = checkDataIdentity<uchar>(cv_dst.data, image, height, width,
+                                             channels, cv_dst.step, stride,
+                                             epsilon);
+    free(image);
+
+    return identity;
+}
+
+TEST_P(PplCvX86ImdecodeOrientationTest, Standard) {
+    bool identity = this->apply();
+    EXPECT_TRUE(identity);
+}
+
+INSTANTIATE_TEST_CASE_P(IsEqual, PplCvX86ImdecodeOrientationTest,
+    ::testing::Combine(
+        ::testing::Values(1, 3),
+        ::testing::Values(1, 2, 3, 4, 5, 6, 7, 8),
+        ::testing::Values(cv::Size{321, 240}, cv::Size{1283, 720},
+                          cv::Size{640, 480}, cv::Size{1920, 1080})),
+    [](const testing::TestParamInfo<PplCvX86ImdecodeOrientationTest::ParamType>&
+       info) {
+        return convertToStringOrientation(info.param);
+    }
+);
+
+/*************************** Decoding mode unittest ***************************/
+
+using Parameters4 = std::tuple<std::string, int, cv::Size>;
+inline std::string convertToStringMode(const Parameters4& parameters) {
+    std::ostringstream formatted;
+
+    std::string extension = std::get<0>(parameters);
+    formatted << extension.substr(1) << "_";
+
+    int mode = std::get<1>(parameters);
+    formatted << "Mode" << mode << "_";
+
+    cv::Size size = std::get<2>(parameters);
+    formatted << size.width << "x";
+    formatted << size.height;
+
+    return formatted.str();
+}
+
+// a smooth image, its jpeg chroma stays close to the chroma of its pixels.
+static cv::Mat createSmoothImage(int rows, int cols) {
+    cv::Mat image(rows, cols, CV_8UC3);
+    for (int row = 0; row < rows; row++) {
+        uchar* pixel = image.ptr<uchar>(row);
+        for (int col = 0; col < cols; col++) {
+            pixel[0] = (uchar)(col * 255 / cols);
+            pixel[1] = (uchar)(row * 255 / rows);
+            pixel[2] = (uchar)(128 + 100 * sin((row + col) / 24.0));
+            pixel += 3;
+        }
+    }
+
+    return image;
+}
+
+static float meanDifference(const cv::Mat& image0, const cv::Mat& image1) {
+    return cv::norm(image0, image1, cv::NORM_L1) / image0.total();
+}
+
+// the U and V planes following the Y plane of an I420/NV12 image.
+static void splitChroma(ppl::cv::ImreadModes mode, uchar* image, int height,
+                        int width, int stride, cv::Mat& u, cv::Mat& v) {
+    if (mode == ppl::cv::IMREAD_GRAYSCALE) {
+        return;
+    }
+
+    int chroma_height = (height + 1) / 2;
+    int chroma_width  = (width + 1) / 2;
+    uchar* chroma = image + (size_t)stride * height;
+    if (mode == ppl::cv::IMREAD_I420) {
+        u = cv::Mat(chroma_height, chroma_width, CV_8UC1, chroma, stride / 2);
+        v = cv::Mat(chroma_height, chroma_width, CV_8UC1,
+                    chroma + (size_t)(stride / 2) * chroma_height, stride / 2);
+    }
+    else {
+        std::vector<cv::Mat> planes;
+        cv::split(cv::Mat(chroma_height, chroma_width, CV_8UC2, chroma, stride),
+                  planes);
+        u = planes[0];
+        v = planes[1];
+    }
+}
+
+class PplCvX86ImdecodeModeTest :
+        public ::testing::TestWithParam<Parameters4> {
+  public:
+    PplCvX86ImdecodeModeTest() {
+        const Parameters4& parameters = GetParam();
+        extension = std::get<0>(parameters);
+        mode      = (ppl::cv::ImreadModes)std::get<1>(parameters);
+        size      = std::get<2>(parameters);
+    }
+
+    ~PplCvX86ImdecodeModeTest() {
+    }
+
+    bool apply();
+
+  private:
+    std::string extension;
+    ppl::cv::ImreadModes mode;
+    cv::Size size;
+};
+
+bool PplCvX86ImdecodeModeTest::apply() {
+    cv::Mat src = createSmoothImage(size.height, size.width);
+    std::vector<uchar> buffer;
+    bool succeeded = cv::imencode(extension, src, buffer);
+    if (succeeded == false) {
+        std::cout << "failed to encode the image to " << extension << "."
+                  << std::endl;
+        return false;
+    }
+
+    // the full range YCrCb of the decoded pixels, averaged over 2x2 pixels.
+    cv::Mat cv_gray = cv::imdecode(buffer, cv::IMREAD_GRAYSCALE);
+    cv::Mat cv_bgr = cv::imdecode(buffer, cv::IMREAD_COLOR);
+    cv::Mat cv_ycrcb, cv_padded, cv_halved;
+    cv::cvtColor(cv_bgr, cv_ycrcb, cv::COLOR_BGR2YCrCb);
+    cv::copyMakeBorder(cv_ycrcb, cv_padded, 0, size.height & 1, 0,
+                       size.width & 1, cv::BORDER_REPLICATE);
+    int chroma_height = (size.height + 1) / 2;
+    int chroma_width  = (size.width + 1) / 2;
+    cv::resize(cv_padded, cv_halved, cv::Size(chroma_width, chroma_height), 0,
+               0, cv::INTER_AREA);
+    std::vector<cv::Mat> cv_planes;
+    cv::split(cv_halved, cv_planes);
+
+    int height, width, channels, stride;
+    uchar* image = nullptr;
+    ppl::cv::x86::ImreadParams params;
+    params.mode = mode;
+    ppl::common::RetCode code = ppl::cv::x86::Imdecode(buffer.data(),
+                                    buffer.size(), &height, &width, &channels,
+                                    &stride, &image, params);
+    if (code != ppl::common::RC_SUCCESS) {
+        return false;
+    }
+    if (height != cv_gray.rows || width != cv_gray.cols || channels != 1) {
+        free(image);
+        return false;
+    }
+
+    float epsilon = extension == ".jpg" ? EPSILON_3F : EPSILON_1F;
+    bool identity = checkDataIdentity<uchar>(cv_gray.data, image, height,
+                                             width, 1, cv_gray.step, stride,
+                                             epsilon);
+    cv::Mat u, v;
+    splitChroma(mode, image, height, width, stride, u, v);
+    if (identity && mode != ppl::cv::IMREAD_GRAYSCALE) {
+        // the chroma of a jpeg image is averaged before the upsampling.
+        if (extension == ".jpg") {
+            identity = meanDifference(cv_planes[2], u) < 1.5f &&
+                       meanDifference(cv_planes[1], v) < 1.5f;
+        }
+        else {
+            identity = checkDataIdentity<uchar>(cv_planes[2].data, u.data,
+                           chroma_height, chroma_width, 1, cv_planes[2].step,
+                           u.step, epsilon) &&
+                       checkDataIdentity<uchar>(cv_planes[1].data, v.data,
+                           chroma_height, chroma_width, 1, cv_planes[1].step,
+                           v.step, epsilon);
+        }
+    }
+
+    // the tightest layout in a buffer of the exact size holds the same planes.
+    static ppl::cv::x86::DecoderContext context;
+    int tight_stride = mode == ppl::cv::IMREAD_GRAYSCALE ? width :
+                       chroma_width * 2;
+    int rows = mode == ppl::cv::IMREAD_GRAYSCALE ? height :
+               height + chroma_height;
+    std::vector<uchar> output((size_t)tight_stride * rows);
+    int header_height, header_width, header_channels, header_depth;
+    code = ppl::cv::x86::ImdecodeHeader(buffer.data(), buffer.size(),
+                                        &header_height, &header_width,
+                                        &header_channels, &header_depth,
+                                        params);
+    if (code != ppl::common::RC_SUCCESS || header_height != height ||
+        header_width != width || header_channels != 1 || header_depth != 8 ||
+        ppl::cv::x86::ImreadBufferSize(header_height, header_width,
+            header_channels, header_depth, tight_stride, mode) !=
+        output.size() ||
+        ppl::cv::x86::ImreadBufferSize(header_height, header_width,
+            header_channels, header_depth, tight_stride - 1, mode) != 0) {
+        free(image);
+        return false;
+    }
+    code = ppl::cv::x86::Imdecode(&context, buffer.data(), buffer.size(),
+                                  tight_stride, output.size(), output.data(),
+                                  &height, &width, &channels, params);
+    if (identity && code == ppl::common::RC_SUCCESS) {
+        cv::Mat y0(height, width, CV_8UC1, image, stride);
+        cv::Mat y1(height, width, CV_8UC1, output.data(), tight_stride);
+        identity = cv::norm(y0, y1, cv::NORM_INF) == 0;
+        if (identity && mode != ppl::cv::IMREAD_GRAYSCALE) {
+            cv::Mat u1, v1;
+            splitChroma(mode, output.data(), height, width, tight_stride, u1,
+                        v1);
+            identity = cv::norm(u, u1, cv::NORM_INF) == 0 &&
+                       cv::norm(v, v1, cv::NORM_INF) == 0;
+        }
+    }
+    else {
+        identity = false;
+    }
+    free(image);
+
+    return identity;
+}
+
+TEST_P(PplCvX86ImdecodeModeTest, Standard) {
+    bool identity = this->apply();
+    EXPECT_TRUE(identity);
+}
+
+INSTANTIATE_TEST_CASE_P(IsEqual, PplCvX86ImdecodeModeTest,
+    ::testing::Combine(
+        ::testing::Values(".bmp", ".jpg", ".png"),
+        ::testing::Values(ppl::cv::IMREAD_GRAYSCALE, ppl::cv::IMREAD_I420,
+                          ppl::cv::IMREAD_NV12),
+        ::testing::Values(cv::Size{321, 241}, cv::Size{1283, 720},
+                          cv::Size{640, 480}, cv::Size{1920, 1080})),
+    [](const testing::TestParamInfo<PplCvX86ImdecodeModeTest::ParamType>&
+       info) {
+        return convertToStringMode(info.param);
+    }
+);
+
+TEST(PplCvX86ImreadBufferSizeTest, Standard) {
+    // rows of 3 channels of 8 and 16 bits, the last one without padding.
+    EXPECT_EQ(ppl::cv::x86::ImreadBufferSize(5, 7, 3, 8, 24), 4 * 24 + 21u);
+    EXPECT_EQ(ppl::cv::x86::ImreadBufferSize(5, 7, 3, 16, 48), 4 * 48 + 42u);
+    EXPECT_EQ(ppl::cv::x86::ImreadBufferSize(5, 7, 3, 16, 41), 0u);
+
+    // a 7x5 image has chroma planes of 4x3.
+    EXPECT_EQ(ppl::cv::x86::ImreadBufferSize(5, 7, 1, 8, 8,
+              ppl::cv::IMREAD_GRAYSCALE), 4 * 8 + 7u);
+    EXPECT_EQ(ppl::cv::x86::ImreadBufferSize(5, 7, 1, 8, 8,
+              ppl::cv::IMREAD_I420), 5 * 8 + 5 * 4 + 4u);
+    EXPECT_EQ(ppl::cv::x86::ImreadBufferSize(5, 7, 1, 8, 8,
+              ppl::cv::IMREAD_NV12), 7 * 8 + 8u);
+    EXPECT_EQ(ppl::cv::x86::ImreadBufferSize(5, 7, 1, 8, 7,
+              ppl::cv::IMREAD_NV12), 0u);
+
+    EXPECT_EQ(ppl::cv::x86::ImreadBufferSize(0, 7, 3, 8, 24), 0u);
+    EXPECT_EQ(ppl::cv::x86::ImreadBufferSize(5, 7, 1, 8, 8,
+              (ppl::cv::ImreadModes)4), 0u);
+}
+
+/************************** Batch decoding unittest ***************************/
+
+class PplCvX86ImreadBatchTest : public ::testing::TestWithParam<int> {
+  public:
+    PplCvX86ImreadBatchTest() {
+        threads = GetParam();
+    }
+
+    ~PplCvX86ImreadBatchTest() {
+    }
+
+    bool apply();
+
+  private:
+    int threads;
+};
+
+/* Every image of the batch must be the one cv::imdecode() gives, and the
+ * broken one in the middle must fail alone.
+ */
+static bool checkBatchImages(const std::vector<std::vector<uchar>>& buffers,
+                             const std::vector<std::string>& extensions,
+                             size_t broken, ppl::common::RetCode code,
+                             std::vector<ppl::cv::x86::DecodedImage>& images) {
+    bool identity = true;
+    for (size_t index = 0; index < images.size(); index++) {
+        ppl::cv::x86::DecodedImage& image = images[index];
+        if (index == broken) {
+            identity = identity && code == image.status &&
+                       image.status != ppl::common::RC_SUCCESS &&
+                       image.image == nullptr;
+            continue;
+        }
+        if (image.status != ppl::common::RC_SUCCESS) {
+            identity = false;
+            continue;
+        }
+
+        cv::Mat cv_dst = cv::imdecode(buffers[index], cv::IMREAD_UNCHANGED);
+        float epsilon = extensions[index] == ".jpg" ? EPSILON_3F : EPSILON_1F;
+        if (image.height != cv_dst.rows || image.width != cv_dst.cols ||
+            image.channels != cv_dst.channels() ||
+            !checkDataIdentity<uchar>(cv_dst.data, image.image, image.height,
+                                      image.width, image.channels,
+                                      cv_dst.step, image.stride, epsilon)) {
+            identity = false;
+        }
+        free(image.image);
+    }
+
+    return identity;
+}
+
+bool PplCvX86ImreadBatchTest::apply() {
+    const char* formats[] = {".bmp", ".jpg", ".png"};
+    cv::Size sizes[] = {cv::Size(64, 48), cv::Size(321, 240),
+                        cv::Size(1283, 720), cv::Size(7, 5)};
+    std::vector<std::vector<uchar>> buffers;
+    std::vector<std::string> extensions;
+    for (int index = 0; index < 24; index++) {
+        cv::Size size = sizes[index % 4];
+        int channels = index % 2 == 0 ? 3 : 1;
+        cv::Mat src = createSourceImage(size.height, size.width,
+                                        CV_MAKETYPE(cv::DataType<uchar>::depth,
+                                        channels));
+        std::vector<uchar> buffer;
+        cv::imencode(formats[index % 3], src, buffer);
+        buffers.push_back(buffer);
+        extensions.push_back(formats[index % 3]);
+    }
+    size_t broken = buffers.size() / 2;
+    buffers[broken].resize(40);
+
+    std::vector<const uchar*> data;
+    std::vector<size_t> data_sizes;
+    std::vector<std::string> file_names;
+    for (size_t index = 0; index < buffers.size(); index++) {
+        data.push_back(buffers[index].data());
+        data_sizes.push_back(buffers[index].size());
+        file_names.push_back("test_batch" + std::to_string(index) +
+                             extensions[index]);
+        FILE* fp = fopen(file_names[index].c_str(), "wb");
+        if (fp == nullptr) {
+            std::cout << "failed to write " << file_names[index] << "."
+                      << std::endl;
+            return false;
+        }
+        fwrite(buffers[index].data(), 1, buffers[index].size(), fp);
+        fclose(fp);
+    }
+    std::vector<const char*> names;
+    for (const std::string& file_name : file_names) {
+        names.push_back(file_name.c_str());
+    }
+
+    std::vector<ppl::cv::x86::DecodedImage> images(buffers.size());
+    ppl::common::RetCode code = ppl::cv::x86::ImdecodeBatch(data.data(),
+                                    data_sizes.data(), data.size(),
+                                    images.data(), threads);
+    bool identity = checkBatchImages(buffers, extensions, broken, code,
+                                     images);
+
+    code = ppl::cv::x86::ImreadBatch(names.data(), names.size(),
+                                     images.data(), threads);
+    identity = checkBatchImages(buffers, extensions, broken, code, images) &&
+               identity;
+
+    for (const std::string& file_name : file_names) {
+        if (remove(file_name.c_str()) != 0) {
+            std::cout << "failed to delete " << file_name << "." << std::endl;
+        }
+    }
+
+    return identity;
+}
+
+TEST_P(PplCvX86ImreadBatchTest, Standard) {
+    bool identity = this->apply();
+    EXPECT_TRUE(identity);
+}
+
+INSTANTIATE_TEST_CASE_P(IsEqual, PplCvX86ImreadBatchTest,
+    ::testing::Values(1, 2, 4, 0),
+    [](const testing::TestParamInfo<PplCvX86ImreadBatchTest::ParamType>&
+       info) {
+        return "Threads" + std::to_string(info.param);
+    }
+);
+
+TEST(PplCvX86ImreadBatchInvalidTest, Standard) {
+    cv::Mat src = createSourceImage(48, 64, CV_8UC3);
+    std::vector<uchar> buffer;
+    cv::imencode(".png", src, buffer);
+    const uchar* data[] = {buffer.data()};
+    size_t sizes[] = {buffer.size()};
+    ppl::cv::x86::DecodedImage images[1];
+
+    ppl::common::RetCode code = ppl::cv::x86::ImdecodeBatch(data, sizes, 0,
+                                    images);
+    EXPECT_EQ(code, ppl::common::RC_INVALID_VALUE);
+    code = ppl::cv::x86::ImdecodeBatch(data, sizes, 1, images, -1);
+    EXPECT_EQ(code, ppl::common::RC_INVALID_VALUE);
+    ppl::cv::x86::ImreadParams params;
+    params.scaleDenominator = 3;
+    code = ppl::cv::x86::ImdecodeBatch(data, sizes, 1, images, 1, params);
+    EXPECT_EQ(code, ppl::common::RC_INVALID_VALUE);
+
+    // an empty buffer and a missing file fail as items of the batch.
+    sizes[0] = 0;
+    code = ppl::cv::x86::ImdecodeBatch(data, sizes, 1, images);
+    EXPECT_EQ(code, ppl::common::RC_INVALID_VALUE);
+    EXPECT_EQ(images[0].status, ppl::common::RC_INVALID_VALUE);
+    const char* names[] = {"test_batch_missing.png"};
+    code = ppl::cv::x86::ImreadBatch(names, 1, images);
+    EXPECT_EQ(code, ppl::common::RC_OTHER_ERROR);
+    EXPECT_EQ(images[0].image, nullptr);
+}
@@ -0,0 +1,281 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "ppl/cv/x86/imwrite.h"
+#include "imgcodecs/byteswriter.h"
+#include "imgcodecs/imagecodecs.h"
+#include "imgcodecs/png.h"
+#include "imgcodecs/jpeg.h"
+#include "imgcodecs/qoi.h"
+#include "imgcodecs/pnm.h"
+#include "imgcodecs/codecs.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <assert.h>
+
+#include "ppl/common/log.h"
+
+using namespace ppl::common;
+
+namespace ppl {
+namespace cv {
+namespace x86 {
+
+// the format is told by the extension, the part behind the last dot.
+static bool detectEncodeFormat(const char* name, ImageFormats* image_format) {
+    const char* extension = strrchr(name, '.');
+    *image_format = UNSUPPORTED;
+    if (extension == nullptr) {
+        LOG(ERROR) << "no extension in " << name << " to tell the format.";
+        return false;
+    }
+
+    char lower[8] = {0};
+    size_t length = strlen(extension + 1);
+    if (length < sizeof(lower)) {
+        for (size_t i = 0; i < length; i++) {
+            lower[i] = (char)tolower((unsigned char)extension[i + 1]);
+        }
+    }
+    if (strcmp(lower, "png") == 0) {
+        *image_format = PNG;
+        return true;
+    }
+    if (strcmp(lower, "jpg") == 0 || strcmp(lower, "jpeg") == 0) {
+        *image_format = JPEG;
+        return true;
+    }
+    if (strcmp(lower, "qoi") == 0) {
+        *image_format = QOI;
+        return true;
+    }
+    if (strcmp(lower, "pgm") == 0 || strcmp(lower, "ppm") == 0 ||
+        strcmp(lower, "pnm") == 0) {
+        *image_format = PNM;
+        return true;
+    }
+
+    LOG(ERROR) << "unsupported image format: " << extension;
+    return false;
+}
+
+static bool checkImage(int height, int width, int channels, int stride,
+                       const uchar* image) {
+    if (image == nullptr || height <= 0 || width <= 0 || channels <= 0) {
+        LOG(ERROR) << "invalid image: " << width << "x" << height << "x"
+                   << channels << ".";
+        return false;
+    }
+    if (stride < width * channels) {
+        LOG(ERROR) << "invalid stride: " << stride << ", less than "
+                   << width * channels << ".";
+        return false;
+    }
+    if ((uint64_t)height * width >= MAX_IMAGE_SIZE) {
+        LOG(ERROR) << "the image is too big: " << width << "x" << height
+                   << ".";
+        return false;
+    }
+
+    return true;
+}
+
+static bool checkParams(const ImwriteParams& params) {
+    if (params.pngCompression < PNG_COMPRESSION_STORED ||
+        params.pngCompression > PNG_COMPRESSION_BEST) {
+        LOG(ERROR) << "invalid png compression level: "
+                   << params.pngCompression << ", valid value: 0 ~ 9.";
+        return false;
+    }
+    if (params.pngStrategy < PNG_STRATEGY_DEFAULT ||
+        params.pngStrategy > PNG_STRATEGY_FIXED) {
+        LOG(ERROR) << "invalid png strategy: " << params.pngStrategy
+                   << ", valid value: 0 ~ 4.";
+        return false;
+    }
+    if (params.jpegQuality < 0 || params.jpegQuality > 100) {
+        LOG(ERROR) << "invalid jpeg quality: " << params.jpegQuality
+                   << ", valid value: 0 ~ 100.";
+        return false;
+    }
+    if (params.jpegSubsampling < JPEG_SUBSAMPLING_420 ||
+        params.jpegSubsampling > JPEG_SUBSAMPLING_444) {
+        LOG(ERROR) << "invalid jpeg subsampling: " << params.jpegSubsampling
+                   << ", valid value: 0 ~ 2.";
+        return false;
+    }
+    if (params.jpegRestartInterval < 0 ||
+        params.jpegRestartInterval > 65535) {
+        LOG(ERROR) << "invalid jpeg restart interval: "
+                   << params.jpegRestartInterval << ", valid value: 0 ~ 65535.";
+        return false;
+    }
+
+    return true;
+}
+
+static RetCode runEncoder(BytesWriter& file_data, ImageEncoder& encoder,
+                          int height, int width, int channels, int stride,
+                          const uchar* image) {
+    if (!encoder.isChannelsSupported(channels)) {
+        LOG(ERROR) << "unsupported channels of the format: " << channels
+                   << ".";
+        return RC_INVALID_VALUE;
+    }
+
+    bool succeeded = encoder.encodeData(height, width, channels, stride,
+                                        image);
+    file_data.writeBlock();
+    if (!succeeded || !file_data.isGood()) {
+        LOG(ERROR) << "failed to encode the image.";
+        return RC_OTHER_ERROR;
+    }
+
+    return RC_SUCCESS;
+}
+
+static RetCode encodeImage(BytesWriter& file_data, ImageFormats image_format,
+                           int height, int width, int channels, int stride,
+                           const uchar* image, const ImwriteParams& params) {
+    if (!file_data.isGood()) {
+        LOG(ERROR) << "failed to allocate the buffer of the writer.";
+        return RC_OUT_OF_MEMORY;
+    }
+
+    if (image_format == JPEG) {
+        if (height > 65535 || width > 65535) {
+            LOG(ERROR) << "the image is too big for jpeg: " << width << "x"
+                       << height << ", valid value: 1 ~ 65535.";
+            return RC_INVALID_VALUE;
+        }
+        JpegEncoder encoder(file_data, params.jpegQuality,
+                            params.jpegSubsampling, params.jpegRestartInterval,
+                            params.jpegOptimize);
+        return runEncoder(file_data, encoder, height, width, channels, stride,
+                          image);
+    }
+    else if (image_format == QOI) {
+        QoiEncoder encoder(file_data);
+        return runEncoder(file_data, encoder, height, width, channels, stride,
+                          image);
+    }
+    else if (image_format == PNM) {
+        PnmEncoder encoder(file_data);
+        return runEncoder(file_data, encoder, height, width, channels, stride,
+                          image);
+    }
+
+    PngEncoder encoder(file_data, params.pngCompression, params.pngStrategy);
+    return runEncoder(file_data, encoder, height, width, channels, stride,
+                      image);
+}
+
+RetCode Imwrite(const char* file_name, int height, int width, int channels,
+                int stride, const uchar* image, const ImwriteParams& params) {
+    assert(file_name != nullptr);
+
+    ImageFormats image_format;
+    if (!detectEncodeFormat(file_name, &image_format) ||
+        !checkImage(height, width, channels, stride, image) ||
+        !checkParams(params)) {
+        return RC_INVALID_VALUE;
+    }
+
+    FILE* fp = fopen(file_name, "wb");
+    if (fp == nullptr) {
+        LOG(ERROR) << "failed to open the output file: " << file_name;
+        return RC_OTHER_ERROR;
+    }
+
+    RetCode code;
+    {
+        BytesWriter file_data(fp);
+        code = encodeImage(file_data, image_format, height, width, channels,
+                           stride, image, params);
+    }
+    if (fclose(fp) != 0 && code == RC_SUCCESS) {
+        LOG(ERROR) << "failed to close the output file: " << file_name;
+        code = RC_OTHER_ERROR;
+    }
+
+    return code;
+}
+
+RetCode Imencode(const char* extension, int height, int width, int channels,
+                 int stride, const uchar* image, size_t* size, uchar** data,
+                 const ImwriteParams& params) {
+    assert(extension != nullptr);
+    assert(size != nullptr);
+    assert(data != nullptr);
+
+    ImageFormats image_format;
+    if (!detectEncodeFormat(extension, &image_format) ||
+        !checkImage(height, width, channels, stride, image) ||
+        !checkParams(params)) {
+        return RC_INVALID_VALUE;
+    }
+
+    BytesWriter file_data;
+    RetCode code = encodeImage(file_data, image_format, height, width,
+                               channels, stride, image, params);
+    if (code != RC_SUCCESS) {
+        return code;
+    }
+    *data = file_data.detach(size);
+
+    return RC_SUCCESS;
+}
+
+RetCode Imencode(const char* extension, int height, int width, int channels,
+                 int stride, const uchar* image, size_t capacity, uchar* data,
+                 size_t* size, const ImwriteParams& params) {
+    assert(extension != nullptr);
+    assert(data != nullptr);
+    assert(size != nullptr);
+
+    ImageFormats image_format;
+    if (!detectEncodeFormat(extension, &image_format) ||
+        !checkImage(height, width, channels, stride, image) ||
+        !checkParams(params)) {
+        return RC_INVALID_VALUE;
+    }
+
+    BytesWriter file_data(data, capacity);
+    if (!file_data.isGood()) {
+        LOG(ERROR) << "invalid output buffer capacity: " << capacity << ".";
+        return RC_INVALID_VALUE;
+    }
+    RetCode code = encodeImage(file_data, image_format, height, width,
+                               channels, stride, image, params);
+    if (file_data.isFull()) {
+        LOG(ERROR) << "the output buffer of " << capacity
+                   << " bytes is too small for the encoded image.";
+        return RC_INVALID_VALUE;
+    }
+    if (code != RC_SUCCESS) {
+        return code;
+    }
+    *size = file_data.getPosition();
+
+    return RC_SUCCESS;
+}
+
+} //! namespace x86
+} //! namespace cv
+} //! namespace ppl
@@ -0,0 +1,244 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "ppl/cv/x86/imwrite.h"
+
+#include <time.h>
+#include <sys/time.h>
+
+#include <stdlib.h>
+#include <vector>
+
+#include "opencv2/imgproc.hpp"
+#include "opencv2/imgcodecs.hpp"
+#include "benchmark/benchmark.h"
+
+#include "ppl/cv/debug.h"
+#include "ppl/cv/cuda/utility/infrastructure.hpp"
+
+using namespace ppl::cv::debug;
+
+// blurred noise with a flat rectangle, closer to photos and masks than noise.
+static cv::Mat createEncodingImage(int height, int width, int channels) {
+    cv::Mat src = createSourceImage(height, width,
+                                    CV_MAKETYPE(cv::DataType<uchar>::depth,
+                                    channels));
+    cv::Mat dst;
+    cv::GaussianBlur(src, dst, cv::Size(5, 5), 0);
+    cv::Rect flat(width / 4, height / 4, (width + 1) / 2, (height + 1) / 2);
+    dst(flat).setTo(cv::Scalar::all(128));
+
+    return dst;
+}
+
+/***************************** Png benchmark *****************************/
+
+template <int channels, int level>
+void BM_ImencodePng_ppl_x86(benchmark::State &state) {
+    int width  = state.range(0);
+    int height = state.range(1);
+    cv::Mat src = createEncodingImage(height, width, channels);
+    ppl::cv::x86::ImwriteParams params;
+    params.pngCompression = level;
+    size_t size;
+    uchar* data = nullptr;
+
+    struct timeval start, end;
+    for (auto _ : state) {
+        gettimeofday(&start, NULL);
+        ppl::cv::x86::Imencode(".png", src.rows, src.cols, channels, src.step,
+                               src.data, &size, &data, params);
+        gettimeofday(&end, NULL);
+        int time = (end.tv_sec * 1000000 + end.tv_usec) -
+                   (start.tv_sec * 1000000 + start.tv_usec);
+        state.SetIterationTime(time * 1e-6);
+
+        if (data != nullptr) {
+            free(data);
+            data = nullptr;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * 1);
+}
+
+template <int channels, int level>
+void BM_ImencodePng_opencv_x86(benchmark::State &state) {
+    int width  = state.range(0);
+    int height = state.range(1);
+    cv::Mat src = createEncodingImage(height, width, channels);
+    std::vector<int> params{cv::IMWRITE_PNG_COMPRESSION, level};
+    std::vector<uchar> buffer;
+
+    for (auto _ : state) {
+        cv::imencode(".png", src, buffer, params);
+    }
+    state.SetItemsProcessed(state.iterations() * 1);
+}
+
+#define RUN_PNG_BENCHMARK(channels, level)                                     \
+BENCHMARK_TEMPLATE(BM_ImencodePng_opencv_x86, channels, level)->               \
+                   Args({640, 480});                                           \
+BENCHMARK_TEMPLATE(BM_ImencodePng_ppl_x86, channels, level)->                  \
+                   Args({640, 480})->UseManualTime();                          \
+BENCHMARK_TEMPLATE(BM_ImencodePng_opencv_x86, channels, level)->               \
+                   Args({1920, 1080});                                         \
+BENCHMARK_TEMPLATE(BM_ImencodePng_ppl_x86, channels, level)->                  \
+                   Args({1920, 1080})->UseManualTime();
+
+RUN_PNG_BENCHMARK(1, 1)
+RUN_PNG_BENCHMARK(1, 6)
+RUN_PNG_BENCHMARK(3, 1)
+RUN_PNG_BENCHMARK(3, 6)
+RUN_PNG_BENCHMARK(4, 1)
+RUN_PNG_BENCHMARK(4, 6)
+
+/***************************** Jpeg benchmark *****************************/
+
+template <int channels, int quality>
+void BM_ImencodeJpeg_ppl_x86(benchmark::State &state) {
+    int width  = state.range(0);
+    int height = state.range(1);
+    cv::Mat src = createEncodingImage(height, width, channels);
+    ppl::cv::x86::ImwriteParams params;
+    params.jpegQuality = quality;
+    size_t size;
+    uchar* data = nullptr;
+
+    struct timeval start, end;
+    for (auto _ : state) {
+        gettimeofday(&start, NULL);
+        ppl::cv::x86::Imencode(".jpg", src.rows, src.cols, channels, src.step,
+                               src.data, &size, &data, params);
+        gettimeofday(&end, NULL);
+        int time = (end.tv_sec * 1000000 + end.tv_usec) -
+                   (start.tv_sec * 1000000 + start.tv_usec);
+        state.SetIterationTime(time * 1e-6);
+
+        if (data != nullptr) {
+            free(data);
+            data = nullptr;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * 1);
+}
+
+template <int channels, int quality>
+void BM_ImencodeJpeg_opencv_x86(benchmark::State &state) {
+    int width  = state.range(0);
+    int height = state.range(1);
+    cv::Mat src = createEncodingImage(height, width, channels);
+    std::vector<int> params{cv::IMWRITE_JPEG_QUALITY, quality};
+    std::vector<uchar> buffer;
+
+    for (auto _ : state) {
+        cv::imencode(".jpg", src, buffer, params);
+    }
+    state.SetItemsProcessed(state.iterations() * 1);
+}
+
+#define RUN_JPEG_BENCHMARK(channels, quality)                                  \
+BENCHMARK_TEMPLATE(BM_ImencodeJpeg_opencv_x86, channels, quality)->            \
+                   Args({640, 480});                                           \
+BENCHMARK_TEMPLATE(BM_ImencodeJpeg_ppl_x86, channels, quality)->               \
+                   Args({640, 480})->UseManualTime();                          \
+BENCHMARK_TEMPLATE(BM_ImencodeJpeg_opencv_x86, channels, quality)->            \
+                   Args({1920, 1080});                                         \
+BENCHMARK_TEMPLATE(BM_ImencodeJpeg_ppl_x86, channels, quality)->               \
+                   Args({1920, 1080})->UseManualTime();
+
+RUN_JPEG_BENCHMARK(1, 75)
+RUN_JPEG_BENCHMARK(1, 95)
+RUN_JPEG_BENCHMARK(3, 75)
+RUN_JPEG_BENCHMARK(3, 95)
+
+/************************** Qoi and Pnm benchmark **************************/
+
+template <int channels>
+void BM_ImencodeQoi_ppl_x86(benchmark::State &state) {
+    int width  = state.range(0);
+    int height = state.range(1);
+    cv::Mat src = createEncodingImage(height, width, channels);
+    size_t capacity = (size_t)height * width * (channels + 1) + 22;
+    std::vector<uchar> buffer(capacity);
+    size_t size;
+
+    struct timeval start, end;
+    for (auto _ : state) {
+        gettimeofday(&start, NULL);
+        ppl::cv::x86::Imencode(".qoi", src.rows, src.cols, channels, src.step,
+                               src.data, capacity, buffer.data(), &size);
+        gettimeofday(&end, NULL);
+        int time = (end.tv_sec * 1000000 + end.tv_usec) -
+                   (start.tv_sec * 1000000 + start.tv_usec);
+        state.SetIterationTime(time * 1e-6);
+    }
+    state.SetItemsProcessed(state.iterations() * 1);
+}
+
+template <int channels>
+void BM_ImencodePnm_ppl_x86(benchmark::State &state) {
+    int width  = state.range(0);
+    int height = state.range(1);
+    cv::Mat src = createEncodingImage(height, width, channels);
+    size_t capacity = (size_t)height * width * channels + 32;
+    std::vector<uchar> buffer(capacity);
+    size_t size;
+
+    struct timeval start, end;
+    for (auto _ : state) {
+        gettimeofday(&start, NULL);
+        ppl::cv::x86::Imencode(".ppm", src.rows, src.cols, channels, src.step,
+                               src.data, capacity, buffer.data(), &size);
+        gettimeofday(&end, NULL);
+        int time = (end.tv_sec * 1000000 + end.tv_usec) -
+                   (start.tv_sec * 1000000 + start.tv_usec);
+        state.SetIterationTime(time * 1e-6);
+    }
+    state.SetItemsProcessed(state.iterations() * 1);
+}
+
+template <int channels>
+void BM_ImencodePnm_opencv_x86(benchmark::State &state) {
+    int width  = state.range(0);
+    int height = state.range(1);
+    cv::Mat src = createEncodingImage(height, width, channels);
+    std::vector<uchar> buffer;
+
+    for (auto _ : state) {
+        cv::imencode(channels == 1 ? ".pgm" : ".ppm", src, buffer);
+    }
+    state.SetItemsProcessed(state.iterations() * 1);
+}
+
+#define RUN_QOI_BENCHMARK(channels)                                            \
+BENCHMARK_TEMPLATE(BM_ImencodeQoi_ppl_x86, channels)->Args({640, 480})->       \
+                   UseManualTime();                                            \
+BENCHMARK_TEMPLATE(BM_ImencodeQoi_ppl_x86, channels)->Args({1920, 1080})->     \
+                   UseManualTime();
+
+#define RUN_PNM_BENCHMARK(channels)                                            \
+BENCHMARK_TEMPLATE(BM_ImencodePnm_opencv_x86, channels)->Args({640, 480});     \
+BENCHMARK_TEMPLATE(BM_ImencodePnm_ppl_x86, channels)->Args({640, 480})->       \
+                   UseManualTime();                                            \
+BENCHMARK_TEMPLATE(BM_ImencodePnm_opencv_x86, channels)->Args({1920, 1080});   \
+BENCHMARK_TEMPLATE(BM_ImencodePnm_ppl_x86, channels)->Args({1920, 1080})->     \
+                   UseManualTime();
+
+RUN_QOI_BENCHMARK(3)
+RUN_QOI_BENCHMARK(4)
+RUN_PNM_BENCHMARK(1)
+RUN_PNM_BENCHMARK(3)
@@ -0,0 +1,686 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "ppl/cv/x86/imwrite.h"
+#include "ppl/cv/x86/imread.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <string>
+#include <vector>
+
+#include <tuple>
+#include <sstream>
+
+#include "opencv2/imgproc.hpp"
+#include "opencv2/imgcodecs.hpp"
+#include "gtest/gtest.h"
+
+#include "ppl/cv/cuda/utility/infrastructure.hpp"
+
+/* Random pixels do not compress, the source is blurred and has a flat
+ * rectangle, so that both the literals and the matches are exercised.
+ */
+static cv::Mat createEncodingImage(int height, int width, int channels) {
+    cv::Mat src = createSourceImage(height, width,
+                                    CV_MAKETYPE(cv::DataType<uchar>::depth,
+                                    channels));
+    cv::Mat dst;
+    cv::GaussianBlur(src, dst, cv::Size(5, 5), 0);
+    cv::Rect flat(width / 4, height / 4, (width + 1) / 2, (height + 1) / 2);
+    dst(flat).setTo(cv::Scalar::all(128));
+
+    return dst;
+}
+
+static bool checkEncodedImage(const cv::Mat& src, const uchar* data,
+                              size_t size) {
+    std::vector<uchar> buffer(data, data + size);
+    cv::Mat cv_dst = cv::imdecode(buffer, cv::IMREAD_UNCHANGED);
+    if (cv_dst.rows != src.rows || cv_dst.cols != src.cols ||
+        cv_dst.channels() != src.channels()) {
+        return false;
+    }
+    bool identity = checkMatricesIdentity<uchar>(src, cv_dst, EPSILON_1F);
+    if (identity == false) {
+        return false;
+    }
+
+    int height, width, channels, stride;
+    uchar* image = nullptr;
+    ppl::common::RetCode code = ppl::cv::x86::Imdecode(data, size, &height,
+                                    &width, &channels, &stride, &image);
+    if (code != ppl::common::RC_SUCCESS) {
+        return false;
+    }
+    if (height != src.rows || width != src.cols ||
+        channels != src.channels()) {
+        free(image);
+        return false;
+    }
+    cv::Mat ppl_dst(height, width, src.type(), image, stride);
+    identity = checkMatricesIdentity<uchar>(src, ppl_dst, EPSILON_1F);
+    free(image);
+
+    return identity;
+}
+
+/***************************** Png unittest *****************************/
+
+using Parameters0 = std::tuple<int, int, cv::Size>;
+inline std::string convertToStringPng(const Parameters0& parameters) {
+    std::ostringstream formatted;
+
+    int channels = std::get<0>(parameters);
+    formatted << "Channels" << channels << "_";
+
+    int level = std::get<1>(parameters);
+    formatted << "Level" << level << "_";
+
+    cv::Size size = std::get<2>(parameters);
+    formatted << size.width << "x";
+    formatted << size.height;
+
+    return formatted.str();
+}
+
+class PplCvX86ImencodePngTest : public ::testing::TestWithParam<Parameters0> {
+  public:
+    PplCvX86ImencodePngTest() {
+        const Parameters0& parameters = GetParam();
+        channels = std::get<0>(parameters);
+        level    = std::get<1>(parameters);
+        size     = std::get<2>(parameters);
+    }
+
+    ~PplCvX86ImencodePngTest() {
+    }
+
+    bool apply();
+
+  private:
+    int channels;
+    int level;
+    cv::Size size;
+};
+
+bool PplCvX86ImencodePngTest::apply() {
+    cv::Mat src = createEncodingImage(size.height, size.width, channels);
+
+    ppl::cv::x86::ImwriteParams params;
+    params.pngCompression = level;
+    size_t data_size;
+    uchar* data = nullptr;
+    ppl::common::RetCode code = ppl::cv::x86::Imencode(".png", src.rows,
+                                    src.cols, channels, src.step, src.data,
+                                    &data_size, &data, params);
+    if (code != ppl::common::RC_SUCCESS) {
+        return false;
+    }
+
+    bool identity = checkEncodedImage(src, data, data_size);
+    free(data);
+
+    return identity;
+}
+
+TEST_P(PplCvX86ImencodePngTest, Standard) {
+    bool identity = this->apply();
+    EXPECT_TRUE(identity);
+}
+
+INSTANTIATE_TEST_CASE_P(IsEqual, PplCvX86ImencodePngTest,
+    ::testing::Combine(
+        ::testing::Values(1, 3, 4),
+        ::testing::Values(0, 1, 2, 4, 6, 9),
+        ::testing::Values(cv::Size{1, 1}, cv::Size{7, 3}, cv::Size{37, 13},
+                          cv::Size{321, 240}, cv::Size{1283, 720})),
+    [](const testing::TestParamInfo<PplCvX86ImencodePngTest::ParamType>&
+       info) {
+        return convertToStringPng(info.param);
+    }
+);
+
+using Parameters1 = std::tuple<int, int, cv::Size>;
+inline std::string convertToStringStrategy(const Parameters1& parameters) {
+    std::ostringstream formatted;
+
+    int channels = std::get<0>(parameters);
+    formatted << "Channels" << channels << "_";
+
+    int strategy = std::get<1>(parameters);
+    formatted << "Strategy" << strategy << "_";
+
+    cv::Size size = std::get<2>(parameters);
+    formatted << size.width << "x";
+    formatted << size.height;
+
+    return formatted.str();
+}
+
+class PplCvX86ImwritePngStrategyTest :
+        public ::testing::TestWithParam<Parameters1> {
+  public:
+    PplCvX86ImwritePngStrategyTest() {
+        const Parameters1& parameters = GetParam();
+        channels = std::get<0>(parameters);
+        strategy = std::get<1>(parameters);
+        size     = std::get<2>(parameters);
+    }
+
+    ~PplCvX86ImwritePngStrategyTest() {
+    }
+
+    bool apply();
+
+  private:
+    int channels;
+    int strategy;
+    cv::Size size;
+};
+
+bool PplCvX86ImwritePngStrategyTest::apply() {
+    cv::Mat src = createEncodingImage(size.height, size.width, channels);
+
+    // a padded stride.
+    int stride = size.width * channels + 3;
+    std::vector<uchar> image((size_t)stride * size.height);
+    for (int row = 0; row < size.height; row++) {
+        memcpy(image.data() + (size_t)row * stride, src.ptr<uchar>(row),
+               size.width * channels);
+    }
+
+    ppl::cv::x86::ImwriteParams params;
+    params.pngCompression = ppl::cv::x86::PNG_COMPRESSION_DEFAULT;
+    params.pngStrategy = strategy;
+    std::string file_name = "imwrite_strategy.png";
+    ppl::common::RetCode code = ppl::cv::x86::Imwrite(file_name.c_str(),
+                                    size.height, size.width, channels, stride,
+                                    image.data(), params);
+    if (code != ppl::common::RC_SUCCESS) {
+        return false;
+    }
+
+    FILE* fp = fopen(file_name.c_str(), "rb");
+    if (fp == nullptr) {
+        return false;
+    }
+    fseek(fp, 0, SEEK_END);
+    size_t file_size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    std::vector<uchar> buffer(file_size);
+    size_t read_size = fread(buffer.data(), 1, file_size, fp);
+    fclose(fp);
+    remove(file_name.c_str());
+    if (read_size != file_size) {
+        return false;
+    }
+
+    bool identity = checkEncodedImage(src, buffer.data(), file_size);
+
+    return identity;
+}
+
+TEST_P(PplCvX86ImwritePngStrategyTest, Standard) {
+    bool identity = this->apply();
+    EXPECT_TRUE(identity);
+}
+
+INSTANTIATE_TEST_CASE_P(IsEqual, PplCvX86ImwritePngStrategyTest,
+    ::testing::Combine(
+        ::testing::Values(1, 3, 4),
+        ::testing::Values(0, 1, 2, 3, 4),
+        ::testing::Values(cv::Size{37, 13}, cv::Size{640, 480})),
+    [](const testing::TestParamInfo<PplCvX86ImwritePngStrategyTest::ParamType>&
+       info) {
+        return convertToStringStrategy(info.param);
+    }
+);
+
+/***************************** Jpeg unittest *****************************/
+
+/* JPEG is lossy, the decoded image is compared by its PSNR. Alpha of 4
+ * channels is dropped by the encoder.
+ */
+static bool checkEncodedJpeg(const cv::Mat& src, const uchar* data,
+                             size_t size, double min_psnr, cv::Mat* decoded) {
+    std::vector<uchar> buffer(data, data + size);
+    cv::Mat cv_dst = cv::imdecode(buffer, cv::IMREAD_UNCHANGED);
+    int channels = src.channels() == 4 ? 3 : src.channels();
+    if (cv_dst.rows != src.rows || cv_dst.cols != src.cols ||
+        cv_dst.channels() != channels) {
+        return false;
+    }
+
+    cv::Mat expected = src;
+    if (src.channels() == 4) {
+        cv::cvtColor(src, expected, cv::COLOR_BGRA2BGR);
+    }
+    if (decoded != nullptr) {
+        *decoded = cv_dst;
+    }
+
+    return cv::PSNR(expected, cv_dst) >= min_psnr;
+}
+
+using Parameters2 = std::tuple<int, int, int, cv::Size>;
+inline std::string convertToStringJpeg(const Parameters2& parameters) {
+    std::ostringstream formatted;
+
+    int channels = std::get<0>(parameters);
+    formatted << "Channels" << channels << "_";
+
+    int subsampling = std::get<1>(parameters);
+    formatted << "Subsampling" << subsampling << "_";
+
+    int quality = std::get<2>(parameters);
+    formatted << "Quality" << quality << "_";
+
+    cv::Size size = std::get<3>(parameters);
+    formatted << size.width << "x";
+    formatted << size.height;
+
+    return formatted.str();
+}
+
+class PplCvX86ImencodeJpegTest : public ::testing::TestWithParam<Parameters2> {
+  public:
+    PplCvX86ImencodeJpegTest() {
+        const Parameters2& parameters = GetParam();
+        channels    = std::get<0>(parameters);
+        subsampling = std::get<1>(parameters);
+        quality     = std::get<2>(parameters);
+        size        = std::get<3>(parameters);
+    }
+
+    ~PplCvX86ImencodeJpegTest() {
+    }
+
+    bool apply();
+
+  private:
+    int channels;
+    int subsampling;
+    int quality;
+    cv::Size size;
+};
+
+bool PplCvX86ImencodeJpegTest::apply() {
+    cv::Mat src = createEncodingImage(size.height, size.width, channels);
+
+    ppl::cv::x86::ImwriteParams params;
+    params.jpegQuality = quality;
+    params.jpegSubsampling = subsampling;
+    size_t data_size;
+    uchar* data = nullptr;
+    ppl::common::RetCode code = ppl::cv::x86::Imencode(".jpg", src.rows,
+                                    src.cols, channels, src.step, src.data,
+                                    &data_size, &data, params);
+    if (code != ppl::common::RC_SUCCESS) {
+        return false;
+    }
+
+    bool identity = checkEncodedJpeg(src, data, data_size, 24.0, nullptr);
+    free(data);
+
+    return identity;
+}
+
+TEST_P(PplCvX86ImencodeJpegTest, Standard) {
+    bool identity = this->apply();
+    EXPECT_TRUE(identity);
+}
+
+INSTANTIATE_TEST_CASE_P(IsEqual, PplCvX86ImencodeJpegTest,
+    ::testing::Combine(
+        ::testing::Values(1, 3, 4),
+        ::testing::Values(ppl::cv::x86::JPEG_SUBSAMPLING_420,
+                          ppl::cv::x86::JPEG_SUBSAMPLING_422,
+                          ppl::cv::x86::JPEG_SUBSAMPLING_444),
+        ::testing::Values(50, 95),
+        ::testing::Values(cv::Size{1, 1}, cv::Size{7, 3}, cv::Size{37, 13},
+                          cv::Size{321, 240}, cv::Size{1283, 720})),
+    [](const testing::TestParamInfo<PplCvX86ImencodeJpegTest::ParamType>&
+       info) {
+        return convertToStringJpeg(info.param);
+    }
+);
+
+using Parameters3 = std::tuple<int, int, bool>;
+inline std::string convertToStringRestart(const Parameters3& parameters) {
+    std::ostringstream formatted;
+
+    int channels = std::get<0>(parameters);
+    formatted << "Channels" << channels << "_";
+
+    int interval = std::get<1>(parameters);
+    formatted << "Interval" << interval << "_";
+
+    bool optimize = std::get<2>(parameters);
+    formatted << "Optimize" << optimize;
+
+    return formatted.str();
+}
+
+class PplCvX86ImwriteJpegRestartTest :
+        public ::testing::TestWithParam<Parameters3> {
+  public:
+    PplCvX86ImwriteJpegRestartTest() {
+        const Parameters3& parameters = GetParam();
+        channels = std::get<0>(parameters);
+        interval = std::get<1>(parameters);
+        optimize = std::get<2>(parameters);
+    }
+
+    ~PplCvX86ImwriteJpegRestartTest() {
+    }
+
+    bool apply();
+
+  private:
+    int channels;
+    int interval;
+    bool optimize;
+};
+
+/* Restart markers and Huffman tables change the coding of the coefficients
+ * only, the image must decode to the same pixels as the one encoded without
+ * them.
+ */
+bool PplCvX86ImwriteJpegRestartTest::apply() {
+    int height = 243, width = 325;
+    cv::Mat src = createEncodingImage(height, width, channels);
+
+    size_t data_size;
+    uchar* data = nullptr;
+    ppl::common::RetCode code = ppl::cv::x86::Imencode(".jpg", height, width,
+                                    channels, src.step, src.data, &data_size,
+                                    &data);
+    if (code != ppl::common::RC_SUCCESS) {
+        return false;
+    }
+    cv::Mat expected;
+    bool identity = checkEncodedJpeg(src, data, data_size, 24.0, &expected);
+    free(data);
+    if (identity == false) {
+        return false;
+    }
+
+    ppl::cv::x86::ImwriteParams params;
+    params.jpegRestartInterval = interval;
+    params.jpegOptimize = optimize;
+    std::string file_name = "imwrite_restart.jpg";
+    code = ppl::cv::x86::Imwrite(file_name.c_str(), height, width, channels,
+                                 src.step, src.data, params);
+    if (code != ppl::common::RC_SUCCESS) {
+        return false;
+    }
+
+    cv::Mat cv_dst = cv::imread(file_name, cv::IMREAD_UNCHANGED);
+    remove(file_name.c_str());
+    if (cv_dst.rows != height || cv_dst.cols != width ||
+        cv_dst.type() != expected.type()) {
+        return false;
+    }
+    identity = checkMatricesIdentity<uchar>(expected, cv_dst, EPSILON_1F);
+
+    return identity;
+}
+
+TEST_P(PplCvX86ImwriteJpegRestartTest, Standard) {
+    bool identity = this->apply();
+    EXPECT_TRUE(identity);
+}
+
+INSTANTIATE_TEST_CASE_P(IsEqual, PplCvX86ImwriteJpegRestartTest,
+    ::testing::Combine(
+        ::testing::Values(1, 3),
+        ::testing::Values(0, 1, 7, 64),
+        ::testing::Values(false, true)),
+    [](const testing::TestParamInfo<PplCvX86ImwriteJpegRestartTest::ParamType>&
+       info) {
+        return convertToStringRestart(info.param);
+    }
+);
+
+/************************** Qoi and Pnm unittest **************************/
+
+// the image decoded by Imdecode() is the same as src.
+static bool checkDecodedImage(const cv::Mat& src, const uchar* data,
+                              size_t size) {
+    int height, width, channels, stride;
+    uchar* image = nullptr;
+    ppl::common::RetCode code = ppl::cv::x86::Imdecode(data, size, &height,
+                                    &width, &channels, &stride, &image);
+    if (code != ppl::common::RC_SUCCESS) {
+        return false;
+    }
+    if (height != src.rows || width != src.cols ||
+        channels != src.channels()) {
+        free(image);
+        return false;
+    }
+    cv::Mat ppl_dst(height, width, src.type(), image, stride);
+    bool identity = checkMatricesIdentity<uchar>(src, ppl_dst, EPSILON_1F);
+    free(image);
+
+    return identity;
+}
+
+using Parameters4 = std::tuple<std::string, int, cv::Size>;
+inline std::string convertToStringCache(const Parameters4& parameters) {
+    std::ostringstream formatted;
+
+    std::string extension = std::get<0>(parameters);
+    formatted << extension.substr(1) << "_";
+
+    int channels = std::get<1>(parameters);
+    formatted << "Channels" << channels << "_";
+
+    cv::Size size = std::get<2>(parameters);
+    formatted << size.width << "x";
+    formatted << size.height;
+
+    return formatted.str();
+}
+
+class PplCvX86ImencodeCacheTest :
+        public ::testing::TestWithParam<Parameters4> {
+  public:
+    PplCvX86ImencodeCacheTest() {
+        const Parameters4& parameters = GetParam();
+        extension = std::get<0>(parameters);
+        channels  = std::get<1>(parameters);
+        size      = std::get<2>(parameters);
+    }
+
+    ~PplCvX86ImencodeCacheTest() {
+    }
+
+    bool apply();
+
+  private:
+    std::string extension;
+    int channels;
+    cv::Size size;
+};
+
+/* The image is encoded into a buffer of the documented bound, and into
+ * buffers of the exact size and a byte less, the rows of the source are
+ * padded. PGM/PPM images are also checked against OpenCV both ways.
+ */
+bool PplCvX86ImencodeCacheTest::apply() {
+    cv::Mat padded = createEncodingImage(size.height, size.width + 3,
+                                         channels);
+    cv::Mat src = padded(cv::Rect(0, 0, size.width, size.height));
+    bool is_qoi = extension == ".qoi";
+    size_t capacity = is_qoi ?
+        (size_t)size.height * size.width * (channels + 1) + 22 :
+        (size_t)size.height * size.width * channels + 32;
+
+    std::vector<uchar> buffer(capacity);
+    size_t data_size;
+    ppl::common::RetCode code = ppl::cv::x86::Imencode(extension.c_str(),
+                                    src.rows, src.cols, channels, src.step,
+                                    src.data, capacity, buffer.data(),
+                                    &data_size);
+    if (code != ppl::common::RC_SUCCESS || data_size > capacity) {
+        return false;
+    }
+    uchar* data = nullptr;
+    size_t allocated_size;
+    code = ppl::cv::x86::Imencode(extension.c_str(), src.rows, src.cols,
+                                  channels, src.step, src.data,
+                                  &allocated_size, &data);
+    if (code != ppl::common::RC_SUCCESS) {
+        return false;
+    }
+    bool identity = allocated_size == data_size &&
+                    memcmp(data, buffer.data(), data_size) == 0;
+    free(data);
+    if (identity == false) {
+        return false;
+    }
+
+    std::vector<uchar> exact(data_size);
+    code = ppl::cv::x86::Imencode(extension.c_str(), src.rows, src.cols,
+                                  channels, src.step, src.data, data_size,
+                                  exact.data(), &allocated_size);
+    if (code != ppl::common::RC_SUCCESS || allocated_size != data_size ||
+        memcmp(exact.data(), buffer.data(), data_size) != 0) {
+        return false;
+    }
+    code = ppl::cv::x86::Imencode(extension.c_str(), src.rows, src.cols,
+                                  channels, src.step, src.data, data_size - 1,
+                                  exact.data(), &allocated_size);
+    if (code != ppl::common::RC_INVALID_VALUE) {
+        return false;
+    }
+
+    if (is_qoi) {
+        return checkDecodedImage(src, buffer.data(), data_size);
+    }
+    if (!checkEncodedImage(src, buffer.data(), data_size)) {
+        return false;
+    }
+    std::vector<uchar> cv_data;
+    cv::imencode(channels == 1 ? ".pgm" : ".ppm", src, cv_data);
+
+    return checkDecodedImage(src, cv_data.data(), cv_data.size());
+}
+
+TEST_P(PplCvX86ImencodeCacheTest, Standard) {
+    bool identity = this->apply();
+    EXPECT_TRUE(identity);
+}
+
+INSTANTIATE_TEST_CASE_P(IsEqualQoi, PplCvX86ImencodeCacheTest,
+    ::testing::Combine(
+        ::testing::Values(std::string(".qoi")),
+        ::testing::Values(3, 4),
+        ::testing::Values(cv::Size{1, 1}, cv::Size{7, 3}, cv::Size{37, 13},
+                          cv::Size{321, 240}, cv::Size{1283, 720})),
+    [](const testing::TestParamInfo<PplCvX86ImencodeCacheTest::ParamType>&
+       info) {
+        return convertToStringCache(info.param);
+    }
+);
+
+INSTANTIATE_TEST_CASE_P(IsEqualPnm, PplCvX86ImencodeCacheTest,
+    ::testing::Combine(
+        ::testing::Values(std::string(".ppm")),
+        ::testing::Values(1, 3),
+        ::testing::Values(cv::Size{1, 1}, cv::Size{7, 3}, cv::Size{37, 13},
+                          cv::Size{321, 240}, cv::Size{1283, 720})),
+    [](const testing::TestParamInfo<PplCvX86ImencodeCacheTest::ParamType>&
+       info) {
+        return convertToStringCache(info.param);
+    }
+);
+
+TEST(PplCvX86ImwriteInvalidTest, Standard) {
+    uchar image[12] = {0};
+    size_t size;
+    uchar* data = nullptr;
+
+    ppl::common::RetCode code = ppl::cv::x86::Imencode(".bmp", 2, 2, 3, 6,
+                                    image, &size, &data);
+    EXPECT_EQ(code, ppl::common::RC_INVALID_VALUE);
+    code = ppl::cv::x86::Imencode(".png", 2, 2, 2, 4, image, &size, &data);
+    EXPECT_EQ(code, ppl::common::RC_INVALID_VALUE);
+    code = ppl::cv::x86::Imencode(".png", 2, 2, 3, 5, image, &size, &data);
+    EXPECT_EQ(code, ppl::common::RC_INVALID_VALUE);
+    code = ppl::cv::x86::Imwrite("imwrite_invalid", 2, 2, 3, 6, image);
+    EXPECT_EQ(code, ppl::common::RC_INVALID_VALUE);
+
+    ppl::cv::x86::ImwriteParams params;
+    params.pngCompression = 10;
+    code = ppl::cv::x86::Imencode(".png", 2, 2, 3, 6, image, &size, &data,
+                                  params);
+    EXPECT_EQ(code, ppl::common::RC_INVALID_VALUE);
+    params.pngCompression = ppl::cv::x86::PNG_COMPRESSION_FASTEST;
+    params.pngStrategy = 5;
+    code = ppl::cv::x86::Imencode(".png", 2, 2, 3, 6, image, &size, &data,
+                                  params);
+    EXPECT_EQ(code, ppl::common::RC_INVALID_VALUE);
+
+    params.pngStrategy = ppl::cv::x86::PNG_STRATEGY_DEFAULT;
+    params.jpegQuality = 101;
+    code = ppl::cv::x86::Imencode(".jpg", 2, 2, 3, 6, image, &size, &data,
+                                  params);
+    EXPECT_EQ(code, ppl::common::RC_INVALID_VALUE);
+    params.jpegQuality = 95;
+    params.jpegSubsampling = 3;
+    code = ppl::cv::x86::Imencode(".jpg", 2, 2, 3, 6, image, &size, &data,
+                                  params);
+    EXPECT_EQ(code, ppl::common::RC_INVALID_VALUE);
+    params.jpegSubsampling = ppl::cv::x86::JPEG_SUBSAMPLING_420;
+    params.jpegRestartInterval = -1;
+    code = ppl::cv::x86::Imencode(".jpg", 2, 2, 3, 6, image, &size, &data,
+                                  params);
+    EXPECT_EQ(code, ppl::common::RC_INVALID_VALUE);
+
+    // jpeg takes no more than 65535 pixels of a row.
+    std::vector<uchar> row(70000);
+    code = ppl::cv::x86::Imencode(".jpg", 1, 70000, 1, 70000, row.data(),
+                                  &size, &data);
+    EXPECT_EQ(code, ppl::common::RC_INVALID_VALUE);
+
+    // the extension is not case sensitive.
+    code = ppl::cv::x86::Imencode(".PNG", 2, 2, 3, 6, image, &size, &data);
+    EXPECT_EQ(code, ppl::common::RC_SUCCESS);
+    free(data);
+    code = ppl::cv::x86::Imencode(".JPEG", 2, 2, 3, 6, image, &size, &data);
+    EXPECT_EQ(code, ppl::common::RC_SUCCESS);
+    free(data);
+
+    // qoi takes 3 and 4 channels, pgm/ppm 1 and 3.
+    code = ppl::cv::x86::Imencode(".qoi", 2, 2, 1, 2, image, &size, &data);
+    EXPECT_EQ(code, ppl::common::RC_INVALID_VALUE);
+    code = ppl::cv::x86::Imencode(".pnm", 1, 2, 4, 8, image, &size, &data);
+    EXPECT_EQ(code, ppl::common::RC_INVALID_VALUE);
+    uchar output[16];
+    code = ppl::cv::x86::Imencode(".qoi", 2, 2, 3, 6, image, sizeof(output),
+                                  output, &size);
+    EXPECT_EQ(code, ppl::common::RC_INVALID_VALUE);
+    code = ppl::cv::x86::Imencode(".pgm", 2, 2, 1, 2, image, sizeof(output),
+                                  output, &size);
+    EXPECT_EQ(code, ppl::common::RC_SUCCESS);
+    EXPECT_EQ(size, (size_t)15);
+}
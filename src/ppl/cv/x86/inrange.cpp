@@ -0,0 +1,206 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "ppl/cv/x86/inrange.h"
+#include "ppl/cv/x86/intrinutils.hpp"
+#include "ppl/cv/types.h"
+#include <immintrin.h>
+
+namespace ppl {
+namespace cv {
+namespace x86 {
+
+static inline __m128i inrange_u8(__m128i v_src, __m128i v_lower, __m128i v_upper)
+{
+    // both bounds are checked separately so that lower > upper gives 0.
+    __m128i v_ge_lower = _mm_cmpeq_epi8(_mm_max_epu8(v_src, v_lower), v_src);
+    __m128i v_le_upper = _mm_cmpeq_epi8(_mm_min_epu8(v_src, v_upper), v_src);
+    return _mm_and_si128(v_ge_lower, v_le_upper);
+}
+
+static inline __m128 inrange_f32(__m128 v_src, __m128 v_lower, __m128 v_upper)
+{
+    return _mm_and_ps(_mm_cmpge_ps(v_src, v_lower), _mm_cmple_ps(v_src, v_upper));
+}
+
+// the masks of 16 pixels, channels are separated first and their masks anded.
+template <int32_t nc>
+static inline __m128i inrange_u8_x16(const uint8_t *src, const __m128i *v_lower, const __m128i *v_upper);
+
+template <>
+inline __m128i inrange_u8_x16<1>(const uint8_t *src, const __m128i *v_lower, const __m128i *v_upper)
+{
+    return inrange_u8(_mm_loadu_si128((const __m128i *)src), v_lower[0], v_upper[0]);
+}
+
+template <>
+inline __m128i inrange_u8_x16<3>(const uint8_t *src, const __m128i *v_lower, const __m128i *v_upper)
+{
+    __m128i v_c0, v_c1, v_c2;
+    v_load_deinterleave(src, v_c0, v_c1, v_c2);
+    __m128i v_mask = inrange_u8(v_c0, v_lower[0], v_upper[0]);
+    v_mask         = _mm_and_si128(v_mask, inrange_u8(v_c1, v_lower[1], v_upper[1]));
+    return _mm_and_si128(v_mask, inrange_u8(v_c2, v_lower[2], v_upper[2]));
+}
+
+template <>
+inline __m128i inrange_u8_x16<4>(const uint8_t *src, const __m128i *v_lower, const __m128i *v_upper)
+{
+    __m128i v_c0, v_c1, v_c2, v_c3;
+    v_load_deinterleave(src, v_c0, v_c1, v_c2, v_c3);
+    __m128i v_mask = inrange_u8(v_c0, v_lower[0], v_upper[0]);
+    v_mask         = _mm_and_si128(v_mask, inrange_u8(v_c1, v_lower[1], v_upper[1]));
+    v_mask         = _mm_and_si128(v_mask, inrange_u8(v_c2, v_lower[2], v_upper[2]));
+    return _mm_and_si128(v_mask, inrange_u8(v_c3, v_lower[3], v_upper[3]));
+}
+
+// the masks of 4 pixels.
+template <int32_t nc>
+static inline __m128 inrange_f32_x4(const float *src, const __m128 *v_lower, const __m128 *v_upper);
+
+template <>
+inline __m128 inrange_f32_x4<1>(const float *src, const __m128 *v_lower, const __m128 *v_upper)
+{
+    return inrange_f32(_mm_loadu_ps(src), v_lower[0], v_upper[0]);
+}
+
+template <>
+inline __m128 inrange_f32_x4<3>(const float *src, const __m128 *v_lower, const __m128 *v_upper)
+{
+    __m128 v_c0, v_c1, v_c2;
+    v_load_deinterleave(src, v_c0, v_c1, v_c2);
+    __m128 v_mask = inrange_f32(v_c0, v_lower[0], v_upper[0]);
+    v_mask        = _mm_and_ps(v_mask, inrange_f32(v_c1, v_lower[1], v_upper[1]));
+    return _mm_and_ps(v_mask, inrange_f32(v_c2, v_lower[2], v_upper[2]));
+}
+
+template <>
+inline __m128 inrange_f32_x4<4>(const float *src, const __m128 *v_lower, const __m128 *v_upper)
+{
+    __m128 v_c0, v_c1, v_c2, v_c3;
+    v_load_deinterleave(src, v_c0, v_c1, v_c2, v_c3);
+    __m128 v_mask = inrange_f32(v_c0, v_lower[0], v_upper[0]);
+    v_mask        = _mm_and_ps(v_mask, inrange_f32(v_c1, v_lower[1], v_upper[1]));
+    v_mask        = _mm_and_ps(v_mask, inrange_f32(v_c2, v_lower[2], v_upper[2]));
+    return _mm_and_ps(v_mask, inrange_f32(v_c3, v_lower[3], v_upper[3]));
+}
+
+template <typename T, int32_t nc>
+static inline uint8_t inrange_pixel(const T *src, const T *lowerBound, const T *upperBound)
+{
+    for (int32_t c = 0; c < nc; c++) {
+        if (!(lowerBound[c] <= src[c] && src[c] <= upperBound[c])) {
+            return 0;
+        }
+    }
+    return 255;
+}
+
+template <int32_t nc>
+static void inrange_kernel(
+    int32_t height,
+    int32_t width,
+    int32_t inWidthStride,
+    const uint8_t *inData,
+    const uint8_t *lowerBound,
+    const uint8_t *upperBound,
+    int32_t outWidthStride,
+    uint8_t *outData)
+{
+    __m128i v_lower[nc], v_upper[nc];
+    for (int32_t c = 0; c < nc; c++) {
+        v_lower[c] = _mm_set1_epi8((char)lowerBound[c]);
+        v_upper[c] = _mm_set1_epi8((char)upperBound[c]);
+    }
+    for (int32_t i = 0; i < height; i++) {
+        const uint8_t *src = inData + i * inWidthStride;
+        uint8_t *dst       = outData + i * outWidthStride;
+        int32_t j          = 0;
+        for (; j <= width - 16; j += 16) {
+            _mm_storeu_si128((__m128i *)(dst + j), inrange_u8_x16<nc>(src + j * nc, v_lower, v_upper));
+        }
+        for (; j < width; j++) {
+            dst[j] = inrange_pixel<uint8_t, nc>(src + j * nc, lowerBound, upperBound);
+        }
+    }
+}
+
+template <int32_t nc>
+static void inrange_kernel(
+    int32_t height,
+    int32_t width,
+    int32_t inWidthStride,
+    const float *inData,
+    const float *lowerBound,
+    const float *upperBound,
+    int32_t outWidthStride,
+    uint8_t *outData)
+{
+    __m128 v_lower[nc], v_upper[nc];
+    for (int32_t c = 0; c < nc; c++) {
+        v_lower[c] = _mm_set1_ps(lowerBound[c]);
+        v_upper[c] = _mm_set1_ps(upperBound[c]);
+    }
+    for (int32_t i = 0; i < height; i++) {
+        const float *src = inData + i * inWidthStride;
+        uint8_t *dst     = outData + i * outWidthStride;
+        int32_t j        = 0;
+        for (; j <= width - 16; j += 16) {
+            __m128i v_m0 = _mm_castps_si128(inrange_f32_x4<nc>(src + j * nc, v_lower, v_upper));
+            __m128i v_m1 = _mm_castps_si128(inrange_f32_x4<nc>(src + (j + 4) * nc, v_lower, v_upper));
+            __m128i v_m2 = _mm_castps_si128(inrange_f32_x4<nc>(src + (j + 8) * nc, v_lower, v_upper));
+            __m128i v_m3 = _mm_castps_si128(inrange_f32_x4<nc>(src + (j + 12) * nc, v_lower, v_upper));
+            __m128i v_mask = _mm_packs_epi16(_mm_packs_epi32(v_m0, v_m1), _mm_packs_epi32(v_m2, v_m3));
+            _mm_storeu_si128((__m128i *)(dst + j), v_mask);
+        }
+        for (; j < width; j++) {
+            dst[j] = inrange_pixel<float, nc>(src + j * nc, lowerBound, upperBound);
+        }
+    }
+}
+
+template <typename T, int32_t nc>
+::ppl::common::RetCode InRange(
+    int32_t height,
+    int32_t width,
+    int32_t inWidthStride,
+    const T *inData,
+    const T *lowerBound,
+    const T *upperBound,
+    int32_t outWidthStride,
+    uint8_t *outData)
+{
+    if (nullptr == inData || nullptr == lowerBound || nullptr == upperBound || nullptr == outData) {
+        return ppl::common::RC_INVALID_VALUE;
+    }
+    if (height <= 0 || width <= 0 || inWidthStride < width * nc || outWidthStride < width) {
+        return ppl::common::RC_INVALID_VALUE;
+    }
+    inrange_kernel<nc>(height, width, inWidthStride, inData, lowerBound, upperBound, outWidthStride, outData);
+    return ppl::common::RC_SUCCESS;
+}
+
+template ::ppl::common::RetCode InRange<float, 1>(int32_t height, int32_t width, int32_t inWidthStride, const float *inData, const float *lowerBound, const float *upperBound, int32_t outWidthStride, uint8_t *outData);
+template ::ppl::common::RetCode InRange<float, 3>(int32_t height, int32_t width, int32_t inWidthStride, const float *inData, const float *lowerBound, const float *upperBound, int32_t outWidthStride, uint8_t *outData);
+template ::ppl::common::RetCode InRange<float, 4>(int32_t height, int32_t width, int32_t inWidthStride, const float *inData, const float *lowerBound, const float *upperBound, int32_t outWidthStride, uint8_t *outData);
+template ::ppl::common::RetCode InRange<uint8_t, 1>(int32_t height, int32_t width, int32_t inWidthStride, const uint8_t *inData, const uint8_t *lowerBound, const uint8_t *upperBound, int32_t outWidthStride, uint8_t *outData);
+template ::ppl::common::RetCode InRange<uint8_t, 3>(int32_t height, int32_t width, int32_t inWidthStride, const uint8_t *inData, const uint8_t *lowerBound, const uint8_t *upperBound, int32_t outWidthStride, uint8_t *outData);
+template ::ppl::common::RetCode InRange<uint8_t, 4>(int32_t height, int32_t width, int32_t inWidthStride, const uint8_t *inData, const uint8_t *lowerBound, const uint8_t *upperBound, int32_t outWidthStride, uint8_t *outData);
+
+}
+}
+} // namespace ppl::cv::x86
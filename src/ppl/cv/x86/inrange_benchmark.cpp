@@ -0,0 +1,93 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <benchmark/benchmark.h>
+#include "ppl/cv/x86/inrange.h"
+#include "ppl/cv/debug.h"
+
+namespace {
+template<typename T, int32_t channels>
+class InRangeBenchmark {
+public:
+    T* dev_iImage = nullptr;
+    uint8_t* dev_oImage = nullptr;
+    T lower[4] = {30, 60, 90, 0};
+    T upper[4] = {220, 180, 255, 128};
+    int32_t height;
+    int32_t width;
+    InRangeBenchmark(int32_t height, int32_t width)
+        : height(height)
+        , width(width)
+    {
+        dev_iImage = (T*)malloc(height * width * channels * sizeof(T));
+        dev_oImage = (uint8_t*)malloc(height * width * sizeof(uint8_t));
+        ppl::cv::debug::randomFill<T>(dev_iImage, height * width * channels, 0, 255);
+    }
+
+    void apply() {
+        ppl::cv::x86::InRange<T, channels>(height, width, width * channels, dev_iImage, lower, upper, width, dev_oImage);
+    }
+
+    void apply_opencv() {
+        cv::Mat iMat(height, width, CV_MAKETYPE(cv::DataType<T>::depth, channels), dev_iImage);
+        cv::Mat oMat(height, width, CV_8UC1, dev_oImage);
+        cv::inRange(iMat, cv::Scalar(lower[0], lower[1], lower[2], lower[3]),
+                    cv::Scalar(upper[0], upper[1], upper[2], upper[3]), oMat);
+    }
+
+    ~InRangeBenchmark() {
+        free(this->dev_iImage);
+        free(this->dev_oImage);
+    }
+};
+}
+
+using namespace ppl::cv::debug;
+template<typename T, int32_t channels>
+static void BM_InRange_ppl_x86(benchmark::State &state) {
+    InRangeBenchmark<T, channels> bm(state.range(1), state.range(0));
+    for (auto _: state) {
+        bm.apply();
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * state.range(0) * state.range(1) * sizeof(T) * channels);
+}
+
+BENCHMARK_TEMPLATE(BM_InRange_ppl_x86, uint8_t, c1)->Args({320, 240})->Args({640, 480});
+BENCHMARK_TEMPLATE(BM_InRange_ppl_x86, uint8_t, c3)->Args({320, 240})->Args({640, 480});
+BENCHMARK_TEMPLATE(BM_InRange_ppl_x86, uint8_t, c4)->Args({320, 240})->Args({640, 480});
+BENCHMARK_TEMPLATE(BM_InRange_ppl_x86, float, c1)->Args({320, 240})->Args({640, 480});
+BENCHMARK_TEMPLATE(BM_InRange_ppl_x86, float, c3)->Args({320, 240})->Args({640, 480});
+BENCHMARK_TEMPLATE(BM_InRange_ppl_x86, float, c4)->Args({320, 240})->Args({640, 480});
+
+#ifdef PPLCV_BENCHMARK_OPENCV
+template<typename T, int32_t channels>
+static void BM_InRange_opencv_x86(benchmark::State &state) {
+    InRangeBenchmark<T, channels> bm(state.range(1), state.range(0));
+    for (auto _: state) {
+        bm.apply_opencv();
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * state.range(0) * state.range(1) * sizeof(T) * channels);
+}
+BENCHMARK_TEMPLATE(BM_InRange_opencv_x86, uint8_t, c1)->Args({320, 240})->Args({640, 480});
+BENCHMARK_TEMPLATE(BM_InRange_opencv_x86, uint8_t, c3)->Args({320, 240})->Args({640, 480});
+BENCHMARK_TEMPLATE(BM_InRange_opencv_x86, uint8_t, c4)->Args({320, 240})->Args({640, 480});
+BENCHMARK_TEMPLATE(BM_InRange_opencv_x86, float, c1)->Args({320, 240})->Args({640, 480});
+BENCHMARK_TEMPLATE(BM_InRange_opencv_x86, float, c3)->Args({320, 240})->Args({640, 480});
+BENCHMARK_TEMPLATE(BM_InRange_opencv_x86, float, c4)->Args({320, 240})->Args({640, 480});
+#endif //! PPLCV_BENCHMARK_OPENCV
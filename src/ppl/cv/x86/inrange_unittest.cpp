@@ -0,0 +1,84 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "ppl/cv/x86/inrange.h"
+#include "ppl/cv/x86/test.h"
+#include "ppl/cv/types.h"
+#include <memory>
+#include <gtest/gtest.h>
+#include "ppl/cv/debug.h"
+
+template<typename T, int32_t nc>
+void InRangeTest(int32_t height, int32_t width, const T *lower, const T *upper) {
+    std::unique_ptr<T[]> src(new T[width * height * nc]);
+    std::unique_ptr<uint8_t[]> dst(new uint8_t[width * height]);
+    std::unique_ptr<uint8_t[]> dst_ref(new uint8_t[width * height]);
+    ppl::cv::debug::randomFill<T>(src.get(), width * height * nc, 0, 255);
+    cv::Mat srcMat(height, width, CV_MAKETYPE(cv::DataType<T>::depth, nc), src.get());
+    cv::Mat dstMat(height, width, CV_8UC1, dst_ref.get());
+
+    cv::Scalar lowerScalar(lower[0], lower[1], lower[2], lower[3]);
+    cv::Scalar upperScalar(upper[0], upper[1], upper[2], upper[3]);
+    ppl::cv::x86::InRange<T, nc>(height, width, width * nc, src.get(), lower, upper, width, dst.get());
+    cv::inRange(srcMat, lowerScalar, upperScalar, dstMat);
+    checkResult<uint8_t, 1>(dst.get(), dst_ref.get(), height, width, width, width, 1e-3);
+}
+
+template<typename T, int32_t nc>
+void InRangeTest(int32_t height, int32_t width) {
+    T lower[4] = {30, 60, 90, 0};
+    T upper[4] = {220, 180, 255, 128};
+    InRangeTest<T, nc>(height, width, lower, upper);
+}
+
+// an inverted range on the first channel selects no pixel at all.
+template<typename T, int32_t nc>
+void InRangeInvertedTest(int32_t height, int32_t width) {
+    T lower[4] = {220, 60, 90, 0};
+    T upper[4] = {30, 180, 255, 128};
+    InRangeTest<T, nc>(height, width, lower, upper);
+}
+
+TEST(InRangeUint8, x86)
+{
+    InRangeTest<uint8_t, 1>(480, 640);
+    InRangeTest<uint8_t, 3>(480, 640);
+    InRangeTest<uint8_t, 4>(480, 640);
+
+    InRangeTest<uint8_t, 1>(31, 67);
+    InRangeTest<uint8_t, 3>(31, 67);
+    InRangeTest<uint8_t, 4>(31, 67);
+
+    InRangeInvertedTest<uint8_t, 1>(480, 640);
+    InRangeInvertedTest<uint8_t, 3>(480, 640);
+    InRangeInvertedTest<uint8_t, 4>(31, 67);
+}
+
+TEST(InRangeFloat, x86)
+{
+    InRangeTest<float, 1>(480, 640);
+    InRangeTest<float, 3>(480, 640);
+    InRangeTest<float, 4>(480, 640);
+
+    InRangeTest<float, 1>(31, 67);
+    InRangeTest<float, 3>(31, 67);
+    InRangeTest<float, 4>(31, 67);
+
+    InRangeInvertedTest<float, 1>(480, 640);
+    InRangeInvertedTest<float, 3>(480, 640);
+    InRangeInvertedTest<float, 4>(31, 67);
+}
@@ -16,8 +16,9 @@
 // under the License.
 
 #include "ppl/cv/x86/medianblur.h"
-#include "ppl/cv/x86/copymakeborder.h"
+#include "ppl/cv/x86/borderedrow.hpp"
 #include "ppl/cv/types.h"
+#include <vector>
 
 namespace ppl {
 namespace cv {
@@ -78,27 +79,31 @@ template <typename T, int32_t cn>
     int32_t radius_x = ksize / 2;
     int32_t radius_y = ksize / 2;
 
-    T* buffer = (T*)malloc((height + 2 * radius_y) * (width + 2 * radius_x) * sizeof(T) * cn);
-    T* temp   = (T*)malloc(ksize * ksize * sizeof(T));
-
-    CopyMakeBorder<T, cn>(height, width, inWidthStride, inData, height + 2 * radius_y, width + 2 * radius_x, (width + 2 * radius_x) * cn, buffer, border_type);
+    // only the ksize padded rows of the current window are kept.
+    BorderedRowProvider<T, cn> provider(height, width, inWidthStride, inData, radius_x, radius_x, border_type, 0, ksize);
+    std::vector<T> temp(ksize * ksize);
+    std::vector<const T*> rows(ksize);
+    if (!provider.valid()) {
+        return ppl::common::RC_OUT_OF_MEMORY;
+    }
 
     int32_t area     = ksize * ksize;
     int32_t midIndex = (area >> 1) + 1;
     for (int32_t i = 0; i < height; ++i) {
+        for (int32_t ky = 0; ky < ksize; ++ky) {
+            rows[ky] = provider.getRow(i + ky - radius_y);
+        }
         for (int32_t j = 0; j < width; ++j) {
             for (int32_t c = 0; c < cn; ++c) {
                 for (int32_t ky = 0; ky < ksize; ++ky) {
                     for (int32_t kx = 0; kx < ksize; ++kx) {
-                        temp[ky * ksize + kx] = buffer[(i + ky) * (width + 2 * radius_x) * cn + (j + kx) * cn + c];
+                        temp[ky * ksize + kx] = rows[ky][(j + kx) * cn + c];
                     }
                 }
-                outData[i * outWidthStride + j * cn + c] = findKth(temp, area, midIndex);
+                outData[i * outWidthStride + j * cn + c] = findKth(temp.data(), area, midIndex);
             }
         }
     }
-    free(buffer);
-    free(temp);
     return ppl::common::RC_SUCCESS;
 }
 
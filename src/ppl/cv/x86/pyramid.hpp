@@ -0,0 +1,96 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef __ST_HPC_PPL_CV_X86_PYRAMID_HPP_
+#define __ST_HPC_PPL_CV_X86_PYRAMID_HPP_
+
+#include <stdint.h>
+
+namespace ppl {
+namespace cv {
+namespace x86 {
+
+/*
+ * Row kernels shared by PyrDown, PyrUp and BuildPyramid. The 5-tap binomial
+ * filter is applied vertically first, on whole rows, and then horizontally on
+ * the single summed row, so the source rows are only read once and the row
+ * kernels need no state besides a scratch buffer.
+ *
+ * The scratch buffer of a row kernel is made of 4 rows of
+ * pyrScratchStep(width, channels) elements, uint16_t for uint8_t images and
+ * float for float images. Integer sums stay exact in 16 bits: the largest
+ * pyrdown sum is 256 * 255 + 128 and the largest pyrup sum is 64 * 255 + 32.
+ */
+static inline int32_t pyrScratchStep(int32_t width, int32_t channels)
+{
+    return (width + 4) * channels + 64;
+}
+
+static inline int32_t pyrScratchLength(int32_t width, int32_t channels)
+{
+    return 4 * pyrScratchStep(width, channels);
+}
+
+// rows holds the 5 border interpolated source rows of one output row.
+void pyrdown_row_u8(const uint8_t *const *rows, int32_t width, int32_t channels, int32_t outWidth, uint16_t *buffer, uint8_t *dst);
+void pyrdown_row_f32(const float *const *rows, int32_t width, int32_t channels, int32_t outWidth, float *buffer, float *dst);
+
+// rows holds source rows y - 1, y and y + 1, dst0 and dst1 are the output
+// rows 2 * y and 2 * y + 1 of width * 2 pixels.
+void pyrup_row_u8(const uint8_t *const *rows, int32_t width, int32_t channels, uint16_t *buffer, uint8_t *dst0, uint8_t *dst1);
+void pyrup_row_f32(const float *const *rows, int32_t width, int32_t channels, float *buffer, float *dst0, float *dst1);
+
+// run the AVX2 row kernels when they are supported, the ones above otherwise.
+void pyrdown_row(const uint8_t *const *rows, int32_t width, int32_t channels, int32_t outWidth, uint16_t *buffer, uint8_t *dst);
+void pyrdown_row(const float *const *rows, int32_t width, int32_t channels, int32_t outWidth, float *buffer, float *dst);
+void pyrup_row(const uint8_t *const *rows, int32_t width, int32_t channels, uint16_t *buffer, uint8_t *dst0, uint8_t *dst1);
+void pyrup_row(const float *const *rows, int32_t width, int32_t channels, float *buffer, float *dst0, float *dst1);
+
+static inline int32_t pyrReflect101(int32_t p, int32_t len)
+{
+    if (len == 1) {
+        return 0;
+    }
+    int32_t period = 2 * len - 2;
+    p %= period;
+    p = p < 0 ? p + period : p;
+    return p < len ? p : period - p;
+}
+
+/*
+ * Fills the pad pixels in front of and behind a summed row of width pixels.
+ * The front is always BORDER_REFLECT_101, the back too for pyrdown, pyrup
+ * replicates the last pixel instead like the reference implementation.
+ */
+template <typename W>
+static inline void pyrPadRow(W *row, int32_t width, int32_t channels, int32_t pad, bool replicate_back)
+{
+    for (int32_t i = 1; i <= pad; i++) {
+        int32_t front = pyrReflect101(-i, width);
+        int32_t back  = replicate_back ? width - 1 : pyrReflect101(width - 1 + i, width);
+        for (int32_t c = 0; c < channels; c++) {
+            row[-i * channels + c]              = row[front * channels + c];
+            row[(width - 1 + i) * channels + c] = row[back * channels + c];
+        }
+    }
+}
+
+} //! namespace x86
+} //! namespace cv
+} //! namespace ppl
+
+#endif //! __ST_HPC_PPL_CV_X86_PYRAMID_HPP_
@@ -16,9 +16,11 @@
 // under the License.
 
 #include "ppl/cv/x86/pyrdown.h"
-#include "ppl/cv/x86/util.hpp"
+#include "ppl/cv/x86/pyramid.hpp"
+#include "ppl/cv/x86/fma/internal_fma.hpp"
 #include "ppl/cv/types.h"
 #include "ppl/common/sys.h"
+#include "ppl/common/x86/sysinfo.h"
 #include <string.h>
 #include <cmath>
 
@@ -26,252 +28,151 @@ namespace ppl {
 namespace cv {
 namespace x86 {
 
-void pyrdown_kernel_f32(
-    int32_t height,
+template <int32_t channels>
+static void pyrdown_row_f32_c(
+    const float *const *rows,
     int32_t width,
-    int32_t channels,
-    int32_t inWidthStride,
-    const float *inData,
-    int32_t outHeight,
     int32_t outWidth,
-    int32_t outWidthStride,
-    float *outData)
+    float *buffer,
+    float *dst)
 {
-    const int32_t PD_SZ = 5;
-    int32_t bufstep     = (outWidth * channels + 16 - 1) / 16 * 16;
-    float *buf          = (float *)malloc(bufstep * PD_SZ * sizeof(float));
-    memset(buf, 0, bufstep * PD_SZ * sizeof(float));
-    int32_t tabL[4 * (PD_SZ + 2)], tabR[4 * (PD_SZ + 2)];
-    int32_t *tabM = (int32_t *)malloc(outWidth * channels * sizeof(int32_t));
-
-    float *rows[PD_SZ];
+    int32_t length = width * channels;
+    float *row     = buffer + 2 * channels;
+    float r        = 1.0f / 256.0f;
 
-    int32_t k, x, sy0 = -PD_SZ / 2, sy = sy0;
-    int32_t width0 = outWidth;
-    if ((width - PD_SZ / 2 - 1) / 2 + 1 < width0) {
-        width0 = (width - PD_SZ / 2 - 1) / 2 + 1;
+    for (int32_t x = 0; x < length; ++x) {
+        row[x] = rows[2][x] * 6 + (rows[1][x] + rows[3][x]) * 4 + rows[0][x] + rows[4][x];
     }
-
-    float r = 1.0f / 256.0f;
-
-    for (x = 0; x <= PD_SZ + 1; ++x) {
-        int32_t sx0 = borderInterpolate(x - PD_SZ / 2, width) * channels;
-        int32_t sx1 = borderInterpolate(x + width0 * 2 - PD_SZ / 2, width) * channels;
-        for (k = 0; k < channels; ++k) {
-            tabL[x * channels + k] = sx0 + k;
-            tabR[x * channels + k] = sx1 + k;
+    pyrPadRow(row, width, channels, 2, false);
+
+    for (int32_t x = 0; x < outWidth; ++x) {
+        const float *s = row + x * 2 * channels;
+        for (int32_t c = 0; c < channels; ++c) {
+            dst[x * channels + c] = (s[c] * 6 + (s[c - channels] + s[c + channels]) * 4 +
+                                     s[c - channels * 2] + s[c + channels * 2]) *
+                                    r;
         }
     }
+}
 
-    width *= channels;
-    outWidth *= channels;
-    width0 *= channels;
-
-    for (x = 0; x < outWidth; ++x) {
-        tabM[x] = (x / channels) * 2 * channels + x % channels;
+// the channel count is a template parameter so the inner loops are unrolled.
+void pyrdown_row_f32(
+    const float *const *rows,
+    int32_t width,
+    int32_t channels,
+    int32_t outWidth,
+    float *buffer,
+    float *dst)
+{
+    if (channels == 1) {
+        pyrdown_row_f32_c<1>(rows, width, outWidth, buffer, dst);
+    } else if (channels == 3) {
+        pyrdown_row_f32_c<3>(rows, width, outWidth, buffer, dst);
+    } else {
+        pyrdown_row_f32_c<4>(rows, width, outWidth, buffer, dst);
     }
+}
 
-    for (int32_t y = 0; y < outHeight; ++y) {
-        float *dst = outData + y * outWidthStride;
-
-        for (; sy <= y * 2 + 2; ++sy) {
-            float *row         = buf + ((sy - sy0) % PD_SZ) * bufstep;
-            int32_t _sy        = borderInterpolate(sy, height);
-            const float *src   = inData + _sy * inWidthStride;
-            int32_t limit      = channels;
-            const int32_t *tab = tabL;
+template <int32_t channels>
+static void pyrdown_row_u8_c(
+    const uint8_t *const *rows,
+    int32_t width,
+    int32_t outWidth,
+    uint16_t *buffer,
+    uint8_t *dst)
+{
+    int32_t length = width * channels;
+    uint16_t *row  = buffer + 2 * channels;
 
-            for (x = 0;;) {
-                for (; x < limit; ++x) {
-                    row[x] = src[tab[x + channels * 2]] * 6 + (src[tab[x + channels]] + src[tab[x + channels * 3]]) * 4 +
-                             src[tab[x]] + src[tab[x + channels * 4]];
-                }
-                if (x == outWidth) {
-                    break;
-                }
+    for (int32_t x = 0; x < length; ++x) {
+        row[x] = rows[2][x] * 6 + (rows[1][x] + rows[3][x]) * 4 + rows[0][x] + rows[4][x];
+    }
+    pyrPadRow(row, width, channels, 2, false);
+
+    for (int32_t x = 0; x < outWidth; ++x) {
+        const uint16_t *s = row + x * 2 * channels;
+        for (int32_t c = 0; c < channels; ++c) {
+            int32_t temp = s[c] * 6 + (s[c - channels] + s[c + channels]) * 4 +
+                           s[c - channels * 2] + s[c + channels * 2];
+            dst[x * channels + c] = (temp + (1 << 7)) >> 8;
+        }
+    }
+}
 
-                if (channels == 1) {
-                    for (; x < width0; ++x) {
-                        row[x] = src[x * 2] * 6 + (src[x * 2 - 1] + src[x * 2 + 1]) * 4 +
-                                 src[x * 2 - 2] + src[x * 2 + 2];
-                    }
-                } else if (channels == 2) {
-                    for (; x < width0; x += 2) {
-                        const float *s = src + x * 2;
-                        float t0       = s[0] * 6 + (s[-2] + s[2]) * 4 + s[-4] + s[4];
-                        float t1       = s[1] * 6 + (s[-1] + s[3]) * 4 + s[-3] + s[5];
-                        row[x]         = t0;
-                        row[x + 1]     = t1;
-                    }
-                } else if (channels == 3) {
-                    for (; x < width0; x += 3) {
-                        const float *s = src + x * 2;
-                        float t0       = s[0] * 6 + (s[-3] + s[3]) * 4 + s[-6] + s[6];
-                        float t1       = s[1] * 6 + (s[-2] + s[4]) * 4 + s[-5] + s[7];
-                        float t2       = s[2] * 6 + (s[-1] + s[5]) * 4 + s[-4] + s[8];
-                        row[x]         = t0;
-                        row[x + 1]     = t1;
-                        row[x + 2]     = t2;
-                    }
-                } else if (channels == 4) {
-                    for (; x < width0; x += 4) {
-                        const float *s = src + x * 2;
-                        float t0       = s[0] * 6 + (s[-4] + s[4]) * 4 + s[-8] + s[8];
-                        float t1       = s[1] * 6 + (s[-3] + s[5]) * 4 + s[-7] + s[9];
-                        float t2       = s[2] * 6 + (s[-2] + s[6]) * 4 + s[-6] + s[10];
-                        float t3       = s[3] * 6 + (s[-1] + s[7]) * 4 + s[-5] + s[11];
-                        row[x]         = t0;
-                        row[x + 1]     = t1;
-                        row[x + 2]     = t2;
-                        row[x + 3]     = t3;
-                    }
-                } else {
-                    for (; x < width0; ++x) {
-                        int32_t sx = tabM[x];
-                        row[x]     = src[sx] * 6 + (src[sx - channels] + src[sx + channels]) * 4 +
-                                 src[sx - channels * 2] + src[sx + channels * 2];
-                    }
-                }
+void pyrdown_row_u8(
+    const uint8_t *const *rows,
+    int32_t width,
+    int32_t channels,
+    int32_t outWidth,
+    uint16_t *buffer,
+    uint8_t *dst)
+{
+    if (channels == 1) {
+        pyrdown_row_u8_c<1>(rows, width, outWidth, buffer, dst);
+    } else if (channels == 3) {
+        pyrdown_row_u8_c<3>(rows, width, outWidth, buffer, dst);
+    } else {
+        pyrdown_row_u8_c<4>(rows, width, outWidth, buffer, dst);
+    }
+}
 
-                limit = outWidth;
-                tab   = tabR - x;
-            }
-        }
+void pyrdown_row(
+    const float *const *rows,
+    int32_t width,
+    int32_t channels,
+    int32_t outWidth,
+    float *buffer,
+    float *dst)
+{
+    if (ppl::common::CpuSupports(ppl::common::ISA_X86_FMA)) {
+        fma::pyrdown_row_f32(rows, width, channels, outWidth, buffer, dst);
+    } else {
+        pyrdown_row_f32(rows, width, channels, outWidth, buffer, dst);
+    }
+}
 
-        for (k = 0; k < PD_SZ; ++k) {
-            rows[k] = buf + ((y * 2 - PD_SZ / 2 + k - sy0) % PD_SZ) * bufstep;
-        }
-        x = 0;
-        for (; x < outWidth; ++x) {
-            dst[x] = (rows[2][x] * 6 + (rows[1][x] + rows[3][x]) * 4 + rows[0][x] + rows[4][x]) * r;
-        }
+void pyrdown_row(
+    const uint8_t *const *rows,
+    int32_t width,
+    int32_t channels,
+    int32_t outWidth,
+    uint16_t *buffer,
+    uint8_t *dst)
+{
+    if (ppl::common::CpuSupports(ppl::common::ISA_X86_FMA)) {
+        fma::pyrdown_row_u8(rows, width, channels, outWidth, buffer, dst);
+    } else {
+        pyrdown_row_u8(rows, width, channels, outWidth, buffer, dst);
     }
-    free(tabM);
-    ppl::common::AlignedFree(buf);
 }
 
-void pyrdown_kernel_u8(
+template <typename T, typename W>
+static ::ppl::common::RetCode pyrdown_kernel(
     int32_t height,
     int32_t width,
     int32_t channels,
     int32_t inWidthStride,
-    const uint8_t *inData,
+    const T *inData,
     int32_t outHeight,
     int32_t outWidth,
     int32_t outWidthStride,
-    uint8_t *outData)
+    T *outData)
 {
-    const int32_t PD_SZ = 5;
-    int32_t bufstep     = (outWidth * channels + 16 - 1) / 16 * 16;
-    int32_t *buf        = (int32_t *)malloc(bufstep * PD_SZ * sizeof(int32_t));
-    memset(buf, 0, bufstep * PD_SZ * sizeof(int32_t));
-    int32_t tabL[4 * (PD_SZ + 2)], tabR[4 * (PD_SZ + 2)];
-    int32_t *tabM = (int32_t *)malloc(outWidth * channels * sizeof(int32_t));
-
-    int32_t *rows[PD_SZ];
-
-    int32_t k, x, sy0 = -PD_SZ / 2, sy = sy0;
-    int32_t width0 = outWidth;
-    if ((width - PD_SZ / 2 - 1) / 2 + 1 < width0) {
-        width0 = (width - PD_SZ / 2 - 1) / 2 + 1;
-    }
-
-    for (x = 0; x <= PD_SZ + 1; ++x) {
-        int32_t sx0 = borderInterpolate(x - PD_SZ / 2, width) * channels;
-        int32_t sx1 = borderInterpolate(x + width0 * 2 - PD_SZ / 2, width) * channels;
-        for (k = 0; k < channels; ++k) {
-            tabL[x * channels + k] = sx0 + k;
-            tabR[x * channels + k] = sx1 + k;
-        }
-    }
-
-    width *= channels;
-    outWidth *= channels;
-    width0 *= channels;
-
-    for (x = 0; x < outWidth; ++x) {
-        tabM[x] = (x / channels) * 2 * channels + x % channels;
+    W *buffer = (W *)ppl::common::AlignedAlloc(pyrScratchLength(width, channels) * sizeof(W), 64);
+    if (buffer == nullptr) {
+        return ppl::common::RC_OUT_OF_MEMORY;
     }
 
+    const T *rows[5];
     for (int32_t y = 0; y < outHeight; ++y) {
-        uint8_t *dst = outData + y * outWidthStride;
-
-        for (; sy <= y * 2 + 2; ++sy) {
-            int32_t *row       = buf + ((sy - sy0) % PD_SZ) * bufstep;
-            int32_t _sy        = borderInterpolate(sy, height);
-            const uint8_t *src = inData + _sy * inWidthStride;
-            int32_t limit      = channels;
-            const int32_t *tab = tabL;
-
-            for (x = 0;;) {
-                for (; x < limit; ++x) {
-                    row[x] = src[tab[x + channels * 2]] * 6 + (src[tab[x + channels]] + src[tab[x + channels * 3]]) * 4 +
-                             src[tab[x]] + src[tab[x + channels * 4]];
-                }
-                if (x == outWidth) {
-                    break;
-                }
-
-                if (channels == 1) {
-                    for (; x < width0; ++x) {
-                        row[x] = src[x * 2] * 6 + (src[x * 2 - 1] + src[x * 2 + 1]) * 4 +
-                                 src[x * 2 - 2] + src[x * 2 + 2];
-                    }
-                } else if (channels == 2) {
-                    for (; x < width0; x += 2) {
-                        const uint8_t *s = src + x * 2;
-                        int32_t t0       = s[0] * 6 + (s[-2] + s[2]) * 4 + s[-4] + s[4];
-                        int32_t t1       = s[1] * 6 + (s[-1] + s[3]) * 4 + s[-3] + s[5];
-                        row[x]           = t0;
-                        row[x + 1]       = t1;
-                    }
-                } else if (channels == 3) {
-                    for (; x < width0; x += 3) {
-                        const uint8_t *s = src + x * 2;
-                        int32_t t0       = s[0] * 6 + (s[-3] + s[3]) * 4 + s[-6] + s[6];
-                        int32_t t1       = s[1] * 6 + (s[-2] + s[4]) * 4 + s[-5] + s[7];
-                        int32_t t2       = s[2] * 6 + (s[-1] + s[5]) * 4 + s[-4] + s[8];
-                        row[x]           = t0;
-                        row[x + 1]       = t1;
-                        row[x + 2]       = t2;
-                    }
-                } else if (channels == 4) {
-                    for (; x < width0; x += 4) {
-                        const uint8_t *s = src + x * 2;
-                        int32_t t0       = s[0] * 6 + (s[-4] + s[4]) * 4 + s[-8] + s[8];
-                        int32_t t1       = s[1] * 6 + (s[-3] + s[5]) * 4 + s[-7] + s[9];
-                        int32_t t2       = s[2] * 6 + (s[-2] + s[6]) * 4 + s[-6] + s[10];
-                        int32_t t3       = s[3] * 6 + (s[-1] + s[7]) * 4 + s[-5] + s[11];
-                        row[x]           = t0;
-                        row[x + 1]       = t1;
-                        row[x + 2]       = t2;
-                        row[x + 3]       = t3;
-                    }
-                } else {
-                    for (; x < width0; ++x) {
-                        int32_t sx = tabM[x];
-                        row[x]     = src[sx] * 6 + (src[sx - channels] + src[sx + channels]) * 4 +
-                                 src[sx - channels * 2] + src[sx + channels * 2];
-                    }
-                }
-
-                limit = outWidth;
-                tab   = tabR - x;
-            }
-        }
-
-        for (k = 0; k < PD_SZ; ++k) {
-            rows[k] = buf + ((y * 2 - PD_SZ / 2 + k - sy0) % PD_SZ) * bufstep;
-        }
-        x = 0;
-        for (; x < outWidth; ++x) {
-            int32_t temp = (rows[2][x] * 6 + (rows[1][x] + rows[3][x]) * 4 + rows[0][x] + rows[4][x]);
-            temp += (1 << 7);
-            dst[x] = temp >> 8;
+        for (int32_t k = 0; k < 5; ++k) {
+            rows[k] = inData + pyrReflect101(y * 2 - 2 + k, height) * inWidthStride;
         }
+        pyrdown_row(rows, width, channels, outWidth, buffer, outData + y * outWidthStride);
     }
-    free(tabM);
-    ppl::common::AlignedFree(buf);
+
+    ppl::common::AlignedFree(buffer);
+    return ppl::common::RC_SUCCESS;
 }
 
 template <>
@@ -295,8 +196,7 @@ template <>
     }
     int32_t outHeight = (height + 1) / 2;
     int32_t outWidth  = (width + 1) / 2;
-    pyrdown_kernel_f32(height, width, 1, inWidthStride, inData, outHeight, outWidth, outWidthStride, outData);
-    return ppl::common::RC_SUCCESS;
+    return pyrdown_kernel<float, float>(height, width, 1, inWidthStride, inData, outHeight, outWidth, outWidthStride, outData);
 }
 
 template <>
@@ -320,8 +220,7 @@ template <>
     }
     int32_t outHeight = (height + 1) / 2;
     int32_t outWidth  = (width + 1) / 2;
-    pyrdown_kernel_f32(height, width, 3, inWidthStride, inData, outHeight, outWidth, outWidthStride, outData);
-    return ppl::common::RC_SUCCESS;
+    return pyrdown_kernel<float, float>(height, width, 3, inWidthStride, inData, outHeight, outWidth, outWidthStride, outData);
 }
 
 template <>
@@ -345,8 +244,7 @@ template <>
     }
     int32_t outHeight = (height + 1) / 2;
     int32_t outWidth  = (width + 1) / 2;
-    pyrdown_kernel_f32(height, width, 4, inWidthStride, inData, outHeight, outWidth, outWidthStride, outData);
-    return ppl::common::RC_SUCCESS;
+    return pyrdown_kernel<float, float>(height, width, 4, inWidthStride, inData, outHeight, outWidth, outWidthStride, outData);
 }
 
 template <>
@@ -370,8 +268,7 @@ template <>
     }
     int32_t outHeight = (height + 1) / 2;
     int32_t outWidth  = (width + 1) / 2;
-    pyrdown_kernel_u8(height, width, 1, inWidthStride, inData, outHeight, outWidth, outWidthStride, outData);
-    return ppl::common::RC_SUCCESS;
+    return pyrdown_kernel<uint8_t, uint16_t>(height, width, 1, inWidthStride, inData, outHeight, outWidth, outWidthStride, outData);
 }
 
 template <>
@@ -395,8 +292,7 @@ template <>
     }
     int32_t outHeight = (height + 1) / 2;
     int32_t outWidth  = (width + 1) / 2;
-    pyrdown_kernel_u8(height, width, 3, inWidthStride, inData, outHeight, outWidth, outWidthStride, outData);
-    return ppl::common::RC_SUCCESS;
+    return pyrdown_kernel<uint8_t, uint16_t>(height, width, 3, inWidthStride, inData, outHeight, outWidth, outWidthStride, outData);
 }
 
 template <>
@@ -420,8 +316,7 @@ template <>
     }
     int32_t outHeight = (height + 1) / 2;
     int32_t outWidth  = (width + 1) / 2;
-    pyrdown_kernel_u8(height, width, 4, inWidthStride, inData, outHeight, outWidth, outWidthStride, outData);
-    return ppl::common::RC_SUCCESS;
+    return pyrdown_kernel<uint8_t, uint16_t>(height, width, 4, inWidthStride, inData, outHeight, outWidth, outWidthStride, outData);
 }
 
 }
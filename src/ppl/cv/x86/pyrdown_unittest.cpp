@@ -60,8 +60,10 @@ public:
         this->apply(GetParam());\
     }\
     INSTANTIATE_TEST_CASE_P(standard, name,\
-        ::testing::Combine(::testing::Values(Size{6, 8}),\
-                           ::testing::Values(Size{3, 4})));
+        ::testing::Values(std::make_tuple(Size{6, 8}, Size{3, 4}),\
+                          std::make_tuple(Size{320, 240}, Size{160, 120}),\
+                          std::make_tuple(Size{321, 241}, Size{161, 121}),\
+                          std::make_tuple(Size{67, 3}, Size{34, 2})));
 
 R(PyrDown_x86_f32c1, float, 1)
 R(PyrDown_x86_f32c3, float, 3)
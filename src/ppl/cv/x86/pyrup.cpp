@@ -16,9 +16,11 @@
 // under the License.
 
 #include "ppl/cv/x86/pyrup.h"
-#include "ppl/cv/x86/util.hpp"
+#include "ppl/cv/x86/pyramid.hpp"
+#include "ppl/cv/x86/fma/internal_fma.hpp"
 #include "ppl/cv/types.h"
 #include "ppl/common/sys.h"
+#include "ppl/common/x86/sysinfo.h"
 #include <string.h>
 #include <cmath>
 
@@ -26,222 +28,166 @@ namespace ppl {
 namespace cv {
 namespace x86 {
 
-void pyrup_kernel_f32(
-    int32_t height,
+template <int32_t channels>
+static void pyrup_row_f32_c(
+    const float *const *rows,
     int32_t width,
-    int32_t channels,
-    int32_t inWidthStride,
-    const float *inData,
-    int32_t outHeight,
-    int32_t outWidth,
-    int32_t outWidthStride,
-    float *outData)
+    float *buffer,
+    float *dst0,
+    float *dst1)
 {
-    const int32_t PU_SZ = 3;
-    int32_t bufstep     = ((outWidth + 1) * channels + 16 - 1) / 16 * 16;
-    float *buf          = (float *)malloc(bufstep * PU_SZ * sizeof(float));
-    memset(buf, 0, bufstep * PU_SZ * sizeof(float));
-    int32_t *dtab = (int32_t *)malloc(width * channels * sizeof(int32_t));
-
-    float *rows[3];
-
-    int32_t k, x, sy0 = -PU_SZ / 2, sy = sy0;
-    float r = 1.0f / 64;
-
-    width *= channels;
-    outWidth *= channels;
-
-    for (x = 0; x < width; ++x) {
-        dtab[x] = (x / channels) * 2 * channels + x % channels;
+    int32_t length  = width * channels;
+    int32_t bufstep = pyrScratchStep(width, channels);
+    float *row0     = buffer + channels;
+    float *row1     = buffer + bufstep + channels;
+    float r         = 1.0f / 64;
+
+    for (int32_t x = 0; x < length; ++x) {
+        row0[x] = rows[0][x] + rows[1][x] * 6 + rows[2][x];
+        row1[x] = (rows[1][x] + rows[2][x]) * 4;
     }
-
-    for (int32_t y = 0; y < height; ++y) {
-        float *dst0 = outData + (y * 2) * outWidthStride;
-
-        int32_t oy1 = y * 2 + 1;
-        if (oy1 >= outHeight) {
-            oy1 = outHeight - 1;
-        }
-        float *dst1 = outData + oy1 * outWidthStride;
-        float *row0, *row1, *row2;
-
-        for (; sy <= y + 1; ++sy) {
-            float *row  = buf + ((sy - sy0) % PU_SZ) * bufstep;
-            int32_t _sy = borderInterpolate(sy * 2, height * 2) / 2;
-
-            const float *src = inData + _sy * inWidthStride;
-
-            if (width == channels) {
-                for (x = 0; x < channels; ++x) {
-                    row[x] = row[x + channels] = src[x] * 8;
-                }
-                continue;
-            }
-
-            for (x = 0; x < channels; ++x) {
-                int32_t dx         = dtab[x];
-                float t0           = src[x] * 6 + src[x + channels] * 2;
-                float t1           = (src[x] + src[x + channels]) * 4;
-                row[dx]            = t0;
-                row[dx + channels] = t1;
-                dx                 = dtab[width - channels + x];
-                int32_t sx         = width - channels + x;
-                t0                 = src[sx - channels] + src[sx] * 7;
-                t1                 = src[sx] * 8;
-                row[dx]            = t0;
-                row[dx + channels] = t1;
-
-                if (outWidth > width * 2) {
-                    row[outWidth - channels + x] = row[dx + channels];
-                }
-            }
-
-            for (x = channels; x < width - channels; ++x) {
-                int32_t dx         = dtab[x];
-                float t0           = src[x - channels] + src[x] * 6 + src[x + channels];
-                float t1           = (src[x] + src[x + channels]) * 4;
-                row[dx]            = t0;
-                row[dx + channels] = t1;
-            }
+    pyrPadRow(row0, width, channels, 1, true);
+    pyrPadRow(row1, width, channels, 1, true);
+
+    for (int32_t x = 0; x < width; ++x) {
+        const float *s0 = row0 + x * channels;
+        const float *s1 = row1 + x * channels;
+        float *d0       = dst0 + x * 2 * channels;
+        float *d1       = dst1 + x * 2 * channels;
+        for (int32_t c = 0; c < channels; ++c) {
+            d0[c]            = (s0[c - channels] + s0[c] * 6 + s0[c + channels]) * r;
+            d0[c + channels] = (s0[c] + s0[c + channels]) * 4 * r;
+            d1[c]            = (s1[c - channels] + s1[c] * 6 + s1[c + channels]) * r;
+            d1[c + channels] = (s1[c] + s1[c + channels]) * 4 * r;
         }
+    }
+}
 
-        for (k = 0; k < PU_SZ; ++k) {
-            rows[k] = buf + ((y - PU_SZ / 2 + k - sy0) % PU_SZ) * bufstep;
-        }
-        row0 = rows[0];
-        row1 = rows[1];
-        row2 = rows[2];
+// the channel count is a template parameter so the inner loops are unrolled.
+void pyrup_row_f32(
+    const float *const *rows,
+    int32_t width,
+    int32_t channels,
+    float *buffer,
+    float *dst0,
+    float *dst1)
+{
+    if (channels == 1) {
+        pyrup_row_f32_c<1>(rows, width, buffer, dst0, dst1);
+    } else if (channels == 3) {
+        pyrup_row_f32_c<3>(rows, width, buffer, dst0, dst1);
+    } else {
+        pyrup_row_f32_c<4>(rows, width, buffer, dst0, dst1);
+    }
+}
 
-        x = 0;
-        for (; x < outWidth; ++x) {
-            float t1 = (row1[x] + row2[x]) * 4;
-            float t0 = (row0[x] + row1[x] * 6 + row2[x]);
-            dst1[x]  = t1 * r;
-            dst0[x]  = t0 * r;
+template <int32_t channels>
+static void pyrup_row_u8_c(
+    const uint8_t *const *rows,
+    int32_t width,
+    uint16_t *buffer,
+    uint8_t *dst0,
+    uint8_t *dst1)
+{
+    int32_t length  = width * channels;
+    int32_t bufstep = pyrScratchStep(width, channels);
+    uint16_t *row0  = buffer + channels;
+    uint16_t *row1  = buffer + bufstep + channels;
+
+    for (int32_t x = 0; x < length; ++x) {
+        row0[x] = rows[0][x] + rows[1][x] * 6 + rows[2][x];
+        row1[x] = (rows[1][x] + rows[2][x]) * 4;
+    }
+    pyrPadRow(row0, width, channels, 1, true);
+    pyrPadRow(row1, width, channels, 1, true);
+
+    for (int32_t x = 0; x < width; ++x) {
+        const uint16_t *s0 = row0 + x * channels;
+        const uint16_t *s1 = row1 + x * channels;
+        uint8_t *d0        = dst0 + x * 2 * channels;
+        uint8_t *d1        = dst1 + x * 2 * channels;
+        for (int32_t c = 0; c < channels; ++c) {
+            d0[c]            = (s0[c - channels] + s0[c] * 6 + s0[c + channels] + (1 << 5)) >> 6;
+            d0[c + channels] = ((s0[c] + s0[c + channels]) * 4 + (1 << 5)) >> 6;
+            d1[c]            = (s1[c - channels] + s1[c] * 6 + s1[c + channels] + (1 << 5)) >> 6;
+            d1[c + channels] = ((s1[c] + s1[c + channels]) * 4 + (1 << 5)) >> 6;
         }
     }
+}
 
-    if (outHeight > height * 2) {
-        float *dst0 = outData + (height * 2 - 2) * outWidthStride;
-        float *dst2 = outData + (height * 2) * outWidthStride;
+void pyrup_row_u8(
+    const uint8_t *const *rows,
+    int32_t width,
+    int32_t channels,
+    uint16_t *buffer,
+    uint8_t *dst0,
+    uint8_t *dst1)
+{
+    if (channels == 1) {
+        pyrup_row_u8_c<1>(rows, width, buffer, dst0, dst1);
+    } else if (channels == 3) {
+        pyrup_row_u8_c<3>(rows, width, buffer, dst0, dst1);
+    } else {
+        pyrup_row_u8_c<4>(rows, width, buffer, dst0, dst1);
+    }
+}
 
-        for (x = 0; x < outWidth; ++x) {
-            dst2[x] = dst0[x];
-        }
+void pyrup_row(
+    const float *const *rows,
+    int32_t width,
+    int32_t channels,
+    float *buffer,
+    float *dst0,
+    float *dst1)
+{
+    if (ppl::common::CpuSupports(ppl::common::ISA_X86_FMA)) {
+        fma::pyrup_row_f32(rows, width, channels, buffer, dst0, dst1);
+    } else {
+        pyrup_row_f32(rows, width, channels, buffer, dst0, dst1);
     }
+}
 
-    free(dtab);
-    free(buf);
+void pyrup_row(
+    const uint8_t *const *rows,
+    int32_t width,
+    int32_t channels,
+    uint16_t *buffer,
+    uint8_t *dst0,
+    uint8_t *dst1)
+{
+    if (ppl::common::CpuSupports(ppl::common::ISA_X86_FMA)) {
+        fma::pyrup_row_u8(rows, width, channels, buffer, dst0, dst1);
+    } else {
+        pyrup_row_u8(rows, width, channels, buffer, dst0, dst1);
+    }
 }
 
-void pyrup_kernel_u8(
+template <typename T, typename W>
+static ::ppl::common::RetCode pyrup_kernel(
     int32_t height,
     int32_t width,
     int32_t channels,
     int32_t inWidthStride,
-    const uint8_t *inData,
-    int32_t outHeight,
-    int32_t outWidth,
+    const T *inData,
     int32_t outWidthStride,
-    uint8_t *outData)
+    T *outData)
 {
-    const int32_t PU_SZ = 3;
-    int32_t bufstep     = ((outWidth + 1) * channels + 16 - 1) / 16 * 16;
-    int32_t *buf        = (int32_t *)malloc(bufstep * PU_SZ * sizeof(int32_t));
-    memset(buf, 0, bufstep * PU_SZ * sizeof(int32_t));
-    int32_t *dtab = (int32_t *)malloc(width * channels * sizeof(int32_t));
-
-    int32_t *rows[3];
-
-    int32_t k, x, sy0 = -PU_SZ / 2, sy = sy0;
-
-    width *= channels;
-    outWidth *= channels;
-
-    for (x = 0; x < width; ++x) {
-        dtab[x] = (x / channels) * 2 * channels + x % channels;
+    W *buffer = (W *)ppl::common::AlignedAlloc(pyrScratchLength(width, channels) * sizeof(W), 64);
+    if (buffer == nullptr) {
+        return ppl::common::RC_OUT_OF_MEMORY;
     }
 
+    // source row y - 1 is reflected, row y + 1 is replicated at the bottom.
+    const T *rows[3];
     for (int32_t y = 0; y < height; ++y) {
-        uint8_t *dst0 = outData + (y * 2) * outWidthStride;
-
-        int32_t oy1 = y * 2 + 1;
-        if (oy1 >= outHeight) {
-            oy1 = outHeight - 1;
-        }
-        uint8_t *dst1 = outData + oy1 * outWidthStride;
-        int32_t *row0, *row1, *row2;
-
-        for (; sy <= y + 1; ++sy) {
-            int32_t *row = buf + ((sy - sy0) % PU_SZ) * bufstep;
-            int32_t _sy  = borderInterpolate(sy * 2, height * 2) / 2;
-
-            const uint8_t *src = inData + _sy * inWidthStride;
-
-            if (width == channels) {
-                for (x = 0; x < channels; ++x) {
-                    row[x] = row[x + channels] = src[x] * 8;
-                }
-                continue;
-            }
-
-            for (x = 0; x < channels; ++x) {
-                int32_t dx         = dtab[x];
-                int32_t t0         = src[x] * 6 + src[x + channels] * 2;
-                int32_t t1         = (src[x] + src[x + channels]) * 4;
-                row[dx]            = t0;
-                row[dx + channels] = t1;
-                dx                 = dtab[width - channels + x];
-                int32_t sx         = width - channels + x;
-                t0                 = src[sx - channels] + src[sx] * 7;
-                t1                 = src[sx] * 8;
-                row[dx]            = t0;
-                row[dx + channels] = t1;
-
-                if (outWidth > width * 2) {
-                    row[outWidth - channels + x] = row[dx + channels];
-                }
-            }
-
-            for (x = channels; x < width - channels; ++x) {
-                int32_t dx         = dtab[x];
-                int32_t t0         = src[x - channels] + src[x] * 6 + src[x + channels];
-                int32_t t1         = (src[x] + src[x + channels]) * 4;
-                row[dx]            = t0;
-                row[dx + channels] = t1;
-            }
-        }
-
-        for (k = 0; k < PU_SZ; ++k) {
-            rows[k] = buf + ((y - PU_SZ / 2 + k - sy0) % PU_SZ) * bufstep;
-        }
-        row0 = rows[0];
-        row1 = rows[1];
-        row2 = rows[2];
-
-        x = 0;
-        for (; x < outWidth; ++x) {
-            int32_t t1 = (row1[x] + row2[x]) * 4;
-            int32_t t0 = (row0[x] + row1[x] * 6 + row2[x]);
-            t1 += 1 << 5;
-            t0 += 1 << 5;
-
-            dst1[x] = t1 >> 6;
-            dst0[x] = t0 >> 6;
-        }
-    }
-
-    if (outHeight > height * 2) {
-        uint8_t *dst0 = outData + (height * 2 - 2) * outWidthStride;
-        uint8_t *dst2 = outData + (height * 2) * outWidthStride;
-
-        for (x = 0; x < outWidth; ++x) {
-            dst2[x] = dst0[x];
-        }
+        rows[0] = inData + pyrReflect101(y - 1, height) * inWidthStride;
+        rows[1] = inData + y * inWidthStride;
+        rows[2] = inData + (y + 1 < height ? y + 1 : height - 1) * inWidthStride;
+        pyrup_row(rows, width, channels, buffer, outData + (y * 2) * outWidthStride, outData + (y * 2 + 1) * outWidthStride);
     }
 
-    free(dtab);
-    free(buf);
+    ppl::common::AlignedFree(buffer);
+    return ppl::common::RC_SUCCESS;
 }
 
 template <>
@@ -263,10 +209,7 @@ template <>
     if (border_type != ppl::cv::BORDER_REFLECT_101) {
         return ppl::common::RC_INVALID_VALUE;
     }
-    int32_t outHeight = height * 2;
-    int32_t outWidth  = width * 2;
-    pyrup_kernel_f32(height, width, 1, inWidthStride, inData, outHeight, outWidth, outWidthStride, outData);
-    return ppl::common::RC_SUCCESS;
+    return pyrup_kernel<float, float>(height, width, 1, inWidthStride, inData, outWidthStride, outData);
 }
 
 template <>
@@ -288,10 +231,7 @@ template <>
     if (border_type != ppl::cv::BORDER_REFLECT_101) {
         return ppl::common::RC_INVALID_VALUE;
     }
-    int32_t outHeight = height * 2;
-    int32_t outWidth  = width * 2;
-    pyrup_kernel_f32(height, width, 3, inWidthStride, inData, outHeight, outWidth, outWidthStride, outData);
-    return ppl::common::RC_SUCCESS;
+    return pyrup_kernel<float, float>(height, width, 3, inWidthStride, inData, outWidthStride, outData);
 }
 
 template <>
@@ -313,10 +253,7 @@ template <>
     if (border_type != ppl::cv::BORDER_REFLECT_101) {
         return ppl::common::RC_INVALID_VALUE;
     }
-    int32_t outHeight = height * 2;
-    int32_t outWidth  = width * 2;
-    pyrup_kernel_f32(height, width, 4, inWidthStride, inData, outHeight, outWidth, outWidthStride, outData);
-    return ppl::common::RC_SUCCESS;
+    return pyrup_kernel<float, float>(height, width, 4, inWidthStride, inData, outWidthStride, outData);
 }
 
 template <>
@@ -338,10 +275,7 @@ template <>
     if (border_type != ppl::cv::BORDER_REFLECT_101) {
         return ppl::common::RC_INVALID_VALUE;
     }
-    int32_t outHeight = height * 2;
-    int32_t outWidth  = width * 2;
-    pyrup_kernel_u8(height, width, 1, inWidthStride, inData, outHeight, outWidth, outWidthStride, outData);
-    return ppl::common::RC_SUCCESS;
+    return pyrup_kernel<uint8_t, uint16_t>(height, width, 1, inWidthStride, inData, outWidthStride, outData);
 }
 
 template <>
@@ -363,10 +297,7 @@ template <>
     if (border_type != ppl::cv::BORDER_REFLECT_101) {
         return ppl::common::RC_INVALID_VALUE;
     }
-    int32_t outHeight = height * 2;
-    int32_t outWidth  = width * 2;
-    pyrup_kernel_u8(height, width, 3, inWidthStride, inData, outHeight, outWidth, outWidthStride, outData);
-    return ppl::common::RC_SUCCESS;
+    return pyrup_kernel<uint8_t, uint16_t>(height, width, 3, inWidthStride, inData, outWidthStride, outData);
 }
 
 template <>
@@ -388,10 +319,7 @@ template <>
     if (border_type != ppl::cv::BORDER_REFLECT_101) {
         return ppl::common::RC_INVALID_VALUE;
     }
-    int32_t outHeight = height * 2;
-    int32_t outWidth  = width * 2;
-    pyrup_kernel_u8(height, width, 4, inWidthStride, inData, outHeight, outWidth, outWidthStride, outData);
-    return ppl::common::RC_SUCCESS;
+    return pyrup_kernel<uint8_t, uint16_t>(height, width, 4, inWidthStride, inData, outWidthStride, outData);
 }
 
 }
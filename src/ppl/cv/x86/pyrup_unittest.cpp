@@ -61,8 +61,10 @@ public:
         this->apply(GetParam());\
     }\
     INSTANTIATE_TEST_CASE_P(standard, name,\
-        ::testing::Combine(::testing::Values(Size{3, 4}),\
-                           ::testing::Values(Size{6, 8})));
+        ::testing::Values(std::make_tuple(Size{3, 4}, Size{6, 8}),\
+                          std::make_tuple(Size{160, 120}, Size{320, 240}),\
+                          std::make_tuple(Size{161, 121}, Size{322, 242}),\
+                          std::make_tuple(Size{33, 3}, Size{66, 6})));
 
 R(PyrUp_x86_f32c1, float, 1)
 R(PyrUp_x86_f32c3, float, 3)
@@ -0,0 +1,368 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "ppl/cv/x86/threshold.h"
+#include "ppl/cv/types.h"
+#include <float.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <immintrin.h>
+
+namespace ppl {
+namespace cv {
+namespace x86 {
+
+/*
+ * uint8_t elements are compared against an integer threshold like OpenCV:
+ * x > ithresh is evaluated as max(x, ithresh + 1) == x, which is always true
+ * for ithresh < 0 and must be forced false for ithresh >= 255.
+ */
+template <int32_t type>
+static inline __m128i threshold_u8_op(__m128i v_src, __m128i v_gt, __m128i v_thresh, __m128i v_max)
+{
+    switch (type) {
+        case ppl::cv::CV_THRESH_BINARY:
+            return _mm_and_si128(v_gt, v_max);
+        case ppl::cv::CV_THRESH_BINARY_INV:
+            return _mm_andnot_si128(v_gt, v_max);
+        case ppl::cv::CV_THRESH_TRUNC:
+            return _mm_min_epu8(v_src, v_thresh);
+        case ppl::cv::CV_THRESH_TOZERO:
+            return _mm_and_si128(v_gt, v_src);
+        default:
+            return _mm_andnot_si128(v_gt, v_src);
+    }
+}
+
+template <int32_t type>
+static inline uint8_t threshold_u8_op(uint8_t src, bool gt, uint8_t thresh, uint8_t max_value)
+{
+    switch (type) {
+        case ppl::cv::CV_THRESH_BINARY:
+            return gt ? max_value : 0;
+        case ppl::cv::CV_THRESH_BINARY_INV:
+            return gt ? 0 : max_value;
+        case ppl::cv::CV_THRESH_TRUNC:
+            return std::min(src, thresh);
+        case ppl::cv::CV_THRESH_TOZERO:
+            return gt ? src : 0;
+        default:
+            return gt ? 0 : src;
+    }
+}
+
+template <int32_t type>
+static void threshold_u8(
+    int32_t height,
+    int32_t length,
+    int32_t inWidthStride,
+    const uint8_t *inData,
+    int32_t outWidthStride,
+    uint8_t *outData,
+    int32_t ithresh,
+    uint8_t max_value)
+{
+    bool never_gt    = ithresh >= 255;
+    uint8_t thresh   = (uint8_t)std::min(std::max(ithresh, 0), 255);
+    uint8_t thresh1  = (uint8_t)std::min(std::max(ithresh + 1, 0), 255);
+    __m128i v_thresh = _mm_set1_epi8((char)thresh);
+    __m128i v_bound  = _mm_set1_epi8((char)thresh1);
+    __m128i v_max    = _mm_set1_epi8((char)max_value);
+    __m128i v_keep   = never_gt ? _mm_setzero_si128() : _mm_set1_epi8(-1);
+    for (int32_t i = 0; i < height; i++) {
+        const uint8_t *src = inData + i * inWidthStride;
+        uint8_t *dst       = outData + i * outWidthStride;
+        int32_t j          = 0;
+        for (; j <= length - 32; j += 32) {
+            __m128i v_src0 = _mm_loadu_si128((const __m128i *)(src + j));
+            __m128i v_src1 = _mm_loadu_si128((const __m128i *)(src + j + 16));
+            __m128i v_gt0  = _mm_and_si128(v_keep, _mm_cmpeq_epi8(_mm_max_epu8(v_src0, v_bound), v_src0));
+            __m128i v_gt1  = _mm_and_si128(v_keep, _mm_cmpeq_epi8(_mm_max_epu8(v_src1, v_bound), v_src1));
+            _mm_storeu_si128((__m128i *)(dst + j), threshold_u8_op<type>(v_src0, v_gt0, v_thresh, v_max));
+            _mm_storeu_si128((__m128i *)(dst + j + 16), threshold_u8_op<type>(v_src1, v_gt1, v_thresh, v_max));
+        }
+        for (; j <= length - 16; j += 16) {
+            __m128i v_src = _mm_loadu_si128((const __m128i *)(src + j));
+            __m128i v_gt  = _mm_and_si128(v_keep, _mm_cmpeq_epi8(_mm_max_epu8(v_src, v_bound), v_src));
+            _mm_storeu_si128((__m128i *)(dst + j), threshold_u8_op<type>(v_src, v_gt, v_thresh, v_max));
+        }
+        for (; j < length; j++) {
+            dst[j] = threshold_u8_op<type>(src[j], !never_gt && src[j] > ithresh, thresh, max_value);
+        }
+    }
+}
+
+template <int32_t type>
+static inline __m128 threshold_f32_op(__m128 v_src, __m128 v_thresh, __m128 v_max)
+{
+    __m128 v_gt = _mm_cmpgt_ps(v_src, v_thresh);
+    switch (type) {
+        case ppl::cv::CV_THRESH_BINARY:
+            return _mm_and_ps(v_gt, v_max);
+        case ppl::cv::CV_THRESH_BINARY_INV:
+            return _mm_andnot_ps(v_gt, v_max);
+        case ppl::cv::CV_THRESH_TRUNC:
+            return _mm_blendv_ps(v_src, v_thresh, v_gt);
+        case ppl::cv::CV_THRESH_TOZERO:
+            return _mm_and_ps(v_gt, v_src);
+        default:
+            return _mm_andnot_ps(v_gt, v_src);
+    }
+}
+
+template <int32_t type>
+static inline float threshold_f32_op(float src, float thresh, float max_value)
+{
+    bool gt = src > thresh;
+    switch (type) {
+        case ppl::cv::CV_THRESH_BINARY:
+            return gt ? max_value : 0.f;
+        case ppl::cv::CV_THRESH_BINARY_INV:
+            return gt ? 0.f : max_value;
+        case ppl::cv::CV_THRESH_TRUNC:
+            return gt ? thresh : src;
+        case ppl::cv::CV_THRESH_TOZERO:
+            return gt ? src : 0.f;
+        default:
+            return gt ? 0.f : src;
+    }
+}
+
+template <int32_t type>
+static void threshold_f32(
+    int32_t height,
+    int32_t length,
+    int32_t inWidthStride,
+    const float *inData,
+    int32_t outWidthStride,
+    float *outData,
+    float thresh,
+    float max_value)
+{
+    __m128 v_thresh = _mm_set1_ps(thresh);
+    __m128 v_max    = _mm_set1_ps(max_value);
+    for (int32_t i = 0; i < height; i++) {
+        const float *src = inData + i * inWidthStride;
+        float *dst       = outData + i * outWidthStride;
+        int32_t j        = 0;
+        for (; j <= length - 16; j += 16) {
+            _mm_storeu_ps(dst + j, threshold_f32_op<type>(_mm_loadu_ps(src + j), v_thresh, v_max));
+            _mm_storeu_ps(dst + j + 4, threshold_f32_op<type>(_mm_loadu_ps(src + j + 4), v_thresh, v_max));
+            _mm_storeu_ps(dst + j + 8, threshold_f32_op<type>(_mm_loadu_ps(src + j + 8), v_thresh, v_max));
+            _mm_storeu_ps(dst + j + 12, threshold_f32_op<type>(_mm_loadu_ps(src + j + 12), v_thresh, v_max));
+        }
+        for (; j <= length - 4; j += 4) {
+            _mm_storeu_ps(dst + j, threshold_f32_op<type>(_mm_loadu_ps(src + j), v_thresh, v_max));
+        }
+        for (; j < length; j++) {
+            dst[j] = threshold_f32_op<type>(src[j], thresh, max_value);
+        }
+    }
+}
+
+/*
+ * Histogram of all elements, gathered in one pass over the image. Four
+ * sub-histograms are filled alternately so that runs of equal values do not
+ * serialize on the same counter.
+ */
+static void otsu_histogram(
+    int32_t height,
+    int32_t length,
+    int32_t inWidthStride,
+    const uint8_t *inData,
+    int32_t *hist)
+{
+    int32_t sub_hist[4][256];
+    memset(sub_hist, 0, sizeof(sub_hist));
+    for (int32_t i = 0; i < height; i++) {
+        const uint8_t *src = inData + i * inWidthStride;
+        int32_t j          = 0;
+        for (; j <= length - 4; j += 4) {
+            sub_hist[0][src[j]]++;
+            sub_hist[1][src[j + 1]]++;
+            sub_hist[2][src[j + 2]]++;
+            sub_hist[3][src[j + 3]]++;
+        }
+        for (; j < length; j++) {
+            sub_hist[0][src[j]]++;
+        }
+    }
+    for (int32_t k = 0; k < 256; k++) {
+        hist[k] = sub_hist[0][k] + sub_hist[1][k] + sub_hist[2][k] + sub_hist[3][k];
+    }
+}
+
+// the threshold maximizing the between-class variance, as cv::threshold does.
+static double otsu_threshold(const int32_t *hist, int64_t total)
+{
+    double scale = 1. / total;
+    double mu    = 0;
+    for (int32_t i = 0; i < 256; i++) {
+        mu += i * (double)hist[i];
+    }
+    mu *= scale;
+
+    double mu1 = 0, q1 = 0;
+    double max_sigma = 0, max_val = 0;
+    for (int32_t i = 0; i < 256; i++) {
+        double p_i = hist[i] * scale;
+        mu1 *= q1;
+        q1 += p_i;
+        double q2 = 1. - q1;
+        if (std::min(q1, q2) < FLT_EPSILON || std::max(q1, q2) > 1. - FLT_EPSILON) {
+            continue;
+        }
+        mu1          = (mu1 + i * p_i) / q1;
+        double mu2   = (mu - q1 * mu1) / q2;
+        double sigma = q1 * q2 * (mu1 - mu2) * (mu1 - mu2);
+        if (sigma > max_sigma) {
+            max_sigma = sigma;
+            max_val   = i;
+        }
+    }
+    return max_val;
+}
+
+static ::ppl::common::RetCode threshold_dispatch(
+    int32_t height,
+    int32_t length,
+    int32_t inWidthStride,
+    const uint8_t *inData,
+    int32_t outWidthStride,
+    uint8_t *outData,
+    double thresh,
+    double maxValue,
+    int32_t thresholdType,
+    double *computedThresh)
+{
+    if (thresholdType & ppl::cv::CV_THRESH_OTSU) {
+        int32_t hist[256];
+        otsu_histogram(height, length, inWidthStride, inData, hist);
+        thresh = otsu_threshold(hist, (int64_t)height * length);
+    }
+    // the threshold applied to integers is floored, and reported so.
+    thresh = floor(thresh);
+    if (computedThresh != nullptr) {
+        *computedThresh = thresh;
+    }
+
+    // thresholds out of [0, 255) behave like -1 or 255.
+    int32_t ithresh   = (int32_t)std::min(std::max(thresh, -1.), 255.);
+    uint8_t max_value = (uint8_t)lrint(std::min(std::max(maxValue, 0.), 255.));
+    switch (thresholdType & ppl::cv::CV_THRESH_MASK) {
+        case ppl::cv::CV_THRESH_BINARY:
+            threshold_u8<ppl::cv::CV_THRESH_BINARY>(height, length, inWidthStride, inData, outWidthStride, outData, ithresh, max_value);
+            break;
+        case ppl::cv::CV_THRESH_BINARY_INV:
+            threshold_u8<ppl::cv::CV_THRESH_BINARY_INV>(height, length, inWidthStride, inData, outWidthStride, outData, ithresh, max_value);
+            break;
+        case ppl::cv::CV_THRESH_TRUNC:
+            threshold_u8<ppl::cv::CV_THRESH_TRUNC>(height, length, inWidthStride, inData, outWidthStride, outData, ithresh, max_value);
+            break;
+        case ppl::cv::CV_THRESH_TOZERO:
+            threshold_u8<ppl::cv::CV_THRESH_TOZERO>(height, length, inWidthStride, inData, outWidthStride, outData, ithresh, max_value);
+            break;
+        default:
+            threshold_u8<ppl::cv::CV_THRESH_TOZERO_INV>(height, length, inWidthStride, inData, outWidthStride, outData, ithresh, max_value);
+            break;
+    }
+    return ppl::common::RC_SUCCESS;
+}
+
+static ::ppl::common::RetCode threshold_dispatch(
+    int32_t height,
+    int32_t length,
+    int32_t inWidthStride,
+    const float *inData,
+    int32_t outWidthStride,
+    float *outData,
+    double thresh,
+    double maxValue,
+    int32_t thresholdType,
+    double *computedThresh)
+{
+    if (thresholdType & ppl::cv::CV_THRESH_OTSU) {
+        return ppl::common::RC_INVALID_VALUE;
+    }
+    if (computedThresh != nullptr) {
+        *computedThresh = thresh;
+    }
+
+    float fthresh   = (float)thresh;
+    float max_value = (float)maxValue;
+    switch (thresholdType & ppl::cv::CV_THRESH_MASK) {
+        case ppl::cv::CV_THRESH_BINARY:
+            threshold_f32<ppl::cv::CV_THRESH_BINARY>(height, length, inWidthStride, inData, outWidthStride, outData, fthresh, max_value);
+            break;
+        case ppl::cv::CV_THRESH_BINARY_INV:
+            threshold_f32<ppl::cv::CV_THRESH_BINARY_INV>(height, length, inWidthStride, inData, outWidthStride, outData, fthresh, max_value);
+            break;
+        case ppl::cv::CV_THRESH_TRUNC:
+            threshold_f32<ppl::cv::CV_THRESH_TRUNC>(height, length, inWidthStride, inData, outWidthStride, outData, fthresh, max_value);
+            break;
+        case ppl::cv::CV_THRESH_TOZERO:
+            threshold_f32<ppl::cv::CV_THRESH_TOZERO>(height, length, inWidthStride, inData, outWidthStride, outData, fthresh, max_value);
+            break;
+        default:
+            threshold_f32<ppl::cv::CV_THRESH_TOZERO_INV>(height, length, inWidthStride, inData, outWidthStride, outData, fthresh, max_value);
+            break;
+    }
+    return ppl::common::RC_SUCCESS;
+}
+
+template <typename T, int32_t nc>
+::ppl::common::RetCode Threshold(
+    int32_t height,
+    int32_t width,
+    int32_t inWidthStride,
+    const T *inData,
+    int32_t outWidthStride,
+    T *outData,
+    double thresh,
+    double maxValue,
+    int32_t thresholdType,
+    double *computedThresh)
+{
+    if (nullptr == inData || nullptr == outData) {
+        return ppl::common::RC_INVALID_VALUE;
+    }
+    if (height <= 0 || width <= 0 || inWidthStride < width * nc || outWidthStride < width * nc) {
+        return ppl::common::RC_INVALID_VALUE;
+    }
+    if ((thresholdType & ~(ppl::cv::CV_THRESH_MASK | ppl::cv::CV_THRESH_OTSU)) != 0 ||
+        (thresholdType & ppl::cv::CV_THRESH_MASK) > ppl::cv::CV_THRESH_TOZERO_INV) {
+        return ppl::common::RC_INVALID_VALUE;
+    }
+    // Otsu's threshold is only defined for single channel images, as in OpenCV.
+    if ((thresholdType & ppl::cv::CV_THRESH_OTSU) && nc != 1) {
+        return ppl::common::RC_INVALID_VALUE;
+    }
+    // the rows are thresholded as flat arrays of width * nc elements.
+    return threshold_dispatch(height, width * nc, inWidthStride, inData, outWidthStride, outData, thresh, maxValue, thresholdType, computedThresh);
+}
+
+template ::ppl::common::RetCode Threshold<float, 1>(int32_t height, int32_t width, int32_t inWidthStride, const float *inData, int32_t outWidthStride, float *outData, double thresh, double maxValue, int32_t thresholdType, double *computedThresh);
+template ::ppl::common::RetCode Threshold<float, 3>(int32_t height, int32_t width, int32_t inWidthStride, const float *inData, int32_t outWidthStride, float *outData, double thresh, double maxValue, int32_t thresholdType, double *computedThresh);
+template ::ppl::common::RetCode Threshold<float, 4>(int32_t height, int32_t width, int32_t inWidthStride, const float *inData, int32_t outWidthStride, float *outData, double thresh, double maxValue, int32_t thresholdType, double *computedThresh);
+template ::ppl::common::RetCode Threshold<uint8_t, 1>(int32_t height, int32_t width, int32_t inWidthStride, const uint8_t *inData, int32_t outWidthStride, uint8_t *outData, double thresh, double maxValue, int32_t thresholdType, double *computedThresh);
+template ::ppl::common::RetCode Threshold<uint8_t, 3>(int32_t height, int32_t width, int32_t inWidthStride, const uint8_t *inData, int32_t outWidthStride, uint8_t *outData, double thresh, double maxValue, int32_t thresholdType, double *computedThresh);
+template ::ppl::common::RetCode Threshold<uint8_t, 4>(int32_t height, int32_t width, int32_t inWidthStride, const uint8_t *inData, int32_t outWidthStride, uint8_t *outData, double thresh, double maxValue, int32_t thresholdType, double *computedThresh);
+
+}
+}
+} // namespace ppl::cv::x86
@@ -0,0 +1,89 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <benchmark/benchmark.h>
+#include "ppl/cv/x86/threshold.h"
+#include "ppl/cv/debug.h"
+
+namespace {
+template<typename T, int32_t channels>
+class ThresholdBenchmark {
+public:
+    T* dev_iImage = nullptr;
+    T* dev_oImage = nullptr;
+    int32_t height;
+    int32_t width;
+    ThresholdBenchmark(int32_t height, int32_t width)
+        : height(height)
+        , width(width)
+    {
+        dev_iImage = (T*)malloc(height * width * channels * sizeof(T));
+        dev_oImage = (T*)malloc(height * width * channels * sizeof(T));
+        ppl::cv::debug::randomFill<T>(dev_iImage, height * width * channels, 0, 255);
+    }
+
+    void apply(int32_t type) {
+        int32_t stride = width * channels;
+        ppl::cv::x86::Threshold<T, channels>(height, width, stride, dev_iImage, stride, dev_oImage, 127, 255, type);
+    }
+
+    void apply_opencv(int32_t type) {
+        cv::Mat iMat(height, width, CV_MAKETYPE(cv::DataType<T>::depth, channels), dev_iImage);
+        cv::Mat oMat(height, width, CV_MAKETYPE(cv::DataType<T>::depth, channels), dev_oImage);
+        cv::threshold(iMat, oMat, 127, 255, type);
+    }
+
+    ~ThresholdBenchmark() {
+        free(this->dev_iImage);
+        free(this->dev_oImage);
+    }
+};
+}
+
+using namespace ppl::cv::debug;
+template<typename T, int32_t channels, int32_t type>
+static void BM_Threshold_ppl_x86(benchmark::State &state) {
+    ThresholdBenchmark<T, channels> bm(state.range(1), state.range(0));
+    for (auto _: state) {
+        bm.apply(type);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * state.range(0) * state.range(1) * sizeof(T) * channels);
+}
+
+BENCHMARK_TEMPLATE(BM_Threshold_ppl_x86, uint8_t, c1, ppl::cv::CV_THRESH_BINARY)->Args({320, 240})->Args({640, 480});
+BENCHMARK_TEMPLATE(BM_Threshold_ppl_x86, uint8_t, c3, ppl::cv::CV_THRESH_TRUNC)->Args({320, 240})->Args({640, 480});
+BENCHMARK_TEMPLATE(BM_Threshold_ppl_x86, uint8_t, c1, ppl::cv::CV_THRESH_BINARY | ppl::cv::CV_THRESH_OTSU)->Args({320, 240})->Args({640, 480});
+BENCHMARK_TEMPLATE(BM_Threshold_ppl_x86, float, c1, ppl::cv::CV_THRESH_BINARY)->Args({320, 240})->Args({640, 480});
+BENCHMARK_TEMPLATE(BM_Threshold_ppl_x86, float, c3, ppl::cv::CV_THRESH_TOZERO)->Args({320, 240})->Args({640, 480});
+
+#ifdef PPLCV_BENCHMARK_OPENCV
+template<typename T, int32_t channels, int32_t type>
+static void BM_Threshold_opencv_x86(benchmark::State &state) {
+    ThresholdBenchmark<T, channels> bm(state.range(1), state.range(0));
+    for (auto _: state) {
+        bm.apply_opencv(type);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * state.range(0) * state.range(1) * sizeof(T) * channels);
+}
+BENCHMARK_TEMPLATE(BM_Threshold_opencv_x86, uint8_t, c1, ppl::cv::CV_THRESH_BINARY)->Args({320, 240})->Args({640, 480});
+BENCHMARK_TEMPLATE(BM_Threshold_opencv_x86, uint8_t, c3, ppl::cv::CV_THRESH_TRUNC)->Args({320, 240})->Args({640, 480});
+BENCHMARK_TEMPLATE(BM_Threshold_opencv_x86, uint8_t, c1, ppl::cv::CV_THRESH_BINARY | ppl::cv::CV_THRESH_OTSU)->Args({320, 240})->Args({640, 480});
+BENCHMARK_TEMPLATE(BM_Threshold_opencv_x86, float, c1, ppl::cv::CV_THRESH_BINARY)->Args({320, 240})->Args({640, 480});
+BENCHMARK_TEMPLATE(BM_Threshold_opencv_x86, float, c3, ppl::cv::CV_THRESH_TOZERO)->Args({320, 240})->Args({640, 480});
+#endif //! PPLCV_BENCHMARK_OPENCV
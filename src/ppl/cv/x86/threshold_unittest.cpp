@@ -0,0 +1,96 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "ppl/cv/x86/threshold.h"
+#include "ppl/cv/x86/test.h"
+#include "ppl/cv/types.h"
+#include <memory>
+#include <gtest/gtest.h>
+#include "ppl/cv/debug.h"
+
+template<typename T, int32_t nc>
+void ThresholdTest(int32_t height, int32_t width, double thresh, double max_value, int32_t type) {
+    std::unique_ptr<T[]> src(new T[width * height * nc]);
+    std::unique_ptr<T[]> dst(new T[width * height * nc]);
+    std::unique_ptr<T[]> dst_ref(new T[width * height * nc]);
+    ppl::cv::debug::randomFill<T>(src.get(), width * height * nc, 0, 255);
+    cv::Mat srcMat(height, width, CV_MAKETYPE(cv::DataType<T>::depth, nc), src.get());
+    cv::Mat dstMat(height, width, CV_MAKETYPE(cv::DataType<T>::depth, nc), dst_ref.get());
+
+    double computed = 0;
+    ppl::cv::x86::Threshold<T, nc>(height, width, width * nc, src.get(), width * nc, dst.get(),
+                                   thresh, max_value, type, &computed);
+    double computed_ref = cv::threshold(srcMat, dstMat, thresh, max_value, type);
+    EXPECT_EQ(computed, computed_ref);
+    checkResult<T, nc>(dst.get(), dst_ref.get(), height, width, width * nc, width * nc, 1e-3);
+}
+
+template<typename T, int32_t nc>
+void ThresholdTypesTest(int32_t height, int32_t width) {
+    const int32_t types[] = {ppl::cv::CV_THRESH_BINARY, ppl::cv::CV_THRESH_BINARY_INV, ppl::cv::CV_THRESH_TRUNC,
+                             ppl::cv::CV_THRESH_TOZERO, ppl::cv::CV_THRESH_TOZERO_INV};
+    for (int32_t type : types) {
+        ThresholdTest<T, nc>(height, width, 127.5, 200, type);
+        ThresholdTest<T, nc>(height, width, -1, 255, type);
+        ThresholdTest<T, nc>(height, width, 255, 255, type);
+    }
+}
+
+TEST(ThresholdUint8, x86)
+{
+    ThresholdTypesTest<uint8_t, 1>(480, 640);
+    ThresholdTypesTest<uint8_t, 3>(480, 640);
+    ThresholdTypesTest<uint8_t, 4>(480, 640);
+
+    ThresholdTypesTest<uint8_t, 1>(31, 67);
+    ThresholdTypesTest<uint8_t, 3>(31, 67);
+    ThresholdTypesTest<uint8_t, 4>(31, 67);
+}
+
+TEST(ThresholdFloat, x86)
+{
+    ThresholdTypesTest<float, 1>(480, 640);
+    ThresholdTypesTest<float, 3>(480, 640);
+    ThresholdTypesTest<float, 4>(480, 640);
+
+    ThresholdTypesTest<float, 1>(31, 67);
+    ThresholdTypesTest<float, 3>(31, 67);
+    ThresholdTypesTest<float, 4>(31, 67);
+}
+
+TEST(ThresholdOtsuUint8, x86)
+{
+    ThresholdTest<uint8_t, 1>(480, 640, 0, 255, ppl::cv::CV_THRESH_BINARY | ppl::cv::CV_THRESH_OTSU);
+    ThresholdTest<uint8_t, 1>(480, 640, 0, 255, ppl::cv::CV_THRESH_TOZERO | ppl::cv::CV_THRESH_OTSU);
+    ThresholdTest<uint8_t, 1>(31, 67, 0, 255, ppl::cv::CV_THRESH_BINARY_INV | ppl::cv::CV_THRESH_OTSU);
+}
+
+TEST(ThresholdOtsuInvalid, x86)
+{
+    const int32_t height = 31, width = 67;
+    std::unique_ptr<uint8_t[]> src(new uint8_t[width * height * 3]);
+    std::unique_ptr<uint8_t[]> dst(new uint8_t[width * height * 3]);
+    std::unique_ptr<float[]> src_f(new float[width * height]);
+    std::unique_ptr<float[]> dst_f(new float[width * height]);
+    ppl::cv::debug::randomFill<uint8_t>(src.get(), width * height * 3, 0, 255);
+    ppl::cv::debug::randomFill<float>(src_f.get(), width * height, 0, 255);
+    int32_t type = ppl::cv::CV_THRESH_BINARY | ppl::cv::CV_THRESH_OTSU;
+    EXPECT_EQ(ppl::common::RC_INVALID_VALUE,
+              (ppl::cv::x86::Threshold<uint8_t, 3>(height, width, width * 3, src.get(), width * 3, dst.get(), 0, 255, type)));
+    EXPECT_EQ(ppl::common::RC_INVALID_VALUE,
+              (ppl::cv::x86::Threshold<float, 1>(height, width, width, src_f.get(), width, dst_f.get(), 0, 255, type)));
+}